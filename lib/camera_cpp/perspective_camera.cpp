@@ -330,11 +330,12 @@ Perspective_camera::Perspective_camera(const Perspective_camera & pc) :
     extrinsic_dirty(true),
     cam_matrix_dirty(true),
     m_camera_matrix(pc.m_camera_matrix),
+    m_camera_matrix_d(pc.m_camera_matrix_d),
     m_rd_k1(pc.m_rd_k1),
     m_rd_k2(pc.m_rd_k2),
     m_rd_k3(pc.m_rd_k3),
     m_rd_p1(pc.m_rd_p1),
-    m_rd_p2(pc.m_rd_p1)
+    m_rd_p2(pc.m_rd_p2)
 {
 }
 
@@ -357,12 +358,13 @@ Perspective_camera & Perspective_camera::operator=(const Perspective_camera & pc
     extrinsic_dirty = pc.extrinsic_dirty;
     cam_matrix_dirty = pc.cam_matrix_dirty;
     m_camera_matrix = pc.m_camera_matrix;
+    m_camera_matrix_d = pc.m_camera_matrix_d;
 
     m_rd_k1 = pc.m_rd_k1;
     m_rd_k2 = pc.m_rd_k2;
     m_rd_k3 = pc.m_rd_k3;
     m_rd_p1 = pc.m_rd_p1;
-    m_rd_p2 = pc.m_rd_p1;
+    m_rd_p2 = pc.m_rd_p2;
 
     return *this;
 }
@@ -388,6 +390,7 @@ void Perspective_camera::swap(Perspective_camera& other)
     swap(world_scale, other.world_scale);
     rendering_interface.swap(other.rendering_interface);
     swap(m_camera_matrix, other.m_camera_matrix);
+    swap(m_camera_matrix_d, other.m_camera_matrix_d);
     swap(intrinsic_dirty, other.intrinsic_dirty);
     swap(extrinsic_dirty, other.extrinsic_dirty);
     swap(cam_matrix_dirty, other.cam_matrix_dirty);
@@ -395,7 +398,7 @@ void Perspective_camera::swap(Perspective_camera& other)
     swap(m_rd_k2, other.m_rd_k2);
     swap(m_rd_k3, other.m_rd_k3);
     swap(m_rd_p1, other.m_rd_p1);
-    swap(m_rd_p2, other.m_rd_p1);
+    swap(m_rd_p2, other.m_rd_p2);
 }
 
 void Perspective_camera::mult_modelview_matrix() const
@@ -478,6 +481,8 @@ void Perspective_camera::update_camera_matrix() const
     m_camera_matrix(1,3) = t[1];
     m_camera_matrix(2,3) = t[2];
 
+    m_camera_matrix_d = Matrix_d<3, 4>(m_camera_matrix);
+
     cam_matrix_dirty = false;
 }
 
@@ -1153,9 +1158,17 @@ void Perspective_camera::prepare_for_rendering(bool clean_buffers) const
 /**
  * Apply Tsai's radial distortion to point
  */
-Vector Perspective_camera::radial_distortion(const Vector& v)
+Vector Perspective_camera::radial_distortion(const Vector& v) const
+{
+    Vector2 x = radial_distortion(Vector2(v[0], v[1]));
+    return Vector(x[0], x[1]);
+}
+
+/**
+ * Apply Tsai's radial distortion to point
+ */
+Vector2 Perspective_camera::radial_distortion(const Vector2& v) const
 {
-    const Matrix& P = get_camera_matrix();
     double fx = get_focal_length() * get_aspect_ratio();
     double fy = get_focal_length() / (sin(get_skew()));
     double cx = get_principal_point_x();
@@ -1173,7 +1186,7 @@ Vector Perspective_camera::radial_distortion(const Vector& v)
     x += 2*m_rd_p1 * dxdy + m_rd_p2 * (r2 + 2*dx2); 
     y += 2*m_rd_p2 * dxdy + m_rd_p1 * (r2 + 2*dy2);
 
-    return Vector(cx + fx*x, cy + fy*y);
+    return Vector2(cx + fx*x, cy + fy*y);
 }
 
 } // namespace kjb
@@ -81,6 +81,8 @@
 #include <l_cpp/l_writeable.h>
 #include <l_cpp/l_cloneable.h>
 #include <m_cpp/m_vector.h>
+#include <m_cpp/m_vector_d.h>
+#include <m_cpp/m_matrix_d.h>
 
 #ifdef KJB_HAVE_BST_SERIAL
 //#include <boost/serialization/nvp.hpp>
@@ -489,12 +491,45 @@ public:
         return get_camera_matrix();
     }
 
+    /**
+     * Get the camera matrix as a fixed-size matrix. It is cached along with
+     * get_camera_matrix(), so projecting with it needs no allocation.
+     */
+    const Matrix_d<3, 4>& get_camera_matrix_d() const
+    {
+        update_camera_matrix();
+        return m_camera_matrix_d;
+    }
+
     Vector to_camera_coordinates(const Vector& v) const;
 
     /**
      * Apply Tsai's radial distortion to point
      */
-    Vector radial_distortion(const Vector& x);
+    Vector radial_distortion(const Vector& x) const;
+
+    /**
+     * Apply Tsai's radial distortion to point
+     */
+    Vector2 radial_distortion(const Vector2& x) const;
+
+    /** @brief Sets the radial (k1, k2, k3) and tangential (p1, p2)
+     *  distortion coefficients. They are all 0 by default. */
+    void set_radial_distortion(double k1, double k2, double k3, double p1, double p2)
+    {
+        m_rd_k1 = k1;
+        m_rd_k2 = k2;
+        m_rd_k3 = k3;
+        m_rd_p1 = p1;
+        m_rd_p2 = p2;
+    }
+
+    /** @brief returns true if any distortion coefficient is not 0 */
+    bool has_radial_distortion() const
+    {
+        return m_rd_k1 != 0.0 || m_rd_k2 != 0.0 || m_rd_k3 != 0.0
+                || m_rd_p1 != 0.0 || m_rd_p2 != 0.0;
+    }
 
 private:
 
@@ -560,6 +595,9 @@ protected:
     /** Camera matrix */
     mutable Matrix m_camera_matrix;
 
+    /** Camera matrix, as a fixed-size matrix */
+    mutable Matrix_d<3, 4> m_camera_matrix_d;
+
 private:
     template<class Archive>
     void serialize(Archive &ar, const unsigned int /* version */)
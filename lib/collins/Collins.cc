@@ -15,6 +15,10 @@
 #include <time.h>
 #include <assert.h>
 
+#include <boost/thread.hpp>
+#include <boost/bind.hpp>
+#include <boost/shared_ptr.hpp>
+
 /* 
    Kobus. This was for MINDOUBLE. I think MINDOUBLE might be an old name for the
    more standard DBL_MIN. I have patched this in l_incl.h above. 
@@ -61,9 +65,6 @@ bool Collins::initialize(
     mymalloc_init();
     mymalloc_char_init();
 
-    /* this is the cache!! */
-    effhash_make_table(1000003,&eff_hash);
-
     string grammarName = modelDirectory + "/grammar";
     if(! read_grammar(grammarName.c_str()))
     {
@@ -169,9 +170,9 @@ static bool convertToCollins(
     return true;
 }
 
-static TreePtr extractBestParse(double& prob)
+static TreePtr extractBestParse(chart_context * chart, double& prob)
 {
-    int best = find_best_parse(prob);
+    int best = find_best_parse(chart, prob);
 
     /** no parse exists */
     if(best == -1)
@@ -180,7 +181,7 @@ static TreePtr extractBestParse(double& prob)
 	return TreePtr();
     }
   
-    TreePtr tree = buildTree(best);
+    TreePtr tree = buildTree(chart, best);
 
     return tree;
 };
@@ -296,27 +297,40 @@ static void changeNpb(const TreePtr & edge)
     }
 }
 
-TreePtr Collins::parse(
+CollinsContext::CollinsContext()
+{
+    if((chart = make_chart_context()) == NULL)
+    {
+	throw std::bad_alloc();
+    }
+}
+
+CollinsContext::~CollinsContext()
+{
+    free_chart_context(chart);
+}
+
+TreePtr CollinsContext::parse(
     const std::vector<spear::Word>& sentence,
     double&                         prob, 
     bool                            discardNpbFlag,
     bool                            traceFlag)
 {
     // if true removes NPB labels from generated trees
-    set_treebankoutputflag(discardNpbFlag);
+    set_treebankoutputflag(chart, discardNpbFlag);
 
     // if true displays the trees in Collins' "raw" format
-    set_traceoutput(traceFlag);
+    set_traceoutput(chart, traceFlag);
 
     // Construct the representation required by Collins
     sentence_type collinsSentence;
     convertToCollins(sentence, collinsSentence);
 
     // The actual parsing code
-    pthresh = -5000000;
-    parse_sentence(&collinsSentence);
+    chart->pthresh = -5000000;
+    parse_sentence(chart, &collinsSentence);
 
-    TreePtr best = extractBestParse(prob);
+    TreePtr best = extractBestParse(chart, prob);
 
     // create a dummy tree if the parse failed
     if(best == (const Tree *) NULL)
@@ -338,3 +352,96 @@ TreePtr Collins::parse(
     free_sentence(&collinsSentence);
     return best;
 }
+
+// Used by the single sentence parse, created on first use
+static CollinsContext * defaultContext = NULL;
+static boost::mutex defaultContextMutex;
+
+TreePtr Collins::parse(
+    const std::vector<spear::Word>& sentence,
+    double&                         prob, 
+    bool                            discardNpbFlag,
+    bool                            traceFlag)
+{
+    boost::mutex::scoped_lock lock(defaultContextMutex);
+
+    if(defaultContext == NULL)
+    {
+	defaultContext = new CollinsContext();
+    }
+
+    return defaultContext->parse(sentence, prob, discardNpbFlag, traceFlag);
+}
+
+/** Parses the next sentence not taken by another thread, until none are left */
+static void parseWorker(
+    CollinsContext *                                context,
+    const std::vector< std::vector<spear::Word> > & sentences,
+    std::vector<TreePtr> &                          trees,
+    std::vector<double> &                           probs,
+    bool                                            discardNpbFlag,
+    size_t *                                        next,
+    boost::mutex *                                  nextMutex)
+{
+    while(true)
+    {
+	size_t i;
+	{
+	    boost::mutex::scoped_lock lock(* nextMutex);
+	    if(* next >= sentences.size()) return;
+	    i = (* next) ++;
+	}
+
+	trees[i] = context->parse(sentences[i], probs[i], discardNpbFlag, false);
+    }
+}
+
+std::vector<TreePtr> Collins::parse(
+    const std::vector< std::vector<spear::Word> >&  sentences,
+    std::vector<double>&                            probs,
+    size_t                                          numThreads,
+    bool                                            discardNpbFlag)
+{
+    std::vector<TreePtr> trees(sentences.size());
+    probs.assign(sentences.size(), 0.0);
+
+    if(numThreads == 0)
+    {
+	numThreads = boost::thread::hardware_concurrency();
+    }
+    if(numThreads > sentences.size())
+    {
+	numThreads = sentences.size();
+    }
+
+    if(numThreads <= 1)
+    {
+	for(size_t i = 0; i < sentences.size(); i ++)
+	{
+	    trees[i] = parse(sentences[i], probs[i], discardNpbFlag, false);
+	}
+	return trees;
+    }
+
+    // the contexts are made here, so that running out of memory is reported
+    // to the caller
+    std::vector< boost::shared_ptr<CollinsContext> > contexts;
+    for(size_t t = 0; t < numThreads; t ++)
+    {
+	contexts.push_back(boost::shared_ptr<CollinsContext>(new CollinsContext()));
+    }
+
+    size_t next = 0;
+    boost::mutex nextMutex;
+    boost::thread_group threads;
+    for(size_t t = 0; t < numThreads; t ++)
+    {
+	threads.create_thread(boost::bind(parseWorker, contexts[t].get(),
+					  boost::cref(sentences),
+					  boost::ref(trees), boost::ref(probs),
+					  discardNpbFlag, &next, &nextMutex));
+    }
+    threads.join_all();
+
+    return trees;
+}
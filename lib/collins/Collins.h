@@ -3,14 +3,42 @@
 #define COLLINS_PARSER_H
 
 #include <string>
+#include <vector>
 
 /* Kobus. */ 
 #include "spear/Word.h"
 #include "spear/Tree.h"
 
+struct chart_context;
+
 namespace spear
 {
 
+    /**
+     * The chart and the probability caches used to parse one sentence at a
+     * time. The model read by Collins::initialize is shared, so each thread
+     * can parse with its own context. A context takes about 90MB.
+     */
+    class CollinsContext
+    {
+    public:
+	CollinsContext();
+
+	~CollinsContext();
+
+	spear::TreePtr parse(
+	    const std::vector<spear::Word>&  sentence,
+	    double&                          prob,
+	    bool                             discardNpbFlag = true, 
+	    bool                             traceFlag = true);
+
+    private:
+	CollinsContext(const CollinsContext&);
+	CollinsContext& operator=(const CollinsContext&);
+
+	chart_context * chart;
+    };
+
     class Collins
     {
     public:
@@ -19,12 +47,23 @@ namespace spear
 	    double              beam = 10000
 	    );
 	
+	/** Parses with a context shared by all callers (one at a time) */
 	static spear::TreePtr parse(
 	    const std::vector<spear::Word>&  sentence,
 	    double&                          prob,
 	    bool                             discardNpbFlag = true, 
 	    bool                             traceFlag = true);
 
+	/** 
+	 * Parses the sentences with numThreads threads, each with its own
+	 * context (0 means one per processor). Nothing is traced.
+	 */
+	static std::vector<spear::TreePtr> parse(
+	    const std::vector< std::vector<spear::Word> >&  sentences,
+	    std::vector<double>&                            probs,
+	    size_t                                          numThreads = 0,
+	    bool                                            discardNpbFlag = true);
+
     private:
 	static bool initialized;
     };
@@ -44,61 +44,19 @@
 int PUNC_FLAG;
 double BEAMPROB;
 hash_table * new_hash;
-effhash_table eff_hash;
-
-
-/* a threshold: all edges must have prob greater than this threshold to be
-   added to the chart 
-   */
-double pthresh;
 
 #define CCPROBSMALL 0.0000000000000000001
 
-/* pointer to the current sentence being parsed*/
-sentence_type* current;
-
 /* initialise the chart */
-void init_chart();
+void init_chart(chart_context *chart);
 
 /* add a sentence to the chart (starts the parsing process) */
-void add_sentence_to_chart(sentence_type* sentence);
+void add_sentence_to_chart(chart_context *chart, sentence_type* sentence);
 
 /*complete the chart for words spanning s..e inclusive*/
-void complete(int s,int e);
-
-/*
-   edges is an array of edges in the chart
-
-   childs is an array used for the children of each node in the chart:
-
-   childs[edge[i].child1] to childs[edge[i].child1+edge[i].numchild-1] are
-   the children of the i'th edge in left to right order (being indexes into
-   the edges array themselves)
-
+void complete(chart_context *chart, int s,int e);
 
- */
-
-#define PMAXEDGES 200000
-#define PMAXCHILDS 3000000
-
-edge_type edges[PMAXEDGES];
-int numedges;
-
-int childs[PMAXCHILDS];
-int numchilds;
-
-/*
-   The edges in the chart spanning words s to e inclusive are contained
-   in edges[sindex[s][e]] to edges[eindex[s][e]] inclusive
-
-   if no edges have been added to the chart for the span s..e,
-   sindex[s][e]==-1, eindex[s][e]==-2
-
- */
-
-int sindex[PMAXWORDS][PMAXWORDS];
-int eindex[PMAXWORDS][PMAXWORDS];
-void init_index();
+void init_index(chart_context *chart);
 
 /*
    add_edge(s,e) adds an edge spanning words s...e inclusive
@@ -112,7 +70,7 @@ void init_index();
    programming/beam conditions
  */
 
-int add_edge(int s,int e);
+int add_edge(chart_context *chart, int s,int e);
 
 
 /*
@@ -148,16 +106,8 @@ int add_edge(int s,int e);
 
 */
 
-typedef struct {
-  int edge1;
-  int minedge;
-  double minprob;
-  char numedges;
-} sament_type;
-
-sament_type saments[GMAXNTS];
-void init_saments();
-void find_sament_minprob(int nt);
+void init_saments(chart_context *chart);
+void find_sament_minprob(chart_context *chart, int nt);
 #define PMAXHEADS 100
 
 
@@ -184,7 +134,7 @@ prob =   P1      P2            P1*P2*Prob_r(R | P,H)
    efficiency reasons
  */
 
-void join_2_edges_follow(int e1,int s,int m,int e,int *e2s,int ne2s);
+void join_2_edges_follow(chart_context *chart, int e1,int s,int m,int e,int *e2s,int ne2s);
 
 /*
    join_2_edges_precede joins two edges but where the modifier precedes the 
@@ -206,7 +156,7 @@ void join_2_edges_follow(int e1,int s,int m,int e,int *e2s,int ne2s);
 
 */
 
-void join_2_edges_precede(int e2,int s,int m,int e,int *e1s,int ne1);
+void join_2_edges_precede(chart_context *chart, int e2,int s,int m,int e,int *e1s,int ne1);
 
 /*
    join_2_edges_cc joins two edges in a coordination relationship:
@@ -227,7 +177,7 @@ void join_2_edges_precede(int e2,int s,int m,int e,int *e1s,int ne1);
 
  */
 
-void join_2_edges_cc(int e1,int e2,int s,int m,int e);
+void join_2_edges_cc(chart_context *chart, int e1,int e2,int s,int m,int e);
 
 /* add_singles add all the unary rules for words spanning s..e:
 
@@ -242,7 +192,7 @@ void join_2_edges_cc(int e1,int e2,int s,int m,int e);
        where edge1 = i'th edge in the edges array for si<=i<=ei
 */
 
-void add_singles(int s,int e,int si,int ei);
+void add_singles(chart_context *chart, int s,int e,int si,int ei);
 
 /* add_stops adds all the stop probabilities for edges which do not yet
    have these added (i.e. for all s<=i<=e and edges[i].stop==0 a new edge is
@@ -251,7 +201,7 @@ void add_singles(int s,int e,int si,int ei);
 
 */
 
-void add_stops(int s,int e,int si,int ei);
+void add_stops(chart_context *chart, int s,int e,int si,int ei);
 
 /* add_traces adds all traces for edges that have both a gap and an NP
    requirement to either their left or right
@@ -267,18 +217,10 @@ void add_stops(int s,int e,int si,int ei);
    and so on...
 */
 
-void add_singles_stops(int s,int e);
-
-/* adds are data-structures are used by add_singles_stops */
+void add_singles_stops(chart_context *chart, int s,int e);
 
-int ADDFLAG;
-int adds1[100000];
-int numadds1;
-int adds2[100000];
-int numadds2;
-
-int *adds;
-int *numadds;
+/* adds are data-structures are used by add_singles_stops (they are in the
+   chart context) */
 
 /* calc_prob2 calculates prob2 for edges[edge]
 
@@ -289,12 +231,12 @@ int *numadds;
    to appear in the correct tree
    */
 
-void calc_prob2(int edge);
+void calc_prob2(chart_context *chart, int edge);
 
 
 /* prints an edge tabbed in by offset spaces */
 
-void print_edge(int e,int offset);
+void print_edge(chart_context *chart, int e,int offset);
 
 /*bestprobs[s][e] holds the highest probability for all edges added spanning
   words s..e 
@@ -311,68 +253,64 @@ void print_edge(int e,int offset);
 
 */
 
-double bestprobs[GMAXNTS][GMAXNTS];
-
-
 /* returns 1 if the edge is within the current beam. Used while the edges for
    s..e in the chart are being added */
-int inbeam(int edge,int s,int e);
+int inbeam(chart_context *chart, int edge,int s,int e);
 
 /* returns 1 if the edge is within the current beam. Also sets
    edges[edge].inbeam indicating whether or not the edge makes the
    beam. Used when s..e is being built upon, at which point edges can
    definitely be classified as falling in/out of the beam */
 
-int inbeam2(int edge,int s,int e);
-
-int TREEBANKOUTPUTFLAG;
+int inbeam2(chart_context *chart, int edge,int s,int e);
 
-void set_treebankoutputflag(int flag)
+void set_treebankoutputflag(chart_context *chart, int flag)
 {
-  TREEBANKOUTPUTFLAG = flag;
+  chart->TREEBANKOUTPUTFLAG = flag;
 }
 
 // If true, print output parse tree in Collins format
-int PRINT_EDGES;
-
-void set_traceoutput(int flag)
+void set_traceoutput(chart_context *chart, int flag)
 {
-  PRINT_EDGES = flag;
+  chart->PRINT_EDGES = flag;
 }
 
 /*==========================================================================*/
 
 /*parse a sentence, print the output to stdout*/
-void parse_sentence(sentence_type* sentence)
+void parse_sentence(chart_context *chart, sentence_type* sentence)
 {
     int i,j;
+    sentence_type *current;
 
-    reset_prior_hashprobs();
-    effhash_newsent(&eff_hash);           
+    reset_prior_hashprobs(chart->prior_hashprobs, sentence->nws_np);
+    effhash_newsent(&chart->eff_hash);           
     //init_chart(GMAXNTS);
-    init_chart();
-    current = sentence;
+    init_chart(chart);
+    current = chart->current = sentence;
   	 
-    add_sentence_to_chart(current);
+    add_sentence_to_chart(chart, current);
   
     for(i = 0; i < current -> nws_np; i++)
     {
 	for(j = i - 1; j >= 0; j--)
 	{
-	    complete(j, i);
+	    complete(chart, j, i);
 	}
     }
 
-    if(PRINT_EDGES)
+    if(chart->PRINT_EDGES)
     {
-  	if(print_best_parse() != -1) return;
+  	if(print_best_parse(chart) != -1) return;
   	printf("PROB 0 0 0\n");
 	print_noparse(current);
     }
 }
 
-void init_index()
+void init_index(chart_context *chart)
 {
+    int (*sindex)[PMAXWORDS] = chart->sindex;
+    int (*eindex)[PMAXWORDS] = chart->eindex;
     int i,j;
 
     for(i=0; i<PMAXWORDS; i++)
@@ -385,33 +323,104 @@ void init_index()
     }
 }
 
-void init_saments()
+void init_saments(chart_context *chart)
 {
+    sament_type *saments = chart->saments;
     int i;
 
     for(i=0; i<GMAXNTS; i++) saments[i].edge1 = -1;
 }
 
-void init_chart()
+void init_chart(chart_context *chart)
 {
-    init_index();
+    init_index(chart);
 
-    numadds = &numadds1;
-    adds = adds1;
-    numadds1 = 0;
+    chart->numadds = &chart->numadds1;
+    chart->adds = chart->adds1;
+    chart->numadds1 = 0;
 
-    init_saments();
+    init_saments(chart);
   
-    numedges = 0;
-    numchilds = 0;
+    chart->numedges = 0;
+    chart->numchilds = 0;
+}
+
+chart_context *make_chart_context()
+{
+    chart_context *chart;
+
+    chart = (chart_context *) malloc(sizeof(chart_context));
+    if(chart == NULL) return NULL;
+
+    chart->edges = (edge_type *) malloc(PMAXEDGES*sizeof(edge_type));
+    chart->childs = (int *) malloc(PMAXCHILDS*sizeof(int));
+    chart->adds1 = (int *) malloc(PMAXADDS*sizeof(int));
+    chart->adds2 = (int *) malloc(PMAXADDS*sizeof(int));
+    chart->t2 = (int *) malloc(PMAXADDS*sizeof(int));
+    chart->t3 = (int *) malloc(PMAXADDS*sizeof(int));
+    chart->t5 = (int *) malloc(PMAXADDS*sizeof(int));
+    chart->prior_hashprobs = 
+      (prior_probs_type *) malloc(PMAXWORDS*sizeof(prior_probs_type));
+    effhash_make_table(PEFFHASHSIZE,&chart->eff_hash);
+
+    chart->numedges = 0;
+    chart->numchilds = 0;
+    chart->ADDFLAG = 0;
+    chart->numadds1 = 0;
+    chart->numadds2 = 0;
+    chart->adds = chart->adds1;
+    chart->numadds = &chart->numadds1;
+    chart->current = NULL;
+    chart->pthresh = -5000000;
+    chart->TREEBANKOUTPUTFLAG = 0;
+    chart->PRINT_EDGES = 0;
+
+    if(chart->edges == NULL || chart->childs == NULL ||
+       chart->adds1 == NULL || chart->adds2 == NULL ||
+       chart->t2 == NULL || chart->t3 == NULL || chart->t5 == NULL ||
+       chart->prior_hashprobs == NULL ||
+       chart->eff_hash.table == NULL || chart->eff_hash.keys == NULL)
+    {
+	free_chart_context(chart);
+	return NULL;
+    }
+
+    return chart;
+}
+
+void free_chart_context(chart_context *chart)
+{
+    if(chart == NULL) return;
+
+    effhash_free_table(&chart->eff_hash);
+    free(chart->prior_hashprobs);
+    free(chart->t5);
+    free(chart->t3);
+    free(chart->t2);
+    free(chart->adds2);
+    free(chart->adds1);
+    free(chart->childs);
+    free(chart->edges);
+    free(chart);
 }
 
 /* note the following bug: for singles, an edge can be replaced when another
    edge is built on top of it. For example, SBAR -> S is added, then the S
    is replaced */
 
-int add_edge(int s,int e)
+int add_edge(chart_context *chart, int s,int e)
 {
+    edge_type *edges = chart->edges;
+    int &numedges = chart->numedges;
+    int (*sindex)[PMAXWORDS] = chart->sindex;
+    int (*eindex)[PMAXWORDS] = chart->eindex;
+    sament_type *saments = chart->saments;
+    double (*bestprobs)[GMAXNTS] = chart->bestprobs;
+    int &ADDFLAG = chart->ADDFLAG;
+    int *&adds = chart->adds;
+    int *&numadds = chart->numadds;
+    sentence_type *current = chart->current;
+    double pthresh = chart->pthresh;
     int i,j;
     int nt;
 
@@ -428,7 +437,7 @@ int add_edge(int s,int e)
       or not yet, as not all edges have been added for span s...e*/
     edges[numedges].inbeam = 2;
 
-    calc_prob2(numedges);
+    calc_prob2(chart, numedges);
 
     if(sindex[s][e] == -1) /*first edge to be added for this span*/
     {
@@ -448,7 +457,7 @@ int add_edge(int s,int e)
       /*return if not a POS tag and not in the beam
 	(note: POS tags are always kept)*/
 
-	if(edges[numedges].type!=0&&!inbeam(numedges,s,e))
+	if(edges[numedges].type!=0&&!inbeam(chart, numedges,s,e))
 	{
 	    return -1;
 	} else if(
@@ -519,7 +528,7 @@ int add_edge(int s,int e)
 		j=edges[i].next;
 		edges[i]=edges[numedges];
 		edges[i].next=j;
-		find_sament_minprob(nt);
+		find_sament_minprob(chart, nt);
 
 		adds[*numadds] = i;
 		(*numadds)++;
@@ -575,7 +584,7 @@ int add_edge(int s,int e)
 	    j=edges[i].next;
 	    edges[i]=edges[numedges];
 	    edges[i].next=j;
-	    find_sament_minprob(nt);
+	    find_sament_minprob(chart, nt);
 
 	    adds[*numadds] = i;
 	    (*numadds)++;
@@ -596,7 +605,7 @@ int add_edge(int s,int e)
   j=edges[i].next;
   edges[i]=edges[numedges];
   edges[i].next=j;
-  find_sament_minprob(nt);
+  find_sament_minprob(chart, nt);
 
   adds[*numadds] = i;
   (*numadds)++;
@@ -608,8 +617,10 @@ int add_edge(int s,int e)
 
 /*update the values for sament*/
 
-void find_sament_minprob(int nt)
+void find_sament_minprob(chart_context *chart, int nt)
 {
+  edge_type *edges = chart->edges;
+  sament_type *saments = chart->saments;
   int i;
 
   i=saments[nt].edge1;
@@ -626,8 +637,10 @@ void find_sament_minprob(int nt)
     }
 }
 
-void add_sentence_to_chart(sentence_type *sentence)
+void add_sentence_to_chart(chart_context *chart, sentence_type *sentence)
 {
+  edge_type *edges = chart->edges;
+  int &numedges = chart->numedges;
   int i,j,k;
   char *td;
   int word;
@@ -636,7 +649,7 @@ void add_sentence_to_chart(sentence_type *sentence)
 
   for(i=0;i<sentence->nws_np;i++)
     {
-      init_saments();
+      init_saments(chart);
 
       word=sentence->wordnos[i];
       flag=0;
@@ -683,16 +696,22 @@ void add_sentence_to_chart(sentence_type *sentence)
 
 	    edges[numedges].hasverb = isverb(j);
 
-	    k=add_edge(i,i);
+	    k=add_edge(chart, i,i);
 
 	  }
 
-      add_singles_stops(i,i);
+      add_singles_stops(chart, i,i);
 
     }
 }
-void add_singles(int s,int e,int si,int ei)
+void add_singles(chart_context *chart, int s,int e,int si,int ei)
 {
+  edge_type *edges = chart->edges;
+  int &numedges = chart->numedges;
+  int *childs = chart->childs;
+  int &numchilds = chart->numchilds;
+  sentence_type *current = chart->current;
+  effhash_table &eff_hash = chart->eff_hash;
   int i,j,k;
   edge_type etemp;
   double prob,probl,probr;
@@ -702,7 +721,7 @@ void add_singles(int s,int e,int si,int ei)
   int wh,th,p,ch;
 
   for(i=si;i<=ei;i++)
-    if(edges[i].valid==1&&inbeam(i,s,e)&&edges[i].stop==1)
+    if(edges[i].valid==1&&inbeam(chart, i,s,e)&&edges[i].stop==1)
       for(j=0;j<unary_nums[(unsigned int) edges[i].label];j++)
 	if(unaries[(unsigned int) edges[i].label][j]!=-1)
 	{
@@ -760,7 +779,7 @@ void add_singles(int s,int e,int si,int ei)
 		  if(flaggap==0)
 		    {
 		      edges[numedges]=etemp;
-		      if((k=add_edge(s,e))!=-1)
+		      if((k=add_edge(chart, s,e))!=-1)
 			{
 			  edges[k].child1=numchilds;
 			  edges[k].numchild=1;
@@ -777,7 +796,7 @@ void add_singles(int s,int e,int si,int ei)
 		      edges[numedges].lc.gap=1;
 		      edges[numedges].prob+=get_gap_prob_witheffhash(3,ch,wh,th,p,new_hash,&eff_hash);
 
-		      if((k=add_edge(s,e))!=-1)
+		      if((k=add_edge(chart, s,e))!=-1)
 			{
 			  edges[k].child1=numchilds;
 			  edges[k].numchild=1;
@@ -790,8 +809,8 @@ void add_singles(int s,int e,int si,int ei)
 		      edges[numedges].rc.gap=1;
 		      edges[numedges].prob+=get_gap_prob_witheffhash(4,ch,wh,th,p,new_hash,&eff_hash);
 /*		      printf("CHECK %g %g\n",edges[i].prob,edges[numedges].prob);
-		      print_edge(i,0);*/
-		      if((k=add_edge(s,e))!=-1)
+		      print_edge(chart, i,0);*/
+		      if((k=add_edge(chart, s,e))!=-1)
 			{
 			  edges[k].child1=numchilds;
 			  edges[k].numchild=1;
@@ -805,8 +824,11 @@ void add_singles(int s,int e,int si,int ei)
 }
 
 
-void print_edge(int e,int off)
+void print_edge(chart_context *chart, int e,int off)
 {
+  edge_type *edges = chart->edges;
+  int *childs = chart->childs;
+  sentence_type *current = chart->current;
   int i,j,newoff;
   int flag;
 
@@ -842,19 +864,21 @@ void print_edge(int e,int off)
       return;
     }
 
-  print_edge(childs[edges[e].child1],newoff);
+  print_edge(chart, childs[edges[e].child1],newoff);
 
   for(i=edges[e].child1+1;i<edges[e].child1+edges[e].numchild;i++)
     {    
       for(j=0;j<newoff;j++)
 	printf(" ");
-      print_edge(childs[i],newoff);
+      print_edge(chart, childs[i],newoff);
     }
 
 }
 
-int find_childno(int e,int c)
+int find_childno(chart_context *chart, int e,int c)
 {
+  edge_type *edges = chart->edges;
+  int *childs = chart->childs;
   int i;
 
   for(i=0;i<edges[e].numchild;i++)
@@ -866,8 +890,10 @@ int find_childno(int e,int c)
   return -1;
 }
 
-void print_wholent(int e)
+void print_wholent(chart_context *chart, int e)
 {
+  edge_type *edges = chart->edges;
+  sentence_type *current = chart->current;
 
   printf("%s",nts[(unsigned int) edges[e].label]);
 
@@ -881,13 +907,17 @@ void print_wholent(int e)
     {
       printf("~%s",current->words[current->wordpos[edges[e].head]]);
       printf("~%d",edges[e].numchild);
-      printf("~%d",find_childno(e,edges[e].headch));
+      printf("~%d",find_childno(chart, e,edges[e].headch));
     }
 
 }
 
-void print_edges_flat(int e)
+void print_edges_flat(chart_context *chart, int e)
 {
+  edge_type *edges = chart->edges;
+  int *childs = chart->childs;
+  sentence_type *current = chart->current;
+  int TREEBANKOUTPUTFLAG = chart->TREEBANKOUTPUTFLAG;
   int i,j,w,next;
   int flag;
 
@@ -933,23 +963,25 @@ if(TREEBANKOUTPUTFLAG &&
   if(flag)
     {
       printf("(");
-      print_wholent(e);
+      print_wholent(chart, e);
       printf(" ");
     }
 
-  print_edges_flat(childs[edges[e].child1]);
+  print_edges_flat(chart, childs[edges[e].child1]);
 
   for(i=edges[e].child1+1;i<edges[e].child1+edges[e].numchild;i++)
     {    
-      print_edges_flat(childs[i]);
+      print_edges_flat(chart, childs[i]);
     }
 
   if(flag)
     printf(") ");
 }
 
-void print_chart()
+void print_chart(chart_context *chart)
 {
+  edge_type *edges = chart->edges;
+  int &numedges = chart->numedges;
   int i;
   int dist,subcat;
 
@@ -965,14 +997,23 @@ void print_chart()
       onectxt_to_dist_subcat(&edges[i].rc,&dist,&subcat,0);
       printf("%d %d\n",dist,subcat);
 
-      print_edge(i,0);
+      print_edge(chart, i,0);
       printf("\n\n");
     }
 
 }
 
-void join_2_edges_follow(int e1,int s,int m,int e,int *e2s,int ne2s)
+void join_2_edges_follow(chart_context *chart, int e1,int s,int m,int e,int *e2s,int ne2s)
 {
+  edge_type *edges = chart->edges;
+  int &numedges = chart->numedges;
+  int *childs = chart->childs;
+  int &numchilds = chart->numchilds;
+  int (*sindex)[PMAXWORDS] = chart->sindex;
+  double (*bestprobs)[GMAXNTS] = chart->bestprobs;
+  sentence_type *current = chart->current;
+  double pthresh = chart->pthresh;
+  effhash_table &eff_hash = chart->eff_hash;
   int h2_is_verb,e2,i2;
 
   int e1hlabel;
@@ -1127,7 +1168,7 @@ void join_2_edges_follow(int e1,int s,int m,int e,int *e2s,int ne2s)
 		  
 		  edges[numedges]=e3;
 		  
-		  if((k=add_edge(s,e))!=-1)
+		  if((k=add_edge(chart, s,e))!=-1)
 		    {
 		      edges[k].numchild=edges[e1].numchild+1;
 		      edges[k].child1=numchilds;
@@ -1135,7 +1176,7 @@ void join_2_edges_follow(int e1,int s,int m,int e,int *e2s,int ne2s)
 			childs[numchilds+i]=childs[edges[e1].child1+i];
 		      childs[numchilds+edges[k].numchild-1]=e2;
 		      /*	      printf("AAAA\n");
-				      print_edge(k,0);*/
+				      print_edge(chart, k,0);*/
 		      numchilds+=edges[k].numchild;
 		    }
 		}
@@ -1144,8 +1185,17 @@ void join_2_edges_follow(int e1,int s,int m,int e,int *e2s,int ne2s)
     }
 }
 
-void join_2_edges_precede(int e2,int s,int m,int e,int *e1s,int ne1)
+void join_2_edges_precede(chart_context *chart, int e2,int s,int m,int e,int *e1s,int ne1)
 {
+  edge_type *edges = chart->edges;
+  int &numedges = chart->numedges;
+  int *childs = chart->childs;
+  int &numchilds = chart->numchilds;
+  int (*sindex)[PMAXWORDS] = chart->sindex;
+  double (*bestprobs)[GMAXNTS] = chart->bestprobs;
+  sentence_type *current = chart->current;
+  double pthresh = chart->pthresh;
+  effhash_table &eff_hash = chart->eff_hash;
   int h1_is_verb,e1;
 
   int e2hlabel;
@@ -1214,8 +1264,8 @@ void join_2_edges_precede(int e2,int s,int m,int e,int *e1s,int ne1)
 
 /*	  printf("BBB %g\n",combineprob);
 	  
-	  print_edge(e1,0);
-	  print_edge(e2,0);*/
+	  print_edge(chart, e1,0);
+	  print_edge(chart, e2,0);*/
 
 	  
 	  if(tablep[(unsigned int) edges[e2].label][e2hlabel][(unsigned int) edges[e1].label] &&
@@ -1315,7 +1365,7 @@ void join_2_edges_precede(int e2,int s,int m,int e,int *e1s,int ne1)
 
 		  edges[numedges]=e4;
 		  
-		  if((k=add_edge(s,e))!=-1)
+		  if((k=add_edge(chart, s,e))!=-1)
 		    {
 		      edges[k].numchild=edges[e2].numchild+1;
 		      edges[k].child1=numchilds;
@@ -1323,7 +1373,7 @@ void join_2_edges_precede(int e2,int s,int m,int e,int *e1s,int ne1)
 			childs[numchilds+i+1]=childs[edges[e2].child1+i];
 		      childs[numchilds]=e1;
 		      /*printf("AAAA\n");
-			print_edge(k,0);*/
+			print_edge(chart, k,0);*/
 		      numchilds+=edges[k].numchild;
 		    }
 		}
@@ -1334,17 +1384,23 @@ void join_2_edges_precede(int e2,int s,int m,int e,int *e1s,int ne1)
 
 
 
-void complete(int s, int e)
+void complete(chart_context *chart, int s, int e)
 {
+  edge_type *edges = chart->edges;
+  int &numedges = chart->numedges;
+  int &numchilds = chart->numchilds;
+  int (*sindex)[PMAXWORDS] = chart->sindex;
+  int (*eindex)[PMAXWORDS] = chart->eindex;
+  sentence_type *current = chart->current;
   int i,j,k,k2;
-  int t2[100000],t3[100000],t5[100000];
+  int *t2 = chart->t2, *t3 = chart->t3, *t5 = chart->t5;
   int nt2,nt3,nt5;
 
   if(numedges>(PMAXEDGES*(2.0/3.0))
      || numchilds > (PMAXCHILDS*(2.0/3.0)))
     return;
 
-  init_saments();
+  init_saments(chart);
 
   for(i=s;i<e;i++)
     if( !PUNC_FLAG || (!current->commaats2[i]||e==(current->nws_np-1)||current->commaats[e]) )
@@ -1353,7 +1409,7 @@ void complete(int s, int e)
 	
 	for(k=sindex[i+1][e];k<=eindex[i+1][e];k++)
 	  {	
-	    if(inbeam2(k,i+1,e)){
+	    if(inbeam2(chart, k,i+1,e)){
 	      if(edges[k].stop==1)		      
 		{
 		  t2[nt2] = k;
@@ -1369,10 +1425,10 @@ void complete(int s, int e)
 	  }
 
 	for(j=sindex[s][i];j<=eindex[s][i];j++)
-	  if(inbeam2(j,s,i)){
+	  if(inbeam2(chart, j,s,i)){
 	    if(edges[j].stop==0)
 	      {
-		join_2_edges_follow(j,s,i,e,t2,nt2);
+		join_2_edges_follow(chart, j,s,i,e,t2,nt2);
 	      }
 	    else
 	      {
@@ -1384,15 +1440,15 @@ void complete(int s, int e)
 	for(k2=0;k2<nt3;k2++)
 	  {
 	    k = t3[k2];
-	    join_2_edges_precede(k,s,i,e,t5,nt5);
+	    join_2_edges_precede(chart, k,s,i,e,t5,nt5);
 	  }
 
 	if(is_cc(current->tagnos[i+1])&&i<e-1)
 	  for(j=sindex[s][i];j<=eindex[s][i];j++)
-	    if(inbeam2(j,s,i))
+	    if(inbeam2(chart, j,s,i))
 	      for(k=sindex[i+2][e];k<=eindex[i+2][e];k++)
-		if(inbeam2(k,i+2,e))
-		  join_2_edges_cc(j,k,s,i,e);
+		if(inbeam2(chart, k,i+2,e))
+		  join_2_edges_cc(chart, j,k,s,i,e);
       }
     else
       {
@@ -1400,7 +1456,7 @@ void complete(int s, int e)
 	
 	for(k=sindex[i+1][e];k<=eindex[i+1][e];k++)
 	  {	
-	    if(inbeam2(k,i+1,e)){
+	    if(inbeam2(chart, k,i+1,e)){
 	      if(edges[k].stop==1)		      
 		{
 		  t2[nt2] = k;
@@ -1416,11 +1472,11 @@ void complete(int s, int e)
 	  }
 
 	for(j=sindex[s][i];j<=eindex[s][i];j++)
-	  if(inbeam2(j,s,i)){
+	  if(inbeam2(chart, j,s,i)){
 	    if(edges[j].stop==0)
 	      {
 		;
-/*		join_2_edges_follow(j,s,i,e,t2,nt2);*/
+/*		join_2_edges_follow(chart, j,s,i,e,t2,nt2);*/
 	      }
 	    else
 	      {
@@ -1433,16 +1489,20 @@ void complete(int s, int e)
 	  {
 	    k = t3[k2];
 	    if(is_npb(edges[k].label))
-	      join_2_edges_precede(k,s,i,e,t5,nt5);
+	      join_2_edges_precede(chart, k,s,i,e,t5,nt5);
 	  }
       }
   
-  add_singles_stops(s,e);
+  add_singles_stops(chart, s,e);
 
 }
 
-int find_best_parse(double & prob)
+int find_best_parse(chart_context *chart, double & prob)
 {
+  edge_type *edges = chart->edges;
+  int (*sindex)[PMAXWORDS] = chart->sindex;
+  int (*eindex)[PMAXWORDS] = chart->eindex;
+  sentence_type *current = chart->current;
   int i,best;
 
   best=-1;
@@ -1453,7 +1513,7 @@ int find_best_parse(double & prob)
     if(is_top(edges[i].label) && edges[i].stop==0)
       {
 /*	printf("prob %g\n",edges[i].prob);
-	print_edge(i,0);*/
+	print_edge(chart, i,0);*/
 	if(best==-1)
 	  best=i;
 	else
@@ -1465,27 +1525,37 @@ int find_best_parse(double & prob)
   return best;
 }
 
-int print_best_parse()
+int print_best_parse(chart_context *chart)
 {
+  edge_type *edges = chart->edges;
   int best;
   double prob = MINDOUBLE;
 
-  best = find_best_parse(prob);
+  best = find_best_parse(chart, prob);
 
   if(best!=-1)
     {
       printf("PROB %d %g %d \n",best,edges[best].prob,edges[best].stop);
 
-      print_edge(best,0);
-      print_edges_flat(best);
+      print_edge(chart, best,0);
+      print_edges_flat(chart, best);
       printf("\n");
     }
 
   return best;
 }
 
-void join_2_edges_cc(int e1,int e2,int s,int m,int e)
+void join_2_edges_cc(chart_context *chart, int e1,int e2,int s,int m,int e)
 {
+  edge_type *edges = chart->edges;
+  int &numedges = chart->numedges;
+  int *childs = chart->childs;
+  int &numchilds = chart->numchilds;
+  int (*sindex)[PMAXWORDS] = chart->sindex;
+  double (*bestprobs)[GMAXNTS] = chart->bestprobs;
+  sentence_type *current = chart->current;
+  double pthresh = chart->pthresh;
+  effhash_table &eff_hash = chart->eff_hash;
   int h2_is_verb;
 
   int e1hlabel;
@@ -1590,7 +1660,7 @@ void join_2_edges_cc(int e1,int e2,int s,int m,int e)
 	  e3.stop=0;
 	  edges[numedges]=e3;
 
-	  if((k=add_edge(s,e))!=-1)
+	  if((k=add_edge(chart, s,e))!=-1)
 	    {
 	      edges[k].numchild=edges[e1].numchild+2;
 	      edges[k].child1=numchilds;
@@ -1609,12 +1679,21 @@ void join_2_edges_cc(int e1,int e2,int s,int m,int e)
 
 /* continue to add singles and stops until no more edges are being added */
 
-void add_singles_stops(int s,int e)
+void add_singles_stops(chart_context *chart, int s,int e)
 {
+  int (*sindex)[PMAXWORDS] = chart->sindex;
+  int (*eindex)[PMAXWORDS] = chart->eindex;
+  int &ADDFLAG = chart->ADDFLAG;
+  int *adds1 = chart->adds1;
+  int &numadds1 = chart->numadds1;
+  int *adds2 = chart->adds2;
+  int &numadds2 = chart->numadds2;
+  int *&adds = chart->adds;
+  int *&numadds = chart->numadds;
   int i,n;
 
   ADDFLAG=0;
-  add_singles(s,e,sindex[s][e],eindex[s][e]);
+  add_singles(chart, s,e,sindex[s][e],eindex[s][e]);
   // mihai, for model 2 and 3
   //add_traces(s,e);
 
@@ -1622,7 +1701,7 @@ void add_singles_stops(int s,int e)
   adds = adds1;
   numadds1 = 0;
 
-  add_stops(s,e,sindex[s][e],eindex[s][e]);
+  add_stops(chart, s,e,sindex[s][e],eindex[s][e]);
 
 /*  printf("ADDS");
   for(i=0;i<numadds;i++)
@@ -1639,7 +1718,7 @@ void add_singles_stops(int s,int e)
       numadds2 = 0;
 
       for(i=0;i<numadds1;i++)
-	add_singles(s,e,adds1[i],adds1[i]);
+	add_singles(chart, s,e,adds1[i],adds1[i]);
 
       // mihai, for model 2 and 3
       //add_traces(s,e);
@@ -1649,7 +1728,7 @@ void add_singles_stops(int s,int e)
       numadds1 = 0;
 
       for(i=0;i<numadds2;i++)
-	add_stops(s,e,adds2[i],adds2[i]);
+	add_stops(chart, s,e,adds2[i],adds2[i]);
 
       n++;
     }
@@ -1669,8 +1748,14 @@ int empty_ctxt(ctxt_type *c)
 }
 
 
-void add_stops(int s,int e,int si,int ei)
+void add_stops(chart_context *chart, int s,int e,int si,int ei)
 {
+  edge_type *edges = chart->edges;
+  int &numedges = chart->numedges;
+  int *childs = chart->childs;
+  int &numchilds = chart->numchilds;
+  sentence_type *current = chart->current;
+  effhash_table &eff_hash = chart->eff_hash;
   int i,j,k;
   int dist,subcat,cc,punc;
   int wh,ch,th;
@@ -1682,7 +1767,7 @@ void add_stops(int s,int e,int si,int ei)
   int ehlabel;
 
   for(i=si;i<=ei;i++)
-    if(edges[i].stop==0&&inbeam(i,s,e)&&edges[i].valid==1 &&
+    if(edges[i].stop==0&&inbeam(chart, i,s,e)&&edges[i].valid==1 &&
        empty_ctxt(&edges[i].lc) && empty_ctxt(&edges[i].rc))
       {
 	edges[numedges]=edges[i];
@@ -1730,7 +1815,7 @@ void add_stops(int s,int e,int si,int ei)
 	onectxt_to_dist_subcat(&edges[i].rc,&dist2,&subcat2,0);
 	printf("%d %d\n",dist2,subcat2);
 	
-	print_edge(i,0);
+	print_edge(chart, i,0);
 
 	printf("\n\n");
 
@@ -1769,7 +1854,7 @@ void add_stops(int s,int e,int si,int ei)
 	
 	edges[numedges].prob+=get_dependency_prob_witheffhash(wm,tm,cm,wh,th,p,ch,dist,subcat,cc,0,0,punc,0,0,new_hash,&eff_hash);
 	
-	if((k=add_edge(s,e))!=-1) /* edge is added to the chart, so add */
+	if((k=add_edge(chart, s,e))!=-1) /* edge is added to the chart, so add */
 	  {			/* its children */
 	    edges[k].child1=numchilds;
 	    edges[k].numchild=edges[i].numchild;
@@ -1780,8 +1865,10 @@ void add_stops(int s,int e,int si,int ei)
       }
 }
 
-void calc_prob2(int edge)
+void calc_prob2(chart_context *chart, int edge)
 {
+  edge_type *edges = chart->edges;
+  sentence_type *current = chart->current;
   int ch,wh,th;
   double prob;
 
@@ -1795,15 +1882,17 @@ void calc_prob2(int edge)
   wh=current->wordnos[edges[edge].head];
   th=edges[edge].headtag;
 
-  prob= get_prior_prob_witheffhash(ch,wh,th,new_hash,edges[edge].head,edges[edge].headtag);
+  prob= get_prior_prob_witheffhash(ch,wh,th,new_hash,edges[edge].head,edges[edge].headtag,chart->prior_hashprobs);
 
   edges[edge].prob2 = edges[edge].prob + prob;
 }
 
 
 
-int inbeam(int edge,int s,int e)
+int inbeam(chart_context *chart, int edge,int s,int e)
 {
+  edge_type *edges = chart->edges;
+  double (*bestprobs)[GMAXNTS] = chart->bestprobs;
   if(edges[edge].type!=1)
     {
       if(edges[edge].prob2 < (bestprobs[s][e]-BEAMPROB) ) 
@@ -1822,8 +1911,10 @@ int inbeam(int edge,int s,int e)
   return 1;
 }
 
-int inbeam2(int edge,int s,int e)
+int inbeam2(chart_context *chart, int edge,int s,int e)
 {
+  edge_type *edges = chart->edges;
+  double (*bestprobs)[GMAXNTS] = chart->bestprobs;
   if(edges[edge].inbeam<=1) return edges[edge].inbeam;
 
   if(edges[edge].type!=1)
@@ -1987,10 +2078,13 @@ using namespace spear;
 /** 
  * Constructs one tree corresponding to this edge (or more if there is punc)
  */
-static TreePtr edgeToTree(int e, 
+static TreePtr edgeToTree(chart_context *chart, int e, 
 			  list<TreePtr> & prevPunc,
 			  list<TreePtr> & nextPunc) 
 {
+  edge_type *edges = chart->edges;
+  int *childs = chart->childs;
+  sentence_type *current = chart->current;
   // POS tag case
   if(edges[e].type == 0){
 
@@ -2028,7 +2122,7 @@ static TreePtr edgeToTree(int e,
 
   for(int i = edges[e].child1; i < edges[e].child1 + edges[e].numchild; i ++){
     list<TreePtr> pp, fp;
-    TreePtr child = edgeToTree(childs[i], pp, fp);
+    TreePtr child = edgeToTree(chart, childs[i], pp, fp);
 
     // if this is the left-most child, propagate preceding punctuation up
     if(i == edges[e].child1){
@@ -2066,10 +2160,10 @@ static TreePtr edgeToTree(int e,
   return tree;
 }
 
-spear::TreePtr buildTree(int edge)
+spear::TreePtr buildTree(chart_context *chart, int edge)
 {
   list<TreePtr> prevPunc, nextPunc;
-  TreePtr tree = edgeToTree(edge, prevPunc, nextPunc);
+  TreePtr tree = edgeToTree(chart, edge, prevPunc, nextPunc);
 
   // append top-level preceding punctuation
   for(list<TreePtr>::reverse_iterator it = prevPunc.rbegin();
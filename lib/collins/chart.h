@@ -48,38 +48,122 @@ extern double BEAMPROB; /*size of the beam if pbest = highest prob of all edges
 			  a particular span, then all edges with 
 			  logprob < log(pbest) - BEAMPROB are discarded*/
 
-/* hash tables used by the probability models*/
+/* hash table used by the probability models. It is only read while parsing,
+   so it is shared by all the chart contexts*/
 
 extern hash_table * new_hash;
-extern effhash_table eff_hash;
 
+#define PMAXEDGES 200000
+#define PMAXCHILDS 3000000
 
-/* a threshold: all edges must have prob greater than this threshold to be
-   added to the chart 
-   */
-extern double pthresh;
+/*size of the adds arrays used by add_singles_stops, and of the arrays of
+  edges to join used by complete*/
+#define PMAXADDS 100000
+
+/*size of the cache of probabilities of each chart context*/
+#define PEFFHASHSIZE 1000003
+
+/* saments is a data structure that supports add_edge (see chart.cc) */
+
+typedef struct {
+  int edge1;
+  int minedge;
+  double minprob;
+  char numedges;
+} sament_type;
+
+/* everything that changes while a sentence is parsed: the chart, the caches
+   of probabilities, and scratch space. With one context per thread, sentences
+   can be parsed concurrently (the grammar and new_hash are only read)
+
+   edges is an array of edges in the chart
+
+   childs is an array used for the children of each node in the chart:
+
+   childs[edge[i].child1] to childs[edge[i].child1+edge[i].numchild-1] are
+   the children of the i'th edge in left to right order (being indexes into
+   the edges array themselves)
+
+   The edges in the chart spanning words s to e inclusive are contained
+   in edges[sindex[s][e]] to edges[eindex[s][e]] inclusive
+
+   if no edges have been added to the chart for the span s..e,
+   sindex[s][e]==-1, eindex[s][e]==-2
+
+   bestprobs[s][e] holds the highest probability for all edges added spanning
+   words s..e, used for pruning edges from the chart
+
+   current is the sentence being parsed
+
+   pthresh is a threshold: all edges must have prob greater than this
+   threshold to be added to the chart
+*/
+
+typedef struct chart_context {
+  edge_type *edges;
+  int numedges;
+
+  int *childs;
+  int numchilds;
+
+  int sindex[PMAXWORDS][PMAXWORDS];
+  int eindex[PMAXWORDS][PMAXWORDS];
+
+  sament_type saments[GMAXNTS];
+
+  double bestprobs[GMAXNTS][GMAXNTS];
+
+  /* used by add_singles_stops */
+  int ADDFLAG;
+  int *adds1;
+  int numadds1;
+  int *adds2;
+  int numadds2;
+  int *adds;
+  int *numadds;
+
+  /* used by complete */
+  int *t2;
+  int *t3;
+  int *t5;
+
+  effhash_table eff_hash;
+  prior_probs_type *prior_hashprobs;
+
+  sentence_type *current;
+
+  double pthresh;
+
+  int TREEBANKOUTPUTFLAG;
+  int PRINT_EDGES;
+} chart_context;
+
+/*allocates a chart context, NULL if there is not enough memory*/
+chart_context *make_chart_context();
+
+void free_chart_context(chart_context *chart);
 
 /*print the entire chart*/
-void print_chart();
+void print_chart(chart_context *chart);
 
 /*print the highest prob tree spanning the entire sentence, rooted in the
   top symbol*/
-int print_best_parse();
+int print_best_parse(chart_context *chart);
 
 /** finds the id of the highest prob tree spanning the entire sentence, rooted in the top symbol */
-int find_best_parse(double & prob);
+int find_best_parse(chart_context *chart, double & prob);
 
-/*parse a sentence, print the output to stdout*/
-void parse_sentence(sentence_type *sentence);
+/*parse a sentence, print the output to stdout if the trace output is set*/
+void parse_sentence(chart_context *chart, sentence_type *sentence);
 
-void set_treebankoutputflag(int flag);
+void set_treebankoutputflag(chart_context *chart, int flag);
 
-void set_traceoutput(int flag);
+void set_traceoutput(chart_context *chart, int flag);
 
 /** Required by buildTree */
 #include "spear/Tree.h"
 
 /** This is the interface to the spear API */
-spear::TreePtr buildTree(int edge);
+spear::TreePtr buildTree(chart_context *chart, int edge);
 
 #endif
@@ -29,22 +29,42 @@
 
 int effhash_find_element(key_type *key,effhash_table *effhash);
 
+/* The keys are allocated in one block, rather than with mymalloc_char, so that
+   tables can be made and freed by any thread (one per parser context) */
 void effhash_make_table(int size,effhash_table *effhash)
 {
   int i;
   effhash->table=(effhash_node *) malloc(size*sizeof(effhash_node));
+  effhash->keys=(unsigned char *) malloc(size*MAXEFFKEYLEN);
   effhash->num=0;
-  effhash_clear_table(effhash);
+
+  /*on failure both pointers are left NULL, for the caller to check*/
+  if(effhash->table==NULL || effhash->keys==NULL)
+    {
+      effhash_free_table(effhash);
+      return;
+    }
+
   effhash->size=size;
+  effhash_clear_table(effhash);
 
   for(i=0;i<size;i++)
     {
-      effhash->table[i].key.key = (unsigned char *) mymalloc_char(MAXEFFKEYLEN);
-/*      effhash->table[i].key.key = (char *) malloc(MAXEFFKEYLEN*sizeof(char));*/
+      effhash->table[i].key.key = effhash->keys + i*MAXEFFKEYLEN;
       effhash->table[i].key.klen = 0;
     }
 }
 
+void effhash_free_table(effhash_table *effhash)
+{
+  free(effhash->keys);
+  free(effhash->table);
+  effhash->keys=NULL;
+  effhash->table=NULL;
+  effhash->size=0;
+  effhash->num=0;
+}
+
 int effhash_find_element(key_type *key,effhash_table *effhash)
 {
   int pos;
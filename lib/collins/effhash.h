@@ -44,11 +44,13 @@ typedef struct {
   int num;
   int size;
   effhash_node *table;
+  unsigned char *keys;
   unsigned char s;
 } effhash_table;
 
 
 void effhash_make_table(int size,effhash_table *effhash);
+void effhash_free_table(effhash_table *effhash);
 void effhash_clear_table(effhash_table *effhash);
 void effhash_newsent(effhash_table *effhash);
 
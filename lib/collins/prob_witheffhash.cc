@@ -36,9 +36,6 @@
 #define GEFFTYPE 3
 #define GEFFLEN 9
 
-/*array for caching prior probabilities*/
-double prior_hashprobs[PMAXWORDS][GMAXNTS][GMAXNTS];
-
 
 /* wm/tm/cm = modifer word/tag/non-terminal
    
@@ -159,7 +156,7 @@ double get_gap_prob_witheffhash(int gap,int ch,int wh,int th,int p,hash_table *h
   return prob;
 }
 
-double get_prior_prob_witheffhash(int ch,int wh,int th,hash_table *hash,int word,int tag)
+double get_prior_prob_witheffhash(int ch,int wh,int th,hash_table *hash,int word,int tag,prior_probs_type *prior_hashprobs)
 {
   double prob;
 
@@ -174,11 +171,11 @@ double get_prior_prob_witheffhash(int ch,int wh,int th,hash_table *hash,int word
   return (prob);
 }
 
-void reset_prior_hashprobs()
+void reset_prior_hashprobs(prior_probs_type *prior_hashprobs,int nws)
 {
   int i,j,k;
 
-  for(i=0;i<PMAXWORDS;i++)
+  for(i=0;i<nws;i++)
     for(j=0;j<GMAXNTS;j++)
       for(k=0;k<GMAXNTS;k++)
 	prior_hashprobs[i][j][k]=10;
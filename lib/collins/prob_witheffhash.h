@@ -58,11 +58,16 @@ double get_subcat_prob_witheffhash(int subcat,int ch,int wh,int th,int p,int dir
 double get_gap_prob_witheffhash(int gap,int ch,int wh,int th,int p,hash_table *hash,effhash_table *effhash);
 
 
+/*array for caching prior probabilities, prior_hashprobs[word][tag][ch] for
+  word=0..PMAXWORDS-1*/
+typedef double prior_probs_type[GMAXNTS][GMAXNTS];
+
 /*hashes prior prob for word,tag,ch (where word,tag are indexes into the
   _sentence_)
 */
-double get_prior_prob_witheffhash(int ch,int wh,int th,hash_table *hash,int word,int tag);
+double get_prior_prob_witheffhash(int ch,int wh,int th,hash_table *hash,int word,int tag,prior_probs_type *prior_hashprobs);
 
-void reset_prior_hashprobs();
+/*clears the cached prior probs for the first nws words of the sentence*/
+void reset_prior_hashprobs(prior_probs_type *prior_hashprobs,int nws);
 
 #endif
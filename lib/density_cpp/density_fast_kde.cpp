@@ -0,0 +1,663 @@
+/* =========================================================================== *
+   |
+   |  Copyright (c) 1994-2011 by Kobus Barnard (author)
+   |
+   |  Personal and educational use of this code is granted, provided that this
+   |  header is kept intact, and that the authorship is not misrepresented, that
+   |  its use is acknowledged in publications, and relevant papers are cited.
+   |
+   |  For other use contact the author (kobus AT cs DOT arizona DOT edu).
+   |
+   |  Please note that the code in this file has not necessarily been adequately
+   |  tested. Naturally, there is no guarantee of performance, support, or fitness
+   |  for any particular task. Nonetheless, I am interested in hearing about
+   |  problems that you encounter.
+   |
+ * =========================================================================== */
+
+/* $Id$ */
+
+#include <density_cpp/density_fast_kde.h>
+#include <boost/thread.hpp>
+#include <boost/bind.hpp>
+#include <boost/ref.hpp>
+#include <algorithm>
+#include <limits>
+#include <cmath>
+
+namespace {
+
+// leaves of the k-d tree hold at most this many samples
+const size_t LEAF_SIZE = 16;
+
+// the k-d tree is never deeper than this (2^64 samples), so the traversal
+// stack, which holds at most one extra node per level, is bounded
+const size_t MAX_STACK = 130;
+
+// highest order considered for the fast Gauss transform
+const size_t FGT_MAX_ORDER = 30;
+
+// the fast Gauss transform is written for exp(-|d|^2 / h^2); our unit-peak
+// Gaussian kernel on the scaled samples is exp(-|d|^2 / 2)
+const double FGT_H_SQ = 2.0;
+
+/** @brief  Compares samples (by index) along one coordinate. */
+class Coordinate_less
+{
+public:
+    Coordinate_less(const std::vector<double>& points, size_t dim, size_t j) :
+        m_points(points), m_dim(dim), m_j(j)
+    {}
+
+    bool operator()(size_t a, size_t b) const
+    {
+        return m_points[a*m_dim + m_j] < m_points[b*m_dim + m_j];
+    }
+
+private:
+    const std::vector<double>& m_points;
+    size_t m_dim;
+    size_t m_j;
+};
+
+/**
+ * @brief   Computes the scaled monomials scale * d^alpha for all multi-indices
+ *          alpha of total degree less than order, in graded order.
+ */
+void fgt_monomials
+(
+    const double* d,
+    size_t dim,
+    size_t order,
+    double scale,
+    std::vector<size_t>& heads,
+    double* monomials
+)
+{
+    std::fill(heads.begin(), heads.begin() + dim, 0);
+    monomials[0] = scale;
+    for(size_t k = 1, t = 1, tail = 1; k < order; k++, tail = t)
+    {
+        for(size_t i = 0; i < dim; i++)
+        {
+            size_t head = heads[i];
+            heads[i] = t;
+            for(size_t j = head; j < tail; j++, t++)
+            {
+                monomials[t] = d[i] * monomials[j];
+            }
+        }
+    }
+}
+
+/** @brief  Number of multi-indices in dim variables of degree < order. */
+double fgt_num_terms(size_t dim, size_t order)
+{
+    // binomial(order - 1 + dim, dim)
+    double n = 1.0;
+    for(size_t i = 1; i <= dim; i++)
+    {
+        n *= static_cast<double>(order - 1 + i) / i;
+    }
+    return std::floor(n + 0.5);
+}
+
+} // anonymous namespace
+
+namespace kjb {
+
+void Fast_kde::finish_init(double prod_h)
+{
+    const size_t D = m_dim;
+
+    m_normalizer = 1.0 / (m_num_samples * prod_h);
+    if(m_kernel == GAUSSIAN_KERNEL)
+    {
+        m_normalizer *= std::pow(2*M_PI, -0.5*D);
+    }
+    else
+    {
+        m_normalizer *= std::pow(0.75, static_cast<double>(D));
+    }
+
+    // build the tree on a permutation, then store the samples in tree order
+    std::vector<size_t> perm(m_num_samples);
+    for(size_t i = 0; i < m_num_samples; i++)
+    {
+        perm[i] = i;
+    }
+
+    m_nodes.clear();
+    m_lo.clear();
+    m_hi.clear();
+    build_tree(perm, 0, m_num_samples);
+
+    std::vector<double> ordered(m_points.size());
+    for(size_t i = 0; i < m_num_samples; i++)
+    {
+        std::copy(m_points.begin() + perm[i]*D,
+                  m_points.begin() + (perm[i] + 1)*D,
+                  ordered.begin() + i*D);
+    }
+    m_points.swap(ordered);
+
+    m_fgt_order = 0;
+    m_fgt_terms = 0;
+    m_fgt_centers.clear();
+    m_fgt_coeffs.clear();
+    if(m_method == FAST_GAUSS_TRANSFORM)
+    {
+        if(m_kernel == GAUSSIAN_KERNEL)
+        {
+            setup_fgt();
+        }
+        else
+        {
+            m_method = KD_TREE;
+        }
+    }
+}
+
+/**
+ * Builds the subtree over perm[begin, end), splitting the widest side of the
+ * bounding box at the median, and returns the index of its root.
+ */
+size_t Fast_kde::build_tree(std::vector<size_t>& perm, size_t begin, size_t end)
+{
+    const size_t D = m_dim;
+    const size_t n = m_nodes.size();
+
+    Node node = { begin, end, 0, 0 };
+    m_nodes.push_back(node);
+    m_lo.insert(m_lo.end(), D, std::numeric_limits<double>::max());
+    m_hi.insert(m_hi.end(), D, -std::numeric_limits<double>::max());
+
+    for(size_t i = begin; i < end; i++)
+    {
+        const double* p = &m_points[perm[i]*D];
+        for(size_t j = 0; j < D; j++)
+        {
+            m_lo[n*D + j] = std::min(m_lo[n*D + j], p[j]);
+            m_hi[n*D + j] = std::max(m_hi[n*D + j], p[j]);
+        }
+    }
+
+    if(end - begin <= LEAF_SIZE)
+    {
+        return n;
+    }
+
+    size_t split = 0;
+    for(size_t j = 1; j < D; j++)
+    {
+        if(m_hi[n*D + j] - m_lo[n*D + j] > m_hi[n*D + split] - m_lo[n*D + split])
+        {
+            split = j;
+        }
+    }
+
+    if(m_hi[n*D + split] == m_lo[n*D + split])
+    {
+        // all samples coincide
+        return n;
+    }
+
+    size_t mid = begin + (end - begin) / 2;
+    std::nth_element(perm.begin() + begin, perm.begin() + mid, perm.begin() + end,
+                     Coordinate_less(m_points, D, split));
+
+    size_t left = build_tree(perm, begin, mid);
+    size_t right = build_tree(perm, mid, end);
+    m_nodes[n].left = left;
+    m_nodes[n].right = right;
+
+    return n;
+}
+
+/**
+ * Chooses the number of clusters and the order of the fast Gauss transform
+ * that meet the error bound at the lowest estimated cost per query, and
+ * computes the expansion coefficients. Falls back to the k-d tree when no
+ * choice is cheaper than summing over all samples.
+ */
+void Fast_kde::setup_fgt()
+{
+    const size_t D = m_dim;
+    const size_t N = m_num_samples;
+    const double h = std::sqrt(FGT_H_SQ);
+
+    // Farthest-point clustering, which adds one center at a time, so the
+    // first k centers are the clustering into k clusters. We record the
+    // radius of each clustering.
+    size_t k_limit = std::max<size_t>(1, static_cast<size_t>(std::sqrt(double(N))));
+    std::vector<size_t> centers;
+    std::vector<double> radius(1, 0.0);
+    std::vector<double> dist_sq(N, std::numeric_limits<double>::max());
+    size_t next = 0;
+    while(centers.size() < k_limit)
+    {
+        centers.push_back(next);
+        const double* c = &m_points[next*D];
+        double far_sq = 0.0;
+        for(size_t i = 0; i < N; i++)
+        {
+            const double* p = &m_points[i*D];
+            double d_sq = 0.0;
+            for(size_t j = 0; j < D; j++)
+            {
+                d_sq += (p[j] - c[j]) * (p[j] - c[j]);
+            }
+            dist_sq[i] = std::min(dist_sq[i], d_sq);
+            if(dist_sq[i] > far_sq)
+            {
+                far_sq = dist_sq[i];
+                next = i;
+            }
+        }
+        radius.push_back(std::sqrt(far_sq));
+        if(far_sq == 0.0) break;
+    }
+
+    // Sources farther than ry - rx from a query contribute at most
+    // epsilon / 2 each, and so does the Taylor remainder of the others,
+    // which is (2^p / p!) (rx ry / h^2)^p.
+    const double margin = h * std::sqrt(std::log(2.0 / m_epsilon));
+    double best_cost = static_cast<double>(N);
+    size_t best_k = 0;
+    size_t best_order = 0;
+    for(size_t k = 1; k < radius.size(); k++)
+    {
+        const double rx = radius[k];
+        const double ry = rx + margin;
+        const double t = rx * ry / FGT_H_SQ;
+
+        size_t order = 0;
+        double bound = 1.0;
+        for(size_t p = 1; p <= FGT_MAX_ORDER; p++)
+        {
+            bound *= 2.0 * t / p;
+            if(bound <= m_epsilon / 2.0)
+            {
+                order = p;
+                break;
+            }
+        }
+        if(order == 0) continue;
+
+        // fraction of the clusters expected within the cutoff of a query
+        double frac = 1.0;
+        for(size_t j = 0; j < D; j++)
+        {
+            double extent = m_hi[j] - m_lo[j];
+            if(extent > 2*ry) frac *= 2*ry / extent;
+        }
+
+        double cost = fgt_num_terms(D, order) * (1.0 + k * frac) + k * D;
+        if(cost < best_cost)
+        {
+            best_cost = cost;
+            best_k = k;
+            best_order = order;
+        }
+    }
+
+    if(best_k == 0)
+    {
+        m_method = KD_TREE;
+        return;
+    }
+
+    m_fgt_order = best_order;
+    m_fgt_terms = static_cast<size_t>(fgt_num_terms(D, best_order));
+    m_fgt_cutoff_sq = (radius[best_k] + margin) * (radius[best_k] + margin);
+
+    m_fgt_centers.resize(best_k * D);
+    for(size_t k = 0; k < best_k; k++)
+    {
+        std::copy(m_points.begin() + centers[k]*D,
+                  m_points.begin() + (centers[k] + 1)*D,
+                  m_fgt_centers.begin() + k*D);
+    }
+
+    // accumulate sum_i exp(-|dx_i|^2) dx_i^alpha per cluster...
+    m_fgt_coeffs.assign(best_k * m_fgt_terms, 0.0);
+    std::vector<size_t> heads(D + 1);
+    std::vector<double> dx(D);
+    std::vector<double> monomials(m_fgt_terms);
+    for(size_t i = 0; i < N; i++)
+    {
+        const double* p = &m_points[i*D];
+        size_t nearest = 0;
+        double nearest_sq = std::numeric_limits<double>::max();
+        for(size_t k = 0; k < best_k; k++)
+        {
+            const double* c = &m_fgt_centers[k*D];
+            double d_sq = 0.0;
+            for(size_t j = 0; j < D; j++)
+            {
+                d_sq += (p[j] - c[j]) * (p[j] - c[j]);
+            }
+            if(d_sq < nearest_sq)
+            {
+                nearest_sq = d_sq;
+                nearest = k;
+            }
+        }
+
+        const double* c = &m_fgt_centers[nearest*D];
+        for(size_t j = 0; j < D; j++)
+        {
+            dx[j] = (p[j] - c[j]) / h;
+        }
+        fgt_monomials(&dx[0], D, m_fgt_order, std::exp(-nearest_sq / FGT_H_SQ),
+                      heads, &monomials[0]);
+
+        double* coeffs = &m_fgt_coeffs[nearest * m_fgt_terms];
+        for(size_t a = 0; a < m_fgt_terms; a++)
+        {
+            coeffs[a] += monomials[a];
+        }
+    }
+
+    // ...and multiply by 2^|alpha| / alpha!, built up the same way as the
+    // monomials; count[t] is the exponent of the variable last multiplied in
+    std::vector<double> constants(m_fgt_terms);
+    std::vector<size_t> count(m_fgt_terms);
+    std::fill(heads.begin(), heads.begin() + D, 0);
+    heads[D] = std::numeric_limits<size_t>::max();
+    constants[0] = 1.0;
+    count[0] = 0;
+    for(size_t k = 1, t = 1, tail = 1; k < m_fgt_order; k++, tail = t)
+    {
+        for(size_t i = 0; i < D; i++)
+        {
+            size_t head = heads[i];
+            heads[i] = t;
+            for(size_t j = head; j < tail; j++, t++)
+            {
+                count[t] = j < heads[i + 1] ? count[j] + 1 : 1;
+                constants[t] = 2.0 * constants[j] / count[t];
+            }
+        }
+    }
+
+    for(size_t k = 0; k < best_k; k++)
+    {
+        for(size_t a = 0; a < m_fgt_terms; a++)
+        {
+            m_fgt_coeffs[k*m_fgt_terms + a] *= constants[a];
+        }
+    }
+}
+
+double Fast_kde::operator()(const Vector& x) const
+{
+    IFT(x.get_length() == static_cast<int>(m_dim), Illegal_argument,
+        "Fast_kde: samples and estimation point must have same dimension.");
+
+    std::vector<double> u(m_dim);
+    for(size_t j = 0; j < m_dim; j++)
+    {
+        u[j] = x[j] * m_inv_h[j];
+    }
+
+    return m_normalizer * kernel_sum(&u[0]);
+}
+
+Vector Fast_kde::evaluate
+(
+    const std::vector<double>& queries,
+    size_t num_threads
+) const
+{
+    const size_t M = queries.size() / m_dim;
+    Vector result(static_cast<int>(M));
+
+    size_t avail_cores = boost::thread::hardware_concurrency();
+    if(num_threads == 0 || num_threads > avail_cores)
+    {
+        num_threads = avail_cores;
+    }
+    if(num_threads > M)
+    {
+        num_threads = M;
+    }
+
+    if(num_threads <= 1)
+    {
+        evaluate_range(queries, 0, M, result);
+        return result;
+    }
+
+    boost::thread_group thrds;
+    for(size_t i = 0; i < num_threads; i++)
+    {
+        size_t st = (M / num_threads) * i;
+        size_t l = (i == num_threads - 1 ? M : (M / num_threads) * (i + 1));
+        thrds.create_thread(boost::bind(&Fast_kde::evaluate_range, this,
+                                        boost::cref(queries), st, l,
+                                        boost::ref(result)));
+    }
+    thrds.join_all();
+
+    return result;
+}
+
+void Fast_kde::evaluate_range
+(
+    const std::vector<double>& queries,
+    size_t begin,
+    size_t end,
+    Vector& result
+) const
+{
+    std::vector<double> u(m_dim);
+    for(size_t q = begin; q < end; q++)
+    {
+        for(size_t j = 0; j < m_dim; j++)
+        {
+            u[j] = queries[q*m_dim + j] * m_inv_h[j];
+        }
+        result[q] = m_normalizer * kernel_sum(&u[0]);
+    }
+}
+
+/** Sum of the unit-peak kernels centered at the samples, at u (scaled). */
+double Fast_kde::kernel_sum(const double* u) const
+{
+    switch(m_method)
+    {
+        case DIRECT_SUM:
+            return direct_sum(u, 0, m_num_samples);
+
+        case FAST_GAUSS_TRANSFORM:
+            return fgt_sum(u);
+
+        default:
+            return tree_sum(u);
+    }
+}
+
+double Fast_kde::direct_sum(const double* u, size_t begin, size_t end) const
+{
+    const size_t D = m_dim;
+    double f = 0.0;
+
+    if(m_kernel == GAUSSIAN_KERNEL)
+    {
+        for(size_t i = begin; i < end; i++)
+        {
+            const double* p = &m_points[i*D];
+            double d_sq = 0.0;
+            for(size_t j = 0; j < D; j++)
+            {
+                d_sq += (u[j] - p[j]) * (u[j] - p[j]);
+            }
+            f += std::exp(-0.5 * d_sq);
+        }
+    }
+    else
+    {
+        for(size_t i = begin; i < end; i++)
+        {
+            const double* p = &m_points[i*D];
+            double f_i = 1.0;
+            for(size_t j = 0; j < D && f_i > 0.0; j++)
+            {
+                double d = u[j] - p[j];
+                f_i *= std::max(0.0, 1.0 - d*d);
+            }
+            f += f_i;
+        }
+    }
+
+    return f;
+}
+
+/** Bounds on the kernel between u and any sample in the box of node n. */
+void Fast_kde::node_bounds
+(
+    const double* u,
+    size_t n,
+    double* k_min,
+    double* k_max
+) const
+{
+    const size_t D = m_dim;
+    const double* lo = &m_lo[n*D];
+    const double* hi = &m_hi[n*D];
+
+    double near_sq = 0.0;
+    double far_sq = 0.0;
+    double prod_min = 1.0;
+    double prod_max = 1.0;
+    for(size_t j = 0; j < D; j++)
+    {
+        double near = std::max(0.0, std::max(lo[j] - u[j], u[j] - hi[j]));
+        double far = std::max(std::fabs(u[j] - lo[j]), std::fabs(u[j] - hi[j]));
+        near_sq += near * near;
+        far_sq += far * far;
+        prod_max *= std::max(0.0, 1.0 - near * near);
+        prod_min *= std::max(0.0, 1.0 - far * far);
+    }
+
+    if(m_kernel == GAUSSIAN_KERNEL)
+    {
+        *k_min = std::exp(-0.5 * far_sq);
+        *k_max = std::exp(-0.5 * near_sq);
+    }
+    else
+    {
+        *k_min = prod_min;
+        *k_max = prod_max;
+    }
+}
+
+/**
+ * Depth-first traversal, nearer child first. A node whose kernel values lie
+ * in [k_min, k_max] contributes size * (k_min + k_max) / 2, with an error of
+ * at most size * (k_max - k_min) / 2; this is accepted if it is at most
+ * size * epsilon * S_lo / N, where S_lo is a lower bound of the whole sum,
+ * so that the errors add up to at most epsilon times the sum.
+ */
+double Fast_kde::tree_sum(const double* u) const
+{
+    struct Entry
+    {
+        size_t node;
+        double k_min;
+        double k_max;
+    };
+
+    const double tol = 2.0 * m_epsilon / m_num_samples;
+    Entry stack[MAX_STACK];
+    size_t top = 0;
+
+    node_bounds(u, 0, &stack[0].k_min, &stack[0].k_max);
+    stack[0].node = 0;
+    top = 1;
+
+    double lower = m_num_samples * stack[0].k_min;
+    double f = 0.0;
+    while(top > 0)
+    {
+        const Entry e = stack[--top];
+        const Node& node = m_nodes[e.node];
+        const double size = static_cast<double>(node.end - node.begin);
+
+        if(e.k_max - e.k_min <= tol * lower)
+        {
+            f += size * 0.5 * (e.k_min + e.k_max);
+            continue;
+        }
+
+        if(node.left == 0)
+        {
+            double exact = direct_sum(u, node.begin, node.end);
+            f += exact;
+            lower += exact - size * e.k_min;
+            continue;
+        }
+
+        Entry a = { node.left, 0.0, 0.0 };
+        Entry b = { node.right, 0.0, 0.0 };
+        node_bounds(u, a.node, &a.k_min, &a.k_max);
+        node_bounds(u, b.node, &b.k_min, &b.k_max);
+        const Node& na = m_nodes[a.node];
+        const Node& nb = m_nodes[b.node];
+        lower += (na.end - na.begin) * a.k_min + (nb.end - nb.begin) * b.k_min
+                 - size * e.k_min;
+
+        if(a.k_max > b.k_max)
+        {
+            std::swap(a, b);
+        }
+        stack[top++] = a;
+        stack[top++] = b;
+    }
+
+    return f;
+}
+
+double Fast_kde::fgt_sum(const double* u) const
+{
+    const size_t D = m_dim;
+    const size_t K = m_fgt_centers.size() / D;
+    const double h = std::sqrt(FGT_H_SQ);
+
+    std::vector<size_t> heads(D + 1);
+    std::vector<double> dy(D);
+    std::vector<double> monomials(m_fgt_terms);
+
+    double f = 0.0;
+    for(size_t k = 0; k < K; k++)
+    {
+        const double* c = &m_fgt_centers[k*D];
+        double d_sq = 0.0;
+        for(size_t j = 0; j < D; j++)
+        {
+            dy[j] = u[j] - c[j];
+            d_sq += dy[j] * dy[j];
+        }
+        if(d_sq > m_fgt_cutoff_sq) continue;
+
+        for(size_t j = 0; j < D; j++)
+        {
+            dy[j] /= h;
+        }
+        fgt_monomials(&dy[0], D, m_fgt_order, std::exp(-d_sq / FGT_H_SQ),
+                      heads, &monomials[0]);
+
+        const double* coeffs = &m_fgt_coeffs[k * m_fgt_terms];
+        for(size_t a = 0; a < m_fgt_terms; a++)
+        {
+            f += coeffs[a] * monomials[a];
+        }
+    }
+
+    // the truncation can make the sum slightly negative far from the samples
+    return std::max(0.0, f);
+}
+
+} //namespace kjb
+
@@ -0,0 +1,269 @@
+/* =========================================================================== *
+   |
+   |  Copyright (c) 1994-2011 by Kobus Barnard (author)
+   |
+   |  Personal and educational use of this code is granted, provided that this
+   |  header is kept intact, and that the authorship is not misrepresented, that
+   |  its use is acknowledged in publications, and relevant papers are cited.
+   |
+   |  For other use contact the author (kobus AT cs DOT arizona DOT edu).
+   |
+   |  Please note that the code in this file has not necessarily been adequately
+   |  tested. Naturally, there is no guarantee of performance, support, or fitness
+   |  for any particular task. Nonetheless, I am interested in hearing about
+   |  problems that you encounter.
+   |
+ * =========================================================================== */
+
+/* $Id$ */
+
+#ifndef DENSITY_FAST_KDE_H
+#define DENSITY_FAST_KDE_H
+
+/**
+ * @file    Contains a kernel density estimator for many queries.
+ */
+
+#include <m_cpp/m_vector.h>
+#include <l_cpp/l_exception.h>
+#include <vector>
+#include <iterator>
+
+namespace kjb {
+
+/**
+ * @brief   Fixed kernel multivariate density estimator for repeated queries.
+ *
+ * This class computes the same estimate as fkde (a product of univariate
+ * kernels, with one bandwidth per dimension), but it copies the samples into
+ * contiguous storage once and answers queries approximately, with a
+ * user-specified error bound, so that it can be evaluated many times (e.g.,
+ * as a prior inside an MCMC loop) or on many points at once.
+ *
+ * Two approximations are available:
+ *
+ * - KD_TREE (the default) organizes the samples in a k-d tree and replaces
+ *   the contribution of a whole node by the midpoint of its lower and upper
+ *   bounds when that is accurate enough. The result f' satisfies
+ *   |f' - f| <= epsilon * f.
+ *
+ * - FAST_GAUSS_TRANSFORM, for Gaussian kernels only, uses the improved fast
+ *   Gauss transform: the samples are clustered, and each cluster is replaced
+ *   by a truncated Taylor expansion computed at construction, so a query
+ *   costs about the number of nearby clusters times the number of expansion
+ *   terms. The result satisfies |f' - f| <= epsilon * f_max, where f_max is
+ *   the largest value that the estimate can take (that of a single kernel at
+ *   its mode). When the number of terms needed for the bound would make the
+ *   expansion slower than a direct sum (typically in more than a few
+ *   dimensions), the estimator uses the k-d tree instead, whose bound implies
+ *   this one; see method().
+ *
+ * DIRECT_SUM computes the exact sum, which is mostly useful for testing.
+ */
+class Fast_kde
+{
+public:
+    /** @brief  Univariate kernels; the product is taken over dimensions. */
+    enum Kernel_type { GAUSSIAN_KERNEL, EPANECHNIKOV_KERNEL };
+
+    /** @brief  Ways of evaluating the estimate. */
+    enum Method { DIRECT_SUM, KD_TREE, FAST_GAUSS_TRANSFORM };
+
+    /**
+     * @brief   Builds an estimator from the samples in [first, last).
+     *
+     * @param   first   Iterator to the first sample (a Vector).
+     * @param   last    One-past-the-end iterator in sequence of samples.
+     * @param   h       Bandwidths, one per dimension.
+     * @param   kernel  The univariate kernel.
+     * @param   method  How to evaluate the estimate.
+     * @param   epsilon Error bound; see the class documentation.
+     */
+    template <class VecIterator>
+    Fast_kde
+    (
+        VecIterator first,
+        VecIterator last,
+        const Vector& h,
+        Kernel_type kernel = GAUSSIAN_KERNEL,
+        Method method = KD_TREE,
+        double epsilon = 1e-3
+    ) :
+        m_kernel(kernel),
+        m_method(method),
+        m_epsilon(epsilon)
+    {
+        init(first, last, std::vector<double>(h.begin(), h.end()));
+    }
+
+    /**
+     * @brief   Builds an estimator with the same bandwidth in all dimensions.
+     */
+    template <class VecIterator>
+    Fast_kde
+    (
+        VecIterator first,
+        VecIterator last,
+        double h,
+        Kernel_type kernel = GAUSSIAN_KERNEL,
+        Method method = KD_TREE,
+        double epsilon = 1e-3
+    ) :
+        m_kernel(kernel),
+        m_method(method),
+        m_epsilon(epsilon)
+    {
+        IFT(first != last, Illegal_argument, "Fast_kde: need at least one sample.");
+        init(first, last, std::vector<double>(first->get_length(), h));
+    }
+
+    /** @brief  Estimates the pdf at x. */
+    double operator()(const Vector& x) const;
+
+    /**
+     * @brief   Estimates the pdf at every point in [first, last).
+     *
+     * The queries are split into contiguous ranges that are evaluated by
+     * num_threads threads; 0 means one per hardware thread.
+     */
+    template <class VecIterator>
+    Vector operator()
+    (
+        VecIterator first,
+        VecIterator last,
+        size_t num_threads = 0
+    ) const
+    {
+        std::vector<double> queries;
+        for(; first != last; first++)
+        {
+            IFT(first->get_length() == static_cast<int>(m_dim),
+                Illegal_argument,
+                "Fast_kde: samples and estimation point must have same dimension.");
+            queries.insert(queries.end(), first->begin(), first->end());
+        }
+
+        return evaluate(queries, num_threads);
+    }
+
+    /** @brief  Number of dimensions. */
+    size_t get_dimension() const { return m_dim; }
+
+    /** @brief  Number of samples. */
+    size_t get_num_samples() const { return m_num_samples; }
+
+    /**
+     * @brief   The method actually in use, which is KD_TREE if
+     *          FAST_GAUSS_TRANSFORM was requested but not worthwhile.
+     */
+    Method method() const { return m_method; }
+
+    /** @brief  Number of clusters of the fast Gauss transform. */
+    size_t get_num_fgt_clusters() const { return m_fgt_centers.size() / m_dim; }
+
+    /** @brief  Order (number of Taylor terms per dimension) of the fast
+     *          Gauss transform. */
+    size_t get_fgt_order() const { return m_fgt_order; }
+
+private:
+    struct Node
+    {
+        size_t begin;
+        size_t end;
+        size_t left;    // 0 for a leaf (the root is never a child)
+        size_t right;
+    };
+
+    template <class VecIterator>
+    void init
+    (
+        VecIterator first,
+        VecIterator last,
+        const std::vector<double>& h
+    )
+    {
+        IFT(first != last, Illegal_argument, "Fast_kde: need at least one sample.");
+        IFT(m_epsilon > 0.0, Illegal_argument,
+            "Fast_kde: error bound must be positive.");
+
+        m_dim = h.size();
+        IFT(m_dim > 0, Illegal_argument, "Fast_kde: need at least one dimension.");
+
+        m_inv_h.resize(m_dim);
+        double prod_h = 1.0;
+        for(size_t j = 0; j < m_dim; j++)
+        {
+            IFT(h[j] > 0.0, Illegal_argument, "Fast_kde: bandwidths must be positive.");
+            m_inv_h[j] = 1.0 / h[j];
+            prod_h *= h[j];
+        }
+
+        m_points.clear();
+        for(; first != last; first++)
+        {
+            IFT(first->get_length() == static_cast<int>(m_dim), Illegal_argument,
+                "Fast_kde: samples and bandwidths must have same dimension.");
+            for(size_t j = 0; j < m_dim; j++)
+            {
+                m_points.push_back((*first)[j] * m_inv_h[j]);
+            }
+        }
+        m_num_samples = m_points.size() / m_dim;
+
+        finish_init(prod_h);
+    }
+
+    void finish_init(double prod_h);
+
+    size_t build_tree(std::vector<size_t>& perm, size_t begin, size_t end);
+
+    void setup_fgt();
+
+    Vector evaluate(const std::vector<double>& queries, size_t num_threads) const;
+
+    void evaluate_range
+    (
+        const std::vector<double>& queries,
+        size_t begin,
+        size_t end,
+        Vector& result
+    ) const;
+
+    double kernel_sum(const double* u) const;
+
+    double direct_sum(const double* u, size_t begin, size_t end) const;
+
+    double tree_sum(const double* u) const;
+
+    double fgt_sum(const double* u) const;
+
+    void node_bounds(const double* u, size_t n, double* k_min, double* k_max) const;
+
+    Kernel_type m_kernel;
+    Method m_method;
+    double m_epsilon;
+
+    size_t m_dim;
+    size_t m_num_samples;
+    std::vector<double> m_inv_h;
+    double m_normalizer;          // multiplies the sum of unit-peak kernels
+
+    // samples divided by the bandwidths, in tree order
+    std::vector<double> m_points;
+
+    std::vector<Node> m_nodes;
+    std::vector<double> m_lo;     // bounding box of each node
+    std::vector<double> m_hi;
+
+    // improved fast Gauss transform
+    size_t m_fgt_order;
+    size_t m_fgt_terms;
+    double m_fgt_cutoff_sq;
+    std::vector<double> m_fgt_centers;
+    std::vector<double> m_fgt_coeffs;
+};
+
+} //namespace kjb
+
+#endif /*DENSITY_FAST_KDE_H */
+
@@ -0,0 +1,116 @@
+/* =========================================================================== *
+   |
+   |  Copyright (c) 1994-2011 by Kobus Barnard (author)
+   |
+   |  Personal and educational use of this code is granted, provided that this
+   |  header is kept intact, and that the authorship is not misrepresented, that
+   |  its use is acknowledged in publications, and relevant papers are cited.
+   |
+   |  For other use contact the author (kobus AT cs DOT arizona DOT edu).
+   |
+   |  Please note that the code in this file has not necessarily been adequately
+   |  tested. Naturally, there is no guarantee of performance, support, or fitness
+   |  for any particular task. Nonetheless, I am interested in hearing about
+   |  problems that you encounter.
+   |
+ * =========================================================================== */
+
+/* $Id$ */
+
+#include <density_cpp/density_fast_kde.h>
+#include <density_cpp/density_kernel.h>
+#include <m_cpp/m_vector.h>
+#include <l/l_sys_rand.h>
+#include <l_cpp/l_test.h>
+#include <vector>
+#include <cmath>
+
+using namespace std;
+using namespace kjb;
+
+namespace {
+
+double gauss_kernel(double u)
+{
+    return exp(-0.5*u*u) / sqrt(2*M_PI);
+}
+
+double epan_kernel(double u)
+{
+    return fabs(u) < 1.0 ? 0.75*(1.0 - u*u) : 0.0;
+}
+
+// a mixture of two blobs, so that the tree has something to prune
+vector<Vector> make_points(size_t n, size_t D)
+{
+    vector<Vector> x(n, Vector((int)D));
+    for(size_t i = 0; i < n; i++)
+    {
+        double offset = i % 3 == 0 ? 4.0 : 0.0;
+        for(size_t j = 0; j < D; j++)
+        {
+            x[i][j] = offset + 2.0 * (kjb_c::kjb_rand() - 0.5)
+                             + 2.0 * (kjb_c::kjb_rand() - 0.5);
+        }
+    }
+    return x;
+}
+
+} // anonymous namespace
+
+int main(int argc, char** argv)
+{
+    const size_t N = 3000;
+    const double eps = 1e-3;
+
+    kjb_c::kjb_seed_rand_2(1234);
+
+    for(size_t D = 1; D <= 3; D++)
+    {
+        vector<Vector> x = make_points(N, D);
+        vector<Vector> y = make_points(200, D);
+        vector<double> h(D, 0.4);
+        h[0] = 0.3;
+        Vector hv(h.begin(), h.end());
+
+        Fast_kde tree(x.begin(), x.end(), hv, Fast_kde::GAUSSIAN_KERNEL,
+                      Fast_kde::KD_TREE, eps);
+        Fast_kde fgt(x.begin(), x.end(), hv, Fast_kde::GAUSSIAN_KERNEL,
+                     Fast_kde::FAST_GAUSS_TRANSFORM, eps);
+        Fast_kde epan(x.begin(), x.end(), hv, Fast_kde::EPANECHNIKOV_KERNEL,
+                      Fast_kde::KD_TREE, eps);
+
+        // in low dimensions the fast Gauss transform should be worthwhile
+        if(D == 1)
+        {
+            TEST_TRUE(fgt.method() == Fast_kde::FAST_GAUSS_TRANSFORM);
+        }
+
+        // the largest value of the estimate, for the absolute bound
+        double f_max = 1.0;
+        for(size_t j = 0; j < D; j++)
+        {
+            f_max *= gauss_kernel(0.0) / h[j];
+        }
+
+        Vector f_tree = tree(y.begin(), y.end(), 4);
+        Vector f_fgt = fgt(y.begin(), y.end(), 4);
+        Vector f_epan = epan(y.begin(), y.end(), 3);
+        for(size_t q = 0; q < y.size(); q++)
+        {
+            double f = fkde(y[q], x.begin(), x.end(), gauss_kernel, h.begin());
+            double g = fkde(y[q], x.begin(), x.end(), epan_kernel, h.begin());
+
+            TEST_TRUE(fabs(f_tree[q] - f) <= eps * f + 1e-15);
+            TEST_TRUE(fabs(f_fgt[q] - f) <= eps * f_max);
+            TEST_TRUE(fabs(f_epan[q] - g) <= eps * g + 1e-15);
+
+            // batched and single queries agree
+            TEST_TRUE(f_tree[q] == tree(y[q]));
+            TEST_TRUE(f_fgt[q] == fgt(y[q]));
+        }
+    }
+
+    RETURN_VICTORIOUSLY();
+}
+
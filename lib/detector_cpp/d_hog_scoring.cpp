@@ -0,0 +1,278 @@
+/* $Id$ */
+/* =========================================================================== *
+   |
+   |  Copyright (c) 1994-2010 by Kobus Barnard (author)
+   |
+   |  Personal and educational use of this code is granted, provided that this
+   |  header is kept intact, and that the authorship is not misrepresented, that
+   |  its use is acknowledged in publications, and relevant papers are cited.
+   |
+   |  For other use contact the author (kobus AT cs DOT arizona DOT edu).
+   |
+   |  Please note that the code in this file has not necessarily been adequately
+   |  tested. Naturally, there is no guarantee of performance, support, or fitness
+   |  for any particular task. Nonetheless, I am interested in hearing about
+   |  problems that you encounter.
+   |
+ * =========================================================================== */
+
+#include <detector_cpp/d_hog_scoring.h>
+#include <gr_cpp/gr_2D_bounding_box.h>
+#include <m_cpp/m_vector.h>
+#include <l_cpp/l_exception.h>
+
+#include <boost/thread.hpp>
+#include <boost/bind.hpp>
+#include <algorithm>
+#include <utility>
+
+using namespace kjb;
+
+namespace
+{
+
+/**
+ * Dot product of two float arrays, with independent partial sums so that it
+ * pipelines (and vectorizes) without reassociating a single sum.
+ */
+inline double dot_features(const float* a, const float* b, int n)
+{
+    float s0 = 0.0f;
+    float s1 = 0.0f;
+    float s2 = 0.0f;
+    float s3 = 0.0f;
+    int   i;
+
+    for (i = 0; i + 4 <= n; i += 4)
+    {
+        s0 += a[ i ] * b[ i ];
+        s1 += a[ i + 1 ] * b[ i + 1 ];
+        s2 += a[ i + 2 ] * b[ i + 2 ];
+        s3 += a[ i + 3 ] * b[ i + 3 ];
+    }
+    for (; i < n; i++)
+    {
+        s0 += a[ i ] * b[ i ];
+    }
+
+    return (double)s0 + s1 + s2 + s3;
+}
+
+/** Correlates one filter with one level. */
+void correlate_filter
+(
+    Matrix&            scores,
+    const Hog_pyramid& pyramid,
+    size_t             level,
+    const Hog_filter&  filter
+)
+{
+    const int    NF       = Hog_pyramid::NUM_FEATURES;
+    const int    cols     = pyramid.get_num_cols(level);
+    const int    f_rows   = filter.get_num_rows();
+    const int    f_span   = filter.get_num_cols() * NF;
+    const float* features = pyramid.get_features(level);
+    const float* weights  = &filter.get_weights()[ 0 ];
+
+    for (int r = 0; r < scores.get_num_rows(); r++)
+    {
+        for (int c = 0; c < scores.get_num_cols(); c++)
+        {
+            double sum = filter.get_bias();
+
+            // A filter row is a contiguous span of the level's features.
+            for (int fr = 0; fr < f_rows; fr++)
+            {
+                sum += dot_features(weights + fr * f_span,
+                                    features + ((r + fr) * cols + c) * NF,
+                                    f_span);
+            }
+
+            scores(r, c) = sum;
+        }
+    }
+}
+
+void correlate_jobs
+(
+    std::vector<std::vector<Matrix> >&         scores,
+    const Hog_pyramid&                         pyramid,
+    const std::vector<Hog_filter>&             filters,
+    const std::vector<std::pair<size_t, size_t> >& jobs,
+    size_t                                     first,
+    size_t                                     step
+)
+{
+    for (size_t j = first; j < jobs.size(); j += step)
+    {
+        const size_t l = jobs[j].first;
+        const size_t f = jobs[j].second;
+
+        correlate_filter(scores[l][f], pyramid, l, filters[f]);
+    }
+}
+
+bool higher_score(const Hog_detection& d1, const Hog_detection& d2)
+{
+    return d1.score > d2.score;
+}
+
+} // anonymous namespace
+
+/* \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ */
+
+Hog_filter::Hog_filter
+(
+    int num_rows,
+    int num_cols,
+    const std::vector<float>& weights,
+    double bias
+) :
+    m_num_rows(num_rows),
+    m_num_cols(num_cols),
+    m_weights(weights),
+    m_bias(bias)
+{
+    IFT(num_rows > 0 && num_cols > 0, Illegal_argument,
+        "HOG filter must have at least one cell.");
+
+    if(weights.size() != (size_t)num_rows * num_cols * Hog_pyramid::NUM_FEATURES)
+    {
+        KJB_THROW(Dimension_mismatch);
+    }
+}
+
+/* \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ */
+
+void kjb::score_hog_pyramid
+(
+    std::vector<std::vector<Matrix> >& scores,
+    const Hog_pyramid& pyramid,
+    const std::vector<Hog_filter>& filters,
+    size_t num_threads
+)
+{
+    std::vector<std::pair<size_t, size_t> > jobs;
+
+    // Allocate all score maps here; Matrix allocation is not thread safe.
+    scores.assign(pyramid.size(), std::vector<Matrix>(filters.size()));
+    for(size_t l = 0; l < pyramid.size(); l++)
+    {
+        for(size_t f = 0; f < filters.size(); f++)
+        {
+            int rows = pyramid.get_num_rows(l) - filters[f].get_num_rows() + 1;
+            int cols = pyramid.get_num_cols(l) - filters[f].get_num_cols() + 1;
+
+            if(rows > 0 && cols > 0)
+            {
+                scores[l][f] = Matrix(rows, cols);
+                jobs.push_back(std::make_pair(l, f));
+            }
+        }
+    }
+
+    size_t nt = num_threads;
+    if(nt == 0)
+    {
+        nt = boost::thread::hardware_concurrency();
+    }
+    if(nt > jobs.size())
+    {
+        nt = jobs.size();
+    }
+
+    if(nt <= 1)
+    {
+        correlate_jobs(scores, pyramid, filters, jobs, 0, 1);
+    }
+    else
+    {
+        // Jobs are interleaved, since the first levels are the largest.
+        boost::thread_group thrds;
+        for(size_t t = 0; t < nt; t++)
+        {
+            thrds.create_thread(boost::bind(
+                        correlate_jobs, boost::ref(scores), boost::cref(pyramid),
+                        boost::cref(filters), boost::cref(jobs), t, nt));
+        }
+        thrds.join_all();
+    }
+}
+
+/* \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ */
+
+void kjb::non_maximum_suppression
+(
+    std::vector<Hog_detection>& detections,
+    double overlap
+)
+{
+    std::stable_sort(detections.begin(), detections.end(), higher_score);
+
+    std::vector<Hog_detection> kept;
+    for(size_t i = 0; i < detections.size(); i++)
+    {
+        const Bbox& box = detections[i].box;
+        bool suppressed = false;
+
+        for(size_t j = 0; j < kept.size() && !suppressed; j++)
+        {
+            double inter = get_rectangle_intersection(box, kept[j].box);
+            double uni = box.get_area() + kept[j].box.get_area() - inter;
+
+            suppressed = uni > 0.0 && inter / uni > overlap;
+        }
+
+        if(!suppressed)
+        {
+            kept.push_back(detections[i]);
+        }
+    }
+
+    detections.swap(kept);
+}
+
+/* \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ */
+
+std::vector<Hog_detection> kjb::detect_with_hog_filters
+(
+    const Hog_pyramid& pyramid,
+    const std::vector<Hog_filter>& filters,
+    double threshold,
+    double overlap,
+    size_t num_threads
+)
+{
+    std::vector<std::vector<Matrix> > scores;
+    score_hog_pyramid(scores, pyramid, filters, num_threads);
+
+    std::vector<Hog_detection> detections;
+    for(size_t l = 0; l < scores.size(); l++)
+    {
+        const double cs = pyramid.get_cell_size(l);
+
+        for(size_t f = 0; f < filters.size(); f++)
+        {
+            const Matrix& sc = scores[l][f];
+            const double w = filters[f].get_num_cols() * cs;
+            const double h = filters[f].get_num_rows() * cs;
+
+            for(int r = 0; r < sc.get_num_rows(); r++)
+            {
+                for(int c = 0; c < sc.get_num_cols(); c++)
+                {
+                    if(sc(r, c) <= threshold) continue;
+
+                    Vector top_left((c + 1) * cs, (r + 1) * cs);
+                    Vector bottom_right(top_left[0] + w, top_left[1] + h);
+                    detections.push_back(Hog_detection(
+                            Bbox(top_left, bottom_right), sc(r, c), f, l));
+                }
+            }
+        }
+    }
+
+    non_maximum_suppression(detections, overlap);
+
+    return detections;
+}
@@ -0,0 +1,128 @@
+/* $Id$ */
+/* =========================================================================== *
+   |
+   |  Copyright (c) 1994-2010 by Kobus Barnard (author)
+   |
+   |  Personal and educational use of this code is granted, provided that this
+   |  header is kept intact, and that the authorship is not misrepresented, that
+   |  its use is acknowledged in publications, and relevant papers are cited.
+   |
+   |  For other use contact the author (kobus AT cs DOT arizona DOT edu).
+   |
+   |  Please note that the code in this file has not necessarily been adequately
+   |  tested. Naturally, there is no guarantee of performance, support, or fitness
+   |  for any particular task. Nonetheless, I am interested in hearing about
+   |  problems that you encounter.
+   |
+ * =========================================================================== */
+
+#ifndef D_HOG_SCORING_H
+#define D_HOG_SCORING_H
+
+#include <detector_cpp/d_bbox.h>
+#include <edge_cpp/hog_pyramid.h>
+#include <m_cpp/m_matrix.h>
+
+#include <vector>
+
+namespace kjb
+{
+
+/**
+ * @brief   Linear filter (root or part template) on HOG features.
+ *
+ * The weights have the layout of the pyramid features: cell by cell, row
+ * major, with Hog_pyramid::NUM_FEATURES weights per cell.
+ */
+class Hog_filter
+{
+public:
+    Hog_filter
+    (
+        int num_rows,
+        int num_cols,
+        const std::vector<float>& weights,
+        double bias = 0.0
+    );
+
+    /** @brief Number of rows of cells. */
+    int get_num_rows() const { return m_num_rows; }
+
+    /** @brief Number of columns of cells. */
+    int get_num_cols() const { return m_num_cols; }
+
+    const std::vector<float>& get_weights() const { return m_weights; }
+
+    double get_bias() const { return m_bias; }
+
+private:
+    int m_num_rows;
+    int m_num_cols;
+    std::vector<float> m_weights;
+    double m_bias;
+};
+
+/**
+ * @brief   Correlates filters with every level of a HOG pyramid.
+ *
+ * Element <tt>(r, c)</tt> of <tt>scores[l][f]</tt> is the bias of filter
+ * <tt>f</tt> plus the dot product of its weights with the features of level
+ * <tt>l</tt> whose top-left cell is <tt>(r, c)</tt>. Levels smaller than a
+ * filter give an empty matrix.
+ *
+ * @param   num_threads  Number of threads to use. If 0, use the number of
+ *                       hardware threads available.
+ */
+void score_hog_pyramid
+(
+    std::vector<std::vector<Matrix> >& scores,
+    const Hog_pyramid& pyramid,
+    const std::vector<Hog_filter>& filters,
+    size_t num_threads = 1
+);
+
+/**
+ * @brief   A window of a HOG pyramid scored by a filter.
+ */
+struct Hog_detection
+{
+    /** @brief Window, in image coordinates (x is the column). */
+    Bbox box;
+    double score;
+    size_t filter;
+    size_t level;
+
+    Hog_detection(const Bbox& b, double s, size_t f, size_t l) :
+        box(b), score(s), filter(f), level(l)
+    {}
+};
+
+/**
+ * @brief   Greedy non-maximum suppression.
+ *
+ * Keeps the best detection, removes those whose intersection over union
+ * with it exceeds overlap, and repeats. The remaining detections are sorted
+ * by decreasing score.
+ */
+void non_maximum_suppression
+(
+    std::vector<Hog_detection>& detections,
+    double overlap = 0.5
+);
+
+/**
+ * @brief   Scores the filters on a pyramid, and returns the windows scoring
+ *          above threshold, after non-maximum suppression.
+ */
+std::vector<Hog_detection> detect_with_hog_filters
+(
+    const Hog_pyramid& pyramid,
+    const std::vector<Hog_filter>& filters,
+    double threshold,
+    double overlap = 0.5,
+    size_t num_threads = 1
+);
+
+} // namespace kjb
+
+#endif /*D_HOG_SCORING_H */
@@ -0,0 +1,220 @@
+/* =========================================================================== *
+   |
+   |  Copyright (c) 1994-2011 by Kobus Barnard (author)
+   |
+   |  Personal and educational use of this code is granted, provided that this
+   |  header is kept intact, and that the authorship is not misrepresented, that
+   |  its use is acknowledged in publications, and relevant papers are cited.
+   |
+   |  For other use contact the author (kobus AT cs DOT arizona DOT edu).
+   |
+   |  Please note that the code in this file has not necessarily been adequately
+   |  tested. Naturally, there is no guarantee of performance, support, or fitness
+   |  for any particular task. Nonetheless, I am interested in hearing about
+   |  problems that you encounter.
+   |
+ * =========================================================================== */
+
+/* $Id$ */
+
+#include <detector_cpp/d_hog_scoring.h>
+#include <edge_cpp/hog_pyramid.h>
+#include <edge_cpp/hog.h>
+#include <i_cpp/i_image.h>
+#include <m_cpp/m_vector.h>
+#include <gr_cpp/gr_2D_bounding_box.h>
+#include <l_cpp/l_test.h>
+#include <iostream>
+#include <vector>
+#include <cmath>
+
+using namespace kjb;
+using namespace std;
+
+const int BIN_SIZE = 8;
+const int INTERVAL = 5;
+
+/* A textured background with a bright square, so that all features vary. */
+Image make_test_image()
+{
+    Image img = Image::create_zero_image(180, 220);
+    for(int r = 0; r < img.get_num_rows(); r++)
+    {
+        for(int c = 0; c < img.get_num_cols(); c++)
+        {
+            img(r, c, 0) = 100 + 40 * sin(0.11 * r) * cos(0.07 * c);
+            img(r, c, 1) = 80 + 30 * sin(0.05 * (r + c));
+            img(r, c, 2) = 60 + 20 * cos(0.13 * c);
+            if(r >= 60 && r < 120 && c >= 90 && c < 150)
+            {
+                img(r, c, 0) = img(r, c, 1) = img(r, c, 2) = 250;
+            }
+        }
+    }
+
+    return img;
+}
+
+bool same_pyramids(const Hog_pyramid& p1, const Hog_pyramid& p2)
+{
+    if(p1.size() != p2.size()) return false;
+
+    for(size_t l = 0; l < p1.size(); l++)
+    {
+        if(p1.get_num_rows(l) != p2.get_num_rows(l)
+            || p1.get_num_cols(l) != p2.get_num_cols(l)
+            || p1.get_cell_size(l) != p2.get_cell_size(l))
+        {
+            return false;
+        }
+
+        int n = p1.get_num_rows(l) * p1.get_num_cols(l) * 32;
+        for(int i = 0; i < n; i++)
+        {
+            if(p1.get_features(l)[i] != p2.get_features(l)[i]) return false;
+        }
+    }
+
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    Image img = make_test_image();
+
+    // pyramid
+    Hog_pyramid pyramid(img, BIN_SIZE, INTERVAL, 1);
+    TEST_TRUE(pyramid.size() > (size_t)2 * INTERVAL);
+    for(size_t l = 1; l < pyramid.size(); l++)
+    {
+        TEST_TRUE(pyramid.get_cell_size(l) > pyramid.get_cell_size(l - 1));
+    }
+
+    Hog_pyramid pyramid_mt(img, BIN_SIZE, INTERVAL, 3);
+    TEST_TRUE(same_pyramids(pyramid, pyramid_mt));
+
+    // the first root level is the single-scale HOG of the image
+    Hog_responses hog(img, BIN_SIZE);
+    TEST_TRUE(pyramid.get_cell_size(INTERVAL) == BIN_SIZE);
+    TEST_TRUE(pyramid.get_num_rows(INTERVAL) == hog.get_hog_num_rows());
+    TEST_TRUE(pyramid.get_num_cols(INTERVAL) == hog.get_hog_num_cols());
+    for(int i = 0; i < hog.get_hog_size(); i++)
+    {
+        TEST_TRUE(fabs(pyramid.get_features(INTERVAL)[i]
+                            - hog.get_hog_responses()[i]) < 1e-4);
+    }
+
+    // a filter cut out of a level
+    const size_t level = INTERVAL;
+    const int f_rows = 5;
+    const int f_cols = 6;
+    const int row0 = 5;
+    const int col0 = 9;
+    vector<float> weights;
+    for(int r = 0; r < f_rows; r++)
+    {
+        const float* f = pyramid.get_features(level, row0 + r, col0);
+        weights.insert(weights.end(), f, f + f_cols * 32);
+    }
+
+    vector<Hog_filter> filters;
+    filters.push_back(Hog_filter(f_rows, f_cols, weights, -1.0));
+    filters.push_back(Hog_filter(2, 2, vector<float>(2 * 2 * 32, 0.5f)));
+
+    vector<vector<Matrix> > scores;
+    vector<vector<Matrix> > scores_mt;
+    score_hog_pyramid(scores, pyramid, filters, 1);
+    score_hog_pyramid(scores_mt, pyramid, filters, 4);
+    TEST_TRUE(scores.size() == pyramid.size());
+    for(size_t l = 0; l < scores.size(); l++)
+    {
+        for(size_t f = 0; f < filters.size(); f++)
+        {
+            TEST_TRUE(scores[l][f].get_num_rows()
+                        == scores_mt[l][f].get_num_rows());
+            TEST_TRUE(scores[l][f].get_num_cols()
+                        == scores_mt[l][f].get_num_cols());
+            TEST_TRUE(max_abs_difference(scores[l][f], scores_mt[l][f]) == 0.0);
+        }
+    }
+
+    // direct computation of one score
+    double expected = -1.0;
+    for(int r = 0; r < f_rows; r++)
+    {
+        for(int k = 0; k < f_cols * 32; k++)
+        {
+            double w = weights[r * f_cols * 32 + k];
+            expected += w * pyramid.get_features(level, r + row0 + 1, col0)[k];
+        }
+    }
+    TEST_TRUE(fabs(scores[level][0](row0 + 1, col0) - expected) < 1e-4);
+
+    // detections: without suppression, every window above threshold,
+    // including the one the filter was cut out of
+    const double self_score = scores[level][0](row0, col0);
+    vector<Hog_filter> root(1, filters[0]);
+    vector<Hog_detection> dets = detect_with_hog_filters(pyramid, root,
+                                                         self_score - 1e-3,
+                                                         1.0, 2);
+    size_t num_above = 0;
+    for(size_t l = 0; l < scores.size(); l++)
+    {
+        const Matrix& sc = scores[l][0];
+        for(int r = 0; r < sc.get_num_rows(); r++)
+        {
+            for(int c = 0; c < sc.get_num_cols(); c++)
+            {
+                if(sc(r, c) > self_score - 1e-3) num_above++;
+            }
+        }
+    }
+    TEST_TRUE(dets.size() == num_above);
+
+    bool found = false;
+    for(size_t i = 0; i < dets.size(); i++)
+    {
+        if(dets[i].level == level && dets[i].score == self_score)
+        {
+            TEST_TRUE(fabs(dets[i].box.get_left() - (col0 + 1) * BIN_SIZE)
+                        < 1e-9);
+            TEST_TRUE(fabs(dets[i].box.get_width() - f_cols * BIN_SIZE)
+                        < 1e-9);
+            TEST_TRUE(fabs(dets[i].box.get_height() - f_rows * BIN_SIZE)
+                        < 1e-9);
+            found = true;
+        }
+        if(i > 0) TEST_TRUE(dets[i].score <= dets[i - 1].score);
+    }
+    TEST_TRUE(found);
+
+    // with suppression, the remaining windows do not overlap much
+    dets = detect_with_hog_filters(pyramid, root, 0.0, 0.3, 2);
+    TEST_TRUE(!dets.empty());
+    for(size_t i = 0; i < dets.size(); i++)
+    {
+        for(size_t j = 0; j < i; j++)
+        {
+            double inter = get_rectangle_intersection(dets[i].box,
+                                                      dets[j].box);
+            double uni = dets[i].box.get_area() + dets[j].box.get_area()
+                            - inter;
+            TEST_TRUE(inter / uni <= 0.3);
+        }
+    }
+
+    // non-maximum suppression
+    vector<Hog_detection> boxes;
+    boxes.push_back(Hog_detection(Bbox(Vector(0.0, 0.0), Vector(10.0, 10.0)),
+                                  1.0, 0, 0));
+    boxes.push_back(Hog_detection(Bbox(Vector(1.0, 0.0), Vector(11.0, 10.0)),
+                                  2.0, 0, 0));
+    boxes.push_back(Hog_detection(Bbox(Vector(20.0, 0.0), Vector(30.0, 10.0)),
+                                  0.5, 0, 0));
+    non_maximum_suppression(boxes, 0.5);
+    TEST_TRUE(boxes.size() == 2);
+    TEST_TRUE(boxes[0].score == 2.0);
+    TEST_TRUE(boxes[1].score == 0.5);
+
+    RETURN_VICTORIOUSLY();
+}
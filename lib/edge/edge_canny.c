@@ -0,0 +1,1537 @@
+/* $Id$ */
+
+/* =========================================================================== *
+   |
+   |  Copyright (c) 1994-2010 by Kobus Barnard (author)
+   |
+   |  Personal and educational use of this code is granted, provided that this
+   |  header is kept intact, and that the authorship is not misrepresented, that
+   |  its use is acknowledged in publications, and relevant papers are cited.
+   |
+   |  For other use contact the author (kobus AT cs DOT arizona DOT edu).
+   |
+   |  Please note that the code in this file has not necessarily been adequately
+   |  tested. Naturally, there is no guarantee of performance, support, or fitness
+   |  for any particular task. Nonetheless, I am interested in hearing about
+   |  problems that you encounter.
+   |
+ * =========================================================================== */
+
+/*
+ * Tiled, multithreaded Canny edge detection.
+ *
+ * The image is split into horizontal bands of rows, one per thread. Each band
+ * is convolved with separable Gaussian derivative masks (the same masks as
+ * detect_matrix_edge_set() uses without the Fourier transform), and the
+ * gradient maxima along the gradient direction are kept (non-maximal
+ * suppression). Maxima above the low threshold are joined into connected
+ * components with union-find, first within each band (in parallel), then
+ * across the seams between bands. Components that contain a maximum above the
+ * high threshold are kept (hysteresis). Finally, the pixels of each kept
+ * component are traced into chains of edge points, with components split over
+ * threads, and the chains are copied into a single buffer of edge points.
+ *
+ * The result does not depend on the number of threads. All buffers live in a
+ * Canny_workspace, which can be kept between frames.
+*/
+
+#include "l/l_incl.h"
+#include "i/i_matrix.h"
+#include "m/m_mat_basic.h"
+#include "l_mt/l_mt_pthread.h"
+#include "edge/edge_canny.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* -------------------------------------------------------------------------- */
+
+/* Bits of the per pixel state. */
+#define CANNY_WEAK           1   /* Maximum above the low threshold.         */
+#define CANNY_STRONG         2   /* Maximum above the high threshold.        */
+#define CANNY_STRONG_ROOT    4   /* Root of a component with a strong pixel. */
+#define CANNY_VISITED        8   /* Already put in a chain.                  */
+
+#define CANNY_CANDIDATE      (CANNY_WEAK | CANNY_STRONG)
+
+/* tan(22.5 degrees), for binning gradient directions. */
+#define TAN_PI_8             0.41421356f
+
+/* Steps that turn back more than this (cosine) end a chain. */
+#define MIN_CHAIN_STEP_COS   (-0.25f)
+
+/* -------------------------------------------------------------------------- */
+
+struct Canny_workspace
+{
+    /* Per pixel buffers, all of size num_pixels. */
+    size_t       num_pixels;
+    float*       image;
+    float*       smooth;
+    float*       deriv;
+    float*       dcol;
+    float*       drow;
+    float*       mag;
+    uint8_t*     state;
+    int32_t*     parent;
+    int32_t*     label;
+
+    /* Per component buffers. */
+    size_t       num_components;
+    int32_t*     component_start;
+    int32_t*     component_num_chains;
+
+    size_t       num_component_pixels;
+    int32_t*     component_pixels;
+
+    /* Per thread buffers. */
+    int          num_threads;
+    float**      row_buffers;
+    size_t*      row_buffer_sizes;
+    Edge_point** points;
+    uint32_t**   chain_lengths;
+    size_t*      chain_capacities;
+};
+
+typedef struct Canny_context
+{
+    Canny_workspace* ws;
+    const Matrix*    m;
+    int              num_rows;
+    int              num_cols;
+    int              padding;
+    const float*     gauss;
+    const float*     dgauss;
+    int              mask_size;
+    float            begin_thresh;
+    float            end_thresh;
+    int              noiseless_data;
+    int              num_components;
+}
+Canny_context;
+
+typedef void (*Canny_thread_fn)
+(
+    const Canny_context* context,
+    int                  thread,
+    int                  num_threads
+);
+
+typedef struct Canny_job
+{
+    Canny_thread_fn      fn;
+    const Canny_context* context;
+    int                  thread;
+    int                  num_threads;
+}
+Canny_job;
+
+/* -------------------------------------------------------------------------- */
+
+static void run_canny_threads
+(
+    Canny_thread_fn      fn,
+    const Canny_context* context,
+    int                  num_threads
+);
+
+static void* canny_job_main(void* arg);
+
+static int  reflect_index(int i, int n);
+
+static int  get_band_begin(int num_rows, int thread, int num_threads);
+
+static void free_pixel_buffers(Canny_workspace* ws);
+
+static int  ensure_pixel_capacity(Canny_workspace* ws, size_t num_pixels);
+
+static int  ensure_component_capacity(Canny_workspace* ws, size_t n);
+
+static int  ensure_thread_capacity
+(
+    Canny_workspace* ws,
+    int              num_threads,
+    size_t           row_buffer_size
+);
+
+static int  get_gaussian_masks(float** gauss_ptr, float** dgauss_ptr, float sigma, int* size_ptr);
+
+static void convolve_rows
+(
+    const Canny_context* c,
+    int                  thread,
+    int                  num_threads
+);
+
+static void convolve_columns
+(
+    const Canny_context* c,
+    int                  thread,
+    int                  num_threads
+);
+
+static void suppress_and_join
+(
+    const Canny_context* c,
+    int                  thread,
+    int                  num_threads
+);
+
+static void trace_components
+(
+    const Canny_context* c,
+    int                  thread,
+    int                  num_threads
+);
+
+static int32_t find_root(int32_t* parent, int32_t i);
+
+static void join(int32_t* parent, int32_t i, int32_t j);
+
+static int  label_components(Canny_context* c, int num_threads);
+
+static size_t follow_chain
+(
+    const Canny_context* c,
+    int32_t              i,
+    float                dir_x,
+    float                dir_y,
+    int32_t              component,
+    Edge_point*          points
+);
+
+static void set_edge_point(const Canny_context* c, int32_t i, Edge_point* pt);
+
+static int  collect_edge_set
+(
+    Edge_set**           edges_out,
+    const Canny_context* c,
+    int                  num_threads
+);
+
+/* -------------------------------------------------------------------------- */
+
+/* =============================================================================
+ *                          create_canny_workspace
+ *
+ * Creates an empty workspace for the tiled edge detector
+ *
+ * The workspace is filled in (and grown as needed) by
+ * detect_matrix_edge_set_tiled(). It should be freed with
+ * free_canny_workspace().
+ *
+ * Returns:
+ *    A new workspace, or NULL if allocation fails.
+ *
+ * Index: edge detection
+ *
+ * -----------------------------------------------------------------------------
+*/
+
+Canny_workspace* create_canny_workspace(void)
+{
+    Canny_workspace* ws;
+
+
+    NRN(ws = TYPE_MALLOC(Canny_workspace));
+
+    ws->num_pixels = 0;
+    ws->image = NULL;
+    ws->smooth = NULL;
+    ws->deriv = NULL;
+    ws->dcol = NULL;
+    ws->drow = NULL;
+    ws->mag = NULL;
+    ws->state = NULL;
+    ws->parent = NULL;
+    ws->label = NULL;
+
+    ws->num_components = 0;
+    ws->component_start = NULL;
+    ws->component_num_chains = NULL;
+
+    ws->num_component_pixels = 0;
+    ws->component_pixels = NULL;
+
+    ws->num_threads = 0;
+    ws->row_buffers = NULL;
+    ws->row_buffer_sizes = NULL;
+    ws->points = NULL;
+    ws->chain_lengths = NULL;
+    ws->chain_capacities = NULL;
+
+    return ws;
+}
+
+/*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\   */
+
+/* =============================================================================
+ *                          free_canny_workspace
+ *
+ * Frees a workspace of the tiled edge detector
+ *
+ * Index: edge detection
+ *
+ * -----------------------------------------------------------------------------
+*/
+
+void free_canny_workspace(Canny_workspace* ws)
+{
+    int t;
+
+
+    if (ws == NULL) return;
+
+    free_pixel_buffers(ws);
+
+    kjb_free(ws->component_start);
+    kjb_free(ws->component_num_chains);
+    kjb_free(ws->component_pixels);
+
+    for (t = 0; t < ws->num_threads; t++)
+    {
+        kjb_free(ws->row_buffers[ t ]);
+        kjb_free(ws->points[ t ]);
+        kjb_free(ws->chain_lengths[ t ]);
+    }
+
+    kjb_free(ws->row_buffers);
+    kjb_free(ws->row_buffer_sizes);
+    kjb_free(ws->points);
+    kjb_free(ws->chain_lengths);
+    kjb_free(ws->chain_capacities);
+
+    kjb_free(ws);
+}
+
+/*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\   */
+
+/* =============================================================================
+ *                          detect_image_edge_set_tiled
+ *
+ * Detects a set of edges in an image, with a tiled version of Canny
+ *
+ * This routine converts the image to gray levels the same way
+ * detect_image_edge_set() does, and then calls
+ * detect_matrix_edge_set_tiled(), which see.
+ *
+ * Returns:
+ *    NO_ERROR on success, and ERROR on failure, with an error message being
+ *    set.
+ *
+ * Index: edge detection
+ *
+ * -----------------------------------------------------------------------------
+*/
+
+int detect_image_edge_set_tiled
+(
+    Edge_set**       edges_out,
+    Canny_workspace* workspace,
+    const KJB_image* img,
+    float            sigma,
+    float            begin_thresh,
+    float            end_thresh,
+    uint32_t         padding,
+    unsigned char    noiseless_data,
+    int              num_threads
+)
+{
+    Matrix* m = NULL;
+    int     result;
+
+
+    ERE(image_to_matrix_2(img, 0.3, 0.59, 0.11, &m));
+
+    result = detect_matrix_edge_set_tiled(edges_out, workspace, m, sigma,
+                                          begin_thresh, end_thresh, padding,
+                                          noiseless_data, num_threads);
+    free_matrix(m);
+
+    return result;
+}
+
+/*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\   */
+
+/* =============================================================================
+ *                          detect_matrix_edge_set_tiled
+ *
+ * Detects a set of edges in a matrix, with a tiled version of Canny
+ *
+ * This routine finds edges with smoothed partial derivative masks, non-maximal
+ * suppression, and hysteresis, like detect_matrix_edge_set(), but splits the
+ * work over num_threads threads. The matrix is padded (by extending it) and
+ * convolved with separable versions of the masks used by
+ * detect_matrix_edge_set(). Gradient maxima (along the gradient) with
+ * magnitude at least end_thresh that are connected (8-neighbors) form
+ * components, and components with at least one maximum with magnitude at
+ * least begin_thresh are traced into edges. The result does not depend on the
+ * number of threads.
+ *
+ * Unlike detect_matrix_edge_set(), which follows edges from each strong pixel
+ * in scan order, this routine finds the edge pixels first and links them
+ * afterwards, so the two routines do not give exactly the same edges. Edge
+ * points from this routine always have a non-zero gradient.
+ *
+ * If workspace is not NULL, its buffers are used (and grown as needed), so
+ * that detecting edges in a sequence of images of the same size does not
+ * allocate memory for anything but the result. If it is NULL, a temporary
+ * workspace is used.
+ *
+ * If *edges_out is not NULL, the edge set it points to is freed and replaced.
+ *
+ * Returns:
+ *    NO_ERROR on success, and ERROR on failure, with an error message being
+ *    set.
+ *
+ * Index: edge detection
+ *
+ * -----------------------------------------------------------------------------
+*/
+
+int detect_matrix_edge_set_tiled
+(
+    Edge_set**       edges_out,
+    Canny_workspace* workspace,
+    const Matrix*    m,
+    float            sigma,
+    float            begin_thresh,
+    float            end_thresh,
+    uint32_t         padding,
+    unsigned char    noiseless_data,
+    int              num_threads
+)
+{
+    Canny_workspace* ws = workspace;
+    Canny_context    context;
+    float*           gauss = NULL;
+    float*           dgauss = NULL;
+    int              mask_size;
+    int              result = NO_ERROR;
+    int              row, col;
+
+
+    if ((edges_out == NULL) || (m == NULL) || (m->num_rows < 1) || (m->num_cols < 1))
+    {
+        SET_ARGUMENT_BUG();
+        return ERROR;
+    }
+
+    if (sigma <= 0.0f)
+    {
+        set_error("Edge detection sigma (%.3f) must be positive.", sigma);
+        return ERROR;
+    }
+
+    if (num_threads < 1) num_threads = 1;
+
+    if (ws == NULL)
+    {
+        NRE(ws = create_canny_workspace());
+    }
+
+    context.ws = ws;
+    context.m = m;
+    context.padding = padding;
+    context.num_rows = m->num_rows + 2 * padding;
+    context.num_cols = m->num_cols + 2 * padding;
+    context.begin_thresh = begin_thresh;
+    context.end_thresh = end_thresh;
+    context.noiseless_data = noiseless_data;
+    context.num_components = 0;
+
+    num_threads = MIN_OF(num_threads, context.num_rows);
+
+    result = get_gaussian_masks(&gauss, &dgauss, sigma, &mask_size);
+
+    if (result != ERROR)
+    {
+        context.gauss = gauss;
+        context.dgauss = dgauss;
+        context.mask_size = mask_size;
+
+        result = ensure_pixel_capacity(ws,
+                      (size_t)context.num_rows * context.num_cols);
+    }
+
+    if (result != ERROR)
+    {
+        result = ensure_thread_capacity(ws, num_threads,
+                                        context.num_cols + mask_size);
+    }
+
+    if (result != ERROR)
+    {
+        /* Pad by extending the border pixels. */
+        for (row = 0; row < context.num_rows; row++)
+        {
+            const double* m_row = m->elements[ MIN_OF(MAX_OF(row - (int)padding, 0),
+                                                      m->num_rows - 1) ];
+            float*        dest  = ws->image + (size_t)row * context.num_cols;
+
+            for (col = 0; col < context.num_cols; col++)
+            {
+                dest[ col ] = m_row[ MIN_OF(MAX_OF(col - (int)padding, 0),
+                                            m->num_cols - 1) ];
+            }
+        }
+
+        run_canny_threads(convolve_rows, &context, num_threads);
+        run_canny_threads(convolve_columns, &context, num_threads);
+        run_canny_threads(suppress_and_join, &context, num_threads);
+
+        result = label_components(&context, num_threads);
+    }
+
+    if (result != ERROR)
+    {
+        run_canny_threads(trace_components, &context, num_threads);
+
+        result = collect_edge_set(edges_out, &context, num_threads);
+    }
+
+    kjb_free(dgauss);
+    kjb_free(gauss);
+
+    if (ws != workspace)
+    {
+        free_canny_workspace(ws);
+    }
+
+    return result;
+}
+
+/*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\   */
+
+/*
+ * Runs fn in num_threads threads, with thread 0 being the calling thread. If a
+ * thread cannot be started, its part is done in the calling thread.
+*/
+static void run_canny_threads
+(
+    Canny_thread_fn      fn,
+    const Canny_context* context,
+    int                  num_threads
+)
+{
+    Canny_job*     jobs;
+    kjb_pthread_t* threads;
+    int*           started;
+    int            t;
+
+
+    if (num_threads <= 1)
+    {
+        fn(context, 0, 1);
+        return;
+    }
+
+    jobs = N_TYPE_MALLOC(Canny_job, num_threads);
+    threads = N_TYPE_MALLOC(kjb_pthread_t, num_threads);
+    started = INT_MALLOC(num_threads);
+
+    if ((jobs == NULL) || (threads == NULL) || (started == NULL))
+    {
+        kjb_free(started);
+        kjb_free(threads);
+        kjb_free(jobs);
+
+        for (t = 0; t < num_threads; t++)
+        {
+            fn(context, t, num_threads);
+        }
+        return;
+    }
+
+    for (t = 0; t < num_threads; t++)
+    {
+        jobs[ t ].fn = fn;
+        jobs[ t ].context = context;
+        jobs[ t ].thread = t;
+        jobs[ t ].num_threads = num_threads;
+    }
+
+    for (t = 1; t < num_threads; t++)
+    {
+        started[ t ] = kjb_pthread_create(&threads[ t ], NULL,
+                                          canny_job_main, &jobs[ t ]) != ERROR;
+    }
+
+    canny_job_main(&jobs[ 0 ]);
+
+    for (t = 1; t < num_threads; t++)
+    {
+        if (started[ t ])
+        {
+            kjb_pthread_join(threads[ t ], NULL);
+        }
+        else
+        {
+            canny_job_main(&jobs[ t ]);
+        }
+    }
+
+    kjb_free(started);
+    kjb_free(threads);
+    kjb_free(jobs);
+}
+
+/*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\   */
+
+static void* canny_job_main(void* arg)
+{
+    const Canny_job* job = (const Canny_job*)arg;
+
+    job->fn(job->context, job->thread, job->num_threads);
+
+    return NULL;
+}
+
+/*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\   */
+
+/* Same boundary handling as convolve_matrix(): the matrix reflects itself. */
+static int reflect_index(int i, int n)
+{
+    if (i < 0)
+    {
+        i = -i - 1;
+    }
+
+    if (i >= n)
+    {
+        i %= 2 * n;
+        if (i >= n) i = 2 * n - i - 1;
+    }
+
+    return i;
+}
+
+/*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\   */
+
+static int get_band_begin(int num_rows, int thread, int num_threads)
+{
+    return (int)(((long)num_rows * thread) / num_threads);
+}
+
+/*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\   */
+
+static void free_pixel_buffers(Canny_workspace* ws)
+{
+    kjb_free(ws->image);
+    kjb_free(ws->smooth);
+    kjb_free(ws->deriv);
+    kjb_free(ws->dcol);
+    kjb_free(ws->drow);
+    kjb_free(ws->mag);
+    kjb_free(ws->state);
+    kjb_free(ws->parent);
+    kjb_free(ws->label);
+
+    ws->image = NULL;
+    ws->smooth = NULL;
+    ws->deriv = NULL;
+    ws->dcol = NULL;
+    ws->drow = NULL;
+    ws->mag = NULL;
+    ws->state = NULL;
+    ws->parent = NULL;
+    ws->label = NULL;
+    ws->num_pixels = 0;
+}
+
+/*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\   */
+
+static int ensure_pixel_capacity(Canny_workspace* ws, size_t num_pixels)
+{
+    if (num_pixels <= ws->num_pixels) return NO_ERROR;
+
+    free_pixel_buffers(ws);
+
+    ws->num_pixels = num_pixels;
+    ws->image = N_TYPE_MALLOC(float, num_pixels);
+    ws->smooth = N_TYPE_MALLOC(float, num_pixels);
+    ws->deriv = N_TYPE_MALLOC(float, num_pixels);
+    ws->dcol = N_TYPE_MALLOC(float, num_pixels);
+    ws->drow = N_TYPE_MALLOC(float, num_pixels);
+    ws->mag = N_TYPE_MALLOC(float, num_pixels);
+    ws->state = N_TYPE_MALLOC(uint8_t, num_pixels);
+    ws->parent = N_TYPE_MALLOC(int32_t, num_pixels);
+    ws->label = N_TYPE_MALLOC(int32_t, num_pixels);
+
+    if (    (ws->image == NULL) || (ws->smooth == NULL) || (ws->deriv == NULL)
+         || (ws->dcol == NULL) || (ws->drow == NULL) || (ws->mag == NULL)
+         || (ws->state == NULL) || (ws->parent == NULL) || (ws->label == NULL)
+       )
+    {
+        free_pixel_buffers(ws);
+        return ERROR;
+    }
+
+    return NO_ERROR;
+}
+
+/*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\   */
+
+/* Grows the component buffers to hold at least n components. */
+static int ensure_component_capacity(Canny_workspace* ws, size_t n)
+{
+    size_t   capacity;
+    int32_t* start;
+    int32_t* num_chains;
+
+
+    if (n <= ws->num_components) return NO_ERROR;
+
+    capacity = MAX_OF(2 * ws->num_components, MAX_OF(n, 256));
+
+    NRE(start = N_TYPE_REALLOC(ws->component_start, int32_t, capacity + 1));
+    ws->component_start = start;
+
+    NRE(num_chains = N_TYPE_REALLOC(ws->component_num_chains, int32_t, capacity));
+    ws->component_num_chains = num_chains;
+
+    ws->num_components = capacity;
+
+    return NO_ERROR;
+}
+
+/*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\   */
+
+static int ensure_thread_capacity
+(
+    Canny_workspace* ws,
+    int              num_threads,
+    size_t           row_buffer_size
+)
+{
+    int t;
+
+
+    if (num_threads > ws->num_threads)
+    {
+        float**      row_buffers;
+        size_t*      row_buffer_sizes;
+        Edge_point** points;
+        uint32_t**   chain_lengths;
+        size_t*      chain_capacities;
+
+        NRE(row_buffers = N_TYPE_REALLOC(ws->row_buffers, float*, num_threads));
+        ws->row_buffers = row_buffers;
+        NRE(row_buffer_sizes = N_TYPE_REALLOC(ws->row_buffer_sizes, size_t,
+                                              num_threads));
+        ws->row_buffer_sizes = row_buffer_sizes;
+        NRE(points = N_TYPE_REALLOC(ws->points, Edge_point*, num_threads));
+        ws->points = points;
+        NRE(chain_lengths = N_TYPE_REALLOC(ws->chain_lengths, uint32_t*,
+                                           num_threads));
+        ws->chain_lengths = chain_lengths;
+        NRE(chain_capacities = N_TYPE_REALLOC(ws->chain_capacities, size_t,
+                                              num_threads));
+        ws->chain_capacities = chain_capacities;
+
+        for (t = ws->num_threads; t < num_threads; t++)
+        {
+            ws->row_buffers[ t ] = NULL;
+            ws->row_buffer_sizes[ t ] = 0;
+            ws->points[ t ] = NULL;
+            ws->chain_lengths[ t ] = NULL;
+            ws->chain_capacities[ t ] = 0;
+        }
+
+        ws->num_threads = num_threads;
+    }
+
+    for (t = 0; t < num_threads; t++)
+    {
+        if (ws->row_buffer_sizes[ t ] < row_buffer_size)
+        {
+            kjb_free(ws->row_buffers[ t ]);
+            ws->row_buffer_sizes[ t ] = 0;
+            NRE(ws->row_buffers[ t ] = N_TYPE_MALLOC(float, row_buffer_size));
+            ws->row_buffer_sizes[ t ] = row_buffer_size;
+        }
+    }
+
+    return NO_ERROR;
+}
+
+/*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\   */
+
+/*
+ * One dimensional factors of the masks made by get_2D_gaussian_dx_mask() and
+ * get_2D_gaussian_dy_mask(), with the same size as detect_matrix_edge_set()
+ * uses. The 2D dx mask is the outer product of gauss (along rows) and dgauss
+ * (along columns), and the dy mask is the transpose.
+*/
+static int get_gaussian_masks
+(
+    float** gauss_ptr,
+    float** dgauss_ptr,
+    float   sigma,
+    int*    size_ptr
+)
+{
+    int    size;
+    int    center;
+    int    i;
+    double gauss_sum = 0.0;
+    double dgauss_sum = 0.0;
+
+
+    size = (int)ceil(sqrt(2.0) * 6.0 * sigma);
+    size += 1 - size % 2;
+    center = size / 2;
+
+    NRE(*gauss_ptr = N_TYPE_MALLOC(float, size));
+
+    if ((*dgauss_ptr = N_TYPE_MALLOC(float, size)) == NULL)
+    {
+        kjb_free(*gauss_ptr);
+        *gauss_ptr = NULL;
+        return ERROR;
+    }
+
+    for (i = 0; i < size; i++)
+    {
+        double d = i - center;
+        double g = exp(-0.5 * d * d / ((double)sigma * sigma));
+
+        gauss_sum += g;
+        dgauss_sum += (size - i) * d * g;
+    }
+
+    for (i = 0; i < size; i++)
+    {
+        double d = i - center;
+        double g = exp(-0.5 * d * d / ((double)sigma * sigma));
+
+        (*gauss_ptr)[ i ] = (float)(g / gauss_sum);
+        (*dgauss_ptr)[ i ] = (float)(d * g / dgauss_sum);
+    }
+
+    *size_ptr = size;
+
+    return NO_ERROR;
+}
+
+/*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\   */
+
+/*
+ * Convolves the rows of a band with the smoothing and derivative masks. Each
+ * row is first copied, with reflected borders, into a buffer, so that the
+ * inner loops run over contiguous memory.
+*/
+static void convolve_rows
+(
+    const Canny_context* c,
+    int                  thread,
+    int                  num_threads
+)
+{
+    const Canny_workspace* ws = c->ws;
+    const int num_cols  = c->num_cols;
+    const int half      = c->mask_size / 2;
+    const int row_begin = get_band_begin(c->num_rows, thread, num_threads);
+    const int row_end   = get_band_begin(c->num_rows, thread + 1, num_threads);
+    float*    ext       = ws->row_buffers[ thread ];
+    int       row, col, k;
+
+
+    for (row = row_begin; row < row_end; row++)
+    {
+        const float* src    = ws->image + (size_t)row * num_cols;
+        float*       smooth = ws->smooth + (size_t)row * num_cols;
+        float*       deriv  = ws->deriv + (size_t)row * num_cols;
+
+        for (col = -half; col < num_cols + half; col++)
+        {
+            ext[ col + half ] = src[ reflect_index(col, num_cols) ];
+        }
+
+        for (col = 0; col < num_cols; col++)
+        {
+            smooth[ col ] = 0.0f;
+            deriv[ col ] = 0.0f;
+        }
+
+        /* out(col) = sum_k mask(k) * in(col + half - k) */
+        for (k = 0; k < c->mask_size; k++)
+        {
+            const float* in = ext + 2 * half - k;
+            const float  g  = c->gauss[ k ];
+            const float  d  = c->dgauss[ k ];
+
+            for (col = 0; col < num_cols; col++)
+            {
+                smooth[ col ] += g * in[ col ];
+                deriv[ col ] += d * in[ col ];
+            }
+        }
+    }
+}
+
+/*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\   */
+
+/*
+ * Convolves the columns of a band, giving the gradient. This reads rows of
+ * the neighboring bands, so it must follow convolve_rows() for all bands.
+*/
+static void convolve_columns
+(
+    const Canny_context* c,
+    int                  thread,
+    int                  num_threads
+)
+{
+    const Canny_workspace* ws = c->ws;
+    const int num_rows  = c->num_rows;
+    const int num_cols  = c->num_cols;
+    const int half      = c->mask_size / 2;
+    const int padding   = c->padding;
+    const int row_begin = get_band_begin(num_rows, thread, num_threads);
+    const int row_end   = get_band_begin(num_rows, thread + 1, num_threads);
+    int       row, col, k;
+
+
+    for (row = row_begin; row < row_end; row++)
+    {
+        float*   dcol  = ws->dcol + (size_t)row * num_cols;
+        float*   drow  = ws->drow + (size_t)row * num_cols;
+        float*   mag   = ws->mag + (size_t)row * num_cols;
+        uint8_t* state = ws->state + (size_t)row * num_cols;
+
+        for (col = 0; col < num_cols; col++)
+        {
+            dcol[ col ] = 0.0f;
+            drow[ col ] = 0.0f;
+        }
+
+        for (k = 0; k < c->mask_size; k++)
+        {
+            const int    in_row = reflect_index(row + half - k, num_rows);
+            const float* smooth = ws->smooth + (size_t)in_row * num_cols;
+            const float* deriv  = ws->deriv + (size_t)in_row * num_cols;
+            const float  g      = c->gauss[ k ];
+            const float  d      = c->dgauss[ k ];
+
+            for (col = 0; col < num_cols; col++)
+            {
+                dcol[ col ] += g * deriv[ col ];
+                drow[ col ] += d * smooth[ col ];
+            }
+        }
+
+        for (col = 0; col < num_cols; col++)
+        {
+            mag[ col ] = sqrtf(dcol[ col ] * dcol[ col ] + drow[ col ] * drow[ col ]);
+            state[ col ] = 0;
+
+            if (mag[ col ] >= 1.0e-8f)
+            {
+                dcol[ col ] /= mag[ col ];
+                drow[ col ] /= mag[ col ];
+            }
+        }
+
+        /*
+         * For noiseless data, only pixels of the (unpadded) input that are
+         * not zero can be edge points.
+        */
+        if (    c->noiseless_data
+             && (row >= padding) && (row < num_rows - padding)
+           )
+        {
+            const double* m_row = c->m->elements[ row - padding ];
+
+            for (col = padding; col < num_cols - padding; col++)
+            {
+                if (m_row[ col - padding ] < FLT_EPSILON)
+                {
+                    dcol[ col ] = 0.0f;
+                    drow[ col ] = 0.0f;
+                    mag[ col ] = 0.0f;
+                }
+            }
+        }
+    }
+}
+
+/*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\   */
+
+/*
+ * Non-maximal suppression for the pixels of a band, joining the maxima that
+ * are above the low threshold with their (already visited) neighbors in the
+ * same band. Neighbors in other bands are joined later by label_components().
+*/
+static void suppress_and_join
+(
+    const Canny_context* c,
+    int                  thread,
+    int                  num_threads
+)
+{
+    Canny_workspace* ws = c->ws;
+    const int num_rows  = c->num_rows;
+    const int num_cols  = c->num_cols;
+    const int padding   = c->padding;
+    const int band_begin = get_band_begin(num_rows, thread, num_threads);
+    const int row_begin = MAX_OF(band_begin, padding);
+    const int row_end   = MIN_OF(get_band_begin(num_rows, thread + 1, num_threads),
+                                 num_rows - padding);
+    const float* mag    = ws->mag;
+    int          row, col;
+
+
+    for (row = row_begin; row < row_end; row++)
+    {
+        const int row_up   = MAX_OF(row - 1, 0);
+        const int row_down = MIN_OF(row + 1, num_rows - 1);
+
+        for (col = padding; col < num_cols - padding; col++)
+        {
+            const int32_t i   = row * num_cols + col;
+            const float   m   = mag[ i ];
+            const float   dx  = ws->dcol[ i ];
+            const float   dy  = ws->drow[ i ];
+            const float   adx = (float)fabs(dx);
+            const float   ady = (float)fabs(dy);
+            const int     col_left  = MAX_OF(col - 1, 0);
+            const int     col_right = MIN_OF(col + 1, num_cols - 1);
+            float         m1, m2;
+
+            if ((m <= 0.0f) || (m < c->end_thresh)) continue;
+
+            /* The two neighbors along the gradient (x is col, y is row). */
+            if (ady <= TAN_PI_8 * adx)
+            {
+                m1 = mag[ row * num_cols + col_right ];
+                m2 = mag[ row * num_cols + col_left ];
+            }
+            else if (adx <= TAN_PI_8 * ady)
+            {
+                m1 = mag[ row_down * num_cols + col ];
+                m2 = mag[ row_up * num_cols + col ];
+            }
+            else if (dx * dy > 0.0f)
+            {
+                m1 = mag[ row_down * num_cols + col_right ];
+                m2 = mag[ row_up * num_cols + col_left ];
+            }
+            else
+            {
+                m1 = mag[ row_down * num_cols + col_left ];
+                m2 = mag[ row_up * num_cols + col_right ];
+            }
+
+            /* Ties are broken to one side, so plateaus give thin edges. */
+            if ((m <= m1) || (m < m2)) continue;
+
+            ws->state[ i ] = (m >= c->begin_thresh) ? CANNY_STRONG : CANNY_WEAK;
+            ws->parent[ i ] = i;
+
+            /* Join with the neighbors that were visited before. */
+            if (    (col > padding)
+                 && (ws->state[ i - 1 ] & CANNY_CANDIDATE)
+               )
+            {
+                join(ws->parent, i, i - 1);
+            }
+
+            if (row > row_begin)
+            {
+                int32_t up = i - num_cols;
+
+                if (ws->state[ up ] & CANNY_CANDIDATE)
+                {
+                    join(ws->parent, i, up);
+                }
+                if ((col > padding) && (ws->state[ up - 1 ] & CANNY_CANDIDATE))
+                {
+                    join(ws->parent, i, up - 1);
+                }
+                if (    (col < num_cols - padding - 1)
+                     && (ws->state[ up + 1 ] & CANNY_CANDIDATE)
+                   )
+                {
+                    join(ws->parent, i, up + 1);
+                }
+            }
+        }
+    }
+}
+
+/*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\   */
+
+/* Finds the root of a component, halving the path on the way. */
+static int32_t find_root(int32_t* parent, int32_t i)
+{
+    while (parent[ i ] != i)
+    {
+        parent[ i ] = parent[ parent[ i ] ];
+        i = parent[ i ];
+    }
+
+    return i;
+}
+
+/*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\   */
+
+/*
+ * Joins the components of i and j. The root with the larger index goes under
+ * the other, so a root is the first pixel of its component in scan order, and
+ * a parent never comes after its child.
+*/
+static void join(int32_t* parent, int32_t i, int32_t j)
+{
+    int32_t ri = find_root(parent, i);
+    int32_t rj = find_root(parent, j);
+
+    if (ri < rj)
+    {
+        parent[ rj ] = ri;
+    }
+    else if (rj < ri)
+    {
+        parent[ ri ] = rj;
+    }
+}
+
+/*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\   */
+
+/*
+ * Joins components across the band seams, applies hysteresis, and numbers the
+ * kept components in scan order, listing their pixels (also in scan order).
+ * This is done in the calling thread, in a few linear passes over the state.
+ * Finally, the per thread edge point buffers are grown to hold the components
+ * assigned to each thread.
+*/
+static int label_components(Canny_context* c, int num_threads)
+{
+    Canny_workspace* ws = c->ws;
+    const int32_t    num_pixels = c->num_rows * c->num_cols;
+    const int        num_cols   = c->num_cols;
+    uint8_t*         state  = ws->state;
+    int32_t*         parent = ws->parent;
+    int32_t*         label  = ws->label;
+    int32_t          num_components = 0;
+    int32_t          num_kept = 0;
+    int32_t          i;
+    int              t, col, k;
+
+
+    for (t = 1; t < num_threads; t++)
+    {
+        int row = get_band_begin(c->num_rows, t, num_threads);
+
+        if ((row <= 0) || (row >= c->num_rows)) continue;
+
+        for (col = 0; col < num_cols; col++)
+        {
+            i = row * num_cols + col;
+
+            if ( ! (state[ i ] & CANNY_CANDIDATE)) continue;
+
+            for (k = -1; k <= 1; k++)
+            {
+                if (    (col + k >= 0) && (col + k < num_cols)
+                     && (state[ i - num_cols + k ] & CANNY_CANDIDATE)
+                   )
+                {
+                    join(parent, i, i - num_cols + k);
+                }
+            }
+        }
+    }
+
+    /*
+     * Since parents come before their children, one pass in scan order points
+     * every pixel at its root.
+    */
+    for (i = 0; i < num_pixels; i++)
+    {
+        if ( ! (state[ i ] & CANNY_CANDIDATE)) continue;
+
+        parent[ i ] = parent[ parent[ i ] ];
+
+        if (state[ i ] & CANNY_STRONG)
+        {
+            state[ parent[ i ] ] |= CANNY_STRONG_ROOT;
+        }
+    }
+
+    for (i = 0; i < num_pixels; i++)
+    {
+        label[ i ] = -1;
+
+        if (    ! (state[ i ] & CANNY_CANDIDATE)
+             || ! (state[ parent[ i ] ] & CANNY_STRONG_ROOT)
+           )
+        {
+            continue;
+        }
+
+        if (parent[ i ] == i)
+        {
+            ERE(ensure_component_capacity(ws, num_components + 1));
+            ws->component_start[ num_components + 1 ] = 0;
+            label[ i ] = num_components++;
+        }
+        else
+        {
+            label[ i ] = label[ parent[ i ] ];
+        }
+
+        ws->component_start[ label[ i ] + 1 ]++;
+        num_kept++;
+    }
+
+    if (num_components == 0)
+    {
+        c->num_components = 0;
+        return NO_ERROR;
+    }
+
+    ws->component_start[ 0 ] = 0;
+
+    for (k = 0; k < num_components; k++)
+    {
+        ws->component_start[ k + 1 ] += ws->component_start[ k ];
+        ws->component_num_chains[ k ] = ws->component_start[ k ];
+    }
+
+    if ((size_t)num_kept > ws->num_component_pixels)
+    {
+        kjb_free(ws->component_pixels);
+        ws->num_component_pixels = 0;
+        NRE(ws->component_pixels = N_TYPE_MALLOC(int32_t, num_kept));
+        ws->num_component_pixels = num_kept;
+    }
+
+    /* The chain counts double as fill positions here. */
+    for (i = 0; i < num_pixels; i++)
+    {
+        if (label[ i ] >= 0)
+        {
+            ws->component_pixels[ ws->component_num_chains[ label[ i ] ]++ ] = i;
+        }
+    }
+
+    c->num_components = num_components;
+
+    /* A chain has at least one point, so points bound chains as well. */
+    for (t = 0; t < num_threads; t++)
+    {
+        size_t needed = 0;
+
+        for (k = t; k < num_components; k += num_threads)
+        {
+            needed += ws->component_start[ k + 1 ] - ws->component_start[ k ];
+        }
+
+        if (needed > ws->chain_capacities[ t ])
+        {
+            kjb_free(ws->points[ t ]);
+            kjb_free(ws->chain_lengths[ t ]);
+            ws->chain_lengths[ t ] = NULL;
+            ws->chain_capacities[ t ] = 0;
+
+            NRE(ws->points[ t ] = N_TYPE_MALLOC(Edge_point, needed));
+            NRE(ws->chain_lengths[ t ] = N_TYPE_MALLOC(uint32_t, needed));
+            ws->chain_capacities[ t ] = needed;
+        }
+    }
+
+    return NO_ERROR;
+}
+
+/*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\   */
+
+/*
+ * Traces the components assigned to a thread (every num_threads'th one) into
+ * chains. Each chain starts at the first unvisited pixel of its component,
+ * goes backwards along the edge, and then forwards from the start. Components
+ * are disjoint, so threads write to different pixels.
+*/
+static void trace_components
+(
+    const Canny_context* c,
+    int                  thread,
+    int                  num_threads
+)
+{
+    Canny_workspace* ws = c->ws;
+    Edge_point*      points = ws->points[ thread ];
+    uint32_t*        chain_lengths = ws->chain_lengths[ thread ];
+    size_t           num_points = 0;
+    size_t           num_chains = 0;
+    int32_t          k, p;
+
+
+    for (k = thread; k < c->num_components; k += num_threads)
+    {
+        int32_t num_component_chains = 0;
+
+        for (p = ws->component_start[ k ]; p < ws->component_start[ k + 1 ]; p++)
+        {
+            const int32_t i = ws->component_pixels[ p ];
+            const size_t  chain_begin = num_points;
+            size_t        n, j;
+
+            if (ws->state[ i ] & CANNY_VISITED) continue;
+
+            ws->state[ i ] |= CANNY_VISITED;
+
+            /* Backwards, then reversed in place. */
+            n = follow_chain(c, i, -ws->drow[ i ], ws->dcol[ i ], k,
+                             points + num_points);
+
+            for (j = 0; j < n / 2; j++)
+            {
+                Edge_point temp = points[ chain_begin + j ];
+
+                points[ chain_begin + j ] = points[ chain_begin + n - 1 - j ];
+                points[ chain_begin + n - 1 - j ] = temp;
+            }
+
+            num_points += n;
+
+            set_edge_point(c, i, points + num_points);
+            num_points++;
+
+            num_points += follow_chain(c, i, ws->drow[ i ], -ws->dcol[ i ], k,
+                                       points + num_points);
+
+            chain_lengths[ num_chains++ ] = (uint32_t)(num_points - chain_begin);
+            num_component_chains++;
+        }
+
+        ws->component_num_chains[ k ] = num_component_chains;
+    }
+}
+
+/*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\   */
+
+/*
+ * Follows unvisited pixels of a component from pixel i, starting in direction
+ * (dir_x, dir_y), and choosing at each step the neighbor best aligned with the
+ * edge direction. Returns the number of points added.
+*/
+static size_t follow_chain
+(
+    const Canny_context* c,
+    int32_t              i,
+    float                dir_x,
+    float                dir_y,
+    int32_t              component,
+    Edge_point*          points
+)
+{
+    static const int   offsets[ 8 ][ 2 ] = { {  1,  0 }, {  1,  1 },
+                                             {  0,  1 }, { -1,  1 },
+                                             { -1,  0 }, { -1, -1 },
+                                             {  0, -1 }, {  1, -1 } };
+    static const float inv_lengths[ 8 ]  = { 1.0f, 0.70710678f,
+                                             1.0f, 0.70710678f,
+                                             1.0f, 0.70710678f,
+                                             1.0f, 0.70710678f };
+    Canny_workspace* ws = c->ws;
+    size_t           n = 0;
+    int              row = i / c->num_cols;
+    int              col = i % c->num_cols;
+
+
+    for (;;)
+    {
+        int   best = -1;
+        float best_cos = MIN_CHAIN_STEP_COS;
+        int   k;
+
+        for (k = 0; k < 8; k++)
+        {
+            int     next_col = col + offsets[ k ][ 0 ];
+            int     next_row = row + offsets[ k ][ 1 ];
+            int32_t next;
+            float   step_cos;
+
+            if (    (next_col < 0) || (next_col >= c->num_cols)
+                 || (next_row < 0) || (next_row >= c->num_rows)
+               )
+            {
+                continue;
+            }
+
+            next = next_row * c->num_cols + next_col;
+
+            if (    (ws->label[ next ] != component)
+                 || (ws->state[ next ] & CANNY_VISITED)
+               )
+            {
+                continue;
+            }
+
+            step_cos = (offsets[ k ][ 0 ] * dir_x + offsets[ k ][ 1 ] * dir_y)
+                                                            * inv_lengths[ k ];
+            if (step_cos > best_cos)
+            {
+                best = k;
+                best_cos = step_cos;
+            }
+        }
+
+        if (best < 0) break;
+
+        col += offsets[ best ][ 0 ];
+        row += offsets[ best ][ 1 ];
+        i = row * c->num_cols + col;
+
+        ws->state[ i ] |= CANNY_VISITED;
+        set_edge_point(c, i, points + n);
+        n++;
+
+        /* Continue along the edge (normal to the gradient) at the new pixel. */
+        {
+            float edge_x = ws->drow[ i ];
+            float edge_y = -ws->dcol[ i ];
+
+            if (edge_x * offsets[ best ][ 0 ] + edge_y * offsets[ best ][ 1 ] < 0.0f)
+            {
+                edge_x = -edge_x;
+                edge_y = -edge_y;
+            }
+
+            dir_x = edge_x;
+            dir_y = edge_y;
+        }
+    }
+
+    return n;
+}
+
+/*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\   */
+
+static void set_edge_point(const Canny_context* c, int32_t i, Edge_point* pt)
+{
+    pt->row  = i / c->num_cols - c->padding;
+    pt->col  = i % c->num_cols - c->padding;
+    pt->dcol = c->ws->dcol[ i ];
+    pt->drow = c->ws->drow[ i ];
+    pt->mag  = c->ws->mag[ i ];
+    pt->silhouette = 0;
+}
+
+/*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\   */
+
+/*
+ * Copies the chains of all threads into a new edge set, in the order of their
+ * components, with all points in one buffer (as the other edge set routines
+ * expect).
+*/
+static int collect_edge_set
+(
+    Edge_set**           edges_out,
+    const Canny_context* c,
+    int                  num_threads
+)
+{
+    Canny_workspace* ws = c->ws;
+    Edge_set*        edge_set;
+    size_t           point_cursors[ 64 ];
+    size_t           chain_cursors[ 64 ];
+    size_t*          point_cursor = point_cursors;
+    size_t*          chain_cursor = chain_cursors;
+    uint32_t         num_edges = 0;
+    uint32_t         num_points;
+    Edge_point*      dest = NULL;
+    int32_t          k, j;
+    int              t;
+
+
+    if (num_threads > 64)
+    {
+        NRE(point_cursor = N_TYPE_MALLOC(size_t, 2 * num_threads));
+        chain_cursor = point_cursor + num_threads;
+    }
+
+    for (t = 0; t < num_threads; t++)
+    {
+        point_cursor[ t ] = 0;
+        chain_cursor[ t ] = 0;
+    }
+
+    for (k = 0; k < c->num_components; k++)
+    {
+        num_edges += ws->component_num_chains[ k ];
+    }
+
+    num_points = (c->num_components == 0) ? 0 :
+                                 ws->component_start[ c->num_components ];
+
+    free_edge_set(*edges_out);
+    *edges_out = NULL;
+
+    edge_set = TYPE_MALLOC(Edge_set);
+
+    if (edge_set != NULL)
+    {
+        edge_set->num_edges = num_edges;
+        edge_set->total_num_pts = num_points;
+        edge_set->num_rows = c->m->num_rows;
+        edge_set->num_cols = c->m->num_cols;
+        edge_set->edges = NULL;
+
+        if (num_edges > 0)
+        {
+            edge_set->edges = N_TYPE_MALLOC(Edge, num_edges);
+            dest = N_TYPE_MALLOC(Edge_point, num_points);
+
+            if ((edge_set->edges == NULL) || (dest == NULL))
+            {
+                kjb_free(dest);
+                kjb_free(edge_set->edges);
+                kjb_free(edge_set);
+                edge_set = NULL;
+            }
+        }
+    }
+
+    if (edge_set == NULL)
+    {
+        if (point_cursor != point_cursors) kjb_free(point_cursor);
+        return ERROR;
+    }
+
+    num_edges = 0;
+
+    for (k = 0; k < c->num_components; k++)
+    {
+        t = k % num_threads;
+
+        for (j = 0; j < ws->component_num_chains[ k ]; j++)
+        {
+            uint32_t length = ws->chain_lengths[ t ][ chain_cursor[ t ]++ ];
+
+            memcpy(dest, ws->points[ t ] + point_cursor[ t ],
+                   length * sizeof(Edge_point));
+
+            edge_set->edges[ num_edges ].points = dest;
+            edge_set->edges[ num_edges ].num_points = length;
+            num_edges++;
+
+            dest += length;
+            point_cursor[ t ] += length;
+        }
+    }
+
+    if (point_cursor != point_cursors) kjb_free(point_cursor);
+
+    *edges_out = edge_set;
+
+    return NO_ERROR;
+}
+
+/*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\   */
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,89 @@
+/* $Id$ */
+
+/* =========================================================================== *
+   |
+   |  Copyright (c) 1994-2010 by Kobus Barnard (author)
+   |
+   |  Personal and educational use of this code is granted, provided that this
+   |  header is kept intact, and that the authorship is not misrepresented, that
+   |  its use is acknowledged in publications, and relevant papers are cited.
+   |
+   |  For other use contact the author (kobus AT cs DOT arizona DOT edu).
+   |
+   |  Please note that the code in this file has not necessarily been adequately
+   |  tested. Naturally, there is no guarantee of performance, support, or fitness
+   |  for any particular task. Nonetheless, I am interested in hearing about
+   |  problems that you encounter.
+   |
+ * =========================================================================== */
+
+#ifndef KJB_EDGE_CANNY_H
+#define KJB_EDGE_CANNY_H
+
+#include "edge/edge_base.h"
+
+#ifdef __cplusplus
+extern "C" {
+#ifdef COMPILING_CPLUSPLUS_SOURCE
+namespace kjb_c {
+#endif
+#endif
+
+/**
+ * @brief Buffers used by the tiled edge detector, kept between calls.
+ *
+ * The layout is private to edge_canny.c. A workspace grows as needed, and is
+ * reused as is for images of the same (or smaller) size, so that detecting
+ * edges in a sequence of frames does not allocate per frame. A workspace must
+ * not be used by two calls at the same time.
+ */
+typedef struct Canny_workspace Canny_workspace;
+
+/** @brief Creates an empty workspace for the tiled edge detector. */
+Canny_workspace* create_canny_workspace(void);
+
+/** @brief Frees a workspace of the tiled edge detector. */
+void free_canny_workspace(Canny_workspace* workspace);
+
+/**
+ * @brief Detects a set of edges in a matrix, with a tiled, multithreaded
+ * version of the Canny algorithm.
+ */
+int detect_matrix_edge_set_tiled
+(
+    Edge_set**       edges_out,
+    Canny_workspace* workspace,
+    const Matrix*    m,
+    float            sigma,
+    float            begin_thresh,
+    float            end_thresh,
+    uint32_t         padding,
+    unsigned char    noiseless_data,
+    int              num_threads
+);
+
+/**
+ * @brief Detects a set of edges in an image, with a tiled, multithreaded
+ * version of the Canny algorithm.
+ */
+int detect_image_edge_set_tiled
+(
+    Edge_set**       edges_out,
+    Canny_workspace* workspace,
+    const KJB_image* img,
+    float            sigma,
+    float            begin_thresh,
+    float            end_thresh,
+    uint32_t         padding,
+    unsigned char    noiseless_data,
+    int              num_threads
+);
+
+#ifdef __cplusplus
+#ifdef COMPILING_CPLUSPLUS_SOURCE
+}
+#endif
+}
+#endif
+
+#endif
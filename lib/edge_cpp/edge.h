@@ -24,6 +24,7 @@
 
 #include <l/l_incl.h>
 #include <edge/edge_base.h>
+#include <edge/edge_canny.h>
 #include <i_cpp/i_image.h>
 
 #ifdef KJB_HAVE_BST_SERIAL
@@ -624,6 +625,12 @@ typedef boost::shared_ptr<Edge_set> Edge_set_ptr;
  * We build edges by starting from edge pixels and following the
  * gradient direction until we find a pixel whose gradient is lower than
  * the second threshold (hysteresis).
+ *
+ * If set_num_threads() is called, the detector uses the tiled, multithreaded
+ * version instead (see kjb_c::detect_matrix_edge_set_tiled()), and keeps its
+ * buffers between calls, which is much faster on video. In that case a
+ * detector must not be used by two threads at once; copies of a detector do
+ * not share buffers.
  */
 class Canny_edge_detector
 {
@@ -662,7 +669,18 @@ public:
         m_begin_thresh(begin_thresh),
         m_end_thresh(end_thresh),
         m_padding(padding),
-        m_fourier(use_fourier)
+        m_fourier(use_fourier),
+        m_num_threads(0)
+    {}
+
+    /** Copies the parameters; the copy gets its own buffers. */
+    Canny_edge_detector(const Canny_edge_detector& other) :
+        m_sigma(other.m_sigma),
+        m_begin_thresh(other.m_begin_thresh),
+        m_end_thresh(other.m_end_thresh),
+        m_padding(other.m_padding),
+        m_fourier(other.m_fourier),
+        m_num_threads(other.m_num_threads)
     {}
 
     Canny_edge_detector& operator=(const Canny_edge_detector& other)
@@ -682,8 +700,28 @@ public:
         swap(m_end_thresh, other.m_end_thresh);
         swap(m_padding, other.m_padding);
         swap(m_fourier, other.m_fourier);
+        swap(m_num_threads, other.m_num_threads);
+        m_workspace.swap(other.m_workspace);
+    }
+
+    /**
+     * @brief Use the tiled detector with this many threads.
+     *
+     * Zero (the default) selects the original, serial detector. The tiled
+     * detector does not use the Fourier transform, and links edge pixels
+     * after finding them, so its edges differ slightly from the original
+     * ones. Its result does not depend on the number of threads.
+     */
+    void set_num_threads(size_t num_threads)
+    {
+        m_num_threads = num_threads;
+    }
+
+    /** @brief Number of threads of the tiled detector (0 if not used). */
+    size_t get_num_threads() const
+    {
+        return m_num_threads;
     }
-            
 
     /** 
      * Detect edges in img 
@@ -701,19 +739,8 @@ public:
         bool noiseless_data = false
     )   const
     {
-        kjb_c::Edge_set* edge_set = NULL;
-        ETX(kjb_c::detect_image_edge_set(
-                &edge_set,
-                img.c_ptr(),
-                m_sigma,
-                m_begin_thresh,
-                m_end_thresh,
-                m_padding, 
-                m_fourier,
-                noiseless_data));
-
         // wrap c struct in c++ object
-        return Edge_set_ptr(new Edge_set(edge_set));
+        return Edge_set_ptr(new Edge_set(detect_c_edges(img, noiseless_data)));
     }
 
     /**
@@ -729,24 +756,53 @@ public:
     * */
     kjb::Edge_set* detect_edges(const Image& img, bool noiseless_data = false)
     {
-
-        kjb_c::Edge_set* edge_set = NULL;
-        ETX(kjb_c::detect_image_edge_set(
-                &edge_set,
-                img.c_ptr(),
-                m_sigma,
-                m_begin_thresh,
-                m_end_thresh,
-                m_padding,
-                m_fourier,
-                noiseless_data));
-
         // wrap c struct in c++ object
-        return new Edge_set(edge_set);
+        return new Edge_set(detect_c_edges(img, noiseless_data));
     }
 
 private:
 
+    kjb_c::Edge_set* detect_c_edges(const Image& img, bool noiseless_data) const
+    {
+        kjb_c::Edge_set* edge_set = NULL;
+
+        if (m_num_threads == 0)
+        {
+            ETX(kjb_c::detect_image_edge_set(
+                    &edge_set,
+                    img.c_ptr(),
+                    m_sigma,
+                    m_begin_thresh,
+                    m_end_thresh,
+                    m_padding,
+                    m_fourier,
+                    noiseless_data));
+        }
+        else
+        {
+            if (!m_workspace)
+            {
+                kjb_c::Canny_workspace* workspace
+                    = kjb_c::create_canny_workspace();
+                ETX(workspace == NULL ? kjb_c::ERROR : kjb_c::NO_ERROR);
+                m_workspace.reset(workspace, kjb_c::free_canny_workspace);
+            }
+
+            ETX(kjb_c::detect_image_edge_set_tiled(
+                    &edge_set,
+                    m_workspace.get(),
+                    img.c_ptr(),
+                    m_sigma,
+                    m_begin_thresh,
+                    m_end_thresh,
+                    m_padding,
+                    noiseless_data,
+                    m_num_threads));
+        }
+
+        return edge_set;
+    }
+
     /// @brief The standard deviation of the Gaussian using to blur the image
     float m_sigma;
 
@@ -761,6 +817,12 @@ private:
 
     /// @brief specifies whether to use fast Fourier transform to convolve
     bool  m_fourier;
+
+    /// @brief Threads of the tiled detector, or 0 for the original one
+    size_t m_num_threads;
+
+    /// @brief Buffers of the tiled detector, kept between calls
+    mutable boost::shared_ptr<kjb_c::Canny_workspace> m_workspace;
 };
 
 
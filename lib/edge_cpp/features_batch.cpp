@@ -0,0 +1,595 @@
+/* $Id */
+
+/* =========================================================================== *
+|
+|  Copyright (c) 1994-2008 by Kobus Barnard (author).
+|
+|  Personal and educational use of this code is granted, provided that this
+|  header is kept intact, and that the authorship is not misrepresented, that
+|  its use is acknowledged in publications, and relevant papers are cited.
+|
+|  For other use contact the author (kobus AT cs DOT arizona DOT edu).
+|
+|  Please note that the code in this file has not necessarily been adequately
+|  tested. Naturally, there is no guarantee of performance, support, or fitness
+|  for any particular task. Nonetheless, I am interested in hearing about
+|  problems that you encounter.
+|
+* =========================================================================== */
+
+#include "edge_cpp/features_batch.h"
+#include "edge_cpp/vanishing_point_detector.h"
+#include "l/l_sys_io.h"
+#include "l/l_sys_time.h"
+#include "l_cpp/l_exception.h"
+
+#include <boost/thread.hpp>
+#include <boost/bind.hpp>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <cstdio>
+#include <cstring>
+#include <unistd.h>
+
+using namespace kjb;
+
+namespace
+{
+
+const char CACHE_MAGIC[8] = { 'K', 'J', 'B', 'F', 'M', 'C', '0', '1' };
+
+/** FNV-1a, which is plenty for cache keys (this is not a secure hash) */
+class Hasher
+{
+    public:
+
+        Hasher() : m_hash(14695981039346656037ULL) {}
+
+        void add(const void * data, size_t length)
+        {
+            const unsigned char * bytes = static_cast<const unsigned char *>(data);
+            for(size_t i = 0; i < length; i++)
+            {
+                m_hash ^= bytes[i];
+                m_hash *= 1099511628211ULL;
+            }
+        }
+
+        template <class T>
+        void add(const T & value)
+        {
+            add(&value, sizeof(value));
+        }
+
+        void add(const std::string & value)
+        {
+            add(value.data(), value.size());
+        }
+
+        uint64_t get() const
+        {
+            return m_hash;
+        }
+
+    private:
+
+        uint64_t m_hash;
+};
+
+template <class T>
+void append_value(std::string & data, const T & value)
+{
+    data.append(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+template <class T>
+bool extract_value(const std::string & data, size_t & pos, T & value)
+{
+    if(pos + sizeof(value) > data.size())
+    {
+        return false;
+    }
+    memcpy(&value, data.data() + pos, sizeof(value));
+    pos += sizeof(value);
+    return true;
+}
+
+/** Vanishing points payload: success, focal length, and each point */
+std::string serialize_vanishing_points
+(
+    bool success,
+    double focal_length,
+    const std::vector<Vanishing_point> & vpts
+)
+{
+    std::string data;
+    append_value(data, (uint32_t)success);
+    append_value(data, focal_length);
+    append_value(data, (uint32_t)vpts.size());
+    for(size_t i = 0; i < vpts.size(); i++)
+    {
+        append_value(data, vpts[i].get_x());
+        append_value(data, vpts[i].get_y());
+        append_value(data, (uint32_t)vpts[i].get_type());
+    }
+    return data;
+}
+
+bool unserialize_vanishing_points
+(
+    const std::string & data,
+    bool & success,
+    double & focal_length,
+    std::vector<Vanishing_point> & vpts
+)
+{
+    size_t pos = 0;
+    uint32_t s, n;
+    if(!extract_value(data, pos, s) || !extract_value(data, pos, focal_length)
+        || !extract_value(data, pos, n))
+    {
+        return false;
+    }
+
+    success = s != 0;
+    vpts.clear();
+    for(uint32_t i = 0; i < n; i++)
+    {
+        double x, y;
+        uint32_t type;
+        if(!extract_value(data, pos, x) || !extract_value(data, pos, y)
+            || !extract_value(data, pos, type))
+        {
+            return false;
+        }
+        Vanishing_point vp(x, y);
+        vp.set_type((Vanishing_point::Vanishing_point_type)type);
+        vpts.push_back(vp);
+    }
+    return true;
+}
+
+/** Image reading goes through the C library I/O, which is not reentrant */
+boost::mutex image_read_mutex;
+
+} // anonymous namespace
+
+/* ------------------------------------------------------------------------- */
+
+Features_cache::Features_cache(const std::string & dir) : m_dir(dir)
+{
+    ETX(kjb_c::kjb_mkdir(dir.c_str()));
+}
+
+std::string Features_cache::get_path(const std::string & stage, uint64_t key) const
+{
+    std::ostringstream path;
+    path << m_dir << '/' << stage << '_' << std::hex << std::setw(16)
+         << std::setfill('0') << key << ".bin";
+    return path.str();
+}
+
+/**
+ * @param stage The name of the stage, e.g. "edges"
+ * @param key   The hash of the input of the stage
+ * @param data  Receives the stored bytes
+ */
+bool Features_cache::read
+(
+    const std::string & stage,
+    uint64_t key,
+    std::string & data
+) const
+{
+    std::ifstream in(get_path(stage, key).c_str(), std::ios::binary);
+    if(!in)
+    {
+        return false;
+    }
+
+    char magic[sizeof(CACHE_MAGIC)];
+    uint64_t stored_key;
+    uint64_t length;
+    in.read(magic, sizeof(magic));
+    in.read(reinterpret_cast<char *>(&stored_key), sizeof(stored_key));
+    in.read(reinterpret_cast<char *>(&length), sizeof(length));
+    if(!in || memcmp(magic, CACHE_MAGIC, sizeof(magic)) != 0 || stored_key != key)
+    {
+        return false;
+    }
+
+    data.resize(length);
+    if(length > 0)
+    {
+        in.read(&data[0], length);
+    }
+    return (bool)in;
+}
+
+/**
+ * @param stage The name of the stage, e.g. "edges"
+ * @param key   The hash of the input of the stage
+ * @param data  The bytes to store
+ */
+void Features_cache::write
+(
+    const std::string & stage,
+    uint64_t key,
+    const std::string & data
+) const
+{
+    const std::string path = get_path(stage, key);
+
+    std::ostringstream tmp_path;
+    tmp_path << path << ".tmp." << getpid() << '.' << boost::this_thread::get_id();
+
+    {
+        std::ofstream out(tmp_path.str().c_str(), std::ios::binary);
+        const uint64_t length = data.size();
+        out.write(CACHE_MAGIC, sizeof(CACHE_MAGIC));
+        out.write(reinterpret_cast<const char *>(&key), sizeof(key));
+        out.write(reinterpret_cast<const char *>(&length), sizeof(length));
+        out.write(data.data(), data.size());
+        if(!out)
+        {
+            std::remove(tmp_path.str().c_str());
+            KJB_THROW_3(IO_error, "Could not write features cache entry %s", (path.c_str()));
+        }
+    }
+
+    if(std::rename(tmp_path.str().c_str(), path.c_str()) != 0)
+    {
+        std::remove(tmp_path.str().c_str());
+        KJB_THROW_3(IO_error, "Could not write features cache entry %s", (path.c_str()));
+    }
+}
+
+/* ------------------------------------------------------------------------- */
+
+uint64_t kjb::hash_image(const kjb::Image & img)
+{
+    Hasher hasher;
+    const int num_rows = img.get_num_rows();
+    const int num_cols = img.get_num_cols();
+    hasher.add(num_rows);
+    hasher.add(num_cols);
+
+    for(int r = 0; r < num_rows; r++)
+    {
+        for(int c = 0; c < num_cols; c++)
+        {
+            float rgb[3] = { img(r, c, 0), img(r, c, 1), img(r, c, 2) };
+            hasher.add(rgb, sizeof(rgb));
+        }
+    }
+    return hasher.get();
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * @param cache_dir   Directory of the cache (created if needed). If empty,
+ *                    every stage is computed and nothing is stored.
+ * @param num_threads Number of images processed at the same time; 0 means
+ *                    one per hardware thread.
+ */
+Features_batch::Features_batch(const std::string & cache_dir, size_t num_threads)
+ : m_num_threads(num_threads)
+{
+    if(!cache_dir.empty())
+    {
+        m_cache.reset(new Features_cache(cache_dir));
+    }
+
+    set_edge_detection_parameters
+    (
+        FM_DEFAULT_EDGE_SIGMA,
+        FM_DEFAULT_EDGE_BEGIN,
+        FM_DEFAULT_EDGE_END,
+        FM_DEFAULT_EDGE_PADDING,
+        true
+    );
+    set_manhattan_world_parameters
+    (
+        FM_DEFAULT_VP_SUCCESS_PROBABILITY,
+        FM_DEFAULT_VP_ASSIGNMENT_THRESHOLD
+    );
+}
+
+void Features_batch::set_edge_detection_parameters
+(
+    float iblurring_sigma,
+    float ibegin_threshold,
+    float iend_threshold,
+    unsigned int ipadding,
+    bool iuse_fourier
+)
+{
+    // Checked by Features_manager, so that bad values fail here rather than
+    // for every image.
+    Features_manager check((kjb::Edge_set *)0, (Edge_segment_set *)0, (Manhattan_world *)0);
+    check.set_edge_detection_parameters(iblurring_sigma, ibegin_threshold,
+                                        iend_threshold, ipadding, iuse_fourier);
+
+    m_blurring_sigma = iblurring_sigma;
+    m_begin_threshold = ibegin_threshold;
+    m_end_threshold = iend_threshold;
+    m_padding = ipadding;
+    m_use_fourier = iuse_fourier;
+}
+
+void Features_batch::set_manhattan_world_parameters
+(
+    double ivanishing_point_detection_success_probability,
+    double ioutlier_threshold_for_vanishing_points_assignment
+)
+{
+    Features_manager check((kjb::Edge_set *)0, (Edge_segment_set *)0, (Manhattan_world *)0);
+    check.set_manhattan_world_parameters(ivanishing_point_detection_success_probability,
+                                         ioutlier_threshold_for_vanishing_points_assignment);
+
+    m_vp_success_probability = ivanishing_point_detection_success_probability;
+    m_vp_outlier_threshold = ioutlier_threshold_for_vanishing_points_assignment;
+}
+
+/**
+ * Runs edge detection, segment fitting and Manhattan world detection as
+ * Features_manager(img) does, reading each stage from the cache if it is
+ * there and storing it otherwise.
+ */
+boost::shared_ptr<Features_manager> Features_batch::detect
+(
+    const kjb::Image & img,
+    Features_batch_result & result
+) const
+{
+    boost::shared_ptr<Features_manager> fm(new Features_manager(
+            (kjb::Edge_set *)0, (Edge_segment_set *)0, (Manhattan_world *)0));
+    fm->set_edge_detection_parameters(m_blurring_sigma, m_begin_threshold,
+                                      m_end_threshold, m_padding, m_use_fourier);
+    fm->set_manhattan_world_parameters(m_vp_success_probability,
+                                       m_vp_outlier_threshold);
+
+    const uint64_t image_key = hash_image(img);
+    std::string data;
+
+    /* Edges */
+    long start = kjb_c::get_real_time();
+    Hasher edges_hasher;
+    edges_hasher.add(image_key);
+    edges_hasher.add(std::string("edges"));
+    edges_hasher.add(m_blurring_sigma);
+    edges_hasher.add(m_begin_threshold);
+    edges_hasher.add(m_end_threshold);
+    edges_hasher.add(m_padding);
+    edges_hasher.add(m_use_fourier);
+    const uint64_t edges_key = edges_hasher.get();
+
+    kjb_c::Edge_set * c_edges = 0;
+    if(m_cache && m_cache->read("edges", edges_key, data)
+        && !data.empty()
+        && kjb_c::unserialize_edge_set(&c_edges, &data[0]) == kjb_c::NO_ERROR)
+    {
+        fm->edges = new kjb::Edge_set(c_edges);
+        fm->_edges_available = true;
+        result.edges_cached = true;
+    }
+    else
+    {
+        fm->detect_edges(img);
+        if(m_cache)
+        {
+            char * buffer = 0;
+            size_t length;
+            ETX(kjb_c::serialize_edge_set(fm->edges->c_ptr(), &buffer, &length));
+            data.assign(buffer, length);
+            kjb_c::kjb_free(buffer);
+            m_cache->write("edges", edges_key, data);
+        }
+    }
+    result.edges_time = kjb_c::get_real_time() - start;
+
+    /* Edge segments */
+    start = kjb_c::get_real_time();
+    Hasher segments_hasher;
+    segments_hasher.add(edges_key);
+    segments_hasher.add(std::string("edge_segments"));
+    const uint64_t segments_key = segments_hasher.get();
+
+    if(m_cache && m_cache->read("edge_segments", segments_key, data))
+    {
+        std::istringstream in(data);
+        fm->edge_segments = new Edge_segment_set(fm->edges, in);
+        fm->_edge_segments_available = true;
+        result.edge_segments_cached = true;
+    }
+    else
+    {
+        fm->fit_edge_segments_to_edges();
+        fm->remove_frame_segments();
+        if(m_cache)
+        {
+            std::ostringstream out;
+            fm->edge_segments->write(out);
+            m_cache->write("edge_segments", segments_key, out.str());
+        }
+    }
+    result.edge_segments_time = kjb_c::get_real_time() - start;
+
+    /* Vanishing points, which only depend on the image */
+    start = kjb_c::get_real_time();
+    Hasher vpts_hasher;
+    vpts_hasher.add(image_key);
+    vpts_hasher.add(std::string("vanishing_points"));
+    vpts_hasher.add(m_vp_success_probability);
+    const uint64_t vpts_key = vpts_hasher.get();
+
+    std::vector<Vanishing_point> vpts;
+    double focal_length = 0.0;
+    bool success = false;
+    if(m_cache && m_cache->read("vanishing_points", vpts_key, data)
+        && unserialize_vanishing_points(data, success, focal_length, vpts))
+    {
+        result.vanishing_points_cached = true;
+    }
+    else
+    {
+        // Each image has its own stream, so the result does not depend on
+        // the other images or on the threads.
+        Vanishing_point_random_stream stream(vpts_key);
+        success = robustly_estimate_vanishing_points(vpts, focal_length, img,
+                                                     m_vp_success_probability,
+                                                     true);
+        if(m_cache)
+        {
+            m_cache->write("vanishing_points", vpts_key,
+                           serialize_vanishing_points(success, focal_length, vpts));
+        }
+    }
+
+    if(success)
+    {
+        // Assigns the segments to the vanishing points and creates corners
+        fm->set_manhattan_world(new Manhattan_world(vpts, focal_length));
+    }
+    result.manhattan_world_time = kjb_c::get_real_time() - start;
+
+    return fm;
+}
+
+void Features_batch::run_worker
+(
+    const std::vector<std::string> & image_paths,
+    std::vector<Features_batch_result> & results,
+    size_t * next,
+    boost::mutex * next_mutex
+) const
+{
+    while(true)
+    {
+        size_t i;
+        {
+            boost::mutex::scoped_lock lock(*next_mutex);
+            if(*next >= image_paths.size())
+            {
+                return;
+            }
+            i = (*next)++;
+        }
+
+        Features_batch_result & result = results[i];
+        result.image_path = image_paths[i];
+
+        try
+        {
+            long start = kjb_c::get_real_time();
+            boost::shared_ptr<kjb::Image> img;
+            {
+                boost::mutex::scoped_lock lock(image_read_mutex);
+                img.reset(new kjb::Image(image_paths[i]));
+            }
+            result.load_time = kjb_c::get_real_time() - start;
+
+            result.features = detect(*img, result);
+        }
+        catch(const KJB_error & e)
+        {
+            result.error = e.get_msg();
+        }
+        catch(const std::exception & e)
+        {
+            result.error = e.what();
+        }
+    }
+}
+
+/**
+ * @param image_paths The images to detect features from
+ *
+ * @return One result per image, in the same order
+ */
+std::vector<Features_batch_result> Features_batch::run
+(
+    const std::vector<std::string> & image_paths
+) const
+{
+    std::vector<Features_batch_result> results(image_paths.size());
+    size_t next = 0;
+    boost::mutex next_mutex;
+
+    size_t nt = m_num_threads;
+    if(nt == 0)
+    {
+        nt = boost::thread::hardware_concurrency();
+    }
+    if(nt > image_paths.size())
+    {
+        nt = image_paths.size();
+    }
+
+    if(nt <= 1)
+    {
+        run_worker(image_paths, results, &next, &next_mutex);
+    }
+    else
+    {
+        // Threads take the next image as they finish one, since images can
+        // take very different times.
+        boost::thread_group thrds;
+        for(size_t t = 0; t < nt; t++)
+        {
+            thrds.create_thread(boost::bind(&Features_batch::run_worker, this,
+                                            boost::cref(image_paths),
+                                            boost::ref(results), &next,
+                                            &next_mutex));
+        }
+        thrds.join_all();
+    }
+
+    return results;
+}
+
+/* ------------------------------------------------------------------------- */
+
+void kjb::report_features_batch_timings
+(
+    std::ostream & out,
+    const std::vector<Features_batch_result> & results
+)
+{
+    long total_load = 0;
+    long total_edges = 0;
+    long total_segments = 0;
+    long total_manhattan = 0;
+    size_t num_failed = 0;
+
+    out << "load edges segments manhattan (ms; * = cached) image\n";
+    for(size_t i = 0; i < results.size(); i++)
+    {
+        const Features_batch_result & r = results[i];
+        out << std::setw(6) << r.load_time << ' '
+            << std::setw(6) << r.edges_time << (r.edges_cached ? '*' : ' ')
+            << std::setw(6) << r.edge_segments_time
+            << (r.edge_segments_cached ? '*' : ' ')
+            << std::setw(6) << r.manhattan_world_time
+            << (r.vanishing_points_cached ? '*' : ' ')
+            << ' ' << r.image_path;
+        if(!r.features)
+        {
+            out << " FAILED: " << r.error;
+            num_failed++;
+        }
+        out << '\n';
+
+        total_load += r.load_time;
+        total_edges += r.edges_time;
+        total_segments += r.edge_segments_time;
+        total_manhattan += r.manhattan_world_time;
+    }
+
+    out << "total: load " << total_load << " ms, edges " << total_edges
+        << " ms, segments " << total_segments << " ms, manhattan "
+        << total_manhattan << " ms; " << num_failed << " of "
+        << results.size() << " failed\n";
+}
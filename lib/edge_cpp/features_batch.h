@@ -0,0 +1,206 @@
+/* $Id $ */
+
+/**
+ * @file
+ *
+ * @brief Batch feature detection with an on-disk cache of each stage
+ *
+ * Copyright (c) 2003-2008 by members of University of Arizona Computer Vision
+ * group. For use outside the University of Arizona Computer Vision group
+ * please contact Kobus Barnard.
+ */
+
+#ifndef EDGE_FEATURES_BATCH_H
+#define EDGE_FEATURES_BATCH_H
+
+#include "edge_cpp/features_manager.h"
+#include "i_cpp/i_image.h"
+
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <ostream>
+
+namespace kjb {
+
+/**
+ * @class Features_cache
+ *
+ * @brief A directory of binary entries, one file per stage and key.
+ *
+ * Keys are hashes of the input of a stage (see hash_image()), so an entry
+ * never needs to be invalidated: changing the image or a parameter changes
+ * the key. Entries are written under a temporary name and then renamed, so
+ * readers (other threads or other runs) never see a partial entry.
+ */
+class Features_cache
+{
+    public:
+
+        /** @brief Uses directory dir for the cache, creating it if needed */
+        explicit Features_cache(const std::string & dir);
+
+        const std::string & get_directory() const
+        {
+            return m_dir;
+        }
+
+        /** @brief Reads the entry of stage with the given key.
+         *  Returns false if there is none (or it is unreadable) */
+        bool read(const std::string & stage, uint64_t key, std::string & data) const;
+
+        /** @brief Stores the entry of stage with the given key */
+        void write(const std::string & stage, uint64_t key, const std::string & data) const;
+
+    private:
+
+        std::string get_path(const std::string & stage, uint64_t key) const;
+
+        std::string m_dir;
+};
+
+/** @brief Hash of the size and pixel values of an image, used to key the
+ *  cache entries of the features of the image */
+uint64_t hash_image(const kjb::Image & img);
+
+/**
+ * @brief The features of one image of a batch, with how they were obtained.
+ *
+ * Times are real times in milliseconds. For a cached stage it is the time
+ * taken to read it back.
+ */
+struct Features_batch_result
+{
+    Features_batch_result() :
+        edges_cached(false), edge_segments_cached(false),
+        vanishing_points_cached(false), load_time(0), edges_time(0),
+        edge_segments_time(0), manhattan_world_time(0)
+    {}
+
+    std::string image_path;
+
+    /** @brief NULL if detection failed; see error */
+    boost::shared_ptr<Features_manager> features;
+    std::string error;
+
+    bool edges_cached;
+    bool edge_segments_cached;
+    bool vanishing_points_cached;
+
+    long load_time;
+    long edges_time;
+    long edge_segments_time;
+    long manhattan_world_time;
+};
+
+/**
+ * @class Features_batch
+ *
+ * @brief Detects the features of Features_manager (edges, edge segments and
+ *        Manhattan world) for many images, reusing cached stages.
+ *
+ * With a cache directory, the output of each stage is stored keyed by the
+ * hash of the image and the parameters the stage depends on:
+ * - edges:            the edge detection parameters
+ * - edge segments:    the edges
+ * - vanishing points: the vanishing point detection success probability
+ * The Manhattan world is rebuilt from the vanishing points and the edge
+ * segments, which is cheap. So, for example, changing the outlier threshold
+ * only reassigns the segments, and changing the Canny thresholds does not
+ * rerun vanishing point detection.
+ *
+ * Images are processed by a pool of threads, each taking the next image of
+ * the list. Reading images and FFTW planning are serialized. Vanishing point
+ * detection of each image draws from its own random stream, seeded from the
+ * image and the parameters (see Vanishing_point_random_stream), so the
+ * features do not depend on the number of threads and equal those of
+ * detect().
+ */
+class Features_batch
+{
+    public:
+
+        /** @brief Uses the default Features_manager parameters.
+         *  If cache_dir is empty nothing is cached. */
+        Features_batch(const std::string & cache_dir = "", size_t num_threads = 1);
+
+        /** @brief Sets the parameters needed for edge detection, see
+         *  Features_manager::set_edge_detection_parameters() */
+        void set_edge_detection_parameters
+        (
+            float iblurring_sigma,
+            float ibegin_threshold,
+            float iend_threshold,
+            unsigned int ipadding,
+            bool iuse_fourier
+        );
+
+        /** @brief Sets the parameters needed to detect Manhattan world
+         *  features, see Features_manager::set_manhattan_world_parameters() */
+        void set_manhattan_world_parameters
+        (
+            double ivanishing_point_detection_success_probability,
+            double ioutlier_threshold_for_vanishing_points_assignment
+        );
+
+        /** @brief Sets the number of threads; 0 means one per hardware thread */
+        void set_num_threads(size_t num_threads)
+        {
+            m_num_threads = num_threads;
+        }
+
+        size_t get_num_threads() const
+        {
+            return m_num_threads;
+        }
+
+        /** @brief Detects the features of every image in image_paths.
+         *  Failures are reported in the results, not thrown. */
+        std::vector<Features_batch_result> run
+        (
+            const std::vector<std::string> & image_paths
+        ) const;
+
+        /** @brief Detects the features of one image, filling in the stage
+         *  information of result */
+        boost::shared_ptr<Features_manager> detect
+        (
+            const kjb::Image & img,
+            Features_batch_result & result
+        ) const;
+
+    private:
+
+        void run_worker
+        (
+            const std::vector<std::string> & image_paths,
+            std::vector<Features_batch_result> & results,
+            size_t * next,
+            boost::mutex * next_mutex
+        ) const;
+
+        boost::shared_ptr<Features_cache> m_cache;
+        size_t m_num_threads;
+
+        float m_blurring_sigma;
+        float m_begin_threshold;
+        float m_end_threshold;
+        unsigned int m_padding;
+        bool m_use_fourier;
+
+        double m_vp_success_probability;
+        double m_vp_outlier_threshold;
+};
+
+/** @brief Prints the time of each stage of each image, and totals */
+void report_features_batch_timings
+(
+    std::ostream & out,
+    const std::vector<Features_batch_result> & results
+);
+
+}
+
+#endif
@@ -232,6 +232,9 @@ class Features_manager : public Readable, public Writeable
 
     private:
 
+        /** Runs the detection stages one at a time, with a cache */
+        friend class Features_batch;
+
         /** Copy constructor is private so that we cannot copy this class */
         Features_manager(const Features_manager & src) :
                     Readable(), Writeable() { (*this) = src; }
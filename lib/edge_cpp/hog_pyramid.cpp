@@ -0,0 +1,550 @@
+/* $Id$ */
+/* =========================================================================== *
+   |
+   |  Copyright (c) 1994-2010 by Kobus Barnard (author)
+   |
+   |  Personal and educational use of this code is granted, provided that this
+   |  header is kept intact, and that the authorship is not misrepresented, that
+   |  its use is acknowledged in publications, and relevant papers are cited.
+   |
+   |  For other use contact the author (kobus AT cs DOT arizona DOT edu).
+   |
+   |  Please note that the code in this file has not necessarily been adequately
+   |  tested. Naturally, there is no guarantee of performance, support, or fitness
+   |  for any particular task. Nonetheless, I am interested in hearing about
+   |  problems that you encounter.
+   |
+ * =========================================================================== */
+
+#include <edge_cpp/hog_pyramid.h>
+#include <l_cpp/l_exception.h>
+
+#include <boost/thread.hpp>
+#include <boost/bind.hpp>
+#include <algorithm>
+#include <cmath>
+
+using namespace kjb;
+
+namespace
+{
+
+// Same constants as Hog_responses.
+const double HOG_NORM_EPSILON = 0.0001;
+
+const double HOG_UU[ 9 ] = {  1.0000,  0.9397,  0.7660,  0.500,   0.1736,
+                             -0.1736, -0.5000, -0.7660, -0.9397 };
+const double HOG_VV[ 9 ] = {  0.0000,  0.3420,  0.6428,  0.8660,  0.9848,
+                              0.9848,  0.8660,  0.6428,  0.3420 };
+
+/**
+ * Resamples a 3-channel planar image by averaging over the area each output
+ * pixel covers. Used both for the scales within an octave and for halving.
+ */
+void resample_planes
+(
+    const std::vector<float>& src,
+    int                       num_rows,
+    int                       num_cols,
+    std::vector<float>&       dest,
+    int                       new_num_rows,
+    int                       new_num_cols
+)
+{
+    std::vector<int>   first_col(new_num_cols + 1);
+    std::vector<int>   src_cols;
+    std::vector<float> col_weights;
+    std::vector<float> tmp(num_rows * new_num_cols);
+    double             f;
+
+    // Source columns, and weights, of each output column.
+    f = (double)num_cols / new_num_cols;
+    for (int c = 0; c < new_num_cols; c++)
+    {
+        double lo = c * f;
+        double hi = (c + 1) * f;
+
+        first_col[ c ] = (int)src_cols.size();
+
+        for (int s = (int)std::floor(lo); s < hi && s < num_cols; s++)
+        {
+            double w = std::min(hi, s + 1.0) - std::max(lo, (double)s);
+
+            if (w > 0.0)
+            {
+                src_cols.push_back(s);
+                col_weights.push_back((float)(w / f));
+            }
+        }
+    }
+    first_col[ new_num_cols ] = (int)src_cols.size();
+
+    dest.resize(3 * new_num_rows * new_num_cols);
+    f = (double)num_rows / new_num_rows;
+
+    for (int ch = 0; ch < 3; ch++)
+    {
+        const float* in  = &src[ ch * num_rows * num_cols ];
+        float*       out = &dest[ ch * new_num_rows * new_num_cols ];
+
+        for (int r = 0; r < num_rows; r++)
+        {
+            const float* in_row  = in + r * num_cols;
+            float*       tmp_row = &tmp[ r * new_num_cols ];
+
+            for (int c = 0; c < new_num_cols; c++)
+            {
+                float sum = 0.0f;
+
+                for (int k = first_col[ c ]; k < first_col[ c + 1 ]; k++)
+                {
+                    sum += col_weights[ k ] * in_row[ src_cols[ k ] ];
+                }
+                tmp_row[ c ] = sum;
+            }
+        }
+
+        for (int r = 0; r < new_num_rows; r++)
+        {
+            double lo      = r * f;
+            double hi      = (r + 1) * f;
+            float* out_row = out + r * new_num_cols;
+
+            std::fill(out_row, out_row + new_num_cols, 0.0f);
+
+            for (int s = (int)std::floor(lo); s < hi && s < num_rows; s++)
+            {
+                float        w = (float)((std::min(hi, s + 1.0)
+                                            - std::max(lo, (double)s)) / f);
+                const float* tmp_row = &tmp[ s * new_num_cols ];
+
+                // Contiguous, so that the compiler can vectorize it.
+                for (int c = 0; c < new_num_cols; c++)
+                {
+                    out_row[ c ] += w * tmp_row[ c ];
+                }
+            }
+        }
+    }
+}
+
+/**
+ * Gradient orientation (one of 18) and magnitude of each interior pixel, taken
+ * from the channel with the strongest gradient, as in Hog_responses.
+ */
+void compute_gradients
+(
+    const std::vector<float>&   planes,
+    int                         num_rows,
+    int                         num_cols,
+    std::vector<unsigned char>& orientations,
+    std::vector<float>&         magnitudes
+)
+{
+    const int          n = num_rows * num_cols;
+    std::vector<float> dx(num_cols);
+    std::vector<float> dy(num_cols);
+    std::vector<float> v(num_cols);
+
+    orientations.assign(n, 0);
+    magnitudes.assign(n, 0.0f);
+
+    for (int r = 1; r < num_rows - 1; r++)
+    {
+        std::fill(v.begin(), v.end(), -1.0f);
+
+        for (int ch = 0; ch < 3; ch++)
+        {
+            const float* row  = &planes[ ch * n + r * num_cols ];
+            const float* up   = row - num_cols;
+            const float* down = row + num_cols;
+
+            for (int c = 1; c < num_cols - 1; c++)
+            {
+                float gx = row[ c + 1 ] - row[ c - 1 ];
+                float gy = down[ c ] - up[ c ];
+                float m  = gx * gx + gy * gy;
+
+                // Ties keep the earlier channel, as in Hog_responses.
+                if (m > v[ c ])
+                {
+                    v[ c ]  = m;
+                    dx[ c ] = gx;
+                    dy[ c ] = gy;
+                }
+            }
+        }
+
+        for (int c = 1; c < num_cols - 1; c++)
+        {
+            double best_dot = 0;
+            int    best_o   = 0;
+
+            for (int o = 0; o < 9; o++)
+            {
+                double dot = HOG_UU[ o ] * dx[ c ] + HOG_VV[ o ] * dy[ c ];
+
+                if (dot > best_dot)
+                {
+                    best_dot = dot;
+                    best_o = o;
+                }
+                else if (-dot > best_dot)
+                {
+                    best_dot = -dot;
+                    best_o = o + 9;
+                }
+            }
+
+            orientations[ r * num_cols + c ] = (unsigned char)best_o;
+            magnitudes[ r * num_cols + c ]   = std::sqrt(v[ c ]);
+        }
+    }
+}
+
+/**
+ * Bins the gradients into cells of the given size, and normalizes them into
+ * the 32 features of each cell. Returns false if there is not a single full
+ * cell, in which case the level is not used.
+ */
+bool compute_level_features
+(
+    const std::vector<unsigned char>& orientations,
+    const std::vector<float>&         magnitudes,
+    int                               num_rows,
+    int                               num_cols,
+    int                               bin_size,
+    int&                              out_num_rows,
+    int&                              out_num_cols,
+    std::vector<float>&               features
+)
+{
+    const int NF = Hog_pyramid::NUM_FEATURES;
+    int       blocks[ 2 ];
+    int       visible[ 2 ];
+
+    if (num_rows < 3 || num_cols < 3) return false;
+
+    blocks[ 0 ] = (int)round((double)num_rows / (double)bin_size);
+    blocks[ 1 ] = (int)round((double)num_cols / (double)bin_size);
+    out_num_rows = blocks[ 0 ] - 2;
+    out_num_cols = blocks[ 1 ] - 2;
+
+    if (out_num_rows < 1 || out_num_cols < 1) return false;
+
+    visible[ 0 ] = blocks[ 0 ] * bin_size;
+    visible[ 1 ] = blocks[ 1 ] * bin_size;
+
+    // Interpolation cell and weight of each pixel column, and row.
+    std::vector<int>    ixp(visible[ 1 ]);
+    std::vector<double> vx0(visible[ 1 ]);
+    std::vector<int>    iyp(visible[ 0 ]);
+    std::vector<double> vy0(visible[ 0 ]);
+
+    for (int x = 0; x < visible[ 1 ]; x++)
+    {
+        double xp = ((double)x + 0.5) / (double)bin_size - 0.5;
+        ixp[ x ] = (int)std::floor(xp);
+        vx0[ x ] = xp - ixp[ x ];
+    }
+    for (int y = 0; y < visible[ 0 ]; y++)
+    {
+        double yp = ((double)y + 0.5) / (double)bin_size - 0.5;
+        iyp[ y ] = (int)std::floor(yp);
+        vy0[ y ] = yp - iyp[ y ];
+    }
+
+    // Histograms are cell major: the 18 orientations of a cell are adjacent.
+    std::vector<float> hist(blocks[ 0 ] * blocks[ 1 ] * 18, 0.0f);
+
+    for (int y = 1; y < visible[ 0 ] - 1; y++)
+    {
+        const int    gy    = std::min(y, num_rows - 2);
+        const int    iy    = iyp[ y ];
+        const double wy0   = vy0[ y ];
+        const double wy1   = 1.0 - wy0;
+        const bool   top   = iy >= 0;
+        const bool   below = iy + 1 < blocks[ 0 ];
+        float*       row0  = &hist[ 0 ] + iy * blocks[ 1 ] * 18;
+        float*       row1  = row0 + blocks[ 1 ] * 18;
+
+        for (int x = 1; x < visible[ 1 ] - 1; x++)
+        {
+            const int    gx  = std::min(x, num_cols - 2);
+            const int    o   = orientations[ gy * num_cols + gx ];
+            const double v   = magnitudes[ gy * num_cols + gx ];
+            const int    ix  = ixp[ x ];
+            const double wx0 = vx0[ x ];
+            const double wx1 = 1.0 - wx0;
+
+            if (ix >= 0 && top)
+            {
+                row0[ ix * 18 + o ] += wx1 * wy1 * v;
+            }
+            if (ix + 1 < blocks[ 1 ] && top)
+            {
+                row0[ (ix + 1) * 18 + o ] += wx0 * wy1 * v;
+            }
+            if (ix >= 0 && below)
+            {
+                row1[ ix * 18 + o ] += wx1 * wy0 * v;
+            }
+            if (ix + 1 < blocks[ 1 ] && below)
+            {
+                row1[ (ix + 1) * 18 + o ] += wx0 * wy0 * v;
+            }
+        }
+    }
+
+    // Energy of each cell, summing opposite orientations.
+    std::vector<float> norm(blocks[ 0 ] * blocks[ 1 ], 0.0f);
+
+    for (size_t b = 0; b < norm.size(); b++)
+    {
+        const float* h = &hist[ b * 18 ];
+
+        for (int o = 0; o < 9; o++)
+        {
+            norm[ b ] += (h[ o ] + h[ o + 9 ]) * (h[ o ] + h[ o + 9 ]);
+        }
+    }
+
+    // Inverse norm of each 2x2 block of cells; each is used by 4 cells.
+    const int          nb_cols = blocks[ 1 ] - 1;
+    std::vector<float> block_norm((blocks[ 0 ] - 1) * nb_cols);
+
+    for (int y = 0; y < blocks[ 0 ] - 1; y++)
+    {
+        for (int x = 0; x < nb_cols; x++)
+        {
+            const float* p = &norm[ y * blocks[ 1 ] + x ];
+
+            block_norm[ y * nb_cols + x ] = 1.0 / std::sqrt(
+                            *p + *(p + blocks[ 1 ]) + *(p + 1)
+                               + *(p + blocks[ 1 ] + 1) + HOG_NORM_EPSILON);
+        }
+    }
+
+    features.resize(out_num_rows * out_num_cols * NF);
+
+    for (int y = 0; y < out_num_rows; y++)
+    {
+        for (int x = 0; x < out_num_cols; x++)
+        {
+            float*       dst = &features[ (y * out_num_cols + x) * NF ];
+            const float* src = &hist[ ((y + 1) * blocks[ 1 ] + x + 1) * 18 ];
+            const float  n1  = block_norm[ (y + 1) * nb_cols + x + 1 ];
+            const float  n2  = block_norm[ y * nb_cols + x + 1 ];
+            const float  n3  = block_norm[ (y + 1) * nb_cols + x ];
+            const float  n4  = block_norm[ y * nb_cols + x ];
+            float        t1  = 0;
+            float        t2  = 0;
+            float        t3  = 0;
+            float        t4  = 0;
+
+            // contrast-sensitive features
+            for (int o = 0; o < 18; o++)
+            {
+                float h1 = std::min(src[ o ] * n1, 0.2f);
+                float h2 = std::min(src[ o ] * n2, 0.2f);
+                float h3 = std::min(src[ o ] * n3, 0.2f);
+                float h4 = std::min(src[ o ] * n4, 0.2f);
+                dst[ o ] = 0.5 * (h1 + h2 + h3 + h4);
+                t1 += h1;
+                t2 += h2;
+                t3 += h3;
+                t4 += h4;
+            }
+
+            // contrast-insensitive features
+            for (int o = 0; o < 9; o++)
+            {
+                float sum = src[ o ] + src[ o + 9 ];
+                float h1 = std::min(sum * n1, 0.2f);
+                float h2 = std::min(sum * n2, 0.2f);
+                float h3 = std::min(sum * n3, 0.2f);
+                float h4 = std::min(sum * n4, 0.2f);
+                dst[ 18 + o ] = 0.5 * (h1 + h2 + h3 + h4);
+            }
+
+            // texture features
+            dst[ 27 ] = 0.2357 * t1;
+            dst[ 28 ] = 0.2357 * t2;
+            dst[ 29 ] = 0.2357 * t3;
+            dst[ 30 ] = 0.2357 * t4;
+
+            // truncation feature
+            dst[ 31 ] = 0;
+        }
+    }
+
+    return true;
+}
+
+} // anonymous namespace
+
+/* \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ */
+
+Hog_pyramid::Hog_pyramid
+(
+    const Image& img,
+    int bin_size,
+    int interval,
+    size_t num_threads
+) :
+    m_bin_size(bin_size),
+    m_interval(interval),
+    m_image_num_rows(img.get_num_rows()),
+    m_image_num_cols(img.get_num_cols())
+{
+    IFT(bin_size >= 2, Illegal_argument, "HOG bin size must be at least 2.");
+    IFT(interval >= 1, Illegal_argument, "HOG interval must be at least 1.");
+
+    const int n = m_image_num_rows * m_image_num_cols;
+
+    m_planes.resize(3 * n);
+    for (int r = 0; r < m_image_num_rows; r++)
+    {
+        for (int c = 0; c < m_image_num_cols; c++)
+        {
+            const int i = r * m_image_num_cols + c;
+
+            m_planes[ i ]         = img(r, c, 0);
+            m_planes[ n + i ]     = img(r, c, 1);
+            m_planes[ 2 * n + i ] = img(r, c, 2);
+        }
+    }
+
+    // Each scale of the first octave, with the octaves below it, is
+    // independent of the others.
+    m_scale_levels.resize(interval);
+
+    size_t nt = num_threads;
+    if (nt == 0)
+    {
+        nt = boost::thread::hardware_concurrency();
+    }
+    if (nt > (size_t)interval)
+    {
+        nt = interval;
+    }
+
+    if (nt <= 1)
+    {
+        for (int i = 0; i < interval; i++)
+        {
+            compute_scale_(i);
+        }
+    }
+    else
+    {
+        boost::thread_group thrds;
+        for (size_t t = 0; t < nt; t++)
+        {
+            thrds.create_thread(boost::bind(
+                        &Hog_pyramid::compute_scales_, this, t, nt));
+        }
+        thrds.join_all();
+    }
+
+    std::vector<float>().swap(m_planes);
+
+    // Part levels first, then the root levels, octave by octave. A scale
+    // runs out of levels no later than the smaller scales after it.
+    for (int i = 0; i < interval && !m_scale_levels[ i ].empty(); i++)
+    {
+        m_levels.push_back(Level());
+        std::swap(m_levels.back(), m_scale_levels[ i ][ 0 ]);
+    }
+
+    for (size_t k = 1; ; k++)
+    {
+        int i;
+
+        for (i = 0; i < interval && m_scale_levels[ i ].size() > k; i++)
+        {
+            m_levels.push_back(Level());
+            std::swap(m_levels.back(), m_scale_levels[ i ][ k ]);
+        }
+
+        if (i < interval) break;
+    }
+
+    m_scale_levels.clear();
+}
+
+/* \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ */
+
+void Hog_pyramid::compute_scales_(size_t first, size_t step)
+{
+    for (size_t i = first; i < (size_t)m_interval; i += step)
+    {
+        compute_scale_(i);
+    }
+}
+
+/* \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ */
+
+void Hog_pyramid::compute_scale_(size_t scale_index)
+{
+    const double factor = std::pow(2.0, (double)scale_index / m_interval);
+
+    std::vector<Level>&        levels = m_scale_levels[ scale_index ];
+    std::vector<float>         planes;
+    std::vector<float>         halved;
+    std::vector<unsigned char> orientations;
+    std::vector<float>         magnitudes;
+    int                        num_rows;
+    int                        num_cols;
+    Level                      level;
+
+    num_rows = std::max(1, (int)round(m_image_num_rows / factor));
+    num_cols = std::max(1, (int)round(m_image_num_cols / factor));
+
+    if (scale_index == 0)
+    {
+        planes = m_planes;
+    }
+    else
+    {
+        resample_planes(m_planes, m_image_num_rows, m_image_num_cols,
+                        planes, num_rows, num_cols);
+    }
+
+    compute_gradients(planes, num_rows, num_cols, orientations, magnitudes);
+
+    // Part level: the same gradients, binned into half size cells.
+    if ( ! compute_level_features(orientations, magnitudes, num_rows, num_cols,
+                                  m_bin_size / 2, level.num_rows,
+                                  level.num_cols, level.features))
+    {
+        return;
+    }
+    level.cell_size = (m_bin_size / 2) * factor;
+    levels.push_back(level);
+
+    for (double cell_size = m_bin_size * factor; ; cell_size *= 2.0)
+    {
+        if ( ! compute_level_features(orientations, magnitudes, num_rows,
+                                      num_cols, m_bin_size, level.num_rows,
+                                      level.num_cols, level.features))
+        {
+            break;
+        }
+        level.cell_size = cell_size;
+        levels.push_back(level);
+
+        // Next octave.
+        int new_num_rows = std::max(1, (int)round(num_rows / 2.0));
+        int new_num_cols = std::max(1, (int)round(num_cols / 2.0));
+
+        resample_planes(planes, num_rows, num_cols,
+                        halved, new_num_rows, new_num_cols);
+        planes.swap(halved);
+        num_rows = new_num_rows;
+        num_cols = new_num_cols;
+
+        compute_gradients(planes, num_rows, num_cols,
+                          orientations, magnitudes);
+    }
+}
@@ -0,0 +1,143 @@
+/* $Id$ */
+/* =========================================================================== *
+   |
+   |  Copyright (c) 1994-2010 by Kobus Barnard (author)
+   |
+   |  Personal and educational use of this code is granted, provided that this
+   |  header is kept intact, and that the authorship is not misrepresented, that
+   |  its use is acknowledged in publications, and relevant papers are cited.
+   |
+   |  For other use contact the author (kobus AT cs DOT arizona DOT edu).
+   |
+   |  Please note that the code in this file has not necessarily been adequately
+   |  tested. Naturally, there is no guarantee of performance, support, or fitness
+   |  for any particular task. Nonetheless, I am interested in hearing about
+   |  problems that you encounter.
+   |
+ * =========================================================================== */
+
+#ifndef KJB_CPP_EDGE_HOG_PYRAMID_H
+#define KJB_CPP_EDGE_HOG_PYRAMID_H
+
+#include <i_cpp/i_image.h>
+
+#include <vector>
+
+namespace kjb
+{
+
+/**
+ * @brief   Multi-scale HOG features of an image.
+ *
+ * The features are the same 32 dimensional (Felzenszwalb style) features as
+ * those of Hog_responses: 18 contrast sensitive and 9 contrast insensitive
+ * orientations, 4 texture features and a truncation feature (always 0).
+ *
+ * Levels are ordered as in the deformable parts model. With
+ * <tt>s = 2^(1/interval)</tt>, level <tt>i < interval</tt> is computed from
+ * the image scaled by <tt>s^-i</tt> with cells of half the bin size (the part
+ * levels), and level <tt>i + k*interval</tt>, for <tt>k >= 1</tt>, from the
+ * same image halved <tt>k - 1</tt> times, with the full bin size. Each scaled
+ * image has its gradients computed once, and they are binned for both cell
+ * sizes; each octave is obtained by halving the one above it rather than by
+ * resampling the input again.
+ *
+ * The features of a level are stored contiguously, cell by cell (row major),
+ * with the 32 features of a cell next to each other, which is the layout
+ * used by Hog_responses::get_hog_responses().
+ */
+class Hog_pyramid
+{
+public:
+    /** @brief Number of features per cell. */
+    static const int NUM_FEATURES = 32;
+
+    /**
+     * @brief   Computes the pyramid of an image.
+     *
+     * @param   img          The image.
+     * @param   bin_size     Cell size (in pixels) of the root levels; the part
+     *                       levels use half of it. Must be at least 2.
+     * @param   interval     Number of levels per octave.
+     * @param   num_threads  Number of threads to use. If 0, use the number of
+     *                       hardware threads available.
+     */
+    Hog_pyramid
+    (
+        const Image& img,
+        int bin_size = 8,
+        int interval = 10,
+        size_t num_threads = 1
+    );
+
+    /** @brief Number of levels. */
+    size_t size() const { return m_levels.size(); }
+
+    /** @brief Number of rows of cells of a level. */
+    int get_num_rows(size_t level) const { return m_levels[level].num_rows; }
+
+    /** @brief Number of columns of cells of a level. */
+    int get_num_cols(size_t level) const { return m_levels[level].num_cols; }
+
+    /**
+     * @brief   Size of a cell of a level, in pixels of the input image.
+     *
+     * Feature cell <tt>(r, c)</tt> of a level covers the input rows from
+     * <tt>(r + 1) * get_cell_size(level)</tt> up to
+     * <tt>(r + 2) * get_cell_size(level)</tt>, and likewise for columns, as
+     * the features skip the border cells of the histograms.
+     */
+    double get_cell_size(size_t level) const
+    {
+        return m_levels[level].cell_size;
+    }
+
+    /** @brief Features of a level; see the class documentation. */
+    const float* get_features(size_t level) const
+    {
+        return m_levels[level].features.empty()
+                ? 0 : &m_levels[level].features[0];
+    }
+
+    /** @brief Features of cell <tt>(row, col)</tt> of a level. */
+    const float* get_features(size_t level, int row, int col) const
+    {
+        return get_features(level)
+                + (row * m_levels[level].num_cols + col) * NUM_FEATURES;
+    }
+
+    int get_bin_size() const { return m_bin_size; }
+
+    int get_interval() const { return m_interval; }
+
+    /** @brief Number of rows of the image. */
+    int get_image_num_rows() const { return m_image_num_rows; }
+
+    /** @brief Number of columns of the image. */
+    int get_image_num_cols() const { return m_image_num_cols; }
+
+private:
+    struct Level
+    {
+        int num_rows;
+        int num_cols;
+        double cell_size;
+        std::vector<float> features;
+    };
+
+    void compute_scales_(size_t first, size_t step);
+
+    void compute_scale_(size_t scale_index);
+
+    int m_bin_size;
+    int m_interval;
+    int m_image_num_rows;
+    int m_image_num_cols;
+    std::vector<float> m_planes;
+    std::vector<std::vector<Level> > m_scale_levels;
+    std::vector<Level> m_levels;
+};
+
+} // namespace kjb
+
+#endif
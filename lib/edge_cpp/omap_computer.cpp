@@ -16,10 +16,410 @@ omap_computer is the base for all the functions under compute_omap.m
 #include <string>
 #include <sstream>
 #include <iostream>
+#include <algorithm>
+
+#include <boost/thread.hpp>
+#include <boost/bind.hpp>
 
 using namespace kjb;
 using namespace std;
 
+namespace
+{
+
+/*
+    Where the lines toward vp meet in the image plane. Vanishing points at
+    infinity are put very far away in their direction.
+*/
+void get_vp_location
+(
+    const Vanishing_point & vp,
+    int imgheight,
+    int imgwidth,
+    double * x,
+    double * y
+)
+{
+    *x = vp.get_x();
+    *y = vp.get_y();
+    if(vp.is_at_infinity())
+    {
+        if(vp.get_type() == Vanishing_point::INFINITY_UP)
+        {
+            *x = imgwidth/2.0;
+            *y = -100000000;
+        }
+        else if(vp.get_type() == Vanishing_point::INFINITY_DOWN)
+        {
+            *x = imgwidth/2.0;
+            *y = 100000000;
+        }
+        else if(vp.get_type() == Vanishing_point::INFINITY_RIGHT)
+        {
+            *y = imgheight/2.0;
+            *x = 100000000;
+        }
+        else if(vp.get_type() == Vanishing_point::INFINITY_LEFT)
+        {
+            *y = imgheight/2.0;
+            *x = -100000000;
+        }
+    }
+}
+
+/* The end points of a line. */
+struct Omap_line
+{
+    double sx, sy, ex, ey;
+};
+
+/* Everything the threads extending the lines read. */
+struct Omap_sweep_input
+{
+    std::vector<Omap_line> lines[4];   // by line class, 1-3
+    std::vector<double> samples[4];    // by line class, 1-3, as x,y pairs
+    double vpx[4];
+    double vpy[4];
+    int imgheight;
+    int imgwidth;
+    size_t row_words;
+};
+
+/*
+    Same as Omap_computer::move_line_towards_vp(), on plain doubles. Moves
+    (p1, p2) by amount toward (vx, vy), giving the new points in q[0..3].
+    Returns true, without moving, if the line would reach the vanishing point.
+*/
+bool move_towards_vp
+(
+    double p1x, double p1y,
+    double p2x, double p2y,
+    double vx, double vy,
+    double amount,
+    double * q
+)
+{
+    double n1 = std::sqrt((vx-p1x)*(vx-p1x) + (vy-p1y)*(vy-p1y));
+    double n2 = std::sqrt((vx-p2x)*(vx-p2x) + (vy-p2y)*(vy-p2y));
+    if(n1 == 0){ n1 = 1; }
+    if(n2 == 0){ n2 = 1; }
+
+    if(n1 <= amount)
+    {
+        return true;
+    }
+
+    double ratio21 = n2/n1;
+    q[0] = p1x + (vx-p1x)/n1*amount;
+    q[1] = p1y + (vy-p1y)/n1*amount;
+    q[2] = p2x + (vx-p2x)/n2*amount*ratio21;
+    q[3] = p2y + (vy-p2y)/n2*amount*ratio21;
+    return false;
+}
+
+/*
+    Whether (x, y) is in, or on the border of, a convex quadrilateral given as
+    4 x,y pairs in cyclic order.
+*/
+bool is_in_convex_quad(const double * quad, double x, double y)
+{
+    double xmin = quad[0], xmax = quad[0];
+    double ymin = quad[1], ymax = quad[1];
+    for(int i = 1; i < 4; i++)
+    {
+        xmin = std::min(xmin, quad[2*i]);
+        xmax = std::max(xmax, quad[2*i]);
+        ymin = std::min(ymin, quad[2*i + 1]);
+        ymax = std::max(ymax, quad[2*i + 1]);
+    }
+    if(x < xmin || x > xmax || y < ymin || y > ymax)
+    {
+        return false;
+    }
+
+    bool left = false;
+    bool right = false;
+    for(int i = 0; i < 4; i++)
+    {
+        const double * a = quad + 2*i;
+        const double * b = quad + 2*((i + 1) % 4);
+        double det = (b[0]-a[0])*(y-a[1]) - (x-a[0])*(b[1]-a[1]);
+        if(det > 0){ left = true; }
+        else if(det < 0){ right = true; }
+    }
+    return !(left && right);
+}
+
+/*
+    Extends line toward (toward_or_away = 1) or away from (-1) the vanishing
+    point at (vx, vy), halving the step every time it leaves the image, hits
+    the vanishing point or sweeps over one of samples. The swept region is
+    returned in quad as [p1; p2; moved p2; moved p1]. Since both end points
+    move by the same fraction of their distance to the vanishing point, it is
+    a trapezoid.
+*/
+void extend_line
+(
+    const Omap_line & line,
+    double vx,
+    double vy,
+    int toward_or_away,
+    const std::vector<double> & samples,
+    int imgheight,
+    int imgwidth,
+    double * quad
+)
+{
+    double start[2] = { line.sx, line.sy };
+    double end[2] = { line.ex, line.ey };
+    double moved[4];
+
+    int move_amount = 128;
+    size_t startchecking = 0;
+    const size_t num_samples = samples.size()/2;
+
+    quad[0] = line.sx;
+    quad[1] = line.sy;
+    quad[2] = line.ex;
+    quad[3] = line.ey;
+
+    while(move_amount >= 1)
+    {
+        bool failed = move_towards_vp(start[0], start[1], end[0], end[1],
+                                      vx, vy, toward_or_away * move_amount,
+                                      moved);
+
+        if(!failed)
+        {
+            failed = moved[0] > imgwidth || moved[0] < 1 ||
+                     moved[1] > imgheight || moved[1] < 1 ||
+                     moved[2] > imgwidth || moved[2] < 1 ||
+                     moved[3] > imgheight || moved[3] < 1;
+        }
+
+        if(!failed)
+        {
+            quad[4] = moved[2];
+            quad[5] = moved[3];
+            quad[6] = moved[0];
+            quad[7] = moved[1];
+
+            // Samples before the last hit are not checked again.
+            for(size_t i = startchecking; i < num_samples; i++)
+            {
+                if(is_in_convex_quad(quad, samples[2*i], samples[2*i + 1]))
+                {
+                    failed = true;
+                    startchecking = i;
+                    break;
+                }
+            }
+        }
+
+        if(failed)
+        {
+            move_amount = move_amount/2;
+        }
+        else
+        {
+            start[0] = moved[0];
+            start[1] = moved[1];
+            end[0] = moved[2];
+            end[1] = moved[3];
+        }
+    }
+
+    quad[4] = end[0];
+    quad[5] = end[1];
+    quad[6] = start[0];
+    quad[7] = start[1];
+}
+
+/* Sets bits first to last (inclusive) of a bitmap row. */
+inline void set_bits(uint64_t * row, size_t first, size_t last)
+{
+    const size_t w0 = first/64;
+    const size_t w1 = last/64;
+    const uint64_t m0 = ~uint64_t(0) << (first % 64);
+    const uint64_t m1 = ~uint64_t(0) >> (63 - last % 64);
+
+    if(w0 == w1)
+    {
+        row[w0] |= m0 & m1;
+        return;
+    }
+
+    row[w0] |= m0;
+    for(size_t w = w0 + 1; w < w1; w++)
+    {
+        row[w] = ~uint64_t(0);
+    }
+    row[w1] |= m1;
+}
+
+/*
+    Extends the lines of classes first, first + step, ... (of 1-3) into their
+    bitmaps. Each class has its own bitmaps, so threads need no locking.
+*/
+void sweep_line_classes
+(
+    std::vector<std::vector<uint64_t> > & bitmaps,
+    const Omap_sweep_input & in,
+    int first,
+    int step
+)
+{
+    double quad[8];
+
+    for(int lc = first; lc <= 3; lc += step)
+    {
+        //extdir = setdiff(1:3, lc)
+        int extdir[2];
+        int n = 0;
+        for(int d = 1; d <= 3; d++)
+        {
+            if(d != lc){ extdir[n++] = d; }
+        }
+
+        const std::vector<Omap_line> & lines = in.lines[lc];
+        for(size_t i = 0; i < lines.size(); i++)
+        {
+            for(int j = 0; j < 2; j++)
+            {
+                int targetdir = extdir[j];
+                int cextdir = extdir[1 - j]; // current extdir
+                size_t index = (3*(lc-1) + (cextdir-1))*2;
+
+                extend_line(lines[i], in.vpx[cextdir], in.vpy[cextdir], 1,
+                            in.samples[targetdir], in.imgheight, in.imgwidth,
+                            quad);
+                scanline_fill_polygon(bitmaps[index], in.row_words, quad, 4,
+                                      in.imgheight, in.imgwidth);
+
+                extend_line(lines[i], in.vpx[cextdir], in.vpy[cextdir], -1,
+                            in.samples[targetdir], in.imgheight, in.imgwidth,
+                            quad);
+                scanline_fill_polygon(bitmaps[index + 1], in.row_words,
+                                      quad, 4, in.imgheight, in.imgwidth);
+            }
+        }
+    }
+}
+
+/* Matrix of the bits of a bitmap, with 1 for set pixels. */
+Matrix bitmap_to_matrix
+(
+    const std::vector<uint64_t> & bitmap,
+    size_t row_words,
+    int imgheight,
+    int imgwidth
+)
+{
+    Matrix m(imgheight, imgwidth, 0.0);
+    for(int r = 0; r < imgheight; r++)
+    {
+        const uint64_t * row = &bitmap[r*row_words];
+        for(int c = 0; c < imgwidth; c++)
+        {
+            if((row[c/64] >> (c % 64)) & 1)
+            {
+                m(r, c) = 1.0;
+            }
+        }
+    }
+    return m;
+}
+
+} // anonymous namespace
+
+void kjb::scanline_fill_polygon
+(
+    std::vector<uint64_t> & bitmap,
+    size_t row_words,
+    const double * poly,
+    size_t num_vertices,
+    int imgheight,
+    int imgwidth
+)
+{
+    if(num_vertices == 0) return;
+
+    double ymin = poly[1];
+    double ymax = poly[1];
+    for(size_t i = 1; i < num_vertices; i++)
+    {
+        ymin = std::min(ymin, poly[2*i + 1]);
+        ymax = std::max(ymax, poly[2*i + 1]);
+    }
+
+    const int r0 = (int)std::max(0.0, std::ceil(ymin));
+    const int r1 = (int)std::min(imgheight - 1.0, std::floor(ymax));
+
+    std::vector<double> crossings;
+    crossings.reserve(num_vertices);
+
+    for(int r = r0; r <= r1; r++)
+    {
+        uint64_t * row = &bitmap[r*row_words];
+        crossings.clear();
+
+        for(size_t i = 0; i < num_vertices; i++)
+        {
+            const double * a = poly + 2*i;
+            const double * b = poly + 2*((i + 1) % num_vertices);
+
+            double xl, xr;
+            if(a[1] == b[1])
+            {
+                if(a[1] != r) continue;
+                xl = std::min(a[0], b[0]);
+                xr = std::max(a[0], b[0]);
+            }
+            else
+            {
+                if(r < std::min(a[1], b[1]) || r > std::max(a[1], b[1]))
+                {
+                    continue;
+                }
+
+                double x = a[0] + (r - a[1])*(b[0] - a[0])/(b[1] - a[1]);
+
+                // Each edge counts for the rows from its lower end up to,
+                // but not including, its upper end, so that a vertex
+                // between two edges is crossed once and a peak not at all.
+                if((a[1] <= r) != (b[1] <= r))
+                {
+                    crossings.push_back(x);
+                }
+                xl = x;
+                xr = x;
+            }
+
+            // the border itself
+            const double c0 = std::max(0.0, std::ceil(xl));
+            const double c1 = std::min(imgwidth - 1.0, std::floor(xr));
+            if(c0 <= c1)
+            {
+                set_bits(row, (size_t)c0, (size_t)c1);
+            }
+        }
+
+        // the inside, between alternate crossings of the row
+        std::sort(crossings.begin(), crossings.end());
+        for(size_t i = 0; i + 1 < crossings.size(); i += 2)
+        {
+            const double c0 = std::max(0.0, std::ceil(crossings[i]));
+            const double c1 = std::min(imgwidth - 1.0,
+                                       std::floor(crossings[i + 1]));
+            if(c0 <= c1)
+            {
+                set_bits(row, (size_t)c0, (size_t)c1);
+            }
+        }
+    }
+}
+
+
 Omap_computer::Omap_computer
 (
     const char* linepath,
@@ -176,110 +576,89 @@ Return type will change when I figure out what it's supposed to be.
 void Omap_computer::compute_omap
 (
     Image & out_omap,
-    Orientation_map_type omap_type
+    Orientation_map_type omap_type,
+    size_t num_threads
 )
 {
-    cout << "Starting compute_omap()...\n";
-    int height=3;
-    int width=3;
-    int depth=2;
-    
-    lineextimg.resize(height);
-    for(int i = 0; i< height; i++){
-        lineextimg[i].resize(width);
-        for(int j=0;j<width;j++){
-            lineextimg[i][j].resize(depth);
-            for(int k=0;k<depth;k++){
-                lineextimg[i][j][k] = Matrix(imageheight,imagewidth,0.0);
-            }
-        }
-    }
+    row_words = (imagewidth + 63)/64;
+    lineextimg.assign(3*3*2, std::vector<uint64_t>(imageheight*row_words, 0));
 
 /***************************************************************************/
-    orient_from_lines();
+    orient_from_lines(num_threads);
 /***************************************************************************/
 
-    Matrix ao23 = logical_or(lineextimg[1][2][0],lineextimg[1][2][1]);
-    Matrix ao32 = logical_or(lineextimg[2][1][0],lineextimg[2][1][1]);
-    Matrix ao13 = logical_or(lineextimg[0][2][0],lineextimg[0][2][1]);
-    Matrix ao31 = logical_or(lineextimg[2][0][0],lineextimg[2][0][1]);
-    Matrix ao12 = logical_or(lineextimg[0][1][0],lineextimg[0][1][1]);
-    Matrix ao21 = logical_or(lineextimg[1][0][0],lineextimg[1][0][1]);
-
-    Matrix aa23 = logical_and(lineextimg[1][2][0],lineextimg[1][2][1]);
-    Matrix aa32 = logical_and(lineextimg[2][1][0],lineextimg[2][1][1]);
-    Matrix aa13 = logical_and(lineextimg[0][2][0],lineextimg[0][2][1]);
-    Matrix aa31 = logical_and(lineextimg[2][0][0],lineextimg[2][0][1]);
-    Matrix aa12 = logical_and(lineextimg[0][1][0],lineextimg[0][1][1]);
-    Matrix aa21 = logical_and(lineextimg[1][0][0],lineextimg[1][0][1]);
-
-    std::vector<Matrix> a;
-    a.push_back(logical_and(ao23,ao32));
-    a.push_back(logical_and(ao13,ao31));
-    a.push_back(logical_and(ao12,ao21));
-
-    std::vector<Matrix> b;
-
-    cout << " creating b...\n";
-    b.push_back(logical_and(a[0],logical_and(logical_not(a[1]),logical_not(a[2]))));    
-    b.push_back(logical_and(logical_not(a[0]),logical_and(a[1],logical_not(a[2]))));    
-    b.push_back(logical_and(logical_not(a[0]),logical_and(logical_not(a[1]),a[2])));    
-
-    cout << " making the omaps\n ";
-    if(omap_type == OMAP_LOOSE)
+    if(omap_type != OMAP_LOOSE && omap_type != OMAP_VERY_STRICT
+        && omap_type != OMAP_STRICT)
     {
-        if(using_featman_lines == true)
-        {
-            compute_tricolor_image(out_omap, b[2], b[1], b[0]);
-        }
-        else
-        {
-            compute_tricolor_image(out_omap, b[0], b[1], b[2]);
-        }
+        return;
     }
 
-    //omapstrict1
-    
-    a[0] = logical_and(aa23,aa32);
-    a[1] = logical_and(aa13,aa31);
-    a[2] = logical_and(aa12,aa21);
-
-    b[0] = logical_and(a[0],logical_and(logical_not(a[1]),logical_not(a[2])));
-    b[1] = logical_and(logical_not(a[0]),logical_and(a[1],logical_not(a[2])));
-    b[2] = logical_and(logical_not(a[0]),logical_and(logical_not(a[1]),a[2]));
+    // ao: extended toward or away from the vp; aa: both.
+    // lineextimg[(3*(i-1) + (j-1))*2 + side] is the region of class i toward/away from vp j.
+    const std::vector<std::vector<uint64_t> > & e = lineextimg;
+    const size_t num_words = imageheight*row_words;
+    std::vector<uint64_t> b0(num_words);
+    std::vector<uint64_t> b1(num_words);
+    std::vector<uint64_t> b2(num_words);
 
-    if(omap_type == OMAP_VERY_STRICT)
+    for(size_t k = 0; k < num_words; k++)
     {
-        if(using_featman_lines == true)
+        uint64_t ao12 = e[2][k] | e[3][k];
+        uint64_t ao13 = e[4][k] | e[5][k];
+        uint64_t ao21 = e[6][k] | e[7][k];
+        uint64_t ao23 = e[10][k] | e[11][k];
+        uint64_t ao31 = e[12][k] | e[13][k];
+        uint64_t ao32 = e[14][k] | e[15][k];
+
+        uint64_t aa12 = e[2][k] & e[3][k];
+        uint64_t aa13 = e[4][k] & e[5][k];
+        uint64_t aa21 = e[6][k] & e[7][k];
+        uint64_t aa23 = e[10][k] & e[11][k];
+        uint64_t aa31 = e[12][k] & e[13][k];
+        uint64_t aa32 = e[14][k] & e[15][k];
+
+        uint64_t a0, a1, a2;
+        if(omap_type == OMAP_LOOSE)
         {
-            compute_tricolor_image(out_omap, b[2], b[0], b[1]);
+            a0 = ao23 & ao32;
+            a1 = ao13 & ao31;
+            a2 = ao12 & ao21;
+        }
+        else if(omap_type == OMAP_VERY_STRICT)
+        {
+            //omapstrict1
+            a0 = aa23 & aa32;
+            a1 = aa13 & aa31;
+            a2 = aa12 & aa21;
         }
         else
         {
-            compute_tricolor_image(out_omap, b[0], b[1], b[2]);
+            //omapstrict2 (a2 uses aa32, as it always has)
+            a0 = (ao23 & aa32) | (aa23 & ao32);
+            a1 = (ao13 & aa31) | (aa13 & ao31);
+            a2 = (ao12 & aa32) | (aa12 & ao21);
         }
-    }
 
-    //omapstrict2
+        b0[k] = a0 & ~a1 & ~a2;
+        b1[k] = ~a0 & a1 & ~a2;
+        b2[k] = ~a0 & ~a1 & a2;
+    }
 
-    a[0] = logical_or(logical_and(ao23,aa32),logical_and(aa23,ao32));
-    a[1] = logical_or(logical_and(ao13,aa31),logical_and(aa13,ao31));
-    a[2] = logical_or(logical_and(ao12,aa32),logical_and(aa12,ao21));
-    
-    b[0] = logical_and(a[0],logical_and(logical_not(a[1]),logical_not(a[2])));
-    b[1] = logical_and(logical_not(a[0]),logical_and(a[1],logical_not(a[2])));
-    b[2] = logical_and(logical_not(a[0]),logical_and(logical_not(a[1]),a[2]));
+    Matrix m0 = bitmap_to_matrix(b0, row_words, imageheight, imagewidth);
+    Matrix m1 = bitmap_to_matrix(b1, row_words, imageheight, imagewidth);
+    Matrix m2 = bitmap_to_matrix(b2, row_words, imageheight, imagewidth);
 
-    if(omap_type == OMAP_STRICT)
+    if(using_featman_lines == false)
     {
-        if(using_featman_lines == true)
-        {
-            compute_tricolor_image(out_omap, b[2], b[0], b[1]);
-        }
-        else
-        {
-            compute_tricolor_image(out_omap, b[0], b[1], b[2]);
-        }
+        compute_tricolor_image(out_omap, m0, m1, m2);
+    }
+    else if(omap_type == OMAP_LOOSE)
+    {
+        compute_tricolor_image(out_omap, m2, m1, m0);
+    }
+    else
+    {
+        compute_tricolor_image(out_omap, m2, m0, m1);
     }
 }
 /*
@@ -288,44 +667,69 @@ Description goes here
 nope - goes in the .h
 ======================================================================================
 */
-vector<vector<vector<Matrix> > > Omap_computer::orient_from_lines(){
-
-    cout << "Extending " << lines.size() << " lines...\n";
-    /*****************************************************************************/
-    Image tehim(imageheight,imagewidth,0,0,0);
-    Matrix mask = create_zero_matrix(imageheight,imagewidth);
+void Omap_computer::orient_from_lines(size_t num_threads)
+{
+    // Copy what the threads need out of the Vector-based members, since
+    // kjb::Vector allocation is not thread safe.
+    Omap_sweep_input in;
+    in.imgheight = imageheight;
+    in.imgwidth = imagewidth;
+    in.row_words = row_words;
+    in.vpx[0] = in.vpy[0] = 0.0;
+
+    for(int vp = 1; vp <= 3; vp++)
+    {
+        get_vp_location(vpts[vp], imageheight, imagewidth, &in.vpx[vp], &in.vpy[vp]);
 
-    for(unsigned i = 0; i<lines.size(); i++){
-        cout << "line #" << i << ": " << lines[i].get_lineclass() << ", " ;
-        cout.flush();
+        const std::vector<kjb::Vector> & samples = (vp == 1) ? samples_at_1 :
+                                                   (vp == 2) ? samples_at_2 :
+                                                               samples_at_3;
+        in.samples[vp].resize(2*samples.size());
+        for(size_t i = 0; i < samples.size(); i++)
+        {
+            in.samples[vp][2*i] = samples[i](0);
+            in.samples[vp][2*i + 1] = samples[i](1);
+        }
+    }
 
+    for(size_t i = 0; i < lines.size(); i++)
+    {
         int lc = lines[i].get_lineclass();
-        //cout << "- " << lc << ", ";
-        std::vector<int> extdir;
-        //extdir = setdiff(1:3, lc)
-        if(lc == 1){ extdir.push_back(2); extdir.push_back(3); }
-        if(lc == 2){ extdir.push_back(1); extdir.push_back(3); }
-        if(lc == 3){ extdir.push_back(1); extdir.push_back(2); }
-
-        for(unsigned j = 0; j<extdir.size(); j++){
-
-            int targetdir;
-            int cextdir;// current extdir
-            if(j==0){ targetdir = extdir[0]; cextdir = extdir[1]; }
-            else{     targetdir = extdir[1]; cextdir = extdir[0]; }  
+        if(lc < 1 || lc > 3) continue;
+
+        Omap_line line;
+        line.sx = lines[i].get_start_x();
+        line.sy = lines[i].get_start_y();
+        line.ex = lines[i].get_end_x();
+        line.ey = lines[i].get_end_y();
+        in.lines[lc].push_back(line);
+    }
 
-            Matrix poly = extend_line(lines[i],vpts[cextdir],1,get_samples_at_vp(targetdir), imageheight,imagewidth); 
-            mask = geometry::polygon_to_mask(poly,imageheight,imagewidth);
-            lineextimg[lc-1][cextdir-1][0] += mask; 
+    size_t nt = num_threads;
+    if(nt == 0)
+    {
+        nt = boost::thread::hardware_concurrency();
+    }
+    if(nt > 3)
+    {
+        nt = 3;
+    }
 
-            poly = extend_line(lines[i],vpts[cextdir], -1,get_samples_at_vp(targetdir), imageheight,imagewidth); 
-            mask = geometry::polygon_to_mask(poly,imageheight,imagewidth);
-        
-            lineextimg[lc-1][cextdir-1][1] +=  mask; 
+    if(nt <= 1)
+    {
+        sweep_line_classes(lineextimg, in, 1, 1);
+    }
+    else
+    {
+        boost::thread_group thrds;
+        for(size_t t = 0; t < nt; t++)
+        {
+            thrds.create_thread(boost::bind(
+                        sweep_line_classes, boost::ref(lineextimg),
+                        boost::cref(in), (int)t + 1, (int)nt));
         }
+        thrds.join_all();
     }
-    cout << "Exiting orient_from_lines\n";  
-    return lineextimg;
 }//end of orient_from_lines()
 
 
@@ -352,31 +756,8 @@ std::vector<double>  Omap_computer::move_line_towards_vp(kjb::Vector p1, kjb::Ve
     double p2y;
     double atvp;
 
-    /** TODO HERE */
-    Vector vp_point(vp.get_x(),vp.get_y());
-    if(vp.is_at_infinity())
-    {
-        if(vp.get_type() == Vanishing_point::INFINITY_UP)
-        {
-            vp_point(0) = imagewidth/2.0;
-            vp_point(1) = -100000000;
-        }
-        else if(vp.get_type() == Vanishing_point::INFINITY_DOWN)
-        {
-            vp_point(0) = imagewidth/2.0;
-            vp_point(1) = 100000000;
-        }
-        else if(vp.get_type() == Vanishing_point::INFINITY_RIGHT)
-        {
-            vp_point(1) = imageheight/2.0;
-            vp_point(0) = 100000000;
-        }
-        else if(vp.get_type() == Vanishing_point::INFINITY_LEFT)
-        {
-            vp_point(1) = imageheight/2.0;
-            vp_point(0) = -100000000;
-        }
-    }
+    Vector vp_point(2);
+    get_vp_location(vp, imageheight, imagewidth, &vp_point(0), &vp_point(1));
 
     double n1 = norm2(vp_point-p1);
     double n2 = norm2(vp_point-p2);
@@ -425,99 +806,6 @@ std::vector<double>  Omap_computer::move_line_towards_vp(kjb::Vector p1, kjb::Ve
 /****************************************************************************************/
 
 /****************************************************************************************/
-Matrix Omap_computer::extend_line(Omap_segment line, Vanishing_point vp, int toward_or_away, std::vector<kjb::Vector> samples, int imgheight, int imgwidth){
-
-    Vector startpt = line.get_start_point();
-    Vector endpt = line.get_end_point();
-    //cout <<"line: (" << startpt(0) << "," << startpt(1) << "),(" << endpt(0) << "," << endpt(1) << ") " ; 
-    //cout << "toward (" << vp.get_x() << "," << vp.get_y() << ")" << endl;
-
-    int move_amount = 128;
-    int failcount = 0;
-    int startchecking = 0; //so that its slightly more efficient going through the potentially very large sample set.
-
-    while(move_amount>=1){
-        
-    //  cout << "Move_amount: " << move_amount << endl; 
-        std::vector<double> movedline = move_line_towards_vp(startpt,endpt,vp,toward_or_away * move_amount);
-    //  cout << "managed to move the line\n";   
-        int failed = 0; 
-        if(movedline[4] ==1){//if atvp ==1
-            //hit the vp
-            failed = 1;
-        }
-
-        else if(movedline[0]>imgwidth || movedline[0]<1 ||
-            movedline[1]>imgheight|| movedline[1]<1 ||
-            movedline[2]>imgwidth || movedline[2]<1 ||
-            movedline[3]>imgheight|| movedline[3]<1){
-            
-            // moved beyond the image
-            failed = 1;
-
-            //cout << "moved beyond the boundaries of the image\n";
-        }
-        else{
-            //isstop = inpolygon(stoppinglines_samples(:,1),stoppinglines_sample(:...
-            //stoppinglines_samples(:,1) = linesamples(linesamplesclass==targetdir,:)
-            //linesamples = cat(1,ls(:).samples)
-            //targetdir = an int 0-2
-
-            //cout << "hit this else thing\n";
-            Matrix region(4,2);
-
-            //p1,2
-            region(0,0) = line.get_start_x();
-            region(0,1) = line.get_start_y(); 
-            region(1,0) = line.get_end_x(); 
-            region(1,1) = line.get_end_y(); 
-            //newp1,2
-            region(2,0) = movedline[2];
-            region(2,1) = movedline[3];
-            region(3,0) = movedline[0];
-            region(3,1) = movedline[1];
-
-            
-            //cout << "checking if the samples are in the polygon\n";   
-            for(unsigned i=startchecking;i<samples.size();i++){
-            //  cout << "sample " << i << ":\n";
-                Vector ref = samples[i];
-                if(kjb::geometry::is_point_in_polygon_new(region,ref)){
-                    //failed polygon check 
-                //  cout << "found a point in the polygon\n";
-                    failed = 1;//exit loop
-                    startchecking = i;
-                    i+=samples.size();
-                }
-            }   
-            //cout << "finished checking if the samples are in the polygon\n";
-        }
-        
-        if(failed == 1){
-            failcount++;
-            move_amount = move_amount/2;
-        }
-        else{
-            startpt = Vector(movedline[0],movedline[1]);
-            endpt = Vector(movedline[2],movedline[3]);
-        }
-    }//end while(move_amount>=1
-
-    //returns - poly = [p1(:)'; p2(:)'; curp2(:)'; curp1(:)'];
-    //where p1 and p2 are the original points and curp1 and 2 are the moved points.
-    Matrix poly = create_zero_matrix(4,2);  
-            poly(0,0) = line.get_start_x();
-            poly(0,1) = line.get_start_y();
-            poly(1,0) = line.get_end_x();
-            poly(1,1) = line.get_end_y(); 
-            poly(2,0) = endpt(0);
-            poly(2,1) = endpt(1); 
-            poly(3,0) = startpt(0);
-            poly(3,1) = startpt(1);
-
-    //cout << "done!\n";
-    return poly;
-}//end extend_line()
 
 std::vector<Omap_segment> Omap_computer::read_matlab_line_file(const char* linepath){
 
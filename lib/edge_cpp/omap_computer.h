@@ -27,6 +27,8 @@ compute_orientationmap
 #include "g/g_geometry.h"
 #include <edge_cpp/features_manager.h>
 
+#include <stdint.h>
+
 namespace kjb
 {
 
@@ -98,7 +100,15 @@ public:
     int imagewidth;
     unsigned numlines;
     std::vector<Omap_segment> lines;    
-    std::vector<std::vector<std::vector<Matrix> > > lineextimg; 
+
+    /*
+        The regions swept by the lines, as bitmaps of one bit per pixel with
+        each row padded to whole words. The region of lines of class lc
+        extended toward (side 0) or away from (side 1) vanishing point ext
+        is lineextimg[(3*(lc-1) + (ext-1))*2 + side].
+    */
+    std::vector<std::vector<uint64_t> > lineextimg; 
+    size_t row_words;
 
     std::vector<Omap_segment> lines_at_1;
     std::vector<Omap_segment> lines_at_2;
@@ -128,14 +138,17 @@ public:
     /*
         orient_from_lines() - Only called once there is a set of lines to orient_from. 
         This function fills in the lineextimg variable. It goes through each line and 
-        tries to see how much area it can describe the orientation of using extend_line().
-        It adds that to a mask, which is layered on top of the appropriate section of 
-        lineextimg. 
+        tries to see how much area it can describe the orientation of by extending it
+        toward and away from the other two vanishing points. An extension stops
+        1) if it goes beyond the edge of the image
+        2) if it hits the vanishing point
+        3) if it intersects (approximately) any of the lines that point toward
+        the other vanishing point (The one that isn't being extended to).
+        The swept trapezoids are scan-converted straight into the bitmaps of
+        lineextimg. Each line class fills its own bitmaps, so the classes are
+        processed by up to num_threads threads (0 means one per hardware thread).
     */
-    std::vector<std::vector<std::vector<Matrix> > > orient_from_lines(); //[][][] where each [] is a pair
-                                  //[][][] of  imgheight,imgwidth
-                                  //[][][] matrix of line overlaps
-                                  //(its [3][3][2])
+    void orient_from_lines(size_t num_threads);
 
     /*
         sample_line() - This method is only called once. Goes through each of the lines
@@ -147,26 +160,6 @@ public:
     */
     void sample_line();
 
-    /*
-        extend_line() - Called twice for every line. Takes the line and attempts to
-        extend its area (creating a trapezoid) toward the vanishing point. It stops
-        if the line does one of several things:
-        1) if the extension goes beyond the edge of the image
-        2) if the extension hits the vanishing point
-        3) if the extension intersects (approximately) any of the lines that point 
-        toward the other vanishing point (The one that isn't being extended to).
- 
-    */  
-    Matrix extend_line
-    (
-        Omap_segment line,
-        Vanishing_point vp,
-        int toward_or_away,
-        std::vector<kjb::Vector> sample,
-        int imgheight,
-        int imgwidth
-    );
-    
     /* private copy constructor */
     Omap_computer(const Omap_computer & src)
     {
@@ -260,12 +253,16 @@ public:
         Initialises lineextimg...
         calls orient_from_lines()...
         once lineextimg is filled out, computes the actual orientation maps by
-        and-ing/or-ing variations of lineextimg's parts.
+        and-ing/or-ing variations of lineextimg's parts, a word at a time.
+
+        @param num_threads - threads used to extend the lines, at most one per
+                             line class; 0 means one per hardware thread.
     */  
     void compute_omap
     (
 		Image & out_omap,
-	    Orientation_map_type omap_type
+	    Orientation_map_type omap_type,
+	    size_t num_threads = 1
     );
 
     //getters
@@ -322,6 +319,26 @@ public:
 
 }; //end class Omap_computer
 
+/*
+    scanline_fill_polygon() - Sets the pixels (row y, column x) of a polygon in
+    a bitmap of one bit per pixel, with each row padded to row_words words,
+    one row span at a time. Concave polygons are filled by the even-odd rule.
+    Pixels on the border are set too, so the result is the support of
+    geometry::polygon_to_mask() for the same polygon, without testing every
+    pixel. Pixels outside the image are clipped.
+
+    @param poly - the x,y pairs of the num_vertices vertices, in a cyclic order
+*/
+void scanline_fill_polygon
+(
+    std::vector<uint64_t> & bitmap,
+    size_t row_words,
+    const double * poly,
+    size_t num_vertices,
+    int imgheight,
+    int imgwidth
+);
+
 }
 
 #endif
@@ -0,0 +1,219 @@
+/* $Id$ */
+/* =========================================================================== *
+   |
+   |  Copyright (c) 1994-2010 by Kobus Barnard (author)
+   |
+   |  Personal and educational use of this code is granted, provided that this
+   |  header is kept intact, and that the authorship is not misrepresented, that
+   |  its use is acknowledged in publications, and relevant papers are cited.
+   |
+   |  For other use contact the author (kobus AT cs DOT arizona DOT edu).
+   |
+   |  Please note that the code in this file has not necessarily been adequately
+   |  tested. Naturally, there is no guarantee of performance, support, or fitness
+   |  for any particular task. Nonetheless, I am interested in hearing about
+   |  problems that you encounter.
+   |
+ * =========================================================================== */
+
+/*
+ * Checks that the features batch driver reads back from its cache exactly
+ * what it computed, that changing a parameter only recomputes the stages
+ * that depend on it, and that running images on several threads gives the
+ * features of a serial detect().
+ */
+
+#include <l_cpp/l_test.h>
+#include <l/l_sys_lib.h>
+#include <l/l_sys_io.h>
+#include <edge_cpp/features_batch.h>
+
+#include <string>
+#include <vector>
+#include <cmath>
+
+using namespace kjb;
+
+namespace
+{
+
+const char* CACHE_DIR = "features_batch_test_cache";
+
+void draw_line(Image& img, double x1, double y1, double x2, double y2)
+{
+    int n = (int)std::ceil(std::max(std::fabs(x2 - x1), std::fabs(y2 - y1)));
+    for(int i = 0; i <= n; i++)
+    {
+        int x = (int)(x1 + (x2 - x1) * i / n + 0.5);
+        int y = (int)(y1 + (y2 - y1) * i / n + 0.5);
+        for(int d = 0; d < 2; d++)
+        {
+            if(x + d >= 0 && x + d < img.get_num_cols()
+                && y >= 0 && y < img.get_num_rows())
+            {
+                img(y, x + d, 0) = img(y, x + d, 1) = img(y, x + d, 2) = 20;
+            }
+        }
+    }
+}
+
+/* Lines toward two vanishing points, and vertical lines. Different shifts
+ * give different images. */
+Image make_test_image(int shift = 0)
+{
+    Image img(240, 320, 230, 230, 230);
+    for(int i = 0; i < 8; i++)
+    {
+        draw_line(img, 20 + shift + 35 * i, 60, 20 + shift + 35 * i, 200);
+        draw_line(img, 30, 40 + shift + 20 * i, 150, 70 + 10 * i);
+        draw_line(img, 170, 70 + 10 * i, 300, 40 + shift + 20 * i);
+    }
+    return img;
+}
+
+bool same_features(Features_manager& f1, Features_manager& f2)
+{
+    const Edge_set& e1 = f1.get_edges();
+    const Edge_set& e2 = f2.get_edges();
+    if(e1.num_edges() != e2.num_edges()) return false;
+    for(unsigned int i = 0; i < e1.num_edges(); i++)
+    {
+        if(e1.get_edge(i).get_num_points() != e2.get_edge(i).get_num_points())
+        {
+            return false;
+        }
+    }
+
+    if(f1.get_edge_segments().size() != f2.get_edge_segments().size())
+    {
+        return false;
+    }
+
+    if(f1.manhattan_world_available() != f2.manhattan_world_available())
+    {
+        return false;
+    }
+    if(f1.manhattan_world_available())
+    {
+        const std::vector<Vanishing_point>& v1
+            = f1.get_manhattan_world().get_vanishing_points();
+        const std::vector<Vanishing_point>& v2
+            = f2.get_manhattan_world().get_vanishing_points();
+        for(size_t i = 0; i < v1.size(); i++)
+        {
+            if(v1[i].get_x() != v2[i].get_x() || v1[i].get_y() != v2[i].get_y()
+                || v1[i].get_type() != v2[i].get_type())
+            {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+}
+
+int main()
+{
+    kjb_c::kjb_system((std::string("rm -rf ") + CACHE_DIR).c_str());
+
+    Image img = make_test_image();
+    Features_batch batch(CACHE_DIR);
+
+    // first run computes everything
+    Features_batch_result r1;
+    boost::shared_ptr<Features_manager> f1 = batch.detect(img, r1);
+    TEST_FALSE(r1.edges_cached);
+    TEST_FALSE(r1.edge_segments_cached);
+    TEST_FALSE(r1.vanishing_points_cached);
+    TEST_TRUE(f1->edges_available());
+    TEST_TRUE(f1->edge_segments_available());
+
+    // second run reads everything back
+    Features_batch_result r2;
+    boost::shared_ptr<Features_manager> f2 = batch.detect(img, r2);
+    TEST_TRUE(r2.edges_cached);
+    TEST_TRUE(r2.edge_segments_cached);
+    TEST_TRUE(r2.vanishing_points_cached);
+    TEST_TRUE(same_features(*f1, *f2));
+
+    // the outlier threshold only affects the assignment of the segments
+    batch.set_manhattan_world_parameters(FM_DEFAULT_VP_SUCCESS_PROBABILITY,
+                                         2 * FM_DEFAULT_VP_ASSIGNMENT_THRESHOLD);
+    Features_batch_result r3;
+    batch.detect(img, r3);
+    TEST_TRUE(r3.edges_cached);
+    TEST_TRUE(r3.edge_segments_cached);
+    TEST_TRUE(r3.vanishing_points_cached);
+
+    // edge parameters do not affect the vanishing points
+    batch.set_edge_detection_parameters(FM_DEFAULT_EDGE_SIGMA,
+                                        FM_DEFAULT_EDGE_BEGIN,
+                                        0.9 * FM_DEFAULT_EDGE_END,
+                                        FM_DEFAULT_EDGE_PADDING, true);
+    Features_batch_result r4;
+    batch.detect(img, r4);
+    TEST_FALSE(r4.edges_cached);
+    TEST_FALSE(r4.edge_segments_cached);
+    TEST_TRUE(r4.vanishing_points_cached);
+
+    // another image
+    Image img2(img);
+    img2(0, 0, 0) = 0;
+    Features_batch_result r5;
+    batch.detect(img2, r5);
+    TEST_FALSE(r5.edges_cached);
+    TEST_FALSE(r5.vanishing_points_cached);
+
+    // failures are reported per image
+    batch.set_num_threads(2);
+    std::vector<std::string> paths(2, "no_such_image_for_features_batch.jpg");
+    std::vector<Features_batch_result> results = batch.run(paths);
+    TEST_TRUE(results.size() == 2);
+    TEST_FALSE(results[0].features);
+    TEST_FALSE(results[0].error.empty());
+    TEST_FALSE(results[1].features);
+
+    kjb_c::kjb_system((std::string("rm -rf ") + CACHE_DIR).c_str());
+
+    // several images on several threads, without a cache, give the features
+    // of a serial detect()
+    kjb_c::kjb_mkdir(CACHE_DIR);
+    const int num_images = 6;
+    std::vector<std::string> image_paths;
+    for(int i = 0; i < num_images; i++)
+    {
+        std::string path = std::string(CACHE_DIR) + "/image_" + (char)('0' + i) + ".tiff";
+        make_test_image(3 * i).write(path);
+        image_paths.push_back(path);
+    }
+
+    Features_batch threaded_batch("", 4);
+    std::vector<Features_batch_result> threaded_results = threaded_batch.run(image_paths);
+    TEST_TRUE(threaded_results.size() == image_paths.size());
+
+    Features_batch serial_batch;
+    for(int i = 0; i < num_images; i++)
+    {
+        TEST_TRUE(threaded_results[i].error.empty());
+        TEST_TRUE(threaded_results[i].features);
+        TEST_TRUE(threaded_results[i].image_path == image_paths[i]);
+
+        Features_batch_result serial_result;
+        boost::shared_ptr<Features_manager> serial
+            = serial_batch.detect(Image(image_paths[i]), serial_result);
+        TEST_TRUE(same_features(*threaded_results[i].features, *serial));
+    }
+
+    // and a second threaded run gives the same features again
+    std::vector<Features_batch_result> again = threaded_batch.run(image_paths);
+    for(int i = 0; i < num_images; i++)
+    {
+        TEST_TRUE(same_features(*threaded_results[i].features, *again[i].features));
+    }
+
+    kjb_c::kjb_system((std::string("rm -rf ") + CACHE_DIR).c_str());
+
+    RETURN_VICTORIOUSLY();
+}
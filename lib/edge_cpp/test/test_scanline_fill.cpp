@@ -0,0 +1,119 @@
+/* $Id$ */
+/* =========================================================================== *
+   |
+   |  Copyright (c) 1994-2010 by Kobus Barnard (author)
+   |
+   |  Personal and educational use of this code is granted, provided that this
+   |  header is kept intact, and that the authorship is not misrepresented, that
+   |  its use is acknowledged in publications, and relevant papers are cited.
+   |
+   |  For other use contact the author (kobus AT cs DOT arizona DOT edu).
+   |
+   |  Please note that the code in this file has not necessarily been adequately
+   |  tested. Naturally, there is no guarantee of performance, support, or fitness
+   |  for any particular task. Nonetheless, I am interested in hearing about
+   |  problems that you encounter.
+   |
+ * =========================================================================== */
+
+/*
+ * Checks that the scanline fill used by Omap_computer gives the same mask as
+ * geometry::polygon_to_mask() for convex and concave polygons, and for ones
+ * whose edges run through pixel centers or along the border of the image.
+ *
+ * polygon_to_mask() jitters the rows it tests, so no vertex is on a pixel row
+ * unless every pixel of that row in the polygon is on its border.
+ */
+
+#include <l_cpp/l_test.h>
+#include <edge_cpp/omap_computer.h>
+#include <g_cpp/g_util.h>
+
+#include <vector>
+#include <algorithm>
+
+using namespace kjb;
+
+namespace
+{
+
+const int HEIGHT = 24;
+const int WIDTH = 32;
+
+/* Number of pixels where the two masks differ, counting both orders of the
+ * vertices for the scanline fill. */
+int count_differences(const double * poly, size_t num_vertices)
+{
+    const size_t row_words = (WIDTH + 63)/64;
+
+    Matrix mpoly((int)num_vertices, 2);
+    std::vector<double> reversed(2*num_vertices);
+    for(size_t i = 0; i < num_vertices; i++)
+    {
+        mpoly(i, 0) = poly[2*i];
+        mpoly(i, 1) = poly[2*i + 1];
+        reversed[2*(num_vertices - 1 - i)] = poly[2*i];
+        reversed[2*(num_vertices - 1 - i) + 1] = poly[2*i + 1];
+    }
+
+    Matrix mask = geometry::polygon_to_mask(mpoly, HEIGHT, WIDTH);
+
+    int num_differences = 0;
+    int num_set = 0;
+    for(int order = 0; order < 2; order++)
+    {
+        std::vector<uint64_t> bitmap(HEIGHT*row_words, 0);
+        scanline_fill_polygon(bitmap, row_words,
+                              order == 0 ? poly : &reversed[0],
+                              num_vertices, HEIGHT, WIDTH);
+
+        for(int r = 0; r < HEIGHT; r++)
+        {
+            for(int c = 0; c < WIDTH; c++)
+            {
+                bool is_set = (bitmap[r*row_words + c/64] >> (c % 64)) & 1;
+                bool in_mask = mask(r, c) != 0.0;
+                if(is_set != in_mask) num_differences++;
+                if(is_set) num_set++;
+            }
+        }
+    }
+
+    // an empty fill of an empty mask would tell us nothing
+    TEST_TRUE(num_set > 0);
+
+    return num_differences;
+}
+
+} // anonymous namespace
+
+int main(int, char**)
+{
+    // convex, with crossings well away from pixel centers
+    const double trapezoid[] = { 2.5, 2.5,  12.5, 2.5,  17.5, 12.5,  6.5, 12.5 };
+    TEST_TRUE(count_differences(trapezoid, 4) == 0);
+
+    // concave, with two spans on the rows above the reflex vertex
+    const double arrow[] = { 1.5, 0.5,  9.0, 10.5,  16.5, 0.5,  9.0, 20.5 };
+    TEST_TRUE(count_differences(arrow, 4) == 0);
+
+    // concave, with vertical edges through pixel centers, and on the left
+    // border of the image
+    const double ell[] = { 0.0, 0.5,  6.0, 0.5,  6.0, 6.5,  14.0, 6.5,
+                           14.0, 12.5,  0.0, 12.5 };
+    TEST_TRUE(count_differences(ell, 6) == 0);
+
+    // diagonal edges through pixel centers
+    const double diamond[] = { 11.5, 0.5,  22.5, 11.5,  11.5, 22.5,
+                               0.5, 11.5 };
+    TEST_TRUE(count_differences(diamond, 4) == 0);
+
+    // on the right and bottom borders of the image, with a bottom edge along
+    // the last row
+    const double corner[] = { 20.0, 12.5,  31.0, 12.5,  31.0, 23.0,
+                              20.0, 23.0 };
+    TEST_TRUE(count_differences(corner, 4) == 0);
+
+    RETURN_VICTORIOUSLY();
+}
+
@@ -0,0 +1,187 @@
+/* $Id$ */
+/* =========================================================================== *
+   |
+   |  Copyright (c) 1994-2010 by Kobus Barnard (author)
+   |
+   |  Personal and educational use of this code is granted, provided that this
+   |  header is kept intact, and that the authorship is not misrepresented, that
+   |  its use is acknowledged in publications, and relevant papers are cited.
+   |
+   |  For other use contact the author (kobus AT cs DOT arizona DOT edu).
+   |
+   |  Please note that the code in this file has not necessarily been adequately
+   |  tested. Naturally, there is no guarantee of performance, support, or fitness
+   |  for any particular task. Nonetheless, I am interested in hearing about
+   |  problems that you encounter.
+   |
+ * =========================================================================== */
+
+/*
+ * Checks the tiled edge detector on a synthetic image (a rectangle and a
+ * disc): the result must not depend on the number of threads, or on whether
+ * the workspace was used before on an image of another size, and the edges
+ * must be connected chains lying on the true boundaries.
+ */
+
+#include <l_cpp/l_test.h>
+#include <m/m_incl.h>
+#include <edge/edge_canny.h>
+
+#include <cstdlib>
+#include <cmath>
+
+using namespace kjb_c;
+
+namespace
+{
+
+const int NUM_ROWS = 120;
+const int NUM_COLS = 160;
+
+Matrix* make_test_matrix(int num_rows, int num_cols)
+{
+    Matrix* mp = NULL;
+    int     i, j;
+
+    EPETE(get_zero_matrix(&mp, num_rows, num_cols));
+
+    for (i = 30; i < MIN_OF(90, num_rows); i++)
+    {
+        for (j = 40; j < MIN_OF(120, num_cols); j++)
+        {
+            mp->elements[ i ][ j ] = 1.0;
+        }
+    }
+
+    for (i = 0; i < num_rows; i++)
+    {
+        for (j = 0; j < num_cols; j++)
+        {
+            double di = i - 60;
+            double dj = j - 30;
+
+            if (di * di + dj * dj < 15 * 15)
+            {
+                mp->elements[ i ][ j ] = 0.5;
+            }
+        }
+    }
+
+    return mp;
+}
+
+bool same_edges(const Edge_set* a, const Edge_set* b)
+{
+    if (a->num_edges != b->num_edges || a->total_num_pts != b->total_num_pts)
+    {
+        return false;
+    }
+
+    for (unsigned int e = 0; e < a->num_edges; e++)
+    {
+        if (a->edges[ e ].num_points != b->edges[ e ].num_points)
+        {
+            return false;
+        }
+
+        for (unsigned int p = 0; p < a->edges[ e ].num_points; p++)
+        {
+            const Edge_point& pa = a->edges[ e ].points[ p ];
+            const Edge_point& pb = b->edges[ e ].points[ p ];
+
+            if (pa.row != pb.row || pa.col != pb.col || pa.mag != pb.mag)
+            {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+/* Each point is next to the previous one, and close to a true boundary. */
+bool edges_are_plausible(const Edge_set* edges)
+{
+    for (unsigned int e = 0; e < edges->num_edges; e++)
+    {
+        const Edge& edge = edges->edges[ e ];
+
+        for (unsigned int p = 0; p < edge.num_points; p++)
+        {
+            int    row = edge.points[ p ].row;
+            int    col = edge.points[ p ].col;
+            double di  = row - 60;
+            double dj  = col - 30;
+            double r   = sqrt(di * di + dj * dj);
+            bool   on_rectangle;
+            bool   on_disc;
+
+            if (p > 0)
+            {
+                int d_row = abs(row - (int)edge.points[ p - 1 ].row);
+                int d_col = abs(col - (int)edge.points[ p - 1 ].col);
+
+                if (d_row > 1 || d_col > 1 || d_row + d_col == 0)
+                {
+                    return false;
+                }
+            }
+
+            on_rectangle = (row >= 28 && row <= 91 && col >= 38 && col <= 121)
+                       && (row <= 31 || row >= 88 || col <= 41 || col >= 118);
+            on_disc = r > 12.5 && r < 17.5;
+
+            if ( ! on_rectangle && ! on_disc)
+            {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+}
+
+int main()
+{
+    Canny_workspace* workspace = create_canny_workspace();
+    Matrix*          mp        = make_test_matrix(NUM_ROWS, NUM_COLS);
+    Matrix*          small_mp  = make_test_matrix(NUM_ROWS / 2, NUM_COLS / 2);
+    Edge_set*        reference = NULL;
+    Edge_set*        edges     = NULL;
+    const int        num_threads[ ] = { 2, 3, 5 };
+
+    TEST_TRUE(workspace != NULL);
+
+    EPETE(detect_matrix_edge_set_tiled(&reference, workspace, mp,
+                                       1.5, 0.05, 0.02, 3, FALSE, 1));
+    TEST_TRUE(reference->num_edges > 0);
+    TEST_TRUE(edges_are_plausible(reference));
+
+    for (int i = 0; i < 3; i++)
+    {
+        EPETE(detect_matrix_edge_set_tiled(&edges, workspace, mp, 1.5, 0.05,
+                                           0.02, 3, FALSE, num_threads[ i ]));
+        TEST_TRUE(same_edges(edges, reference));
+    }
+
+    /* A used workspace must give the same result as a fresh one. */
+    EPETE(detect_matrix_edge_set_tiled(&edges, workspace, small_mp,
+                                       1.5, 0.05, 0.02, 3, FALSE, 2));
+    EPETE(detect_matrix_edge_set_tiled(&edges, workspace, mp,
+                                       1.5, 0.05, 0.02, 3, FALSE, 2));
+    TEST_TRUE(same_edges(edges, reference));
+
+    EPETE(detect_matrix_edge_set_tiled(&edges, NULL, mp,
+                                       1.5, 0.05, 0.02, 3, FALSE, 2));
+    TEST_TRUE(same_edges(edges, reference));
+
+    free_edge_set(edges);
+    free_edge_set(reference);
+    free_matrix(small_mp);
+    free_matrix(mp);
+    free_canny_workspace(workspace);
+
+    RETURN_VICTORIOUSLY();
+}
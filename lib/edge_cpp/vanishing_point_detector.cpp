@@ -26,6 +26,7 @@
 #include "n/n_invert.h"
 #include <cmath>
 #include <iostream>
+#include <boost/thread/tss.hpp>
 
 using namespace kjb;
 
@@ -2096,9 +2097,18 @@ void Vanishing_point_detector::sample_n_from_m_without_repetitions(unsigned int
         iv.resize(n, 0);
     }
 
+    Vanishing_point_random_stream* stream = Vanishing_point_random_stream::get_current();
     for(unsigned int i = 0; i < n; i++)
     {
-        unsigned int position = (unsigned int) kjb_c::kjb_rand_int(0, m-i-1);
+        unsigned int position;
+        if(stream)
+        {
+            position = (unsigned int) stream->rand_int(0, m-i-1);
+        }
+        else
+        {
+            position = (unsigned int) kjb_c::kjb_rand_int(0, m-i-1);
+        }
         unsigned int counter = 0;
         for(unsigned int j = 0; j < m; j++ )
         {
@@ -2119,6 +2129,51 @@ void Vanishing_point_detector::sample_n_from_m_without_repetitions(unsigned int
     }
 }
 
+namespace
+{
+
+/* Streams live on the stack of their thread, so they are not deleted here */
+void leave_stream(Vanishing_point_random_stream *) {}
+
+boost::thread_specific_ptr<Vanishing_point_random_stream> current_stream(&leave_stream);
+
+const uint64_t RANDOM_STREAM_MASK = (((uint64_t)1) << 48) - 1;
+
+}
+
+/**
+ * @param seed All 64 bits are used
+ */
+Vanishing_point_random_stream::Vanishing_point_random_stream(uint64_t seed)
+  : m_state((seed ^ (seed >> 48)) & RANDOM_STREAM_MASK),
+    m_previous(current_stream.get())
+{
+    current_stream.reset(this);
+}
+
+Vanishing_point_random_stream::~Vanishing_point_random_stream()
+{
+    current_stream.reset(m_previous);
+}
+
+Vanishing_point_random_stream* Vanishing_point_random_stream::get_current()
+{
+    return current_stream.get();
+}
+
+int Vanishing_point_random_stream::rand_int(int lb, int ub)
+{
+    if(lb > ub)
+    {
+        KJB_THROW_2(Illegal_argument, "Empty interval for random integer");
+    }
+
+    m_state = (0x5DEECE66DULL * m_state + 0xB) & RANDOM_STREAM_MASK;
+    double u = (double)m_state / (double)(RANDOM_STREAM_MASK + 1);
+
+    return lb + (int)(u * (1 + ub - lb));
+}
+
 void Vanishing_point_detector::insert_penalty_into_list(double ipenalty)
 {
     std::list<double>::iterator result = std::find_if( penalties.begin(), penalties.end(), std::bind2nd( ComparePenalty(), ipenalty ) );
@@ -2250,19 +2305,6 @@ bool kjb::robustly_estimate_vanishing_points
     Edge_segment_set edge_set( &(*ptr));
     edge_set.remove_frame_segments(ptr->get_num_rows(),ptr->get_num_cols(),*ptr);
 
-    Image cp(img);
-    Image cp2(img);
-    for(unsigned int i = 0; i < edge_set.size(); i++)
-    {
-        if(edge_set.get_segment(i).get_least_squares_fitting_error() < 0.5) //0.5
-        {
-            edge_set.get_segment(i).randomly_color(cp);
-        }
-    }
-    ptr->randomly_color(cp2);
-    cp.write("uffa.jpg");
-    cp2.write("uffa2.jpg");
-
     Edge_set_ptr ptr_temp(new kjb::Edge_set(*ptr));
 
     bool found = false;
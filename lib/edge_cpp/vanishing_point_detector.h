@@ -32,6 +32,7 @@
 #include <vector>
 #include <list>
 #include <string>
+#include <stdint.h>
 
 #define VPD_VERTICAL_THRESHOLD   0.12
 #define VPD_VERTICAL_VP_OUTLIER_THRESHOLD 0.05
@@ -388,6 +389,45 @@ class Vanishing_point_detector
 
 };
 
+/**
+ * @class Vanishing_point_random_stream
+ *
+ * @brief While an object of this class exists, RANSAC vanishing point
+ *        detection in the calling thread draws from this stream instead of
+ *        kjb_rand().
+ *
+ * kjb_rand() is shared by all threads (unless they were started with
+ * kjb_pthread_create()), so detection on several threads at once races on
+ * it, and which image gets which numbers depends on scheduling. Seeding a
+ * stream per image, for example from a hash of the image, makes detection
+ * safe to run on several threads and gives the same result as a serial run.
+ * Streams nest; the innermost one of the thread is used.
+ */
+class Vanishing_point_random_stream
+{
+    public:
+
+        explicit Vanishing_point_random_stream(uint64_t seed);
+
+        ~Vanishing_point_random_stream();
+
+        /** @brief Returns a uniform integer in [lb, ub], like kjb_rand_int() */
+        int rand_int(int lb, int ub);
+
+        /** @brief The stream of the calling thread, or NULL if there is none */
+        static Vanishing_point_random_stream* get_current();
+
+    private:
+
+        Vanishing_point_random_stream(const Vanishing_point_random_stream &);
+        Vanishing_point_random_stream & operator=(const Vanishing_point_random_stream &);
+
+        /** 48 bit linear congruential state, as erand48() */
+        uint64_t m_state;
+
+        Vanishing_point_random_stream* m_previous;
+};
+
 /**
  * @brief Estimates the vanishing points for the three orthogonal directions
  * of a Manhattan world scene (where most of all planes are aligned
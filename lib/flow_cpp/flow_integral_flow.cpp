@@ -36,14 +36,38 @@
 
 using namespace kjb;
 
+namespace {
+
+/**
+ * @brief   Allocates a table of n floats, returning it both writable and
+ *          as the shared pointer Integral_flow keeps.
+ */
+float* make_table(size_t n, boost::shared_ptr<const float>& table)
+{
+    boost::shared_ptr<std::vector<float> > values(new std::vector<float>(n));
+    if(n == 0)
+    {
+        table.reset();
+        return 0;
+    }
+
+    table = boost::shared_ptr<const float>(values, &(*values)[0]);
+    return &(*values)[0];
+}
+
+} // anonymous namespace
+
+/* \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ */
+
 Integral_flow::Integral_flow(const Matrix& flow, size_t subsample_rate) :
     ss_rate_(subsample_rate),
     img_width_(flow.get_num_cols()),
     img_height_(flow.get_num_rows()),
     width_(img_width_ / ss_rate_),
-    height_(img_height_ / ss_rate_),
-    image_(width_ * height_)
+    height_(img_height_ / ss_rate_)
 {
+    float* image = make_table(width_ * height_, image_);
+
     Matrix iflow(img_height_, img_width_);
 
     iflow(0, 0) = flow(0, 0);
@@ -66,12 +90,14 @@ Integral_flow::Integral_flow(const Matrix& flow, size_t subsample_rate) :
         }
     }
 
+    // keep to the table size; stepping through the whole image overruns it
+    // when the image size is not a multiple of the subsampling rate
     size_t k = 0;
-    for(size_t i = 0; i < img_height_; i += ss_rate_)
+    for(size_t i = 0; i < height_; i++)
     {
-        for(size_t j = 0; j < img_width_; j += ss_rate_)
+        for(size_t j = 0; j < width_; j++)
         {
-            image_[k++] = iflow(i, j);
+            image[k++] = iflow(i * ss_rate_, j * ss_rate_);
         }
     }
 }
@@ -105,7 +131,7 @@ Integral_flow::Integral_flow(const std::string& fname)
     height_ = img_height_/ss_rate_;
 
     size_t total_length = width_ * height_;
-    image_.resize(width_ * height_, 0.0);
+    float* image = make_table(total_length, image_);
 
     // read in the precomputed integral image
     size_t i = 0;
@@ -117,7 +143,7 @@ Integral_flow::Integral_flow(const std::string& fname)
         assert(tokens.size() == width_);
         BOOST_FOREACH(const string& token, tokens)
         {
-            image_[i++] = boost::lexical_cast<float>(token);
+            image[i++] = boost::lexical_cast<float>(token);
         }
     }
 
@@ -126,6 +152,28 @@ Integral_flow::Integral_flow(const std::string& fname)
 
 /* \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ */
 
+Integral_flow::Integral_flow
+(
+    size_t img_width,
+    size_t img_height,
+    size_t subsample_rate,
+    const boost::shared_ptr<const float>& table
+) :
+    ss_rate_(subsample_rate),
+    img_width_(img_width),
+    img_height_(img_height),
+    width_(img_width_ / ss_rate_),
+    height_(img_height_ / ss_rate_),
+    image_(table)
+{
+    IFT(ss_rate_ > 0, Illegal_argument,
+        "Integral_flow: subsampling rate must be positive.");
+    IFT(image_ || width_ * height_ == 0, Illegal_argument,
+        "Integral_flow: missing summed area table.");
+}
+
+/* \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ */
+
 double Integral_flow::flow_sum(double x, double y) const
 {
     typedef std::pair<size_t, size_t> xy_pair;
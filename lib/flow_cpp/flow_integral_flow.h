@@ -23,6 +23,7 @@
 
 #include <m_cpp/m_matrix.h>
 #include <gr_cpp/gr_2D_bounding_box.h>
+#include <boost/shared_ptr.hpp>
 #include <vector>
 #include <algorithm>
 #include <utility>
@@ -34,6 +35,10 @@ namespace kjb {
  * @class   Integral_flow
  *
  * Class that represents the summed area table for optical flow features.
+ *
+ * The table is never modified after construction, so copies share it. It
+ * can also live in memory owned by someone else, e.g., a memory-mapped
+ * integral flow store (see read_integral_flow_store()).
  */
 class Integral_flow
 {
@@ -49,6 +54,20 @@ public:
      */
     Integral_flow(const std::string& fname);
 
+    /**
+     * @brief   Construct an integral flow from a precomputed summed area
+     *          table of (img_height / subsample_rate) rows of
+     *          (img_width / subsample_rate) values, which is shared, not
+     *          copied.
+     */
+    Integral_flow
+    (
+        size_t img_width,
+        size_t img_height,
+        size_t subsample_rate,
+        const boost::shared_ptr<const float>& table
+    );
+
     /**
      * @brief   Returns the (interpolated) value of the integral flow at
      *          (x, y); i.e., computes the sum of flow in the box with
@@ -94,6 +113,13 @@ public:
 
     size_t img_width() const { return  img_width_; }
     size_t img_height() const { return  img_height_; }
+    size_t subsample_rate() const { return  ss_rate_; }
+
+    /** @brief  The summed area table, row by row. */
+    const float* table() const { return image_.get(); }
+
+    /** @brief  The number of values in the summed area table. */
+    size_t table_size() const { return width_ * height_; }
 
 private:
     /**
@@ -102,7 +128,7 @@ private:
      */
     double at(size_t row, size_t col) const
     {
-        return image_[row*width_ + col];
+        return image_.get()[row*width_ + col];
     }
 
     /**
@@ -118,7 +144,7 @@ private:
     size_t img_height_;
     size_t width_;
     size_t height_;
-    std::vector<float> image_;
+    boost::shared_ptr<const float> image_;
 };
 
 } //namespace kjb
@@ -0,0 +1,517 @@
+/* =========================================================================== *
+   |
+   |  Copyright (c) 1994-2011 by Kobus Barnard (author)
+   |
+   |  Personal and educational use of this code is granted, provided that this
+   |  header is kept intact, and that the authorship is not misrepresented, that
+   |  its use is acknowledged in publications, and relevant papers are cited.
+   |
+   |  For other use contact the author (kobus AT cs DOT arizona DOT edu).
+   |
+   |  Please note that the code in this file has not necessarily been adequately
+   |  tested. Naturally, there is no guarantee of performance, support, or fitness
+   |  for any particular task. Nonetheless, I am interested in hearing about
+   |  problems that you encounter.
+   |
+ * =========================================================================== */
+
+/* $Id$ */
+
+#include <flow_cpp/flow_integral_flow_store.h>
+#include <m_cpp/m_matrix.h>
+#include <l_cpp/l_exception.h>
+
+#include <boost/thread.hpp>
+#include <boost/bind.hpp>
+#include <boost/function.hpp>
+#include <cstring>
+#include <cstdio>
+#include <cerrno>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+using namespace kjb;
+
+namespace {
+
+/** Tables start on multiples of this, so paging in one reads no other. */
+const size_t STORE_PAGE_SIZE = 4096;
+
+const char STORE_MAGIC[8] = { 'K', 'J', 'B', 'I', 'F', 'L', 'W', '1' };
+
+/** Reads differently if written with another byte order. */
+const uint64_t STORE_BYTE_ORDER = 0x0102030405060708ULL;
+
+/** The start of the header page. */
+struct Store_header
+{
+    char magic[8];
+    uint64_t byte_order;
+    uint64_t num_frames;
+    uint64_t img_width;
+    uint64_t img_height;
+    uint64_t subsample_rate;
+    uint64_t table_stride;
+};
+
+typedef boost::function<Integral_flow (const std::string&)> Flow_loader;
+
+/** Matrix reading goes through the C library I/O, which is not reentrant */
+boost::mutex flow_read_mutex;
+
+/* \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ */
+
+/** @brief  Layout of a store whose frames are all like the given one. */
+Store_header make_header(const Integral_flow& flow, size_t num_frames)
+{
+    Store_header header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, STORE_MAGIC, sizeof(STORE_MAGIC));
+    header.byte_order = STORE_BYTE_ORDER;
+    header.num_frames = num_frames;
+    header.img_width = flow.img_width();
+    header.img_height = flow.img_height();
+    header.subsample_rate = flow.subsample_rate();
+
+    size_t table_bytes = flow.table_size() * sizeof(float);
+    header.table_stride = (table_bytes + STORE_PAGE_SIZE - 1)
+                            / STORE_PAGE_SIZE * STORE_PAGE_SIZE;
+
+    return header;
+}
+
+/** @brief  Offset of table i (frame i/2; x if i is even, y if odd). */
+off_t table_offset(const Store_header& header, size_t i)
+{
+    return STORE_PAGE_SIZE + (off_t)i * header.table_stride;
+}
+
+/** @brief  Writes all of n bytes at offset. */
+void write_at(int fd, const void* buffer, size_t n, off_t offset)
+{
+    const char* p = static_cast<const char*>(buffer);
+    while(n > 0)
+    {
+        ssize_t k = pwrite(fd, p, n, offset);
+        if(k < 0 && errno == EINTR) continue;
+        IFT(k > 0, IO_error, "Integral flow store: write failed.");
+        p += k;
+        n -= k;
+        offset += k;
+    }
+}
+
+/** @brief  Stores table i, checking that it fits the layout of the store. */
+void write_table
+(
+    int fd,
+    const Store_header& header,
+    size_t i,
+    const Integral_flow& flow
+)
+{
+    IFT(flow.img_width() == header.img_width
+            && flow.img_height() == header.img_height
+            && flow.subsample_rate() == header.subsample_rate,
+        Illegal_argument,
+        "Integral flow store: all frames must have the same size "
+        "and subsampling rate.");
+
+    if(flow.table_size() > 0)
+    {
+        write_at(fd, flow.table(), flow.table_size() * sizeof(float),
+                 table_offset(header, i));
+    }
+}
+
+/**
+ * @brief   Creates the file of a store with the given layout, at its full
+ *          size, with the header written.
+ */
+int create_store(const std::string& fname, const Store_header& header)
+{
+    int fd = open(fname.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    if(fd < 0)
+    {
+        KJB_THROW_3(IO_error, "Can't open file %s", (fname.c_str()));
+    }
+
+    off_t size = table_offset(header, 2 * header.num_frames);
+    char page[STORE_PAGE_SIZE];
+    std::memset(page, 0, sizeof(page));
+    std::memcpy(page, &header, sizeof(header));
+
+    if(ftruncate(fd, size) != 0)
+    {
+        close(fd);
+        KJB_THROW_3(IO_error, "Can't resize file %s", (fname.c_str()));
+    }
+
+    try
+    {
+        write_at(fd, page, sizeof(page), 0);
+    }
+    catch(...)
+    {
+        close(fd);
+        throw;
+    }
+
+    return fd;
+}
+
+/**
+ * @brief   Loads and stores the tables not yet taken by another thread,
+ *          until none are left or one fails.
+ */
+void build_worker
+(
+    int fd,
+    const Store_header& header,
+    const std::vector<std::string>& x_flow_fps,
+    const std::vector<std::string>& y_flow_fps,
+    const Flow_loader& load,
+    size_t* next,
+    std::string* error,
+    boost::mutex* next_mutex
+)
+{
+    const size_t num_tables = 2 * x_flow_fps.size();
+    while(true)
+    {
+        size_t i;
+        {
+            boost::mutex::scoped_lock lock(*next_mutex);
+            if(*next >= num_tables)
+            {
+                return;
+            }
+            i = (*next)++;
+        }
+
+        const std::string& fp = i % 2 == 0 ? x_flow_fps[i / 2]
+                                           : y_flow_fps[i / 2];
+        try
+        {
+            write_table(fd, header, i, load(fp));
+        }
+        catch(const KJB_error& e)
+        {
+            boost::mutex::scoped_lock lock(*next_mutex);
+            if(error->empty()) *error = fp + ": " + e.get_msg();
+            *next = num_tables;
+        }
+        catch(const std::exception& e)
+        {
+            boost::mutex::scoped_lock lock(*next_mutex);
+            if(error->empty()) *error = fp + ": " + e.what();
+            *next = num_tables;
+        }
+        catch(...)
+        {
+            // nothing may escape a thread
+            boost::mutex::scoped_lock lock(*next_mutex);
+            if(error->empty()) *error = fp + ": unknown error";
+            *next = num_tables;
+        }
+    }
+}
+
+/**
+ * @brief   Builds a store from the files of the frames, loading them with
+ *          load. The store is written under a temporary name and renamed
+ *          when complete, so mappings of a previous version stay valid.
+ */
+void build_store
+(
+    const std::string& fname,
+    const std::vector<std::string>& x_flow_fps,
+    const std::vector<std::string>& y_flow_fps,
+    const Flow_loader& load,
+    size_t num_threads
+)
+{
+    IFT(x_flow_fps.size() == y_flow_fps.size(), Illegal_argument,
+        "Integral flow store: need as many x flows as y flows.");
+    IFT(!x_flow_fps.empty(), Illegal_argument,
+        "Integral flow store: no flows given.");
+
+    // the first frame gives the layout
+    Integral_flow first = load(x_flow_fps[0]);
+    Store_header header = make_header(first, x_flow_fps.size());
+
+    std::string tmp_fname = fname + ".tmp";
+    int fd = create_store(tmp_fname, header);
+
+    std::string error;
+    try
+    {
+        try
+        {
+            write_table(fd, header, 0, first);
+        }
+        catch(const KJB_error& e)
+        {
+            error = x_flow_fps[0] + ": " + e.get_msg();
+        }
+
+        const size_t num_tables = 2 * x_flow_fps.size();
+        size_t next = error.empty() ? 1 : num_tables;
+        boost::mutex next_mutex;
+
+        size_t nt = num_threads;
+        if(nt == 0)
+        {
+            nt = boost::thread::hardware_concurrency();
+        }
+        if(nt > num_tables - 1)
+        {
+            nt = num_tables - 1;
+        }
+
+        if(nt <= 1)
+        {
+            build_worker(fd, header, x_flow_fps, y_flow_fps, load,
+                         &next, &error, &next_mutex);
+        }
+        else
+        {
+            boost::thread_group thrds;
+            try
+            {
+                for(size_t t = 0; t < nt; t++)
+                {
+                    thrds.create_thread(boost::bind(build_worker, fd,
+                                                    boost::cref(header),
+                                                    boost::cref(x_flow_fps),
+                                                    boost::cref(y_flow_fps),
+                                                    boost::cref(load),
+                                                    &next, &error,
+                                                    &next_mutex));
+                }
+            }
+            catch(...)
+            {
+                // the started threads use our locals; let them finish
+                {
+                    boost::mutex::scoped_lock lock(next_mutex);
+                    next = num_tables;
+                }
+                thrds.join_all();
+                throw;
+            }
+            thrds.join_all();
+        }
+    }
+    catch(...)
+    {
+        close(fd);
+        unlink(tmp_fname.c_str());
+        throw;
+    }
+
+    if(close(fd) != 0 && error.empty())
+    {
+        error = "Can't write file " + tmp_fname;
+    }
+
+    if(!error.empty())
+    {
+        unlink(tmp_fname.c_str());
+        KJB_THROW_2(IO_error, "Integral flow store: " + error);
+    }
+
+    if(rename(tmp_fname.c_str(), fname.c_str()) != 0)
+    {
+        unlink(tmp_fname.c_str());
+        KJB_THROW_3(IO_error, "Can't rename to %s", (fname.c_str()));
+    }
+}
+
+/** @brief  Reads an integral flow file. */
+Integral_flow load_integral_flow(const std::string& fp)
+{
+    return Integral_flow(fp);
+}
+
+/** @brief  Reads a flow matrix and computes its integral flow. */
+Integral_flow load_flow(const std::string& fp, size_t subsample_rate)
+{
+    Matrix flow;
+    {
+        boost::mutex::scoped_lock lock(flow_read_mutex);
+        flow.read(fp.c_str());
+    }
+
+    return Integral_flow(flow, subsample_rate);
+}
+
+/** @brief  Unmaps a store when the last integral flow using it is gone. */
+class Store_unmapper
+{
+public:
+    Store_unmapper(size_t length) : length_(length) {}
+
+    void operator()(void* address) const
+    {
+        munmap(address, length_);
+    }
+
+private:
+    size_t length_;
+};
+
+} // anonymous namespace
+
+/* \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ */
+
+void kjb::write_integral_flow_store
+(
+    const std::string& fname,
+    const std::vector<Integral_flow>& flows_x,
+    const std::vector<Integral_flow>& flows_y
+)
+{
+    IFT(flows_x.size() == flows_y.size(), Illegal_argument,
+        "Integral flow store: need as many x flows as y flows.");
+    IFT(!flows_x.empty(), Illegal_argument,
+        "Integral flow store: no flows given.");
+
+    Store_header header = make_header(flows_x[0], flows_x.size());
+
+    std::string tmp_fname = fname + ".tmp";
+    int fd = create_store(tmp_fname, header);
+    try
+    {
+        for(size_t f = 0; f < flows_x.size(); f++)
+        {
+            write_table(fd, header, 2 * f, flows_x[f]);
+            write_table(fd, header, 2 * f + 1, flows_y[f]);
+        }
+    }
+    catch(...)
+    {
+        close(fd);
+        unlink(tmp_fname.c_str());
+        throw;
+    }
+
+    if(close(fd) != 0 || rename(tmp_fname.c_str(), fname.c_str()) != 0)
+    {
+        unlink(tmp_fname.c_str());
+        KJB_THROW_3(IO_error, "Can't write file %s", (fname.c_str()));
+    }
+}
+
+/* \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ */
+
+void kjb::build_integral_flow_store
+(
+    const std::string& fname,
+    const std::vector<std::string>& x_flow_fps,
+    const std::vector<std::string>& y_flow_fps,
+    size_t num_threads
+)
+{
+    build_store(fname, x_flow_fps, y_flow_fps,
+                load_integral_flow, num_threads);
+}
+
+/* \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ */
+
+void kjb::build_integral_flow_store_from_flows
+(
+    const std::string& fname,
+    const std::vector<std::string>& x_flow_fps,
+    const std::vector<std::string>& y_flow_fps,
+    size_t subsample_rate,
+    size_t num_threads
+)
+{
+    IFT(subsample_rate > 0, Illegal_argument,
+        "Integral flow store: subsampling rate must be positive.");
+
+    build_store(fname, x_flow_fps, y_flow_fps,
+                boost::bind(load_flow, _1, subsample_rate), num_threads);
+}
+
+/* \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ */
+
+void kjb::read_integral_flow_store
+(
+    const std::string& fname,
+    std::vector<Integral_flow>& flows_x,
+    std::vector<Integral_flow>& flows_y
+)
+{
+    int fd = open(fname.c_str(), O_RDONLY);
+    if(fd < 0)
+    {
+        KJB_THROW_3(IO_error, "Can't open file %s", (fname.c_str()));
+    }
+
+    struct stat st;
+    Store_header header;
+    if(fstat(fd, &st) != 0
+        || (size_t)st.st_size < STORE_PAGE_SIZE
+        || pread(fd, &header, sizeof(header), 0) != (ssize_t)sizeof(header))
+    {
+        close(fd);
+        KJB_THROW_3(IO_error, "Can't read integral flow store %s",
+                    (fname.c_str()));
+    }
+
+    if(std::memcmp(header.magic, STORE_MAGIC, sizeof(STORE_MAGIC)) != 0
+        || header.byte_order != STORE_BYTE_ORDER
+        || header.subsample_rate == 0)
+    {
+        close(fd);
+        KJB_THROW_3(IO_error, "%s is not an integral flow store",
+                    (fname.c_str()));
+    }
+
+    size_t width = header.img_width / header.subsample_rate;
+    size_t height = header.img_height / header.subsample_rate;
+    if(header.table_stride < width * height * sizeof(float)
+        || st.st_size < table_offset(header, 2 * header.num_frames))
+    {
+        close(fd);
+        KJB_THROW_3(IO_error, "Integral flow store %s is truncated",
+                    (fname.c_str()));
+    }
+
+    size_t length = st.st_size;
+    void* address = mmap(0, length, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if(address == MAP_FAILED)
+    {
+        KJB_THROW_3(IO_error, "Can't map integral flow store %s",
+                    (fname.c_str()));
+    }
+
+    boost::shared_ptr<void> mapping(address, Store_unmapper(length));
+    const char* base = static_cast<const char*>(address);
+
+    std::vector<Integral_flow> xs;
+    std::vector<Integral_flow> ys;
+    xs.reserve(header.num_frames);
+    ys.reserve(header.num_frames);
+    for(size_t f = 0; f < header.num_frames; f++)
+    {
+        boost::shared_ptr<const float> x_table(mapping,
+            reinterpret_cast<const float*>(base + table_offset(header, 2*f)));
+        boost::shared_ptr<const float> y_table(mapping,
+            reinterpret_cast<const float*>(base + table_offset(header, 2*f+1)));
+
+        xs.push_back(Integral_flow(header.img_width, header.img_height,
+                                   header.subsample_rate, x_table));
+        ys.push_back(Integral_flow(header.img_width, header.img_height,
+                                   header.subsample_rate, y_table));
+    }
+
+    flows_x.swap(xs);
+    flows_y.swap(ys);
+}
@@ -0,0 +1,109 @@
+/* =========================================================================== *
+   |
+   |  Copyright (c) 1994-2011 by Kobus Barnard (author)
+   |
+   |  Personal and educational use of this code is granted, provided that this
+   |  header is kept intact, and that the authorship is not misrepresented, that
+   |  its use is acknowledged in publications, and relevant papers are cited.
+   |
+   |  For other use contact the author (kobus AT cs DOT arizona DOT edu).
+   |
+   |  Please note that the code in this file has not necessarily been adequately
+   |  tested. Naturally, there is no guarantee of performance, support, or fitness
+   |  for any particular task. Nonetheless, I am interested in hearing about
+   |  problems that you encounter.
+   |
+ * =========================================================================== */
+
+/* $Id$ */
+
+#ifndef KJB_FLOW_INTEGRAL_FLOW_STORE_H
+#define KJB_FLOW_INTEGRAL_FLOW_STORE_H
+
+#include <flow_cpp/flow_integral_flow.h>
+#include <vector>
+#include <string>
+
+/**
+ * @file
+ *
+ * An integral flow store is a single binary file holding the x and y
+ * integral flows of every frame of a video, as the single precision tables
+ * Integral_flow uses. All frames have the same size and subsampling rate.
+ *
+ * Reading a store maps the file into memory; the integral flows point into
+ * the mapping, so a table is only paged in when a flow_sum() touches it and
+ * the operating system can drop it again under memory pressure. Sums are
+ * exactly those of the integral flows the store was built from.
+ *
+ * The file has a header page followed by the tables of frame 1 (x then y),
+ * frame 2, and so on, each starting on a page boundary. Numbers are stored
+ * in the byte order of the machine that wrote them; reading a store written
+ * with another byte order fails.
+ */
+
+namespace kjb {
+
+/**
+ * @brief   Writes the given integral flows into an integral flow store.
+ *
+ * flows_x and flows_y must have the same number of frames, and all frames
+ * must have the same size and subsampling rate.
+ */
+void write_integral_flow_store
+(
+    const std::string& fname,
+    const std::vector<Integral_flow>& flows_x,
+    const std::vector<Integral_flow>& flows_y
+);
+
+/**
+ * @brief   Builds an integral flow store from integral flow files (see
+ *          Integral_flow::write()), one per frame for x and for y.
+ *
+ * The files are read and stored by num_threads threads (0 means one per
+ * hardware thread), without holding more than one frame per thread in
+ * memory.
+ */
+void build_integral_flow_store
+(
+    const std::string& fname,
+    const std::vector<std::string>& x_flow_fps,
+    const std::vector<std::string>& y_flow_fps,
+    size_t num_threads = 0
+);
+
+/**
+ * @brief   Builds an integral flow store from flow fields stored as
+ *          matrices (see Matrix::read()), one per frame for x and for y,
+ *          computing their integral flows with the given subsampling rate.
+ *
+ * As build_integral_flow_store(), but reading the matrices is serialized,
+ * since it goes through the C library I/O.
+ */
+void build_integral_flow_store_from_flows
+(
+    const std::string& fname,
+    const std::vector<std::string>& x_flow_fps,
+    const std::vector<std::string>& y_flow_fps,
+    size_t subsample_rate,
+    size_t num_threads = 0
+);
+
+/**
+ * @brief   Reads an integral flow store, replacing the contents of flows_x
+ *          and flows_y with its frames.
+ *
+ * Nothing is read until it is used. The mapping stays until the last of the
+ * integral flows sharing it is destroyed.
+ */
+void read_integral_flow_store
+(
+    const std::string& fname,
+    std::vector<Integral_flow>& flows_x,
+    std::vector<Integral_flow>& flows_y
+);
+
+} //namespace kjb
+
+#endif /*KJB_FLOW_INTEGRAL_FLOW_STORE_H */
@@ -0,0 +1,726 @@
+/* =========================================================================== *
+   |
+   |  Copyright (c) 1994-2011 by Kobus Barnard (author)
+   |
+   |  Personal and educational use of this code is granted, provided that this
+   |  header is kept intact, and that the authorship is not misrepresented, that
+   |  its use is acknowledged in publications, and relevant papers are cited.
+   |
+   |  For other use contact the author (kobus AT cs DOT arizona DOT edu).
+   |
+   |  Please note that the code in this file has not necessarily been adequately
+   |  tested. Naturally, there is no guarantee of performance, support, or fitness
+   |  for any particular task. Nonetheless, I am interested in hearing about
+   |  problems that you encounter.
+   |
+ * =========================================================================== */
+
+/* $Id$ */
+
+#include <flow_cpp/flow_tv_l1.h>
+#include <l_cpp/l_exception.h>
+
+#include <boost/thread.hpp>
+#include <boost/bind.hpp>
+#include <boost/function.hpp>
+#include <boost/noncopyable.hpp>
+#include <algorithm>
+#include <vector>
+#include <cmath>
+
+using namespace kjb;
+
+namespace {
+
+/** Pyramid levels are not made smaller than this on either side. */
+const int MIN_LEVEL_SIZE = 16;
+
+/** Smoothing of the frames before anything else. */
+const double PRESMOOTHING_SIGMA = 0.8;
+
+/** Smoothing before halving, to avoid aliasing. */
+const double PYRAMID_SIGMA = 0.6 * std::sqrt(1.0 / 0.25 - 1.0);
+
+/**
+ * @brief   A single precision image, stored row by row, which the inner
+ *          loops can run over with vector instructions.
+ */
+struct Plane
+{
+    int rows;
+    int cols;
+    std::vector<float> values;
+
+    Plane(int num_rows = 0, int num_cols = 0) :
+        rows(num_rows),
+        cols(num_cols),
+        values(num_rows * num_cols, 0.0f)
+    {}
+
+    float* row(int i) { return &values[i * cols]; }
+    const float* row(int i) const { return &values[i * cols]; }
+};
+
+/** @brief  Bilinear interpolation of f at (x, y), clamped to its border. */
+inline float sample(const Plane& f, float x, float y)
+{
+    x = std::min(std::max(x, 0.0f), f.cols - 1.0f);
+    y = std::min(std::max(y, 0.0f), f.rows - 1.0f);
+
+    const int j0 = (int)x;
+    const int i0 = (int)y;
+    const int j1 = std::min(j0 + 1, f.cols - 1);
+    const int i1 = std::min(i0 + 1, f.rows - 1);
+    const float a = x - j0;
+    const float b = y - i0;
+
+    const float* r0 = f.row(i0);
+    const float* r1 = f.row(i1);
+    return (1.0f - b) * ((1.0f - a) * r0[j0] + a * r0[j1])
+            + b * ((1.0f - a) * r1[j0] + a * r1[j1]);
+}
+
+/** @brief  First row of band t, when num_rows rows are split in nt bands. */
+inline int band_begin(int num_rows, size_t nt, size_t t)
+{
+    return (int)((size_t)num_rows * t / nt);
+}
+
+typedef boost::function<void(int, int)> Band_function;
+
+/** @brief  Calls fn(first, last) for bands of [0, num_rows), in threads. */
+void for_bands(int num_rows, size_t nt, const Band_function& fn)
+{
+    if(nt > (size_t)num_rows)
+    {
+        nt = num_rows;
+    }
+
+    if(nt <= 1)
+    {
+        fn(0, num_rows);
+        return;
+    }
+
+    boost::thread_group thrds;
+    for(size_t t = 0; t < nt; t++)
+    {
+        thrds.create_thread(boost::bind(fn, band_begin(num_rows, nt, t),
+                                        band_begin(num_rows, nt, t + 1)));
+    }
+    thrds.join_all();
+}
+
+/** @brief  Half of a normalized Gaussian kernel, from its center out. */
+std::vector<float> gaussian_kernel(double sigma)
+{
+    const int radius = std::max(1, (int)std::ceil(3.0 * sigma));
+    std::vector<double> k(radius + 1);
+    double total = 0.0;
+    for(int t = 0; t <= radius; t++)
+    {
+        k[t] = std::exp(-0.5 * t * t / (sigma * sigma));
+        total += (t == 0) ? k[t] : 2.0 * k[t];
+    }
+
+    std::vector<float> kernel(radius + 1);
+    for(int t = 0; t <= radius; t++)
+    {
+        kernel[t] = k[t] / total;
+    }
+
+    return kernel;
+}
+
+/** @brief  Convolves rows [first, last) of in with k along the rows. */
+void blur_rows
+(
+    const Plane& in,
+    Plane& out,
+    const std::vector<float>& k,
+    int first,
+    int last
+)
+{
+    const int radius = k.size() - 1;
+    const int cols = in.cols;
+
+    // the row, with its border repeated, so the loops need no clamping
+    std::vector<float> padded(cols + 2 * radius);
+    for(int i = first; i < last; i++)
+    {
+        const float* src = in.row(i);
+        float* dst = out.row(i);
+
+        std::fill(padded.begin(), padded.begin() + radius, src[0]);
+        std::copy(src, src + cols, padded.begin() + radius);
+        std::fill(padded.begin() + radius + cols, padded.end(), src[cols - 1]);
+
+        const float* p = &padded[radius];
+        for(int j = 0; j < cols; j++)
+        {
+            dst[j] = k[0] * p[j];
+        }
+
+        for(int t = 1; t <= radius; t++)
+        {
+            const float kt = k[t];
+            for(int j = 0; j < cols; j++)
+            {
+                dst[j] += kt * (p[j - t] + p[j + t]);
+            }
+        }
+    }
+}
+
+/** @brief  Convolves rows [first, last) of in with k along the columns. */
+void blur_cols
+(
+    const Plane& in,
+    Plane& out,
+    const std::vector<float>& k,
+    int first,
+    int last
+)
+{
+    const int radius = k.size() - 1;
+    const int cols = in.cols;
+
+    for(int i = first; i < last; i++)
+    {
+        const float* src = in.row(i);
+        float* dst = out.row(i);
+        for(int j = 0; j < cols; j++)
+        {
+            dst[j] = k[0] * src[j];
+        }
+
+        for(int t = 1; t <= radius; t++)
+        {
+            const float kt = k[t];
+            const float* up = in.row(std::max(i - t, 0));
+            const float* down = in.row(std::min(i + t, in.rows - 1));
+            for(int j = 0; j < cols; j++)
+            {
+                dst[j] += kt * (up[j] + down[j]);
+            }
+        }
+    }
+}
+
+/** @brief  Gaussian blur of f, with the border repeated. */
+Plane blur(const Plane& f, double sigma, size_t nt)
+{
+    const std::vector<float> k = gaussian_kernel(sigma);
+    Plane tmp(f.rows, f.cols);
+    Plane out(f.rows, f.cols);
+
+    for_bands(f.rows, nt, boost::bind(blur_rows, boost::cref(f),
+                                      boost::ref(tmp), boost::cref(k), _1, _2));
+    for_bands(f.rows, nt, boost::bind(blur_cols, boost::cref(tmp),
+                                      boost::ref(out), boost::cref(k), _1, _2));
+
+    return out;
+}
+
+/** @brief  Halves f, averaging blocks of 2 by 2 pixels. */
+Plane halve(const Plane& f)
+{
+    Plane out((f.rows + 1) / 2, (f.cols + 1) / 2);
+    for(int i = 0; i < out.rows; i++)
+    {
+        const float* r0 = f.row(2 * i);
+        const float* r1 = f.row(std::min(2 * i + 1, f.rows - 1));
+        float* dst = out.row(i);
+        for(int j = 0; j < out.cols; j++)
+        {
+            const int j0 = 2 * j;
+            const int j1 = std::min(j0 + 1, f.cols - 1);
+            dst[j] = 0.25f * (r0[j0] + r0[j1] + r1[j0] + r1[j1]);
+        }
+    }
+
+    return out;
+}
+
+/** @brief  Central differences of rows [first, last) of f. */
+void gradient
+(
+    const Plane& f,
+    Plane& fx,
+    Plane& fy,
+    int first,
+    int last
+)
+{
+    const int cols = f.cols;
+    for(int i = first; i < last; i++)
+    {
+        const float* r = f.row(i);
+        const float* up = f.row(std::max(i - 1, 0));
+        const float* down = f.row(std::min(i + 1, f.rows - 1));
+        float* gx = fx.row(i);
+        float* gy = fy.row(i);
+
+        for(int j = 1; j < cols - 1; j++)
+        {
+            gx[j] = 0.5f * (r[j + 1] - r[j - 1]);
+        }
+        gx[0] = 0.5f * (r[std::min(1, cols - 1)] - r[0]);
+        gx[cols - 1] = 0.5f * (r[cols - 1] - r[std::max(cols - 2, 0)]);
+
+        for(int j = 0; j < cols; j++)
+        {
+            gy[j] = 0.5f * (down[j] - up[j]);
+        }
+    }
+}
+
+/**
+ * @brief   Scales the flow u1, u2 of one level up to a level of the given
+ *          size.
+ */
+void upsample_flow(Plane& u1, Plane& u2, int rows, int cols)
+{
+    const float sx = (float)cols / u1.cols;
+    const float sy = (float)rows / u1.rows;
+
+    Plane v1(rows, cols);
+    Plane v2(rows, cols);
+    for(int i = 0; i < rows; i++)
+    {
+        const float y = (i + 0.5f) / sy - 0.5f;
+        float* d1 = v1.row(i);
+        float* d2 = v2.row(i);
+        for(int j = 0; j < cols; j++)
+        {
+            const float x = (j + 0.5f) / sx - 0.5f;
+            d1[j] = sx * sample(u1, x, y);
+            d2[j] = sy * sample(u2, x, y);
+        }
+    }
+
+    std::swap(u1, v1);
+    std::swap(u2, v2);
+}
+
+/**
+ * @brief   Solves for the flow at one pyramid level, refining the flow it
+ *          is given.
+ *
+ * The rows are split into bands, one per thread. Each iteration of the
+ * solver is a primal step, which reads the dual variables of the row above,
+ * and a dual step, which reads the flow of the row below; the threads wait
+ * for each other after each step.
+ */
+class Tv_l1_level : boost::noncopyable
+{
+public:
+    Tv_l1_level
+    (
+        const Plane& I0,
+        const Plane& I1,
+        Plane& u1,
+        Plane& u2,
+        const Tv_l1_flow_options& options
+    ) :
+        I0_(I0),
+        I1_(I1),
+        u1_(u1),
+        u2_(u2),
+        options_(options),
+        I1x_(I0.rows, I0.cols),
+        I1y_(I0.rows, I0.cols),
+        I1wx_(I0.rows, I0.cols),
+        I1wy_(I0.rows, I0.cols),
+        grad2_(I0.rows, I0.cols),
+        rho_c_(I0.rows, I0.cols),
+        p11_(I0.rows, I0.cols),
+        p12_(I0.rows, I0.cols),
+        p21_(I0.rows, I0.cols),
+        p22_(I0.rows, I0.cols)
+    {}
+
+    void solve(size_t nt)
+    {
+        if(nt > (size_t)I0_.rows)
+        {
+            nt = I0_.rows;
+        }
+
+        for_bands(I0_.rows, nt, boost::bind(gradient, boost::cref(I1_),
+                                            boost::ref(I1x_), boost::ref(I1y_),
+                                            _1, _2));
+
+        boost::barrier barrier(std::max(nt, (size_t)1));
+        for_bands(I0_.rows, nt, boost::bind(&Tv_l1_level::solve_band, this,
+                                            boost::ref(barrier), _1, _2));
+    }
+
+private:
+    void solve_band(boost::barrier& barrier, int first, int last)
+    {
+        std::vector<float> s1(I0_.cols);
+        std::vector<float> s2(I0_.cols);
+        std::vector<float> s3(I0_.cols);
+        std::vector<float> s4(I0_.cols);
+        std::vector<float> s5(I0_.cols);
+        std::vector<float> s6(I0_.cols);
+
+        for(size_t w = 0; w < options_.num_warps; w++)
+        {
+            warp(first, last);
+            for(size_t n = 0; n < options_.num_iterations; n++)
+            {
+                primal_step(first, last, s1, s2, s3);
+                barrier.wait();
+                dual_step(first, last, s1, s2, s3, s4, s5, s6);
+                barrier.wait();
+            }
+        }
+    }
+
+    /** @brief  Linearizes the data term about the current flow. */
+    void warp(int first, int last)
+    {
+        const int cols = I0_.cols;
+        for(int i = first; i < last; i++)
+        {
+            const float* i0 = I0_.row(i);
+            const float* a1 = u1_.row(i);
+            const float* a2 = u2_.row(i);
+            float* wx = I1wx_.row(i);
+            float* wy = I1wy_.row(i);
+            float* g2 = grad2_.row(i);
+            float* rc = rho_c_.row(i);
+
+            for(int j = 0; j < cols; j++)
+            {
+                const float x = j + a1[j];
+                const float y = i + a2[j];
+                wx[j] = sample(I1x_, x, y);
+                wy[j] = sample(I1y_, x, y);
+                rc[j] = sample(I1_, x, y) - i0[j];
+            }
+
+            for(int j = 0; j < cols; j++)
+            {
+                g2[j] = wx[j] * wx[j] + wy[j] * wy[j];
+                rc[j] -= wx[j] * a1[j] + wy[j] * a2[j];
+            }
+        }
+    }
+
+    /**
+     * @brief   Thresholds the data term, then adds the divergence of the
+     *          dual variables.
+     */
+    void primal_step
+    (
+        int first,
+        int last,
+        std::vector<float>& div1,
+        std::vector<float>& div2,
+        std::vector<float>& step
+    )
+    {
+        const int cols = I0_.cols;
+        const float lt = options_.lambda * options_.theta;
+        const float theta = options_.theta;
+
+        for(int i = first; i < last; i++)
+        {
+            const float* wx = I1wx_.row(i);
+            const float* wy = I1wy_.row(i);
+            const float* g2 = grad2_.row(i);
+            const float* rc = rho_c_.row(i);
+            const float* q11 = p11_.row(i);
+            const float* q21 = p21_.row(i);
+            const float* q12 = p12_.row(i);
+            const float* q22 = p22_.row(i);
+            float* a1 = u1_.row(i);
+            float* a2 = u2_.row(i);
+
+            // the last column and row of the dual variables stay zero, so
+            // only the first column and row need care
+            for(int j = 0; j < cols; j++)
+            {
+                div1[j] = q11[j] + q12[j];
+                div2[j] = q21[j] + q22[j];
+            }
+            for(int j = 1; j < cols; j++)
+            {
+                div1[j] -= q11[j - 1];
+                div2[j] -= q21[j - 1];
+            }
+            if(i > 0)
+            {
+                const float* q12_up = p12_.row(i - 1);
+                const float* q22_up = p22_.row(i - 1);
+                for(int j = 0; j < cols; j++)
+                {
+                    div1[j] -= q12_up[j];
+                    div2[j] -= q22_up[j];
+                }
+            }
+
+            // the minimizer of the data term is a step along the gradient
+            // of at most lambda * theta times its length
+            for(int j = 0; j < cols; j++)
+            {
+                const float rho = rc[j] + wx[j] * a1[j] + wy[j] * a2[j];
+                const float t = -rho / (g2[j] + 1e-10f);
+                step[j] = std::min(std::max(t, -lt), lt);
+            }
+
+            // separate loops, so that each can be vectorized
+            for(int j = 0; j < cols; j++)
+            {
+                a1[j] += step[j] * wx[j] + theta * div1[j];
+            }
+            for(int j = 0; j < cols; j++)
+            {
+                a2[j] += step[j] * wy[j] + theta * div2[j];
+            }
+        }
+    }
+
+    /** @brief  Projected gradient step on the dual variables. */
+    void dual_step
+    (
+        int first,
+        int last,
+        std::vector<float>& ux1,
+        std::vector<float>& uy1,
+        std::vector<float>& ux2,
+        std::vector<float>& uy2,
+        std::vector<float>& n1,
+        std::vector<float>& n2
+    )
+    {
+        const int cols = I0_.cols;
+        const float c = options_.tau / options_.theta;
+
+        for(int i = first; i < last; i++)
+        {
+            const float* a1 = u1_.row(i);
+            const float* a2 = u2_.row(i);
+            float* q11 = p11_.row(i);
+            float* q12 = p12_.row(i);
+            float* q21 = p21_.row(i);
+            float* q22 = p22_.row(i);
+
+            // forward differences, zero past the last column and row
+            for(int j = 0; j < cols - 1; j++)
+            {
+                ux1[j] = a1[j + 1] - a1[j];
+                ux2[j] = a2[j + 1] - a2[j];
+            }
+            ux1[cols - 1] = 0.0f;
+            ux2[cols - 1] = 0.0f;
+
+            if(i < I0_.rows - 1)
+            {
+                const float* b1 = u1_.row(i + 1);
+                const float* b2 = u2_.row(i + 1);
+                for(int j = 0; j < cols; j++)
+                {
+                    uy1[j] = b1[j] - a1[j];
+                    uy2[j] = b2[j] - a2[j];
+                }
+            }
+            else
+            {
+                std::fill(uy1.begin(), uy1.end(), 0.0f);
+                std::fill(uy2.begin(), uy2.end(), 0.0f);
+            }
+
+            // the square roots get a loop of their own, since they keep
+            // the compiler from vectorizing the loop they are in
+            for(int j = 0; j < cols; j++)
+            {
+                n1[j] = 1.0f + c * std::sqrt(ux1[j] * ux1[j] + uy1[j] * uy1[j]);
+                n2[j] = 1.0f + c * std::sqrt(ux2[j] * ux2[j] + uy2[j] * uy2[j]);
+            }
+
+            for(int j = 0; j < cols; j++)
+            {
+                q11[j] = (q11[j] + c * ux1[j]) / n1[j];
+                q12[j] = (q12[j] + c * uy1[j]) / n1[j];
+            }
+            for(int j = 0; j < cols; j++)
+            {
+                q21[j] = (q21[j] + c * ux2[j]) / n2[j];
+                q22[j] = (q22[j] + c * uy2[j]) / n2[j];
+            }
+        }
+    }
+
+    const Plane& I0_;
+    const Plane& I1_;
+    Plane& u1_;
+    Plane& u2_;
+    const Tv_l1_flow_options& options_;
+
+    Plane I1x_;
+    Plane I1y_;
+    Plane I1wx_;
+    Plane I1wy_;
+    Plane grad2_;
+    Plane rho_c_;
+    Plane p11_;
+    Plane p12_;
+    Plane p21_;
+    Plane p22_;
+};
+
+/** @brief  Copies a matrix into a plane. */
+Plane to_plane(const Matrix& m)
+{
+    Plane f(m.get_num_rows(), m.get_num_cols());
+    for(int i = 0; i < f.rows; i++)
+    {
+        float* r = f.row(i);
+        for(int j = 0; j < f.cols; j++)
+        {
+            r[j] = m(i, j);
+        }
+    }
+
+    return f;
+}
+
+/** @brief  Copies a plane into a matrix. */
+void to_matrix(const Plane& f, Matrix& m)
+{
+    m.resize(f.rows, f.cols);
+    for(int i = 0; i < f.rows; i++)
+    {
+        const float* r = f.row(i);
+        for(int j = 0; j < f.cols; j++)
+        {
+            m(i, j) = r[j];
+        }
+    }
+}
+
+} // anonymous namespace
+
+/* \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ */
+
+void kjb::compute_tv_l1_flow
+(
+    const Matrix& frame_1,
+    const Matrix& frame_2,
+    Matrix& x_flow,
+    Matrix& y_flow,
+    const Tv_l1_flow_options& options
+)
+{
+    IFT(frame_1.get_num_rows() == frame_2.get_num_rows()
+            && frame_1.get_num_cols() == frame_2.get_num_cols(),
+        Dimension_mismatch, "Frames must have the same size.");
+    IFT(frame_1.get_num_rows() > 0 && frame_1.get_num_cols() > 0,
+        Illegal_argument, "Frames must not be empty.");
+    IFT(options.lambda > 0.0 && options.theta > 0.0
+            && options.tau > 0.0 && options.tau <= 0.25,
+        Illegal_argument,
+        "TV-L1 needs positive lambda and theta, and tau in (0, 0.25].");
+
+    size_t nt = options.num_threads;
+    if(nt == 0)
+    {
+        nt = boost::thread::hardware_concurrency();
+    }
+
+    // stretch both frames to [0, 255] together, which lambda is made for
+    Plane f0 = to_plane(frame_1);
+    Plane f1 = to_plane(frame_2);
+    const float lo = std::min(
+                *std::min_element(f0.values.begin(), f0.values.end()),
+                *std::min_element(f1.values.begin(), f1.values.end()));
+    const float hi = std::max(
+                *std::max_element(f0.values.begin(), f0.values.end()),
+                *std::max_element(f1.values.begin(), f1.values.end()));
+    if(hi > lo)
+    {
+        const float s = 255.0f / (hi - lo);
+        for(size_t k = 0; k < f0.values.size(); k++)
+        {
+            f0.values[k] = s * (f0.values[k] - lo);
+            f1.values[k] = s * (f1.values[k] - lo);
+        }
+    }
+
+    std::vector<Plane> pyr_0(1, blur(f0, PRESMOOTHING_SIGMA, nt));
+    std::vector<Plane> pyr_1(1, blur(f1, PRESMOOTHING_SIGMA, nt));
+    while(pyr_0.size() < options.num_scales
+            && (pyr_0.back().rows + 1) / 2 >= MIN_LEVEL_SIZE
+            && (pyr_0.back().cols + 1) / 2 >= MIN_LEVEL_SIZE)
+    {
+        pyr_0.push_back(halve(blur(pyr_0.back(), PYRAMID_SIGMA, nt)));
+        pyr_1.push_back(halve(blur(pyr_1.back(), PYRAMID_SIGMA, nt)));
+    }
+
+    Plane u1(pyr_0.back().rows, pyr_0.back().cols);
+    Plane u2(pyr_0.back().rows, pyr_0.back().cols);
+    for(size_t l = pyr_0.size(); l-- > 0; )
+    {
+        if(u1.rows != pyr_0[l].rows || u1.cols != pyr_0[l].cols)
+        {
+            upsample_flow(u1, u2, pyr_0[l].rows, pyr_0[l].cols);
+        }
+
+        Tv_l1_level level(pyr_0[l], pyr_1[l], u1, u2, options);
+        level.solve(nt);
+    }
+
+    to_matrix(u1, x_flow);
+    to_matrix(u2, y_flow);
+}
+
+/* \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ */
+
+void kjb::compute_tv_l1_flow
+(
+    const Image& frame_1,
+    const Image& frame_2,
+    Matrix& x_flow,
+    Matrix& y_flow,
+    const Tv_l1_flow_options& options
+)
+{
+    compute_tv_l1_flow(frame_1.to_grayscale_matrix(),
+                       frame_2.to_grayscale_matrix(),
+                       x_flow, y_flow, options);
+}
+
+/* \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ */
+
+void kjb::compute_integral_flows
+(
+    const std::vector<std::string>& frame_fps,
+    std::vector<Integral_flow>& flows_x,
+    std::vector<Integral_flow>& flows_y,
+    size_t subsample_rate,
+    const Tv_l1_flow_options& options
+)
+{
+    if(frame_fps.size() < 2)
+    {
+        return;
+    }
+
+    Matrix previous = Image(frame_fps[0]).to_grayscale_matrix();
+    Matrix x_flow;
+    Matrix y_flow;
+    for(size_t f = 1; f < frame_fps.size(); f++)
+    {
+        Matrix current = Image(frame_fps[f]).to_grayscale_matrix();
+        compute_tv_l1_flow(previous, current, x_flow, y_flow, options);
+
+        flows_x.push_back(Integral_flow(x_flow, subsample_rate));
+        flows_y.push_back(Integral_flow(y_flow, subsample_rate));
+        std::swap(previous, current);
+    }
+}
@@ -0,0 +1,129 @@
+/* =========================================================================== *
+   |
+   |  Copyright (c) 1994-2011 by Kobus Barnard (author)
+   |
+   |  Personal and educational use of this code is granted, provided that this
+   |  header is kept intact, and that the authorship is not misrepresented, that
+   |  its use is acknowledged in publications, and relevant papers are cited.
+   |
+   |  For other use contact the author (kobus AT cs DOT arizona DOT edu).
+   |
+   |  Please note that the code in this file has not necessarily been adequately
+   |  tested. Naturally, there is no guarantee of performance, support, or fitness
+   |  for any particular task. Nonetheless, I am interested in hearing about
+   |  problems that you encounter.
+   |
+ * =========================================================================== */
+
+/* $Id$ */
+
+#ifndef KJB_FLOW_TV_L1_H
+#define KJB_FLOW_TV_L1_H
+
+#include <flow_cpp/flow_integral_flow.h>
+#include <m_cpp/m_matrix.h>
+#include <i_cpp/i_image.h>
+
+#include <string>
+#include <vector>
+
+/**
+ * @file
+ *
+ * Dense optical flow by the TV-L1 method of Zach, Pock and Bischof (A duality
+ * based approach for realtime TV-L1 optical flow, DAGM 2007), solved coarse
+ * to fine over an image pyramid as in Sanchez, Meinhardt-Llopis and
+ * Facciolo (TV-L1 optical flow estimation, IPOL 2013).
+ *
+ * The flow at (row, col) is the displacement, in pixels, of that pixel of
+ * the first frame to the second frame; x is along the columns and y along
+ * the rows. Each pyramid level is split into bands of rows that are solved
+ * by separate threads; the result does not depend on the number of threads.
+ */
+
+namespace kjb {
+
+/**
+ * @brief   Parameters of the TV-L1 optical flow solver.
+ */
+struct Tv_l1_flow_options
+{
+    /** @brief  Weight of the data term; smaller gives smoother flow. */
+    double lambda;
+
+    /** @brief  Tightness of the coupling between the two sub-problems. */
+    double theta;
+
+    /** @brief  Time step of the dual update; at most 0.25. */
+    double tau;
+
+    /** @brief  Maximum number of pyramid levels, each half the last. */
+    size_t num_scales;
+
+    /** @brief  Number of times the second frame is warped per level. */
+    size_t num_warps;
+
+    /** @brief  Number of iterations per warp. */
+    size_t num_iterations;
+
+    /** @brief  Number of threads to use; 0 means one per hardware thread. */
+    size_t num_threads;
+
+    Tv_l1_flow_options() :
+        lambda(0.15),
+        theta(0.3),
+        tau(0.25),
+        num_scales(5),
+        num_warps(5),
+        num_iterations(30),
+        num_threads(0)
+    {}
+};
+
+/**
+ * @brief   Computes the optical flow from frame_1 to frame_2, given as
+ *          grayscale matrices of the same size.
+ */
+void compute_tv_l1_flow
+(
+    const Matrix& frame_1,
+    const Matrix& frame_2,
+    Matrix& x_flow,
+    Matrix& y_flow,
+    const Tv_l1_flow_options& options = Tv_l1_flow_options()
+);
+
+/**
+ * @brief   Computes the optical flow from frame_1 to frame_2, using their
+ *          intensities.
+ */
+void compute_tv_l1_flow
+(
+    const Image& frame_1,
+    const Image& frame_2,
+    Matrix& x_flow,
+    Matrix& y_flow,
+    const Tv_l1_flow_options& options = Tv_l1_flow_options()
+);
+
+/**
+ * @brief   Computes the optical flow between each pair of consecutive
+ *          frames of a video and appends its integral flows to flows_x and
+ *          flows_y.
+ *
+ * Frames are read one at a time, and nothing is written to disk; the
+ * results are what Integral_flow(Matrix, subsample_rate) gives for the flow
+ * fields computed by compute_tv_l1_flow().
+ */
+void compute_integral_flows
+(
+    const std::vector<std::string>& frame_fps,
+    std::vector<Integral_flow>& flows_x,
+    std::vector<Integral_flow>& flows_y,
+    size_t subsample_rate = 1,
+    const Tv_l1_flow_options& options = Tv_l1_flow_options()
+);
+
+} //namespace kjb
+
+#endif /*KJB_FLOW_TV_L1_H */
@@ -0,0 +1,163 @@
+/* =========================================================================== *
+   |
+   |  Copyright (c) 1994-2011 by Kobus Barnard (author)
+   |
+   |  Personal and educational use of this code is granted, provided that this
+   |  header is kept intact, and that the authorship is not misrepresented, that
+   |  its use is acknowledged in publications, and relevant papers are cited.
+   |
+   |  For other use contact the author (kobus AT cs DOT arizona DOT edu).
+   |
+   |  Please note that the code in this file has not necessarily been adequately
+   |  tested. Naturally, there is no guarantee of performance, support, or fitness
+   |  for any particular task. Nonetheless, I am interested in hearing about
+   |  problems that you encounter.
+   |
+ * =========================================================================== */
+
+/* $Id$ */
+
+#include <flow_cpp/flow_integral_flow.h>
+#include <flow_cpp/flow_integral_flow_store.h>
+#include <m_cpp/m_matrix.h>
+#include <gr_cpp/gr_2D_bounding_box.h>
+#include <l_cpp/l_test.h>
+#include <l/l_init.h>
+#include <l/l_sys_io.h>
+#include <string>
+#include <vector>
+#include <sstream>
+#include <cstring>
+
+using namespace kjb;
+using namespace std;
+
+/** @brief  True if both have the same tables, bit by bit. */
+bool same_flow(const Integral_flow& f1, const Integral_flow& f2)
+{
+    return f1.img_width() == f2.img_width()
+            && f1.img_height() == f2.img_height()
+            && f1.subsample_rate() == f2.subsample_rate()
+            && f1.table_size() == f2.table_size()
+            && memcmp(f1.table(), f2.table(),
+                      f1.table_size() * sizeof(float)) == 0;
+}
+
+/** @brief  True if both give the same sums over some boxes. */
+bool same_sums(const Integral_flow& f1, const Integral_flow& f2)
+{
+    for(double x = 0.5; x < f1.img_width() + 5; x += 3.7)
+    {
+        for(double y = 1.0; y < f1.img_height() + 5; y += 4.3)
+        {
+            Axis_aligned_rectangle_2d box(Vector(x/2, y/2), x, y);
+            if(f1.flow_sum(box) != f2.flow_sum(box)) return false;
+        }
+    }
+
+    return true;
+}
+
+string file_name(const string& prefix, size_t f)
+{
+    ostringstream ost;
+    ost << prefix << f << ".txt";
+    return ost.str();
+}
+
+int main(int argc, char** argv)
+{
+    kjb_c::kjb_init();
+
+    const size_t num_frames = 5;
+    const size_t imw = 53;
+    const size_t imh = 37;
+    const string store = "integral_flow_store_test.bin";
+
+    vector<Integral_flow> flows_x;
+    vector<Integral_flow> flows_y;
+    vector<string> flow_x_fps;
+    vector<string> flow_y_fps;
+    vector<string> iflow_x_fps;
+    vector<string> iflow_y_fps;
+    for(size_t f = 0; f < num_frames; f++)
+    {
+        Matrix F_x = create_random_matrix(imh, imw) - 0.5;
+        Matrix F_y = create_random_matrix(imh, imw) + 0.5;
+        flows_x.push_back(Integral_flow(F_x));
+        flows_y.push_back(Integral_flow(F_y));
+
+        flow_x_fps.push_back(file_name("flow_store_test_x_", f));
+        flow_y_fps.push_back(file_name("flow_store_test_y_", f));
+        F_x.write(flow_x_fps.back().c_str());
+        F_y.write(flow_y_fps.back().c_str());
+
+        iflow_x_fps.push_back(file_name("flow_store_test_ix_", f));
+        iflow_y_fps.push_back(file_name("flow_store_test_iy_", f));
+        flows_x.back().write(iflow_x_fps.back());
+        flows_y.back().write(iflow_y_fps.back());
+    }
+
+    // in-memory flows give the same sums from the store
+    write_integral_flow_store(store, flows_x, flows_y);
+
+    vector<Integral_flow> stored_x;
+    vector<Integral_flow> stored_y;
+    read_integral_flow_store(store, stored_x, stored_y);
+    TEST_TRUE(stored_x.size() == num_frames && stored_y.size() == num_frames);
+    for(size_t f = 0; f < num_frames; f++)
+    {
+        TEST_TRUE(same_flow(flows_x[f], stored_x[f]));
+        TEST_TRUE(same_flow(flows_y[f], stored_y[f]));
+        TEST_TRUE(same_sums(flows_x[f], stored_x[f]));
+    }
+
+    // rebuilding the store does not disturb flows already mapped
+    Integral_flow kept = stored_y[2];
+    stored_x.clear();
+    stored_y.clear();
+
+    // from integral flow files, with several threads
+    build_integral_flow_store(store, iflow_x_fps, iflow_y_fps, 3);
+    read_integral_flow_store(store, stored_x, stored_y);
+    for(size_t f = 0; f < num_frames; f++)
+    {
+        TEST_TRUE(same_flow(Integral_flow(iflow_x_fps[f]), stored_x[f]));
+        TEST_TRUE(same_flow(Integral_flow(iflow_y_fps[f]), stored_y[f]));
+    }
+    TEST_TRUE(same_flow(flows_y[2], kept));
+
+    // from flow fields, subsampled
+    const size_t ssr = 4;
+    build_integral_flow_store_from_flows(store, flow_x_fps, flow_y_fps, ssr, 2);
+    read_integral_flow_store(store, stored_x, stored_y);
+    for(size_t f = 0; f < num_frames; f++)
+    {
+        Matrix F_x;
+        F_x.read(flow_x_fps[f].c_str());
+        TEST_TRUE(same_flow(Integral_flow(F_x, ssr), stored_x[f]));
+        TEST_TRUE(stored_x[f].subsample_rate() == ssr);
+    }
+
+    // frames of different sizes are rejected, and the old store kept
+    flows_x[3] = Integral_flow(create_random_matrix(imh, imw + 1));
+    TEST_FAIL(write_integral_flow_store(store, flows_x, flows_y));
+    read_integral_flow_store(store, stored_x, stored_y);
+    TEST_TRUE(stored_x[0].subsample_rate() == ssr);
+
+    vector<string> missing = iflow_y_fps;
+    missing[4] = "no_such_integral_flow.txt";
+    TEST_FAIL(build_integral_flow_store(store, iflow_x_fps, missing, 2));
+    TEST_FAIL(read_integral_flow_store(iflow_x_fps[0], stored_x, stored_y));
+
+    for(size_t f = 0; f < num_frames; f++)
+    {
+        kjb_c::kjb_unlink(flow_x_fps[f].c_str());
+        kjb_c::kjb_unlink(flow_y_fps[f].c_str());
+        kjb_c::kjb_unlink(iflow_x_fps[f].c_str());
+        kjb_c::kjb_unlink(iflow_y_fps[f].c_str());
+    }
+    kjb_c::kjb_unlink(store.c_str());
+
+    RETURN_VICTORIOUSLY();
+}
@@ -0,0 +1,86 @@
+/* =========================================================================== *
+   |
+   |  Copyright (c) 1994-2011 by Kobus Barnard (author)
+   |
+   |  Personal and educational use of this code is granted, provided that this
+   |  header is kept intact, and that the authorship is not misrepresented, that
+   |  its use is acknowledged in publications, and relevant papers are cited.
+   |
+   |  For other use contact the author (kobus AT cs DOT arizona DOT edu).
+   |
+   |  Please note that the code in this file has not necessarily been adequately
+   |  tested. Naturally, there is no guarantee of performance, support, or fitness
+   |  for any particular task. Nonetheless, I am interested in hearing about
+   |  problems that you encounter.
+   |
+ * =========================================================================== */
+
+/* $Id$ */
+
+#include <flow_cpp/flow_tv_l1.h>
+#include <flow_cpp/flow_dense.h>
+#include <m_cpp/m_matrix.h>
+#include <l_cpp/l_test.h>
+#include <l/l_init.h>
+#include <cmath>
+
+using namespace kjb;
+using namespace std;
+
+/** @brief  A smooth textured scene, seen at (x, y). */
+double scene(double x, double y)
+{
+    return 100.0 + 40.0 * sin(0.31 * x + 0.05 * y) * cos(0.23 * y)
+            + 30.0 * sin(0.17 * x * 0.7 + 0.29 * y + 1.0)
+            + 20.0 * cos(0.41 * x - 0.13 * y);
+}
+
+int main(int argc, char** argv)
+{
+    kjb_c::kjb_init();
+
+    const int rows = 96;
+    const int cols = 128;
+    const double dx = 1.5;
+    const double dy = -0.75;
+
+    // the scene moves by (dx, dy) from the first frame to the second
+    Matrix frame_1(rows, cols);
+    Matrix frame_2(rows, cols);
+    for(int i = 0; i < rows; i++)
+    {
+        for(int j = 0; j < cols; j++)
+        {
+            frame_1(i, j) = scene(j, i);
+            frame_2(i, j) = scene(j - dx, i - dy);
+        }
+    }
+
+    Tv_l1_flow_options options;
+    options.num_threads = 1;
+    Matrix x_flow;
+    Matrix y_flow;
+    compute_tv_l1_flow(frame_1, frame_2, x_flow, y_flow, options);
+    TEST_TRUE(x_flow.get_num_rows() == rows && x_flow.get_num_cols() == cols);
+    TEST_TRUE(y_flow.get_num_rows() == rows && y_flow.get_num_cols() == cols);
+
+    // away from the border, where the scene comes in or goes out of view
+    Axis_aligned_rectangle_2d inside(Vector(cols / 2.0, rows / 2.0),
+                                     cols - 20.0, rows - 20.0);
+    Vector flow = average_flow(x_flow, y_flow, inside);
+    TEST_TRUE(fabs(flow[0] - dx) < 0.1);
+    TEST_TRUE(fabs(flow[1] - dy) < 0.1);
+
+    // threads work on bands of rows, which does not change the result
+    options.num_threads = 3;
+    Matrix x_flow_mt;
+    Matrix y_flow_mt;
+    compute_tv_l1_flow(frame_1, frame_2, x_flow_mt, y_flow_mt, options);
+    TEST_TRUE(max_abs_difference(x_flow, x_flow_mt) == 0.0);
+    TEST_TRUE(max_abs_difference(y_flow, y_flow_mt) == 0.0);
+
+    TEST_FAIL(compute_tv_l1_flow(frame_1, Matrix(rows, cols + 1),
+                                 x_flow, y_flow, options));
+
+    RETURN_VICTORIOUSLY();
+}
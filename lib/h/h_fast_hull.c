@@ -0,0 +1,1492 @@
+
+/* $Id$ */
+
+/* =========================================================================== *
+|
+|  Copyright (c) 1994-2008 by Kobus Barnard (author).
+|
+|  Personal and educational use of this code is granted, provided that this
+|  header is kept intact, and that the authorship is not misrepresented, that
+|  its use is acknowledged in publications, and relevant papers are cited.
+|
+|  For other use contact the author (kobus AT cs DOT arizona DOT edu).
+|
+|  Please note that the code in this file has not necessarily been adequately
+|  tested. Naturally, there is no guarantee of performance, support, or fitness
+|  for any particular task. Nonetheless, I am interested in hearing about
+|  problems that you encounter.
+|
+* =========================================================================== */
+
+#include "h/h_gen.h"      /*  Only safe if first #include in a ".c" file  */
+
+#include "h/h_fast_hull.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* -------------------------------------------------------------------------- */
+
+/*
+// Points within this many machine epsilons (relative to the largest coordinate)
+// of a line or plane are taken to be on it. This plays the role of the round
+// off bound that qhull computes, and gives a similar merging of (nearly)
+// collinear edges and coplanar facets.
+*/
+#define ROUNDOFF_FACTOR   (100.0)
+
+/* -------------------------------------------------------------------------- */
+
+typedef struct Hull_point_2D
+{
+    double x;
+    double y;
+    int    index;
+}
+Hull_point_2D;
+
+/*
+// A triangle of a 3D hull under construction. The vertices are counter
+// clockwise when seen from outside, and adj[ i ] is the face across the edge
+// from v[ i ] to v[ (i + 1) % 3 ]. The points outside the face which have not
+// yet been added form a list through the next_point array.
+*/
+typedef struct Hull_face_3D
+{
+    int    v[ 3 ];
+    int    adj[ 3 ];
+    double n[ 3 ];
+    double d;
+    int    first_outside;
+    int    furthest;
+    double furthest_dist;
+    int    visit;
+    int    alive;
+}
+Hull_face_3D;
+
+typedef struct Hull_edge_3D
+{
+    int a;
+    int b;
+    int face;
+}
+Hull_edge_3D;
+
+typedef struct Hull_3D
+{
+    const double* points;
+    int           num_points;
+    double        tol;
+    Hull_face_3D* faces;
+    int           num_faces;
+    int           max_num_faces;
+    int*          next_point;
+}
+Hull_3D;
+
+/* -------------------------------------------------------------------------- */
+
+static int find_2D_convex_hull
+(
+    const Matrix*   points_mp,
+    int*            num_vertices_ptr,
+    int*            num_facets_ptr,
+    Matrix**        vertex_mpp,
+    Matrix**        normal_mpp,
+    Vector**        b_value_vpp,
+    Matrix_vector** facet_mp_list_ptr
+);
+
+static int find_3D_convex_hull
+(
+    const Matrix*   points_mp,
+    int*            num_vertices_ptr,
+    int*            num_facets_ptr,
+    Matrix**        vertex_mpp,
+    Matrix**        normal_mpp,
+    Vector**        b_value_vpp,
+    Matrix_vector** facet_mp_list_ptr
+);
+
+static int build_3D_hull(Hull_3D* hull_ptr);
+
+static int merge_3D_hull_faces
+(
+    const Matrix*   points_mp,
+    const Hull_3D*  hull_ptr,
+    int*            num_vertices_ptr,
+    int*            num_facets_ptr,
+    Matrix**        vertex_mpp,
+    Matrix**        normal_mpp,
+    Vector**        b_value_vpp,
+    Matrix_vector** facet_mp_list_ptr
+);
+
+static int add_3D_hull_face(Hull_3D* hull_ptr, int a, int b, int c);
+
+static void add_outside_point
+(
+    Hull_3D*   hull_ptr,
+    const int* faces,
+    int        num_faces,
+    int        point
+);
+
+static int push_int(int** array_ptr, int* length_ptr, int* max_length_ptr,
+                    int value);
+
+static int put_hull_output
+(
+    const Matrix*   points_mp,
+    int             num_facets,
+    const int*      facet_offsets,
+    const int*      facet_points,
+    const double*   normals,
+    const int*      vertices,
+    int             num_vertices,
+    int*            num_vertices_ptr,
+    int*            num_facets_ptr,
+    Matrix**        vertex_mpp,
+    Matrix**        normal_mpp,
+    Vector**        b_value_vpp,
+    Matrix_vector** facet_mp_list_ptr
+);
+
+static double get_roundoff_tolerance(const Matrix* points_mp);
+
+static int compare_hull_points_2D(const void* p1, const void* p2);
+
+static int compare_ints(const void* p1, const void* p2);
+
+/* -------------------------------------------------------------------------- */
+
+/* =============================================================================
+ *                          fast_find_convex_hull
+ *
+ * Finds the convex hull of 2D or 3D points without qhull
+ *
+ * This routine finds the convex hull of the rows of points_mp, and returns it
+ * in the same form as the qhull wrapper qh_find_convex_hull() does: the hull
+ * vertices (in the order of the input), the unit outward normal of each facet,
+ * the average of X.N over the points of each facet, and the points of each
+ * facet (again in the order of the input). Facets which are coplanar up to
+ * round off are merged, and points in the interior of facets or of edges are
+ * not vertices.
+ *
+ * 2D hulls are found with Andrew's monotone chain algorithm, and 3D hulls
+ * incrementally, by adding the furthest point outside of some facet until no
+ * points are outside (as qhull does). Both take O(n log n) time in the
+ * typical case. Unlike qhull, this routine uses no global state, and so it can
+ * be called from several threads at once.
+ *
+ * If any of normal_mpp, b_value_vpp, or facet_mp_list_ptr is NULL, that part
+ * of the hull is not computed.
+ *
+ * Returns:
+ *    NO_ERROR on success, ERROR on failure, and NO_SOLUTION if the points are
+ *    not 2D or 3D, or if they are degenerate (e.g., 3D points that are all
+ *    nearly coplanar), in which case the caller should use qhull, which
+ *    handles these cases by perturbing the data.
+ *
+ * Related:
+ *    find_convex_hull, Hull
+ *
+ * Index: geometry, convex hulls
+ *
+ * -----------------------------------------------------------------------------
+*/
+
+int fast_find_convex_hull
+(
+    const Matrix*   points_mp,
+    int*            num_vertices_ptr,
+    int*            num_facets_ptr,
+    Matrix**        vertex_mpp,
+    Matrix**        normal_mpp,
+    Vector**        b_value_vpp,
+    Matrix_vector** facet_mp_list_ptr
+)
+{
+    if (points_mp->num_rows <= points_mp->num_cols)
+    {
+        return NO_SOLUTION;
+    }
+    else if (points_mp->num_cols == 2)
+    {
+        return find_2D_convex_hull(points_mp, num_vertices_ptr,
+                                   num_facets_ptr, vertex_mpp, normal_mpp,
+                                   b_value_vpp, facet_mp_list_ptr);
+    }
+    else if (points_mp->num_cols == 3)
+    {
+        return find_3D_convex_hull(points_mp, num_vertices_ptr,
+                                   num_facets_ptr, vertex_mpp, normal_mpp,
+                                   b_value_vpp, facet_mp_list_ptr);
+    }
+    else
+    {
+        return NO_SOLUTION;
+    }
+}
+
+/*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\   */
+
+static int find_2D_convex_hull
+(
+    const Matrix*   points_mp,
+    int*            num_vertices_ptr,
+    int*            num_facets_ptr,
+    Matrix**        vertex_mpp,
+    Matrix**        normal_mpp,
+    Vector**        b_value_vpp,
+    Matrix_vector** facet_mp_list_ptr
+)
+{
+    const int      num_points    = points_mp->num_rows;
+    const double   tol           = get_roundoff_tolerance(points_mp);
+    Hull_point_2D* points        = NULL;
+    int*           chain         = NULL;
+    int*           vertices      = NULL;
+    int*           facet_offsets = NULL;
+    int*           facet_points  = NULL;
+    double*        normals       = NULL;
+    int            extremes[ 4 ] = { 0, 0, 0, 0 };
+    int            num_extremes  = 0;
+    int            num_kept      = 0;
+    int            num_unique    = 0;
+    int            num_chain     = 0;
+    int            lower_length;
+    int            result        = NO_ERROR;
+    int            i;
+
+
+    if (    ((points = N_TYPE_MALLOC(Hull_point_2D, num_points)) == NULL)
+         || ((chain = INT_MALLOC(2 * num_points + 1)) == NULL)
+       )
+    {
+        kjb_free(points);
+        return ERROR;
+    }
+
+    /*
+    // The points at the extremes of x and y, in counter-clockwise order, are
+    // on the hull. Points further than tol inside the polygon they make cannot
+    // be on the hull, so they are dropped before the sort (Akl and Toussaint).
+    */
+    for (i = 1; i < num_points; i++)
+    {
+        const double* row = points_mp->elements[ i ];
+
+        if (row[ 0 ] < points_mp->elements[ extremes[ 0 ] ][ 0 ]) extremes[ 0 ] = i;
+        if (row[ 1 ] < points_mp->elements[ extremes[ 1 ] ][ 1 ]) extremes[ 1 ] = i;
+        if (row[ 0 ] > points_mp->elements[ extremes[ 2 ] ][ 0 ]) extremes[ 2 ] = i;
+        if (row[ 1 ] > points_mp->elements[ extremes[ 3 ] ][ 1 ]) extremes[ 3 ] = i;
+    }
+
+    for (i = 0; i < 4; i++)
+    {
+        if (    (num_extremes == 0)
+             || (    (extremes[ i ] != extremes[ num_extremes - 1 ])
+                  && ((i < 3) || (extremes[ i ] != extremes[ 0 ]))
+                )
+           )
+        {
+            extremes[ num_extremes++ ] = extremes[ i ];
+        }
+    }
+
+    for (i = 0; i < num_points; i++)
+    {
+        const double* row = points_mp->elements[ i ];
+        int           k;
+
+        for (k = 0; k < num_extremes; k++)
+        {
+            const double* o  = points_mp->elements[ extremes[ k ] ];
+            const double* a  = points_mp->elements[ extremes[ (k + 1) % num_extremes ] ];
+            double        ax = a[ 0 ] - o[ 0 ];
+            double        ay = a[ 1 ] - o[ 1 ];
+            double cross = ax * (row[ 1 ] - o[ 1 ]) - ay * (row[ 0 ] - o[ 0 ]);
+
+            if (cross <= tol * sqrt(ax * ax + ay * ay)) break;
+        }
+
+        /* Inside all of the (at least three) edges. */
+        if ((num_extremes >= 3) && (k == num_extremes)) continue;
+
+        points[ num_kept ].x = row[ 0 ];
+        points[ num_kept ].y = row[ 1 ];
+        points[ num_kept ].index = i;
+        num_kept++;
+    }
+
+    /*
+    // Sort by x, then y, then input order, and drop repeated points, keeping
+    // the first one given.
+    */
+    qsort(points, (size_t)num_kept, sizeof(Hull_point_2D),
+          compare_hull_points_2D);
+
+    for (i = 0; i < num_kept; i++)
+    {
+        if (    (num_unique == 0)
+             || (points[ i ].x != points[ num_unique - 1 ].x)
+             || (points[ i ].y != points[ num_unique - 1 ].y)
+           )
+        {
+            points[ num_unique++ ] = points[ i ];
+        }
+    }
+
+    /*
+    // Andrew's monotone chain. The middle of three points is dropped unless
+    // it is further than tol to the right of the line through the other two,
+    // so that the chain is strictly convex and counter-clockwise.
+    */
+    for (i = 0; i < num_unique; i++)
+    {
+        while (num_chain >= 2)
+        {
+            const Hull_point_2D* o = &(points[ chain[ num_chain - 2 ] ]);
+            const Hull_point_2D* a = &(points[ chain[ num_chain - 1 ] ]);
+            double dx    = points[ i ].x - o->x;
+            double dy    = points[ i ].y - o->y;
+            double cross = (a->x - o->x) * dy - (a->y - o->y) * dx;
+
+            if (cross > tol * sqrt(dx * dx + dy * dy)) break;
+
+            num_chain--;
+        }
+
+        chain[ num_chain++ ] = i;
+    }
+
+    lower_length = num_chain + 1;
+
+    for (i = num_unique - 2; i >= 0; i--)
+    {
+        while (num_chain >= lower_length)
+        {
+            const Hull_point_2D* o = &(points[ chain[ num_chain - 2 ] ]);
+            const Hull_point_2D* a = &(points[ chain[ num_chain - 1 ] ]);
+            double dx    = points[ i ].x - o->x;
+            double dy    = points[ i ].y - o->y;
+            double cross = (a->x - o->x) * dy - (a->y - o->y) * dx;
+
+            if (cross > tol * sqrt(dx * dx + dy * dy)) break;
+
+            num_chain--;
+        }
+
+        chain[ num_chain++ ] = i;
+    }
+
+    /* The last point is the first one again. */
+    num_chain--;
+
+    if (num_chain < 3)
+    {
+        result = NO_SOLUTION;
+    }
+    else if (    ((vertices = INT_MALLOC(num_chain)) == NULL)
+              || ((facet_offsets = INT_MALLOC(num_chain + 1)) == NULL)
+              || ((facet_points = INT_MALLOC(2 * num_chain)) == NULL)
+              || ((normals = DBL_MALLOC(2 * num_chain)) == NULL)
+            )
+    {
+        result = ERROR;
+    }
+    else
+    {
+        for (i = 0; i < num_chain; i++)
+        {
+            const Hull_point_2D* a  = &(points[ chain[ i ] ]);
+            const Hull_point_2D* b  = &(points[ chain[ (i + 1) % num_chain ] ]);
+            double               dx = b->x - a->x;
+            double               dy = b->y - a->y;
+            double               length = sqrt(dx * dx + dy * dy);
+
+            vertices[ i ] = a->index;
+
+            facet_offsets[ i ] = 2 * i;
+            facet_points[ 2 * i ] = MIN_OF(a->index, b->index);
+            facet_points[ 2 * i + 1 ] = MAX_OF(a->index, b->index);
+
+            /* The outward normal of a counter-clockwise edge is on its right. */
+            normals[ 2 * i ] = dy / length;
+            normals[ 2 * i + 1 ] = -dx / length;
+        }
+
+        facet_offsets[ num_chain ] = 2 * num_chain;
+
+        qsort(vertices, (size_t)num_chain, sizeof(int), compare_ints);
+
+        result = put_hull_output(points_mp, num_chain, facet_offsets,
+                                 facet_points, normals, vertices, num_chain,
+                                 num_vertices_ptr, num_facets_ptr, vertex_mpp,
+                                 normal_mpp, b_value_vpp, facet_mp_list_ptr);
+    }
+
+    kjb_free(points);
+    kjb_free(chain);
+    kjb_free(vertices);
+    kjb_free(facet_offsets);
+    kjb_free(facet_points);
+    kjb_free(normals);
+
+    return result;
+}
+
+/*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\   */
+
+static int find_3D_convex_hull
+(
+    const Matrix*   points_mp,
+    int*            num_vertices_ptr,
+    int*            num_facets_ptr,
+    Matrix**        vertex_mpp,
+    Matrix**        normal_mpp,
+    Vector**        b_value_vpp,
+    Matrix_vector** facet_mp_list_ptr
+)
+{
+    const int num_points = points_mp->num_rows;
+    Hull_3D   hull;
+    double*   points;
+    int       result;
+    int       i, j;
+
+
+    hull.num_points = num_points;
+    hull.tol = get_roundoff_tolerance(points_mp);
+    hull.faces = NULL;
+    hull.num_faces = 0;
+    hull.max_num_faces = 0;
+    hull.next_point = NULL;
+
+    if (    ((points = DBL_MALLOC(3 * num_points)) == NULL)
+         || ((hull.next_point = INT_MALLOC(num_points)) == NULL)
+       )
+    {
+        kjb_free(points);
+        return ERROR;
+    }
+
+    for (i = 0; i < num_points; i++)
+    {
+        for (j = 0; j < 3; j++)
+        {
+            points[ 3 * i + j ] = points_mp->elements[ i ][ j ];
+        }
+    }
+
+    hull.points = points;
+
+    result = build_3D_hull(&hull);
+
+    if (result == NO_ERROR)
+    {
+        result = merge_3D_hull_faces(points_mp, &hull, num_vertices_ptr,
+                                     num_facets_ptr, vertex_mpp, normal_mpp,
+                                     b_value_vpp, facet_mp_list_ptr);
+    }
+
+    kjb_free(points);
+    kjb_free(hull.next_point);
+    kjb_free(hull.faces);
+
+    return result;
+}
+
+/*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\   */
+
+/*
+// Builds the triangulated hull. We start with the tetrahedron on four extreme
+// points, and put every other point into the outside set of the first face it
+// is outside of. Then, while some face has an outside set, we add the point
+// of that set furthest from it: the faces which that point is outside of are
+// replaced by a fan of triangles joining the point to their boundary (the
+// horizon), and their outside sets are spread over the new faces.
+//
+// If the geometry is too close to degenerate for this to be done cleanly (the
+// points are nearly coplanar, or the horizon is not a simple cycle), we return
+// NO_SOLUTION and leave the hull to qhull.
+*/
+static int build_3D_hull(Hull_3D* hull_ptr)
+{
+    const double* points     = hull_ptr->points;
+    const int     num_points = hull_ptr->num_points;
+    const double  tol        = hull_ptr->tol;
+    int           extremes[ 6 ];
+    int           simplex[ 4 ];
+    double        best_dist;
+    double        e1[ 3 ], e2[ 3 ], n[ 3 ];
+    double        n_norm;
+    int*          start_face = NULL;
+    int*          end_face   = NULL;
+    int*          work       = NULL;
+    int           work_length = 0;
+    int           max_work_length = 0;
+    int*          visible    = NULL;
+    int           num_visible;
+    int           max_num_visible = 0;
+    int*          new_faces  = NULL;
+    int           num_new_faces;
+    int           max_num_new_faces = 0;
+    Hull_edge_3D* horizon    = NULL;
+    int           num_horizon;
+    int           max_num_horizon = 0;
+    int           visit      = 0;
+    int           result     = NO_ERROR;
+    int           i, j, k;
+
+
+    /* The points with the smallest and largest coordinate along each axis. */
+    for (j = 0; j < 3; j++)
+    {
+        extremes[ 2 * j ] = 0;
+        extremes[ 2 * j + 1 ] = 0;
+
+        for (i = 1; i < num_points; i++)
+        {
+            if (points[ 3 * i + j ] < points[ 3 * extremes[ 2 * j ] + j ])
+            {
+                extremes[ 2 * j ] = i;
+            }
+
+            if (points[ 3 * i + j ] > points[ 3 * extremes[ 2 * j + 1 ] + j ])
+            {
+                extremes[ 2 * j + 1 ] = i;
+            }
+        }
+    }
+
+    /* The first two vertices are the pair of extremes furthest apart. */
+    best_dist = -1.0;
+    simplex[ 0 ] = simplex[ 1 ] = 0;
+
+    for (j = 0; j < 3; j++)
+    {
+        const double* a = points + 3 * extremes[ 2 * j ];
+        const double* b = points + 3 * extremes[ 2 * j + 1 ];
+        double dist = sqrt((b[ 0 ] - a[ 0 ]) * (b[ 0 ] - a[ 0 ])
+                            + (b[ 1 ] - a[ 1 ]) * (b[ 1 ] - a[ 1 ])
+                            + (b[ 2 ] - a[ 2 ]) * (b[ 2 ] - a[ 2 ]));
+
+        if (dist > best_dist)
+        {
+            best_dist = dist;
+            simplex[ 0 ] = extremes[ 2 * j ];
+            simplex[ 1 ] = extremes[ 2 * j + 1 ];
+        }
+    }
+
+    if (best_dist <= tol) return NO_SOLUTION;
+
+    /* The third is the point furthest from the line through them. */
+    for (j = 0; j < 3; j++)
+    {
+        e1[ j ] = points[ 3 * simplex[ 1 ] + j ] - points[ 3 * simplex[ 0 ] + j ];
+    }
+
+    best_dist = -1.0;
+
+    for (i = 0; i < num_points; i++)
+    {
+        double dist;
+
+        for (j = 0; j < 3; j++)
+        {
+            e2[ j ] = points[ 3 * i + j ] - points[ 3 * simplex[ 0 ] + j ];
+        }
+
+        n[ 0 ] = e1[ 1 ] * e2[ 2 ] - e1[ 2 ] * e2[ 1 ];
+        n[ 1 ] = e1[ 2 ] * e2[ 0 ] - e1[ 0 ] * e2[ 2 ];
+        n[ 2 ] = e1[ 0 ] * e2[ 1 ] - e1[ 1 ] * e2[ 0 ];
+
+        dist = n[ 0 ] * n[ 0 ] + n[ 1 ] * n[ 1 ] + n[ 2 ] * n[ 2 ];
+
+        if (dist > best_dist)
+        {
+            best_dist = dist;
+            simplex[ 2 ] = i;
+        }
+    }
+
+    if (sqrt(best_dist) <= tol * sqrt(e1[ 0 ] * e1[ 0 ] + e1[ 1 ] * e1[ 1 ]
+                                                        + e1[ 2 ] * e1[ 2 ]))
+    {
+        return NO_SOLUTION;
+    }
+
+    /* The fourth is the point furthest from the plane through all three. */
+    for (j = 0; j < 3; j++)
+    {
+        e2[ j ] = points[ 3 * simplex[ 2 ] + j ] - points[ 3 * simplex[ 0 ] + j ];
+    }
+
+    n[ 0 ] = e1[ 1 ] * e2[ 2 ] - e1[ 2 ] * e2[ 1 ];
+    n[ 1 ] = e1[ 2 ] * e2[ 0 ] - e1[ 0 ] * e2[ 2 ];
+    n[ 2 ] = e1[ 0 ] * e2[ 1 ] - e1[ 1 ] * e2[ 0 ];
+    n_norm = sqrt(n[ 0 ] * n[ 0 ] + n[ 1 ] * n[ 1 ] + n[ 2 ] * n[ 2 ]);
+
+    best_dist = -1.0;
+
+    for (i = 0; i < num_points; i++)
+    {
+        double dist = 0.0;
+
+        for (j = 0; j < 3; j++)
+        {
+            dist += n[ j ] * (points[ 3 * i + j ] - points[ 3 * simplex[ 0 ] + j ]);
+        }
+
+        dist = ABS_OF(dist) / n_norm;
+
+        if (dist > best_dist)
+        {
+            best_dist = dist;
+            simplex[ 3 ] = i;
+        }
+    }
+
+    if (best_dist <= tol) return NO_SOLUTION;
+
+    /*
+    // The faces of the tetrahedron are the triples leaving out one vertex,
+    // oriented so that the vertex left out is inside.
+    */
+    for (k = 0; k < 4; k++)
+    {
+        int tri[ 3 ];
+        int m = 0;
+        int f;
+
+        for (i = 0; i < 4; i++)
+        {
+            if (i != k) tri[ m++ ] = simplex[ i ];
+        }
+
+        ERE(f = add_3D_hull_face(hull_ptr, tri[ 0 ], tri[ 1 ], tri[ 2 ]));
+
+        if (f == NOT_SET) return NO_SOLUTION;
+
+        if (    hull_ptr->faces[ f ].n[ 0 ] * points[ 3 * simplex[ k ] ]
+              + hull_ptr->faces[ f ].n[ 1 ] * points[ 3 * simplex[ k ] + 1 ]
+              + hull_ptr->faces[ f ].n[ 2 ] * points[ 3 * simplex[ k ] + 2 ]
+            > hull_ptr->faces[ f ].d
+           )
+        {
+            hull_ptr->num_faces--;
+            ERE(f = add_3D_hull_face(hull_ptr, tri[ 0 ], tri[ 2 ], tri[ 1 ]));
+            if (f == NOT_SET) return NO_SOLUTION;
+        }
+    }
+
+    for (k = 0; k < 4; k++)
+    {
+        Hull_face_3D* face_ptr = &(hull_ptr->faces[ k ]);
+
+        for (i = 0; i < 3; i++)
+        {
+            int a = face_ptr->v[ i ];
+            int b = face_ptr->v[ (i + 1) % 3 ];
+            int f;
+
+            for (f = 0; f < 4; f++)
+            {
+                const Hull_face_3D* other_ptr = &(hull_ptr->faces[ f ]);
+
+                if (    (f != k)
+                     && (    ((other_ptr->v[ 0 ] == b) && (other_ptr->v[ 1 ] == a))
+                          || ((other_ptr->v[ 1 ] == b) && (other_ptr->v[ 2 ] == a))
+                          || ((other_ptr->v[ 2 ] == b) && (other_ptr->v[ 0 ] == a))
+                        )
+                   )
+                {
+                    face_ptr->adj[ i ] = f;
+                }
+            }
+        }
+    }
+
+    {
+        int first_faces[ 4 ] = { 0, 1, 2, 3 };
+
+        for (i = 0; i < num_points; i++)
+        {
+            if (    (i != simplex[ 0 ]) && (i != simplex[ 1 ])
+                 && (i != simplex[ 2 ]) && (i != simplex[ 3 ])
+               )
+            {
+                add_outside_point(hull_ptr, first_faces, 4, i);
+            }
+        }
+    }
+
+    if (    ((start_face = INT_MALLOC(num_points)) == NULL)
+         || ((end_face = INT_MALLOC(num_points)) == NULL)
+       )
+    {
+        kjb_free(start_face);
+        return ERROR;
+    }
+
+    for (i = 0; i < num_points; i++)
+    {
+        start_face[ i ] = NOT_SET;
+        end_face[ i ] = NOT_SET;
+    }
+
+    for (k = 0; k < 4; k++)
+    {
+        if (hull_ptr->faces[ k ].first_outside != NOT_SET)
+        {
+            result = push_int(&work, &work_length, &max_work_length, k);
+            if (result == ERROR) break;
+        }
+    }
+
+    while ((result == NO_ERROR) && (work_length > 0))
+    {
+        int           f = work[ --work_length ];
+        const double* p;
+        int           p_index;
+        int           point;
+
+        if (    ( ! hull_ptr->faces[ f ].alive)
+             || (hull_ptr->faces[ f ].first_outside == NOT_SET)
+           )
+        {
+            continue;
+        }
+
+        p_index = hull_ptr->faces[ f ].furthest;
+        p = points + 3 * p_index;
+
+        /*
+        // Find the faces that p is outside of by searching from f, and the
+        // horizon edges between them and the rest.
+        */
+        visit++;
+        num_visible = 0;
+        num_horizon = 0;
+
+        hull_ptr->faces[ f ].visit = visit;
+        result = push_int(&visible, &num_visible, &max_num_visible, f);
+
+        for (k = 0; (result == NO_ERROR) && (k < num_visible); k++)
+        {
+            for (i = 0; i < 3; i++)
+            {
+                const Hull_face_3D* face_ptr = &(hull_ptr->faces[ visible[ k ] ]);
+                int                 g        = face_ptr->adj[ i ];
+                Hull_face_3D*       g_ptr    = &(hull_ptr->faces[ g ]);
+
+                if (g_ptr->visit == visit) continue;
+
+                if (    g_ptr->n[ 0 ] * p[ 0 ] + g_ptr->n[ 1 ] * p[ 1 ]
+                      + g_ptr->n[ 2 ] * p[ 2 ] - g_ptr->d
+                      > tol
+                   )
+                {
+                    g_ptr->visit = visit;
+                    result = push_int(&visible, &num_visible,
+                                      &max_num_visible, g);
+                    if (result == ERROR) break;
+                }
+                else
+                {
+                    if (num_horizon == max_num_horizon)
+                    {
+                        int new_max = MAX_OF(16, 2 * max_num_horizon);
+                        Hull_edge_3D* new_horizon = N_TYPE_REALLOC(horizon,
+                                                                   Hull_edge_3D,
+                                                                   new_max);
+
+                        if (new_horizon == NULL)
+                        {
+                            result = ERROR;
+                            break;
+                        }
+
+                        horizon = new_horizon;
+                        max_num_horizon = new_max;
+                    }
+
+                    horizon[ num_horizon ].a = face_ptr->v[ i ];
+                    horizon[ num_horizon ].b = face_ptr->v[ (i + 1) % 3 ];
+                    horizon[ num_horizon ].face = g;
+                    num_horizon++;
+                }
+            }
+        }
+
+        if (result == ERROR) break;
+
+        /* The horizon must be a simple cycle. */
+        for (i = 0; i < num_horizon; i++)
+        {
+            if (    (start_face[ horizon[ i ].a ] != NOT_SET)
+                 || (end_face[ horizon[ i ].b ] != NOT_SET)
+               )
+            {
+                result = NO_SOLUTION;
+                break;
+            }
+
+            /* Only marks, for now. */
+            start_face[ horizon[ i ].a ] = i;
+            end_face[ horizon[ i ].b ] = i;
+        }
+
+        if (result == NO_SOLUTION)
+        {
+            for (i = 0; i < num_horizon; i++)
+            {
+                start_face[ horizon[ i ].a ] = NOT_SET;
+                end_face[ horizon[ i ].b ] = NOT_SET;
+            }
+            break;
+        }
+
+        /* Join p to the horizon. */
+        num_new_faces = 0;
+
+        for (i = 0; i < num_horizon; i++)
+        {
+            int a = horizon[ i ].a;
+            int b = horizon[ i ].b;
+            int g = horizon[ i ].face;
+            int nf;
+
+            nf = add_3D_hull_face(hull_ptr, a, b, p_index);
+
+            if ((nf == ERROR) || (nf == NOT_SET))
+            {
+                result = (nf == ERROR) ? ERROR : NO_SOLUTION;
+                break;
+            }
+
+            result = push_int(&new_faces, &num_new_faces, &max_num_new_faces,
+                              nf);
+            if (result == ERROR) break;
+
+            hull_ptr->faces[ nf ].adj[ 0 ] = g;
+
+            for (j = 0; j < 3; j++)
+            {
+                if (    (hull_ptr->faces[ g ].v[ j ] == b)
+                     && (hull_ptr->faces[ g ].v[ (j + 1) % 3 ] == a)
+                   )
+                {
+                    hull_ptr->faces[ g ].adj[ j ] = nf;
+                }
+            }
+
+            start_face[ a ] = nf;
+            end_face[ b ] = nf;
+        }
+
+        if (result == NO_ERROR)
+        {
+            for (i = 0; i < num_new_faces; i++)
+            {
+                Hull_face_3D* face_ptr = &(hull_ptr->faces[ new_faces[ i ] ]);
+
+                face_ptr->adj[ 1 ] = start_face[ face_ptr->v[ 1 ] ];
+                face_ptr->adj[ 2 ] = end_face[ face_ptr->v[ 0 ] ];
+            }
+        }
+
+        for (i = 0; i < num_horizon; i++)
+        {
+            start_face[ horizon[ i ].a ] = NOT_SET;
+            end_face[ horizon[ i ].b ] = NOT_SET;
+        }
+
+        if (result != NO_ERROR) break;
+
+        /* Spread the outside sets of the faces replaced over the new ones. */
+        for (k = 0; k < num_visible; k++)
+        {
+            Hull_face_3D* face_ptr = &(hull_ptr->faces[ visible[ k ] ]);
+
+            point = face_ptr->first_outside;
+
+            while (point != NOT_SET)
+            {
+                int next = hull_ptr->next_point[ point ];
+
+                if (point != p_index)
+                {
+                    add_outside_point(hull_ptr, new_faces, num_new_faces,
+                                      point);
+                }
+
+                point = next;
+            }
+
+            face_ptr->first_outside = NOT_SET;
+            face_ptr->alive = FALSE;
+        }
+
+        for (i = 0; i < num_new_faces; i++)
+        {
+            if (hull_ptr->faces[ new_faces[ i ] ].first_outside != NOT_SET)
+            {
+                result = push_int(&work, &work_length, &max_work_length,
+                                  new_faces[ i ]);
+                if (result == ERROR) break;
+            }
+        }
+    }
+
+    kjb_free(start_face);
+    kjb_free(end_face);
+    kjb_free(work);
+    kjb_free(visible);
+    kjb_free(new_faces);
+    kjb_free(horizon);
+
+    return result;
+}
+
+/*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\   */
+
+/*
+// Merges the triangles of the hull that are coplanar up to round off into the
+// facets of the result. A vertex which is in fewer than three facets is in the
+// interior of a facet or an edge, and is dropped.
+*/
+static int merge_3D_hull_faces
+(
+    const Matrix*   points_mp,
+    const Hull_3D*  hull_ptr,
+    int*            num_vertices_ptr,
+    int*            num_facets_ptr,
+    Matrix**        vertex_mpp,
+    Matrix**        normal_mpp,
+    Vector**        b_value_vpp,
+    Matrix_vector** facet_mp_list_ptr
+)
+{
+    const double*       points     = hull_ptr->points;
+    const int           num_points = hull_ptr->num_points;
+    const int           num_faces  = hull_ptr->num_faces;
+    const Hull_face_3D* faces      = hull_ptr->faces;
+    int*    face_group     = NULL;
+    int*    group_faces    = NULL;
+    int*    group_offsets  = NULL;
+    double* normals        = NULL;
+    int*    point_group    = NULL;
+    int*    num_point_groups = NULL;
+    int*    facet_offsets  = NULL;
+    int*    facet_points   = NULL;
+    int     max_num_facet_points = 0;
+    int*    vertices       = NULL;
+    int     num_vertices   = 0;
+    int     num_groups     = 0;
+    int     num_grouped    = 0;
+    int     num_facet_points = 0;
+    int     result         = NO_ERROR;
+    int     f, g, i, j, k;
+
+
+    if (    ((face_group = INT_MALLOC(num_faces)) == NULL)
+         || ((group_faces = INT_MALLOC(num_faces)) == NULL)
+         || ((group_offsets = INT_MALLOC(num_faces + 1)) == NULL)
+         || ((normals = DBL_MALLOC(3 * num_faces)) == NULL)
+         || ((point_group = INT_MALLOC(num_points)) == NULL)
+         || ((num_point_groups = INT_MALLOC(num_points)) == NULL)
+         || ((facet_offsets = INT_MALLOC(num_faces + 1)) == NULL)
+         || ((vertices = INT_MALLOC(num_points)) == NULL)
+       )
+    {
+        result = ERROR;
+    }
+
+    if (result == NO_ERROR)
+    {
+        for (f = 0; f < num_faces; f++)
+        {
+            face_group[ f ] = NOT_SET;
+        }
+
+        for (i = 0; i < num_points; i++)
+        {
+            point_group[ i ] = NOT_SET;
+            num_point_groups[ i ] = 0;
+        }
+
+        /*
+        // Grow each group from a seed face through neighbours whose vertices
+        // are on the plane of the seed.
+        */
+        for (f = 0; f < num_faces; f++)
+        {
+            const Hull_face_3D* seed_ptr = &(faces[ f ]);
+
+            if (( ! seed_ptr->alive) || (face_group[ f ] != NOT_SET)) continue;
+
+            group_offsets[ num_groups ] = num_grouped;
+            face_group[ f ] = num_groups;
+            group_faces[ num_grouped++ ] = f;
+
+            for (k = group_offsets[ num_groups ]; k < num_grouped; k++)
+            {
+                const Hull_face_3D* face_ptr = &(faces[ group_faces[ k ] ]);
+
+                for (i = 0; i < 3; i++)
+                {
+                    const Hull_face_3D* other_ptr;
+                    int                 h = face_ptr->adj[ i ];
+                    int                 is_coplanar = TRUE;
+
+                    if (face_group[ h ] != NOT_SET) continue;
+
+                    other_ptr = &(faces[ h ]);
+
+                    if (    seed_ptr->n[ 0 ] * other_ptr->n[ 0 ]
+                          + seed_ptr->n[ 1 ] * other_ptr->n[ 1 ]
+                          + seed_ptr->n[ 2 ] * other_ptr->n[ 2 ]
+                          <= 0.0
+                       )
+                    {
+                        continue;
+                    }
+
+                    for (j = 0; j < 3; j++)
+                    {
+                        const double* v = points + 3 * other_ptr->v[ j ];
+                        double dist =   seed_ptr->n[ 0 ] * v[ 0 ]
+                                      + seed_ptr->n[ 1 ] * v[ 1 ]
+                                      + seed_ptr->n[ 2 ] * v[ 2 ]
+                                      - seed_ptr->d;
+
+                        if (ABS_OF(dist) > hull_ptr->tol)
+                        {
+                            is_coplanar = FALSE;
+                            break;
+                        }
+                    }
+
+                    if (is_coplanar)
+                    {
+                        face_group[ h ] = num_groups;
+                        group_faces[ num_grouped++ ] = h;
+                    }
+                }
+            }
+
+            num_groups++;
+        }
+
+        group_offsets[ num_groups ] = num_grouped;
+
+        /*
+        // The normal of a group is the area weighted average of the normals of
+        // its triangles, and its points are those of the triangles.
+        */
+        for (g = 0; g < num_groups; g++)
+        {
+            double* n = normals + 3 * g;
+            double  n_norm;
+
+            n[ 0 ] = n[ 1 ] = n[ 2 ] = 0.0;
+
+            for (k = group_offsets[ g ]; k < group_offsets[ g + 1 ]; k++)
+            {
+                const Hull_face_3D* face_ptr = &(faces[ group_faces[ k ] ]);
+                const double* a = points + 3 * face_ptr->v[ 0 ];
+                const double* b = points + 3 * face_ptr->v[ 1 ];
+                const double* c = points + 3 * face_ptr->v[ 2 ];
+                double e1[ 3 ], e2[ 3 ];
+
+                for (j = 0; j < 3; j++)
+                {
+                    e1[ j ] = b[ j ] - a[ j ];
+                    e2[ j ] = c[ j ] - a[ j ];
+                }
+
+                n[ 0 ] += e1[ 1 ] * e2[ 2 ] - e1[ 2 ] * e2[ 1 ];
+                n[ 1 ] += e1[ 2 ] * e2[ 0 ] - e1[ 0 ] * e2[ 2 ];
+                n[ 2 ] += e1[ 0 ] * e2[ 1 ] - e1[ 1 ] * e2[ 0 ];
+
+                for (j = 0; j < 3; j++)
+                {
+                    int v = face_ptr->v[ j ];
+
+                    if (point_group[ v ] != g)
+                    {
+                        point_group[ v ] = g;
+                        num_point_groups[ v ]++;
+                    }
+                }
+            }
+
+            n_norm = sqrt(n[ 0 ] * n[ 0 ] + n[ 1 ] * n[ 1 ] + n[ 2 ] * n[ 2 ]);
+
+            n[ 0 ] /= n_norm;
+            n[ 1 ] /= n_norm;
+            n[ 2 ] /= n_norm;
+        }
+
+        for (i = 0; i < num_points; i++)
+        {
+            point_group[ i ] = NOT_SET;
+
+            if (num_point_groups[ i ] >= 3)
+            {
+                vertices[ num_vertices++ ] = i;
+            }
+        }
+
+        for (g = 0; g < num_groups; g++)
+        {
+            int first = num_facet_points;
+
+            facet_offsets[ g ] = first;
+
+            for (k = group_offsets[ g ]; k < group_offsets[ g + 1 ]; k++)
+            {
+                const Hull_face_3D* face_ptr = &(faces[ group_faces[ k ] ]);
+
+                for (j = 0; j < 3; j++)
+                {
+                    int v = face_ptr->v[ j ];
+
+                    if ((point_group[ v ] != g) && (num_point_groups[ v ] >= 3))
+                    {
+                        point_group[ v ] = g;
+                        result = push_int(&facet_points, &num_facet_points,
+                                          &max_num_facet_points, v);
+                        if (result == ERROR) break;
+                    }
+                }
+
+                if (result == ERROR) break;
+            }
+
+            if (result == ERROR) break;
+
+            /* Only possible if the merging went wrong due to round off. */
+            if (num_facet_points - first < 3)
+            {
+                result = NO_SOLUTION;
+                break;
+            }
+
+            qsort(facet_points + first, (size_t)(num_facet_points - first),
+                  sizeof(int), compare_ints);
+        }
+
+        facet_offsets[ num_groups ] = num_facet_points;
+    }
+
+    if (result == NO_ERROR)
+    {
+        result = put_hull_output(points_mp, num_groups, facet_offsets,
+                                 facet_points, normals, vertices, num_vertices,
+                                 num_vertices_ptr, num_facets_ptr, vertex_mpp,
+                                 normal_mpp, b_value_vpp, facet_mp_list_ptr);
+    }
+
+    kjb_free(face_group);
+    kjb_free(group_faces);
+    kjb_free(group_offsets);
+    kjb_free(normals);
+    kjb_free(point_group);
+    kjb_free(num_point_groups);
+    kjb_free(facet_offsets);
+    kjb_free(facet_points);
+    kjb_free(vertices);
+
+    return result;
+}
+
+/*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\   */
+
+/*
+// Adds the face (a, b, c) and sets its plane. Returns the index of the new
+// face, NOT_SET if the face is too thin to have a reliable normal, or ERROR.
+*/
+static int add_3D_hull_face(Hull_3D* hull_ptr, int a, int b, int c)
+{
+    const double* pa = hull_ptr->points + 3 * a;
+    const double* pb = hull_ptr->points + 3 * b;
+    const double* pc = hull_ptr->points + 3 * c;
+    Hull_face_3D* face_ptr;
+    double        e1[ 3 ], e2[ 3 ];
+    double        n_norm;
+    int           j;
+
+
+    if (hull_ptr->num_faces == hull_ptr->max_num_faces)
+    {
+        int new_max = MAX_OF(64, 2 * hull_ptr->max_num_faces);
+        Hull_face_3D* new_faces = N_TYPE_REALLOC(hull_ptr->faces, Hull_face_3D,
+                                                 new_max);
+
+        NRE(new_faces);
+
+        hull_ptr->faces = new_faces;
+        hull_ptr->max_num_faces = new_max;
+    }
+
+    face_ptr = &(hull_ptr->faces[ hull_ptr->num_faces ]);
+
+    face_ptr->v[ 0 ] = a;
+    face_ptr->v[ 1 ] = b;
+    face_ptr->v[ 2 ] = c;
+    face_ptr->adj[ 0 ] = face_ptr->adj[ 1 ] = face_ptr->adj[ 2 ] = NOT_SET;
+    face_ptr->first_outside = NOT_SET;
+    face_ptr->furthest = NOT_SET;
+    face_ptr->furthest_dist = 0.0;
+    face_ptr->visit = 0;
+    face_ptr->alive = TRUE;
+
+    for (j = 0; j < 3; j++)
+    {
+        e1[ j ] = pb[ j ] - pa[ j ];
+        e2[ j ] = pc[ j ] - pa[ j ];
+    }
+
+    face_ptr->n[ 0 ] = e1[ 1 ] * e2[ 2 ] - e1[ 2 ] * e2[ 1 ];
+    face_ptr->n[ 1 ] = e1[ 2 ] * e2[ 0 ] - e1[ 0 ] * e2[ 2 ];
+    face_ptr->n[ 2 ] = e1[ 0 ] * e2[ 1 ] - e1[ 1 ] * e2[ 0 ];
+
+    n_norm = sqrt(  face_ptr->n[ 0 ] * face_ptr->n[ 0 ]
+                  + face_ptr->n[ 1 ] * face_ptr->n[ 1 ]
+                  + face_ptr->n[ 2 ] * face_ptr->n[ 2 ]);
+
+    if ( ! (n_norm > 0.0)) return NOT_SET;
+
+    face_ptr->d = 0.0;
+
+    for (j = 0; j < 3; j++)
+    {
+        face_ptr->n[ j ] /= n_norm;
+        face_ptr->d += face_ptr->n[ j ] * (pa[ j ] + pb[ j ] + pc[ j ]) / 3.0;
+    }
+
+    return hull_ptr->num_faces++;
+}
+
+/*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\   */
+
+/*
+// Puts a point into the outside set of the first of the given faces that it is
+// further than tol outside of. If there is no such face, the point is inside
+// the hull and is forgotten.
+*/
+static void add_outside_point
+(
+    Hull_3D*   hull_ptr,
+    const int* faces,
+    int        num_faces,
+    int        point
+)
+{
+    const double* p = hull_ptr->points + 3 * point;
+    int           i;
+
+
+    for (i = 0; i < num_faces; i++)
+    {
+        Hull_face_3D* face_ptr = &(hull_ptr->faces[ faces[ i ] ]);
+        double dist =   face_ptr->n[ 0 ] * p[ 0 ] + face_ptr->n[ 1 ] * p[ 1 ]
+                      + face_ptr->n[ 2 ] * p[ 2 ] - face_ptr->d;
+
+        if (dist > hull_ptr->tol)
+        {
+            hull_ptr->next_point[ point ] = face_ptr->first_outside;
+            face_ptr->first_outside = point;
+
+            if ((face_ptr->furthest == NOT_SET) || (dist > face_ptr->furthest_dist))
+            {
+                face_ptr->furthest = point;
+                face_ptr->furthest_dist = dist;
+            }
+
+            return;
+        }
+    }
+}
+
+/*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\   */
+
+static int push_int(int** array_ptr, int* length_ptr, int* max_length_ptr,
+                    int value)
+{
+    if (*length_ptr == *max_length_ptr)
+    {
+        int  new_max   = MAX_OF(16, 2 * (*max_length_ptr));
+        int* new_array = N_TYPE_REALLOC(*array_ptr, int, new_max);
+
+        NRE(new_array);
+
+        *array_ptr = new_array;
+        *max_length_ptr = new_max;
+    }
+
+    (*array_ptr)[ (*length_ptr)++ ] = value;
+
+    return NO_ERROR;
+}
+
+/*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\   */
+
+/*
+// Fills in the hull the way qh_find_convex_hull() does. The b value of each
+// facet is the average of X.N over its points.
+*/
+static int put_hull_output
+(
+    const Matrix*   points_mp,
+    int             num_facets,
+    const int*      facet_offsets,
+    const int*      facet_points,
+    const double*   normals,
+    const int*      vertices,
+    int             num_vertices,
+    int*            num_vertices_ptr,
+    int*            num_facets_ptr,
+    Matrix**        vertex_mpp,
+    Matrix**        normal_mpp,
+    Vector**        b_value_vpp,
+    Matrix_vector** facet_mp_list_ptr
+)
+{
+    const int dim = points_mp->num_cols;
+    int       i, j, k;
+
+
+    if (vertex_mpp != NULL)
+    {
+        ERE(get_target_matrix(vertex_mpp, num_vertices, dim));
+
+        for (i = 0; i < num_vertices; i++)
+        {
+            for (j = 0; j < dim; j++)
+            {
+                (*vertex_mpp)->elements[ i ][ j ] =
+                                    points_mp->elements[ vertices[ i ] ][ j ];
+            }
+        }
+    }
+
+    if (facet_mp_list_ptr != NULL)
+    {
+        ERE(get_target_matrix_vector(facet_mp_list_ptr, num_facets));
+
+        for (i = 0; i < num_facets; i++)
+        {
+            Matrix** facet_mpp = &((*facet_mp_list_ptr)->elements[ i ]);
+            int      first     = facet_offsets[ i ];
+
+            ERE(get_target_matrix(facet_mpp, facet_offsets[ i + 1 ] - first,
+                                  dim));
+
+            for (k = first; k < facet_offsets[ i + 1 ]; k++)
+            {
+                for (j = 0; j < dim; j++)
+                {
+                    (*facet_mpp)->elements[ k - first ][ j ] =
+                                points_mp->elements[ facet_points[ k ] ][ j ];
+                }
+            }
+        }
+    }
+
+    if (normal_mpp != NULL)
+    {
+        ERE(get_target_matrix(normal_mpp, num_facets, dim));
+
+        for (i = 0; i < num_facets; i++)
+        {
+            for (j = 0; j < dim; j++)
+            {
+                (*normal_mpp)->elements[ i ][ j ] = normals[ dim * i + j ];
+            }
+        }
+    }
+
+    if (b_value_vpp != NULL)
+    {
+        ERE(get_target_vector(b_value_vpp, num_facets));
+
+        for (i = 0; i < num_facets; i++)
+        {
+            double b_value_sum = 0.0;
+
+            for (k = facet_offsets[ i ]; k < facet_offsets[ i + 1 ]; k++)
+            {
+                for (j = 0; j < dim; j++)
+                {
+                    b_value_sum += points_mp->elements[ facet_points[ k ] ][ j ]
+                                                    * normals[ dim * i + j ];
+                }
+            }
+
+            (*b_value_vpp)->elements[ i ] =
+                     b_value_sum / (facet_offsets[ i + 1 ] - facet_offsets[ i ]);
+        }
+    }
+
+    *num_vertices_ptr = num_vertices;
+    *num_facets_ptr = num_facets;
+
+    return NO_ERROR;
+}
+
+/*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\   */
+
+static double get_roundoff_tolerance(const Matrix* points_mp)
+{
+    double max_abs = 0.0;
+    int    i, j;
+
+
+    for (i = 0; i < points_mp->num_rows; i++)
+    {
+        for (j = 0; j < points_mp->num_cols; j++)
+        {
+            max_abs = MAX_OF(max_abs, ABS_OF(points_mp->elements[ i ][ j ]));
+        }
+    }
+
+    return ROUNDOFF_FACTOR * DBL_EPSILON * points_mp->num_cols * max_abs;
+}
+
+/*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\   */
+
+static int compare_hull_points_2D(const void* p1, const void* p2)
+{
+    const Hull_point_2D* a = (const Hull_point_2D*)p1;
+    const Hull_point_2D* b = (const Hull_point_2D*)p2;
+
+
+    if (a->x < b->x) return -1;
+    if (a->x > b->x) return 1;
+    if (a->y < b->y) return -1;
+    if (a->y > b->y) return 1;
+
+    return a->index - b->index;
+}
+
+/*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\   */
+
+static int compare_ints(const void* p1, const void* p2)
+{
+    return *(const int*)p1 - *(const int*)p2;
+}
+
+/*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\   */
+
+#ifdef __cplusplus
+}
+#endif
+
@@ -0,0 +1,55 @@
+
+/* $Id$ */
+
+/* =========================================================================== *
+|
+|  Copyright (c) 1994-2008 by Kobus Barnard (author).
+|
+|  Personal and educational use of this code is granted, provided that this
+|  header is kept intact, and that the authorship is not misrepresented, that
+|  its use is acknowledged in publications, and relevant papers are cited.
+|
+|  For other use contact the author (kobus AT cs DOT arizona DOT edu).
+|
+|  Please note that the code in this file has not necessarily been adequately
+|  tested. Naturally, there is no guarantee of performance, support, or fitness
+|  for any particular task. Nonetheless, I am interested in hearing about
+|  problems that you encounter.
+|
+* =========================================================================== */
+
+#ifndef H_FAST_HULL_INCLUDED
+#define H_FAST_HULL_INCLUDED
+
+
+#include "m/m_gen.h"
+
+#ifdef __cplusplus
+extern "C" {
+#ifdef COMPILING_CPLUSPLUS_SOURCE
+namespace kjb_c {
+#endif
+#endif
+
+
+int fast_find_convex_hull
+(
+    const Matrix*   points_mp,
+    int*            num_vertices_ptr,
+    int*            num_facets_ptr,
+    Matrix**        vertex_mpp,
+    Matrix**        normal_mpp,
+    Vector**        b_value_vpp,
+    Matrix_vector** facet_mp_list_ptr
+);
+
+
+#ifdef __cplusplus
+#ifdef COMPILING_CPLUSPLUS_SOURCE
+}
+#endif
+}
+#endif
+
+#endif
+
@@ -21,6 +21,9 @@
 
 #include "h/h_gen.h"      /*  Only safe if first #include in a ".c" file  */
 #include "h/h_qh.h"
+#include "h/h_fast_hull.h"
+#include "l_mt/l_mt_pthread.h"
+#include "l_mt/l_mt_options.h"
 
 #include <setjmp.h>
 
@@ -32,6 +35,9 @@ extern "C" {
 
 #define LOTS_OF_POINTS   (1000000)
 
+/* Number of points whose coordinates are gathered at a time for testing. */
+#define INSIDE_HULL_BLOCK_SIZE   (256)
+
 #ifdef TEST
     #define CONSTRAINT_TOLERENCE  (0.001)
     #define RELATIVE_CONSTRAINT_TOLERENCE  (0.01)
@@ -40,7 +46,14 @@ extern "C" {
 
 /* -------------------------------------------------------------------------- */
 
-static int fs_hull_fill_resolution         = 200;
+/*
+// The hull options are kept in a struct so that threads can use their own
+// (see l_mt_options.h). Read them with get_hull_options(), and change them
+// (in set_hull_options() only) with get_hull_options_for_update().
+*/
+typedef struct Hull_options
+{
+    int fill_resolution;
 /*
 // Orginally, we expanded hulls exactly, which is fast and logical, but leads to
 // precision problems under the normal use. Thus I coded up expansion which is
@@ -48,9 +61,35 @@ static int fs_hull_fill_resolution         = 200;
 // hull facets. Because it is so slow, we leave the default as before. Note that
 // some of the precision problems have since been mitigated by other means.
 */
-static int     fs_recompute_hull_level = 0;
+    int recompute_level;
+    int use_fast_hulls;
+}
+Hull_options;
+
+static const Hull_options fs_initial_hull_options = { 200, 0, TRUE };
+static Hull_options       fs_hull_options         = { 200, 0, TRUE };
+
+static Option_module fs_hull_option_module =
+{
+    "hull",
+    sizeof(Hull_options),
+    &fs_initial_hull_options,
+    &fs_hull_options,
+    FALSE
+};
+
+#define get_hull_options() \
+    ((const Hull_options*)get_module_options(&fs_hull_option_module))
+
+#define get_hull_options_for_update() \
+    ((Hull_options*)get_module_options_for_update(&fs_hull_option_module))
+
 static jmp_buf fs_qhull_crash_env;
-static Vector* fs_cached_n_dot_x_vp = NULL;
+
+/*
+// Qhull keeps its state in globals, so only one thread at a time may use it.
+*/
+static kjb_pthread_mutex_t fs_qhull_mutex = KJB_PTHREAD_MUTEX_INITIALIZER;
 
 /* -------------------------------------------------------------------------- */
 
@@ -64,23 +103,42 @@ static Hull* find_convex_hull_3
     unsigned long         options         /* Returned data structure flags. */
 );
 
+static int find_fast_convex_hull
+(
+    Hull**        hp_ptr,
+    const Matrix* input_point_mp,
+    unsigned long options
+);
+
+static Hull* find_qhull_convex_hull
+(
+    const Matrix* input_point_mp,
+    unsigned long options
+);
+
+static int set_hull_bounds(Hull* hp);
+
+static double get_hull_normal_dot_product
+(
+    const Hull*   hp,
+    int           i,
+    const double* x
+);
+
 static int fill_3D_hull(Hull* hp, int resolution);
 static int fill_2D_hull(Hull* hp, int resolution);
 
 static TRAP_FN_RETURN_TYPE qhull_crash_fn(TRAP_FN_ARGS);
 
-#ifdef TRACK_MEMORY_ALLOCATION
-    static void free_allocated_static_data(void);
-    static void prepare_memory_cleanup(void);
-#endif
-
 /* -------------------------------------------------------------------------- */
 
 int set_hull_options(const char* option, const char* value)
 {
-    char lc_option[ 100 ];
-    int  temp_int_value;
-    int  result = NOT_FOUND;
+    char                lc_option[ 100 ];
+    int                 temp_int_value;
+    int                 result          = NOT_FOUND;
+    const Hull_options* options_ptr     = get_hull_options();
+    Hull_options*       new_options_ptr;
 
 
     EXTENDED_LC_BUFF_CPY(lc_option, option);
@@ -97,10 +155,10 @@ int set_hull_options(const char* option, const char* value)
         }
         else if (value[ 0 ] == '?')
         {
-            if (fs_hull_fill_resolution > 0)
+            if (options_ptr->fill_resolution > 0)
             {
                 ERE(pso("hull-fill-resolution = %d\n",
-                        fs_hull_fill_resolution));
+                        options_ptr->fill_resolution));
             }
             else
             {
@@ -109,10 +167,10 @@ int set_hull_options(const char* option, const char* value)
         }
         else if (value[ 0 ] == '\0')
         {
-            if (fs_hull_fill_resolution > 0)
+            if (options_ptr->fill_resolution > 0)
             {
                 ERE(pso("Hull fill resolution is %d.\n",
-                        fs_hull_fill_resolution));
+                        options_ptr->fill_resolution));
             }
             else
             {
@@ -121,12 +179,14 @@ int set_hull_options(const char* option, const char* value)
         }
         else if (is_no_value_word(value))
         {
-            fs_hull_fill_resolution = NOT_SET;
+            NRE(new_options_ptr = get_hull_options_for_update());
+            new_options_ptr->fill_resolution = NOT_SET;
         }
         else
         {
             ERE(ss1pi(value, &temp_int_value));
-            fs_hull_fill_resolution = temp_int_value;
+            NRE(new_options_ptr = get_hull_options_for_update());
+            new_options_ptr->fill_resolution = temp_int_value;
         }
         result = NO_ERROR;
     }
@@ -143,16 +203,43 @@ int set_hull_options(const char* option, const char* value)
         else if (value[ 0 ] == '\0')
         {
             ERE(pso("Convex hulls are recomputed %d times using vertices as input.\n",
-                    fs_recompute_hull_level));
+                    options_ptr->recompute_level));
         }
         else if (value[ 0 ] == '?')
         {
-            ERE(pso("recompute-hulls = %d\n", fs_recompute_hull_level));
+            ERE(pso("recompute-hulls = %d\n", options_ptr->recompute_level));
         }
         else
         {
             ERE(ss1pi(value, &temp_int_value));
-            fs_recompute_hull_level = temp_int_value;
+            NRE(new_options_ptr = get_hull_options_for_update());
+            new_options_ptr->recompute_level = temp_int_value;
+        }
+        result = NO_ERROR;
+    }
+
+    if (    (lc_option[ 0 ] == '\0')
+          || match_pattern(lc_option, "fast-hulls")
+       )
+    {
+        if (value == NULL)
+        {
+            return NO_ERROR;
+        }
+        else if (value[ 0 ] == '\0')
+        {
+            ERE(pso("2D and 3D convex hulls %s found without qhull when possible.\n",
+                    options_ptr->use_fast_hulls ? "are" : "are not"));
+        }
+        else if (value[ 0 ] == '?')
+        {
+            ERE(pso("fast-hulls = %s\n", options_ptr->use_fast_hulls ? "t" : "f"));
+        }
+        else
+        {
+            ERE(temp_int_value = get_boolean_value(value));
+            NRE(new_options_ptr = get_hull_options_for_update());
+            new_options_ptr->use_fast_hulls = temp_int_value;
         }
         result = NO_ERROR;
     }
@@ -441,6 +528,14 @@ int get_convex_hull(Hull** hp_ptr, const Matrix* mp, unsigned long options)
  * the "options" argument. This routine is a wrapper to the "QHull" code
  * released by the Geomentry Centre at the University of Minneapolis.
  *
+ * Unless the option "fast-hulls" is turned off, 2D and 3D hulls are instead
+ * found by fast_find_convex_hull() (monotone chain in 2D, and incremental in
+ * 3D), falling back to qhull only for degenerate data (e.g., too few points,
+ * or 3D points that are nearly coplanar) or when the geomview geometry is
+ * requested. As qhull keeps its state in globals, only one thread at a time
+ * uses it, but 2D and 3D hulls of non-degenerate data can be found by several
+ * threads at once.
+ *
  * The first argument "point_mp" is the address of a matrix containing
  * the input point set.
  *
@@ -482,7 +577,6 @@ Hull* find_convex_hull(const Matrix* input_point_mp, unsigned long options)
     int i, j;
     Hull*   hp;
     Matrix* temp_point_mp = NULL;
-    Vector* temp_row_vp = NULL;
 
 
     if (num_points < LOTS_OF_POINTS)
@@ -494,7 +588,8 @@ Hull* find_convex_hull(const Matrix* input_point_mp, unsigned long options)
         int step = 1 + num_points / LOTS_OF_POINTS;
         int temp_num_points = 1 + (num_points - 1) / step;
         int num_points_outside = NOT_SET;
-        int is_inside;
+        int num_inside;
+        Int_vector* inside_ivp = NULL;
 
         dbp("***************************************************************");
         dbp("***************************************************************");
@@ -523,26 +618,22 @@ Hull* find_convex_hull(const Matrix* input_point_mp, unsigned long options)
             return NULL;
         }
 
-        num_points_outside = hp->num_vertices;
-
         dbi(hp->num_vertices);
 
-        for (i = 0; i < num_points; i++)
+        if ((num_inside = are_points_inside_hull(hp, input_point_mp,
+                                                 &inside_ivp))
+            == ERROR)
         {
-            if (    (get_matrix_row(&temp_row_vp, input_point_mp, i) == ERROR)
-                 || ((is_inside = is_point_inside_hull(hp, temp_row_vp)) == ERROR)
-               )
-            {
-                NOTE_ERROR();
-                free_hull(hp);
-                free_matrix(temp_point_mp);
-                free_vector(temp_row_vp);
-                return NULL;
-            }
-
-            if ( ! is_inside) num_points_outside++;
+            /* The result vector may have been created before the error. */
+            NOTE_ERROR();
+            free_hull(hp);
+            free_matrix(temp_point_mp);
+            free_int_vector(inside_ivp);
+            return NULL;
         }
 
+        num_points_outside = hp->num_vertices + num_points - num_inside;
+
         if (    (get_target_matrix(&temp_point_mp, num_points_outside, num_dim) == ERROR)
              || (ow_copy_matrix(temp_point_mp, 0, 0, hp->vertex_mp) == ERROR)
            )
@@ -550,7 +641,7 @@ Hull* find_convex_hull(const Matrix* input_point_mp, unsigned long options)
             NOTE_ERROR();
             free_hull(hp);
             free_matrix(temp_point_mp);
-            free_vector(temp_row_vp);
+            free_int_vector(inside_ivp);
             return NULL;
         }
 
@@ -560,32 +651,20 @@ Hull* find_convex_hull(const Matrix* input_point_mp, unsigned long options)
 
         for (i = 0; i < num_points; i++)
         {
-            if (    (get_matrix_row(&temp_row_vp, input_point_mp, i) == ERROR)
-                 || ((is_inside = is_point_inside_hull(hp, temp_row_vp)) == ERROR)
-               )
+            if ( ! inside_ivp->elements[ i ])
             {
-                NOTE_ERROR();
-                free_hull(hp);
-                free_matrix(temp_point_mp);
-                free_vector(temp_row_vp);
-                return NULL;
-            }
-
-            if ( ! is_inside)
-            {
-                if (put_matrix_row(temp_point_mp, temp_row_vp, num_points_outside) == ERROR)
+                for (j = 0; j < num_dim; j++)
                 {
-                    NOTE_ERROR();
-                    free_hull(hp);
-                    free_matrix(temp_point_mp);
-                    free_vector(temp_row_vp);
-                    return NULL;
+                    temp_point_mp->elements[ num_points_outside ][ j ] =
+                                                input_point_mp->elements[ i ][ j ];
                 }
 
                 num_points_outside++;
             }
         }
 
+        free_int_vector(inside_ivp);
+
         free_hull(hp);
 
         hp = find_convex_hull_2(temp_point_mp, options);
@@ -773,7 +852,6 @@ Hull* find_convex_hull(const Matrix* input_point_mp, unsigned long options)
 #endif
 
     free_matrix(temp_point_mp);
-    free_vector(temp_row_vp);
 
     if (    (hp != NULL)
          && (hp->dimension == 2)
@@ -799,6 +877,7 @@ static Hull* find_convex_hull_2(const Matrix* input_point_mp, unsigned long opti
     int i;
     Hull*   hp;
     Matrix* temp_point_mp = NULL;
+    int     recompute_level = get_hull_options()->recompute_level;
 
 
 #ifdef TEST
@@ -809,7 +888,7 @@ static Hull* find_convex_hull_2(const Matrix* input_point_mp, unsigned long opti
 
     hp = find_convex_hull_3(input_point_mp, options);
 
-    for (i=0; i<fs_recompute_hull_level; i++)
+    for (i=0; i<recompute_level; i++)
     {
         if (copy_matrix(&temp_point_mp, hp->vertex_mp) == ERROR)
         {
@@ -1226,6 +1305,12 @@ static Hull* compute_ordered_2D_hull(Hull* hp)
 
 /*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\   */
 
+/*
+// All hulls are found here. 2D and 3D hulls are found by fast_find_convex_hull()
+// when possible, as it has no global state, and so hulls can be found by
+// several threads at once. Otherwise (and for degenerate data, which qhull
+// handles by perturbing it) we use qhull, one thread at a time.
+*/
 static Hull* find_convex_hull_3
 (
     const Matrix* input_point_mp,
@@ -1234,6 +1319,102 @@ static Hull* find_convex_hull_3
 {
     IMPORT volatile Bool   io_atn_flag;
     IMPORT volatile Bool   halt_all_output;
+    Hull*                  hp     = NULL;
+    int                    dim    = input_point_mp->num_cols;
+    int                    result = NO_SOLUTION;
+
+
+    /*
+    // Arguably, this does not belong here, but it is a convenient because
+    // find_convex_hull() is used in slow loops.
+    */
+    if (io_atn_flag)
+    {
+        set_error("Processing interrupted.");
+        halt_all_output = FALSE;
+        return NULL;
+    }
+
+    if (    (get_hull_options()->use_fast_hulls)
+         && ((dim == 2) || (dim == 3))
+         && ( ! (options & HULL_GEOM_VIEW_GEOMETRY))
+       )
+    {
+        ERN(result = find_fast_convex_hull(&hp, input_point_mp, options));
+    }
+
+    if (result == NO_SOLUTION)
+    {
+        ERN(kjb_pthread_mutex_lock(&fs_qhull_mutex));
+        hp = find_qhull_convex_hull(input_point_mp, options);
+        EPE(kjb_pthread_mutex_unlock(&fs_qhull_mutex));
+
+        if (hp == NULL) return NULL;
+    }
+
+    if (set_hull_bounds(hp) == ERROR)
+    {
+        free_hull(hp);
+        return NULL;
+    }
+
+    if (options & HULL_FILL)
+    {
+        UNTESTED_CODE();
+
+        if (fill_hull(hp) == ERROR)
+        {
+            free_hull(hp);
+            return NULL;
+        }
+    }
+
+    return hp;
+}
+
+/*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\   */
+
+static int find_fast_convex_hull
+(
+    Hull**        hp_ptr,
+    const Matrix* input_point_mp,
+    unsigned long options
+)
+{
+    Hull* hp;
+    int   result;
+
+
+    NRE(hp = create_hull());
+    hp->dimension = input_point_mp->num_cols;
+
+    result = fast_find_convex_hull(input_point_mp,
+                                   &(hp->num_vertices),
+                                   &(hp->num_facets),
+                                   &(hp->vertex_mp),
+                                   (options & HULL_NORMALS) ? &(hp->normal_mp) : NULL,
+                                   (options & HULL_B_VALUES) ? &(hp->b_value_vp) : NULL,
+                                   (options & HULL_FACETS) ? &(hp->facets) : NULL);
+
+    if (result != NO_ERROR)
+    {
+        free_hull(hp);
+        hp = NULL;
+    }
+
+    *hp_ptr = hp;
+
+    return result;
+}
+
+/*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\   */
+
+static Hull* find_qhull_convex_hull
+(
+    const Matrix* input_point_mp,
+    unsigned long options
+)
+{
     /* These are made static simply to be sure that there are no problems due to
     // the longjmp. Initialization is done as a separate step below. */
     static int             result;
@@ -1252,8 +1433,6 @@ static Hull* find_convex_hull_3
     int                    read_res;
     off_t                  num_bytes;
     Matrix*                extended_point_mp = NULL;
-    Vector*                min_vp   = NULL;
-    Vector*                max_vp   = NULL;
     Matrix*                point_mp = NULL;
 
 
@@ -1265,17 +1444,6 @@ static Hull* find_convex_hull_3
     facets_ptr      = NULL;
     attempt         = 0;
 
-    /*
-    // Arguably, this does not belong here, but it is a convenient because
-    // find_convex_hull() is used in slow loops.
-    */
-    if (io_atn_flag)
-    {
-        set_error("Processing interrupted.");
-        halt_all_output = FALSE;
-        return NULL;
-    }
-
     if (input_point_mp->num_rows <= input_point_mp->num_cols)
     {
         int i, j;
@@ -1489,8 +1657,24 @@ static Hull* find_convex_hull_3
         EPE(kjb_unlink(geom_view_file_name));
     }
 
-    ERN(get_min_matrix_col_elements(&min_vp, hp->vertex_mp));
-    ERN(get_max_matrix_col_elements(&max_vp, hp->vertex_mp));
+    return hp;
+}
+
+/*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\   */
+
+static int set_hull_bounds(Hull* hp)
+{
+    Vector* min_vp = NULL;
+    Vector* max_vp = NULL;
+
+
+    ERE(get_min_matrix_col_elements(&min_vp, hp->vertex_mp));
+
+    if (get_max_matrix_col_elements(&max_vp, hp->vertex_mp) == ERROR)
+    {
+        free_vector(min_vp);
+        return ERROR;
+    }
 
     hp->min_x = (min_vp->elements)[ 0 ];
     hp->max_x = (max_vp->elements)[ 0 ];
@@ -1510,18 +1694,7 @@ static Hull* find_convex_hull_3
     free_vector(min_vp);
     free_vector(max_vp);
 
-    if (options & HULL_FILL)
-    {
-        UNTESTED_CODE();
-
-        if (fill_hull(hp) == ERROR)
-        {
-            free_hull(hp);
-            return NULL;
-        }
-    }
-
-    return hp;
+    return NO_ERROR;
 }
 
 /*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\   */
@@ -1529,19 +1702,20 @@ static Hull* find_convex_hull_3
 int fill_hull(Hull* hp)
 {
     int dim;
+    int resolution = get_hull_options()->fill_resolution;
 
 
-    if (fs_hull_fill_resolution <= 0) return NO_ERROR;
+    if (resolution <= 0) return NO_ERROR;
 
     dim = hp->dimension;
 
     if (dim == 2)
     {
-        return fill_2D_hull(hp, fs_hull_fill_resolution);
+        return fill_2D_hull(hp, resolution);
     }
     else if (dim == 3)
     {
-        return fill_3D_hull(hp, fs_hull_fill_resolution);
+        return fill_3D_hull(hp, resolution);
     }
     else
     {
@@ -2160,13 +2334,9 @@ int is_point_inside_hull(const Hull* hp, const Vector* test_vp)
         return ERROR;
     }
 
-#ifdef TRACK_MEMORY_ALLOCATION
-    prepare_memory_cleanup();
-#endif
-
-    if (multiply_matrix_and_vector(&fs_cached_n_dot_x_vp, hp->normal_mp, test_vp)
-        ==ERROR)
+    if (hp->normal_mp->num_cols != test_vp->length)
     {
+        SET_ARGUMENT_BUG();
         return ERROR;
     }
 
@@ -2174,7 +2344,9 @@ int is_point_inside_hull(const Hull* hp, const Vector* test_vp)
 
     for (i=0; i<constraint_vp->length; i++)
     {
-        if (IS_GREATER_DBL(fs_cached_n_dot_x_vp->elements[i], constraint_vp->elements[i]))
+        double n_dot_x = get_hull_normal_dot_product(hp, i, test_vp->elements);
+
+        if (IS_GREATER_DBL(n_dot_x, constraint_vp->elements[i]))
         {
             result = FALSE;
             break;
@@ -2261,13 +2433,9 @@ int is_point_inside_hull_2
         return ERROR;
     }
 
-#ifdef TRACK_MEMORY_ALLOCATION
-    prepare_memory_cleanup();
-#endif
-
-    if (multiply_matrix_and_vector(&fs_cached_n_dot_x_vp, hp->normal_mp, test_vp)
-        ==ERROR)
+    if (hp->normal_mp->num_cols != test_vp->length)
     {
+        SET_ARGUMENT_BUG();
         return ERROR;
     }
 
@@ -2275,10 +2443,12 @@ int is_point_inside_hull_2
 
     for (i=0; i<constraint_vp->length; i++)
     {
-        if ((SUB_RELATIVE_DBL(fs_cached_n_dot_x_vp->elements[i] - abs_tol, rel_tol)) > ADD_RELATIVE_DBL(constraint_vp->elements[i] + abs_tol, rel_tol))
+        double n_dot_x = get_hull_normal_dot_product(hp, i, test_vp->elements);
+
+        if ((SUB_RELATIVE_DBL(n_dot_x - abs_tol, rel_tol)) > ADD_RELATIVE_DBL(constraint_vp->elements[i] + abs_tol, rel_tol))
         {
             result = FALSE;
-            *error_ptr = fs_cached_n_dot_x_vp->elements[i] - constraint_vp->elements[i];
+            *error_ptr = n_dot_x - constraint_vp->elements[i];
             break;
         }
     }
@@ -2288,6 +2458,223 @@ int is_point_inside_hull_2
 
 /*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\   */
 
+/* =============================================================================
+ *                             are_points_inside_hull
+ *
+ * Determines which of a set of points are inside a hull.
+ *
+ * This routine gives the same answers as calling is_point_inside_hull() on
+ * each row of test_mp, but is much faster for many points. The points are
+ * processed in blocks, stored by coordinate, so that each facet constraint
+ * X.N <= b is checked for a whole block in a loop that the compiler can
+ * vectorize.
+ *
+ * The first argument "hp" is the address of the convex hull. The rows of the
+ * second argument "test_mp" are the query locations. The result for each row
+ * (TRUE if it is inside, FALSE if not) is put into *result_ivpp, which is
+ * created or resized as needed.
+ *
+ * Unlike is_point_inside_hull(), this routine uses no static data, and so it
+ * can be called from several threads at once.
+ *
+ * Returns:
+ *    The number of points inside the hull, or ERROR on failure.
+ *
+ * Related:
+ *    is_point_inside_hull, Hull
+ *
+ * Index: geometry, convex hulls
+ *
+ * -----------------------------------------------------------------------------
+*/
+
+int are_points_inside_hull
+(
+    const Hull*   hp,
+    const Matrix* test_mp,
+    Int_vector**  result_ivpp
+)
+{
+    const int dim        = hp->dimension;
+    const int num_points = test_mp->num_rows;
+    double*   coords     = NULL;
+    double*   n_dot_x    = NULL;
+    double*   excess     = NULL;
+    int       num_inside = 0;
+    int       first, i, j, k;
+
+
+    if (dim != test_mp->num_cols)
+    {
+        set_bug("Test points not the same dimension as hull in are_points_inside_hull.");
+        return ERROR;
+    }
+
+    if (dim < 2)
+    {
+        SET_ARGUMENT_BUG();
+        return ERROR;
+    }
+
+    ERE(get_target_int_vector(result_ivpp, num_points));
+
+    if (KJB_IS_SET(hp->filled_resolution))
+    {
+        Vector* test_vp = NULL;
+        int     is_inside;
+
+        for (i = 0; i < num_points; i++)
+        {
+            if (    (get_matrix_row(&test_vp, test_mp, i) == ERROR)
+                 || ((is_inside = is_point_inside_hull(hp, test_vp)) == ERROR)
+               )
+            {
+                free_vector(test_vp);
+                return ERROR;
+            }
+
+            (*result_ivpp)->elements[ i ] = is_inside;
+            if (is_inside) num_inside++;
+        }
+
+        free_vector(test_vp);
+
+        return num_inside;
+    }
+
+    if (hp->normal_mp == NULL)
+    {
+        set_bug("Hulls sent to are_points_inside_hull must have HULL_NORMALS.");
+        return ERROR;
+    }
+
+    if (hp->b_value_vp == NULL)
+    {
+        set_bug("Hulls sent to are_points_inside_hull must have HULL_B_VALUES.");
+        return ERROR;
+    }
+
+    if (hp->normal_mp->num_cols != dim)
+    {
+        SET_ARGUMENT_BUG();
+        return ERROR;
+    }
+
+    if (    ((coords = DBL_MALLOC(dim * INSIDE_HULL_BLOCK_SIZE)) == NULL)
+         || ((n_dot_x = DBL_MALLOC(INSIDE_HULL_BLOCK_SIZE)) == NULL)
+         || ((excess = DBL_MALLOC(INSIDE_HULL_BLOCK_SIZE)) == NULL)
+       )
+    {
+        kjb_free(coords);
+        kjb_free(n_dot_x);
+        return ERROR;
+    }
+
+    for (first = 0; first < num_points; first += INSIDE_HULL_BLOCK_SIZE)
+    {
+        const int block_size = MIN_OF(INSIDE_HULL_BLOCK_SIZE,
+                                      num_points - first);
+        const double* x = coords;
+        const double* y = coords + INSIDE_HULL_BLOCK_SIZE;
+
+        for (i = 0; i < block_size; i++)
+        {
+            const double* row = test_mp->elements[ first + i ];
+
+            for (j = 0; j < dim; j++)
+            {
+                coords[ j * INSIDE_HULL_BLOCK_SIZE + i ] = row[ j ];
+            }
+        }
+
+        /*
+        // A point is outside if excess[ i ] > 0, which is first set by the
+        // bounding box test of is_point_inside_hull().
+        */
+        for (i = 0; i < block_size; i++)
+        {
+            excess[ i ] = (    (x[ i ] < hp->min_x) || (x[ i ] > hp->max_x)
+                            || (y[ i ] < hp->min_y) || (y[ i ] > hp->max_y))
+                          ? 1.0 : -1.0;
+        }
+
+        if (dim > 2)
+        {
+            const double* z = coords + 2 * INSIDE_HULL_BLOCK_SIZE;
+
+            for (i = 0; i < block_size; i++)
+            {
+                if ((z[ i ] < hp->min_z) || (z[ i ] > hp->max_z))
+                {
+                    excess[ i ] = 1.0;
+                }
+            }
+        }
+
+        /*
+        // The facet constraints. The dot products are summed in the same
+        // order as in is_point_inside_hull(), so that the answers are the
+        // same; x.n > b exactly when x.n - b > 0.
+        */
+        for (k = 0; k < hp->num_facets; k++)
+        {
+            const double* n = hp->normal_mp->elements[ k ];
+            const double  b = ADD_DBL_EPSILON(hp->b_value_vp->elements[ k ]);
+
+            for (i = 0; i < block_size; i++)
+            {
+                n_dot_x[ i ] = n[ 0 ] * x[ i ];
+            }
+
+            for (j = 1; j < dim; j++)
+            {
+                const double* c = coords + j * INSIDE_HULL_BLOCK_SIZE;
+
+                for (i = 0; i < block_size; i++)
+                {
+                    n_dot_x[ i ] += n[ j ] * c[ i ];
+                }
+            }
+
+            for (i = 0; i < block_size; i++)
+            {
+                double d = n_dot_x[ i ] - b;
+
+                excess[ i ] = (d > excess[ i ]) ? d : excess[ i ];
+            }
+
+            /* Stop when all of the block is outside. */
+            for (i = 0; i < block_size; i++)
+            {
+                if (excess[ i ] <= 0.0) break;
+            }
+
+            if (i == block_size) break;
+        }
+
+        for (i = 0; i < block_size; i++)
+        {
+            if (excess[ i ] > 0.0)
+            {
+                (*result_ivpp)->elements[ first + i ] = FALSE;
+            }
+            else
+            {
+                (*result_ivpp)->elements[ first + i ] = TRUE;
+                num_inside++;
+            }
+        }
+    }
+
+    kjb_free(coords);
+    kjb_free(n_dot_x);
+    kjb_free(excess);
+
+    return num_inside;
+}
+
+/*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\   */
+
 /* =============================================================================
  *                           find_hull_bounds
  *
@@ -2339,38 +2726,38 @@ int find_hull_bounds(const Hull* hp, Vector** min_vpp, Vector** max_vpp)
 
 /*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\   */
 
-/*ARGSUSED*/   /* Usually have "sig" as "int" as first arg (always on UNIX) */
-static TRAP_FN_RETURN_TYPE qhull_crash_fn(TRAP_FN_DUMMY_ARGS)
-{
-    allow_abort_sig();
-    longjmp(fs_qhull_crash_env, TRUE);
-}
-
-/*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\   */
-
-#ifdef TRACK_MEMORY_ALLOCATION
-static void prepare_memory_cleanup(void)
+/*
+// The dot product of the i'th hull normal with x, summed the same way as by
+// multiply_matrix_and_vector().
+*/
+static double get_hull_normal_dot_product
+(
+    const Hull*   hp,
+    int           i,
+    const double* x
+)
 {
-    static int first_time = TRUE;
+    const double* n   = hp->normal_mp->elements[ i ];
+    double        sum = 0.0;
+    int           j;
 
 
-    if (first_time)
+    for (j = 0; j < hp->normal_mp->num_cols; j++)
     {
-        add_cleanup_function(free_allocated_static_data);
-        first_time = FALSE;
+        sum += n[ j ] * x[ j ];
     }
-}
 
-#endif
+    return sum;
+}
 
 /*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\   */
 
-#ifdef TRACK_MEMORY_ALLOCATION
-static void free_allocated_static_data(void)
+/*ARGSUSED*/   /* Usually have "sig" as "int" as first arg (always on UNIX) */
+static TRAP_FN_RETURN_TYPE qhull_crash_fn(TRAP_FN_DUMMY_ARGS)
 {
-    free_vector(fs_cached_n_dot_x_vp);
+    allow_abort_sig();
+    longjmp(fs_qhull_crash_env, TRUE);
 }
-#endif
 
 /*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\   */
 
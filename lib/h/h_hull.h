@@ -131,6 +131,13 @@ int is_point_inside_hull_2
     double*       error_ptr
 );
 
+int are_points_inside_hull
+(
+    const Hull*   hp,
+    const Matrix* test_mp,
+    Int_vector**  result_ivpp
+);
+
 int find_hull_bounds(const Hull* hp, Vector** min_vpp, Vector** max_vpp);
 
 
@@ -0,0 +1,399 @@
+
+/* $Id$ */
+
+/*
+ * Checks that 2D and 3D hulls found without qhull are the same as those found
+ * by qhull, that hulls can be found by several threads at once, that threads
+ * use the hull options of their option context, and that
+ * are_points_inside_hull() agrees with is_point_inside_hull().
+ */
+
+#include "h/h_incl.h"
+#include "l_mt/l_mt_pthread.h"
+#include "l_mt/l_mt_options.h"
+
+#define BASE_NUM_TRIES       100
+#define NUM_THREADS          4
+#define NUM_TEST_POINTS      1000
+#define TOLERANCE            (1.0e-5)
+#define HULL_TOLERANCE       (1.0e-12)
+#define FILL_RESOLUTION      50
+#define FILL_RESOLUTION_STR  "50"
+
+typedef struct Hull_thread_data
+{
+    const Matrix*         point_mp;
+    const Option_context* context_ptr;
+    int                   fill_flag;
+    Hull*                 hp;
+}
+Hull_thread_data;
+
+static void* find_hull_in_thread(void* arg)
+{
+    Hull_thread_data* data_ptr = (Hull_thread_data*)arg;
+
+    if (data_ptr->context_ptr != NULL)
+    {
+        EPETE(set_thread_option_context(data_ptr->context_ptr));
+    }
+
+    data_ptr->hp = find_convex_hull(data_ptr->point_mp, DEFAULT_HULL_OPTIONS);
+
+    if ((data_ptr->hp != NULL) && (data_ptr->fill_flag))
+    {
+        EPETE(fill_hull(data_ptr->hp));
+    }
+
+    return NULL;
+}
+
+/* The largest distance of a row of mp outside of the facets of hp. */
+static double get_max_distance_outside(const Hull* hp, const Matrix* mp)
+{
+    double max_distance = DBL_MOST_NEGATIVE;
+    int    i, k, j;
+
+    for (i = 0; i < mp->num_rows; i++)
+    {
+        for (k = 0; k < hp->num_facets; k++)
+        {
+            double distance = -hp->b_value_vp->elements[ k ];
+
+            for (j = 0; j < hp->dimension; j++)
+            {
+                distance += hp->normal_mp->elements[ k ][ j ]
+                                                    * mp->elements[ i ][ j ];
+            }
+
+            max_distance = MAX_OF(max_distance, distance);
+        }
+    }
+
+    return max_distance;
+}
+
+/*
+ * True if hp is a hull of the rows of point_mp: none of them is outside any
+ * facet, the points of each facet are on it, and the vertices are among the
+ * rows.
+ */
+static int is_hull_of_points(const Hull* hp, const Matrix* point_mp)
+{
+    int i, k, j;
+
+    if (get_max_distance_outside(hp, point_mp) > HULL_TOLERANCE)
+    {
+        return FALSE;
+    }
+
+    for (k = 0; k < hp->num_facets; k++)
+    {
+        const Matrix* facet_mp = hp->facets->elements[ k ];
+
+        if (facet_mp->num_rows < hp->dimension) return FALSE;
+
+        for (i = 0; i < facet_mp->num_rows; i++)
+        {
+            double distance = -hp->b_value_vp->elements[ k ];
+
+            for (j = 0; j < hp->dimension; j++)
+            {
+                distance += hp->normal_mp->elements[ k ][ j ]
+                                                * facet_mp->elements[ i ][ j ];
+            }
+
+            if (ABS_OF(distance) > HULL_TOLERANCE) return FALSE;
+        }
+    }
+
+    for (i = 0; i < hp->vertex_mp->num_rows; i++)
+    {
+        for (k = 0; k < point_mp->num_rows; k++)
+        {
+            for (j = 0; j < hp->dimension; j++)
+            {
+                if (hp->vertex_mp->elements[ i ][ j ]
+                                            != point_mp->elements[ k ][ j ])
+                {
+                    break;
+                }
+            }
+
+            if (j == hp->dimension) break;
+        }
+
+        if (k == point_mp->num_rows) return FALSE;
+    }
+
+    return TRUE;
+}
+
+/*
+ * Two hulls are the same if the vertices of each are (nearly) inside the
+ * other. Qhull works in single precision here, so it is only good to about
+ * 1.0e-5; it drops vertices which are less than that outside of a facet, and
+ * merges facets which are that close to coplanar, so the facets need not be
+ * the same.
+ */
+static int is_same_hull(const Hull* hp, const Hull* other_hp)
+{
+    return (    (get_max_distance_outside(hp, other_hp->vertex_mp) < TOLERANCE)
+             && (get_max_distance_outside(other_hp, hp->vertex_mp) < TOLERANCE));
+}
+
+/*ARGSUSED*/
+int main(int argc, char **argv)
+{
+    int              status      = EXIT_SUCCESS;
+    int              num_tries   = BASE_NUM_TRIES;
+    int              test_factor = 1;
+    Matrix*          point_mp    = NULL;
+    Matrix*          test_mp     = NULL;
+    Vector*          test_vp     = NULL;
+    Int_vector*      inside_ivp  = NULL;
+    Hull*            fast_hp     = NULL;
+    Hull*            qhull_hp    = NULL;
+    Option_context*  context_ptr = NULL;
+    Matrix*          thread_point_mp[ NUM_THREADS ];
+    Hull_thread_data thread_data[ NUM_THREADS ];
+    kjb_pthread_t    threads[ NUM_THREADS ];
+    int              i, j, t, dim;
+
+
+    kjb_init();
+
+    if (argc > 1)
+    {
+        EPETE(ss1pi(argv[ 1 ], &test_factor));
+    }
+
+    if (test_factor <= 0)
+    {
+        num_tries = 1;
+    }
+    else
+    {
+        num_tries *= test_factor;
+    }
+
+    EPETB(set_random_options("seed", "0"));
+    EPETB(set_random_options("seed_2", "0"));
+    EPETB(set_heap_options("heap-checking", "f"));
+    EPETB(set_qhull_options("qhull-error-file", "qhull-error-log"));
+
+    for (t = 0; t < NUM_THREADS; t++)
+    {
+        thread_point_mp[ t ] = NULL;
+    }
+
+    for (i = 0; i < num_tries; i++)
+    {
+        for (dim = 2; dim <= 3; dim++)
+        {
+            int num_points = 5 + (int)(200.0 * kjb_rand());
+            int num_inside;
+
+            EPETE(get_random_matrix(&point_mp, num_points, dim));
+
+            /* Some hulls have points on their facets and edges. */
+            if (i % 3 == 1)
+            {
+                EPETE(ow_add_scalar_to_matrix(point_mp, -0.5));
+                EPETE(ow_multiply_matrix_by_scalar(point_mp, 8.0));
+
+                for (j = 0; j < num_points; j++)
+                {
+                    int k;
+
+                    for (k = 0; k < dim; k++)
+                    {
+                        point_mp->elements[ j ][ k ] =
+                            MAX_OF(-2.0, MIN_OF(2.0,
+                                        kjb_rint(point_mp->elements[ j ][ k ])));
+                    }
+                }
+            }
+
+            EPETE(set_hull_options("fast-hulls", "f"));
+            NPETE(qhull_hp = find_convex_hull(point_mp, DEFAULT_HULL_OPTIONS));
+
+            EPETE(set_hull_options("fast-hulls", "t"));
+            NPETE(fast_hp = find_convex_hull(point_mp, DEFAULT_HULL_OPTIONS));
+
+            if ( ! is_hull_of_points(fast_hp, point_mp))
+            {
+                p_stderr("Fast %d-D hull is not a hull of its points (try %d).\n",
+                         dim, i + 1);
+                status = EXIT_BUG;
+            }
+
+            if ( ! is_same_hull(fast_hp, qhull_hp))
+            {
+                p_stderr("Fast %d-D hull differs from qhull's (try %d).\n",
+                         dim, i + 1);
+                status = EXIT_BUG;
+            }
+
+            EPETE(get_random_matrix(&test_mp, NUM_TEST_POINTS, dim));
+            EPETE(ow_add_scalar_to_matrix(test_mp, -0.25));
+            EPETE(ow_multiply_matrix_by_scalar(test_mp, 1.5));
+
+            if (i % 3 == 1)
+            {
+                EPETE(ow_multiply_matrix_by_scalar(test_mp, 4.0));
+            }
+
+            /* The input points themselves are on the border cases. */
+            EPETE(ow_copy_matrix_block(test_mp, 0, 0, point_mp, 0, 0,
+                                       num_points, dim));
+
+            EPETE(num_inside = are_points_inside_hull(fast_hp, test_mp,
+                                                      &inside_ivp));
+
+            for (j = 0; j < NUM_TEST_POINTS; j++)
+            {
+                int is_inside;
+
+                EPETE(get_matrix_row(&test_vp, test_mp, j));
+                EPETE(is_inside = is_point_inside_hull(fast_hp, test_vp));
+
+                if (is_inside != inside_ivp->elements[ j ])
+                {
+                    p_stderr("Batched point in %d-D hull test differs (try %d, point %d).\n",
+                             dim, i + 1, j);
+                    status = EXIT_BUG;
+                    break;
+                }
+
+                if (is_inside) num_inside--;
+            }
+
+            if (num_inside != 0)
+            {
+                p_stderr("Wrong count of points inside %d-D hull (try %d).\n",
+                         dim, i + 1);
+                status = EXIT_BUG;
+            }
+
+            free_hull(fast_hp);
+            free_hull(qhull_hp);
+        }
+
+        /* Hulls found by several threads are those found by one. */
+        for (t = 0; t < NUM_THREADS; t++)
+        {
+            EPETE(get_random_matrix(&(thread_point_mp[ t ]),
+                                    50 + (int)(500.0 * kjb_rand()), 2 + t % 2));
+            thread_data[ t ].point_mp = thread_point_mp[ t ];
+            thread_data[ t ].context_ptr = NULL;
+            thread_data[ t ].fill_flag = FALSE;
+            thread_data[ t ].hp = NULL;
+        }
+
+        for (t = 0; t < NUM_THREADS; t++)
+        {
+            EPETE(kjb_pthread_create(&(threads[ t ]), NULL,
+                                     find_hull_in_thread, &(thread_data[ t ])));
+        }
+
+        for (t = 0; t < NUM_THREADS; t++)
+        {
+            EPETE(kjb_pthread_join(threads[ t ], NULL));
+        }
+
+        for (t = 0; t < NUM_THREADS; t++)
+        {
+            NPETE(thread_data[ t ].hp);
+            NPETE(fast_hp = find_convex_hull(thread_point_mp[ t ],
+                                             DEFAULT_HULL_OPTIONS));
+
+            if ( ! is_same_hull(fast_hp, thread_data[ t ].hp))
+            {
+                p_stderr("Hull found in thread %d differs (try %d).\n",
+                         t, i + 1);
+                status = EXIT_BUG;
+            }
+
+            free_hull(fast_hp);
+            free_hull(thread_data[ t ].hp);
+        }
+    }
+
+    /*
+    // Threads with an option context use its hull options, threads without one
+    // use the process wide ones, and threads made by a thread with a context
+    // start with it.
+    */
+    EPETE(set_hull_options("hull-fill-resolution", "200"));
+    NPETE(context_ptr = create_option_context());
+    EPETE(set_option_context_value(context_ptr, set_hull_options,
+                                   "hull-fill-resolution",
+                                   FILL_RESOLUTION_STR));
+
+    EPETE(get_random_matrix(&point_mp, 100, 2));
+
+    for (t = 0; t < NUM_THREADS; t++)
+    {
+        thread_data[ t ].point_mp = point_mp;
+        thread_data[ t ].context_ptr = (t % 2 == 0) ? context_ptr : NULL;
+        thread_data[ t ].fill_flag = TRUE;
+        thread_data[ t ].hp = NULL;
+
+        EPETE(kjb_pthread_create(&(threads[ t ]), NULL,
+                                 find_hull_in_thread, &(thread_data[ t ])));
+    }
+
+    EPETE(set_thread_option_context(context_ptr));
+
+    for (t = 0; t < NUM_THREADS; t++)
+    {
+        int resolution = (t % 2 == 0) ? FILL_RESOLUTION : 200;
+
+        EPETE(kjb_pthread_join(threads[ t ], NULL));
+        NPETE(thread_data[ t ].hp);
+
+        if (thread_data[ t ].hp->filled_resolution != resolution)
+        {
+            p_stderr("Hull filled in thread %d at resolution %d, not %d.\n",
+                     t, thread_data[ t ].hp->filled_resolution, resolution);
+            status = EXIT_BUG;
+        }
+
+        free_hull(thread_data[ t ].hp);
+
+        /* This thread now has the context, which new threads inherit. */
+        thread_data[ t ].context_ptr = NULL;
+        thread_data[ t ].hp = NULL;
+
+        EPETE(kjb_pthread_create(&(threads[ t ]), NULL,
+                                 find_hull_in_thread, &(thread_data[ t ])));
+        EPETE(kjb_pthread_join(threads[ t ], NULL));
+        NPETE(thread_data[ t ].hp);
+
+        if (thread_data[ t ].hp->filled_resolution != FILL_RESOLUTION)
+        {
+            p_stderr("Hull filled in thread %d did not use the inherited options.\n",
+                     t);
+            status = EXIT_BUG;
+        }
+
+        free_hull(thread_data[ t ].hp);
+    }
+
+    EPETE(set_thread_option_context(NULL));
+    free_option_context(context_ptr);
+
+    for (t = 0; t < NUM_THREADS; t++)
+    {
+        free_matrix(thread_point_mp[ t ]);
+    }
+
+    free_matrix(point_mp);
+    free_matrix(test_mp);
+    free_vector(test_vp);
+    free_int_vector(inside_ivp);
+
+    return status;
+}
+
@@ -2,6 +2,7 @@
 /* $Id: i_color_histogram.cpp 21596 2017-07-30 23:33:36Z kobus $ */
 
 #include "i_cpp/i_color_histogram.h"
+#include "i_cpp/i_integral_histogram.h"
 #include "m_cpp/m_vector_stream_io.h"
 
 #include <fstream>
@@ -183,6 +184,35 @@ void Color_histogram::compute_histogram
     m_histogram /= ((bottom_right_x - top_left_x)*(bottom_right_y - top_left_y));
 }
 
+void Color_histogram::compute_histogram
+(
+    const Integral_histogram & ihist,
+    int top_left_x,
+    int top_left_y,
+    int bottom_right_x,
+    int bottom_right_y
+)
+{
+    unsigned int n = round(pow(ihist.get_num_bins(), 1.0/3.0));
+    if(n*n*n != ihist.get_num_bins())
+    {
+        KJB_THROW_2(Illegal_argument, "Integral histogram is not an RGB histogram");
+    }
+    if( bottom_right_x <= top_left_x)
+    {
+        KJB_THROW_2(Illegal_argument, "right x coordinate of image region is smaller then left x coordinate");
+    }
+    if( bottom_right_y <= top_left_y)
+    {
+        KJB_THROW_2(Illegal_argument, "bottom y coordinate of image region is smaller then top y coordinate");
+    }
+
+    num_bins = n;
+    bin_size = 255.0 / num_bins;
+    m_histogram = ihist.get_histogram(top_left_x, top_left_y, bottom_right_x, bottom_right_y);
+    m_histogram /= ((bottom_right_x - top_left_x)*(bottom_right_y - top_left_y));
+}
+
 unsigned int Color_histogram::compute_rgb_bin(float r, float g, float b) const
 {
     unsigned int r_bin = find_bin(r);
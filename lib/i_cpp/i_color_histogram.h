@@ -23,6 +23,8 @@
 namespace kjb 
 {
 
+class Integral_histogram;
+
 /**
  * @addtogroup kjbImageProc
  * @{
@@ -103,6 +105,26 @@ public:
         int bottom_right_y
     );
 
+    /**
+     * @brief Computes a color histogram over the specified image region
+     * from an integral histogram of the image, in time independent of the
+     * size of the region.
+     *
+     * The integral histogram must have been built from
+     * get_rgb_bin_indices(), and sets the number of bins. As for the other
+     * versions, the region is the pixels with column in
+     * <tt>[top_left_x, bottom_right_x)</tt> and row in
+     * <tt>[top_left_y, bottom_right_y)</tt>.
+     */
+    void compute_histogram
+    (
+        const Integral_histogram & ihist,
+        int top_left_x,
+        int top_left_y,
+        int bottom_right_x,
+        int bottom_right_y
+    );
+
     /// @brief Returns the number of bins 
     unsigned int get_num_bins() const
     {
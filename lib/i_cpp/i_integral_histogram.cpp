@@ -0,0 +1,299 @@
+/* $Id$ */
+
+#include "i_cpp/i_integral_histogram.h"
+#include "i_cpp/i_hsv.h"
+#include "l_cpp/l_exception.h"
+
+#include <boost/thread.hpp>
+#include <boost/bind.hpp>
+#include <algorithm>
+#include <cmath>
+
+using namespace kjb;
+
+namespace
+{
+
+/**
+ * Fills the tables of bins [first_bin, last_bin). Each thread only writes its
+ * own bins, so the threads need no synchronization.
+ */
+void build_tables
+(
+    std::vector<unsigned int>& tables,
+    const std::vector<int>&    bins,
+    int                        num_rows,
+    int                        num_cols,
+    size_t                     num_bins,
+    size_t                     first_bin,
+    size_t                     last_bin
+)
+{
+    const size_t              nb         = last_bin - first_bin;
+    const size_t              row_stride = (num_cols + 1) * num_bins;
+    std::vector<unsigned int> row_counts(nb);
+
+    // Row 0 and column 0 are zero, as set by the caller.
+    for (int r = 1; r <= num_rows; r++)
+    {
+        const int*          row_bins = &bins[ (size_t)(r - 1) * num_cols ];
+        unsigned int*       dest     = &tables[ r * row_stride + first_bin ];
+        const unsigned int* above    = dest - row_stride;
+
+        std::fill(row_counts.begin(), row_counts.end(), 0);
+
+        for (int c = 1; c <= num_cols; c++)
+        {
+            const size_t b = (size_t)row_bins[ c - 1 ] - first_bin;
+
+            // Also false for negative bins, which wrap around.
+            if (b < nb)
+            {
+                row_counts[ b ]++;
+            }
+
+            dest  += num_bins;
+            above += num_bins;
+
+            for (size_t i = 0; i < nb; i++)
+            {
+                dest[ i ] = above[ i ] + row_counts[ i ];
+            }
+        }
+    }
+}
+
+} // anonymous namespace
+
+/* \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ */
+
+Integral_histogram::Integral_histogram
+(
+    const Int_matrix& bin_indices,
+    size_t num_bins,
+    size_t num_threads
+) :
+    m_num_rows(bin_indices.get_num_rows()),
+    m_num_cols(bin_indices.get_num_cols()),
+    m_num_bins(num_bins)
+{
+    if (num_bins == 0)
+    {
+        KJB_THROW_2(Illegal_argument, "Integral histogram needs at least one bin");
+    }
+
+    std::vector<int> bins((size_t)m_num_rows * m_num_cols);
+    for (int r = 0; r < m_num_rows; r++)
+    {
+        for (int c = 0; c < m_num_cols; c++)
+        {
+            const int b = bin_indices(r, c);
+            if (b >= (int)num_bins)
+            {
+                KJB_THROW_2(Illegal_argument, "Bin index out of bounds");
+            }
+            bins[(size_t)r * m_num_cols + c] = b;
+        }
+    }
+
+    m_tables.assign((size_t)(m_num_rows + 1) * (m_num_cols + 1) * num_bins, 0);
+
+    size_t nt = num_threads;
+    if (nt == 0)
+    {
+        nt = boost::thread::hardware_concurrency();
+    }
+    if (nt > num_bins)
+    {
+        nt = num_bins;
+    }
+
+    if (nt <= 1)
+    {
+        build_tables(m_tables, bins, m_num_rows, m_num_cols, num_bins,
+                     0, num_bins);
+    }
+    else
+    {
+        boost::thread_group thrds;
+        for (size_t i = 0; i < nt; i++)
+        {
+            size_t first = (num_bins / nt) * i;
+            size_t last = (i == nt - 1 ? num_bins : (num_bins / nt) * (i + 1));
+            thrds.create_thread(boost::bind(
+                        build_tables, boost::ref(m_tables), boost::cref(bins),
+                        m_num_rows, m_num_cols, num_bins, first, last));
+        }
+        thrds.join_all();
+    }
+}
+
+/* \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ */
+
+void Integral_histogram::check_rectangle
+(
+    int left,
+    int top,
+    int right,
+    int bottom
+) const
+{
+    if (left < 0 || top < 0 || right > m_num_cols || bottom > m_num_rows)
+    {
+        KJB_THROW_2(Illegal_argument, "Rectangle is out of the image");
+    }
+    if (right < left || bottom < top)
+    {
+        KJB_THROW_2(Illegal_argument, "Rectangle has negative size");
+    }
+}
+
+/* \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ */
+
+void Integral_histogram::get_counts
+(
+    unsigned int* counts,
+    int left,
+    int top,
+    int right,
+    int bottom
+) const
+{
+    check_rectangle(left, top, right, bottom);
+
+    const unsigned int* br = table(bottom, right);
+    const unsigned int* bl = table(bottom, left);
+    const unsigned int* tr = table(top, right);
+    const unsigned int* tl = table(top, left);
+
+    for (size_t b = 0; b < m_num_bins; b++)
+    {
+        counts[b] = br[b] - bl[b] - tr[b] + tl[b];
+    }
+}
+
+/* \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ */
+
+Vector Integral_histogram::get_histogram
+(
+    int left,
+    int top,
+    int right,
+    int bottom
+) const
+{
+    std::vector<unsigned int> counts(m_num_bins);
+    get_counts(&counts[0], left, top, right, bottom);
+
+    Vector hist((int)m_num_bins);
+    for (size_t b = 0; b < m_num_bins; b++)
+    {
+        hist[b] = counts[b];
+    }
+
+    return hist;
+}
+
+/* \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ */
+
+unsigned int Integral_histogram::get_num_counted
+(
+    int left,
+    int top,
+    int right,
+    int bottom
+) const
+{
+    std::vector<unsigned int> counts(m_num_bins);
+    get_counts(&counts[0], left, top, right, bottom);
+
+    unsigned int total = 0;
+    for (size_t b = 0; b < m_num_bins; b++)
+    {
+        total += counts[b];
+    }
+
+    return total;
+}
+
+/* \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ */
+
+Int_matrix kjb::get_rgb_bin_indices(const Image& img, size_t num_bins)
+{
+    if (num_bins == 0)
+    {
+        KJB_THROW_2(Illegal_argument, "Number of bins must be positive");
+    }
+
+    const float bin_size = 255.0 / num_bins;
+    const int num_rows = img.get_num_rows();
+    const int num_cols = img.get_num_cols();
+    Int_matrix bins(num_rows, num_cols);
+
+    for (int r = 0; r < num_rows; r++)
+    {
+        for (int c = 0; c < num_cols; c++)
+        {
+            unsigned int rgb[3];
+            for (int ch = 0; ch < 3; ch++)
+            {
+                // Same as Color_histogram::find_bin().
+                float value = img(r, c, ch);
+                if (value < 0.0 || value > 255.0)
+                {
+                    KJB_THROW_2(Illegal_argument,
+                                "RGB value should be between 0 and 255");
+                }
+                rgb[ch] = round(value / bin_size);
+                if (rgb[ch] == num_bins)
+                {
+                    rgb[ch]--;
+                }
+            }
+
+            bins(r, c) = (num_bins * (rgb[0] * num_bins + rgb[1])) + rgb[2];
+        }
+    }
+
+    return bins;
+}
+
+/* \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ */
+
+Int_matrix kjb::get_hsv_bin_indices
+(
+    const Image& img,
+    size_t num_h_bins,
+    size_t num_s_bins,
+    size_t num_v_bins
+)
+{
+    if (num_h_bins == 0 || num_s_bins == 0 || num_v_bins == 0)
+    {
+        KJB_THROW_2(Illegal_argument, "Number of bins must be positive");
+    }
+
+    const int num_rows = img.get_num_rows();
+    const int num_cols = img.get_num_cols();
+    Int_matrix bins(num_rows, num_cols);
+
+    for (int r = 0; r < num_rows; r++)
+    {
+        for (int c = 0; c < num_cols; c++)
+        {
+            float h, s, v;
+            PixelHSVA(img(r, c)).get_hsv(&h, &s, &v);
+
+            size_t hb = std::min((size_t)std::max(0.0f, h * num_h_bins),
+                                 num_h_bins - 1);
+            size_t sb = std::min((size_t)std::max(0.0f, s * num_s_bins),
+                                 num_s_bins - 1);
+            size_t vb = std::min((size_t)std::max(0.0f, v * num_v_bins),
+                                 num_v_bins - 1);
+
+            bins(r, c) = (hb * num_s_bins + sb) * num_v_bins + vb;
+        }
+    }
+
+    return bins;
+}
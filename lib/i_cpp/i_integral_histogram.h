@@ -0,0 +1,139 @@
+/**
+ * @file
+ * @brief Integral histograms, for histograms of many rectangles of an image.
+ */
+/*
+ * $Id$
+ */
+
+#ifndef KJB_CPP_INTEGRAL_HISTOGRAM_H
+#define KJB_CPP_INTEGRAL_HISTOGRAM_H
+
+#include "i_cpp/i_image.h"
+#include <l_cpp/l_int_matrix.h>
+#include <m_cpp/m_vector.h>
+
+#include <vector>
+
+namespace kjb
+{
+
+/**
+ * @addtogroup kjbImageProc
+ * @{
+ */
+
+/**
+ * @class Integral_histogram
+ *
+ * @brief Summed-area tables of the bin counts of an image, one per bin.
+ *
+ * Once built (in time proportional to the number of pixels times the number
+ * of bins), the histogram of any axis-aligned rectangle is found in time
+ * proportional to the number of bins, independently of the size of the
+ * rectangle. This pays off when many, possibly overlapping, rectangles of
+ * the same image are needed, e.g., the boxes of all proposals of a frame.
+ *
+ * The tables take <tt>(rows + 1) * (cols + 1) * num_bins</tt> unsigned
+ * integers, so large images with many bins should be subsampled first.
+ *
+ * The image is given as a matrix of bin indices; see get_rgb_bin_indices()
+ * and get_hsv_bin_indices() for the usual ones.
+ */
+class Integral_histogram
+{
+public:
+    /// @brief Constructs an empty integral histogram
+    Integral_histogram() : m_num_rows(0), m_num_cols(0), m_num_bins(0) {}
+
+    /**
+     * @brief Builds the integral histogram of a matrix of bin indices.
+     *
+     * @param bin_indices  Bin of each pixel. Pixels with a negative bin are
+     *                     not counted.
+     * @param num_bins     Number of bins; indices must be less than this.
+     * @param num_threads  Number of threads to use, each handling a range of
+     *                     bins. If 0, use the number of hardware threads.
+     */
+    Integral_histogram
+    (
+        const Int_matrix& bin_indices,
+        size_t num_bins,
+        size_t num_threads = 1
+    );
+
+    /// @brief Number of rows of the image.
+    int get_num_rows() const { return m_num_rows; }
+
+    /// @brief Number of columns of the image.
+    int get_num_cols() const { return m_num_cols; }
+
+    /// @brief Number of bins.
+    size_t get_num_bins() const { return m_num_bins; }
+
+    /**
+     * @brief Bin counts of the pixels with column in
+     * <tt>[left, right)</tt> and row in <tt>[top, bottom)</tt>.
+     *
+     * @param counts  Receives the get_num_bins() counts.
+     */
+    void get_counts
+    (
+        unsigned int* counts,
+        int left,
+        int top,
+        int right,
+        int bottom
+    ) const;
+
+    /**
+     * @brief Histogram of the pixels with column in <tt>[left, right)</tt>
+     * and row in <tt>[top, bottom)</tt>, as counts.
+     */
+    Vector get_histogram(int left, int top, int right, int bottom) const;
+
+    /**
+     * @brief Number of counted pixels in the rectangle (the sum of its
+     * histogram).
+     */
+    unsigned int get_num_counted(int left, int top, int right, int bottom) const;
+
+private:
+    void check_rectangle(int left, int top, int right, int bottom) const;
+
+    const unsigned int* table(int row, int col) const
+    {
+        return &m_tables[((size_t)row * (m_num_cols + 1) + col) * m_num_bins];
+    }
+
+    int m_num_rows;
+    int m_num_cols;
+    size_t m_num_bins;
+
+    /// @brief Cell major: the counts of all bins at a corner are adjacent.
+    std::vector<unsigned int> m_tables;
+};
+
+/**
+ * @brief Bin of each pixel for an RGB histogram with num_bins bins per
+ * channel, as used by Color_histogram.
+ */
+Int_matrix get_rgb_bin_indices(const Image& img, size_t num_bins);
+
+/**
+ * @brief Bin of each pixel for an HSV histogram, with bin
+ * <tt>(h * num_s_bins + s) * num_v_bins + v</tt>.
+ */
+Int_matrix get_hsv_bin_indices
+(
+    const Image& img,
+    size_t num_h_bins,
+    size_t num_s_bins,
+    size_t num_v_bins
+);
+
+/// @}
+
+} // namespace kjb
+
+#endif /*KJB_CPP_INTEGRAL_HISTOGRAM_H */
@@ -0,0 +1,114 @@
+/*
+ * $Id$
+ */
+
+#include "i_cpp/i_integral_histogram.h"
+#include "i_cpp/i_color_histogram.h"
+#include "l_cpp/l_test.h"
+
+#include <vector>
+#include <cmath>
+
+using namespace kjb;
+
+namespace
+{
+
+const int NUM_ROWS = 37;
+const int NUM_COLS = 53;
+
+/* Counts bins by scanning the rectangle. */
+std::vector<unsigned int> scan_counts
+(
+    const Int_matrix& bins,
+    size_t num_bins,
+    int left,
+    int top,
+    int right,
+    int bottom
+)
+{
+    std::vector<unsigned int> counts(num_bins, 0);
+    for (int r = top; r < bottom; r++)
+    {
+        for (int c = left; c < right; c++)
+        {
+            if (bins(r, c) >= 0) counts[bins(r, c)]++;
+        }
+    }
+    return counts;
+}
+
+}
+
+int main()
+{
+    Image img(NUM_ROWS, NUM_COLS);
+    for (int r = 0; r < NUM_ROWS; r++)
+    {
+        for (int c = 0; c < NUM_COLS; c++)
+        {
+            img(r, c, 0) = (r * 7 + c * 3) % 256;
+            img(r, c, 1) = (r * c) % 256;
+            img(r, c, 2) = (c * 11) % 256;
+        }
+    }
+
+    const size_t num_bins = 4;
+    Int_matrix bins = get_rgb_bin_indices(img, num_bins);
+    const size_t nb = num_bins * num_bins * num_bins;
+
+    // some pixels are not counted
+    bins(3, 4) = -1;
+    bins(20, 30) = -1;
+
+    Integral_histogram ihist(bins, nb, 1);
+    Integral_histogram ihist_mt(bins, nb, 3);
+
+    TEST_TRUE(ihist.get_num_rows() == NUM_ROWS);
+    TEST_TRUE(ihist.get_num_cols() == NUM_COLS);
+    TEST_TRUE(ihist.get_num_bins() == nb);
+
+    const int rects[][4] = { { 0, 0, NUM_COLS, NUM_ROWS },
+                             { 2, 3, 10, 25 },
+                             { 30, 0, 31, 1 },
+                             { 5, 5, 5, 9 },
+                             { 40, 10, NUM_COLS, NUM_ROWS } };
+
+    std::vector<unsigned int> counts(nb);
+    std::vector<unsigned int> counts_mt(nb);
+    for (size_t i = 0; i < sizeof(rects) / sizeof(rects[0]); i++)
+    {
+        const int* rc = rects[i];
+        std::vector<unsigned int> expected = scan_counts(bins, nb, rc[0],
+                                                         rc[1], rc[2], rc[3]);
+
+        ihist.get_counts(&counts[0], rc[0], rc[1], rc[2], rc[3]);
+        ihist_mt.get_counts(&counts_mt[0], rc[0], rc[1], rc[2], rc[3]);
+        TEST_TRUE(counts == expected);
+        TEST_TRUE(counts_mt == expected);
+    }
+
+    TEST_TRUE(ihist.get_num_counted(0, 0, NUM_COLS, NUM_ROWS)
+                == NUM_ROWS * NUM_COLS - 2);
+
+    // same as scanning with Color_histogram
+    Integral_histogram rgb_hist(get_rgb_bin_indices(img, num_bins), nb);
+    Color_histogram scanned(num_bins, img, 2, 3, 40, 30);
+    Color_histogram integral;
+    integral.compute_histogram(rgb_hist, 2, 3, 40, 30);
+    TEST_TRUE(integral.get_num_bins() == num_bins);
+    TEST_TRUE(integral.compare(scanned) < 1e-12);
+
+    // HSV bins are in range
+    Int_matrix hsv_bins = get_hsv_bin_indices(img, 6, 3, 2);
+    Integral_histogram hsv_hist(hsv_bins, 6 * 3 * 2, 2);
+    TEST_TRUE(hsv_hist.get_num_counted(0, 0, NUM_COLS, NUM_ROWS)
+                == NUM_ROWS * NUM_COLS);
+
+    // rectangles out of the image are rejected
+    TEST_FAIL(ihist.get_counts(&counts[0], 0, 0, NUM_COLS + 1, 1));
+    TEST_FAIL(ihist.get_counts(&counts[0], 3, 0, 2, 1));
+
+    RETURN_VICTORIOUSLY();
+}
@@ -0,0 +1,589 @@
+/*
+ * Option contexts: per thread (or per call) copies of module options.
+ *
+ * Modules which keep their options in a struct described by an Option_module
+ * read them with get_module_options(). Without an option context, this gives
+ * the process wide values, which the string based set_<module>_options()
+ * functions change as they always have. A thread can instead install an
+ * option context, which is a snapshot of the options of all such modules
+ * taken when the context was created, and which can then be changed without
+ * affecting other threads. Threads made with kjb_pthread_create() start with
+ * the option context of the thread that made them.
+ *
+ * Reading options does not lock: the context is found through thread
+ * specific data, and contexts are not changed while they are in use by other
+ * threads (this is up to the caller). The list of modules is protected by a
+ * mutex, but it is only used when process wide options are first changed and
+ * when contexts are created.
+ *
+ * $Id$
+ */
+
+#include "l/l_sys_debug.h"
+#include "l/l_sys_lib.h"
+#include "l/l_sys_mal.h"
+#include "l/l_error.h"
+#include "l/l_global.h"
+#include "l/l_string.h"
+#include "l_mt/l_mt_pthread.h"
+#include "l_mt/l_mt_util.h"
+#include "l_mt/l_mt_options.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* The most modules that can describe their options with an Option_module. */
+#define MAX_NUM_OPTION_MODULES  64
+
+
+struct Option_context
+{
+    int            num_modules;
+    Option_module* modules[ MAX_NUM_OPTION_MODULES ];
+    void*          options[ MAX_NUM_OPTION_MODULES ];
+};
+
+
+/* This mutex protects the list of modules whose process wide options have
+   been changed, which are the ones that contexts need to copy. */
+static kjb_pthread_mutex_t fs_option_module_mutex =
+                                                KJB_PTHREAD_MUTEX_INITIALIZER;
+static Option_module* fs_option_modules[ MAX_NUM_OPTION_MODULES ];
+static int            fs_num_option_modules = 0;
+
+#ifdef KJB_HAVE_PTHREAD
+static kjb_pthread_once_t fs_option_keys_set_up = KJB_PTHREAD_ONCE_INIT;
+
+/* Set JUST ONCE, when the keys are made, and read without serialization
+   afterwards, like fs_kjb_pthreads_active in l_mt_pthread.c. */
+static int               fs_option_keys_made = FALSE;
+static kjb_pthread_key_t fs_option_context_key;
+static kjb_pthread_key_t fs_option_update_context_key;
+#else
+static const Option_context* fs_option_context_ptr        = NULL;
+static Option_context*       fs_option_update_context_ptr = NULL;
+#endif
+
+/* -------------------------------------------------------------------------- */
+
+static void* add_module_options
+(
+    Option_context* context_ptr,
+    Option_module*  module_ptr,
+    const void*     source_ptr
+);
+
+static int set_thread_option_update_context(Option_context* context_ptr);
+
+static Option_context* get_thread_option_update_context(void);
+
+#ifdef KJB_HAVE_PTHREAD
+static void make_option_keys(void);
+#endif
+
+/* -------------------------------------------------------------------------- */
+
+/*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\  */
+
+/* ============================================================================
+ *                             create_option_context
+ *
+ * Makes a snapshot of module options
+ *
+ * This makes an option context holding a copy of the current options of
+ * every module that describes its options with an Option_module (see
+ * l_mt_options.h). Options can then be changed in the context with
+ * set_option_context_value(), and the context can be used by one or more
+ * threads with set_thread_option_context(), without changing the process
+ * wide options that other threads use.
+ *
+ * The process wide options should not be changed while a context is being
+ * created.
+ *
+ * LOCK STATUS:  yes, this locks the mutex protecting the module list.
+ *
+ * Returns:
+ *     A new option context, which should be freed with free_option_context(),
+ *     or NULL on failure, with an error message being set.
+ *
+ * Related:
+ *     free_option_context, set_option_context_value,
+ *     set_thread_option_context, get_module_options
+ *
+ * Index: threads, options
+ *
+ * ----------------------------------------------------------------------------
+*/
+Option_context* create_option_context(void)
+{
+    Option_context* context_ptr;
+    int             result      = NO_ERROR;
+    int             i;
+
+
+    NRN(context_ptr = (Option_context*)kjb_mt_malloc(sizeof(Option_context)));
+    context_ptr->num_modules = 0;
+
+    if (kjb_pthread_mutex_lock(&fs_option_module_mutex) == ERROR)
+    {
+        kjb_mt_free(context_ptr);
+        return NULL;
+    }
+
+    for (i = 0; i < fs_num_option_modules; i++)
+    {
+        Option_module* module_ptr = fs_option_modules[ i ];
+
+        if (add_module_options(context_ptr, module_ptr,
+                               module_ptr->global_ptr) == NULL)
+        {
+            result = ERROR;
+            break;
+        }
+    }
+
+    EPETE(kjb_pthread_mutex_unlock(&fs_option_module_mutex));
+
+    if (result == ERROR)
+    {
+        free_option_context(context_ptr);
+        return NULL;
+    }
+
+    return context_ptr;
+}
+
+/*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\  */
+
+/* ============================================================================
+ *                             copy_option_context
+ *
+ * Copies an option context
+ *
+ * The context *target_context_ptr_ptr is replaced by a copy of context_ptr.
+ * If *target_context_ptr_ptr is NULL, a context is created.
+ *
+ * LOCK STATUS:  no, this does not block
+ *
+ * Returns:
+ *     NO_ERROR on success, or ERROR with an error message being set.
+ *
+ * Index: threads, options
+ *
+ * ----------------------------------------------------------------------------
+*/
+int copy_option_context
+(
+    Option_context**      target_context_ptr_ptr,
+    const Option_context* context_ptr
+)
+{
+    Option_context* target_context_ptr = *target_context_ptr_ptr;
+    int             i;
+
+
+    if (context_ptr == target_context_ptr) return NO_ERROR;
+
+    if (target_context_ptr == NULL)
+    {
+        NRE(target_context_ptr = (Option_context*)kjb_mt_malloc(
+                                                    sizeof(Option_context)));
+        *target_context_ptr_ptr = target_context_ptr;
+    }
+    else
+    {
+        for (i = 0; i < target_context_ptr->num_modules; i++)
+        {
+            kjb_mt_free(target_context_ptr->options[ i ]);
+        }
+    }
+
+    target_context_ptr->num_modules = 0;
+
+    for (i = 0; i < context_ptr->num_modules; i++)
+    {
+        NRE(add_module_options(target_context_ptr, context_ptr->modules[ i ],
+                               context_ptr->options[ i ]));
+    }
+
+    return NO_ERROR;
+}
+
+/*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\  */
+
+/* ============================================================================
+ *                             free_option_context
+ *
+ * Frees an option context
+ *
+ * No thread may be using the context when it is freed. If it is the option
+ * context of the calling thread, the thread goes back to the process wide
+ * options.
+ *
+ * LOCK STATUS:  no, this does not block
+ *
+ * Index: threads, options
+ *
+ * ----------------------------------------------------------------------------
+*/
+void free_option_context(Option_context* context_ptr)
+{
+    int i;
+
+
+    if (context_ptr == NULL) return;
+
+    if (get_thread_option_context() == context_ptr)
+    {
+        EPE(set_thread_option_context(NULL));
+    }
+
+    for (i = 0; i < context_ptr->num_modules; i++)
+    {
+        kjb_mt_free(context_ptr->options[ i ]);
+    }
+
+    kjb_mt_free(context_ptr);
+}
+
+/*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\  */
+
+/* ============================================================================
+ *                             set_option_context_value
+ *
+ * Sets an option in an option context
+ *
+ * This calls set_fn(option, value) so that it changes the options in the
+ * given context instead of the process wide ones. The set function is any of
+ * the usual string based ones, for example set_hull_options(), or a library
+ * wide one such as kjb_h_set(). Only modules which keep their options with
+ * an Option_module honor contexts; others change their process wide options
+ * as usual.
+ *
+ * The context should not be in use by other threads while it is changed.
+ *
+ * LOCK STATUS:  no, this does not block
+ *
+ * Returns:
+ *     Whatever set_fn returns (NO_ERROR, NOT_FOUND, or ERROR).
+ *
+ * Related:
+ *     create_option_context
+ *
+ * Index: threads, options
+ *
+ * ----------------------------------------------------------------------------
+*/
+int set_option_context_value
+(
+    Option_context* context_ptr,
+    int             (*set_fn)(const char*, const char*),
+    const char*     option,
+    const char*     value
+)
+{
+    const Option_context* save_context_ptr = get_thread_option_context();
+    Option_context*       save_update_context_ptr =
+                                        get_thread_option_update_context();
+    int                   result;
+
+
+    ERE(set_thread_option_context(context_ptr));
+    ERE(set_thread_option_update_context(context_ptr));
+
+    result = (*set_fn)(option, value);
+
+    ERE(set_thread_option_update_context(save_update_context_ptr));
+    ERE(set_thread_option_context(save_context_ptr));
+
+    return result;
+}
+
+/*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\  */
+
+/* ============================================================================
+ *                             set_thread_option_context
+ *
+ * Sets the option context of the calling thread
+ *
+ * From now on, modules which keep their options with an Option_module use
+ * the options in context_ptr when called from this thread, and from threads
+ * it creates with kjb_pthread_create(). If context_ptr is NULL, the process
+ * wide options are used. The context must outlive its use by these threads.
+ *
+ * LOCK STATUS:  no, this does not block
+ *
+ * Returns:
+ *     NO_ERROR on success, or ERROR with an error message being set.
+ *
+ * Related:
+ *     create_option_context, get_thread_option_context
+ *
+ * Index: threads, options
+ *
+ * ----------------------------------------------------------------------------
+*/
+int set_thread_option_context(const Option_context* context_ptr)
+{
+#ifdef KJB_HAVE_PTHREAD
+    ERE(kjb_pthread_once(&fs_option_keys_set_up, make_option_keys));
+
+    if ( ! fs_option_keys_made)
+    {
+        set_error("Cannot set option context: no thread specific data key.");
+        return ERROR;
+    }
+
+    return kjb_pthread_setspecific(fs_option_context_key, context_ptr);
+#else
+    fs_option_context_ptr = context_ptr;
+    return NO_ERROR;
+#endif
+}
+
+/*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\  */
+
+/* ============================================================================
+ *                             get_thread_option_context
+ *
+ * Gets the option context of the calling thread
+ *
+ * LOCK STATUS:  no, this does not block
+ *
+ * Returns:
+ *     The option context of the calling thread, or NULL if it uses the
+ *     process wide options.
+ *
+ * Index: threads, options
+ *
+ * ----------------------------------------------------------------------------
+*/
+const Option_context* get_thread_option_context(void)
+{
+#ifdef KJB_HAVE_PTHREAD
+    if ( ! fs_option_keys_made) return NULL;
+
+    return (const Option_context*)pthread_getspecific(fs_option_context_key);
+#else
+    return fs_option_context_ptr;
+#endif
+}
+
+/*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\  */
+
+/* ============================================================================
+ *                             get_module_options
+ *
+ * Gets the options of a module for reading
+ *
+ * This returns the options of the module described by module_ptr in the
+ * option context of the calling thread, or the process wide options if the
+ * thread has no context. This is meant to be cheap enough to call each time
+ * a module needs its options.
+ *
+ * LOCK STATUS:  no, this does not block
+ *
+ * Returns:
+ *     A pointer to the options struct of the module.
+ *
+ * Related:
+ *     get_module_options_for_update
+ *
+ * Index: threads, options
+ *
+ * ----------------------------------------------------------------------------
+*/
+const void* get_module_options(Option_module* module_ptr)
+{
+    const Option_context* context_ptr = get_thread_option_context();
+    int                   i;
+
+
+    if (context_ptr == NULL) return module_ptr->global_ptr;
+
+    for (i = 0; i < context_ptr->num_modules; i++)
+    {
+        if (context_ptr->modules[ i ] == module_ptr)
+        {
+            return context_ptr->options[ i ];
+        }
+    }
+
+    /*
+    // The module options were not yet changed when the context was made, so
+    // they had their initial values.
+    */
+    return module_ptr->initial_ptr;
+}
+
+/*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\  */
+
+/* ============================================================================
+ *                             get_module_options_for_update
+ *
+ * Gets the options of a module for changing
+ *
+ * This is used by set_<module>_options() functions. Within
+ * set_option_context_value(), it returns the options of the module in the
+ * context being set. Otherwise, it returns the process wide options.
+ *
+ * LOCK STATUS:  yes, the first time that the process wide options of a module
+ *               are changed, this locks the mutex protecting the module list.
+ *
+ * Returns:
+ *     A pointer to the options struct of the module, or NULL on failure with
+ *     an error message being set.
+ *
+ * Related:
+ *     get_module_options
+ *
+ * Index: threads, options
+ *
+ * ----------------------------------------------------------------------------
+*/
+void* get_module_options_for_update(Option_module* module_ptr)
+{
+    Option_context* context_ptr = get_thread_option_update_context();
+    int             result      = NO_ERROR;
+    int             i;
+
+
+    if (context_ptr != NULL)
+    {
+        for (i = 0; i < context_ptr->num_modules; i++)
+        {
+            if (context_ptr->modules[ i ] == module_ptr)
+            {
+                return context_ptr->options[ i ];
+            }
+        }
+
+        return add_module_options(context_ptr, module_ptr,
+                                  module_ptr->initial_ptr);
+    }
+
+    /* Contexts made from now on need to copy this module's options. */
+    if ( ! module_ptr->registered)
+    {
+        if (kjb_pthread_mutex_lock(&fs_option_module_mutex) == ERROR)
+        {
+            return NULL;
+        }
+
+        if ( ! module_ptr->registered)
+        {
+            if (fs_num_option_modules >= MAX_NUM_OPTION_MODULES)
+            {
+                set_error("Cannot track the options of module %s.",
+                          module_ptr->name);
+                add_error("There are already %d such modules.",
+                          MAX_NUM_OPTION_MODULES);
+                result = ERROR;
+            }
+            else
+            {
+                fs_option_modules[ fs_num_option_modules ] = module_ptr;
+                fs_num_option_modules++;
+                module_ptr->registered = TRUE;
+            }
+        }
+
+        EPETE(kjb_pthread_mutex_unlock(&fs_option_module_mutex));
+
+        if (result == ERROR) return NULL;
+    }
+
+    return module_ptr->global_ptr;
+}
+
+/*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\  */
+
+static void* add_module_options
+(
+    Option_context* context_ptr,
+    Option_module*  module_ptr,
+    const void*     source_ptr
+)
+{
+    void* options_ptr;
+
+
+    if (context_ptr->num_modules >= MAX_NUM_OPTION_MODULES)
+    {
+        set_error("Cannot add the options of module %s to an option context.",
+                  module_ptr->name);
+        add_error("It already has options for %d modules.",
+                  MAX_NUM_OPTION_MODULES);
+        return NULL;
+    }
+
+    NRN(options_ptr = kjb_mt_malloc(module_ptr->size));
+    kjb_memcpy(options_ptr, source_ptr, module_ptr->size);
+
+    context_ptr->modules[ context_ptr->num_modules ] = module_ptr;
+    context_ptr->options[ context_ptr->num_modules ] = options_ptr;
+    context_ptr->num_modules++;
+
+    return options_ptr;
+}
+
+/*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\  */
+
+static int set_thread_option_update_context(Option_context* context_ptr)
+{
+#ifdef KJB_HAVE_PTHREAD
+    ERE(kjb_pthread_once(&fs_option_keys_set_up, make_option_keys));
+
+    if ( ! fs_option_keys_made)
+    {
+        set_error("Cannot set option context: no thread specific data key.");
+        return ERROR;
+    }
+
+    return kjb_pthread_setspecific(fs_option_update_context_key, context_ptr);
+#else
+    fs_option_update_context_ptr = context_ptr;
+    return NO_ERROR;
+#endif
+}
+
+/*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\  */
+
+static Option_context* get_thread_option_update_context(void)
+{
+#ifdef KJB_HAVE_PTHREAD
+    if ( ! fs_option_keys_made) return NULL;
+
+    return (Option_context*)pthread_getspecific(fs_option_update_context_key);
+#else
+    return fs_option_update_context_ptr;
+#endif
+}
+
+/*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\  */
+
+#ifdef KJB_HAVE_PTHREAD
+
+static void make_option_keys(void)
+{
+    if (    (kjb_pthread_key_create(&fs_option_context_key, NULL) == ERROR)
+         || (kjb_pthread_key_create(&fs_option_update_context_key, NULL)
+                                                                    == ERROR)
+       )
+    {
+        kjb_print_error();
+        return;
+    }
+
+    fs_option_keys_made = TRUE;
+}
+
+#endif
+
+/*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\  */
+
+#ifdef __cplusplus
+}
+#endif
+
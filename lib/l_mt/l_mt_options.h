@@ -0,0 +1,105 @@
+/*
+ * $Id$
+ */
+
+#ifndef L_MT_OPTIONS_H_LIBKJB_INCLUDED
+#define L_MT_OPTIONS_H_LIBKJB_INCLUDED 1
+
+#include <l/l_sys_def.h>
+
+#ifdef __cplusplus
+extern "C" {
+#ifdef COMPILING_CPLUSPLUS_SOURCE
+namespace kjb_c {
+#endif
+#endif
+
+
+/* ============================================================================
+ *                             Option_module
+ *
+ * Describes the options of one module for option contexts
+ *
+ * A module that keeps its options in a struct (rather than in file statics)
+ * describes that struct with a static Option_module. The struct pointed to by
+ * global_ptr holds the process wide values, which are what the module's
+ * set_<module>_options() changes, as before. The struct pointed to by
+ * initial_ptr holds the values before any were set. Modules read their
+ * options with get_module_options(), which honors the option context of the
+ * calling thread (see create_option_context()), and change them with
+ * get_module_options_for_update(). The options structs are copied bytewise,
+ * so they should not hold pointers to allocated storage.
+ *
+ * So far, only the hull options (set_hull_options()) and the RANSAC options
+ * (set_ransac_options()) are kept this way. The following setters still
+ * write file statics, which all threads share. They are NOT thread safe yet:
+ * their options should only be set before threads are started, and setting
+ * them with set_option_context_value() changes the process wide values.
+ *
+ *     set_random_options()      -- l/l_sys_rand.c. The l library is below
+ *                                  l_mt, so it cannot use contexts.
+ *     set_em_cluster_options()  -- r/r_cluster.c and r2/r2_gmm_em.c.
+ *     set_keypoint_options()    -- kpt/keypoint.c.
+ *     set_image_input_options() -- i/i_float_io.c.
+ *
+ * Fields:
+ *     name        -- used in messages.
+ *     size        -- the size of the options struct.
+ *     initial_ptr -- the option values before any were set.
+ *     global_ptr  -- the process wide option values.
+ *     registered  -- set when the process wide values are first changed.
+ *                    Initialize to FALSE.
+ *
+ * Index: threads, options
+ *
+ * ----------------------------------------------------------------------------
+*/
+typedef struct Option_module
+{
+    const char* name;
+    size_t      size;
+    const void* initial_ptr;
+    void*       global_ptr;
+    int         registered;
+}
+Option_module;
+
+typedef struct Option_context Option_context;
+
+
+Option_context* create_option_context(void);
+
+int copy_option_context
+(
+    Option_context**      target_context_ptr_ptr,
+    const Option_context* context_ptr
+);
+
+void free_option_context(Option_context* context_ptr);
+
+int set_option_context_value
+(
+    Option_context* context_ptr,
+    int             (*set_fn)(const char*, const char*),
+    const char*     option,
+    const char*     value
+);
+
+int set_thread_option_context(const Option_context* context_ptr);
+
+const Option_context* get_thread_option_context(void);
+
+const void* get_module_options(Option_module* module_ptr);
+
+void* get_module_options_for_update(Option_module* module_ptr);
+
+
+#ifdef __cplusplus
+#ifdef COMPILING_CPLUSPLUS_SOURCE
+}
+#endif
+}
+#endif
+
+#endif
+
@@ -19,6 +19,7 @@
 #include "l/l_global.h"
 #include "l/l_string.h"
 #include "l_mt/l_mt_pthread.h"
+#include "l_mt/l_mt_options.h"
 
 /* Kobus: 17-03-05: FIXME. 
  * This is a bizarre construction for the pre-processor.  I hope it is portable.
@@ -77,7 +78,7 @@ static int fs_kjb_pthread_counter = 0;
    thread.  The 'seed1' and 'seed2' fields contain the seeds for random number
    generators used by the threads.
    For convenience, we also store the thread's userland worker function,
-   and its argument.
+   and its argument, and the option context of the thread that created it.
  */
 struct Thread_props
 {
@@ -87,6 +88,7 @@ struct Thread_props
     void* (*pfun)(void*);      /* pointer to the program the user wants to   */
                                /* run in a thread                            */
     void* arg;                 /* argument to the user's invocation of *pfun */
+    const Option_context* option_context; /* options the thread starts with */
 };
 
 /* The seed architecture here is based on that found in l_sys_rand.c, which
@@ -142,13 +144,13 @@ static double kjb_random_multithread(int generator_ix)
     if (kjb_pthread_equal(tid, fs_primal_tid))
     {
         /* primal thread runs the standard code */
-        return generator_ix ? kjb_rand_st() : kjb_rand_2_st();
+        return generator_ix ? kjb_rand_2_st() : kjb_rand_st();
     }
 
     /* all other threads use erand48() based on their respective seeds. */
     p=(struct Thread_props*) kjb_pthread_getspecific(fs_kjb_pthread_props_key);
     NGC(p);
-    return erand48(generator_ix ? p -> seed1 : p -> seed2);
+    return erand48(generator_ix ? p -> seed2 : p -> seed1);
 
 cleanup:
     add_error("Invalid behavior in kjb_random_multithread");
@@ -191,7 +193,7 @@ static double kjb_rand_multithread()
  *
  * This implements the action of 'kjb_rand_2()' for a multithreaded program
  * using the kjb_pthreads wrapper.  In other words, once multithreading is set
- * up, a call to kjb_rand() is redirected (using a function pointer) hither.
+ * up, a call to kjb_rand_2() is redirected (using a function pointer) hither.
  *
  * Returns:
  *     Uniform-distributed real sample in the range [0, 1).
@@ -288,6 +290,11 @@ static void* launchpad(void* v)
     NPETE(p);
     EPETE(kjb_pthread_setspecific(fs_kjb_pthread_props_key, p));
 
+    if (p -> option_context != NULL)
+    {
+        EPETE(set_thread_option_context(p -> option_context));
+    }
+
     /* run the user's function -- it might not return. */
     return (* p -> pfun)(p -> arg);
 }
@@ -458,6 +465,7 @@ static int kjb_pthread_create_unsafe(
     p -> thread_counter = ++fs_kjb_pthread_counter;
     p -> pfun = pfun;
     p -> arg = arg;
+    p -> option_context = get_thread_option_context();
 
     if ((rc = pthread_create(newthread, attr, &launchpad, p)))
     {
@@ -579,6 +587,10 @@ static int is_a_child_thread(void)
  * thread-safe.  Be sure to serialize library-based IO and memory allocation,
  * or anything that uses IO or memory allocation.
  *
+ * The new thread starts with the option context of the calling thread (see
+ * set_thread_option_context()), so modules that support option contexts use
+ * the same options in both.
+ *
  * LOCK STATUS:  yes, this locks/unlocks the thread_master_lock.
  *
  * Returns:
@@ -57,6 +57,12 @@
 #include "m_cpp/m_arith.h"
 #include "gr_cpp/gr_fbo_offscreen.h"
 
+#include <boost/thread.hpp>
+#include <boost/bind.hpp>
+#include <boost/ref.hpp>
+#include <algorithm>
+#include <cmath>
+
 using namespace kjb;
 
 #ifdef KJB_HAVE_GLEW
@@ -800,3 +806,343 @@ void Chamfer_likelihood::evaluate_dispatch_(float* buffer, bool reverse_y)
 }
 
 #endif /* have glew */
+
+
+/*  -------------------------------------------------------------------------- */
+/*  -------------------------------------------------------------------------- */
+/*  -------------------------------------------------------------------------- */
+
+Cpu_chamfer_likelihood::Cpu_chamfer_likelihood(size_t width, size_t height) :
+    Base(width, height),
+    distance_(),
+    position_(),
+    normal_x_(),
+    normal_y_(),
+    num_edges_(0),
+    pixel_stamp_(width * height, 0),
+    data_stamp_(width * height, 0),
+    stamp_(0),
+    pixels_(),
+    values_(),
+    orientation_sum_(0)
+{}
+
+void Cpu_chamfer_likelihood::check_dimensions_(size_t num_rows, size_t num_cols) const
+{
+    if(num_rows != height_ || num_cols != width_)
+    {
+        KJB_THROW(Dimension_mismatch);
+    }
+}
+
+void Cpu_chamfer_likelihood::set_maps(const Chamfer_transform& xfm)
+{
+    check_dimensions_(xfm.get_num_rows(), xfm.get_num_cols());
+
+    const Matrix& distance = xfm.distance_map();
+    const std::vector<std::vector<const kjb_c::Edge_point*> >& edge_map = xfm.edge_map();
+
+    const size_t N = width_ * height_;
+    distance_.resize(N);
+    position_.resize(N);
+    normal_x_.resize(N);
+    normal_y_.resize(N);
+
+    size_t i = 0;
+    for(size_t row = 0; row < height_; row++)
+    for(size_t col = 0; col < width_; col++, i++)
+    {
+        const kjb_c::Edge_point& pt = *edge_map[row][col];
+        const double mag = std::sqrt(pt.dcol * pt.dcol + pt.drow * pt.drow);
+
+        distance_[i] = distance(row, col);
+        position_[i] = pt.row * width_ + pt.col;
+        normal_x_[i] = mag > 0.0 ? pt.dcol / mag : 0.0;
+        normal_y_[i] = mag > 0.0 ? pt.drow / mag : 0.0;
+    }
+
+    num_edges_ = xfm.get_num_points();
+}
+
+void Cpu_chamfer_likelihood::set_maps(
+        const Matrix& distance,
+        const Int_matrix& row_position,
+        const Int_matrix& col_position,
+        size_t num_edges)
+{
+    check_dimensions_(distance.get_num_rows(), distance.get_num_cols());
+    check_dimensions_(row_position.get_num_rows(), row_position.get_num_cols());
+    check_dimensions_(col_position.get_num_rows(), col_position.get_num_cols());
+
+    const size_t N = width_ * height_;
+    distance_.resize(N);
+    position_.resize(N);
+    normal_x_.assign(N, 0.0f);
+    normal_y_.assign(N, 0.0f);
+
+    size_t i = 0;
+    for(size_t row = 0; row < height_; row++)
+    for(size_t col = 0; col < width_; col++, i++)
+    {
+        distance_[i] = distance(row, col);
+        position_[i] = row_position(row, col) * width_ + col_position(row, col);
+    }
+
+    num_edges_ = num_edges;
+}
+
+void Cpu_chamfer_likelihood::operator()(
+        const std::vector<Model_edge>& edges,
+        bool silhouettes_only)
+{
+    clear_edges();
+
+    for(size_t i = 0; i < edges.size(); i++)
+    {
+        const Model_edge& e = edges[i];
+        if(!e.is_visible() || (silhouettes_only && !e.is_silhouette()))
+        {
+            continue;
+        }
+
+        add_edge(e.get_start_x(), e.get_start_y(), e.get_end_x(), e.get_end_y());
+    }
+
+    evaluate();
+}
+
+void Cpu_chamfer_likelihood::add_edge(double x1, double y1, double x2, double y2)
+{
+    const double dx = x2 - x1;
+    const double dy = y2 - y1;
+    const double length = std::sqrt(dx * dx + dy * dy);
+
+    Edge_pixel pixel;
+    pixel.dir_x = length > 0.0 ? dx / length : 0.0;
+    pixel.dir_y = length > 0.0 ? dy / length : 0.0;
+
+    // Clip the segment to the pixels of the image (Liang-Barsky), so that
+    // edges projected far outside it cost nothing.
+    double t0 = 0.0;
+    double t1 = 1.0;
+    const double p[4] = { -dx, dx, -dy, dy };
+    const double q[4] = { x1 + 0.5, width_ - 0.5 - x1, y1 + 0.5, height_ - 0.5 - y1 };
+    for(int k = 0; k < 4; k++)
+    {
+        if(p[k] == 0.0)
+        {
+            if(q[k] < 0.0) return;
+        }
+        else
+        {
+            const double t = q[k] / p[k];
+            if(p[k] < 0.0)
+                t0 = std::max(t0, t);
+            else
+                t1 = std::min(t1, t);
+        }
+    }
+    if(t0 > t1) return;
+
+    const double cx1 = x1 + t0 * dx;
+    const double cy1 = y1 + t0 * dy;
+    const double cdx = (t1 - t0) * dx;
+    const double cdy = (t1 - t0) * dy;
+
+    // one pixel per step along the major axis
+    const int steps = static_cast<int>(std::ceil(std::max(std::fabs(cdx), std::fabs(cdy))));
+    const double sx = steps > 0 ? cdx / steps : 0.0;
+    const double sy = steps > 0 ? cdy / steps : 0.0;
+
+    for(int k = 0; k <= steps; k++)
+    {
+        const int col = static_cast<int>(std::floor(cx1 + k * sx + 0.5));
+        const int row = static_cast<int>(std::floor(cy1 + k * sy + 0.5));
+
+        if(col < 0 || row < 0 || col >= (int) width_ || row >= (int) height_)
+        {
+            continue;
+        }
+
+        pixel.index = row * width_ + col;
+        pixels_.push_back(pixel);
+    }
+}
+
+void Cpu_chamfer_likelihood::evaluate()
+{
+    if(distance_.empty())
+    {
+        KJB_THROW_2(Runtime_error, "Cpu_chamfer_likelihood: set_maps() must be called before evaluating.");
+    }
+
+    if(++stamp_ == 0)
+    {
+        std::fill(pixel_stamp_.begin(), pixel_stamp_.end(), 0);
+        std::fill(data_stamp_.begin(), data_stamp_.end(), 0);
+        stamp_ = 1;
+    }
+
+    // gather the distances of the distinct model pixels
+    values_.clear();
+    double orientation = 0.0;
+    size_t correspondences = 0;
+    for(size_t k = 0; k < pixels_.size(); k++)
+    {
+        const Edge_pixel& pixel = pixels_[k];
+        const uint32_t i = pixel.index;
+        if(pixel_stamp_[i] == stamp_)
+        {
+            continue;
+        }
+        pixel_stamp_[i] = stamp_;
+
+        values_.push_back(distance_[i]);
+        orientation += std::fabs(pixel.dir_x * normal_x_[i] + pixel.dir_y * normal_y_[i]);
+
+        const uint32_t c = position_[i];
+        if(data_stamp_[c] != stamp_)
+        {
+            data_stamp_[c] = stamp_;
+            correspondences++;
+        }
+    }
+
+    // independent partial sums, so the loops vectorize
+    const size_t n = values_.size();
+    const float* v = values_.empty() ? NULL : &values_[0];
+    double acc[4] = { 0.0, 0.0, 0.0, 0.0 };
+    size_t k = 0;
+    if(square_values_)
+    {
+        for(; k + 4 <= n; k += 4)
+        {
+            acc[0] += double(v[k]) * v[k];
+            acc[1] += double(v[k + 1]) * v[k + 1];
+            acc[2] += double(v[k + 2]) * v[k + 2];
+            acc[3] += double(v[k + 3]) * v[k + 3];
+        }
+        for(; k < n; k++)
+        {
+            acc[0] += double(v[k]) * v[k];
+        }
+    }
+    else
+    {
+        for(; k + 4 <= n; k += 4)
+        {
+            acc[0] += v[k];
+            acc[1] += v[k + 1];
+            acc[2] += v[k + 2];
+            acc[3] += v[k + 3];
+        }
+        for(; k < n; k++)
+        {
+            acc[0] += v[k];
+        }
+    }
+
+    sum_ = (acc[0] + acc[1]) + (acc[2] + acc[3]);
+    orientation_sum_ = orientation;
+    model_points_ = n;
+    data_points_ = num_edges_;
+    correspondences_ = correspondences;
+}
+
+/*  -------------------------------------------------------------------------- */
+
+void Multi_cpu_chamfer_likelihood::square_values(bool enabled)
+{
+    square_values_ = enabled;
+    for(size_t i = 0; i < views_.size(); i++)
+    {
+        views_[i].square_values(enabled);
+    }
+}
+
+void Multi_cpu_chamfer_likelihood::push_back(const Chamfer_transform& xfm)
+{
+    views_.push_back(Cpu_chamfer_likelihood(width_, height_));
+    views_.back().square_values(square_values_);
+    views_.back().set_maps(xfm);
+}
+
+void Multi_cpu_chamfer_likelihood::push_back(
+        const Matrix& distance,
+        const Int_matrix& row_position,
+        const Int_matrix& col_position,
+        size_t num_edges)
+{
+    views_.push_back(Cpu_chamfer_likelihood(width_, height_));
+    views_.back().square_values(square_values_);
+    views_.back().set_maps(distance, row_position, col_position, num_edges);
+}
+
+void Multi_cpu_chamfer_likelihood::evaluate_views_(
+        const std::vector<std::vector<Model_edge> >& edges,
+        bool silhouettes_only,
+        size_t begin,
+        size_t end)
+{
+    for(size_t i = begin; i < end; i++)
+    {
+        views_[i](edges[i], silhouettes_only);
+    }
+}
+
+void Multi_cpu_chamfer_likelihood::operator()(
+        const std::vector<std::vector<Model_edge> >& edges,
+        bool silhouettes_only)
+{
+    const size_t num_views = views_.size();
+    if(edges.size() != num_views)
+    {
+        KJB_THROW(Dimension_mismatch);
+    }
+
+    size_t nt = num_threads_;
+    size_t avail_cores = boost::thread::hardware_concurrency();
+    if(nt == 0 || nt > avail_cores)
+    {
+        nt = avail_cores;
+    }
+    if(nt > num_views)
+    {
+        nt = num_views;
+    }
+
+    if(nt <= 1)
+    {
+        evaluate_views_(edges, silhouettes_only, 0, num_views);
+    }
+    else
+    {
+        boost::thread_group thrds;
+        for(size_t i = 0; i < nt; i++)
+        {
+            size_t st = (num_views / nt) * i;
+            size_t l = (i == nt - 1 ? num_views : (num_views / nt) * (i + 1));
+            thrds.create_thread(boost::bind(
+                        &Multi_cpu_chamfer_likelihood::evaluate_views_, this,
+                        boost::cref(edges), silhouettes_only, st, l));
+        }
+        thrds.join_all();
+    }
+
+    sum_ = 0;
+    orientation_sum_ = 0;
+    model_points_ = 0;
+    correspondences_ = 0;
+    data_points_ = 0;
+
+    for(size_t i = 0; i < num_views; i++)
+    {
+        const Cpu_chamfer_likelihood& view = views_[i];
+
+        sum_ += square_values_ ? view.get_sq_sum() : view.get_sum();
+        orientation_sum_ += view.get_orientation_sum();
+        model_points_ += view.get_num_model_points();
+        correspondences_ += view.get_num_correspondences();
+        data_points_ += view.get_num_data_points();
+    }
+}
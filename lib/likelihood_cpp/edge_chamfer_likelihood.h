@@ -35,6 +35,7 @@
 #include <l_cpp/l_debug.h>
 
 #include "edge_cpp/edge_chamfer.h"
+#include "likelihood_cpp/model_edge.h"
 
 #ifdef KJB_HAVE_GLEW
 #include "GL/glew.h"
@@ -69,8 +70,6 @@ namespace kjb {
 
 
 
-#ifdef KJB_HAVE_OPENGL
-#ifdef KJB_HAVE_GLEW
 class Base_chamfer_likelihood
 {
 public:
@@ -80,7 +79,12 @@ public:
         data_points_(0),
         correspondences_(0),
         square_values_(false),
-        offscreen_buffer_(width, height)
+        width_(width),
+        height_(height)
+    {
+    }
+
+    virtual ~Base_chamfer_likelihood()
     {
     }
 
@@ -146,10 +150,14 @@ protected:
 
     bool square_values_;
 
-    ::kjb::opengl::Fbo_offscreen_buffer offscreen_buffer_;
+    size_t width_;
+    size_t height_;
 };
 
 
+
+#ifdef KJB_HAVE_OPENGL
+#ifdef KJB_HAVE_GLEW
 #ifdef KJB_HAVE_CUDA
 
 class Base_gpu_chamfer_likelihood : public Base_chamfer_likelihood
@@ -162,6 +170,7 @@ public:
      */
     Base_gpu_chamfer_likelihood(int width_in, int height_in) :
         Base(width_in, height_in),
+        offscreen_buffer_(width_in, height_in),
         cuda_rbo_handle_(),
         reduce_mod_()
     {
@@ -192,6 +201,8 @@ protected:
         CU_ETX(cuGraphicsUnmapResources(1, &cuda_rbo_handle_, 0));
     }
 protected:
+    ::kjb::opengl::Fbo_offscreen_buffer offscreen_buffer_;
+
     CUgraphicsResource cuda_rbo_handle_;
 
     gpu::Cuda_reduce_module reduce_mod_;
@@ -503,6 +514,7 @@ class Chamfer_likelihood : public Base_chamfer_likelihood
 public:
     Chamfer_likelihood(size_t width, size_t height) :
         Base_chamfer_likelihood(width, height),
+        offscreen_buffer_(width, height),
         distance_(NULL),
         row_position_(),
         col_position_(),
@@ -536,6 +548,8 @@ public:
 
     void evaluate_dispatch_(float* buffer, bool invert_y);
 private:
+    ::kjb::opengl::Fbo_offscreen_buffer offscreen_buffer_;
+
     const Matrix* distance_;
     Int_matrix row_position_;
     Int_matrix col_position_;
@@ -544,6 +558,225 @@ private:
 #endif /* have glew */
 #endif /* have opengl  */
 
+/**
+ * Chamfer likelihood that rasterizes projected model edges in software.
+ *
+ * This computes the same statistics as Chamfer_likelihood, but instead of
+ * rendering with OpenGL and reading back the whole frame buffer, it walks each
+ * projected edge (e.g., from prepare_model_edges() on a Polymesh such as a
+ * Parapiped) and appends its pixels, with the edge direction, to a buffer
+ * that is reused from one evaluation to the next. Only those pixels are then
+ * looked up in the distance and position maps of the Chamfer_transform, so
+ * the cost depends on the length of the model edges and not on the size of
+ * the image, and no OpenGL context is needed.
+ *
+ * Edge coordinates are (x, y) = (column, row) in the image of the
+ * Chamfer_transform. A pixel covered by several edges counts once, as it
+ * would in a rendered binary image.
+ *
+ * In addition to the distances, the likelihood sums the misalignment of each
+ * model pixel with the nearest data edge point, |sin| of the angle between
+ * the model edge and the data edge (0 if parallel, 1 if perpendicular), which
+ * can be retrieved with get_orientation_sum().
+ */
+class Cpu_chamfer_likelihood : public Base_chamfer_likelihood
+{
+typedef Base_chamfer_likelihood Base;
+public:
+    /** @brief  A model edge pixel and the unit direction of its edge. */
+    struct Edge_pixel
+    {
+        uint32_t index;     ///< row * width + col
+        float dir_x;
+        float dir_y;
+    };
+
+    Cpu_chamfer_likelihood(size_t width, size_t height);
+
+    /**
+     * Use the distance and position maps, and the edge orientations, of
+     * xfm. The dimensions of xfm must be width x height.
+     */
+    void set_maps(const Chamfer_transform& xfm);
+
+    /**
+     * Use the given distance and position maps; the orientation sum is
+     * zero in this case, since the data edge orientations are unknown.
+     */
+    void set_maps(
+            const Matrix& distance,
+            const Int_matrix& row_position,
+            const Int_matrix& col_position,
+            size_t num_edges);
+
+    /**
+     * Rasterize the visible edges (only the silhouette edges, if
+     * silhouettes_only is true) and evaluate them.
+     */
+    void operator()(
+            const std::vector<Model_edge>& edges,
+            bool silhouettes_only = false);
+
+    /** Empty the edge pixel buffer, to add edges one by one. */
+    void clear_edges()
+    {
+        pixels_.clear();
+    }
+
+    /** Rasterize the segment from (x1, y1) to (x2, y2) into the buffer. */
+    void add_edge(double x1, double y1, double x2, double y2);
+
+    /** Evaluate the edge pixels added since the last clear_edges(). */
+    void evaluate();
+
+    /// Call after evaluating to retrieve the summed orientation mismatch.
+    double get_orientation_sum() const
+    {
+        return orientation_sum_;
+    }
+
+    /// The edge pixels of the last evaluation (duplicates included).
+    const std::vector<Edge_pixel>& get_edge_pixels() const
+    {
+        return pixels_;
+    }
+
+private:
+    void check_dimensions_(size_t num_rows, size_t num_cols) const;
+
+    std::vector<float> distance_;
+    std::vector<uint32_t> position_;   // row * width + col of nearest point
+    std::vector<float> normal_x_;      // unit gradient at the nearest point
+    std::vector<float> normal_y_;
+    size_t num_edges_;
+
+    // A pixel (or data point) has been seen in the current evaluation iff
+    // its stamp equals stamp_, so the buffers never need clearing.
+    std::vector<uint32_t> pixel_stamp_;
+    std::vector<uint32_t> data_stamp_;
+    uint32_t stamp_;
+
+    std::vector<Edge_pixel> pixels_;
+    std::vector<float> values_;
+    double orientation_sum_;
+};
+
+/**
+ * Chamfer likelihood for multi-view objects, rasterizing in software.
+ *
+ * This is the counterpart of Multi_gpu_chamfer_likelihood for
+ * Cpu_chamfer_likelihood. The views are independent, so they are evaluated
+ * in parallel.
+ */
+class Multi_cpu_chamfer_likelihood
+{
+public:
+    /**
+     * @param num_threads Number of threads used to evaluate the views; 0
+     *                    means one per hardware thread.
+     */
+    Multi_cpu_chamfer_likelihood(int width, int height, size_t num_threads = 0) :
+        width_(width),
+        height_(height),
+        num_threads_(num_threads),
+        views_(),
+        sum_(0),
+        orientation_sum_(0),
+        model_points_(0),
+        data_points_(0),
+        correspondences_(0),
+        square_values_(false)
+    { }
+
+    void square_values(bool enabled);
+
+    /**
+     * Add data from a new viewpoint.
+     */
+    void push_back(const Chamfer_transform& xfm);
+
+    /**
+     * Add data from a new viewpoint, given as distance and position maps.
+     */
+    void push_back(
+            const Matrix& distance,
+            const Int_matrix& row_position,
+            const Int_matrix& col_position,
+            size_t num_edges);
+
+    /**
+     * Evaluate the model edges of each view; edges[i] are the projected
+     * edges in the i-th view that was added with push_back().
+     */
+    void operator()(
+            const std::vector<std::vector<Model_edge> >& edges,
+            bool silhouettes_only = false);
+
+    double get_sum() const
+    {
+        if(square_values_)
+        {
+            KJB_THROW_2(Runtime_error, "Attempting to get sum when square_values is set.  Use get_sq_sum() instead.");
+        }
+        return sum_;
+    }
+
+    double get_sq_sum() const
+    {
+        if(!square_values_)
+        {
+            KJB_THROW_2(Runtime_error, "Attempting to get squared sum when square_values is not set.  Use get_sum() instead, or call square_values(true) and re-evaluate.");
+        }
+
+        return sum_;
+    }
+
+    double get_orientation_sum() const
+    {
+        return orientation_sum_;
+    }
+
+    size_t get_num_correspondences() const
+    {
+        return correspondences_;
+    }
+
+    size_t get_num_data_points() const
+    {
+        return data_points_;
+    }
+
+    size_t get_num_model_points() const
+    {
+        return model_points_;
+    }
+
+    size_t num_views() const
+    {
+        return views_.size();
+    }
+
+private:
+    void evaluate_views_(
+            const std::vector<std::vector<Model_edge> >& edges,
+            bool silhouettes_only,
+            size_t begin,
+            size_t end);
+
+    int width_;
+    int height_;
+    size_t num_threads_;
+    std::vector<Cpu_chamfer_likelihood> views_;
+
+    double sum_;
+    double orientation_sum_;
+    size_t model_points_;
+    size_t data_points_;
+    size_t correspondences_;
+
+    bool square_values_;
+};
+
 } // namespace kjb
 
 #endif
@@ -0,0 +1,151 @@
+/* $Id$ */
+/* =========================================================================== *
+   |
+   |  Copyright (c) 1994-2010 by Kobus Barnard (author)
+   |
+   |  Personal and educational use of this code is granted, provided that this
+   |  header is kept intact, and that the authorship is not misrepresented, that
+   |  its use is acknowledged in publications, and relevant papers are cited.
+   |
+   |  For other use contact the author (kobus AT cs DOT arizona DOT edu).
+   |
+   |  Please note that the code in this file has not necessarily been adequately
+   |  tested. Naturally, there is no guarantee of performance, support, or fitness
+   |  for any particular task. Nonetheless, I am interested in hearing about
+   |  problems that you encounter.
+   |
+ * =========================================================================== */
+
+/*
+ * Checks the software-rasterized chamfer likelihood against distances that
+ * can be worked out by hand: the data is a single vertical edge, so the
+ * chamfer distance of a pixel is its horizontal distance to that edge.
+ */
+
+#include <likelihood_cpp/edge_chamfer_likelihood.h>
+#include <likelihood_cpp/model_edge.h>
+#include <l_cpp/l_test.h>
+
+#include <vector>
+#include <cmath>
+
+using namespace kjb;
+
+namespace {
+
+const int WIDTH = 64;
+const int HEIGHT = 48;
+const int DATA_COL = 20;
+
+void make_maps(Matrix& distance, Int_matrix& row_position, Int_matrix& col_position)
+{
+    distance = Matrix(HEIGHT, WIDTH);
+    row_position = Int_matrix(HEIGHT, WIDTH);
+    col_position = Int_matrix(HEIGHT, WIDTH);
+
+    for(int row = 0; row < HEIGHT; row++)
+    for(int col = 0; col < WIDTH; col++)
+    {
+        distance(row, col) = std::abs(col - DATA_COL);
+        row_position(row, col) = row;
+        col_position(row, col) = DATA_COL;
+    }
+}
+
+} // anonymous namespace
+
+int main(int, char**)
+{
+    Matrix distance;
+    Int_matrix row_position, col_position;
+    make_maps(distance, row_position, col_position);
+
+    Cpu_chamfer_likelihood likelihood(WIDTH, HEIGHT);
+    likelihood.set_maps(distance, row_position, col_position, HEIGHT);
+
+    // vertical model edge 5 pixels from the data, rows 10..29
+    std::vector<Model_edge> edges;
+    edges.push_back(Model_edge(25, 10, 25, 29, false, true));
+    likelihood(edges);
+
+    TEST_TRUE(likelihood.get_num_model_points() == 20);
+    TEST_TRUE(likelihood.get_num_correspondences() == 20);
+    TEST_TRUE(likelihood.get_num_data_points() == HEIGHT);
+    TEST_TRUE(likelihood.get_sum() == 20 * 5);
+
+    // the same edge twice, reversed, covers the same pixels
+    edges.push_back(Model_edge(25, 29, 25, 10, false, true));
+    likelihood(edges);
+    TEST_TRUE(likelihood.get_num_model_points() == 20);
+    TEST_TRUE(likelihood.get_sum() == 20 * 5);
+
+    // an invisible edge is skipped, and so is an inner edge when only
+    // silhouettes are requested
+    edges.push_back(Model_edge(0, 0, 63, 0, false, false));
+    likelihood(edges);
+    TEST_TRUE(likelihood.get_num_model_points() == 20);
+    likelihood(edges, true);
+    TEST_TRUE(likelihood.get_num_model_points() == 0);
+    TEST_TRUE(likelihood.get_sum() == 0);
+
+    // horizontal edge on row 3, crossing the image and clipped to it; all its
+    // pixels correspond to the same data point
+    edges.clear();
+    edges.push_back(Model_edge(-100, 3, 200, 3, true, true));
+    likelihood.square_values(true);
+    likelihood(edges, true);
+    TEST_TRUE(likelihood.get_num_model_points() == WIDTH);
+    TEST_TRUE(likelihood.get_num_correspondences() == 1);
+    double sq_sum = 0;
+    for(int col = 0; col < WIDTH; col++)
+    {
+        sq_sum += (col - DATA_COL) * (col - DATA_COL);
+    }
+    TEST_TRUE(likelihood.get_sq_sum() == sq_sum);
+
+    // an edge entirely outside the image
+    edges.clear();
+    edges.push_back(Model_edge(-10, -10, -50, 100, true, true));
+    likelihood(edges);
+    TEST_TRUE(likelihood.get_num_model_points() == 0);
+
+    // a diagonal edge has one pixel per row
+    likelihood.square_values(false);
+    likelihood.clear_edges();
+    likelihood.add_edge(0, 0, 40, 40);
+    likelihood.evaluate();
+    TEST_TRUE(likelihood.get_num_model_points() == 41);
+
+    // views are independent, so evaluating several at once adds them up
+    const size_t NUM_VIEWS = 5;
+    Multi_cpu_chamfer_likelihood multi(WIDTH, HEIGHT, 3);
+    Cpu_chamfer_likelihood single(WIDTH, HEIGHT);
+    std::vector<std::vector<Model_edge> > view_edges(NUM_VIEWS);
+    for(size_t i = 0; i < NUM_VIEWS; i++)
+    {
+        view_edges[i].push_back(Model_edge(22 + i, 5, 30 + i, 40, true, true));
+    }
+
+    double sum = 0;
+    size_t model_points = 0;
+    for(size_t i = 0; i < NUM_VIEWS; i++)
+    {
+        single.set_maps(distance, row_position, col_position, HEIGHT);
+        single(view_edges[i]);
+        sum += single.get_sum();
+        model_points += single.get_num_model_points();
+    }
+
+    for(size_t i = 0; i < NUM_VIEWS; i++)
+    {
+        multi.push_back(distance, row_position, col_position, HEIGHT);
+    }
+    multi(view_edges);
+    TEST_TRUE(multi.num_views() == NUM_VIEWS);
+    TEST_TRUE(std::fabs(multi.get_sum() - sum) < 1e-9);
+    TEST_TRUE(multi.get_num_model_points() == model_points);
+    TEST_TRUE(multi.get_num_data_points() == NUM_VIEWS * HEIGHT);
+
+    RETURN_VICTORIOUSLY();
+}
+
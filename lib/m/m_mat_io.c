@@ -20,8 +20,16 @@
 * =========================================================================== */
 
 #include "m/m_gen.h"      /*  Only safe if first #include in a ".c" file  */
+#include "l_mt/l_mt_pthread.h"
 #include "m/m_mat_io.h"
 
+#ifdef UNIX
+#    include <fcntl.h>
+#    include <sys/mman.h>
+#    include <sys/stat.h>
+#    include <locale.h>
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -32,8 +40,150 @@ extern "C" {
 #define KJB_RAW_MATRIX_STRING  "kjb raw matrix\n\n\f\n"
 #define KJB_RAW_MATRIX_VECTOR_STRING  "kjb raw matrix vector\n\n\f\n"
 
+/*
+// Tokens at least this long are split by BUFF_GEN_GET_TOKEN() into the 200 byte
+// buffer used for numbers, so we leave them to the line by line reader.
+*/
+#define MAX_MAPPED_TOKEN_LEN  199
+
+/* Longest locale decimal point that scan_mapped_double() puts in a token. */
+#define MAX_DECIMAL_POINT_LEN  8
+
+/* Don't start a thread for fewer numbers than this. */
+#define MIN_ELEMENTS_PER_READ_THREAD  4096
+
+#define MAPPED_BLANK_LINE     0
+#define MAPPED_COMMENT_LINE   1
+#define MAPPED_SOFT_EOF_LINE  2
+#define MAPPED_DATA_LINE      3
+
+/* -------------------------------------------------------------------------- */
+
+typedef struct Mapped_matrix_job
+{
+    Matrix*      mp;
+    const char** row_starts;
+    const char*  map_end;
+    char*        row_needs_scan;
+    const char*  decimal_point;
+    int          first_row;
+    int          last_row;
+}
+Mapped_matrix_job;
+
+/* -------------------------------------------------------------------------- */
+
+static int fs_matrix_read_num_threads = 0;
+
+/* -------------------------------------------------------------------------- */
+
+static int read_formatted_matrix_row
+(
+    Matrix*     mp,
+    int         row,
+    const char* line,
+    FILE*       fp
+);
+
+#ifdef UNIX
+static int fp_read_mapped_formatted_matrix(Matrix** result_mpp, FILE* fp);
+
+static int get_mapped_line_type(const char* line, const char* line_end);
+
+static const char* get_mapped_line_end
+(
+    const char* line,
+    const char* map_end,
+    const char** next_line_ptr
+);
+
+static int get_matrix_read_num_threads(void);
+
+static void* mapped_matrix_job_main(void* arg);
+
+static int scan_mapped_double
+(
+    const char* str,
+    const char* str_end,
+    const char* decimal_point,
+    double*     double_ptr
+);
+#endif
+
 /* -------------------------------------------------------------------------- */
 
+/* =============================================================================
+ *                           set_matrix_io_options
+ *
+ * Sets options for matrix I/O
+ *
+ * Currently the only option is "matrix-read-threads", the number of threads
+ * used to parse formatted matrix files (see fp_read_formatted_matrix()). The
+ * value 0, which is the default, means one thread per processor.
+ *
+ * Returns:
+ *     NO_ERROR if the option was handled, NOT_FOUND if it is not a matrix I/O
+ *     option, and ERROR if the value is bad.
+ *
+ * Index: set options, I/O, matrix I/O
+ *
+ * -----------------------------------------------------------------------------
+*/
+
+int set_matrix_io_options(const char* option, const char* value)
+{
+    char lc_option[ 100 ];
+    int  result = NOT_FOUND;
+    int  temp_int_value;
+
+
+    EXTENDED_LC_BUFF_CPY(lc_option, option);
+
+    if (    (lc_option[ 0 ] == '\0')
+         || (match_pattern(lc_option, "matrix-read-threads"))
+       )
+    {
+        if (value == NULL)
+        {
+            return NO_ERROR;
+        }
+        else if (value[ 0 ] == '?')
+        {
+            ERE(pso("matrix-read-threads = %d\n",
+                    fs_matrix_read_num_threads));
+        }
+        else if (value[ 0 ] == '\0')
+        {
+            if (fs_matrix_read_num_threads == 0)
+            {
+                ERE(pso("Formatted matrices are read with one thread per processor.\n"));
+            }
+            else
+            {
+                ERE(pso("Formatted matrices are read with %d threads.\n",
+                        fs_matrix_read_num_threads));
+            }
+        }
+        else
+        {
+            ERE(ss1i(value, &temp_int_value));
+
+            if (temp_int_value < 0)
+            {
+                set_error("The number of matrix read threads cannot be negative.");
+                return ERROR;
+            }
+
+            fs_matrix_read_num_threads = temp_int_value;
+        }
+        result = NO_ERROR;
+    }
+
+    return result;
+}
+
+/*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\   */
+
 /* =============================================================================
  *                        read_matrix_from_config_file
  *
@@ -565,6 +715,13 @@ int fp_read_matrix_with_header(Matrix** result_mpp, FILE* fp)
  *
  * "fp" points to type FILE as returned by "kjb_fopen".
  *
+ * If fp is a regular file opened only for reading, then the file is mapped into
+ * memory and the rows are parsed in parallel (see the option
+ * "matrix-read-threads" in set_matrix_io_options()). Rows with anything other
+ * than plain numbers (e.g., "off", "nan", or percentages) are parsed as
+ * before, so the result and the error messages do not depend on which way the
+ * file is read. Numbers written by fp_write_matrix_full_precision() are read
+ * back exactly.
  *
  * Returns:
  *     Either NO_ERROR, or ERROR, with an appropriate error message being set.
@@ -573,7 +730,7 @@ int fp_read_matrix_with_header(Matrix** result_mpp, FILE* fp)
  *     Lindsay Martin
  *
  * Related:
- *     read_matrix, kjb_print_error.
+ *     read_matrix, set_matrix_io_options, kjb_print_error.
  *
  * Index: I/O, matrices, matrix I/O
  *
@@ -582,18 +739,27 @@ int fp_read_matrix_with_header(Matrix** result_mpp, FILE* fp)
 
 int fp_read_formatted_matrix(Matrix** result_mpp, FILE* fp)
 {
-    IMPORT volatile Bool io_atn_flag;
-    IMPORT volatile Bool halt_all_output;
     Matrix* mp;
     char    line[ LARGE_IO_BUFF_SIZE ];
     char    num_buff[ 200 ];
     int     num_cols;
     int     num_rows;
-    int     i,j;
+    int     i;
     char*    line_pos;
-    int     scan_res;
+#ifdef UNIX
+    int     result;
+#endif
 
 
+#ifdef UNIX
+    result = fp_read_mapped_formatted_matrix(result_mpp, fp);
+
+    if (result != NOT_FOUND)
+    {
+        return result;
+    }
+#endif
+
     ERE(num_rows = count_real_lines(fp));
 
     if ((num_rows == 0) || (num_rows == EOF))
@@ -638,32 +804,7 @@ int fp_read_formatted_matrix(Matrix** result_mpp, FILE* fp)
             ERE(BUFF_GET_REAL_LINE(fp, line));
         }
 
-        line_pos = line;
-
-        for (j=0; j<num_cols; j++)
-        {
-            if (! BUFF_GEN_GET_TOKEN_OK(&line_pos, num_buff,
-                                        " ,\t"))
-            {
-                set_error("Missing data on row %d of %F.", (i+1), fp);
-                return ERROR;
-            }
-
-            scan_res = ss1snd(num_buff, ((mp->elements)[i])+j);
-
-            if (scan_res == ERROR)
-            {
-                insert_error("Error reading floating point number from %F.",
-                             fp);
-                return ERROR;
-            }
-            else if (io_atn_flag)
-            {
-                halt_all_output = FALSE;
-                set_error("Processing interrupted.");
-                return ERROR;
-            }
-        }
+        ERE(read_formatted_matrix_row(mp, i, line, fp));
     }
 
     /*
@@ -695,6 +836,708 @@ int fp_read_formatted_matrix(Matrix** result_mpp, FILE* fp)
 
 /*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\   */
 
+static int read_formatted_matrix_row
+(
+    Matrix*     mp,
+    int         row,
+    const char* line,
+    FILE*       fp
+)
+{
+    IMPORT volatile Bool io_atn_flag;
+    IMPORT volatile Bool halt_all_output;
+    char        num_buff[ 200 ];
+    const char* line_pos = line;
+    int         j;
+    int         scan_res;
+
+
+    for (j=0; j<mp->num_cols; j++)
+    {
+        if (! BUFF_CONST_GEN_GET_TOKEN_OK(&line_pos, num_buff, " ,\t"))
+        {
+            set_error("Missing data on row %d of %F.", (row+1), fp);
+            return ERROR;
+        }
+
+        scan_res = ss1snd(num_buff, ((mp->elements)[row])+j);
+
+        if (scan_res == ERROR)
+        {
+            insert_error("Error reading floating point number from %F.",
+                         fp);
+            return ERROR;
+        }
+        else if (io_atn_flag)
+        {
+            halt_all_output = FALSE;
+            set_error("Processing interrupted.");
+            return ERROR;
+        }
+    }
+
+    return NO_ERROR;
+}
+
+/*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\   */
+
+#ifdef UNIX
+
+/*
+ * Reads a formatted matrix from a memory map of fp. The lines are found the
+ * same way as get_real_line() finds them, and the rows are then split among
+ * threads. A row which is not just plain numbers is marked, and read
+ * afterwards with read_formatted_matrix_row(), which gives the same result and
+ * error messages as reading the file line by line.
+ *
+ * NOT_FOUND is returned, with fp not moved, if the file cannot be mapped, or
+ * has anything the line by line reader handles specially (very long lines, NUL
+ * characters, no data before the next soft EOF).
+*/
+static int fp_read_mapped_formatted_matrix(Matrix** result_mpp, FILE* fp)
+{
+    IMPORT volatile Bool io_atn_flag;
+    IMPORT volatile Bool halt_all_output;
+    struct stat        file_stats;
+    long               start_pos;
+    size_t             map_size;
+    char*              map;
+    const char*        map_end;
+    const char*        data_end;
+    const char*        line;
+    const char*        line_end;
+    const char*        next_line;
+    const char*        first_line_end = NULL;
+    const char**       row_starts     = NULL;
+    char*              row_needs_scan = NULL;
+    char*              line_buff      = NULL;
+    Mapped_matrix_job* jobs           = NULL;
+    kjb_pthread_t*     threads        = NULL;
+    int*               started        = NULL;
+    char               decimal_point[ MAX_DECIMAL_POINT_LEN + ROOM_FOR_NULL ];
+    size_t             max_line_len;
+    size_t             token_len;
+    int                line_type;
+    int                num_rows       = 0;
+    int                num_cols       = 0;
+    int                num_threads;
+    int                i, t;
+    int                result         = NO_ERROR;
+
+
+    if (fstat(fileno(fp), &file_stats) == -1) return NOT_FOUND;
+    if ( ! S_ISREG(file_stats.st_mode)) return NOT_FOUND;
+
+    /*
+    // localeconv() is not thread safe, so the decimal point is looked up here
+    // for the threads. If it does not fit, the rare tokens which need it are
+    // left to the line by line reader.
+    */
+    if (strlen(localeconv()->decimal_point) > MAX_DECIMAL_POINT_LEN)
+    {
+        decimal_point[ 0 ] = '\0';
+    }
+    else
+    {
+        BUFF_CPY(decimal_point, localeconv()->decimal_point);
+    }
+
+    /*
+    // If the stream could also be written, there may be output in its buffer
+    // which is not in the file yet.
+    */
+    if ((fcntl(fileno(fp), F_GETFL) & O_ACCMODE) != O_RDONLY) return NOT_FOUND;
+
+    start_pos = ftell(fp);
+
+    if ((start_pos < 0) || ((off_t)start_pos >= file_stats.st_size))
+    {
+        return NOT_FOUND;
+    }
+
+    map_size = (size_t)file_stats.st_size;
+    map = (char*)mmap(NULL, map_size, PROT_READ, MAP_PRIVATE, fileno(fp), 0);
+
+    if (map == MAP_FAILED) return NOT_FOUND;
+
+    map_end = map + map_size;
+
+    /* As in fget_line(), the longest line that is not truncated. */
+    max_line_len = MIN_OF(LARGE_IO_BUFF_SIZE, GET_LINE_BUFF_SIZE) - 1;
+
+    /*
+    // First pass: find where the matrix ends (soft or hard EOF), count the
+    // rows, and check that there is nothing we don't handle.
+    */
+    line = map + start_pos;
+    data_end = map_end;
+
+    while (line < map_end)
+    {
+        line_end = get_mapped_line_end(line, map_end, &next_line);
+
+        if (    ((size_t)(next_line - line) >= max_line_len)
+             || (memchr(line, '\0', (size_t)(line_end - line)) != NULL)
+           )
+        {
+            result = NOT_FOUND;
+            break;
+        }
+
+        line_type = get_mapped_line_type(line, line_end);
+
+        if (line_type == MAPPED_SOFT_EOF_LINE)
+        {
+            data_end = next_line;
+            break;
+        }
+        else if (line_type == MAPPED_DATA_LINE)
+        {
+            if (num_rows == 0) first_line_end = line_end;
+            num_rows++;
+        }
+
+        line = next_line;
+    }
+
+    if (num_rows == 0) result = NOT_FOUND;
+
+    /* The number of columns is the number of tokens on the first row. */
+    if (result == NO_ERROR)
+    {
+        line = map + start_pos;
+
+        while (get_mapped_line_type(line, get_mapped_line_end(line, map_end, &next_line))
+                   != MAPPED_DATA_LINE)
+        {
+            line = next_line;
+        }
+
+        while (line < first_line_end)
+        {
+            while ((line < first_line_end) && (FIND_CHAR_YES(" ,\t", *line)))
+            {
+                line++;
+            }
+
+            if (line == first_line_end) break;
+
+            token_len = 0;
+
+            while ((line < first_line_end) && (FIND_CHAR_NO(" ,\t", *line)))
+            {
+                line++;
+                token_len++;
+            }
+
+            if (token_len >= MAX_MAPPED_TOKEN_LEN)
+            {
+                result = NOT_FOUND;
+                break;
+            }
+
+            num_cols++;
+        }
+
+        if (num_cols == 0) result = NOT_FOUND;
+    }
+
+    if (result == NO_ERROR)
+    {
+        row_starts = N_TYPE_MALLOC(const char*, num_rows);
+        row_needs_scan = N_TYPE_MALLOC(char, num_rows);
+        line_buff = N_TYPE_MALLOC(char, max_line_len + ROOM_FOR_NULL);
+
+        if ((row_starts == NULL) || (row_needs_scan == NULL) || (line_buff == NULL))
+        {
+            result = ERROR;
+        }
+    }
+
+    if (result == NO_ERROR)
+    {
+        /*
+        // Because this routine is interuptable, we have to initialize it,
+        // otherwise on interuption the initializatio checker will kick in.
+        */
+#ifdef TRACK_MEMORY_ALLOCATION
+        result = get_zero_matrix(result_mpp, num_rows, num_cols);
+#else
+        result = get_target_matrix(result_mpp, num_rows, num_cols);
+#endif
+    }
+
+    if (result == NO_ERROR)
+    {
+        line = map + start_pos;
+        i = 0;
+
+        while (i < num_rows)
+        {
+            line_end = get_mapped_line_end(line, map_end, &next_line);
+
+            if (get_mapped_line_type(line, line_end) == MAPPED_DATA_LINE)
+            {
+                row_starts[ i ] = line;
+                row_needs_scan[ i ] = FALSE;
+                i++;
+            }
+
+            line = next_line;
+        }
+
+        num_threads = get_matrix_read_num_threads();
+        num_threads = MIN_OF(num_threads,
+                             1 + ((long)num_rows * num_cols) / MIN_ELEMENTS_PER_READ_THREAD);
+        num_threads = MIN_OF(num_threads, num_rows);
+
+        jobs = N_TYPE_MALLOC(Mapped_matrix_job, num_threads);
+
+        if (jobs == NULL)
+        {
+            result = ERROR;
+        }
+        else if (num_threads > 1)
+        {
+            threads = N_TYPE_MALLOC(kjb_pthread_t, num_threads);
+            started = INT_MALLOC(num_threads);
+
+            /* Without these, all the work is done in this thread. */
+            if ((threads == NULL) || (started == NULL))
+            {
+                kjb_clear_error();
+            }
+        }
+    }
+
+    if (result == NO_ERROR)
+    {
+        for (t = 0; t < num_threads; t++)
+        {
+            jobs[ t ].mp = *result_mpp;
+            jobs[ t ].row_starts = row_starts;
+            jobs[ t ].map_end = map_end;
+            jobs[ t ].row_needs_scan = row_needs_scan;
+            jobs[ t ].decimal_point = decimal_point;
+            jobs[ t ].first_row = (int)(((long)num_rows * t) / num_threads);
+            jobs[ t ].last_row = (int)(((long)num_rows * (t + 1)) / num_threads);
+        }
+
+        for (t = 1; t < num_threads; t++)
+        {
+            if ((threads != NULL) && (started != NULL))
+            {
+                started[ t ] = kjb_pthread_create(&threads[ t ], NULL,
+                                                  mapped_matrix_job_main,
+                                                  &jobs[ t ]) != ERROR;
+            }
+        }
+
+        mapped_matrix_job_main(&jobs[ 0 ]);
+
+        for (t = 1; t < num_threads; t++)
+        {
+            if ((threads != NULL) && (started != NULL) && (started[ t ]))
+            {
+                kjb_pthread_join(threads[ t ], NULL);
+            }
+            else
+            {
+                mapped_matrix_job_main(&jobs[ t ]);
+            }
+        }
+
+        if (io_atn_flag)
+        {
+            halt_all_output = FALSE;
+            set_error("Processing interrupted.");
+            result = ERROR;
+        }
+    }
+
+    /* Rows that are not plain numbers are read as usual, in order. */
+    for (i = 0; (result == NO_ERROR) && (i < num_rows); i++)
+    {
+        if (row_needs_scan[ i ])
+        {
+            line_end = get_mapped_line_end(row_starts[ i ], map_end, &next_line);
+            kjb_memcpy(line_buff, row_starts[ i ],
+                       (size_t)(line_end - row_starts[ i ]));
+            line_buff[ line_end - row_starts[ i ] ] = '\0';
+
+            result = read_formatted_matrix_row(*result_mpp, i, line_buff, fp);
+        }
+    }
+
+    if (result == NO_ERROR)
+    {
+        /* Position fp after the soft EOF, as reading line by line does. */
+        result = kjb_fseek(fp, (long)(data_end - map), SEEK_SET);
+    }
+
+    kjb_free(started);
+    kjb_free(threads);
+    kjb_free(jobs);
+    kjb_free(line_buff);
+    kjb_free(row_needs_scan);
+    kjb_free(row_starts);
+
+    munmap(map, map_size);
+
+    return result;
+}
+
+/*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\   */
+
+/*
+ * Returns the end of the line starting at line, without the line feed, and
+ * without a carriage return before it (as fget_line()). The start of the next
+ * line is put into *next_line_ptr.
+*/
+static const char* get_mapped_line_end
+(
+    const char*  line,
+    const char*  map_end,
+    const char** next_line_ptr
+)
+{
+    const char* line_end;
+
+
+    line_end = (const char*)memchr(line, '\n', (size_t)(map_end - line));
+
+    if (line_end == NULL)
+    {
+        line_end = map_end;
+        *next_line_ptr = map_end;
+    }
+    else
+    {
+        *next_line_ptr = line_end + 1;
+    }
+
+    if ((line_end > line) && (*(line_end - 1) == '\r'))
+    {
+        line_end--;
+    }
+
+    return line_end;
+}
+
+/*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\   */
+
+/* Classifies a line the way get_real_line() does. */
+static int get_mapped_line_type(const char* line, const char* line_end)
+{
+    IMPORT int kjb_comment_char;
+
+
+    while ((line < line_end) && (IS_WHITE_SPACE(*line)))
+    {
+        line++;
+    }
+
+    if (line == line_end)
+    {
+        return MAPPED_BLANK_LINE;
+    }
+    else if (*line != kjb_comment_char)
+    {
+        return MAPPED_DATA_LINE;
+    }
+
+    line++;
+
+    if ((line == line_end) || (*line != '!'))
+    {
+        return MAPPED_COMMENT_LINE;
+    }
+
+    line++;
+
+    while ((line < line_end) && (IS_WHITE_SPACE(*line)))
+    {
+        line++;
+    }
+
+    while ((line_end > line) && (IS_WHITE_SPACE(*(line_end - 1))))
+    {
+        line_end--;
+    }
+
+    if (    (line_end - line == 3)
+         && ((line[ 0 ] == 'e') || (line[ 0 ] == 'E'))
+         && ((line[ 1 ] == 'o') || (line[ 1 ] == 'O'))
+         && ((line[ 2 ] == 'f') || (line[ 2 ] == 'F'))
+       )
+    {
+        return MAPPED_SOFT_EOF_LINE;
+    }
+
+    return MAPPED_COMMENT_LINE;
+}
+
+/*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\   */
+
+static int get_matrix_read_num_threads(void)
+{
+    long num_processors;
+
+
+    if (fs_matrix_read_num_threads > 0)
+    {
+        return fs_matrix_read_num_threads;
+    }
+
+#if defined(KJB_HAVE_PTHREAD) && defined(_SC_NPROCESSORS_ONLN)
+    num_processors = sysconf(_SC_NPROCESSORS_ONLN);
+#else
+    num_processors = 1;
+#endif
+
+    return (num_processors > 1) ? (int)num_processors : 1;
+}
+
+/*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\   */
+
+/*
+ * Parses the rows [first_row, last_row). This only writes to those rows of the
+ * matrix and of row_needs_scan, and calls nothing that uses the library
+ * statics (errors, allocation), so it can run in any thread.
+*/
+static void* mapped_matrix_job_main(void* arg)
+{
+    IMPORT volatile Bool io_atn_flag;
+    const Mapped_matrix_job* job = (const Mapped_matrix_job*)arg;
+    const char* line_pos;
+    const char* line_end;
+    const char* next_line;
+    const char* token;
+    double*     row_elements;
+    int         num_cols = job->mp->num_cols;
+    int         i, j;
+
+
+    for (i = job->first_row; i < job->last_row; i++)
+    {
+        if (io_atn_flag) break;
+
+        line_pos = job->row_starts[ i ];
+        line_end = get_mapped_line_end(line_pos, job->map_end, &next_line);
+        row_elements = job->mp->elements[ i ];
+
+        for (j = 0; j < num_cols; j++)
+        {
+            while ((line_pos < line_end) && (FIND_CHAR_YES(" ,\t", *line_pos)))
+            {
+                line_pos++;
+            }
+
+            token = line_pos;
+
+            while ((line_pos < line_end) && (FIND_CHAR_NO(" ,\t", *line_pos)))
+            {
+                line_pos++;
+            }
+
+            if (    (line_pos == token)
+                 || (line_pos - token >= MAX_MAPPED_TOKEN_LEN)
+                 || (scan_mapped_double(token, line_pos, job->decimal_point,
+                                        row_elements + j)
+                     == ERROR)
+               )
+            {
+                job->row_needs_scan[ i ] = TRUE;
+                break;
+            }
+        }
+    }
+
+    return NULL;
+}
+
+/*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\   */
+
+/*
+ * Scans a number in the syntax accepted by is_scientific_notation_number(),
+ * without a sign (or exponent) in the wrong place, percentages, or white space.
+ * It does not depend on the locale, and does not set errors, so it is safe in
+ * threads. Anything else returns ERROR and is left to ss1snd().
+ *
+ * Like sscanf(), the result is the double nearest to the decimal number. When
+ * the digits fit in 53 bits and the power of ten is at most 22, both are
+ * exact, so one multiply (or divide) rounds correctly. This covers most of
+ * what fp_write_matrix_full_precision() writes; the rest goes to strtod(),
+ * with the '.' of the token replaced by decimal_point, the decimal point of
+ * the current locale, which strtod() expects. (Switching to the "C" locale
+ * instead would change it for every thread.) If decimal_point is empty, such
+ * numbers return ERROR.
+*/
+static int scan_mapped_double
+(
+    const char* str,
+    const char* str_end,
+    const char* decimal_point,
+    double*     double_ptr
+)
+{
+    static const double powers_of_ten[ ] =
+    {
+        1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,
+        1e8,  1e9,  1e10, 1e11, 1e12, 1e13, 1e14, 1e15,
+        1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+    const char* str_pos           = str;
+    kjb_uint64  mantissa          = 0;
+    int         num_digits        = 0;
+    int         num_sig_digits    = 0;
+    int         exponent          = 0;
+    int         exponent_value    = 0;
+    int         negative          = FALSE;
+    int         negative_exponent = FALSE;
+    double      value;
+    char        num_buff[ MAX_MAPPED_TOKEN_LEN + MAX_DECIMAL_POINT_LEN
+                          + ROOM_FOR_NULL ];
+    char*       num_buff_pos;
+    size_t      decimal_point_len = strlen(decimal_point);
+
+
+    if ((*str_pos == '-') || (*str_pos == '+'))
+    {
+        negative = (*str_pos == '-');
+        str_pos++;
+    }
+
+    while ((str_pos < str_end) && (isdigit((int)(*str_pos))))
+    {
+        if ((mantissa != 0) || (*str_pos != '0'))
+        {
+            /* Digits past 19 might not fit; strtod() will take care of it. */
+            if (num_sig_digits < 19)
+            {
+                mantissa = 10 * mantissa + (kjb_uint64)(*str_pos - '0');
+            }
+            num_sig_digits++;
+        }
+        num_digits++;
+        str_pos++;
+    }
+
+    if ((str_pos < str_end) && (*str_pos == '.'))
+    {
+        str_pos++;
+
+        while ((str_pos < str_end) && (isdigit((int)(*str_pos))))
+        {
+            if ((mantissa != 0) || (*str_pos != '0'))
+            {
+                if (num_sig_digits < 19)
+                {
+                    mantissa = 10 * mantissa + (kjb_uint64)(*str_pos - '0');
+                }
+                num_sig_digits++;
+            }
+            exponent--;
+            num_digits++;
+            str_pos++;
+        }
+    }
+
+    if (num_digits == 0) return ERROR;
+
+    if (    (str_pos < str_end)
+         && (    (*str_pos == 'e') || (*str_pos == 'E')
+              || (*str_pos == 'd') || (*str_pos == 'D'))
+       )
+    {
+        str_pos++;
+
+        if ((str_pos < str_end) && ((*str_pos == '-') || (*str_pos == '+')))
+        {
+            negative_exponent = (*str_pos == '-');
+            str_pos++;
+        }
+
+        if ((str_pos == str_end) || ( ! isdigit((int)(*str_pos))))
+        {
+            return ERROR;
+        }
+
+        while ((str_pos < str_end) && (isdigit((int)(*str_pos))))
+        {
+            if (exponent_value < 100000)
+            {
+                exponent_value = 10 * exponent_value + (*str_pos - '0');
+            }
+            str_pos++;
+        }
+
+        exponent += negative_exponent ? -exponent_value : exponent_value;
+    }
+
+    if (str_pos != str_end) return ERROR;
+
+    if (mantissa == 0)
+    {
+        value = 0.0;
+    }
+    else if (    (num_sig_digits <= 19)
+              && (mantissa <= ((kjb_uint64)1 << 53))
+              && (exponent >= -22)
+              && (exponent <= 22)
+            )
+    {
+        if (exponent < 0)
+        {
+            value = (double)mantissa / powers_of_ten[ -exponent ];
+        }
+        else
+        {
+            value = (double)mantissa * powers_of_ten[ exponent ];
+        }
+    }
+    else
+    {
+        if (decimal_point_len == 0) return ERROR;
+
+        /*
+         * The token is known to be a plain number with at most one '.', so
+         * strtod() takes it all.
+        */
+        num_buff_pos = num_buff;
+
+        for (str_pos = str; str_pos < str_end; str_pos++)
+        {
+            if (*str_pos == '.')
+            {
+                memcpy(num_buff_pos, decimal_point, decimal_point_len);
+                num_buff_pos += decimal_point_len;
+            }
+            else if ((*str_pos == 'd') || (*str_pos == 'D'))
+            {
+                *num_buff_pos++ = 'e';
+            }
+            else
+            {
+                *num_buff_pos++ = *str_pos;
+            }
+        }
+
+        *num_buff_pos = '\0';
+
+        *double_ptr = strtod(num_buff, NULL);
+        return NO_ERROR;
+    }
+
+    *double_ptr = negative ? -value : value;
+
+    return NO_ERROR;
+}
+
+#endif   /* UNIX */
+
+/*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\   */
+
 /* =============================================================================
  *                           read_matrix_by_rows
  *
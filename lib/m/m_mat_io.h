@@ -32,6 +32,8 @@ namespace kjb_c {
 #endif
 
 
+int set_matrix_io_options(const char* option, const char* value);
+
 int read_matrix_from_config_file
 (
     Matrix**    result_mpp,            /* Double pointer to Matrix result.    */
@@ -20,6 +20,7 @@
 
 #include "m/m_gen.h"     /* Only safe as first include in a ".c" file. */
 
+#include "m/m_mat_io.h"
 #include "m/m_set.h"
 
 
@@ -60,6 +61,7 @@ int kjb_m_set(const char* option, const char* value)
     */
     static int (*set_fn[])(const char*, const char*) =
                                     {
+                                        set_matrix_io_options,
                                         NULL
                                     };
 
@@ -0,0 +1,207 @@
+/*
+ * $Id$
+ */
+
+/*
+ * Checks that reading formatted matrices from a memory map, with one thread and
+ * with several, gives exactly what reading them line by line gives, including
+ * soft EOFs, comments, and rows that are not plain numbers. A stream open for
+ * writing is always read line by line. If a locale with a decimal comma is
+ * installed, it also checks that the mapped read does not depend on it.
+ */
+
+#include "m/m_incl.h"
+
+#include <locale.h>
+
+#define NUM_ROWS  1000
+#define NUM_COLS  13
+
+static const char* fs_file_name = "mat_io_test.txt";
+
+static const char* fs_comma_locales[ ] =
+{
+    "de_DE.UTF-8", "de_DE.utf8", "de_DE", "fr_FR.UTF-8", "fr_FR.utf8", "fr_FR",
+    NULL
+};
+
+static int is_same_matrix(const Matrix* mp, const Matrix* other_mp)
+{
+    int i, j;
+
+    if (    (mp->num_rows != other_mp->num_rows)
+         || (mp->num_cols != other_mp->num_cols))
+    {
+        return FALSE;
+    }
+
+    for (i = 0; i < mp->num_rows; i++)
+    {
+        for (j = 0; j < mp->num_cols; j++)
+        {
+            /* Exact, and also tells 0.0 from -0.0. */
+            if (memcmp(&(mp->elements[ i ][ j ]),
+                       &(other_mp->elements[ i ][ j ]), sizeof(double)) != 0)
+            {
+                return FALSE;
+            }
+        }
+    }
+
+    return TRUE;
+}
+
+int main(void)
+{
+    Matrix* mp        = NULL;
+    Matrix* second_mp = NULL;
+    Matrix* read_mp   = NULL;
+    Matrix* line_mp   = NULL;
+    FILE*   fp;
+    int     i, j;
+    int     num_threads;
+    const char* thread_options[ ] = { "1", "4" };
+
+
+    kjb_init();
+
+    EPETE(get_random_matrix(&mp, NUM_ROWS, NUM_COLS));
+
+    for (i = 0; i < NUM_ROWS; i++)
+    {
+        for (j = 0; j < NUM_COLS; j++)
+        {
+            /* Spread the exponents well past what the fast scan covers. */
+            mp->elements[ i ][ j ] = (mp->elements[ i ][ j ] - 0.5)
+                                        * pow(10.0, (double)((i * 7 + j) % 80 - 40));
+        }
+    }
+    mp->elements[ 0 ][ 0 ] = -0.0;
+    mp->elements[ 1 ][ 1 ] = DBL_MAX / 3.0;
+    mp->elements[ 2 ][ 2 ] = DBL_MIN / 8.0;
+    mp->elements[ 3 ][ 3 ] = 9007199254740993.0;
+
+    EPETE(get_target_matrix(&second_mp, 2, 3));
+    second_mp->elements[ 0 ][ 0 ] = DBL_NOT_SET;
+    second_mp->elements[ 0 ][ 1 ] = 0.25;
+    second_mp->elements[ 0 ][ 2 ] = 1.5;
+    second_mp->elements[ 1 ][ 0 ] = -2.0;
+    second_mp->elements[ 1 ][ 1 ] = 3.0;
+    second_mp->elements[ 1 ][ 2 ] = 4.0;
+
+    for (num_threads = 0; num_threads < 2; num_threads++)
+    {
+        EPETE(set_matrix_io_options("matrix-read-threads",
+                                    thread_options[ num_threads ]));
+
+        NPETE(fp = kjb_fopen(fs_file_name, "w"));
+        EPETE(kjb_fprintf(fp, "# A comment before the matrix.\n\n"));
+        EPETE(fp_write_matrix_full_precision(mp, fp));
+        EPETE(kjb_fprintf(fp, "  #!EOF \n"));
+        EPETE(kjb_fprintf(fp, "off, 25%%\t1.5\r\n\n# comment\n-2 3.0 4e0 5\n"));
+        EPETE(kjb_fclose(fp));
+
+        NPETE(fp = kjb_fopen(fs_file_name, "r+"));
+        EPETE(fp_read_formatted_matrix(&line_mp, fp));
+        EPETE(kjb_fclose(fp));
+
+        NPETE(fp = kjb_fopen(fs_file_name, "r"));
+
+        EPETE(fp_read_formatted_matrix(&read_mp, fp));
+        if ( ! is_same_matrix(line_mp, read_mp))
+        {
+            p_stderr("Mapped read differs from line by line read (%s threads).\n",
+                     thread_options[ num_threads ]);
+            return EXIT_BUG;
+        }
+
+        EPETE(fp_read_formatted_matrix(&read_mp, fp));
+        if ( ! is_same_matrix(second_mp, read_mp))
+        {
+            p_stderr("Matrix after soft EOF not read correctly (%s threads).\n",
+                     thread_options[ num_threads ]);
+            return EXIT_BUG;
+        }
+
+        if (fp_read_formatted_matrix(&read_mp, fp) != EOF)
+        {
+            p_stderr("Expecting EOF after the last matrix.\n");
+            return EXIT_BUG;
+        }
+
+        EPETE(kjb_fclose(fp));
+
+        /* Errors are still reported. */
+        NPETE(fp = kjb_fopen(fs_file_name, "w"));
+        for (i = 0; i < 3000; i++)
+        {
+            EPETE(kjb_fprintf(fp, (i == 2500) ? "1 2\n" : "1 2 3\n"));
+        }
+        EPETE(kjb_fclose(fp));
+
+        if (read_matrix(&read_mp, fs_file_name) != ERROR)
+        {
+            p_stderr("Missing data not reported.\n");
+            return EXIT_BUG;
+        }
+
+        NPETE(fp = kjb_fopen(fs_file_name, "w"));
+        EPETE(kjb_fprintf(fp, "1 2 3\n1 2 x\n"));
+        EPETE(kjb_fclose(fp));
+
+        if (read_matrix(&read_mp, fs_file_name) != ERROR)
+        {
+            p_stderr("Bad number not reported.\n");
+            return EXIT_BUG;
+        }
+    }
+
+    /*
+     * Most numbers written at full precision have too many digits for the fast
+     * scan, and go to strtod(), which follows the locale.
+    */
+    NPETE(fp = kjb_fopen(fs_file_name, "w"));
+    EPETE(fp_write_matrix_full_precision(mp, fp));
+    EPETE(kjb_fclose(fp));
+
+    for (i = 0; fs_comma_locales[ i ] != NULL; i++)
+    {
+        if (setlocale(LC_NUMERIC, fs_comma_locales[ i ]) != NULL) break;
+    }
+
+    if (fs_comma_locales[ i ] == NULL)
+    {
+        p_stderr("No locale with a decimal comma; skipping the locale check.\n");
+    }
+
+    for (num_threads = 0; (fs_comma_locales[ i ] != NULL) && (num_threads < 2);
+         num_threads++)
+    {
+        EPETE(set_matrix_io_options("matrix-read-threads",
+                                    thread_options[ num_threads ]));
+
+        NPETE(fp = kjb_fopen(fs_file_name, "r"));
+        EPETE(fp_read_formatted_matrix(&read_mp, fp));
+        EPETE(kjb_fclose(fp));
+
+        if ( ! is_same_matrix(mp, read_mp))
+        {
+            p_stderr("Mapped read in locale %s differs (%s threads).\n",
+                     fs_comma_locales[ i ], thread_options[ num_threads ]);
+            return EXIT_BUG;
+        }
+    }
+
+    setlocale(LC_NUMERIC, "C");
+
+    EPETE(kjb_unlink(fs_file_name));
+
+    free_matrix(line_mp);
+    free_matrix(read_mp);
+    free_matrix(second_mp);
+    free_matrix(mp);
+
+    kjb_cleanup();
+
+    return EXIT_SUCCESS;
+}
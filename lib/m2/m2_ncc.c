@@ -21,6 +21,7 @@
 #include "m/m_incl.h"
 
 #include "i/i_float.h"
+#include "l_mt/l_mt_pthread.h"
 
 #ifdef KJB_HAVE_FFTW
 #    include "fftw3.h"
@@ -39,6 +40,16 @@ extern "C" {
 
 /* -------------------------------------------------------------------------- */
 
+#ifdef KJB_HAVE_FFTW
+/*
+// FFTW planning is not thread-safe (only fftw_execute is), so plans are made
+// and destroyed one thread at a time.
+*/
+static kjb_pthread_mutex_t fs_fftw_plan_mutex = KJB_PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+/* -------------------------------------------------------------------------- */
+
 #ifdef KJB_HAVE_FFTW
 static int padding_matrix_to_fttw_vector
 (
@@ -149,6 +160,7 @@ static int fourier_convolve_mat
     int           index;
     int           mask_row_offset;
     int           mask_col_offset;
+    int           result          = ERROR;
 
     mask_rows = mask_mp->num_rows;
     mask_cols = mask_mp->num_cols;
@@ -169,7 +181,8 @@ static int fourier_convolve_mat
                                       pad_num_cols));
 
     /* the big shebang */
-    fftw_convolve(&inverse_fftw, in_complex, mask_complex, pad_num_rows, pad_num_cols);
+    EGC(fftw_convolve(&inverse_fftw, in_complex, mask_complex, pad_num_rows,
+                      pad_num_cols));
 
     EGC(get_target_matrix(out_mpp, num_rows, num_cols));
     out_mp = *out_mpp;
@@ -198,12 +211,14 @@ static int fourier_convolve_mat
         }
     }
 
+    result = NO_ERROR;
+
 cleanup:
     fftw_free(in_complex);
     fftw_free(mask_complex);
     fftw_free(inverse_fftw);
 
-    return NO_ERROR;
+    return result;
 }
 #endif
 
@@ -325,41 +340,67 @@ static int fftw_convolve(
     fftw_complex* product_fftw    = NULL;
 
     int num = pad_num_rows * pad_num_cols;
-    fftw_plan     p;
+    fftw_plan     mask_plan       = NULL;
+    fftw_plan     in_plan         = NULL;
+    fftw_plan     inverse_plan    = NULL;
+    int           result          = ERROR;
 
-    /* perform fourier transform */
     mask_fftw = (fftw_complex *)fftw_malloc(sizeof(fftw_complex) * num);
-    p = fftw_plan_dft_2d(pad_num_rows, pad_num_cols, mask_complex, mask_fftw,
-                         FFTW_FORWARD, FFTW_ESTIMATE);
-    fftw_execute(p);
-
-    fftw_destroy_plan(p);
-
     in_fftw = (fftw_complex *)fftw_malloc(sizeof(fftw_complex) * num);
+    *out_complex = (fftw_complex *)fftw_malloc(sizeof(fftw_complex) * num);
 
+    EGC(kjb_pthread_mutex_lock(&fs_fftw_plan_mutex));
+    mask_plan = fftw_plan_dft_2d(pad_num_rows, pad_num_cols, mask_complex,
+                                 mask_fftw, FFTW_FORWARD, FFTW_ESTIMATE);
+    in_plan = fftw_plan_dft_2d(pad_num_rows, pad_num_cols, in_complex, in_fftw,
+                               FFTW_FORWARD, FFTW_ESTIMATE);
+    EPE(kjb_pthread_mutex_unlock(&fs_fftw_plan_mutex));
 
-    p = fftw_plan_dft_2d(pad_num_rows, pad_num_cols, in_complex, in_fftw,
-                         FFTW_FORWARD, FFTW_ESTIMATE);
-    fftw_execute(p); /* repeat as needed */
-
-    fftw_destroy_plan(p);
+    /* perform fourier transform */
+    fftw_execute(mask_plan);
+    fftw_execute(in_plan);
 
     /* multiply the fourier-transformed results */
     multiply_fftw(&product_fftw, in_fftw, mask_fftw, pad_num_rows, pad_num_cols);
 
     /* invert the the product obtained above */
-    *out_complex = (fftw_complex *)fftw_malloc(sizeof(fftw_complex) * num);
-    p = fftw_plan_dft_2d(pad_num_rows, pad_num_cols, product_fftw, *out_complex,
-                         FFTW_BACKWARD, FFTW_ESTIMATE);
-    fftw_execute(p); /* repeat as needed */
+    EGC(kjb_pthread_mutex_lock(&fs_fftw_plan_mutex));
+    inverse_plan = fftw_plan_dft_2d(pad_num_rows, pad_num_cols, product_fftw,
+                                    *out_complex, FFTW_BACKWARD, FFTW_ESTIMATE);
+    EPE(kjb_pthread_mutex_unlock(&fs_fftw_plan_mutex));
 
-    fftw_destroy_plan(p);
+    fftw_execute(inverse_plan);
+
+    result = NO_ERROR;
+
+cleanup:
+    /* Plans are only destroyed under the lock; without it they are leaked. */
+    if (mask_plan != NULL || in_plan != NULL || inverse_plan != NULL)
+    {
+        if (kjb_pthread_mutex_lock(&fs_fftw_plan_mutex) == ERROR)
+        {
+            result = ERROR;
+        }
+        else
+        {
+            if (mask_plan != NULL) fftw_destroy_plan(mask_plan);
+            if (in_plan != NULL) fftw_destroy_plan(in_plan);
+            if (inverse_plan != NULL) fftw_destroy_plan(inverse_plan);
+            EPE(kjb_pthread_mutex_unlock(&fs_fftw_plan_mutex));
+        }
+    }
 
     fftw_free(in_fftw);
     fftw_free(mask_fftw);
     fftw_free(product_fftw);
 
-    return NO_ERROR;
+    if (result == ERROR)
+    {
+        fftw_free(*out_complex);
+        *out_complex = NULL;
+    }
+
+    return result;
 }
 #endif
 
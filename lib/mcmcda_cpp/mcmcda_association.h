@@ -7,6 +7,8 @@
 #include <l_cpp/l_functors.h>
 #include <m_cpp/m_vector.h>
 #include <set>
+#include <vector>
+#include <utility>
 #include <algorithm>
 #include <iterator>
 #include <functional>
@@ -17,6 +19,7 @@
 #include <boost/lexical_cast.hpp>
 #include <boost/lambda/lambda.hpp>
 #include <boost/algorithm/string.hpp>
+#include <boost/shared_ptr.hpp>
 
 namespace kjb {
 namespace mcmcda {
@@ -59,6 +62,14 @@ struct Compare_tracks
  * This class represents an association, in the MCMCDA sense. Specifically, it
  * is simply a set of tracks and a pointer to a tracking data set.
  *
+ * The association also keeps an index of which data points are used by its
+ * tracks, which is updated as tracks are inserted and erased. This makes
+ * the available data (and the noise likelihood) cheap to get during
+ * sampling. Inserting or erasing a track re-indexes the data if they have
+ * changed, but queries do not look at the data, so if the data change in
+ * place after the tracks are inserted, call set_data() again to re-index
+ * them.
+ *
  * @see     Tracking_data
  * @see     Track
  */
@@ -72,8 +83,24 @@ private:
     typedef std::set<Track, Compare_tracks<Track> > Parent;
     typedef std::set<const Element*> Elementp_set;
 
+    /**
+     * @brief   The points of a data set, stored contiguously frame by frame
+     *          (in data order), together with a lookup by address. It
+     *          depends only on the data, so copies of an association share it.
+     */
+    struct Data_index
+    {
+        const Data<Element>* data;
+        std::vector<size_t> offsets;
+        std::vector<const Element*> points;
+        std::vector<std::pair<const Element*, size_t> > positions;
+    };
+
 private:
     const Data<Element>* Y;
+    boost::shared_ptr<const Data_index> index_;
+    std::vector<size_t> uses_;
+    size_t num_used_;
 
 public:
     typedef std::vector<Elementp_set> Available_data;
@@ -82,14 +109,16 @@ public:
      * @brief   Default constructor -- meaningless association. Use
      *          with care!!
      */
-    Association() : Y(0)
+    Association() : Y(0), num_used_(0)
     {}
 
     /**
      * @brief   Constructor
      */
-    Association(const Data<Element>& data) : Y(&data)
-    {}
+    Association(const Data<Element>& data) : Y(&data), num_used_(0)
+    {
+        rebuild_index();
+    }
 
     /**
      * @brief   Constructor from sequence and data
@@ -104,8 +133,10 @@ public:
         Iterator first,
         Iterator last
     ) :
-        Parent(first, last), Y(&data)
-    {}
+        Parent(first, last), Y(&data), num_used_(0)
+    {
+        rebuild_index();
+    }
 
     // pass-throughs
     using Parent::empty;
@@ -114,24 +145,164 @@ public:
     using Parent::rbegin;
     using Parent::rend;
     using Parent::size;
-    using Parent::insert;
-    using Parent::clear;
-    using Parent::erase;
     using Parent::find;
     typedef typename Parent::iterator iterator;
     typedef typename Parent::const_iterator const_iterator;
     typedef typename Parent::const_reference const_reference;
 
+    /** @brief   Inserts a track, updating the used data. */
+    std::pair<iterator, bool> insert(const Track& track)
+    {
+        std::pair<iterator, bool> res = Parent::insert(track);
+        if(res.second)
+        {
+            update_index(*res.first, true);
+        }
+
+        return res;
+    }
+
+    /** @brief   Inserts a track using a hint, updating the used data. */
+    iterator insert(iterator hint, const Track& track)
+    {
+        size_t sz = size();
+        iterator track_p = Parent::insert(hint, track);
+        if(size() != sz)
+        {
+            update_index(*track_p, true);
+        }
+
+        return track_p;
+    }
+
+    /** @brief   Inserts a sequence of tracks, updating the used data. */
+    template<class Iterator>
+    void insert(Iterator first, Iterator last)
+    {
+        for(; first != last; first++)
+        {
+            insert(*first);
+        }
+    }
+
+    /** @brief   Erases a track, updating the used data. */
+    void erase(iterator track_p)
+    {
+        if(index_is_current())
+        {
+            update_index(*track_p, false);
+            Parent::erase(track_p);
+        }
+        else
+        {
+            Parent::erase(track_p);
+            rebuild_index();
+        }
+    }
+
+    /** @brief   Erases a track by value, updating the used data. */
+    size_t erase(const Track& track)
+    {
+        iterator track_p = find(track);
+        if(track_p == end())
+        {
+            return 0;
+        }
+
+        erase(track_p);
+        return 1;
+    }
+
+    /** @brief   Erases a sequence of tracks, updating the used data. */
+    void erase(iterator first, iterator last)
+    {
+        while(first != last)
+        {
+            erase(first++);
+        }
+    }
+
+    /** @brief   Removes all tracks. */
+    void clear()
+    {
+        Parent::clear();
+        rebuild_index();
+    }
+
     /** @brief   Returns data set const-ref. */
     const Data<Element>& get_data() const
     {
         return *Y;
     }
 
-    /** @brief   Set data. */
+    /**
+     * @brief   Set data. This also re-indexes the data, so it should be
+     *          called again if the data change.
+     */
     void set_data(const Data<Element>& data)
     {
         Y = &data;
+        index_.reset();
+        rebuild_index();
+    }
+
+    /**
+     * @brief   Counts the points (at all times) that do not belong to any
+     *          track. This is much faster than getting the available data
+     *          and counting them.
+     */
+    size_t count_available_data() const
+    {
+        if(has_index())
+        {
+            return index_->points.size() - num_used_;
+        }
+
+        size_t n = 0;
+        for(size_t t = 1; t <= Y->size(); t++)
+        {
+            n += get_dead_points_at_time(t).size();
+        }
+
+        return n;
+    }
+
+    /**
+     * @brief   Gets the points at time t that do not belong to any track,
+     *          in data order. Unlike get_dead_points_at_time(), this does
+     *          not build a set, and reuses the storage of avail.
+     */
+    void get_available_data_at_time
+    (
+        int t,
+        std::vector<const Element*>& avail
+    ) const
+    {
+        avail.clear();
+        if(has_index())
+        {
+            for(size_t i = index_->offsets[t - 1]; i < index_->offsets[t]; i++)
+            {
+                if(uses_[i] == 0)
+                {
+                    avail.push_back(index_->points[i]);
+                }
+            }
+
+            return;
+        }
+
+        typedef typename std::set<Element>::const_iterator E_cit;
+        Elementp_set dead_data_t = get_dead_points_at_time(t);
+        for(E_cit elem_p = (*Y)[t - 1].begin();
+                  elem_p != (*Y)[t - 1].end();
+                  elem_p++)
+        {
+            if(dead_data_t.count(&(*elem_p)) != 0)
+            {
+                avail.push_back(&(*elem_p));
+            }
+        }
     }
 
     /**
@@ -172,6 +343,19 @@ public:
         using namespace std;
 
         Elementp_set dead_data_t;
+        if(has_index())
+        {
+            for(size_t i = index_->offsets[t - 1]; i < index_->offsets[t]; i++)
+            {
+                if(uses_[i] == 0)
+                {
+                    dead_data_t.insert(dead_data_t.end(), index_->points[i]);
+                }
+            }
+
+            return dead_data_t;
+        }
+
         Elementp_set live_data_t = get_live_points_at_time(t);
         Elementp_set data_t_addrs;
         transform((*Y)[t - 1].begin(), (*Y)[t - 1].end(),
@@ -356,10 +540,45 @@ public:
         using std::swap;
 
         swap(a1.Y, a2.Y);
+        swap(a1.index_, a2.index_);
+        swap(a1.uses_, a2.uses_);
+        swap(a1.num_used_, a2.num_used_);
         std::set<Track, Compare_tracks<Track> >& s1 = a1;
         std::set<Track, Compare_tracks<Track> >& s2 = a2;
         swap(s1, s2);
     }
+
+private:
+    /**
+     * @brief   True if there is an index for the current data set. This
+     *          takes constant time, and does not check whether the data
+     *          have changed in place since the index was built.
+     */
+    bool has_index() const
+    {
+        return Y != 0 && index_ && index_->data == Y
+                && index_->offsets.size() == Y->size() + 1;
+    }
+
+    /**
+     * @brief   True if the data index is that of the current data, i.e., the
+     *          data have not changed since it was built. This takes time
+     *          linear in the number of frames, so it is only used when the
+     *          tracks change.
+     */
+    bool index_is_current() const;
+
+    /** @brief   Indexes the data and counts the uses of its points. */
+    void rebuild_index();
+
+    /**
+     * @brief   Adds (or removes) the uses of the points of a track, or
+     *          rebuilds the index if the data have changed.
+     */
+    void update_index(const Track& track, bool add);
+
+    /** @brief   Adds (or removes) the uses of the points of a track. */
+    void count_uses(const Track& track, bool add);
 };
 
 /*============================================================================*
@@ -406,6 +625,120 @@ int Association<Track>::count_live_points_at_time(int t) const
 
 /* \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ */
 
+template<class Track>
+bool Association<Track>::index_is_current() const
+{
+    if(!has_index()) return false;
+
+    const size_t T = Y->size();
+    for(size_t t = 0; t < T; t++)
+    {
+        const std::set<Element>& data_t = (*Y)[t];
+        size_t i = index_->offsets[t];
+        if(index_->offsets[t + 1] - i != data_t.size()) return false;
+        if(!data_t.empty() && index_->points[i] != &(*data_t.begin()))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/* \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ */
+
+template<class Track>
+void Association<Track>::rebuild_index()
+{
+    uses_.clear();
+    num_used_ = 0;
+
+    if(Y == 0)
+    {
+        index_.reset();
+        return;
+    }
+
+    if(!index_is_current())
+    {
+        boost::shared_ptr<Data_index> index_p(new Data_index);
+        index_p->data = Y;
+        index_p->offsets.push_back(0);
+        for(size_t t = 0; t < Y->size(); t++)
+        {
+            typedef typename std::set<Element>::const_iterator E_cit;
+            for(E_cit elem_p = (*Y)[t].begin();
+                      elem_p != (*Y)[t].end();
+                      elem_p++)
+            {
+                size_t i = index_p->points.size();
+                index_p->points.push_back(&(*elem_p));
+                index_p->positions.push_back(std::make_pair(&(*elem_p), i));
+            }
+
+            index_p->offsets.push_back(index_p->points.size());
+        }
+
+        std::sort(index_p->positions.begin(), index_p->positions.end());
+        index_ = index_p;
+    }
+
+    uses_.resize(index_->points.size(), 0);
+    for(const_iterator track_p = begin(); track_p != end(); track_p++)
+    {
+        count_uses(*track_p, true);
+    }
+}
+
+/* \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ */
+
+template<class Track>
+void Association<Track>::update_index(const Track& track, bool add)
+{
+    if(!index_is_current())
+    {
+        rebuild_index();
+        return;
+    }
+
+    count_uses(track, add);
+}
+
+/* \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ */
+
+template<class Track>
+void Association<Track>::count_uses(const Track& track, bool add)
+{
+    typedef std::pair<const Element*, size_t> Position;
+    typedef typename std::vector<Position>::const_iterator Pos_cit;
+    const std::vector<Position>& positions = index_->positions;
+
+    for(typename Track::const_iterator pair_p = track.begin();
+                                       pair_p != track.end();
+                                       pair_p++)
+    {
+        // points that are not in the data are not indexed
+        Pos_cit pos_p = std::lower_bound(positions.begin(), positions.end(),
+                                         Position(pair_p->second, 0));
+        if(pos_p == positions.end() || pos_p->first != pair_p->second)
+        {
+            continue;
+        }
+
+        size_t& uses = uses_[pos_p->second];
+        if(add)
+        {
+            if(uses++ == 0) num_used_++;
+        }
+        else if(uses != 0)
+        {
+            if(--uses == 0) num_used_--;
+        }
+    }
+}
+
+/* \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ */
+
 template<class Track>
 void Association<Track>::read(const std::string& filename, const Track& def)
 {
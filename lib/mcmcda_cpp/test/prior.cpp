@@ -73,6 +73,28 @@ int main(int argc, char** argv)
     // test basic stuff
     TEST_TRUE(w.get_available_data().size() == fa.size());
 
+    // the used data are tracked as tracks come and go
+    size_t num_fa = 0;
+    for(size_t t = 0; t < T; t++)
+    {
+        TEST_TRUE(w.get_dead_points_at_time(t + 1).size() == fa[t]);
+        num_fa += fa[t];
+    }
+    TEST_TRUE(w.count_available_data() == num_fa);
+
+    Association<Track> w_copy = w;
+    size_t num_avail = num_fa;
+    while(!w_copy.empty())
+    {
+        num_avail += w_copy.begin()->size();
+        w_copy.erase(w_copy.begin());
+        TEST_TRUE(w_copy.count_available_data() == num_avail);
+    }
+
+    w_copy.insert(tracks.begin(), tracks.end());
+    TEST_TRUE(w_copy.count_available_data() == num_fa);
+    TEST_TRUE(w.count_available_data() == num_fa);
+
     double pr = prior(w);
     TEST_FALSE(::isinf(pr));
     TEST_FALSE(::isnan(pr));
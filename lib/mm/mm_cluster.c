@@ -104,6 +104,7 @@
 #include "mm/mm_cluster.h"
 #include "mm/mm_cluster_lib.h"
 #include "mm/mm_compute_con_prob.h"
+#include "l_mt/l_mt_pthread.h"
 
 /*
 #define XXX_SUPPORT_TRIMMING    (buggy?)
@@ -223,17 +224,21 @@ Training_options;
 
 /* -------------------------------------------------------------------------- */
 
-static int* fs_vector_feature_counts_ptr = NULL;
-static int  fs_vector_feature_counts_set = FALSE;
-
+/*
+ * The options of set_multi_modal_cluster_options(). The process wide ones are
+ * in fs_options, but each call to do_multi_modal_clustering_with_options() or
+ * get_cluster_membership_with_options() can have its own.
+*/
+struct Multi_modal_cluster_options
+{
 #ifdef XXX_SUPPORT_LIMITING_NUM_FEATURES
-static int    fs_max_num_con_features  = NOT_SET;
+    int                   max_num_con_features;
 #endif
 
-static int    fs_min_num_levels    = NOT_SET;
+    int                   min_num_levels;
 #ifdef XXX_SUPPORT_TRIMMING
-static double fs_min_trim_fraction = DBL_NOT_SET;
-static double fs_max_trim_fraction = DBL_NOT_SET;
+    double                min_trim_fraction;
+    double                max_trim_fraction;
 #endif
 
 #ifdef SUPPORT_IGNORE_DIS_PROB
@@ -244,152 +249,467 @@ static double fs_max_trim_fraction = DBL_NOT_SET;
 // emmitted in this way. I never figured out a good way to do this, an thus
 // this option remains disabled.
 */
-static double fs_ignore_dis_prob_fraction = 0.0;
+    double                ignore_dis_prob_fraction;
 #endif
 
-static int fs_multiply_vertical_prior_weights = FALSE;   /* OBSOLETE ?? */
-static int fs_multiply_vertical_depend_weights = FALSE;   /* OBSOLETE ?? */
+    int                   multiply_vertical_prior_weights; /* OBSOLETE ?? */
+    int                   multiply_vertical_depend_weights; /* OBSOLETE ?? */
 
-static int fs_initialize_method = 2;
-static int fs_sample_hack = 1;
+    int                   initialize_method;
+    int                   sample_hack;
 
 #ifdef XXX_SUPPORT_TRIMMING
-static int fs_trim_hack = 2;
+    int                   trim_hack;
 #endif
 
-static int fs_discrete_tie_count = 1;
-static int fs_tie_var = FALSE;
-static int fs_weight_data = FALSE;
-static int fs_add_discrete_nulls = FALSE;
-static int fs_save_model_data = FALSE;
+    int                   discrete_tie_count;
+    int                   tie_var;
+    int                   weight_data;
+    int                   add_discrete_nulls;
+    int                   save_model_data;
 
-static int fs_phase_one_model_correspondence = 0;
-static int fs_phase_two_model_correspondence = 0;
-static int fs_phase_one_last_sample = NOT_SET;
-static int fs_phase_two_last_sample = NOT_SET;
-static int fs_phase_one_sample_matches = FALSE;
-static int fs_phase_two_sample_matches = FALSE;
-static int fs_phase_one_share_matches = FALSE;
-static int fs_phase_two_share_matches = FALSE;
+    int                   phase_one_model_correspondence;
+    int                   phase_two_model_correspondence;
+    int                   phase_one_last_sample;
+    int                   phase_two_last_sample;
+    int                   phase_one_sample_matches;
+    int                   phase_two_sample_matches;
+    int                   phase_one_share_matches;
+    int                   phase_two_share_matches;
 
-static int fs_phase_one_num_iterations    = 0;
-static int fs_phase_two_num_iterations    = 1;
-static int fs_phase_one_uniform_vertical_dist = FALSE;
-static int fs_phase_two_uniform_vertical_dist = FALSE;
-static int fs_phase_one_cluster_dependent_vertical_dist = FALSE;
-static int fs_phase_two_cluster_dependent_vertical_dist = FALSE;
+    int                   phase_one_num_iterations;
+    int                   phase_two_num_iterations;
+    int                   phase_one_uniform_vertical_dist;
+    int                   phase_two_uniform_vertical_dist;
+    int                   phase_one_cluster_dependent_vertical_dist;
+    int                   phase_two_cluster_dependent_vertical_dist;
 
-static Convergence_criterion fs_phase_one_convergence_criterion = MAX_HELD_OUT_LL;
+    Convergence_criterion phase_one_convergence_criterion;
 
-static int fs_phase_one_held_out_data_is_fixed = FALSE;
+    int                   phase_one_held_out_data_is_fixed;
 
-static Convergence_criterion fs_phase_two_convergence_criterion = MAX_DATA_LL;
+    Convergence_criterion phase_two_convergence_criterion;
 
-static int    fs_double_depend            = FALSE;
-static int    fs_pair_depend              = FALSE;
-static int    fs_max_depend               = FALSE;
+    int                   double_depend;
+    int                   pair_depend;
+    int                   max_depend;
 
-static int    fs_norm_depend              = TRUE;
-static int    fs_normalize_data           = FALSE;
-static int    fs_norm_con_prob            = TRUE;
+    int                   norm_depend;
+    int                   normalize_data;
+    int                   norm_con_prob;
 #ifdef XXX_SUPPORT_TRIMMING
-static int    fs_trim_mach_two            = TRUE;
+    int                   trim_mach_two;
 #endif
-static int    fs_norm_vec_prob            = TRUE;
-static double fs_var_offset               = 0.0001;
-static double fs_var_offset_2             = 0.0;
-static double fs_max_con_norm_var         = DBL_NOT_SET;
+    int                   norm_vec_prob;
+    double                var_offset;
+    double                var_offset_2;
+    double                max_con_norm_var;
 #ifdef XXX_LIMIT_MIN_CON_PROB
-static double fs_min_con_log_prob_cutoff  = DBL_NOT_SET;
-#endif
-static double fs_data_perturbation        = DBL_NOT_SET;
-static int    fs_num_tries_per_topology   = 1;
-static int    fs_max_num_em_iterations    = 10;
-static int    fs_min_num_em_iterations    = NOT_SET;
-static double fs_iteration_tolerance      = 1.0e-05;
-static double fs_dis_item_prob_threshold  = DBL_NOT_SET;
-static int    fs_num_limited_clusters     = NOT_SET;
+    double                min_con_log_prob_cutoff;
+#endif
+    double                data_perturbation;
+    int                   num_tries_per_topology;
+    int                   max_num_em_iterations;
+    int                   min_num_em_iterations;
+    double                iteration_tolerance;
+    double                dis_item_prob_threshold;
+    int                   num_limited_clusters;
 #ifdef DEF_OUT
-static int    fs_num_passes               = 1;
-static int    fs_max_num_pass_one_points  = 2000;
-static double fs_pass_one_fraction        = 0.1;
-#endif
-static double fs_phase_one_train_fraction    = 0.7;
-static double fs_phase_one_held_out_fraction = 0.3;
-static double fs_dis_prob_boost_factor    = 1.0;
-static double fs_con_prob_boost_factor    = 1.0;
-static double fs_vec_prob_boost_factor    = 1.0;
-static double fs_his_prob_boost_factor    = 1.0;
-static int    fs_norm_items               = TRUE;
-static int    fs_norm_continuous_features = FALSE;
-static int    fs_do_map                   = FALSE;
-static double fs_map_alpha                = 1.0;
-static double fs_map_beta_minus_one       = 1.0;
-static double fs_map_kappa                = 0.0;
-static double fs_map_delta                = 1.0;
-static double fs_map_r_minus_n_g          = 0.0;
+    int                   num_passes;
+    int                   max_num_pass_one_points;
+    double                pass_one_fraction;
+#endif
+    double                phase_one_train_fraction;
+    double                phase_one_held_out_fraction;
+    double                dis_prob_boost_factor;
+    double                con_prob_boost_factor;
+    double                vec_prob_boost_factor;
+    double                his_prob_boost_factor;
+    int                   norm_items;
+    int                   norm_continuous_features;
+    int                   do_map;
+    double                map_alpha;
+    double                map_beta_minus_one;
+    double                map_kappa;
+    double                map_delta;
+    double                map_r_minus_n_g;
 
 #ifdef I_FORGET_WHAT_THIS_IS_FOR
-static int    fs_compute_uniform_vertical_log_likelihood = FALSE;
+    int                   compute_uniform_vertical_log_likelihood;
 #endif
 
-static double fs_max_ave_limited_cluster_error = 0.000001;
+    double                max_ave_limited_cluster_error;
 
 #ifdef  SUPPORT_ANNEALING
-static int    fs_num_cooling_iterations   = NOT_SET;
-static double fs_min_temperature          = 0.2;
-static double fs_max_temperature          = 1.0;
-static int fs_watch_temperature = TRUE;
+    int                   num_cooling_iterations;
+    double                min_temperature;
+    double                max_temperature;
+    int                   watch_temperature;
+#endif
+
+    int                   watch;
+    int                   watch_2;
+    int                   watch_max_con_prob;
+#ifdef VEC_AND_HIS
+    int                   watch_max_vec_prob;
+#endif
+    int                   watch_max_parm_diff;
+
+/* Can't support these for a bit. */
+    int                   watch_max_cluster_given_point_diff;
+    int                   watch_rms_cluster_given_point_diff;
+
+    int                   watch_ave_limited_error;
+    int                   watch_max_limited_error;
+
+    int                   use_level_prior;
+    int                   use_blob_prior;
+
+    int                   weight_con_items;
+
+    int                   min_it_for_con_items;
+    int                   min_it_for_dis_items;
+    int                   sample_count;
+
+    int                   max_num_level_weights;
+
+    double                limit_gaussian_deviation;
+
+    Int_vector*           sub_group_vp;
+    int                   use_specified_clusters;
+    int                   one_to_one_match;
+    int                   use_contiguous_assignment;
+    int                   duplicate_words_for_matching;
+
+    int                   emulate_uniform_discrete_prob;
+
+    int                   num_threads;
+};
+
+/*
+ * What used to be kept in statics between calls. Each call to
+ * do_multi_modal_clustering_with_options() or
+ * get_cluster_membership_with_options() has its own, so that several can run
+ * at once.
+*/
+typedef struct Cluster_cache
+{
+    int*            vector_feature_counts_ptr;
+    int             vector_feature_counts_set;
+    double***       level_indicators_ppp;
+    int             level_indicators_num_levels;
+    int             level_indicators_num_clusters;
+    int             level_indicators_num_items;
+    V_v_v*          con_prob_cache_vvvp;
+    Int_vector*     level_counts_vp;
+    int             con_prob_cache_max_num_con_items;
+    int             con_prob_cache_first_level;
+    int             con_prob_cache_last_level_num;
+    int             con_prob_cache_num_levels;
+    Indexed_vector* cluster_index_vp;
+}
+Cluster_cache;
+
+/* Don't start a cluster membership thread for fewer points than this. */
+#define MIN_POINTS_PER_MEMBERSHIP_THREAD  100
+
+/*
+ * What get_cluster_membership_2() shares with the jobs that find the cluster
+ * membership of its points.
+*/
+typedef struct Cluster_membership_input
+{
+    const Topology*                    topology_ptr;
+    const Vector*                      a_vp;
+    const Matrix*                      V_mp;
+    const Matrix_vector*               input_P_l_p_c_mvp;
+    const Matrix*                      input_P_l_p_mp;
+    const Matrix_vector*               P_i_n_mvp;
+    const Matrix_vector*               mean_mvp;
+    const Matrix_vector*               var_mvp;
+    const Vector_vector*               con_log_sqrt_det_vvp;
+    double                             con_log_norm;
+    const Int_vector*                  con_feature_enable_vp;
+    const Int_vector*                  con_feature_group_vp;
+    double                             min_con_log_prob;
+    double                             max_con_norm_var;
+    double                             con_score_cutoff;
+    int                                weight_con_items;
+    int                                norm_depend;
+    int                                model_correspondence;
+    const Cluster_data*                data_ptr;
+    const Int_vector*                  points_to_use_vp;
+    const Vector*                      dis_factor_vp;
+    const Vector*                      con_factor_vp;
+    int                                norm_continuous_features;
+    const Multi_modal_cluster_options* cluster_options_ptr;
+    const int*                         vector_feature_counts_ptr;
+    int                                num_sparse_levels;
+    int                                first_sparse_level;
+    const Int_matrix*                  level_index_mp;
+    const Vector*                      con_score_vp;
+    const Matrix*                      lock_P_c_p_mp;
+    Matrix*                            P_c_p_mp;
+    const Matrix_vector*               P_l_p_c_mvp;
+    Matrix*                            P_l_p_mp;
+    Vector*                            fit_vp;
+    const Int_vector_vector*           missing_index_vvp;
+}
+Cluster_membership_input;
+
+/* The points [first_point, last_point) and the work space to do them with. */
+typedef struct Cluster_membership_job
+{
+    const Cluster_membership_input* input_ptr;
+    Cluster_cache*                  cache_ptr;
+    Cluster_cache                   cache;
+    Vector*                         nu_vp;
+    Vector*                         log_nu_vp;
+    Vector*                         log_prob_vp;
+    Vector*                         nu_for_dependent_model_vp;
+    Vector*                         level_weight_vp;
+    Indexed_vector*                 sorted_l_p_vp;
+    int                             first_point;
+    int                             last_point;
+    int                             iteration;
+    int                             report_progress;
+    int                             result;
+    double                          max_con_log_prob;
+}
+Cluster_membership_job;
+
+/*
+ * Training points are summed in slices of at least this many, and there are
+ * never more slices than MAX_NUM_TRAINING_SLICES. The slices depend only on
+ * the number of points, so that the sums, which are added up slice by slice,
+ * are the same for any number of threads.
+*/
+#define MIN_POINTS_PER_TRAINING_SLICE  50
+#define MAX_NUM_TRAINING_SLICES        64
+
+/* The sufficient statistics of the M-step, summed over some of the points. */
+typedef struct Cluster_training_statistics
+{
+    Vector*        a_vp;
+    Matrix*        V_mp;
+    Matrix*        dis_V_mp;
+    Matrix*        con_V_mp;
+    Vector_vector* dis_P_sum_vvp;
+    Matrix_vector* P_i_n_mvp;
+    Vector_vector* con_P_sum_vvp;
+    Matrix_vector* mean_mvp;
+    Matrix_vector* var_mvp;
+    V_v_v*         missing_con_P_sum_vvvp;
+    double         log_likelihood;
+    double         ll_con_correction_norm_sum;
+    double         max_con_log_prob;
+    int            num_points;
+    int            num_dis_items;
+    int            num_con_items;
+}
+Cluster_training_statistics;
+
+/*
+ * What the training jobs need beyond what the E-step needs. The vertical
+ * weights P_l_p_c_mvp or P_l_p_mp are written for the points of each job.
+*/
+typedef struct Cluster_training_input
+{
+    const Cluster_membership_input* membership_input_ptr;
+    const Vector*                   weight_vp;
+    const Vector*                   dis_item_empirical_vp;
+    int                             multiply_vertical_prior_weights;
+    int                             compute_cluster_dependent_aspects;
+    int                             compute_aspects;
+    Matrix_vector*                  P_l_p_c_mvp;
+    Matrix*                         P_l_p_mp;
+    int                             num_points;
+    int                             num_slices;
+}
+Cluster_training_input;
+
+/* One thread of a training E-step, and the slice it is summing. */
+typedef struct Cluster_training_job
+{
+    const Cluster_training_input* input_ptr;
+    Cluster_membership_job*       membership_job_ptr;
+    Cluster_training_statistics   statistics;
+    int                           slice;
+    int                           result;
+}
+Cluster_training_job;
+
+/* -------------------------------------------------------------------------- */
+
+static Multi_modal_cluster_options fs_options =
+{
+#ifdef XXX_SUPPORT_LIMITING_NUM_FEATURES
+    NOT_SET,           /* max_num_con_features */
+#endif
+
+    NOT_SET,           /* min_num_levels */
+#ifdef XXX_SUPPORT_TRIMMING
+    DBL_NOT_SET,       /* min_trim_fraction */
+    DBL_NOT_SET,       /* max_trim_fraction */
+#endif
+
+#ifdef SUPPORT_IGNORE_DIS_PROB
+    0.0,               /* ignore_dis_prob_fraction */
+#endif
+
+    FALSE,             /* multiply_vertical_prior_weights */
+    FALSE,             /* multiply_vertical_depend_weights */
+
+    2,                 /* initialize_method */
+    1,                 /* sample_hack */
+
+#ifdef XXX_SUPPORT_TRIMMING
+    2,                 /* trim_hack */
+#endif
+
+    1,                 /* discrete_tie_count */
+    FALSE,             /* tie_var */
+    FALSE,             /* weight_data */
+    FALSE,             /* add_discrete_nulls */
+    FALSE,             /* save_model_data */
+
+    0,                 /* phase_one_model_correspondence */
+    0,                 /* phase_two_model_correspondence */
+    NOT_SET,           /* phase_one_last_sample */
+    NOT_SET,           /* phase_two_last_sample */
+    FALSE,             /* phase_one_sample_matches */
+    FALSE,             /* phase_two_sample_matches */
+    FALSE,             /* phase_one_share_matches */
+    FALSE,             /* phase_two_share_matches */
+
+    0,                 /* phase_one_num_iterations */
+    1,                 /* phase_two_num_iterations */
+    FALSE,             /* phase_one_uniform_vertical_dist */
+    FALSE,             /* phase_two_uniform_vertical_dist */
+    FALSE,             /* phase_one_cluster_dependent_vertical_dist */
+    FALSE,             /* phase_two_cluster_dependent_vertical_dist */
+
+    MAX_HELD_OUT_LL,   /* phase_one_convergence_criterion */
+
+    FALSE,             /* phase_one_held_out_data_is_fixed */
+
+    MAX_DATA_LL,       /* phase_two_convergence_criterion */
+
+    FALSE,             /* double_depend */
+    FALSE,             /* pair_depend */
+    FALSE,             /* max_depend */
+
+    TRUE,              /* norm_depend */
+    FALSE,             /* normalize_data */
+    TRUE,              /* norm_con_prob */
+#ifdef XXX_SUPPORT_TRIMMING
+    TRUE,              /* trim_mach_two */
+#endif
+    TRUE,              /* norm_vec_prob */
+    0.0001,            /* var_offset */
+    0.0,               /* var_offset_2 */
+    DBL_NOT_SET,       /* max_con_norm_var */
+#ifdef XXX_LIMIT_MIN_CON_PROB
+    DBL_NOT_SET,       /* min_con_log_prob_cutoff */
+#endif
+    DBL_NOT_SET,       /* data_perturbation */
+    1,                 /* num_tries_per_topology */
+    10,                /* max_num_em_iterations */
+    NOT_SET,           /* min_num_em_iterations */
+    1.0e-05,           /* iteration_tolerance */
+    DBL_NOT_SET,       /* dis_item_prob_threshold */
+    NOT_SET,           /* num_limited_clusters */
+#ifdef DEF_OUT
+    1,                 /* num_passes */
+    2000,              /* max_num_pass_one_points */
+    0.1,               /* pass_one_fraction */
+#endif
+    0.7,               /* phase_one_train_fraction */
+    0.3,               /* phase_one_held_out_fraction */
+    1.0,               /* dis_prob_boost_factor */
+    1.0,               /* con_prob_boost_factor */
+    1.0,               /* vec_prob_boost_factor */
+    1.0,               /* his_prob_boost_factor */
+    TRUE,              /* norm_items */
+    FALSE,             /* norm_continuous_features */
+    FALSE,             /* do_map */
+    1.0,               /* map_alpha */
+    1.0,               /* map_beta_minus_one */
+    0.0,               /* map_kappa */
+    1.0,               /* map_delta */
+    0.0,               /* map_r_minus_n_g */
+
+#ifdef I_FORGET_WHAT_THIS_IS_FOR
+    FALSE,             /* compute_uniform_vertical_log_likelihood */
 #endif
 
+    0.000001,          /* max_ave_limited_cluster_error */
 
-static int fs_watch = TRUE;
+#ifdef  SUPPORT_ANNEALING
+    NOT_SET,           /* num_cooling_iterations */
+    0.2,               /* min_temperature */
+    1.0,               /* max_temperature */
+    TRUE,              /* watch_temperature */
+#endif
+
+    TRUE,              /* watch */
 #ifdef TEST
-static int fs_watch_2 = TRUE;
+    TRUE,              /* watch_2 */
 #else
-static int fs_watch_2 = FALSE;
+    FALSE,             /* watch_2 */
 #endif
-static int fs_watch_max_con_prob = FALSE;
+    FALSE,             /* watch_max_con_prob */
 #ifdef VEC_AND_HIS
-static int fs_watch_max_vec_prob = FALSE;
+    FALSE,             /* watch_max_vec_prob */
 #endif
-static int fs_watch_max_parm_diff = TRUE;
+    TRUE,              /* watch_max_parm_diff */
 
-/* Can't support these for a bit. */
-static int fs_watch_max_cluster_given_point_diff = FALSE;
-static int fs_watch_rms_cluster_given_point_diff = FALSE;
+    FALSE,             /* watch_max_cluster_given_point_diff */
+    FALSE,             /* watch_rms_cluster_given_point_diff */
 
-static int fs_watch_ave_limited_error = TRUE;
-static int fs_watch_max_limited_error = TRUE;
+    TRUE,              /* watch_ave_limited_error */
+    TRUE,              /* watch_max_limited_error */
 
-static int fs_use_level_prior  = TRUE;
-static int fs_use_blob_prior  = TRUE;
+    TRUE,              /* use_level_prior */
+    TRUE,              /* use_blob_prior */
 
-static double***       fs_cached_level_indicators_ppp = NULL;
-static Indexed_vector* fs_cached_cluster_index_vp  = NULL;
-static V_v_v*          fs_con_prob_cache_vvvp         = NULL;
-static Int_vector*     fs_level_counts_vp          = NULL;
+    FALSE,             /* weight_con_items */
 
-static int fs_weight_con_items = FALSE;
+    NOT_SET,           /* min_it_for_con_items */
+    NOT_SET,           /* min_it_for_dis_items */
+    NOT_SET,           /* sample_count */
 
-static int fs_min_it_for_con_items = NOT_SET;
-static int fs_min_it_for_dis_items = NOT_SET;
-static int fs_sample_count = NOT_SET;
+    100,               /* max_num_level_weights */
 
-static int fs_max_num_level_weights = 100;
+    DBL_NOT_SET,       /* limit_gaussian_deviation */
 
-static double fs_limit_gaussian_deviation = DBL_NOT_SET;
+    NULL,              /* sub_group_vp */
+    FALSE,             /* use_specified_clusters */
+    FALSE,             /* one_to_one_match */
+    FALSE,             /* use_contiguous_assignment */
+    FALSE,             /* duplicate_words_for_matching */
 
-static Int_vector* fs_sub_group_vp = NULL;
-static int fs_use_specified_clusters = FALSE;
-static int fs_one_to_one_match = FALSE;
-static int fs_use_contiguous_assignment = FALSE;
-static int fs_duplicate_words_for_matching = FALSE;
+    FALSE              /* emulate_uniform_discrete_prob */,
 
-static int fs_emulate_uniform_discrete_prob = FALSE;
+    0                  /* num_threads */
+};
 
 /* -------------------------------------------------------------------------- */
 
+static int do_multi_modal_clustering_with_cache
+(
+    const Topology_vector*             topology_vp,
+    const Int_vector*                  dis_item_level_vp,
+    const Cluster_data*                data_ptr,
+    const Cluster_data*                held_out_data_ptr,
+    Multi_modal_model*                 model_ptr,
+    int                                (*output_model_fn) (const Multi_modal_model *, int, const char *),
+    const char*                        output_dir,
+    double                             (*dis_item_loss_fn)(int, const double*),
+    const Multi_modal_cluster_options* cluster_options_ptr,
+    Cluster_cache*                     cache_ptr
+);
+
 static int do_multi_modal_clustering_2
 (
     const Topology*     topology_ptr,
@@ -402,7 +722,9 @@ static int do_multi_modal_clustering_2
     const Vector*       norm_mean_vp,
     const Vector*       norm_var_vp,
     double              norm_stdev,
-    double              (*dis_item_loss_fn) (int, const double*)
+    double              (*dis_item_loss_fn) (int, const double*),
+    const Multi_modal_cluster_options* cluster_options_ptr,
+    Cluster_cache*                     cache_ptr
 );
 
 static void set_default_training_options
@@ -424,7 +746,9 @@ static int do_multi_modal_clustering_3
     const Vector*       norm_var_vp,
     double              norm_stdev,
     int                 max_num_em_iterations,
-    double              (*dis_item_loss_fn)(int, const double*)
+    double              (*dis_item_loss_fn)(int, const double*),
+    const Multi_modal_cluster_options* cluster_options_ptr,
+    Cluster_cache*                     cache_ptr
 );
 
 static int do_multi_modal_clustering_4
@@ -441,9 +765,9 @@ static int do_multi_modal_clustering_4
     const Vector*           norm_var_vp,
     double                  norm_stdev,
     int                     max_num_em_iterations,
-    double                  (*dis_item_loss_fn) (int, const double*)
-
-
+    double                  (*dis_item_loss_fn) (int, const double*),
+    const Multi_modal_cluster_options* cluster_options_ptr,
+    Cluster_cache*                     cache_ptr
 );
 
 static int do_fixed_discrete_multi_modal_clustering
@@ -458,7 +782,9 @@ static int do_fixed_discrete_multi_modal_clustering
     const Vector*           norm_mean_vp,
     const Vector*           norm_var_vp,
     double                  norm_stdev,
-    int                     max_num_em_iterations
+    int                     max_num_em_iterations,
+    const Multi_modal_cluster_options* cluster_options_ptr,
+    Cluster_cache*                     cache_ptr
 );
 
 static int get_cluster_membership_2
@@ -498,11 +824,114 @@ static int get_cluster_membership_2
     double*              log_likelihood_ptr,
     const Matrix*        test_P_c_p_mp,
     int                  test_data_flag,
-    Vector_vector*       con_score_vpp
+    Vector_vector*       con_score_vpp,
+    const Multi_modal_cluster_options* cluster_options_ptr,
+    Cluster_cache*                     cache_ptr
+);
+
+static int get_cluster_membership_of_point
+(
+    Cluster_membership_job* job_ptr,
+    int                     point
+);
+
+static void* cluster_membership_job_main(void* arg);
+
+static int run_cluster_membership_jobs
+(
+    Cluster_membership_job* jobs,
+    int                     num_jobs,
+    int                     iteration
+);
+
+static int get_cluster_membership_jobs
+(
+    Cluster_membership_job**        jobs_ptr,
+    int*                            num_jobs_ptr,
+    const Cluster_membership_input* input_ptr,
+    Cluster_cache*                  cache_ptr,
+    int                             num_points,
+    int                             max_num_items
+);
+
+static void free_cluster_membership_jobs
+(
+    Cluster_membership_job* jobs,
+    int                     num_jobs
+);
+
+static int can_use_training_jobs
+(
+    const Training_options*            options_ptr,
+    const Multi_modal_cluster_options* cluster_options_ptr,
+    const Cluster_data*                data_ptr,
+    int                                it,
+    int                                num_clusters,
+    int                                num_clusters_used,
+    int                                num_limited_clusters
+);
+
+static int do_training_e_step_with_jobs
+(
+    Cluster_training_statistics*  total_ptr,
+    const Cluster_training_input* input_ptr,
+    Cluster_cache*                cache_ptr,
+    int                           max_num_items,
+    int                           iteration
+);
+
+static void* cluster_training_job_main(void* arg);
+
+static int add_point_to_training_statistics
+(
+    Cluster_training_statistics*  statistics_ptr,
+    const Cluster_training_input* input_ptr,
+    Cluster_membership_job*       membership_job_ptr,
+    int                           point
+);
+
+static int get_zero_training_statistics
+(
+    Cluster_training_statistics*       target_ptr,
+    const Cluster_training_statistics* source_ptr
+);
+
+static int ow_zero_training_statistics
+(
+    Cluster_training_statistics* statistics_ptr
+);
+
+static int ow_add_training_statistics
+(
+    Cluster_training_statistics*       total_ptr,
+    const Cluster_training_statistics* statistics_ptr
+);
+
+static void free_training_statistics
+(
+    Cluster_training_statistics* statistics_ptr
+);
+
+static void sort_level_weights
+(
+    Indexed_vector* sorted_l_p_vp,
+    const Vector*   level_weight_vp
 );
 
+static int compare_level_weights(const void* first_ptr, const void* second_ptr);
+
+static int get_cluster_num_threads
+(
+    const Multi_modal_cluster_options* cluster_options_ptr
+);
+
+static void init_cluster_cache(Cluster_cache* cache_ptr);
+
+static void free_cluster_cache(Cluster_cache* cache_ptr);
+
 static int initialize_vector_feature_counts
 (
+    Cluster_cache*    cache_ptr,
     const Int_vector* con_feature_enable_vp,
     const Int_vector* con_feature_group_vp
 );
@@ -548,6 +977,7 @@ static int get_his_factors
 
 static int initialize_con_prob_cache
 (
+    Cluster_cache*    cache_ptr,
     int               max_num_con_items,
     int               first_level,
     int               last_level_num,
@@ -557,6 +987,7 @@ static int initialize_con_prob_cache
 
 static int initialize_level_indicators_cache
 (
+    Cluster_cache*    cache_ptr,
     int num_levels,
     int num_clusters,
     int num_items
@@ -564,6 +995,7 @@ static int initialize_level_indicators_cache
 
 static int get_limited_cluster_membership
 (
+    Cluster_cache*    cache_ptr,
     Int_matrix*   cluster_index_mp,
     const Vector* P_c_p_vp,
     int           point,
@@ -590,6 +1022,92 @@ static void sum_collected_scores
 /* -------------------------------------------------------------------------- */
 
 int set_multi_modal_cluster_options(const char* option, const char* value)
+{
+    return set_multi_modal_cluster_options_2(&fs_options, option, value);
+}
+
+/*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\   */
+
+/*
+ * Returns a copy of the process wide options (those set with
+ * set_multi_modal_cluster_options()), which can then be changed with
+ * set_multi_modal_cluster_options_2() without changing them, and passed to
+ * do_multi_modal_clustering_with_options() and
+ * get_cluster_membership_with_options(). Models with different options can
+ * then be fit in one process, including in different threads.
+*/
+Multi_modal_cluster_options* create_multi_modal_cluster_options(void)
+{
+    Multi_modal_cluster_options* options_ptr = NULL;
+
+
+    if (copy_multi_modal_cluster_options(&options_ptr, &fs_options) == ERROR)
+    {
+        return NULL;
+    }
+
+    return options_ptr;
+}
+
+/*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\   */
+
+int copy_multi_modal_cluster_options
+(
+    Multi_modal_cluster_options**      target_options_ptr_ptr,
+    const Multi_modal_cluster_options* options_ptr
+)
+{
+    Multi_modal_cluster_options* target_options_ptr = *target_options_ptr_ptr;
+    Int_vector*                  sub_group_vp;
+
+
+    if (target_options_ptr == options_ptr) return NO_ERROR;
+
+    if (target_options_ptr == NULL)
+    {
+        NRE(target_options_ptr = TYPE_MALLOC(Multi_modal_cluster_options));
+        target_options_ptr->sub_group_vp = NULL;
+        *target_options_ptr_ptr = target_options_ptr;
+    }
+
+    sub_group_vp = target_options_ptr->sub_group_vp;
+
+    *target_options_ptr = *options_ptr;
+
+    target_options_ptr->sub_group_vp = sub_group_vp;
+
+    if (options_ptr->sub_group_vp == NULL)
+    {
+        free_int_vector(target_options_ptr->sub_group_vp);
+        target_options_ptr->sub_group_vp = NULL;
+    }
+    else
+    {
+        ERE(copy_int_vector(&(target_options_ptr->sub_group_vp),
+                            options_ptr->sub_group_vp));
+    }
+
+    return NO_ERROR;
+}
+
+/*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\   */
+
+void free_multi_modal_cluster_options(Multi_modal_cluster_options* options_ptr)
+{
+    if (options_ptr == NULL) return;
+
+    free_int_vector(options_ptr->sub_group_vp);
+    kjb_free(options_ptr);
+}
+
+/*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\   */
+
+int set_multi_modal_cluster_options_2
+(
+    Multi_modal_cluster_options* cluster_options_ptr,
+    const char*                  option,
+    const char*                  value
+)
 {
     char lc_option[ 100 ];
     int    result             = NOT_FOUND;
@@ -637,17 +1155,17 @@ int set_multi_modal_cluster_options(const char* option, const char* value)
         else if (value[ 0 ] == '\0')
         {
             ERE(pso("HC con items %s weighted.\n",
-                    fs_weight_con_items ? "are" : "are not"));
+                    cluster_options_ptr->weight_con_items ? "are" : "are not"));
         }
         else if (value[ 0 ] == '?')
         {
             ERE(pso("hc-weight-con-items = %s\n",
-                    fs_weight_con_items ? "t" : "f"));
+                    cluster_options_ptr->weight_con_items ? "t" : "f"));
         }
         else
         {
             ERE(temp_boolean_value = get_boolean_value(value));
-            fs_weight_con_items = temp_boolean_value;
+            cluster_options_ptr->weight_con_items = temp_boolean_value;
         }
         result = NO_ERROR;
     }
@@ -664,17 +1182,17 @@ int set_multi_modal_cluster_options(const char* option, const char* value)
         else if (value[ 0 ] == '\0')
         {
             ERE(pso("HC vertical depend weights %s multiplied.\n",
-                    fs_multiply_vertical_depend_weights ? "are" : "are not"));
+                    cluster_options_ptr->multiply_vertical_depend_weights ? "are" : "are not"));
         }
         else if (value[ 0 ] == '?')
         {
             ERE(pso("hc-multiply-vertical-depend-weights = %s\n",
-                    fs_multiply_vertical_depend_weights ? "t" : "f"));
+                    cluster_options_ptr->multiply_vertical_depend_weights ? "t" : "f"));
         }
         else
         {
             ERE(temp_boolean_value = get_boolean_value(value));
-            fs_multiply_vertical_depend_weights = temp_boolean_value;
+            cluster_options_ptr->multiply_vertical_depend_weights = temp_boolean_value;
         }
         result = NO_ERROR;
     }
@@ -691,17 +1209,17 @@ int set_multi_modal_cluster_options(const char* option, const char* value)
         else if (value[ 0 ] == '\0')
         {
             ERE(pso("HC vertical prior weights %s multiplied.\n",
-                    fs_multiply_vertical_prior_weights ? "are" : "are not"));
+                    cluster_options_ptr->multiply_vertical_prior_weights ? "are" : "are not"));
         }
         else if (value[ 0 ] == '?')
         {
             ERE(pso("hc-multiply-vertical-prior-weights = %s\n",
-                    fs_multiply_vertical_prior_weights ? "t" : "f"));
+                    cluster_options_ptr->multiply_vertical_prior_weights ? "t" : "f"));
         }
         else
         {
             ERE(temp_boolean_value = get_boolean_value(value));
-            fs_multiply_vertical_prior_weights = temp_boolean_value;
+            cluster_options_ptr->multiply_vertical_prior_weights = temp_boolean_value;
         }
         result = NO_ERROR;
     }
@@ -718,12 +1236,12 @@ int set_multi_modal_cluster_options(const char* option, const char* value)
         else if (value[ 0 ] == '\0')
         {
             ERE(pso("Phase one correspondence learning parameter is %d.\n",
-                    fs_phase_one_model_correspondence));
+                    cluster_options_ptr->phase_one_model_correspondence));
         }
         else if (value[ 0 ] == '?')
         {
             ERE(pso("hc-phase-one-correspondence = %d\n",
-                    fs_phase_one_model_correspondence));
+                    cluster_options_ptr->phase_one_model_correspondence));
         }
         else
         {
@@ -731,7 +1249,7 @@ int set_multi_modal_cluster_options(const char* option, const char* value)
 
             if ((temp_int_value >= 0) && (temp_int_value < 6))
             {
-                fs_phase_one_model_correspondence = temp_int_value;
+                cluster_options_ptr->phase_one_model_correspondence = temp_int_value;
             }
             else
             {
@@ -755,12 +1273,12 @@ int set_multi_modal_cluster_options(const char* option, const char* value)
         else if (value[ 0 ] == '\0')
         {
             ERE(pso("Phase two correspondence learning parameter is %d.\n",
-                    fs_phase_two_model_correspondence));
+                    cluster_options_ptr->phase_two_model_correspondence));
         }
         else if (value[ 0 ] == '?')
         {
             ERE(pso("hc-phase-two-correspondence = %d\n",
-                    fs_phase_two_model_correspondence));
+                    cluster_options_ptr->phase_two_model_correspondence));
         }
         else
         {
@@ -768,7 +1286,7 @@ int set_multi_modal_cluster_options(const char* option, const char* value)
 
             if ((temp_int_value >= 0) && (temp_int_value < 6))
             {
-                fs_phase_two_model_correspondence = temp_int_value;
+                cluster_options_ptr->phase_two_model_correspondence = temp_int_value;
             }
             else
             {
@@ -790,12 +1308,12 @@ int set_multi_modal_cluster_options(const char* option, const char* value)
         }
         else if (value[ 0 ] == '\0')
         {
-            if (fs_phase_one_last_sample > 0)
+            if (cluster_options_ptr->phase_one_last_sample > 0)
             {
                 ERE(pso("HC correspondence learing phase one -- sampling is not used after iteration %d.\n",
-                        fs_phase_one_last_sample));
+                        cluster_options_ptr->phase_one_last_sample));
             }
-            else if (fs_phase_one_last_sample < 0)
+            else if (cluster_options_ptr->phase_one_last_sample < 0)
             {
                 ERE(pso("HC correspondence learing phase one -- sampling is not stopped.\n"));
             }
@@ -803,12 +1321,12 @@ int set_multi_modal_cluster_options(const char* option, const char* value)
         else if (value[ 0 ] == '?')
         {
             ERE(pso("phase-one-last-sample = %d\n",
-                    fs_phase_one_last_sample));
+                    cluster_options_ptr->phase_one_last_sample));
         }
         else
         {
             ERE(ss1i(value, &temp_int_value));
-            fs_phase_one_last_sample = temp_int_value;
+            cluster_options_ptr->phase_one_last_sample = temp_int_value;
         }
         result = NO_ERROR;
     }
@@ -823,12 +1341,12 @@ int set_multi_modal_cluster_options(const char* option, const char* value)
         }
         else if (value[ 0 ] == '\0')
         {
-            if (fs_phase_two_last_sample > 0)
+            if (cluster_options_ptr->phase_two_last_sample > 0)
             {
                 ERE(pso("HC correspondence learing phase two -- sampling is not used after iteration %d.\n",
-                        fs_phase_two_last_sample));
+                        cluster_options_ptr->phase_two_last_sample));
             }
-            else if (fs_phase_two_last_sample < 0)
+            else if (cluster_options_ptr->phase_two_last_sample < 0)
             {
                 ERE(pso("HC correspondence learing phase two -- sampling is not stopped.\n"));
             }
@@ -836,12 +1354,12 @@ int set_multi_modal_cluster_options(const char* option, const char* value)
         else if (value[ 0 ] == '?')
         {
             ERE(pso("phase-two-last-sample = %d\n",
-                    fs_phase_two_last_sample));
+                    cluster_options_ptr->phase_two_last_sample));
         }
         else
         {
             ERE(ss1i(value, &temp_int_value));
-            fs_phase_two_last_sample = temp_int_value;
+            cluster_options_ptr->phase_two_last_sample = temp_int_value;
         }
         result = NO_ERROR;
     }
@@ -860,15 +1378,15 @@ int set_multi_modal_cluster_options(const char* option, const char* value)
         }
         else if (value[ 0 ] == '\0')
         {
-            db_irv(fs_sub_group_vp);
+            db_irv(cluster_options_ptr->sub_group_vp);
         }
         else if (value[ 0 ] == '?')
         {
-            db_irv(fs_sub_group_vp);
+            db_irv(cluster_options_ptr->sub_group_vp);
         }
         else
         {
-            ERE(sget_positive_int_vector(&fs_sub_group_vp, value));
+            ERE(sget_positive_int_vector(&cluster_options_ptr->sub_group_vp, value));
         }
         result = NO_ERROR;
     }
@@ -884,17 +1402,17 @@ int set_multi_modal_cluster_options(const char* option, const char* value)
         else if (value[ 0 ] == '\0')
         {
             ERE(pso("HC specified clusters %s used.\n",
-                    fs_use_specified_clusters ? "are" : "are not"));
+                    cluster_options_ptr->use_specified_clusters ? "are" : "are not"));
         }
         else if (value[ 0 ] == '?')
         {
             ERE(pso("hc-use-specified-clusters = %s\n",
-                    fs_use_specified_clusters ? "t" : "f"));
+                    cluster_options_ptr->use_specified_clusters ? "t" : "f"));
         }
         else
         {
             ERE(temp_boolean_value = get_boolean_value(value));
-            fs_use_specified_clusters = temp_boolean_value;
+            cluster_options_ptr->use_specified_clusters = temp_boolean_value;
         }
         result = NO_ERROR;
     }
@@ -912,17 +1430,17 @@ int set_multi_modal_cluster_options(const char* option, const char* value)
         else if (value[ 0 ] == '\0')
         {
             ERE(pso("HC contiguous assignment %s used.\n",
-                    fs_use_contiguous_assignment ? "are" : "are not"));
+                    cluster_options_ptr->use_contiguous_assignment ? "are" : "are not"));
         }
         else if (value[ 0 ] == '?')
         {
             ERE(pso("hc-use-contiguous-assignment = %s\n",
-                    fs_use_contiguous_assignment ? "t" : "f"));
+                    cluster_options_ptr->use_contiguous_assignment ? "t" : "f"));
         }
         else
         {
             ERE(temp_boolean_value = get_boolean_value(value));
-            fs_use_contiguous_assignment = temp_boolean_value;
+            cluster_options_ptr->use_contiguous_assignment = temp_boolean_value;
         }
         result = NO_ERROR;
     }
@@ -938,17 +1456,17 @@ int set_multi_modal_cluster_options(const char* option, const char* value)
         else if (value[ 0 ] == '\0')
         {
             ERE(pso("HC one to one matched %s used.\n",
-                    fs_one_to_one_match ? "is" : "is not"));
+                    cluster_options_ptr->one_to_one_match ? "is" : "is not"));
         }
         else if (value[ 0 ] == '?')
         {
             ERE(pso("hc-one-to-one-match = %s\n",
-                    fs_one_to_one_match ? "t" : "f"));
+                    cluster_options_ptr->one_to_one_match ? "t" : "f"));
         }
         else
         {
             ERE(temp_boolean_value = get_boolean_value(value));
-            fs_one_to_one_match = temp_boolean_value;
+            cluster_options_ptr->one_to_one_match = temp_boolean_value;
         }
         result = NO_ERROR;
     }
@@ -965,16 +1483,16 @@ int set_multi_modal_cluster_options(const char* option, const char* value)
         else if (value[ 0 ] == '\0')
         {
             ERE(pso("HC initialize method is %d.\n",
-                    fs_initialize_method));
+                    cluster_options_ptr->initialize_method));
         }
         else if (value[ 0 ] == '?')
         {
-            ERE(pso("hc-initialize-method = %d\n", fs_initialize_method));
+            ERE(pso("hc-initialize-method = %d\n", cluster_options_ptr->initialize_method));
         }
         else
         {
             ERE(ss1i(value, &temp_int_value));
-            fs_initialize_method = temp_int_value;
+            cluster_options_ptr->initialize_method = temp_int_value;
         }
         result = NO_ERROR;
     }
@@ -990,11 +1508,11 @@ int set_multi_modal_cluster_options(const char* option, const char* value)
         else if (value[ 0 ] == '\0')
         {
             ERE(pso("HC sample hack is %d.\n",
-                    fs_sample_hack));
+                    cluster_options_ptr->sample_hack));
         }
         else if (value[ 0 ] == '?')
         {
-            ERE(pso("hc-sample-hack = %d\n", fs_sample_hack));
+            ERE(pso("hc-sample-hack = %d\n", cluster_options_ptr->sample_hack));
         }
         else
         {
@@ -1007,7 +1525,7 @@ int set_multi_modal_cluster_options(const char* option, const char* value)
             }
             else
             {
-                fs_sample_hack = temp_int_value;
+                cluster_options_ptr->sample_hack = temp_int_value;
             }
         }
         result = NO_ERROR;
@@ -1025,11 +1543,11 @@ int set_multi_modal_cluster_options(const char* option, const char* value)
         else if (value[ 0 ] == '\0')
         {
             ERE(pso("HC trim hack is %d.\n",
-                    fs_trim_hack));
+                    cluster_options_ptr->trim_hack));
         }
         else if (value[ 0 ] == '?')
         {
-            ERE(pso("hc-trim-hack = %d\n", fs_sample_hack));
+            ERE(pso("hc-trim-hack = %d\n", cluster_options_ptr->sample_hack));
         }
         else
         {
@@ -1042,7 +1560,7 @@ int set_multi_modal_cluster_options(const char* option, const char* value)
             }
             else
             {
-                fs_trim_hack = temp_int_value;
+                cluster_options_ptr->trim_hack = temp_int_value;
             }
         }
         result = NO_ERROR;
@@ -1060,17 +1578,17 @@ int set_multi_modal_cluster_options(const char* option, const char* value)
         else if (value[ 0 ] == '\0')
         {
             ERE(pso("HC correspondence learing phase one -- matches %s sampled.\n",
-                    fs_phase_one_sample_matches ? "are" : "are not"));
+                    cluster_options_ptr->phase_one_sample_matches ? "are" : "are not"));
         }
         else if (value[ 0 ] == '?')
         {
             ERE(pso("hc-phase-one-sample-matches = %s\n",
-                    fs_phase_one_sample_matches ? "t" : "f"));
+                    cluster_options_ptr->phase_one_sample_matches ? "t" : "f"));
         }
         else
         {
             ERE(temp_boolean_value = get_boolean_value(value));
-            fs_phase_one_sample_matches = temp_boolean_value;
+            cluster_options_ptr->phase_one_sample_matches = temp_boolean_value;
         }
         result = NO_ERROR;
     }
@@ -1086,17 +1604,17 @@ int set_multi_modal_cluster_options(const char* option, const char* value)
         else if (value[ 0 ] == '\0')
         {
             ERE(pso("HC correspondence learing phase two -- matches %s sampled.\n",
-                    fs_phase_two_sample_matches ? "are" : "are not"));
+                    cluster_options_ptr->phase_two_sample_matches ? "are" : "are not"));
         }
         else if (value[ 0 ] == '?')
         {
             ERE(pso("hc-phase-two-sample-matches = %s\n",
-                    fs_phase_two_sample_matches ? "t" : "f"));
+                    cluster_options_ptr->phase_two_sample_matches ? "t" : "f"));
         }
         else
         {
             ERE(temp_boolean_value = get_boolean_value(value));
-            fs_phase_two_sample_matches = temp_boolean_value;
+            cluster_options_ptr->phase_two_sample_matches = temp_boolean_value;
         }
         result = NO_ERROR;
     }
@@ -1112,17 +1630,17 @@ int set_multi_modal_cluster_options(const char* option, const char* value)
         else if (value[ 0 ] == '\0')
         {
             ERE(pso("HC correspondence learing phase one -- matches %s shared.\n",
-                    fs_phase_one_share_matches ? "are" : "are not"));
+                    cluster_options_ptr->phase_one_share_matches ? "are" : "are not"));
         }
         else if (value[ 0 ] == '?')
         {
             ERE(pso("hc-phase-one-share-matches = %s\n",
-                    fs_phase_one_share_matches ? "t" : "f"));
+                    cluster_options_ptr->phase_one_share_matches ? "t" : "f"));
         }
         else
         {
             ERE(temp_boolean_value = get_boolean_value(value));
-            fs_phase_one_share_matches = temp_boolean_value;
+            cluster_options_ptr->phase_one_share_matches = temp_boolean_value;
         }
         result = NO_ERROR;
     }
@@ -1138,19 +1656,19 @@ int set_multi_modal_cluster_options(const char* option, const char* value)
         else if (value[ 0 ] == '\0')
         {
             ERE(pso("HC correspondence learing phase two -- matches %s shared.\n",
-                    fs_phase_two_share_matches ? "are" : "are not"));
+                    cluster_options_ptr->phase_two_share_matches ? "are" : "are not"));
         }
         else if (value[ 0 ] == '?')
         {
             ERE(pso("hc-phase-two-share-matches = %s\n",
-                    fs_phase_two_share_matches ? "t" : "f"));
+                    cluster_options_ptr->phase_two_share_matches ? "t" : "f"));
         }
         else
         {
             ERE(temp_boolean_value = get_boolean_value(value));
-            fs_phase_two_share_matches = temp_boolean_value;
+            cluster_options_ptr->phase_two_share_matches = temp_boolean_value;
 
-            if ( ! fs_phase_two_share_matches)
+            if ( ! cluster_options_ptr->phase_two_share_matches)
             {
                 warn_pso("Option to not share matches is dubious!\n");
             }
@@ -1169,17 +1687,17 @@ int set_multi_modal_cluster_options(const char* option, const char* value)
         else if (value[ 0 ] == '\0')
         {
             ERE(pso("HC iterations %s displayed.\n",
-                    fs_watch ? "is" : "is not"));
+                    cluster_options_ptr->watch ? "is" : "is not"));
         }
         else if (value[ 0 ] == '?')
         {
             ERE(pso("hc-watch = %s\n",
-                    fs_watch ? "t" : "f"));
+                    cluster_options_ptr->watch ? "t" : "f"));
         }
         else
         {
             ERE(temp_boolean_value = get_boolean_value(value));
-            fs_watch = temp_boolean_value;
+            cluster_options_ptr->watch = temp_boolean_value;
         }
         result = NO_ERROR;
     }
@@ -1195,17 +1713,17 @@ int set_multi_modal_cluster_options(const char* option, const char* value)
         else if (value[ 0 ] == '\0')
         {
             ERE(pso("HC sub-iterations %s displayed.\n",
-                    fs_watch_2 ? "is" : "is not"));
+                    cluster_options_ptr->watch_2 ? "is" : "is not"));
         }
         else if (value[ 0 ] == '?')
         {
             ERE(pso("hc-watch = %s\n",
-                    fs_watch_2 ? "t" : "f"));
+                    cluster_options_ptr->watch_2 ? "t" : "f"));
         }
         else
         {
             ERE(temp_boolean_value = get_boolean_value(value));
-            fs_watch_2 = temp_boolean_value;
+            cluster_options_ptr->watch_2 = temp_boolean_value;
         }
         result = NO_ERROR;
     }
@@ -1220,16 +1738,16 @@ int set_multi_modal_cluster_options(const char* option, const char* value)
         }
         else if (value[ 0 ] == '\0')
         {
-            ERE(pso("HC MAP alpha is %.3e.\n", fs_map_alpha));
+            ERE(pso("HC MAP alpha is %.3e.\n", cluster_options_ptr->map_alpha));
         }
         else if (value[ 0 ] == '?')
         {
-            ERE(pso("hc-map-alpha = %.3e\n", fs_map_alpha));
+            ERE(pso("hc-map-alpha = %.3e\n", cluster_options_ptr->map_alpha));
         }
         else
         {
             ERE(ss1snd(value, &temp_double_value));
-            fs_map_alpha = temp_double_value;
+            cluster_options_ptr->map_alpha = temp_double_value;
         }
         result = NO_ERROR;
     }
@@ -1244,16 +1762,16 @@ int set_multi_modal_cluster_options(const char* option, const char* value)
         }
         else if (value[ 0 ] == '\0')
         {
-            ERE(pso("HC MAP beta_minus_one is %.3e.\n", fs_map_beta_minus_one));
+            ERE(pso("HC MAP beta_minus_one is %.3e.\n", cluster_options_ptr->map_beta_minus_one));
         }
         else if (value[ 0 ] == '?')
         {
-            ERE(pso("hc-map-beta-minus-one = %.3e\n", fs_map_beta_minus_one));
+            ERE(pso("hc-map-beta-minus-one = %.3e\n", cluster_options_ptr->map_beta_minus_one));
         }
         else
         {
             ERE(ss1snd(value, &temp_double_value));
-            fs_map_beta_minus_one = temp_double_value;
+            cluster_options_ptr->map_beta_minus_one = temp_double_value;
         }
         result = NO_ERROR;
     }
@@ -1268,16 +1786,16 @@ int set_multi_modal_cluster_options(const char* option, const char* value)
         }
         else if (value[ 0 ] == '\0')
         {
-            ERE(pso("HC MAP kappa is %.3e.\n", fs_map_kappa));
+            ERE(pso("HC MAP kappa is %.3e.\n", cluster_options_ptr->map_kappa));
         }
         else if (value[ 0 ] == '?')
         {
-            ERE(pso("hc-map-kappa = %.3e\n", fs_map_kappa));
+            ERE(pso("hc-map-kappa = %.3e\n", cluster_options_ptr->map_kappa));
         }
         else
         {
             ERE(ss1snd(value, &temp_double_value));
-            fs_map_kappa = temp_double_value;
+            cluster_options_ptr->map_kappa = temp_double_value;
         }
         result = NO_ERROR;
     }
@@ -1292,16 +1810,16 @@ int set_multi_modal_cluster_options(const char* option, const char* value)
         }
         else if (value[ 0 ] == '\0')
         {
-            ERE(pso("HC MAP delta is %.3e.\n", fs_map_delta));
+            ERE(pso("HC MAP delta is %.3e.\n", cluster_options_ptr->map_delta));
         }
         else if (value[ 0 ] == '?')
         {
-            ERE(pso("hc-map-delta = %.3e\n", fs_map_delta));
+            ERE(pso("hc-map-delta = %.3e\n", cluster_options_ptr->map_delta));
         }
         else
         {
             ERE(ss1snd(value, &temp_double_value));
-            fs_map_delta = temp_double_value;
+            cluster_options_ptr->map_delta = temp_double_value;
         }
         result = NO_ERROR;
     }
@@ -1317,16 +1835,16 @@ int set_multi_modal_cluster_options(const char* option, const char* value)
         else if (value[ 0 ] == '\0')
         {
             ERE(pso("HC MAP r minus number of dimensions is %.3e.\n",
-                    fs_map_r_minus_n_g));
+                    cluster_options_ptr->map_r_minus_n_g));
         }
         else if (value[ 0 ] == '?')
         {
-            ERE(pso("hc-map-r-minus-n-g = %.3e\n", fs_map_r_minus_n_g));
+            ERE(pso("hc-map-r-minus-n-g = %.3e\n", cluster_options_ptr->map_r_minus_n_g));
         }
         else
         {
             ERE(ss1snd(value, &temp_double_value));
-            fs_map_r_minus_n_g = temp_double_value;
+            cluster_options_ptr->map_r_minus_n_g = temp_double_value;
         }
         result = NO_ERROR;
     }
@@ -1341,16 +1859,16 @@ int set_multi_modal_cluster_options(const char* option, const char* value)
         }
         else if (value[ 0 ] == '\0')
         {
-            ERE(pso("HC variance offset is %.3e.\n", fs_var_offset));
+            ERE(pso("HC variance offset is %.3e.\n", cluster_options_ptr->var_offset));
         }
         else if (value[ 0 ] == '?')
         {
-            ERE(pso("hc-var-offset = %.3e\n", fs_var_offset));
+            ERE(pso("hc-var-offset = %.3e\n", cluster_options_ptr->var_offset));
         }
         else
         {
             ERE(ss1snd(value, &temp_double_value));
-            fs_var_offset = temp_double_value;
+            cluster_options_ptr->var_offset = temp_double_value;
         }
         result = NO_ERROR;
     }
@@ -1365,16 +1883,16 @@ int set_multi_modal_cluster_options(const char* option, const char* value)
         }
         else if (value[ 0 ] == '\0')
         {
-            ERE(pso("HC variance offset 2 is %.3e.\n", fs_var_offset_2));
+            ERE(pso("HC variance offset 2 is %.3e.\n", cluster_options_ptr->var_offset_2));
         }
         else if (value[ 0 ] == '?')
         {
-            ERE(pso("hc-var-offset-2 = %.3e\n", fs_var_offset_2));
+            ERE(pso("hc-var-offset-2 = %.3e\n", cluster_options_ptr->var_offset_2));
         }
         else
         {
             ERE(ss1snd(value, &temp_double_value));
-            fs_var_offset_2 = temp_double_value;
+            cluster_options_ptr->var_offset_2 = temp_double_value;
         }
         result = NO_ERROR;
     }
@@ -1389,32 +1907,32 @@ int set_multi_modal_cluster_options(const char* option, const char* value)
         }
         else if (value[ 0 ] == '\0')
         {
-            if (fs_max_con_norm_var <= 0.0)
+            if (cluster_options_ptr->max_con_norm_var <= 0.0)
             {
                 ERE(pso("HC max con norm var is not used.\n"));
             }
             else
             {
                 ERE(pso("HC max con norm var is %.3e.\n",
-                        fs_max_con_norm_var));
+                        cluster_options_ptr->max_con_norm_var));
             }
         }
         else if (value[ 0 ] == '?')
         {
-            if (fs_max_con_norm_var <= 0.0)
+            if (cluster_options_ptr->max_con_norm_var <= 0.0)
             {
                 ERE(pso("hc-max-con-norm-var = off\n"));
             }
             else
             {
                 ERE(pso("hc-max-con-norm-var = %.3e\n",
-                        fs_max_con_norm_var));
+                        cluster_options_ptr->max_con_norm_var));
             }
         }
         else
         {
             ERE(ss1snd(value, &temp_double_value));
-            fs_max_con_norm_var = temp_double_value;
+            cluster_options_ptr->max_con_norm_var = temp_double_value;
         }
         result = NO_ERROR;
     }
@@ -1431,17 +1949,17 @@ int set_multi_modal_cluster_options(const char* option, const char* value)
         else if (value[ 0 ] == '\0')
         {
             ERE(pso("HC min log con prob cutoff is %.3e.\n",
-                    fs_min_con_log_prob_cutoff));
+                    cluster_options_ptr->min_con_log_prob_cutoff));
         }
         else if (value[ 0 ] == '?')
         {
             ERE(pso("hc-min-log-con-prob-curoff = %.3e\n",
-                    fs_min_con_log_prob_cutoff));
+                    cluster_options_ptr->min_con_log_prob_cutoff));
         }
         else
         {
             ERE(ss1snd(value, &temp_double_value));
-            fs_min_con_log_prob_cutoff = temp_double_value;
+            cluster_options_ptr->min_con_log_prob_cutoff = temp_double_value;
         }
         result = NO_ERROR;
     }
@@ -1458,17 +1976,17 @@ int set_multi_modal_cluster_options(const char* option, const char* value)
         else if (value[ 0 ] == '\0')
         {
             ERE(pso("HC max depend %s used.\n",
-                    fs_max_depend ? "is" : "is not"));
+                    cluster_options_ptr->max_depend ? "is" : "is not"));
         }
         else if (value[ 0 ] == '?')
         {
             ERE(pso("hc-max-depend = %s\n",
-                    fs_max_depend ? "t" : "f"));
+                    cluster_options_ptr->max_depend ? "t" : "f"));
         }
         else
         {
             ERE(temp_boolean_value = get_boolean_value(value));
-            fs_max_depend = temp_boolean_value;
+            cluster_options_ptr->max_depend = temp_boolean_value;
         }
         result = NO_ERROR;
     }
@@ -1484,17 +2002,17 @@ int set_multi_modal_cluster_options(const char* option, const char* value)
         else if (value[ 0 ] == '\0')
         {
             ERE(pso("HC pair depend %s used.\n",
-                    fs_pair_depend ? "is" : "is not"));
+                    cluster_options_ptr->pair_depend ? "is" : "is not"));
         }
         else if (value[ 0 ] == '?')
         {
             ERE(pso("hc-pair-depend = %s\n",
-                    fs_pair_depend ? "t" : "f"));
+                    cluster_options_ptr->pair_depend ? "t" : "f"));
         }
         else
         {
             ERE(temp_boolean_value = get_boolean_value(value));
-            fs_pair_depend = temp_boolean_value;
+            cluster_options_ptr->pair_depend = temp_boolean_value;
         }
         result = NO_ERROR;
     }
@@ -1510,17 +2028,17 @@ int set_multi_modal_cluster_options(const char* option, const char* value)
         else if (value[ 0 ] == '\0')
         {
             ERE(pso("HC double depend %s used.\n",
-                    fs_double_depend ? "is" : "is not"));
+                    cluster_options_ptr->double_depend ? "is" : "is not"));
         }
         else if (value[ 0 ] == '?')
         {
             ERE(pso("hc-double-depend = %s\n",
-                    fs_double_depend ? "t" : "f"));
+                    cluster_options_ptr->double_depend ? "t" : "f"));
         }
         else
         {
             ERE(temp_boolean_value = get_boolean_value(value));
-            fs_double_depend = temp_boolean_value;
+            cluster_options_ptr->double_depend = temp_boolean_value;
         }
         result = NO_ERROR;
     }
@@ -1536,17 +2054,17 @@ int set_multi_modal_cluster_options(const char* option, const char* value)
         else if (value[ 0 ] == '\0')
         {
             ERE(pso("HC norm depend %s used.\n",
-                    fs_norm_depend ? "is" : "is not"));
+                    cluster_options_ptr->norm_depend ? "is" : "is not"));
         }
         else if (value[ 0 ] == '?')
         {
             ERE(pso("hc-norm-depend = %s\n",
-                    fs_norm_depend ? "t" : "f"));
+                    cluster_options_ptr->norm_depend ? "t" : "f"));
         }
         else
         {
             ERE(temp_boolean_value = get_boolean_value(value));
-            fs_norm_depend = temp_boolean_value;
+            cluster_options_ptr->norm_depend = temp_boolean_value;
         }
         result = NO_ERROR;
     }
@@ -1565,17 +2083,17 @@ int set_multi_modal_cluster_options(const char* option, const char* value)
         else if (value[ 0 ] == '\0')
         {
             ERE(pso("HC data %s normalized.\n",
-                    fs_normalize_data ? "is" : "is not"));
+                    cluster_options_ptr->normalize_data ? "is" : "is not"));
         }
         else if (value[ 0 ] == '?')
         {
             ERE(pso("hc-normalize-data = %s\n",
-                    fs_normalize_data ? "t" : "f"));
+                    cluster_options_ptr->normalize_data ? "t" : "f"));
         }
         else
         {
             ERE(temp_boolean_value = get_boolean_value(value));
-            fs_normalize_data = temp_boolean_value;
+            cluster_options_ptr->normalize_data = temp_boolean_value;
         }
         result = NO_ERROR;
     }
@@ -1591,12 +2109,12 @@ int set_multi_modal_cluster_options(const char* option, const char* value)
         else if (value[ 0 ] == '\0')
         {
             ERE(pso("HC discrete tie count is %d.\n",
-                    fs_discrete_tie_count));
+                    cluster_options_ptr->discrete_tie_count));
         }
         else if (value[ 0 ] == '?')
         {
             ERE(pso("hc-discrete-tie-count = %d\n",
-                    fs_discrete_tie_count));
+                    cluster_options_ptr->discrete_tie_count));
         }
         else
         {
@@ -1607,7 +2125,7 @@ int set_multi_modal_cluster_options(const char* option, const char* value)
                 set_error("Discrete tie count must be at least one.");
                 return ERROR;
             }
-            fs_discrete_tie_count = temp_int_value;
+            cluster_options_ptr->discrete_tie_count = temp_int_value;
         }
         result = NO_ERROR;
     }
@@ -1624,17 +2142,17 @@ int set_multi_modal_cluster_options(const char* option, const char* value)
         else if (value[ 0 ] == '\0')
         {
             ERE(pso("HC var %s tied.\n",
-                    fs_tie_var ? "is" : "is not"));
+                    cluster_options_ptr->tie_var ? "is" : "is not"));
         }
         else if (value[ 0 ] == '?')
         {
             ERE(pso("hc-tie-var = %s\n",
-                    fs_tie_var ? "t" : "f"));
+                    cluster_options_ptr->tie_var ? "t" : "f"));
         }
         else
         {
             ERE(temp_boolean_value = get_boolean_value(value));
-            fs_tie_var = temp_boolean_value;
+            cluster_options_ptr->tie_var = temp_boolean_value;
         }
         result = NO_ERROR;
     }
@@ -1651,17 +2169,17 @@ int set_multi_modal_cluster_options(const char* option, const char* value)
         else if (value[ 0 ] == '\0')
         {
             ERE(pso("HC data %s weighted.\n",
-                    fs_weight_data ? "is" : "is not"));
+                    cluster_options_ptr->weight_data ? "is" : "is not"));
         }
         else if (value[ 0 ] == '?')
         {
             ERE(pso("hc-weight-data = %s\n",
-                    fs_weight_data ? "t" : "f"));
+                    cluster_options_ptr->weight_data ? "t" : "f"));
         }
         else
         {
             ERE(temp_boolean_value = get_boolean_value(value));
-            fs_weight_data = temp_boolean_value;
+            cluster_options_ptr->weight_data = temp_boolean_value;
         }
         result = NO_ERROR;
     }
@@ -1677,17 +2195,17 @@ int set_multi_modal_cluster_options(const char* option, const char* value)
         else if (value[ 0 ] == '\0')
         {
             ERE(pso("HC discrete nulls %s added.\n",
-                    fs_add_discrete_nulls ? "is" : "is not"));
+                    cluster_options_ptr->add_discrete_nulls ? "is" : "is not"));
         }
         else if (value[ 0 ] == '?')
         {
             ERE(pso("hc-add-discrete-nulls = %s\n",
-                    fs_add_discrete_nulls ? "t" : "f"));
+                    cluster_options_ptr->add_discrete_nulls ? "t" : "f"));
         }
         else
         {
             ERE(temp_boolean_value = get_boolean_value(value));
-            fs_add_discrete_nulls = temp_boolean_value;
+            cluster_options_ptr->add_discrete_nulls = temp_boolean_value;
         }
         result = NO_ERROR;
     }
@@ -1703,17 +2221,17 @@ int set_multi_modal_cluster_options(const char* option, const char* value)
         else if (value[ 0 ] == '\0')
         {
             ERE(pso("HC model data %s saveed.\n",
-                    fs_save_model_data ? "is" : "is not"));
+                    cluster_options_ptr->save_model_data ? "is" : "is not"));
         }
         else if (value[ 0 ] == '?')
         {
             ERE(pso("hc-save-model-data = %s\n",
-                    fs_save_model_data ? "t" : "f"));
+                    cluster_options_ptr->save_model_data ? "t" : "f"));
         }
         else
         {
             ERE(temp_boolean_value = get_boolean_value(value));
-            fs_save_model_data = temp_boolean_value;
+            cluster_options_ptr->save_model_data = temp_boolean_value;
         }
         result = NO_ERROR;
     }
@@ -1731,17 +2249,17 @@ int set_multi_modal_cluster_options(const char* option, const char* value)
         else if (value[ 0 ] == '\0')
         {
             ERE(pso("HC continuous probabilities %s normalized.\n",
-                    fs_norm_con_prob ? "are" : "are not"));
+                    cluster_options_ptr->norm_con_prob ? "are" : "are not"));
         }
         else if (value[ 0 ] == '?')
         {
             ERE(pso("hc-norm-con-prob = %s\n",
-                    fs_norm_con_prob ? "t" : "f"));
+                    cluster_options_ptr->norm_con_prob ? "t" : "f"));
         }
         else
         {
             ERE(temp_boolean_value = get_boolean_value(value));
-            fs_norm_con_prob = temp_boolean_value;
+            cluster_options_ptr->norm_con_prob = temp_boolean_value;
         }
         result = NO_ERROR;
     }
@@ -1758,17 +2276,17 @@ int set_multi_modal_cluster_options(const char* option, const char* value)
         else if (value[ 0 ] == '\0')
         {
             ERE(pso("HC trim mach two %s used.\n",
-                    fs_trim_mach_two ? "is" : "is not"));
+                    cluster_options_ptr->trim_mach_two ? "is" : "is not"));
         }
         else if (value[ 0 ] == '?')
         {
             ERE(pso("hc-trim-mach-two = %s\n",
-                    fs_trim_mach_two ? "t" : "f"));
+                    cluster_options_ptr->trim_mach_two ? "t" : "f"));
         }
         else
         {
             ERE(temp_boolean_value = get_boolean_value(value));
-            fs_trim_mach_two = temp_boolean_value;
+            cluster_options_ptr->trim_mach_two = temp_boolean_value;
         }
         result = NO_ERROR;
     }
@@ -1787,17 +2305,17 @@ int set_multi_modal_cluster_options(const char* option, const char* value)
         else if (value[ 0 ] == '\0')
         {
             ERE(pso("HC vector probabilities %s normalized.\n",
-                    fs_norm_vec_prob ? "are" : "are not"));
+                    cluster_options_ptr->norm_vec_prob ? "are" : "are not"));
         }
         else if (value[ 0 ] == '?')
         {
             ERE(pso("hc-norm-vec-prob = %s\n",
-                    fs_norm_vec_prob ? "t" : "f"));
+                    cluster_options_ptr->norm_vec_prob ? "t" : "f"));
         }
         else
         {
             ERE(temp_boolean_value = get_boolean_value(value));
-            fs_norm_vec_prob = temp_boolean_value;
+            cluster_options_ptr->norm_vec_prob = temp_boolean_value;
         }
         result = NO_ERROR;
     }
@@ -1812,20 +2330,20 @@ int set_multi_modal_cluster_options(const char* option, const char* value)
         }
         else if (value[ 0 ] == '\0')
         {
-            ERE(pso("HC data perturbation is %.3e.\n", fs_data_perturbation));
+            ERE(pso("HC data perturbation is %.3e.\n", cluster_options_ptr->data_perturbation));
         }
         else if (value[ 0 ] == '?')
         {
-            ERE(pso("hc-data-perturbation = %.3e\n", fs_data_perturbation));
+            ERE(pso("hc-data-perturbation = %.3e\n", cluster_options_ptr->data_perturbation));
         }
         else if (is_no_value_word(value))
         {
-            fs_data_perturbation = DBL_NOT_SET;
+            cluster_options_ptr->data_perturbation = DBL_NOT_SET;
         }
         else
         {
             ERE(ss1snd(value, &temp_double_value));
-            fs_data_perturbation = temp_double_value;
+            cluster_options_ptr->data_perturbation = temp_double_value;
         }
         result = NO_ERROR;
     }
@@ -1841,17 +2359,17 @@ int set_multi_modal_cluster_options(const char* option, const char* value)
         else if (value[ 0 ] == '\0')
         {
             ERE(pso("HC threshold for excluding discrete probabilities %.3e.\n",
-                    fs_dis_item_prob_threshold));
+                    cluster_options_ptr->dis_item_prob_threshold));
         }
         else if (value[ 0 ] == '?')
         {
             ERE(pso("hc-discrete-threshold = %.3e\n",
-                    fs_dis_item_prob_threshold));
+                    cluster_options_ptr->dis_item_prob_threshold));
         }
         else
         {
             ERE(ss1snd(value, &temp_double_value));
-            fs_dis_item_prob_threshold = temp_double_value;
+            cluster_options_ptr->dis_item_prob_threshold = temp_double_value;
         }
         result = NO_ERROR;
     }
@@ -1867,12 +2385,12 @@ int set_multi_modal_cluster_options(const char* option, const char* value)
         else if (value[ 0 ] == '?')
         {
             ERE(pso("hc-num-tries-per-toplogy = %d\n",
-                    fs_num_tries_per_topology));
+                    cluster_options_ptr->num_tries_per_topology));
         }
         else if (value[ 0 ] == '\0')
         {
             ERE(pso("Each toplogy gets %d EM tries.\n",
-                    fs_num_tries_per_topology));
+                    cluster_options_ptr->num_tries_per_topology));
         }
         else
         {
@@ -1882,7 +2400,7 @@ int set_multi_modal_cluster_options(const char* option, const char* value)
                 set_error("Number of tries per cluster count must be at least one.");
                 return ERROR;
             }
-            fs_num_tries_per_topology = temp_int_value;
+            cluster_options_ptr->num_tries_per_topology = temp_int_value;
         }
         result = NO_ERROR;
     }
@@ -1897,10 +2415,10 @@ int set_multi_modal_cluster_options(const char* option, const char* value)
         }
         else if (value[ 0 ] == '?')
         {
-            if (fs_num_limited_clusters > 0)
+            if (cluster_options_ptr->num_limited_clusters > 0)
             {
                 ERE(pso("hc-max-cluster-membership = %d\n",
-                        fs_num_limited_clusters));
+                        cluster_options_ptr->num_limited_clusters));
             }
             else
             {
@@ -1909,10 +2427,10 @@ int set_multi_modal_cluster_options(const char* option, const char* value)
         }
         else if (value[ 0 ] == '\0')
         {
-            if (fs_num_limited_clusters > 0)
+            if (cluster_options_ptr->num_limited_clusters > 0)
             {
                 ERE(pso("Cluster membership is limited to %d clusters.\n",
-                        fs_num_limited_clusters));
+                        cluster_options_ptr->num_limited_clusters));
             }
             else
             {
@@ -1922,7 +2440,7 @@ int set_multi_modal_cluster_options(const char* option, const char* value)
         else
         {
             ERE(ss1pi_2(value, &temp_int_value));
-            fs_num_limited_clusters = temp_int_value;
+            cluster_options_ptr->num_limited_clusters = temp_int_value;
         }
         result = NO_ERROR;
     }
@@ -1940,12 +2458,12 @@ int set_multi_modal_cluster_options(const char* option, const char* value)
         else if (value[ 0 ] == '?')
         {
             ERE(pso("hc-num-passes = %d\n",
-                    fs_num_passes));
+                    cluster_options_ptr->num_passes));
         }
         else if (value[ 0 ] == '\0')
         {
             ERE(pso("HC clustering uses %d pass%s.\n",
-                    fs_num_passes, (fs_num_passes == 2) ? "es" : ""));
+                    cluster_options_ptr->num_passes, (cluster_options_ptr->num_passes == 2) ? "es" : ""));
         }
         else
         {
@@ -1956,7 +2474,7 @@ int set_multi_modal_cluster_options(const char* option, const char* value)
                 set_error("Currently the number of passes must be 1 or 2.\n");
                 return ERROR;
             }
-            fs_num_passes = temp_int_value;
+            cluster_options_ptr->num_passes = temp_int_value;
         }
         result = NO_ERROR;
     }
@@ -1972,12 +2490,12 @@ int set_multi_modal_cluster_options(const char* option, const char* value)
         else if (value[ 0 ] == '?')
         {
             ERE(pso("hc-max-num-pass-one-points = %d\n",
-                    fs_max_num_pass_one_points));
+                    cluster_options_ptr->max_num_pass_one_points));
         }
         else if (value[ 0 ] == '\0')
         {
             ERE(pso("A maximum of %d points is used in HC pass one.\n",
-                    fs_max_num_pass_one_points));
+                    cluster_options_ptr->max_num_pass_one_points));
         }
         else
         {
@@ -1988,7 +2506,7 @@ int set_multi_modal_cluster_options(const char* option, const char* value)
                 set_error("The max number of pass one points must be non-negative.\n");
                 return ERROR;
             }
-            fs_max_num_pass_one_points = temp_int_value;
+            cluster_options_ptr->max_num_pass_one_points = temp_int_value;
         }
         result = NO_ERROR;
     }
@@ -2006,12 +2524,12 @@ int set_multi_modal_cluster_options(const char* option, const char* value)
         else if (value[ 0 ] == '\0')
         {
             ERE(pso("%d%% of the points are held out in phase one training.\n",
-                    (int)(fs_phase_one_held_out_fraction * 100)));
+                    (int)(cluster_options_ptr->phase_one_held_out_fraction * 100)));
         }
         else if (value[ 0 ] == '?')
         {
             ERE(pso("hc-phase-one-hold-out-fraction = %d%%\n",
-                    (int)(fs_phase_one_held_out_fraction * 100)));
+                    (int)(cluster_options_ptr->phase_one_held_out_fraction * 100)));
         }
         else
         {
@@ -2022,7 +2540,7 @@ int set_multi_modal_cluster_options(const char* option, const char* value)
                 set_error("Phase one hold out fraction must be positive.");
                 return ERROR;
             }
-            fs_phase_one_held_out_fraction = temp_double_value;
+            cluster_options_ptr->phase_one_held_out_fraction = temp_double_value;
         }
         result = NO_ERROR;
     }
@@ -2038,12 +2556,12 @@ int set_multi_modal_cluster_options(const char* option, const char* value)
         else if (value[ 0 ] == '\0')
         {
             ERE(pso("%d%% of the points are used in phase one training.\n",
-                    (int)(fs_phase_one_train_fraction * 100)));
+                    (int)(cluster_options_ptr->phase_one_train_fraction * 100)));
         }
         else if (value[ 0 ] == '?')
         {
             ERE(pso("hc-phase-one-train-fraction = %d%%\n",
-                    (int)(fs_phase_one_train_fraction * 100)));
+                    (int)(cluster_options_ptr->phase_one_train_fraction * 100)));
         }
         else
         {
@@ -2054,7 +2572,7 @@ int set_multi_modal_cluster_options(const char* option, const char* value)
                 set_error("Phase one training fraction must be positive.");
                 return ERROR;
             }
-            fs_phase_one_train_fraction = temp_double_value;
+            cluster_options_ptr->phase_one_train_fraction = temp_double_value;
         }
         result = NO_ERROR;
     }
@@ -2071,12 +2589,12 @@ int set_multi_modal_cluster_options(const char* option, const char* value)
         else if (value[ 0 ] == '\0')
         {
             ERE(pso("%d%% of the discrete probability is ignored.\n",
-                    (int)(fs_ignore_dis_prob_fraction * 100)));
+                    (int)(cluster_options_ptr->ignore_dis_prob_fraction * 100)));
         }
         else if (value[ 0 ] == '?')
         {
             ERE(pso("hc-ignore-dis-item-fraction = %d%%\n",
-                    (int)(fs_ignore_dis_prob_fraction * 100)));
+                    (int)(cluster_options_ptr->ignore_dis_prob_fraction * 100)));
         }
         else
         {
@@ -2087,7 +2605,7 @@ int set_multi_modal_cluster_options(const char* option, const char* value)
                 set_error("Ignore discrete prob fraction must be in [0,1).");
                 return ERROR;
             }
-            fs_ignore_dis_prob_fraction = temp_double_value;
+            cluster_options_ptr->ignore_dis_prob_fraction = temp_double_value;
         }
         result = NO_ERROR;
     }
@@ -2105,12 +2623,12 @@ int set_multi_modal_cluster_options(const char* option, const char* value)
         else if (value[ 0 ] == '\0')
         {
             ERE(pso("%d%% of the points are fitted in pass one.\n",
-                    (int)(fs_pass_one_fraction * 100)));
+                    (int)(cluster_options_ptr->pass_one_fraction * 100)));
         }
         else if (value[ 0 ] == '?')
         {
             ERE(pso("hc-pass-one-fraction = %d%%\n",
-                    (int)(fs_pass_one_fraction * 100)));
+                    (int)(cluster_options_ptr->pass_one_fraction * 100)));
         }
         else
         {
@@ -2121,7 +2639,7 @@ int set_multi_modal_cluster_options(const char* option, const char* value)
                 set_error("HC pass one fraction must be positive.");
                 return ERROR;
             }
-            fs_pass_one_fraction = temp_double_value;
+            cluster_options_ptr->pass_one_fraction = temp_double_value;
         }
         result = NO_ERROR;
     }
@@ -2139,17 +2657,17 @@ int set_multi_modal_cluster_options(const char* option, const char* value)
         else if (value[ 0 ] == '?')
         {
             ERE(pso("hc-max-num-em-iterations = %d\n",
-                    fs_max_num_em_iterations));
+                    cluster_options_ptr->max_num_em_iterations));
         }
         else if (value[ 0 ] == '\0')
         {
             ERE(pso("A maximum of %d EM iterations are used.\n",
-                    fs_max_num_em_iterations));
+                    cluster_options_ptr->max_num_em_iterations));
         }
         else
         {
             ERE(ss1pi(value, &temp_int_value));
-            fs_max_num_em_iterations = temp_int_value;
+            cluster_options_ptr->max_num_em_iterations = temp_int_value;
         }
         result = NO_ERROR;
     }
@@ -2166,17 +2684,17 @@ int set_multi_modal_cluster_options(const char* option, const char* value)
         else if (value[ 0 ] == '?')
         {
             ERE(pso("hc-min-num-em-iterations = %d\n",
-                    fs_min_num_em_iterations));
+                    cluster_options_ptr->min_num_em_iterations));
         }
         else if (value[ 0 ] == '\0')
         {
             ERE(pso("A minimum of %d EM iterations are used.\n",
-                    fs_min_num_em_iterations));
+                    cluster_options_ptr->min_num_em_iterations));
         }
         else
         {
             ERE(ss1pi(value, &temp_int_value));
-            fs_min_num_em_iterations = temp_int_value;
+            cluster_options_ptr->min_num_em_iterations = temp_int_value;
         }
         result = NO_ERROR;
     }
@@ -2192,17 +2710,17 @@ int set_multi_modal_cluster_options(const char* option, const char* value)
         else if (value[ 0 ] == '?')
         {
             ERE(pso("hc-phase-one-num-iterations = %d\n",
-                    fs_phase_one_num_iterations));
+                    cluster_options_ptr->phase_one_num_iterations));
         }
         else if (value[ 0 ] == '\0')
         {
             ERE(pso("%d phase one iterations are used in hierarchical clustering.\n",
-                    fs_phase_one_num_iterations));
+                    cluster_options_ptr->phase_one_num_iterations));
         }
         else
         {
             ERE(ss1pi(value, &temp_int_value));
-            fs_phase_one_num_iterations = temp_int_value;
+            cluster_options_ptr->phase_one_num_iterations = temp_int_value;
         }
         result = NO_ERROR;
     }
@@ -2218,17 +2736,17 @@ int set_multi_modal_cluster_options(const char* option, const char* value)
         else if (value[ 0 ] == '?')
         {
             ERE(pso("hc-phase-two-num-iterations = %d\n",
-                    fs_phase_two_num_iterations));
+                    cluster_options_ptr->phase_two_num_iterations));
         }
         else if (value[ 0 ] == '\0')
         {
             ERE(pso("%d phase two iterations are used in hierarchical clustering.\n",
-                    fs_phase_two_num_iterations));
+                    cluster_options_ptr->phase_two_num_iterations));
         }
         else
         {
             ERE(ss1pi(value, &temp_int_value));
-            fs_phase_two_num_iterations = temp_int_value;
+            cluster_options_ptr->phase_two_num_iterations = temp_int_value;
         }
         result = NO_ERROR;
     }
@@ -2245,17 +2763,17 @@ int set_multi_modal_cluster_options(const char* option, const char* value)
         else if (value[ 0 ] == '?')
         {
             ERE(pso("hc-discrete-prob-boost-factor = %.5f\n",
-                    fs_dis_prob_boost_factor));
+                    cluster_options_ptr->dis_prob_boost_factor));
         }
         else if (value[ 0 ] == '\0')
         {
             ERE(pso("Discrete probs are boosted by a factor of %.5f.\n",
-                    fs_dis_prob_boost_factor));
+                    cluster_options_ptr->dis_prob_boost_factor));
         }
         else
         {
             ERE(ss1d(value, &temp_double_value));
-            fs_dis_prob_boost_factor = temp_double_value;
+            cluster_options_ptr->dis_prob_boost_factor = temp_double_value;
         }
         result = NO_ERROR;
     }
@@ -2272,17 +2790,17 @@ int set_multi_modal_cluster_options(const char* option, const char* value)
         else if (value[ 0 ] == '?')
         {
             ERE(pso("hc-continuous-prob-boost-factor = %.5f\n",
-                    fs_con_prob_boost_factor));
+                    cluster_options_ptr->con_prob_boost_factor));
         }
         else if (value[ 0 ] == '\0')
         {
             ERE(pso("Continuous probs are boosted by a factor of %.5f.\n",
-                    fs_con_prob_boost_factor));
+                    cluster_options_ptr->con_prob_boost_factor));
         }
         else
         {
             ERE(ss1d(value, &temp_double_value));
-            fs_con_prob_boost_factor = temp_double_value;
+            cluster_options_ptr->con_prob_boost_factor = temp_double_value;
         }
         result = NO_ERROR;
     }
@@ -2299,17 +2817,17 @@ int set_multi_modal_cluster_options(const char* option, const char* value)
         else if (value[ 0 ] == '?')
         {
             ERE(pso("hc-vector-prob-boost-factor = %.5f\n",
-                    fs_vec_prob_boost_factor));
+                    cluster_options_ptr->vec_prob_boost_factor));
         }
         else if (value[ 0 ] == '\0')
         {
             ERE(pso("HC vector probs are boosted by a factor of %.5f.\n",
-                    fs_vec_prob_boost_factor));
+                    cluster_options_ptr->vec_prob_boost_factor));
         }
         else
         {
             ERE(ss1d(value, &temp_double_value));
-            fs_vec_prob_boost_factor = temp_double_value;
+            cluster_options_ptr->vec_prob_boost_factor = temp_double_value;
         }
         result = NO_ERROR;
     }
@@ -2326,17 +2844,17 @@ int set_multi_modal_cluster_options(const char* option, const char* value)
         else if (value[ 0 ] == '?')
         {
             ERE(pso("hc-histogram-prob-boost-factor = %.5f\n",
-                    fs_his_prob_boost_factor));
+                    cluster_options_ptr->his_prob_boost_factor));
         }
         else if (value[ 0 ] == '\0')
         {
             ERE(pso("HC histogram probs are boosted by a factor of %.5f.\n",
-                    fs_his_prob_boost_factor));
+                    cluster_options_ptr->his_prob_boost_factor));
         }
         else
         {
             ERE(ss1d(value, &temp_double_value));
-            fs_his_prob_boost_factor = temp_double_value;
+            cluster_options_ptr->his_prob_boost_factor = temp_double_value;
         }
         result = NO_ERROR;
     }
@@ -2352,16 +2870,16 @@ int set_multi_modal_cluster_options(const char* option, const char* value)
         else if (value[ 0 ] == '\0')
         {
             ERE(pso("HC iteration tolerance is %.3e.\n",
-                    fs_iteration_tolerance));
+                    cluster_options_ptr->iteration_tolerance));
         }
         else if (value[ 0 ] == '?')
         {
-            ERE(pso("hc-iteration-tolerance = %.3e\n", fs_iteration_tolerance));
+            ERE(pso("hc-iteration-tolerance = %.3e\n", cluster_options_ptr->iteration_tolerance));
         }
         else
         {
             ERE(ss1snd(value, &temp_double_value));
-            fs_iteration_tolerance = temp_double_value;
+            cluster_options_ptr->iteration_tolerance = temp_double_value;
         }
         result = NO_ERROR;
     }
@@ -2378,17 +2896,17 @@ int set_multi_modal_cluster_options(const char* option, const char* value)
         else if (value[ 0 ] == '?')
         {
             ERE(pso("hc-num-cooling-iterations = %d\n",
-                    fs_num_cooling_iterations));
+                    cluster_options_ptr->num_cooling_iterations));
         }
         else if (value[ 0 ] == '\0')
         {
             ERE(pso("%d HC iteratations are annealed.\n",
-                    fs_num_cooling_iterations));
+                    cluster_options_ptr->num_cooling_iterations));
         }
         else
         {
             ERE(ss1pi_2(value, &temp_int_value));
-            fs_num_cooling_iterations= temp_int_value;
+            cluster_options_ptr->num_cooling_iterations= temp_int_value;
         }
         result = NO_ERROR;
     }
@@ -2403,16 +2921,16 @@ int set_multi_modal_cluster_options(const char* option, const char* value)
         }
         else if (value[ 0 ] == '\0')
         {
-            ERE(pso("HC min temperature is %.3e.\n", fs_min_temperature));
+            ERE(pso("HC min temperature is %.3e.\n", cluster_options_ptr->min_temperature));
         }
         else if (value[ 0 ] == '?')
         {
-            ERE(pso("hc-min-temperature = %.3e\n", fs_min_temperature));
+            ERE(pso("hc-min-temperature = %.3e\n", cluster_options_ptr->min_temperature));
         }
         else
         {
             ERE(ss1snd(value, &temp_double_value));
-            fs_min_temperature = temp_double_value;
+            cluster_options_ptr->min_temperature = temp_double_value;
         }
         result = NO_ERROR;
     }
@@ -2428,16 +2946,16 @@ int set_multi_modal_cluster_options(const char* option, const char* value)
         }
         else if (value[ 0 ] == '\0')
         {
-            ERE(pso("HC max temperature is %.3e.\n", fs_max_temperature));
+            ERE(pso("HC max temperature is %.3e.\n", cluster_options_ptr->max_temperature));
         }
         else if (value[ 0 ] == '?')
         {
-            ERE(pso("hc-max-temperature = %.3e\n", fs_max_temperature));
+            ERE(pso("hc-max-temperature = %.3e\n", cluster_options_ptr->max_temperature));
         }
         else
         {
             ERE(ss1snd(value, &temp_double_value));
-            fs_max_temperature = temp_double_value;
+            cluster_options_ptr->max_temperature = temp_double_value;
         }
         result = NO_ERROR;
     }
@@ -2454,10 +2972,10 @@ int set_multi_modal_cluster_options(const char* option, const char* value)
         }
         else if (value[ 0 ] == '\0')
         {
-            if (fs_max_ave_limited_cluster_error >= 0.0)
+            if (cluster_options_ptr->max_ave_limited_cluster_error >= 0.0)
             {
                 ERE(pso("HC max ave limited cluster error is %.3e.\n",
-                        fs_max_ave_limited_cluster_error));
+                        cluster_options_ptr->max_ave_limited_cluster_error));
             }
             else
             {
@@ -2467,10 +2985,10 @@ int set_multi_modal_cluster_options(const char* option, const char* value)
         }
         else if (value[ 0 ] == '?')
         {
-            if (fs_max_ave_limited_cluster_error >= 0.0)
+            if (cluster_options_ptr->max_ave_limited_cluster_error >= 0.0)
             {
                 ERE(pso("hc-max-ave-limited-cluster-error = %.3e\n",
-                        fs_max_ave_limited_cluster_error));
+                        cluster_options_ptr->max_ave_limited_cluster_error));
             }
             else
             {
@@ -2480,7 +2998,7 @@ int set_multi_modal_cluster_options(const char* option, const char* value)
         else
         {
             ERE(ss1snd(value, &temp_double_value));
-            fs_max_ave_limited_cluster_error = temp_double_value;
+            cluster_options_ptr->max_ave_limited_cluster_error = temp_double_value;
         }
         result = NO_ERROR;
     }
@@ -2497,17 +3015,17 @@ int set_multi_modal_cluster_options(const char* option, const char* value)
         else if (value[ 0 ] == '\0')
         {
             ERE(pso("HC item probability contributions %s normalized.\n",
-                    fs_norm_items ? "are" : "are not"));
+                    cluster_options_ptr->norm_items ? "are" : "are not"));
         }
         else if (value[ 0 ] == '?')
         {
             ERE(pso("hc-norm-item-flag = %s\n",
-                    fs_norm_items ? "t" : "f"));
+                    cluster_options_ptr->norm_items ? "t" : "f"));
         }
         else
         {
             ERE(temp_boolean_value = get_boolean_value(value));
-            fs_norm_items = temp_boolean_value;
+            cluster_options_ptr->norm_items = temp_boolean_value;
         }
         result = NO_ERROR;
     }
@@ -2526,17 +3044,17 @@ int set_multi_modal_cluster_options(const char* option, const char* value)
         else if (value[ 0 ] == '\0')
         {
             ERE(pso("HC continuous feature probability contributrions %s normalized.\n",
-                    fs_norm_continuous_features ? "are" : "are not"));
+                    cluster_options_ptr->norm_continuous_features ? "are" : "are not"));
         }
         else if (value[ 0 ] == '?')
         {
             ERE(pso("hc-norm-continuous-features = %s\n",
-                    fs_norm_continuous_features ? "t" : "f"));
+                    cluster_options_ptr->norm_continuous_features ? "t" : "f"));
         }
         else
         {
             ERE(temp_boolean_value = get_boolean_value(value));
-            fs_norm_continuous_features = temp_boolean_value;
+            cluster_options_ptr->norm_continuous_features = temp_boolean_value;
         }
         result = NO_ERROR;
     }
@@ -2552,17 +3070,17 @@ int set_multi_modal_cluster_options(const char* option, const char* value)
         else if (value[ 0 ] == '\0')
         {
             ERE(pso("Clusters %s fitted with average vertical distributions for phase one.\n",
-                    fs_phase_one_uniform_vertical_dist ? "are" : "are not"));
+                    cluster_options_ptr->phase_one_uniform_vertical_dist ? "are" : "are not"));
         }
         else if (value[ 0 ] == '?')
         {
             ERE(pso("hc-phase-one-uniform-vertical-dist = %s\n",
-                    fs_phase_one_uniform_vertical_dist ? "t" : "f"));
+                    cluster_options_ptr->phase_one_uniform_vertical_dist ? "t" : "f"));
         }
         else
         {
             ERE(temp_boolean_value = get_boolean_value(value));
-            fs_phase_one_uniform_vertical_dist = temp_boolean_value;
+            cluster_options_ptr->phase_one_uniform_vertical_dist = temp_boolean_value;
         }
         result = NO_ERROR;
     }
@@ -2581,17 +3099,17 @@ int set_multi_modal_cluster_options(const char* option, const char* value)
         else if (value[ 0 ] == '\0')
         {
             ERE(pso("Clusters %s fitted with cluster dependent vertical distributions for phase one.\n",
-                    fs_phase_one_cluster_dependent_vertical_dist ? "are" : "are not"));
+                    cluster_options_ptr->phase_one_cluster_dependent_vertical_dist ? "are" : "are not"));
         }
         else if (value[ 0 ] == '?')
         {
             ERE(pso("hc-phase-one-cluster-dependent-vertical-dist = %s\n",
-                    fs_phase_one_cluster_dependent_vertical_dist ? "t" : "f"));
+                    cluster_options_ptr->phase_one_cluster_dependent_vertical_dist ? "t" : "f"));
         }
         else
         {
             ERE(temp_boolean_value = get_boolean_value(value));
-            fs_phase_one_cluster_dependent_vertical_dist = temp_boolean_value;
+            cluster_options_ptr->phase_one_cluster_dependent_vertical_dist = temp_boolean_value;
         }
         result = NO_ERROR;
     }
@@ -2607,17 +3125,17 @@ int set_multi_modal_cluster_options(const char* option, const char* value)
         else if (value[ 0 ] == '\0')
         {
             ERE(pso("Clusters %s fitted with average vertical distributions for phase two.\n",
-                    fs_phase_two_uniform_vertical_dist ? "are" : "are not"));
+                    cluster_options_ptr->phase_two_uniform_vertical_dist ? "are" : "are not"));
         }
         else if (value[ 0 ] == '?')
         {
             ERE(pso("hc-phase-two-uniform-vertical-dist = %s\n",
-                    fs_phase_two_uniform_vertical_dist ? "t" : "f"));
+                    cluster_options_ptr->phase_two_uniform_vertical_dist ? "t" : "f"));
         }
         else
         {
             ERE(temp_boolean_value = get_boolean_value(value));
-            fs_phase_two_uniform_vertical_dist = temp_boolean_value;
+            cluster_options_ptr->phase_two_uniform_vertical_dist = temp_boolean_value;
         }
         result = NO_ERROR;
     }
@@ -2636,17 +3154,17 @@ int set_multi_modal_cluster_options(const char* option, const char* value)
         else if (value[ 0 ] == '\0')
         {
             ERE(pso("Clusters %s fitted with cluster dependent vertical distributions for phase two.\n",
-                    fs_phase_two_cluster_dependent_vertical_dist ? "are" : "are not"));
+                    cluster_options_ptr->phase_two_cluster_dependent_vertical_dist ? "are" : "are not"));
         }
         else if (value[ 0 ] == '?')
         {
             ERE(pso("hc-phase-two-cluster-dependent-vertical-dist = %s\n",
-                    fs_phase_two_cluster_dependent_vertical_dist ? "t" : "f"));
+                    cluster_options_ptr->phase_two_cluster_dependent_vertical_dist ? "t" : "f"));
         }
         else
         {
             ERE(temp_boolean_value = get_boolean_value(value));
-            fs_phase_two_cluster_dependent_vertical_dist = temp_boolean_value;
+            cluster_options_ptr->phase_two_cluster_dependent_vertical_dist = temp_boolean_value;
         }
         result = NO_ERROR;
     }
@@ -2662,16 +3180,16 @@ int set_multi_modal_cluster_options(const char* option, const char* value)
         else if (value[ 0 ] == '\0')
         {
             ERE(pso("Bayesian priors %s used.\n",
-                    fs_do_map ? "are" : "are not"));
+                    cluster_options_ptr->do_map ? "are" : "are not"));
         }
         else if (value[ 0 ] == '?')
         {
-            ERE(pso("hc-do-map = %s\n", fs_do_map ? "t" : "f"));
+            ERE(pso("hc-do-map = %s\n", cluster_options_ptr->do_map ? "t" : "f"));
         }
         else
         {
             ERE(temp_boolean_value = get_boolean_value(value));
-            fs_do_map = temp_boolean_value;
+            cluster_options_ptr->do_map = temp_boolean_value;
         }
         result = NO_ERROR;
     }
@@ -2687,17 +3205,17 @@ int set_multi_modal_cluster_options(const char* option, const char* value)
         else if (value[ 0 ] == '\0')
         {
             ERE(pso("Blob priors %s used if available.\n",
-                    fs_use_blob_prior ? "is" : "is not"));
+                    cluster_options_ptr->use_blob_prior ? "is" : "is not"));
         }
         else if (value[ 0 ] == '?')
         {
             ERE(pso("hc-use-blob-and-priors = %s\n",
-                    fs_use_blob_prior ? "t" : "f"));
+                    cluster_options_ptr->use_blob_prior ? "t" : "f"));
         }
         else
         {
             ERE(temp_boolean_value = get_boolean_value(value));
-            fs_use_blob_prior = temp_boolean_value;
+            cluster_options_ptr->use_blob_prior = temp_boolean_value;
         }
         result = NO_ERROR;
     }
@@ -2713,17 +3231,17 @@ int set_multi_modal_cluster_options(const char* option, const char* value)
         else if (value[ 0 ] == '\0')
         {
             ERE(pso("Level priors %s used if available.\n",
-                    fs_use_level_prior ? "is" : "is not"));
+                    cluster_options_ptr->use_level_prior ? "is" : "is not"));
         }
         else if (value[ 0 ] == '?')
         {
             ERE(pso("hc-use-level-and-priors = %s\n",
-                    fs_use_level_prior ? "t" : "f"));
+                    cluster_options_ptr->use_level_prior ? "t" : "f"));
         }
         else
         {
             ERE(temp_boolean_value = get_boolean_value(value));
-            fs_use_level_prior = temp_boolean_value;
+            cluster_options_ptr->use_level_prior = temp_boolean_value;
         }
         result = NO_ERROR;
     }
@@ -2739,14 +3257,14 @@ int set_multi_modal_cluster_options(const char* option, const char* value)
         else if (value[ 0 ] == '?')
         {
             ERE(pso("hc-min-num-levels = %d\n",
-                    fs_min_num_levels));
+                    cluster_options_ptr->min_num_levels));
         }
         else if (value[ 0 ] == '\0')
         {
-            if (fs_min_num_levels > 0)
+            if (cluster_options_ptr->min_num_levels > 0)
             {
                 ERE(pso("HC training begins with %d levels.\n",
-                        fs_min_num_levels));
+                        cluster_options_ptr->min_num_levels));
             }
             else
             {
@@ -2756,7 +3274,7 @@ int set_multi_modal_cluster_options(const char* option, const char* value)
         else
         {
             ERE(ss1pi_2(value, &temp_int_value));
-            fs_min_num_levels = temp_int_value;
+            cluster_options_ptr->min_num_levels = temp_int_value;
         }
         result = NO_ERROR;
     }
@@ -2772,10 +3290,10 @@ int set_multi_modal_cluster_options(const char* option, const char* value)
         }
         else if (value[ 0 ] == '\0')
         {
-            if (fs_min_trim_fraction > 0.0)
+            if (cluster_options_ptr->min_trim_fraction > 0.0)
             {
                 ERE(pso("HC training begins with %d%% trims.\n",
-                        (int)(fs_min_trim_fraction * 100)));
+                        (int)(cluster_options_ptr->min_trim_fraction * 100)));
             }
             else
             {
@@ -2784,10 +3302,10 @@ int set_multi_modal_cluster_options(const char* option, const char* value)
         }
         else if (value[ 0 ] == '?')
         {
-            if (fs_min_trim_fraction > 0.0)
+            if (cluster_options_ptr->min_trim_fraction > 0.0)
             {
                 ERE(pso("hc-min-trim-fraction = %d%%\n",
-                        (int)(fs_min_trim_fraction * 100)));
+                        (int)(cluster_options_ptr->min_trim_fraction * 100)));
             }
             else
             {
@@ -2797,7 +3315,7 @@ int set_multi_modal_cluster_options(const char* option, const char* value)
         else
         {
             ERE(ss1d(value, &temp_double_value));
-            fs_min_trim_fraction = temp_double_value;
+            cluster_options_ptr->min_trim_fraction = temp_double_value;
         }
         result = NO_ERROR;
     }
@@ -2814,10 +3332,10 @@ int set_multi_modal_cluster_options(const char* option, const char* value)
         }
         else if (value[ 0 ] == '\0')
         {
-            if (fs_max_trim_fraction > 0.0)
+            if (cluster_options_ptr->max_trim_fraction > 0.0)
             {
                 ERE(pso("HC training ends with %d%% trims.\n",
-                        (int)(fs_max_trim_fraction * 100)));
+                        (int)(cluster_options_ptr->max_trim_fraction * 100)));
             }
             else
             {
@@ -2826,10 +3344,10 @@ int set_multi_modal_cluster_options(const char* option, const char* value)
         }
         else if (value[ 0 ] == '?')
         {
-            if (fs_max_trim_fraction > 0.0)
+            if (cluster_options_ptr->max_trim_fraction > 0.0)
             {
                 ERE(pso("hc-max-trim-fraction = %d%%\n",
-                        (int)(fs_max_trim_fraction * 100)));
+                        (int)(cluster_options_ptr->max_trim_fraction * 100)));
             }
             else
             {
@@ -2839,7 +3357,7 @@ int set_multi_modal_cluster_options(const char* option, const char* value)
         else
         {
             ERE(ss1d(value, &temp_double_value));
-            fs_max_trim_fraction = temp_double_value;
+            cluster_options_ptr->max_trim_fraction = temp_double_value;
         }
         result = NO_ERROR;
     }
@@ -2855,10 +3373,10 @@ int set_multi_modal_cluster_options(const char* option, const char* value)
         }
         else if (value[ 0 ] == '?')
         {
-            if (fs_sample_count > 0)
+            if (cluster_options_ptr->sample_count > 0)
             {
                 ERE(pso("hc-sample-count = %d\n",
-                        fs_sample_count));
+                        cluster_options_ptr->sample_count));
             }
             else
             {
@@ -2867,10 +3385,10 @@ int set_multi_modal_cluster_options(const char* option, const char* value)
         }
         else if (value[ 0 ] == '\0')
         {
-            if (fs_sample_count > 0)
+            if (cluster_options_ptr->sample_count > 0)
             {
                 ERE(pso("HC sample count is %d .\n",
-                        fs_sample_count));
+                        cluster_options_ptr->sample_count));
             }
             else
             {
@@ -2880,7 +3398,7 @@ int set_multi_modal_cluster_options(const char* option, const char* value)
         else
         {
             ERE(ss1pi_2(value, &temp_int_value));
-            fs_sample_count= temp_int_value;
+            cluster_options_ptr->sample_count= temp_int_value;
         }
         result = NO_ERROR;
     }
@@ -2895,10 +3413,10 @@ int set_multi_modal_cluster_options(const char* option, const char* value)
         }
         else if (value[ 0 ] == '?')
         {
-            if (fs_min_it_for_dis_items > 0)
+            if (cluster_options_ptr->min_it_for_dis_items > 0)
             {
                 ERE(pso("hc-min-it-for-dis-items = %d\n",
-                        fs_min_it_for_dis_items));
+                        cluster_options_ptr->min_it_for_dis_items));
             }
             else
             {
@@ -2907,10 +3425,10 @@ int set_multi_modal_cluster_options(const char* option, const char* value)
         }
         else if (value[ 0 ] == '\0')
         {
-            if (fs_min_it_for_dis_items > 0)
+            if (cluster_options_ptr->min_it_for_dis_items > 0)
             {
                 ERE(pso("HC min iteration for dis items is %d .\n",
-                        fs_min_it_for_dis_items));
+                        cluster_options_ptr->min_it_for_dis_items));
             }
             else
             {
@@ -2920,7 +3438,7 @@ int set_multi_modal_cluster_options(const char* option, const char* value)
         else
         {
             ERE(ss1pi_2(value, &temp_int_value));
-            fs_min_it_for_dis_items= temp_int_value;
+            cluster_options_ptr->min_it_for_dis_items= temp_int_value;
         }
         result = NO_ERROR;
     }
@@ -2935,10 +3453,10 @@ int set_multi_modal_cluster_options(const char* option, const char* value)
         }
         else if (value[ 0 ] == '?')
         {
-            if (fs_min_it_for_con_items > 0)
+            if (cluster_options_ptr->min_it_for_con_items > 0)
             {
                 ERE(pso("hc-min-it-for-con-items = %d\n",
-                        fs_min_it_for_con_items));
+                        cluster_options_ptr->min_it_for_con_items));
             }
             else
             {
@@ -2947,10 +3465,10 @@ int set_multi_modal_cluster_options(const char* option, const char* value)
         }
         else if (value[ 0 ] == '\0')
         {
-            if (fs_min_it_for_con_items > 0)
+            if (cluster_options_ptr->min_it_for_con_items > 0)
             {
                 ERE(pso("HC min iteration for con items is %d .\n",
-                        fs_min_it_for_con_items));
+                        cluster_options_ptr->min_it_for_con_items));
             }
             else
             {
@@ -2960,7 +3478,7 @@ int set_multi_modal_cluster_options(const char* option, const char* value)
         else
         {
             ERE(ss1pi_2(value, &temp_int_value));
-            fs_min_it_for_con_items= temp_int_value;
+            cluster_options_ptr->min_it_for_con_items= temp_int_value;
         }
         result = NO_ERROR;
     }
@@ -2976,14 +3494,14 @@ int set_multi_modal_cluster_options(const char* option, const char* value)
         else if (value[ 0 ] == '?')
         {
             ERE(pso("hc-max-num-level-weights = %d\n",
-                    fs_max_num_level_weights));
+                    cluster_options_ptr->max_num_level_weights));
         }
         else if (value[ 0 ] == '\0')
         {
-            if (fs_max_num_level_weights > 0)
+            if (cluster_options_ptr->max_num_level_weights > 0)
             {
                 ERE(pso("The maximum number of level weights used is %d.\n",
-                        fs_max_num_level_weights));
+                        cluster_options_ptr->max_num_level_weights));
             }
             else
             {
@@ -2993,7 +3511,7 @@ int set_multi_modal_cluster_options(const char* option, const char* value)
         else
         {
             ERE(ss1pi_2(value, &temp_int_value));
-            fs_max_num_level_weights = temp_int_value;
+            cluster_options_ptr->max_num_level_weights = temp_int_value;
         }
         result = NO_ERROR;
     }
@@ -3008,22 +3526,22 @@ int set_multi_modal_cluster_options(const char* option, const char* value)
         }
         else if (value[ 0 ] == '\0')
         {
-            if (fs_limit_gaussian_deviation > 0.0)
+            if (cluster_options_ptr->limit_gaussian_deviation > 0.0)
             {
                 ERE(pso("Gaussian distribution deviations are not limited.\n"));
             }
             else
             {
                 ERE(pso("Gaussian distribution deviations are limited to %.2f.\n",
-                        fs_limit_gaussian_deviation));
+                        cluster_options_ptr->limit_gaussian_deviation));
             }
         }
         else if (value[ 0 ] == '?')
         {
-            if (fs_limit_gaussian_deviation > 0.0)
+            if (cluster_options_ptr->limit_gaussian_deviation > 0.0)
             {
                 ERE(pso("hc-limit-gaussian-deviation = %.2f\n",
-                        fs_limit_gaussian_deviation));
+                        cluster_options_ptr->limit_gaussian_deviation));
             }
             else
             {
@@ -3033,12 +3551,12 @@ int set_multi_modal_cluster_options(const char* option, const char* value)
         }
         else if (is_no_value_word(value))
         {
-            fs_limit_gaussian_deviation = DBL_NOT_SET;
+            cluster_options_ptr->limit_gaussian_deviation = DBL_NOT_SET;
         }
         else
         {
             ERE(ss1d(value, &temp_double_value));
-            fs_limit_gaussian_deviation = temp_double_value;
+            cluster_options_ptr->limit_gaussian_deviation = temp_double_value;
         }
         result = NO_ERROR;
     }
@@ -3054,17 +3572,17 @@ int set_multi_modal_cluster_options(const char* option, const char* value)
         else if (value[ 0 ] == '\0')
         {
             ERE(pso("HC correspondence learing words %s duplicated.\n",
-                    fs_duplicate_words_for_matching ? "are" : "are not"));
+                    cluster_options_ptr->duplicate_words_for_matching ? "are" : "are not"));
         }
         else if (value[ 0 ] == '?')
         {
             ERE(pso("hc-duplicate-words-for-matching = %s\n",
-                    fs_duplicate_words_for_matching ? "t" : "f"));
+                    cluster_options_ptr->duplicate_words_for_matching ? "t" : "f"));
         }
         else
         {
             ERE(temp_boolean_value = get_boolean_value(value));
-            fs_duplicate_words_for_matching = temp_boolean_value;
+            cluster_options_ptr->duplicate_words_for_matching = temp_boolean_value;
         }
         result = NO_ERROR;
     }
@@ -3083,17 +3601,56 @@ int set_multi_modal_cluster_options(const char* option, const char* value)
         else if (value[ 0 ] == '\0')
         {
             ERE(pso("HC uniform discrete item probability %s emulated.\n",
-                    fs_emulate_uniform_discrete_prob ? "is" : "is not"));
+                    cluster_options_ptr->emulate_uniform_discrete_prob ? "is" : "is not"));
         }
         else if (value[ 0 ] == '?')
         {
             ERE(pso("hc-emulate-uniform-word-prob = %s\n",
-                    fs_emulate_uniform_discrete_prob ? "t" : "f"));
+                    cluster_options_ptr->emulate_uniform_discrete_prob ? "t" : "f"));
         }
         else
         {
             ERE(temp_boolean_value = get_boolean_value(value));
-            fs_emulate_uniform_discrete_prob = temp_boolean_value;
+            cluster_options_ptr->emulate_uniform_discrete_prob = temp_boolean_value;
+        }
+        result = NO_ERROR;
+    }
+
+    if (    (lc_option[ 0 ] == '\0')
+          || match_pattern(lc_option, "hc-num-threads")
+       )
+    {
+        if (value == NULL)
+        {
+            return NO_ERROR;
+        }
+        else if (value[ 0 ] == '\0')
+        {
+            if (cluster_options_ptr->num_threads == 0)
+            {
+                ERE(pso("HC cluster membership is computed with one thread per processor.\n"));
+            }
+            else
+            {
+                ERE(pso("HC cluster membership is computed with %d threads.\n",
+                        cluster_options_ptr->num_threads));
+            }
+        }
+        else if (value[ 0 ] == '?')
+        {
+            ERE(pso("hc-num-threads = %d\n", cluster_options_ptr->num_threads));
+        }
+        else
+        {
+            ERE(ss1i(value, &temp_int_value));
+
+            if (temp_int_value < 0)
+            {
+                set_error("The number of HC threads cannot be negative.");
+                return ERROR;
+            }
+
+            cluster_options_ptr->num_threads = temp_int_value;
         }
         result = NO_ERROR;
     }
@@ -3116,6 +3673,76 @@ int do_multi_modal_clustering
     const char*            output_dir,
     double                 (*dis_item_loss_fn)(int, const double*)
 )
+{
+    return do_multi_modal_clustering_with_options(topology_vp,
+                                                  dis_item_level_vp,
+                                                  data_ptr,
+                                                  held_out_data_ptr,
+                                                  model_ptr,
+                                                  output_model_fn,
+                                                  output_dir,
+                                                  dis_item_loss_fn,
+                                                  &fs_options);
+}
+
+/*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\   */
+
+/*
+ * As do_multi_modal_clustering(), but with the options in cluster_options_ptr
+ * (see create_multi_modal_cluster_options()) rather than the process wide
+ * ones. Nothing else is shared between calls, so several models can be fit at
+ * once in different threads. The cluster membership (E-step) computations for
+ * held out data are split over "hc-num-threads" threads.
+*/
+int do_multi_modal_clustering_with_options
+(
+    const Topology_vector*             topology_vp,
+    const Int_vector*                  dis_item_level_vp,
+    const Cluster_data*                data_ptr,
+    const Cluster_data*                held_out_data_ptr,
+    Multi_modal_model*                 model_ptr,
+    int                                (*output_model_fn) (const Multi_modal_model *, int, const char *),
+    const char*                        output_dir,
+    double                             (*dis_item_loss_fn)(int, const double*),
+    const Multi_modal_cluster_options* cluster_options_ptr
+)
+{
+    Cluster_cache cache;
+    int           result;
+
+
+    init_cluster_cache(&cache);
+
+    result = do_multi_modal_clustering_with_cache(topology_vp,
+                                                  dis_item_level_vp,
+                                                  data_ptr,
+                                                  held_out_data_ptr,
+                                                  model_ptr,
+                                                  output_model_fn,
+                                                  output_dir,
+                                                  dis_item_loss_fn,
+                                                  cluster_options_ptr,
+                                                  &cache);
+    free_cluster_cache(&cache);
+
+    return result;
+}
+
+/*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\   */
+
+static int do_multi_modal_clustering_with_cache
+(
+    const Topology_vector*             topology_vp,
+    const Int_vector*                  dis_item_level_vp,
+    const Cluster_data*                data_ptr,
+    const Cluster_data*                held_out_data_ptr,
+    Multi_modal_model*                 model_ptr,
+    int                                (*output_model_fn) (const Multi_modal_model *, int, const char *),
+    const char*                        output_dir,
+    double                             (*dis_item_loss_fn)(int, const double*),
+    const Multi_modal_cluster_options* cluster_options_ptr,
+    Cluster_cache*                     cache_ptr
+)
 {
     int           j;
     int           result = NO_ERROR;
@@ -3161,7 +3788,7 @@ int do_multi_modal_clustering
         return ERROR;
     }
 
-    if (fs_normalize_data)
+    if (cluster_options_ptr->normalize_data)
     {
         verbose_pso(2, "Normalizing data before training.\n");
 
@@ -3199,9 +3826,9 @@ int do_multi_modal_clustering
     }
 #endif
 
-    if (fs_data_perturbation > 10.0 * DBL_MIN)
+    if (cluster_options_ptr->data_perturbation > 10.0 * DBL_MIN)
     {
-        if ( ! fs_normalize_data)
+        if ( ! cluster_options_ptr->normalize_data)
         {
             warn_pso("Perturbing data without normalization.\n");
             warn_pso("This may not be what you want.\n");
@@ -3209,7 +3836,7 @@ int do_multi_modal_clustering
 
         ERE(copy_cluster_data(&perturbed_data_ptr, derived_data_ptr));
         ERE(ow_perturb_composite_cluster_data(perturbed_data_ptr->con_item_mvp,
-                                              fs_data_perturbation,
+                                              cluster_options_ptr->data_perturbation,
                                               /*
                                                * We don't normalize grouped
                                                * features, because this might
@@ -3229,7 +3856,7 @@ int do_multi_modal_clustering
     }
 #endif
 
-    if (fs_add_discrete_nulls)
+    if (cluster_options_ptr->add_discrete_nulls)
     {
         ERE(add_discrete_nulls_to_data(&data_with_nulls_ptr,
                                        derived_data_ptr));
@@ -3254,7 +3881,7 @@ int do_multi_modal_clustering
     verify_cluster_data(derived_held_out_data_ptr);
 #endif
 
-    if (num_topologies * fs_num_tries_per_topology == 1)
+    if (num_topologies * cluster_options_ptr->num_tries_per_topology == 1)
     {
         result = do_multi_modal_clustering_2(topology_vp->topologies[ 0 ],
                                              dis_item_level_vp,
@@ -3262,7 +3889,8 @@ int do_multi_modal_clustering
                                              derived_held_out_data_ptr,
                                              model_ptr, output_model_fn, output_dir,
                                              mean_vp, var_vp, norm_stdev,
-                                             dis_item_loss_fn);
+                                             dis_item_loss_fn,
+                                             cluster_options_ptr, cache_ptr);
 
         if (result == ERROR)
         {
@@ -3285,7 +3913,7 @@ int do_multi_modal_clustering
         UNTESTED_CODE();  /* Not recently, anyway. */
 
         verbose_pso(2, "Using %d topologies, and %d tries per topologoy.\n",
-                    num_topologies, fs_num_tries_per_topology);
+                    num_topologies, cluster_options_ptr->num_tries_per_topology);
 
         if (new_model_ptr == NULL) result = ERROR;
 
@@ -3293,7 +3921,7 @@ int do_multi_modal_clustering
         {
             if (result == ERROR) { NOTE_ERROR(); break; }
 
-            for (j = 0; j < fs_num_tries_per_topology; j++)
+            for (j = 0; j < cluster_options_ptr->num_tries_per_topology; j++)
             {
                 int impossible_model;
 
@@ -3316,7 +3944,8 @@ int do_multi_modal_clustering
                                  derived_held_out_data_ptr,
                                  new_model_ptr, NULL, NULL,
                                  mean_vp, var_vp, norm_stdev,
-                                 dis_item_loss_fn
+                                 dis_item_loss_fn,
+                                 cluster_options_ptr, cache_ptr
                              );
                 }
 
@@ -3365,7 +3994,7 @@ int do_multi_modal_clustering
         free_multi_modal_model(new_model_ptr);
     }
 
-    if ((result != ERROR) && (fs_normalize_data))
+    if ((result != ERROR) && (cluster_options_ptr->normalize_data))
     {
         result = ow_un_normalize_multi_modal_model(model_ptr, mean_vp, var_vp,
                                                     norm_stdev);
@@ -3381,7 +4010,7 @@ int do_multi_modal_clustering
     }
 #endif
 
-    if ((result != ERROR) && (fs_add_discrete_nulls))
+    if ((result != ERROR) && (cluster_options_ptr->add_discrete_nulls))
     {
         result = subtract_discrete_nulls_from_model(model_ptr);
         if (result == ERROR) { NOTE_ERROR(); }
@@ -3425,7 +4054,9 @@ static int do_multi_modal_clustering_2
     const Vector*       norm_mean_vp,
     const Vector*       norm_var_vp,
     double              norm_stdev,
-    double              (*dis_item_loss_fn)(int, const double*)
+    double              (*dis_item_loss_fn)(int, const double*),
+    const Multi_modal_cluster_options* cluster_options_ptr,
+    Cluster_cache*                     cache_ptr
 )
 {
     int           result            = NO_ERROR;
@@ -3472,48 +4103,48 @@ static int do_multi_modal_clustering_2
     // to output the model, then the fields reflect the state under which the
     // model is being trained.
     */
-    model_ptr->weight_con_items = fs_weight_con_items;
-    model_ptr->discrete_tie_count = fs_discrete_tie_count;
-    model_ptr->norm_depend = fs_norm_depend;
+    model_ptr->weight_con_items = cluster_options_ptr->weight_con_items;
+    model_ptr->discrete_tie_count = cluster_options_ptr->discrete_tie_count;
+    model_ptr->norm_depend = cluster_options_ptr->norm_depend;
     model_ptr->phase_one_num_iterations = 0;  /* Ignore phase one. */
     model_ptr->phase_two_num_iterations = 1;  /* Not sure why we would want anything else. */
-    model_ptr->phase_one_uniform_vertical_dist = fs_phase_one_uniform_vertical_dist;
-    model_ptr->phase_two_uniform_vertical_dist = fs_phase_two_uniform_vertical_dist;
-    model_ptr->phase_one_cluster_dependent_vertical_dist = fs_phase_one_cluster_dependent_vertical_dist;
-    model_ptr->phase_two_cluster_dependent_vertical_dist = fs_phase_two_cluster_dependent_vertical_dist;
-
-    model_ptr->phase_one_sample_matches = fs_phase_one_sample_matches;
-    model_ptr->phase_one_share_matches = fs_phase_one_share_matches;
-    model_ptr->phase_one_model_correspondence = fs_phase_one_model_correspondence;
-    model_ptr->phase_one_last_sample = fs_phase_one_last_sample;
-    model_ptr->phase_two_sample_matches = fs_phase_two_sample_matches;
-    model_ptr->phase_two_share_matches = fs_phase_two_share_matches;
-    model_ptr->phase_two_model_correspondence = fs_phase_two_model_correspondence;
-    model_ptr->phase_two_last_sample = fs_phase_two_last_sample;
-
-    model_ptr->dis_item_prob_threshold  = fs_dis_item_prob_threshold;
-    model_ptr->norm_items               = fs_norm_items;
-    model_ptr->norm_continuous_features = fs_norm_continuous_features;
-    model_ptr->dis_prob_boost_factor    = fs_dis_prob_boost_factor;
-    model_ptr->con_prob_boost_factor    = fs_con_prob_boost_factor;
-    model_ptr->var_offset = fs_var_offset;
+    model_ptr->phase_one_uniform_vertical_dist = cluster_options_ptr->phase_one_uniform_vertical_dist;
+    model_ptr->phase_two_uniform_vertical_dist = cluster_options_ptr->phase_two_uniform_vertical_dist;
+    model_ptr->phase_one_cluster_dependent_vertical_dist = cluster_options_ptr->phase_one_cluster_dependent_vertical_dist;
+    model_ptr->phase_two_cluster_dependent_vertical_dist = cluster_options_ptr->phase_two_cluster_dependent_vertical_dist;
+
+    model_ptr->phase_one_sample_matches = cluster_options_ptr->phase_one_sample_matches;
+    model_ptr->phase_one_share_matches = cluster_options_ptr->phase_one_share_matches;
+    model_ptr->phase_one_model_correspondence = cluster_options_ptr->phase_one_model_correspondence;
+    model_ptr->phase_one_last_sample = cluster_options_ptr->phase_one_last_sample;
+    model_ptr->phase_two_sample_matches = cluster_options_ptr->phase_two_sample_matches;
+    model_ptr->phase_two_share_matches = cluster_options_ptr->phase_two_share_matches;
+    model_ptr->phase_two_model_correspondence = cluster_options_ptr->phase_two_model_correspondence;
+    model_ptr->phase_two_last_sample = cluster_options_ptr->phase_two_last_sample;
+
+    model_ptr->dis_item_prob_threshold  = cluster_options_ptr->dis_item_prob_threshold;
+    model_ptr->norm_items               = cluster_options_ptr->norm_items;
+    model_ptr->norm_continuous_features = cluster_options_ptr->norm_continuous_features;
+    model_ptr->dis_prob_boost_factor    = cluster_options_ptr->dis_prob_boost_factor;
+    model_ptr->con_prob_boost_factor    = cluster_options_ptr->con_prob_boost_factor;
+    model_ptr->var_offset = cluster_options_ptr->var_offset;
 #ifdef SUPPORT_IGNORE_DIS_PROB
-    model_ptr->ignore_dis_prob_fraction = fs_ignore_dis_prob_fraction;
+    model_ptr->ignore_dis_prob_fraction = cluster_options_ptr->ignore_dis_prob_fraction;
 #endif
 
 
-    options.convergence_criterion = fs_phase_two_convergence_criterion;
-    options.uniform_vertical_dist = fs_phase_two_uniform_vertical_dist;
-    options.cluster_dependent_vertical_dist = fs_phase_two_cluster_dependent_vertical_dist;
-    options.sample_matches = fs_phase_two_sample_matches;
-    options.share_matches = fs_phase_two_share_matches;
-    options.last_sample = fs_phase_two_last_sample;
+    options.convergence_criterion = cluster_options_ptr->phase_two_convergence_criterion;
+    options.uniform_vertical_dist = cluster_options_ptr->phase_two_uniform_vertical_dist;
+    options.cluster_dependent_vertical_dist = cluster_options_ptr->phase_two_cluster_dependent_vertical_dist;
+    options.sample_matches = cluster_options_ptr->phase_two_sample_matches;
+    options.share_matches = cluster_options_ptr->phase_two_share_matches;
+    options.last_sample = cluster_options_ptr->phase_two_last_sample;
 
 #ifdef OBSOLETE /* Superseeded by separate word model. */
     /* IE, see do_fixed_discrete_multi_modal_clustering(). */
     if (topology_ptr->hack_nando_gaussian)
     {
-        if (fs_phase_two_model_correspondence != 1)
+        if (cluster_options_ptr->phase_two_model_correspondence != 1)
         {
             warn_pso("Forcing correspondence model 1 for ");
             warn_pso("hacking Nando's Gaussian method.\n");
@@ -3523,27 +4154,27 @@ static int do_multi_modal_clustering_2
     }
     else
     {
-        options.model_correspondence = fs_phase_two_model_correspondence;
+        options.model_correspondence = cluster_options_ptr->phase_two_model_correspondence;
     }
 #else
-    options.model_correspondence = fs_phase_two_model_correspondence;
+    options.model_correspondence = cluster_options_ptr->phase_two_model_correspondence;
 #endif
 
     dbi(topology_ptr->num_levels);
 
     max_num_levels = topology_ptr->num_levels;
 
-    dbi(fs_min_num_levels);
-    dbi(MAX_OF(fs_min_num_levels, topology_ptr->first_level));
+    dbi(cluster_options_ptr->min_num_levels);
+    dbi(MAX_OF(cluster_options_ptr->min_num_levels, topology_ptr->first_level));
 
-    if (fs_min_num_levels <= 0)
+    if (cluster_options_ptr->min_num_levels <= 0)
     {
         min_num_levels = max_num_levels;
     }
     else
     {
         min_num_levels = MIN_OF(max_num_levels,
-                                MAX_OF(fs_min_num_levels,
+                                MAX_OF(cluster_options_ptr->min_num_levels,
                                        topology_ptr->first_level));
     }
 
@@ -3591,11 +4222,11 @@ static int do_multi_modal_clustering_2
         if (result == ERROR) { NOTE_ERROR(); break; }
 
 #ifdef XXX_SUPPORT_TRIMMING
-        if (    (fs_min_trim_fraction > 0.0)
-             && (fs_max_trim_fraction > 0.0)
+        if (    (cluster_options_ptr->min_trim_fraction > 0.0)
+             && (cluster_options_ptr->max_trim_fraction > 0.0)
            )
         {
-            double trim_fraction_range = fs_max_trim_fraction - fs_min_trim_fraction;
+            double trim_fraction_range = cluster_options_ptr->max_trim_fraction - cluster_options_ptr->min_trim_fraction;
             double trim_fraction_done = 0;
 
             if (level_range > 0)
@@ -3603,7 +4234,7 @@ static int do_multi_modal_clustering_2
                 trim_fraction_done = (double)(num_levels - min_num_levels) / (double)level_range;
             }
 
-            trim_fraction = fs_max_trim_fraction - trim_fraction_done * trim_fraction_range
+            trim_fraction = cluster_options_ptr->max_trim_fraction - trim_fraction_done * trim_fraction_range
         }
 
         dbe(trim_fraction);
@@ -3618,8 +4249,9 @@ static int do_multi_modal_clustering_2
                                        output_dir,
                                        norm_mean_vp, norm_var_vp,
                                        norm_stdev,
-                                       fs_max_num_em_iterations,
-                                       dis_item_loss_fn);
+                                       cluster_options_ptr->max_num_em_iterations,
+                                       dis_item_loss_fn,
+                                       cluster_options_ptr, cache_ptr);
 
         if (result == ERROR)
         {
@@ -3673,7 +4305,9 @@ static int do_multi_modal_clustering_2
     const Vector*       norm_mean_vp,
     const Vector*       norm_var_vp,
     double              norm_stdev,
-    double              (*dis_item_loss_fn)(int, const double*)
+    double              (*dis_item_loss_fn)(int, const double*),
+    const Multi_modal_cluster_options* cluster_options_ptr,
+    Cluster_cache*                     cache_ptr
 )
 {
     int           result            = NO_ERROR;
@@ -3708,36 +4342,36 @@ static int do_multi_modal_clustering_2
     // to output the model, then the fields reflect the state under which the
     // model is being trained.
     */
-    model_ptr->weight_con_items = fs_weight_con_items;
-    model_ptr->discrete_tie_count = fs_discrete_tie_count;
-    model_ptr->norm_depend = fs_norm_depend;
-    model_ptr->phase_one_num_iterations = fs_phase_one_num_iterations;
-    model_ptr->phase_two_num_iterations = fs_phase_two_num_iterations;
-    model_ptr->phase_one_uniform_vertical_dist = fs_phase_one_uniform_vertical_dist;
-    model_ptr->phase_two_uniform_vertical_dist = fs_phase_two_uniform_vertical_dist;
-    model_ptr->phase_one_cluster_dependent_vertical_dist = fs_phase_one_cluster_dependent_vertical_dist;
-    model_ptr->phase_two_cluster_dependent_vertical_dist = fs_phase_two_cluster_dependent_vertical_dist;
-
-    model_ptr->phase_one_sample_matches = fs_phase_one_sample_matches;
-    model_ptr->phase_one_share_matches = fs_phase_one_share_matches;
-    model_ptr->phase_one_model_correspondence = fs_phase_one_model_correspondence;
-    model_ptr->phase_one_last_sample = fs_phase_one_last_sample;
-    model_ptr->phase_two_sample_matches = fs_phase_two_sample_matches;
-    model_ptr->phase_two_share_matches = fs_phase_two_share_matches;
-    model_ptr->phase_two_model_correspondence = fs_phase_two_model_correspondence;
-    model_ptr->phase_two_last_sample = fs_phase_two_last_sample;
-
-    model_ptr->dis_item_prob_threshold  = fs_dis_item_prob_threshold;
-    model_ptr->norm_items               = fs_norm_items;
-    model_ptr->norm_continuous_features = fs_norm_continuous_features;
-    model_ptr->dis_prob_boost_factor    = fs_dis_prob_boost_factor;
-    model_ptr->con_prob_boost_factor    = fs_con_prob_boost_factor;
-    model_ptr->var_offset = fs_var_offset;
+    model_ptr->weight_con_items = cluster_options_ptr->weight_con_items;
+    model_ptr->discrete_tie_count = cluster_options_ptr->discrete_tie_count;
+    model_ptr->norm_depend = cluster_options_ptr->norm_depend;
+    model_ptr->phase_one_num_iterations = cluster_options_ptr->phase_one_num_iterations;
+    model_ptr->phase_two_num_iterations = cluster_options_ptr->phase_two_num_iterations;
+    model_ptr->phase_one_uniform_vertical_dist = cluster_options_ptr->phase_one_uniform_vertical_dist;
+    model_ptr->phase_two_uniform_vertical_dist = cluster_options_ptr->phase_two_uniform_vertical_dist;
+    model_ptr->phase_one_cluster_dependent_vertical_dist = cluster_options_ptr->phase_one_cluster_dependent_vertical_dist;
+    model_ptr->phase_two_cluster_dependent_vertical_dist = cluster_options_ptr->phase_two_cluster_dependent_vertical_dist;
+
+    model_ptr->phase_one_sample_matches = cluster_options_ptr->phase_one_sample_matches;
+    model_ptr->phase_one_share_matches = cluster_options_ptr->phase_one_share_matches;
+    model_ptr->phase_one_model_correspondence = cluster_options_ptr->phase_one_model_correspondence;
+    model_ptr->phase_one_last_sample = cluster_options_ptr->phase_one_last_sample;
+    model_ptr->phase_two_sample_matches = cluster_options_ptr->phase_two_sample_matches;
+    model_ptr->phase_two_share_matches = cluster_options_ptr->phase_two_share_matches;
+    model_ptr->phase_two_model_correspondence = cluster_options_ptr->phase_two_model_correspondence;
+    model_ptr->phase_two_last_sample = cluster_options_ptr->phase_two_last_sample;
+
+    model_ptr->dis_item_prob_threshold  = cluster_options_ptr->dis_item_prob_threshold;
+    model_ptr->norm_items               = cluster_options_ptr->norm_items;
+    model_ptr->norm_continuous_features = cluster_options_ptr->norm_continuous_features;
+    model_ptr->dis_prob_boost_factor    = cluster_options_ptr->dis_prob_boost_factor;
+    model_ptr->con_prob_boost_factor    = cluster_options_ptr->con_prob_boost_factor;
+    model_ptr->var_offset = cluster_options_ptr->var_offset;
 #ifdef SUPPORT_IGNORE_DIS_PROB
-    model_ptr->ignore_dis_prob_fraction = fs_ignore_dis_prob_fraction;
+    model_ptr->ignore_dis_prob_fraction = cluster_options_ptr->ignore_dis_prob_fraction;
 #endif
 
-    if (fs_phase_one_num_iterations > 0)
+    if (cluster_options_ptr->phase_one_num_iterations > 0)
     {
         int                 i;
         int                 num_points               = data_ptr->num_points;
@@ -3746,8 +4380,8 @@ static int do_multi_modal_clustering_2
         Cluster_data*       subset_held_out_data_ptr = NULL;
         const Cluster_data* used_held_out_data_ptr;
         Indexed_vector*     point_key_vp             = NULL;
-        int                 train_count              = kjb_rint((double)num_points * fs_phase_one_train_fraction);
-        int                 held_out_count           = kjb_rint((double)num_points * fs_phase_one_held_out_fraction);
+        int                 train_count              = kjb_rint((double)num_points * cluster_options_ptr->phase_one_train_fraction);
+        int                 held_out_count           = kjb_rint((double)num_points * cluster_options_ptr->phase_one_held_out_fraction);
         int                 point;
 
 
@@ -3784,7 +4418,7 @@ static int do_multi_modal_clustering_2
             goto mmc2_phase_one_cleanup;
         }
 
-        if (    (fs_phase_one_held_out_data_is_fixed)
+        if (    (cluster_options_ptr->phase_one_held_out_data_is_fixed)
              && (    (held_out_data_ptr == NULL)
                   || (held_out_data_ptr->id_vp == NULL)
                   || (held_out_data_ptr->id_vp->length <= 0)
@@ -3797,18 +4431,18 @@ static int do_multi_modal_clustering_2
             goto mmc2_phase_one_cleanup;
         }
 
-        options.convergence_criterion = fs_phase_one_convergence_criterion;
-        options.uniform_vertical_dist = fs_phase_one_uniform_vertical_dist;
-        options.cluster_dependent_vertical_dist = fs_phase_one_cluster_dependent_vertical_dist;
-        options.sample_matches = fs_phase_one_sample_matches;
-        options.share_matches = fs_phase_one_share_matches;
-        options.last_sample = fs_phase_one_last_sample;
+        options.convergence_criterion = cluster_options_ptr->phase_one_convergence_criterion;
+        options.uniform_vertical_dist = cluster_options_ptr->phase_one_uniform_vertical_dist;
+        options.cluster_dependent_vertical_dist = cluster_options_ptr->phase_one_cluster_dependent_vertical_dist;
+        options.sample_matches = cluster_options_ptr->phase_one_sample_matches;
+        options.share_matches = cluster_options_ptr->phase_one_share_matches;
+        options.last_sample = cluster_options_ptr->phase_one_last_sample;
 
 #ifdef OBSOLETE /* Superseeded by separate word model. */
         /* IE, see do_fixed_discrete_multi_modal_clustering(). */
         if (topology_ptr->hack_nando_gaussian)
         {
-            if (fs_phase_one_model_correspondence != 1)
+            if (cluster_options_ptr->phase_one_model_correspondence != 1)
             {
                 warn_pso("Forcing correspondence model 1 for ");
                 warn_pso("hacking Nando's Gaussian method.\n");
@@ -3818,10 +4452,10 @@ static int do_multi_modal_clustering_2
         }
         else
         {
-            options.model_correspondence = fs_phase_one_model_correspondence;
+            options.model_correspondence = cluster_options_ptr->phase_one_model_correspondence;
         }
 #else
-        options.model_correspondence = fs_phase_one_model_correspondence;
+        options.model_correspondence = cluster_options_ptr->phase_one_model_correspondence;
 #endif
 
         if (train_count + held_out_count > num_points)
@@ -3835,7 +4469,7 @@ static int do_multi_modal_clustering_2
         }
 
         if (    (held_out_count < 1)
-             && (fs_phase_one_convergence_criterion != MAX_DATA_LL)
+             && (cluster_options_ptr->phase_one_convergence_criterion != MAX_DATA_LL)
            )
         {
             set_error("No phase one held out data.");
@@ -3844,7 +4478,7 @@ static int do_multi_modal_clustering_2
             NOTE_ERROR();
         }
 
-        if ( ! fs_phase_one_held_out_data_is_fixed)
+        if ( ! cluster_options_ptr->phase_one_held_out_data_is_fixed)
         {
             if ((subset_held_out_data_ptr = allocate_cluster_data()) == NULL)
             {
@@ -3862,7 +4496,7 @@ static int do_multi_modal_clustering_2
             used_held_out_data_ptr = held_out_data_ptr;
         }
 
-        for (i = 0; i < fs_phase_one_num_iterations; i++)
+        for (i = 0; i < cluster_options_ptr->phase_one_num_iterations; i++)
         {
             if (result == ERROR) { NOTE_ERROR(); break; }
 
@@ -4101,8 +4735,9 @@ static int do_multi_modal_clustering_2
                                                  &options, NULL, NULL,
                                                  norm_mean_vp, norm_var_vp,
                                                  norm_stdev,
-                          (fs_phase_one_convergence_criterion == THREE_ITERATIONS) ? 3 : fs_max_num_em_iterations,
-                                                 dis_item_loss_fn);
+                          (cluster_options_ptr->phase_one_convergence_criterion == THREE_ITERATIONS) ? 3 : cluster_options_ptr->max_num_em_iterations,
+                                                 dis_item_loss_fn,
+                                                 cluster_options_ptr, cache_ptr);
 
             if (result == ERROR)
             {
@@ -4141,7 +4776,7 @@ mmc2_phase_one_cleanup:
     }
 #endif
 
-    if (fs_phase_two_num_iterations <= 0)
+    if (cluster_options_ptr->phase_two_num_iterations <= 0)
     {
         UNTESTED_CODE();   /* Not excecuted recently anyway. */
 
@@ -4150,17 +4785,17 @@ mmc2_phase_one_cleanup:
         // data from phase one. We therefore use phase one options.
         */
         options.convergence_criterion = SINGLE_ITERATION;
-        options.uniform_vertical_dist = fs_phase_one_uniform_vertical_dist;
-        options.cluster_dependent_vertical_dist = fs_phase_one_cluster_dependent_vertical_dist;
-        options.sample_matches = fs_phase_one_sample_matches;
-        options.share_matches = fs_phase_one_share_matches;
-        options.last_sample = fs_phase_one_last_sample;
+        options.uniform_vertical_dist = cluster_options_ptr->phase_one_uniform_vertical_dist;
+        options.cluster_dependent_vertical_dist = cluster_options_ptr->phase_one_cluster_dependent_vertical_dist;
+        options.sample_matches = cluster_options_ptr->phase_one_sample_matches;
+        options.share_matches = cluster_options_ptr->phase_one_share_matches;
+        options.last_sample = cluster_options_ptr->phase_one_last_sample;
 
 #ifdef OBSOLETE /* Superseeded by separate word model. */
         /* IE, see do_fixed_discrete_multi_modal_clustering(). */
         if (topology_ptr->hack_nando_gaussian)
         {
-            if (fs_phase_one_model_correspondence != 1)
+            if (cluster_options_ptr->phase_one_model_correspondence != 1)
             {
                 warn_pso("Forcing correspondence model 1 for ");
                 warn_pso("hacking Nando's Gaussian method.\n");
@@ -4170,10 +4805,10 @@ mmc2_phase_one_cleanup:
         }
         else
         {
-            options.model_correspondence = fs_phase_one_model_correspondence;
+            options.model_correspondence = cluster_options_ptr->phase_one_model_correspondence;
         }
 #else
-        options.model_correspondence = fs_phase_one_model_correspondence;
+        options.model_correspondence = cluster_options_ptr->phase_one_model_correspondence;
 #endif
 
         result = do_multi_modal_clustering_3(topology_ptr, dis_item_level_vp,
@@ -4181,7 +4816,8 @@ mmc2_phase_one_cleanup:
                                              model_ptr, &options, NULL, NULL,
                                              norm_mean_vp, norm_var_vp,
                                              norm_stdev, 1,
-                                             dis_item_loss_fn);
+                                             dis_item_loss_fn,
+                                             cluster_options_ptr, cache_ptr);
 
         if (result == ERROR)
         {
@@ -4202,18 +4838,18 @@ mmc2_phase_one_cleanup:
     }
     else
     {
-        options.convergence_criterion = fs_phase_two_convergence_criterion;
-        options.uniform_vertical_dist = fs_phase_two_uniform_vertical_dist;
-        options.cluster_dependent_vertical_dist = fs_phase_two_cluster_dependent_vertical_dist;
-        options.sample_matches = fs_phase_two_sample_matches;
-        options.share_matches = fs_phase_two_share_matches;
-        options.last_sample = fs_phase_two_last_sample;
+        options.convergence_criterion = cluster_options_ptr->phase_two_convergence_criterion;
+        options.uniform_vertical_dist = cluster_options_ptr->phase_two_uniform_vertical_dist;
+        options.cluster_dependent_vertical_dist = cluster_options_ptr->phase_two_cluster_dependent_vertical_dist;
+        options.sample_matches = cluster_options_ptr->phase_two_sample_matches;
+        options.share_matches = cluster_options_ptr->phase_two_share_matches;
+        options.last_sample = cluster_options_ptr->phase_two_last_sample;
 
 #ifdef OBSOLETE /* Superseeded by separate word model. */
         /* IE, see do_fixed_discrete_multi_modal_clustering(). */
         if (topology_ptr->hack_nando_gaussian)
         {
-            if (fs_phase_two_model_correspondence != 1)
+            if (cluster_options_ptr->phase_two_model_correspondence != 1)
             {
                 warn_pso("Forcing correspondence model 1 for ");
                 warn_pso("hacking Nando's Gaussian method.\n");
@@ -4223,13 +4859,13 @@ mmc2_phase_one_cleanup:
         }
         else
         {
-            options.model_correspondence = fs_phase_two_model_correspondence;
+            options.model_correspondence = cluster_options_ptr->phase_two_model_correspondence;
         }
 #else
-        options.model_correspondence = fs_phase_two_model_correspondence;
+        options.model_correspondence = cluster_options_ptr->phase_two_model_correspondence;
 #endif
 
-        for (it = 0; it < fs_phase_two_num_iterations; it++)
+        for (it = 0; it < cluster_options_ptr->phase_two_num_iterations; it++)
         {
             if (result == ERROR)
             {
@@ -4245,12 +4881,13 @@ mmc2_phase_one_cleanup:
             result  = do_multi_modal_clustering_3(topology_ptr, dis_item_level_vp,
                                                   data_ptr, held_out_data_ptr,
                                                   model_ptr, &options,
-                                                  (it < fs_phase_two_num_iterations - 1) ? NULL : output_model_fn,
+                                                  (it < cluster_options_ptr->phase_two_num_iterations - 1) ? NULL : output_model_fn,
                                                   output_dir,
                                                   norm_mean_vp, norm_var_vp,
                                                   norm_stdev,
-                                                  fs_max_num_em_iterations,
-                                                  dis_item_loss_fn);
+                                                  cluster_options_ptr->max_num_em_iterations,
+                                                  dis_item_loss_fn,
+                                                  cluster_options_ptr, cache_ptr);
 
             if (result == ERROR)
             {
@@ -4289,7 +4926,9 @@ static int do_multi_modal_clustering_3
     const Vector*       norm_var_vp,
     double              norm_stdev,
     int                 max_num_em_iterations,
-    double              (*dis_item_loss_fn)(int, const double*)
+    double              (*dis_item_loss_fn)(int, const double*),
+    const Multi_modal_cluster_options* cluster_options_ptr,
+    Cluster_cache*                     cache_ptr
 )
 {
     Training_options options = *options_ptr;
@@ -4331,7 +4970,8 @@ static int do_multi_modal_clustering_3
                                               output_dir,
                                               norm_mean_vp, norm_var_vp,
                                               norm_stdev,
-                                              max_num_em_iterations);
+                                              max_num_em_iterations,
+                                              cluster_options_ptr, cache_ptr);
 
     }
 
@@ -4340,17 +4980,17 @@ static int do_multi_modal_clustering_3
 
     max_num_levels = topology_ptr->num_levels;
 
-    dbi(fs_min_num_levels);
-    dbi(MAX_OF(fs_min_num_levels, topology_ptr->first_level));
+    dbi(cluster_options_ptr->min_num_levels);
+    dbi(MAX_OF(cluster_options_ptr->min_num_levels, topology_ptr->first_level));
 
-    if (fs_min_num_levels <= 0)
+    if (cluster_options_ptr->min_num_levels <= 0)
     {
         min_num_levels = max_num_levels;
     }
     else
     {
         min_num_levels = MIN_OF(max_num_levels,
-                                MAX_OF(fs_min_num_levels,
+                                MAX_OF(cluster_options_ptr->min_num_levels,
                                        topology_ptr->first_level));
     }
 
@@ -4398,11 +5038,11 @@ static int do_multi_modal_clustering_3
         if (result == ERROR) { NOTE_ERROR(); break; }
 
 #ifdef XXX_SUPPORT_TRIMMING
-        if (    (fs_min_trim_fraction > 0.0)
-             && (fs_max_trim_fraction > 0.0)
+        if (    (cluster_options_ptr->min_trim_fraction > 0.0)
+             && (cluster_options_ptr->max_trim_fraction > 0.0)
            )
         {
-            double trim_fraction_range = fs_max_trim_fraction - fs_min_trim_fraction;
+            double trim_fraction_range = cluster_options_ptr->max_trim_fraction - cluster_options_ptr->min_trim_fraction;
             double trim_fraction_done = 0;
 
             if (level_range > 0)
@@ -4410,7 +5050,7 @@ static int do_multi_modal_clustering_3
                 trim_fraction_done = (double)(num_levels - min_num_levels) / (double)level_range;
             }
 
-            trim_fraction = fs_max_trim_fraction - trim_fraction_done * trim_fraction_range
+            trim_fraction = cluster_options_ptr->max_trim_fraction - trim_fraction_done * trim_fraction_range
         }
 
         dbe(trim_fraction);
@@ -4426,7 +5066,8 @@ static int do_multi_modal_clustering_3
                                               norm_mean_vp, norm_var_vp,
                                               norm_stdev,
                                               max_num_em_iterations,
-                                              dis_item_loss_fn);
+                                              dis_item_loss_fn,
+                                              cluster_options_ptr, cache_ptr);
 
         if (result == ERROR)
         {
@@ -4498,7 +5139,9 @@ static int do_multi_modal_clustering_4
     const Vector*           norm_var_vp,
     double                  norm_stdev,
     int                     max_num_em_iterations,
-    double                  (*dis_item_loss_fn)(int, const double*)
+    double                  (*dis_item_loss_fn)(int, const double*),
+    const Multi_modal_cluster_options* cluster_options_ptr,
+    Cluster_cache*                     cache_ptr
 )
 {
     IMPORT volatile Bool    iteration_atn_flag;
@@ -5039,11 +5682,11 @@ static int do_multi_modal_clustering_4
 
     if (result != ERROR)
     {
-        result = initialize_vector_feature_counts(con_feature_enable_vp, con_feature_group_vp);
+        result = initialize_vector_feature_counts(cache_ptr, con_feature_enable_vp, con_feature_group_vp);
     }
 
     if (    (result != ERROR)
-         && (fs_emulate_uniform_discrete_prob)
+         && (cluster_options_ptr->emulate_uniform_discrete_prob)
          && (dis_item_mp != NULL)
        )
     {
@@ -5076,17 +5719,17 @@ static int do_multi_modal_clustering_4
     }
 
 #ifdef SUPPORT_ANNEALING
-    if ((result != ERROR) && (fs_num_cooling_iterations > 0))
+    if ((result != ERROR) && (cluster_options_ptr->num_cooling_iterations > 0))
     {
-        temperature = fs_min_temperature;
-        temperature_factor = exp(log(fs_max_temperature/fs_min_temperature)/
-                                            (double)fs_num_cooling_iterations);
+        temperature = cluster_options_ptr->min_temperature;
+        temperature_factor = exp(log(cluster_options_ptr->max_temperature/cluster_options_ptr->min_temperature)/
+                                            (double)cluster_options_ptr->num_cooling_iterations);
     }
 #endif
 
 
 #ifdef TEST_WEIGHT_DATA
-    if ((result != ERROR) && (fs_weight_data) && (weight_vp == NULL))
+    if ((result != ERROR) && (cluster_options_ptr->weight_data) && (weight_vp == NULL))
     {
         ERE(get_random_vector(&test_weight_vp, num_points));
         weight_vp = test_weight_vp;
@@ -5238,8 +5881,8 @@ static int do_multi_modal_clustering_4
     }
 
     if (    (result != ERROR)
-         && (    (fs_watch_max_cluster_given_point_diff)
-              || (fs_watch_rms_cluster_given_point_diff)
+         && (    (cluster_options_ptr->watch_max_cluster_given_point_diff)
+              || (cluster_options_ptr->watch_rms_cluster_given_point_diff)
            )
        )
     {
@@ -5399,13 +6042,13 @@ XXX }
         if (result == ERROR) { NOTE_ERROR(); }
     }
 
-    if ((result != ERROR) && (max_num_con_items > 0) && (fs_do_map))
+    if ((result != ERROR) && (max_num_con_items > 0) && (cluster_options_ptr->do_map))
     {
         result = get_target_matrix_vector(&omega_mvp, num_levels);
         if (result == ERROR) { NOTE_ERROR(); }
     }
 
-    if ((result != ERROR) && (max_num_con_items > 0) && (fs_do_map))
+    if ((result != ERROR) && (max_num_con_items > 0) && (cluster_options_ptr->do_map))
     {
         result = get_target_matrix_vector(&delta_inverse_mvp, num_levels);
         if (result == ERROR) { NOTE_ERROR(); }
@@ -5604,10 +6247,10 @@ XXX }
     }
 #endif
 
-    if ((result != ERROR) && (max_num_dis_items > 0) && (fs_do_map))
+    if ((result != ERROR) && (max_num_dis_items > 0) && (cluster_options_ptr->do_map))
     {
         result = get_initialized_vector(&map_alpha_vp, num_clusters,
-                                        fs_map_alpha);
+                                        cluster_options_ptr->map_alpha);
 
         if (result != ERROR)
         {
@@ -5650,7 +6293,7 @@ XXX }
 #else
                 result = get_initialized_vector(
                                         &(map_beta_minus_one_vvp->elements[ node ]),
-                                        num_categories, fs_map_beta_minus_one);
+                                        num_categories, cluster_options_ptr->map_beta_minus_one);
 #endif
 #endif
 
@@ -5658,7 +6301,7 @@ XXX }
 
                 map_beta_minus_one_vp = map_beta_minus_one_vvp->elements[ node ];
 
-                if ((fs_use_level_prior) && (dis_item_level_vp != NULL))
+                if ((cluster_options_ptr->use_level_prior) && (dis_item_level_vp != NULL))
                 {
                     for (category = 0; category < num_categories; category++)
                     {
@@ -5688,11 +6331,11 @@ XXX }
                             map_beta_minus_one_vp->elements[ category ] *= 2.0;
 #endif
 #ifdef MACH_TWO
-                            map_beta_minus_one_vp->elements[ category ] = fs_map_beta_minus_one *
+                            map_beta_minus_one_vp->elements[ category ] = cluster_options_ptr->map_beta_minus_one *
                                                                                      exp(-level_diff);
 #endif
 #ifdef MACH_THREE
-                            map_beta_minus_one_vp->elements[ category ] = fs_map_beta_minus_one *
+                            map_beta_minus_one_vp->elements[ category ] = cluster_options_ptr->map_beta_minus_one *
                                                                                      exp(-2.0 * level_diff);
 #endif
 
@@ -5729,7 +6372,7 @@ XXX }
     }
 #endif
 
-    if ((result != ERROR) && (max_num_con_items > 0) && (fs_do_map))
+    if ((result != ERROR) && (max_num_con_items > 0) && (cluster_options_ptr->do_map))
     {
         /* Untested since addition of last level parameter in topology. */
         /* Dec 10, 2004 */
@@ -5741,7 +6384,7 @@ XXX }
 
         while (level < last_level_num)
         {
-            map_r_minus_n_g = fs_map_r_minus_n_g /
+            map_r_minus_n_g = cluster_options_ptr->map_r_minus_n_g /
                                         (double)(last_level_num - level);
             level++;
         }
@@ -5753,8 +6396,8 @@ XXX }
                                  dis_item_mp,
                                  dis_item_multiplicity_mp,
                                  max_num_dis_items_with_multiplicity,
-                                 fs_norm_items,
-                                 fs_dis_prob_boost_factor);
+                                 cluster_options_ptr->norm_items,
+                                 cluster_options_ptr->dis_prob_boost_factor);
         verify_vector(dis_factor_vp, NULL);
     }
 
@@ -5767,8 +6410,8 @@ XXX }
                                  held_out_dis_item_mp,
                                  held_out_dis_item_multiplicity_mp,
                                  max_num_held_out_dis_items_with_multiplicity,
-                                 fs_norm_items,
-                                 fs_dis_prob_boost_factor);
+                                 cluster_options_ptr->norm_items,
+                                 cluster_options_ptr->dis_prob_boost_factor);
         verify_vector(held_out_dis_factor_vp, NULL);
     }
 
@@ -5776,8 +6419,8 @@ XXX }
     {
         result = get_con_factors(&con_factor_vp, con_item_mvp,
                                  max_num_con_items,
-                                 fs_norm_items,
-                                 fs_con_prob_boost_factor);
+                                 cluster_options_ptr->norm_items,
+                                 cluster_options_ptr->con_prob_boost_factor);
         verify_vector(con_factor_vp, NULL);
     }
 
@@ -5789,8 +6432,8 @@ XXX }
         result = get_con_factors(&held_out_con_factor_vp,
                                  held_out_con_item_mvp,
                                  max_num_held_out_con_items,
-                                 fs_norm_items,
-                                 fs_con_prob_boost_factor);
+                                 cluster_options_ptr->norm_items,
+                                 cluster_options_ptr->con_prob_boost_factor);
         verify_vector(held_out_con_factor_vp, NULL);
     }
 
@@ -5800,16 +6443,16 @@ XXX if ((result != ERROR) && (max_num_vec_items > 0))
 XXX {
 XXX     result = get_vec_factors(&vec_factor_vp, vec_item_vvvvp,
 XXX                              max_num_vec_items,
-XXX                              fs_norm_items,
-XXX                              fs_vec_prob_boost_factor);
+XXX                              cluster_options_ptr->norm_items,
+XXX                              cluster_options_ptr->vec_prob_boost_factor);
 XXX }
 XXX
 XXX if ((result != ERROR) && (max_num_his_items > 0))
 XXX {
 XXX     result = get_his_factors(&his_factor_vp, his_item_vvvvp,
 XXX                              max_num_his_items,
-XXX                              fs_norm_items,
-XXX                              fs_his_prob_boost_factor);
+XXX                              cluster_options_ptr->norm_items,
+XXX                              cluster_options_ptr->his_prob_boost_factor);
 XXX }
 #endif
 
@@ -5861,7 +6504,7 @@ XXX }
     if (    (result != ERROR)
          && (max_num_con_items > 0)
          && (options_ptr->initial_model_is_valid )
-         && (fs_do_map)
+         && (cluster_options_ptr->do_map)
        )
     {
         result = copy_matrix_vector(&omega_mvp, model_ptr->mean_mvp);
@@ -5949,44 +6592,44 @@ XXX }
     }
 #endif
 
-    if ((result != ERROR) && fs_watch)
+    if ((result != ERROR) && cluster_options_ptr->watch)
     {
         head_len = 30;
 
         if (need_held_out_log_likelihood) head_len += 15;
         if (need_held_out_log_likelihood) head_len += 13;
 #ifdef SUPPORT_ANNEALING
-        if (fs_watch_temperature) head_len += 13;
+        if (cluster_options_ptr->watch_temperature) head_len += 13;
 #endif
-        if (fs_watch_max_con_prob) head_len += 12;
+        if (cluster_options_ptr->watch_max_con_prob) head_len += 12;
 #ifdef VEC_AND_HIS
-        if (fs_watch_max_vec_prob) head_len += 12;
+        if (cluster_options_ptr->watch_max_vec_prob) head_len += 12;
 #endif
-        if (fs_watch_max_cluster_given_point_diff) head_len += 12;
-        if (fs_watch_rms_cluster_given_point_diff) head_len += 12;
-        if (fs_watch_max_parm_diff) head_len += 12;
-        if (fs_watch_ave_limited_error) head_len += 12;
-        if (fs_watch_max_limited_error) head_len += 12;
+        if (cluster_options_ptr->watch_max_cluster_given_point_diff) head_len += 12;
+        if (cluster_options_ptr->watch_rms_cluster_given_point_diff) head_len += 12;
+        if (cluster_options_ptr->watch_max_parm_diff) head_len += 12;
+        if (cluster_options_ptr->watch_ave_limited_error) head_len += 12;
+        if (cluster_options_ptr->watch_max_limited_error) head_len += 12;
 
         rep_print(stdout, '=', head_len);
         pso("\n");
 
-        pso(" it  |    %s     |   diff   ", fs_do_map ? "LP/N" : "LL/N");
+        pso(" it  |    %s     |   diff   ", cluster_options_ptr->do_map ? "LP/N" : "LL/N");
 
         if (need_held_out_log_likelihood) pso(" | Held out LL");
         if (need_held_out_log_likelihood) pso(" |   diff   ");
 #ifdef SUPPORT_ANNEALING
-        if (fs_watch_temperature) pso(" |   temp    ");
+        if (cluster_options_ptr->watch_temperature) pso(" |   temp    ");
 #endif
-        if (fs_watch_max_con_prob) pso(" | max con P");
+        if (cluster_options_ptr->watch_max_con_prob) pso(" | max con P");
 #ifdef VEC_AND_HIS
-        if (fs_watch_max_vec_prob) pso(" | max vec P");
+        if (cluster_options_ptr->watch_max_vec_prob) pso(" | max vec P");
 #endif
-        if (fs_watch_rms_cluster_given_point_diff) pso(" | rms P c  ");
-        if (fs_watch_max_cluster_given_point_diff) pso(" | max P c  ");
-        if (fs_watch_max_parm_diff) pso(" | max parm ");
-        if (fs_watch_ave_limited_error) pso(" | ave lim  ");
-        if (fs_watch_max_limited_error) pso(" | max lim  ");
+        if (cluster_options_ptr->watch_rms_cluster_given_point_diff) pso(" | rms P c  ");
+        if (cluster_options_ptr->watch_max_cluster_given_point_diff) pso(" | max P c  ");
+        if (cluster_options_ptr->watch_max_parm_diff) pso(" | max parm ");
+        if (cluster_options_ptr->watch_ave_limited_error) pso(" | ave lim  ");
+        if (cluster_options_ptr->watch_max_limited_error) pso(" | max lim  ");
         pso("\n");
         rep_print(stdout, '-', head_len);
         pso("\n");
@@ -6010,7 +6653,7 @@ XXX }
     dbp("************************************************************");
     db_irv(level_counts_vp);
 
-    if (    ( ! fs_use_specified_clusters)
+    if (    ( ! cluster_options_ptr->use_specified_clusters)
          && (last_level_num == (num_levels - 1))
          && (num_levels >= 2)
          && (level_counts_vp->elements[ num_levels - 2 ] == 1)
@@ -6031,6 +6674,7 @@ XXX }
     for (it = 0; it < max_num_em_iterations; it++)
     {
         int num_good_points = 0;
+        int use_training_jobs;
 
 
         CHECK_FOR_HEAP_OVERRUNS();
@@ -6054,7 +6698,7 @@ XXX }
 #endif
 
         changed_number_of_parameters = FALSE;
-        var_offset = fs_var_offset + fs_var_offset_2 / (1.0 + it/5);
+        var_offset = cluster_options_ptr->var_offset + cluster_options_ptr->var_offset_2 / (1.0 + it/5);
         var_offset *= (norm_stdev * norm_stdev);
 
 #ifdef REPORT_CPU_TIME
@@ -6076,9 +6720,9 @@ XXX }
         if (    ( ! valid_cluster_index) /* Only flip the switch once. */
              && ((it != 0) || (options_ptr->initial_model_is_valid))
              && (num_limited_clusters != num_clusters)
-             && (    (fs_max_ave_limited_cluster_error < 0.0)  /* Not set */
+             && (    (cluster_options_ptr->max_ave_limited_cluster_error < 0.0)  /* Not set */
                   || (    (ave_limited_cluster_error > 0.0)
-                       && (ave_limited_cluster_error < fs_max_ave_limited_cluster_error)
+                       && (ave_limited_cluster_error < cluster_options_ptr->max_ave_limited_cluster_error)
                      )
                 )
            )
@@ -6163,7 +6807,7 @@ XXX }
 #ifdef SUPPORT_IGNORE_DIS_PROB
         if (dis_prob_count > 0)
         {
-            extra_dis_prob = fs_ignore_dis_prob_fraction * total_dis_prob / dis_prob_count;
+            extra_dis_prob = cluster_options_ptr->ignore_dis_prob_fraction * total_dis_prob / dis_prob_count;
             dis_prob_count = 0;
             total_dis_prob = 0.0;
         }
@@ -6481,8 +7125,114 @@ XXX     }
 #endif
         CHECK_FOR_HEAP_OVERRUNS();
 
+        /*
+         * In the usual case the E-step is done by the same jobs as
+         * get_cluster_membership_2(), in threads, each summing the statistics
+         * of the M-step for its own points. Otherwise the points are done one
+         * at a time in the loop below.
+        */
+        use_training_jobs = can_use_training_jobs(options_ptr,
+                                                  cluster_options_ptr,
+                                                  data_ptr, it,
+                                                  num_clusters,
+                                                  num_clusters_used,
+                                                  num_limited_clusters);
 
-        for (point = 0; point < num_points; point++)
+        if (use_training_jobs)
+        {
+            Cluster_membership_input    membership_input;
+            Cluster_training_input      training_input;
+            Cluster_training_statistics total;
+
+            current_model_is_valid = TRUE;
+            ave_limited_cluster_error = DBL_NOT_SET;
+            max_limited_cluster_error = DBL_MOST_NEGATIVE;
+
+            result = initialize_vector_feature_counts(cache_ptr,
+                                                      con_feature_enable_vp,
+                                                      con_feature_group_vp);
+            if (result == ERROR) { NOTE_ERROR(); break; }
+
+            membership_input.topology_ptr = topology_ptr;
+            membership_input.a_vp = a_vp;
+            membership_input.V_mp = ((valid_cluster_dependent_aspects) || (valid_aspects)) ? NULL : V_mp;
+            membership_input.input_P_l_p_c_mvp = valid_cluster_dependent_aspects ? P_l_p_c_mvp : NULL;
+            membership_input.input_P_l_p_mp = ((valid_aspects) && ( ! valid_cluster_dependent_aspects)) ? P_l_p_mp : NULL;
+            membership_input.P_i_n_mvp = (max_num_dis_items == 0) ? NULL : P_i_n_mvp;
+            membership_input.mean_mvp = (max_num_con_items == 0) ? NULL : mean_mvp;
+            membership_input.var_mvp = var_mvp;
+            membership_input.con_log_sqrt_det_vvp = con_log_sqrt_det_vvp;
+            /* The normalization is added to the log likelihood after the loop. */
+            membership_input.con_log_norm = 0.0;
+            membership_input.con_feature_enable_vp = con_feature_enable_vp;
+            membership_input.con_feature_group_vp = con_feature_group_vp;
+            membership_input.min_con_log_prob = min_con_log_prob;
+            membership_input.max_con_norm_var = cluster_options_ptr->max_con_norm_var;
+            membership_input.con_score_cutoff = con_score_cutoff;
+            membership_input.weight_con_items = model_ptr->weight_con_items;
+            membership_input.norm_depend = model_ptr->norm_depend;
+            membership_input.model_correspondence = options_ptr->model_correspondence;
+            membership_input.data_ptr = data_ptr;
+            membership_input.points_to_use_vp = NULL;
+            membership_input.dis_factor_vp = dis_factor_vp;
+            membership_input.con_factor_vp = con_factor_vp;
+            membership_input.norm_continuous_features = cluster_options_ptr->norm_continuous_features;
+            membership_input.cluster_options_ptr = cluster_options_ptr;
+            membership_input.vector_feature_counts_ptr = cache_ptr->vector_feature_counts_ptr;
+            membership_input.num_sparse_levels = num_levels;
+            membership_input.first_sparse_level = first_level;
+            membership_input.level_index_mp = NULL;
+            membership_input.con_score_vp = NULL;
+            membership_input.lock_P_c_p_mp = P_c_p_mp;
+            membership_input.P_c_p_mp = P_c_p_mp;
+            membership_input.P_l_p_c_mvp = NULL;
+            membership_input.P_l_p_mp = NULL;
+            membership_input.fit_vp = fit_vp;
+            membership_input.missing_index_vvp = missing_index_vvp;
+
+            training_input.membership_input_ptr = &membership_input;
+            training_input.weight_vp = (cluster_options_ptr->weight_data) ? weight_vp : NULL;
+            training_input.dis_item_empirical_vp = dis_item_empirical_vp;
+            training_input.multiply_vertical_prior_weights = cluster_options_ptr->multiply_vertical_prior_weights;
+            training_input.compute_cluster_dependent_aspects = compute_cluster_dependent_aspects;
+            training_input.compute_aspects = compute_aspects;
+            training_input.P_l_p_c_mvp = compute_cluster_dependent_aspects ? P_l_p_c_mvp : NULL;
+            training_input.P_l_p_mp = compute_aspects ? P_l_p_mp : NULL;
+            training_input.num_points = num_points;
+            training_input.num_slices = MIN_OF(MAX_NUM_TRAINING_SLICES,
+                                               1 + (num_points - 1) / MIN_POINTS_PER_TRAINING_SLICE);
+
+            total.a_vp = new_a_vp;
+            total.V_mp = new_V_mp;
+            total.dis_V_mp = (max_num_dis_items == 0) ? NULL : new_dis_V_mp;
+            total.con_V_mp = (max_num_con_items == 0) ? NULL : new_con_V_mp;
+            total.dis_P_sum_vvp = (max_num_dis_items == 0) ? NULL : dis_P_sum_vvp;
+            total.P_i_n_mvp = (max_num_dis_items == 0) ? NULL : new_P_i_n_mvp;
+            total.con_P_sum_vvp = (max_num_con_items == 0) ? NULL : con_P_sum_vvp;
+            total.mean_mvp = (max_num_con_items == 0) ? NULL : new_mean_mvp;
+            total.var_mvp = (max_num_con_items == 0) ? NULL : new_var_mvp;
+            total.missing_con_P_sum_vvvp = (max_num_con_items == 0) ? NULL : missing_con_P_sum_vvvp;
+            total.log_likelihood = log_likelihood;
+            total.ll_con_correction_norm_sum = ll_con_correction_norm_sum;
+            total.max_con_log_prob = max_con_log_prob;
+            total.num_points = 0;
+            total.num_dis_items = 0;
+            total.num_con_items = 0;
+
+            result = do_training_e_step_with_jobs(&total, &training_input,
+                                                  cache_ptr, max_num_items,
+                                                  it);
+            if (result == ERROR) { NOTE_ERROR(); break; }
+
+            log_likelihood = total.log_likelihood;
+            ll_con_correction_norm_sum = total.ll_con_correction_norm_sum;
+            max_con_log_prob = total.max_con_log_prob;
+            num_good_points = total.num_points;
+            dis_item_count = total.num_dis_items;
+            con_item_count = total.num_con_items;
+        }
+
+        for (point = 0; (point < num_points) && ( ! use_training_jobs ); point++)
         {
             double point_weight = 1.0;
 
@@ -6503,7 +7253,7 @@ XXX     }
              */
             if (    (options_ptr->model_correspondence == 0)
                  && (max_num_dis_items > 0)
-                 && (it < fs_min_it_for_con_items)
+                 && (it < cluster_options_ptr->min_it_for_con_items)
                )
             {
                 num_con_items = 0;
@@ -6514,7 +7264,7 @@ XXX     }
 
             /* dbi(point); */
 
-            if ((fs_weight_data) && (weight_vp != NULL))
+            if ((cluster_options_ptr->weight_data) && (weight_vp != NULL))
             {
                 point_weight = weight_vp->elements[ point ];
             }
@@ -6561,7 +7311,7 @@ XXX     }
 /* TEST */
 /* TEST */          for (item = 0; item < max_num_items; item++)
 /* TEST */          {
-                        if (    (fs_use_specified_clusters)
+                        if (    (cluster_options_ptr->use_specified_clusters)
                              && (data_ptr->group_vp != NULL)
                            )
                         {
@@ -6662,7 +7412,7 @@ once_more:
                 num_levels = num_real_levels;
 
 #ifdef SUPPORT_NUM_CLUSTER_SWITCH     /* Not finished. Should it be? */
-                if (    ( ! fs_use_specified_clusters)
+                if (    ( ! cluster_options_ptr->use_specified_clusters)
                      && (last_level_num == (num_levels - 1))
                      && (num_levels >= 2)
                      && (level_counts_vp->elements[ num_levels - 2 ] == 1)
@@ -6728,7 +7478,7 @@ once_more:
                                        );
 #else
 
-                if (fs_initialize_method <= 0)
+                if (cluster_options_ptr->initialize_method <= 0)
                 {
                     result = ow_set_vector(P_c_p_vp, 0.001);
                 }
@@ -6766,7 +7516,7 @@ once_more:
 #endif
 
 #else
-                        if (fs_initialize_method <= 0)
+                        if (cluster_options_ptr->initialize_method <= 0)
                         {
                             cluster = (int)((double)num_clusters * temp_double);
 
@@ -6777,7 +7527,7 @@ once_more:
                         else
                         {
                             P_c_p_vp->elements[ c ] += pow(temp_double,
-                                                           (double)fs_initialize_method);
+                                                           (double)cluster_options_ptr->initialize_method);
                         }
 #endif
 
@@ -6884,13 +7634,13 @@ once_more:
 #else
                             p = kjb_rand();
 
-                            if (fs_initialize_method <= 0)
+                            if (cluster_options_ptr->initialize_method <= 0)
                             {
                                 p += 0.1;
                             }
                             else
                             {
-                                p = pow(p, (double)fs_initialize_method);
+                                p = pow(p, (double)cluster_options_ptr->initialize_method);
 
                             }
 #endif
@@ -6947,13 +7697,13 @@ once_more:
 #else
                             p = kjb_rand();
 
-                            if (fs_initialize_method <= 0)
+                            if (cluster_options_ptr->initialize_method <= 0)
                             {
                                 p += 0.1;
                             }
                             else
                             {
-                                p = pow(p, (double)fs_initialize_method);
+                                p = pow(p, (double)cluster_options_ptr->initialize_method);
 
                             }
 #endif
@@ -7021,13 +7771,13 @@ once_more:
 #else
                                 p = kjb_rand();
 
-                                if (fs_initialize_method <= 0)
+                                if (cluster_options_ptr->initialize_method <= 0)
                                 {
                                     p += 0.1;
                                 }
                                 else
                                 {
-                                    p = pow(p, (double)fs_initialize_method);
+                                    p = pow(p, (double)cluster_options_ptr->initialize_method);
 
                                 }
                             }
@@ -7150,7 +7900,7 @@ once_more:
                  * Too dangerous to integrate this with the above mess. Just
                  * overwrite P_c_p_vp with what it has to be.
                 */
-                if (    (fs_use_specified_clusters)
+                if (    (cluster_options_ptr->use_specified_clusters)
                      && (data_ptr->group_vp != NULL)
                    )
                 {
@@ -7299,10 +8049,10 @@ once_more:
                                                       mean_mvp->elements[ level ]->elements[ node ],
                                                       var_mvp->elements[ level ]->elements[ node ],
                                                       con_log_sqrt_det_vvp->elements[ level ]->elements[ node ],
-                                                      fs_norm_continuous_features,
-                                                      fs_limit_gaussian_deviation,
-                                                      fs_max_con_norm_var,
-                                                      fs_vector_feature_counts_ptr,
+                                                      cluster_options_ptr->norm_continuous_features,
+                                                      cluster_options_ptr->limit_gaussian_deviation,
+                                                      cluster_options_ptr->max_con_norm_var,
+                                                      cache_ptr->vector_feature_counts_ptr,
                                                       con_prob_cache_ptr,
                                                       &max_con_log_prob, TRUE);
                         }
@@ -7314,10 +8064,10 @@ once_more:
                                                       mean_mvp->elements[ level ]->elements[ node ],
                                                       var_mvp->elements[ level ]->elements[ node ],
                                                       con_log_sqrt_det_vvp->elements[ level ]->elements[ node ],
-                                                      fs_norm_continuous_features,
-                                                      fs_limit_gaussian_deviation,
-                                                      fs_max_con_norm_var,
-                                                      fs_vector_feature_counts_ptr,
+                                                      cluster_options_ptr->norm_continuous_features,
+                                                      cluster_options_ptr->limit_gaussian_deviation,
+                                                      cluster_options_ptr->max_con_norm_var,
+                                                      cache_ptr->vector_feature_counts_ptr,
                                                       con_prob_cache_ptr,
                                                       &max_con_log_prob, FALSE);
                         }
@@ -7338,7 +8088,7 @@ once_more:
 
 /* ANNEAL */            *annealed_log_prob_ptr = (*con_prob_cache_ptr);
 /* ANNEAL */
-/* ANNEAL */            if (it < fs_num_cooling_iterations)
+/* ANNEAL */            if (it < cluster_options_ptr->num_cooling_iterations)
 /* ANNEAL */            {
 /* ANNEAL */                (*annealed_log_prob_ptr) *= temperature;
 /* ANNEAL */            }
@@ -7372,7 +8122,7 @@ once_more:
             CHECK_FOR_HEAP_OVERRUNS();
 #endif
 
-            if (    (fs_use_specified_clusters)
+            if (    (cluster_options_ptr->use_specified_clusters)
                  && (data_ptr->group_vp != NULL)
                )
             {
@@ -7405,7 +8155,7 @@ once_more:
 
                     cluster = (cluster_index_ptr == NULL) ? cluster_index : cluster_index_ptr[ cluster_index ];
 
-                    if (    (fs_use_specified_clusters)
+                    if (    (cluster_options_ptr->use_specified_clusters)
                          && (data_ptr->group_vp != NULL)
                        )
                     {
@@ -7533,7 +8283,7 @@ once_more:
 #endif
                     if (options_ptr->model_correspondence == 1)
                     {
-                        if (fs_pair_depend)
+                        if (cluster_options_ptr->pair_depend)
                         {
                                                /* FIX */
                             UNTESTED_CODE();   /* Will be broken for cases other than word depends on blob. */
@@ -7603,7 +8353,7 @@ once_more:
                                     {
                                         if (model_ptr->norm_depend)
                                         {
-                                            if (fs_max_depend)
+                                            if (cluster_options_ptr->max_depend)
                                             {
                                                 nu_based_on_pairs_vp->elements[ level ] =
                                                     MAX_OF(nu_based_on_pairs_vp->elements[ level ],
@@ -7616,7 +8366,7 @@ once_more:
                                         }
                                         else
                                         {
-                                            if (fs_max_depend)
+                                            if (cluster_options_ptr->max_depend)
                                             {
                                                 nu_based_on_pairs_vp->elements[ level ] =
                                                     MAX_OF(nu_based_on_pairs_vp->elements[ level ],
@@ -7633,7 +8383,7 @@ once_more:
                         }
                         else
                         {
-                            if ((fs_use_blob_prior) && (blob_word_prior_mvp != NULL))
+                            if ((cluster_options_ptr->use_blob_prior) && (blob_word_prior_mvp != NULL))
                             {
                                 result = get_zero_matrix(&nu_with_prior_mp,
                                                          num_levels, num_con_items);
@@ -7712,11 +8462,11 @@ once_more:
 
                                 for (level = first_level; level < last_level_num; level++)
                                 {
-                                    if ((fs_use_blob_prior) && (blob_word_prior_mvp != NULL))
+                                    if ((cluster_options_ptr->use_blob_prior) && (blob_word_prior_mvp != NULL))
                                     {
                                         if (model_ptr->norm_depend) /* Usually true, might not make a difference. */
                                         {
-                                            if (fs_max_depend) /* Usually false. */
+                                            if (cluster_options_ptr->max_depend) /* Usually false. */
                                             {
                                                 nu_with_prior_mp->elements[ level ][ con_item ] =
                                                     MAX_OF(nu_with_prior_mp->elements[ level ][ con_item ],
@@ -7730,7 +8480,7 @@ once_more:
                                         }
                                         else
                                         {
-                                            if (fs_max_depend) /* Usually false. */
+                                            if (cluster_options_ptr->max_depend) /* Usually false. */
                                             {
                                                 nu_with_prior_mp->elements[ level ][ con_item ] =
                                                     MAX_OF(nu_with_prior_mp->elements[ level ][ con_item ],
@@ -7747,7 +8497,7 @@ once_more:
                                     {
                                         if (model_ptr->norm_depend) /* Usually true, might not make a difference. */
                                         {
-                                            if (fs_max_depend) /* Usually false. */
+                                            if (cluster_options_ptr->max_depend) /* Usually false. */
                                             {
                                                 nu_for_dependent_model_vp->elements[ level ] =
                                                     MAX_OF(nu_for_dependent_model_vp->elements[ level ],
@@ -7761,7 +8511,7 @@ once_more:
                                         }
                                         else
                                         {
-                                            if (fs_max_depend) /* Usually false. */
+                                            if (cluster_options_ptr->max_depend) /* Usually false. */
                                             {
                                                 nu_for_dependent_model_vp->elements[ level ] =
                                                     MAX_OF(nu_for_dependent_model_vp->elements[ level ],
@@ -7778,7 +8528,7 @@ once_more:
                             }
                         }
 
-                        if (fs_double_depend)   /* Usually false, perhaps a dead option. */
+                        if (cluster_options_ptr->double_depend)   /* Usually false, perhaps a dead option. */
                         {
                                                /* FIX */
                             UNTESTED_CODE();   /* Will be broken for cases other than word depends on blob. */
@@ -7842,7 +8592,7 @@ once_more:
 
                             }
 
-                            if (fs_multiply_vertical_depend_weights)
+                            if (cluster_options_ptr->multiply_vertical_depend_weights)
                             {
                                 double temp_sum = 0;
 
@@ -7908,13 +8658,13 @@ once_more:
                         for (level = first_level; level < last_level_num; level++)
                         {
                             if (    (options_ptr->model_correspondence == 1)
-                                 && (fs_pair_depend)
+                                 && (cluster_options_ptr->pair_depend)
                                )
                             {
                                 log_nu = log(nu_based_on_pairs_vp->elements[ level ]);
                             }
                             else if (    (options_ptr->model_correspondence == 1)
-                                      && (fs_double_depend)
+                                      && (cluster_options_ptr->double_depend)
                                     )
                             {
                                 log_nu = log(nu_based_on_dis_items_vp->elements[ level ]);
@@ -7959,12 +8709,12 @@ once_more:
                                           + log(P_i_n_mvp->elements[ level ]->elements[ node ][ category ])
                                           - log((double)num_dis_items);
 
-                                    if (fs_trim_hack == 1)
+                                    if (cluster_options_ptr->trim_hack == 1)
                                     {
                                         (con_score_mp->elements[ con_item ][ i ]) += log_a;
                                         dbw();   /* Suspect! */
                                     }
-                                    else if (fs_trim_hack == 2)
+                                    else if (cluster_options_ptr->trim_hack == 2)
                                     {
                                         (con_score_mp->elements[ con_item ][ i ]) += log(P_c_p_mp->elements[ point ][ cluster ]);
                                     }
@@ -8102,7 +8852,7 @@ once_more:
                         ASSERT_IS_FINITE_DBL(log_prob_sum);
 
 #ifdef XXX_SUPPORT_TRIMMING
-                        if (fs_trim_mach_two)
+                        if (cluster_options_ptr->trim_mach_two)
                         {
                             if (    ( ! apply_score_cutoff)
                                  || (con_score_vp->elements[ con_item_count + con_item ] > con_score_cutoff)
@@ -8157,7 +8907,7 @@ once_more:
                     }
 
 #ifdef XXX_SUPPORT_TRIMMING
-                    if (fs_trim_mach_two)
+                    if (cluster_options_ptr->trim_mach_two)
                     {
                         /*
                         // FIX
@@ -8244,7 +8994,7 @@ once_more:
 #endif
                         dis_item_multiplicity = dis_item_multiplicity_mp->elements[ point ][ dis_item ];
 
-                        if ((fs_use_blob_prior) && (blob_word_prior_mvp != NULL))
+                        if ((cluster_options_ptr->use_blob_prior) && (blob_word_prior_mvp != NULL))
                         {
                             result = get_matrix_col(&word_prior_vp,
                                                     blob_word_prior_mvp->elements[ point ],
@@ -8281,7 +9031,7 @@ once_more:
                                 nu = nu_with_prior_vp->elements[ level ];
                             }
                             else if (    (options_ptr->model_correspondence == 1)
-                                      && (fs_pair_depend)
+                                      && (cluster_options_ptr->pair_depend)
                                     )
                             {
                                 nu = nu_based_on_pairs_vp->elements[ level ];
@@ -8324,11 +9074,11 @@ once_more:
                                           + con_prob_cache_vvvp->elements[ con_item ]->elements[ level ]->elements[ node ]
                                           - log((double)num_con_items);
 
-                                    if (fs_trim_hack == 1)
+                                    if (cluster_options_ptr->trim_hack == 1)
                                     {
                                         (dis_score_mp->elements[ dis_item ][ i ]) += log_a;
                                     }
-                                    else if (fs_trim_hack == 2)
+                                    else if (cluster_options_ptr->trim_hack == 2)
                                     {
                                         (dis_score_mp->elements[ dis_item ][ i ]) += log(P_c_p_mp->elements[ point ][ cluster ]);
                                     }
@@ -8341,7 +9091,7 @@ once_more:
                             level_indicators_pp = level_indicators_ppp[ level ];
 
 #ifdef SUPPORT_ANNEALING
-    /* ANNEAL */            if (it < fs_num_cooling_iterations)
+    /* ANNEAL */            if (it < cluster_options_ptr->num_cooling_iterations)
     /* ANNEAL */            {
     /* ANNEAL */                annealed_prob = pow(prob, temperature);
     /* ANNEAL */                annealed_nu_times_prob = nu * annealed_prob;
@@ -8462,7 +9212,7 @@ once_more:
                         }
 
 #ifdef XXX_SUPPORT_TRIMMING
-                        if (fs_trim_mach_two)
+                        if (cluster_options_ptr->trim_mach_two)
                         {
                             if (    ( ! apply_score_cutoff)
                                  || (dis_score_vp->elements[ dis_item_count + dis_item ] > dis_score_cutoff)
@@ -8495,7 +9245,7 @@ once_more:
 
 
 #ifdef XXX_SUPPORT_TRIMMING
-                    if (fs_trim_mach_two)
+                    if (cluster_options_ptr->trim_mach_two)
                     {
                         if (num_good_dis_items > 0)
                         {
@@ -8524,7 +9274,7 @@ once_more:
                          */
                         if (    (options_ptr->model_correspondence == 0)
                              && (max_num_con_items > 0)
-                             && (it < fs_min_it_for_dis_items)
+                             && (it < cluster_options_ptr->min_it_for_dis_items)
                            )
                         {
                             /*EMPTY*/
@@ -8563,7 +9313,7 @@ once_more:
                     ASSERT_IS_FINITE_DBL(log_p);
 
 #ifdef XXX_SUPPORT_TRIMMING
-                    if (fs_trim_mach_two)
+                    if (cluster_options_ptr->trim_mach_two)
                     {
                         if (num_good_dis_items + num_good_con_items > 0)
                         {
@@ -8583,7 +9333,7 @@ once_more:
 #endif
 
 #ifdef XXX_SUPPORT_TRIMMING
-                    if (fs_trim_mach_two)
+                    if (cluster_options_ptr->trim_mach_two)
                     {
 #ifdef SUPPORT_ANNEALING
                         BARF  /* not done */
@@ -8697,7 +9447,7 @@ once_more:
 
                     cluster = (cluster_index_ptr == NULL) ? cluster_index : cluster_index_ptr[ cluster_index ];
 
-                    if (    (fs_use_specified_clusters)
+                    if (    (cluster_options_ptr->use_specified_clusters)
                          && (data_ptr->group_vp != NULL)
                        )
                     {
@@ -8974,15 +9724,15 @@ once_more:
                                 ASSERT_IS_NON_NEGATIVE_DBL(level_sum);
                             }
 
-                            if (fs_sample_hack == 0)
+                            if (cluster_options_ptr->sample_hack == 0)
                             {
                                 prob_sum += level_sum;
                             }
-                            else if (fs_sample_hack == 1)
+                            else if (cluster_options_ptr->sample_hack == 1)
                             {
                                 prob_sum += level_sum * a_vp->elements[ cluster ];
                             }
-                            else if (fs_sample_hack == 2)
+                            else if (cluster_options_ptr->sample_hack == 2)
                             {
                                 prob_sum += level_sum * P_c_p_mp->elements[ point ][ cluster ];
                             }
@@ -9040,7 +9790,7 @@ once_more:
                                           || (it <= options_ptr->last_sample)
                                         ),
                                      num_nulls,
-                                     fs_duplicate_words_for_matching);
+                                     cluster_options_ptr->duplicate_words_for_matching);
 
                 log_pair_probs_mp->num_rows = max_num_con_items;
                 log_pair_probs_mp->num_cols = max_num_dis_items;
@@ -9246,7 +9996,7 @@ once_more:
                         ASSERT_IS_GREATER_DBL(con_max_log_prob, DBL_MOST_NEGATIVE / 100.0);
 
 #ifdef XXX_SUPPORT_TRIMMING
-                        if (fs_trim_mach_two)
+                        if (cluster_options_ptr->trim_mach_two)
                         {
                             if (    ( ! apply_score_cutoff)
                                  || (    (dis_score_vp->elements[ dis_item_count + dis_item ] > dis_score_cutoff)
@@ -9279,7 +10029,7 @@ once_more:
                     // in the computation of ll_con_correction_norm_sum.
                     */
 #ifdef XXX_SUPPORT_TRIMMING
-                    if (fs_trim_mach_two)
+                    if (cluster_options_ptr->trim_mach_two)
                     {
                         if (num_good_pairs > 0)
                         {
@@ -9376,7 +10126,7 @@ once_more:
                     }
 
 #ifdef XXX_SUPPORT_TRIMMING
-                    if (fs_trim_mach_two)
+                    if (cluster_options_ptr->trim_mach_two)
                     {
                         if (num_good_pairs > 0)
                         {
@@ -9434,7 +10184,7 @@ once_more:
 
                     cluster = (cluster_index_ptr == NULL) ? cluster_index : cluster_index_ptr[ cluster_index ];
 
-                    if (    (fs_use_specified_clusters)
+                    if (    (cluster_options_ptr->use_specified_clusters)
                          && (data_ptr->group_vp != NULL)
                        )
                     {
@@ -9685,7 +10435,7 @@ once_more:
                                          && (    (options_ptr->last_sample < 0)
                                               || (it <= options_ptr->last_sample)),
                                          num_nulls,
-                                         fs_duplicate_words_for_matching);
+                                         cluster_options_ptr->duplicate_words_for_matching);
 
                     if (result == ERROR) { NOTE_ERROR(); break; }
 
@@ -9796,7 +10546,7 @@ once_more:
                         log_prob_sum = log(prob_sum) + con_max_log_prob;
 
 #ifdef XXX_SUPPORT_TRIMMING
-                        if (fs_trim_mach_two)
+                        if (cluster_options_ptr->trim_mach_two)
                         {
                             if (    ( ! apply_score_cutoff)
                                  || (    (dis_score_vp->elements[ dis_item_count + dis_item ] > dis_score_cutoff)
@@ -9829,7 +10579,7 @@ once_more:
                     // the likelihood for con_log_norm needs to change also.
                     */
 #ifdef XXX_SUPPORT_TRIMMING
-                    if (fs_trim_mach_two)
+                    if (cluster_options_ptr->trim_mach_two)
                     {
                         if (num_good_pairs > 0)
                         {
@@ -10089,11 +10839,11 @@ once_more:
 
                             log_pair_prob = log_pair_probs_mp->elements[ con_item ][ dis_item ];
 
-                            if (fs_trim_hack == 1)
+                            if (cluster_options_ptr->trim_hack == 1)
                             {
                                 log_pair_prob += log_a;
                             }
-                            else if (fs_trim_hack == 2)
+                            else if (cluster_options_ptr->trim_hack == 2)
                             {
                                 log_pair_prob += log(P_c_p_mp->elements[ point ][ cluster ]);
                             }
@@ -10153,7 +10903,7 @@ once_more:
 #endif
 
 #ifdef XXX_SUPPORT_TRIMMING
-                    if (fs_trim_mach_two)
+                    if (cluster_options_ptr->trim_mach_two)
                     {
                         if (num_good_pairs > 0)
                         {
@@ -10216,7 +10966,7 @@ once_more:
                     int num_good_pairs = 0;
 #endif
 
-                    if (    (fs_use_specified_clusters)
+                    if (    (cluster_options_ptr->use_specified_clusters)
                          && (data_ptr->group_vp != NULL)
                        )
                     {
@@ -10552,7 +11302,7 @@ once_more:
 
                     cluster = (cluster_index_ptr == NULL) ? cluster_index : cluster_index_ptr[ cluster_index ];
 
-                    if (    (fs_use_specified_clusters)
+                    if (    (cluster_options_ptr->use_specified_clusters)
                          && (data_ptr->group_vp != NULL)
                        )
                     {
@@ -10831,7 +11581,7 @@ once_more:
                 */
                 Int_matrix* concept_for_pair_probs_mp = NULL;
                 int block;
-                int num_blocks = (last_level_num - first_level) / fs_discrete_tie_count;
+                int num_blocks = (last_level_num - first_level) / cluster_options_ptr->discrete_tie_count;
                 Matrix_vector* con_item_merge_prior_mvp = data_ptr->con_item_merge_prior_mvp;
                 Matrix* con_item_merge_prior_mp = (con_item_merge_prior_mvp == NULL) ? NULL :  con_item_merge_prior_mvp->elements[ point ];
 
@@ -10952,9 +11702,9 @@ once_more:
                         {
                             max_log_prob = DBL_MOST_NEGATIVE;
 
-                            for (i = 0; i < fs_discrete_tie_count; i++)
+                            for (i = 0; i < cluster_options_ptr->discrete_tie_count; i++)
                             {
-                                level = first_level + block * fs_discrete_tie_count + i;
+                                level = first_level + block * cluster_options_ptr->discrete_tie_count + i;
 
                                 log_prob = con_prob_cache_vvp->elements[ level ]->elements[ 0 ];
                                 ASSERT_IS_NUMBER_DBL(log_prob);
@@ -10969,9 +11719,9 @@ once_more:
 
                             prob_sum = 0;
 
-                            for (i = 0; i < fs_discrete_tie_count; i++)
+                            for (i = 0; i < cluster_options_ptr->discrete_tie_count; i++)
                             {
-                                level = first_level + block * fs_discrete_tie_count + i;
+                                level = first_level + block * cluster_options_ptr->discrete_tie_count + i;
 
                                 prob = exp(log_prob_vp->elements[ level ] - max_log_prob);
                                 ASSERT_IS_NUMBER_DBL(prob);
@@ -11031,7 +11781,7 @@ once_more:
 
                 if (result == ERROR) { NOTE_ERROR(); break; }
 
-                if ((! fs_one_to_one_match) && (num_con_items > num_dis_items))
+                if ((! cluster_options_ptr->one_to_one_match) && (num_con_items > num_dis_items))
                 {
                     Int_vector* dis_item_for_con_item_vp = NULL;
 
@@ -11080,9 +11830,9 @@ once_more:
                             category = dis_item_mp->elements[ point ][ dis_item ];
                             block = concept_for_pair_probs_mp->elements[ con_item ][ dis_item ];
 
-                            for (i = 0; i < fs_discrete_tie_count; i++)
+                            for (i = 0; i < cluster_options_ptr->discrete_tie_count; i++)
                             {
-                                level = first_level + block * fs_discrete_tie_count + i;
+                                level = first_level + block * cluster_options_ptr->discrete_tie_count + i;
 
                                 log_prob = con_prob_cache_vvp->elements[ level ]->elements[ 0 ];
                                 ASSERT_IS_NUMBER_DBL(log_prob);
@@ -11097,9 +11847,9 @@ once_more:
 
                             prob_sum = 0;
 
-                            for (i = 0; i < fs_discrete_tie_count; i++)
+                            for (i = 0; i < cluster_options_ptr->discrete_tie_count; i++)
                             {
-                                level = first_level + block * fs_discrete_tie_count + i;
+                                level = first_level + block * cluster_options_ptr->discrete_tie_count + i;
 
                                 prob = exp(log_prob_vp->elements[ level ] - max_log_prob);
                                 ASSERT_IS_NUMBER_DBL(prob);
@@ -11134,7 +11884,7 @@ once_more:
                     {
                         int best_dis_item = NOT_SET;
                         int best_con_item = NOT_SET;
-                        int enforce_contiguous = (fs_use_contiguous_assignment && con_item_merge_prior_mp != NULL);
+                        int enforce_contiguous = (cluster_options_ptr->use_contiguous_assignment && con_item_merge_prior_mp != NULL);
                         int num_tries = enforce_contiguous ? 2 : 1;
                         int try_count = 0;
                         double contig_factor = 1.0;
@@ -11237,9 +11987,9 @@ once_more:
 
                     log_prob_sum = 0;
 
-                    for (i = 0; i < fs_discrete_tie_count; i++)
+                    for (i = 0; i < cluster_options_ptr->discrete_tie_count; i++)
                     {
-                        level = first_level + block * fs_discrete_tie_count + i;
+                        level = first_level + block * cluster_options_ptr->discrete_tie_count + i;
 
                         log_prob = log_nu_vp->elements[ level ];
                         log_prob += con_prob_cache_vvp->elements[ level ]->elements[ 0 ];
@@ -11249,18 +11999,18 @@ once_more:
 
                     prob_sum = 0;
 
-                    for (i = 0; i < fs_discrete_tie_count; i++)
+                    for (i = 0; i < cluster_options_ptr->discrete_tie_count; i++)
                     {
-                        level = first_level + block * fs_discrete_tie_count + i;
+                        level = first_level + block * cluster_options_ptr->discrete_tie_count + i;
 
                         prob = exp(log_prob_vp->elements[ level ] - max_log_prob);
                         prob_sum += prob;
                         prob_vp->elements[ level ] = prob;
                     }
 
-                    for (i = 0; i < fs_discrete_tie_count; i++)
+                    for (i = 0; i < cluster_options_ptr->discrete_tie_count; i++)
                     {
-                        level = first_level + block * fs_discrete_tie_count + i;
+                        level = first_level + block * cluster_options_ptr->discrete_tie_count + i;
 
                         level_indicators_p = level_indicators_ppp[ level ][ 0 ];
 
@@ -11286,7 +12036,7 @@ once_more:
 
                     if (prob_sum < 0.5)
                     {
-                        ASSERT((num_dis_items > num_con_items) || ((fs_one_to_one_match) && (num_dis_items < num_con_items)));
+                        ASSERT((num_dis_items > num_con_items) || ((cluster_options_ptr->one_to_one_match) && (num_dis_items < num_con_items)));
                         continue;
                     }
 
@@ -11493,7 +12243,7 @@ once_more:
             for (cluster_index = 0; cluster_index < num_clusters_used; cluster_index++)
             {
 #ifdef XXX_SUPPORT_TRIMMING
-                if (fs_trim_mach_two)
+                if (cluster_options_ptr->trim_mach_two)
                 {
                     if (ll_P_c_p_vp->elements[ cluster_index ] > DBL_MOST_NEGATIVE /2.0)
                     {
@@ -11512,7 +12262,7 @@ once_more:
             for (cluster_index = 0; cluster_index < num_clusters_used; cluster_index++)
             {
 #ifdef XXX_SUPPORT_TRIMMING
-                if (fs_trim_mach_two)
+                if (cluster_options_ptr->trim_mach_two)
                 {
                     if (ll_P_c_p_vp->elements[ cluster_index ] > DBL_MOST_NEGATIVE /2.0)
                     {
@@ -11534,7 +12284,7 @@ once_more:
             if (sum < 5.0 * DBL_MIN)
             {
 #ifdef XXX_SUPPORT_TRIMMING
-                if (fs_trim_mach_two)
+                if (cluster_options_ptr->trim_mach_two)
                 {
                     fit = 0.0;
                 }
@@ -11575,7 +12325,7 @@ once_more:
             for (cluster_index = 0; cluster_index < num_clusters_used; cluster_index++)
             {
 #ifdef XXX_SUPPORT_TRIMMING
-                if (fs_trim_mach_two)
+                if (cluster_options_ptr->trim_mach_two)
                 {
                     if (P_c_p_vp->elements[ cluster_index ] > DBL_MOST_NEGATIVE /2.0)
                     {
@@ -11594,7 +12344,7 @@ once_more:
             for (cluster_index = 0; cluster_index < num_clusters_used; cluster_index++)
             {
 #ifdef XXX_SUPPORT_TRIMMING
-                if (fs_trim_mach_two)
+                if (cluster_options_ptr->trim_mach_two)
                 {
                     if (P_c_p_vp->elements[ cluster_index ] > DBL_MOST_NEGATIVE /2.0)
                     {
@@ -11618,7 +12368,7 @@ once_more:
             for (cluster_index = 0; cluster_index < num_clusters_used; cluster_index++)
             {
 #ifdef XXX_SUPPORT_TRIMMING
-                if (fs_trim_mach_two)
+                if (cluster_options_ptr->trim_mach_two)
                 {
                     if (P_c_p_vp->elements[ cluster_index ] > DBL_MOST_NEGATIVE /2.0)
                     {
@@ -11665,7 +12415,7 @@ once_more:
             result = ow_scale_vector_by_sum_2(P_c_p_vp, (double*)NULL);
             if (result == ERROR) { NOTE_ERROR(); break; }
 
-            if (fs_sample_count > 0)
+            if (cluster_options_ptr->sample_count > 0)
             {
                 int count;
                 Vector* cum_P_c_p_vp = NULL;
@@ -11700,7 +12450,7 @@ once_more:
                 /* Force to 1.0 to deal with round off error. */
                 cum_P_c_p_vp->elements[ num_clusters - 1 ] = 1.0;
 
-                for (count = 0; count < fs_sample_count; count++)
+                for (count = 0; count < cluster_options_ptr->sample_count; count++)
                 {
                     double r = kjb_rand();
 
@@ -11793,7 +12543,7 @@ v_step:
 #ifdef SUPPORT_NUM_CLUSTER_SWITCH     /* Not finished. Should it be? */
             if (    (result != ERROR)
                  && (it == 3)   /* HERE */
-                 && ( ! fs_use_specified_clusters)
+                 && ( ! cluster_options_ptr->use_specified_clusters)
                  && (last_level_num == (num_levels - 1))
                  && (num_levels >= 2)
                  && (level_counts_vp->elements[ num_levels - 2 ] == 1)
@@ -11874,7 +12624,7 @@ v_step:
 
             for (cluster_index = 0; cluster_index < num_clusters_used; cluster_index++)
             {
-                if (    (fs_use_specified_clusters)
+                if (    (cluster_options_ptr->use_specified_clusters)
                      && (data_ptr->group_vp != NULL)
                    )
                 {
@@ -11990,7 +12740,7 @@ v_step:
                         ASSERT_IS_PROB_DBL(*level_indicators_p);
 #ifdef MIN_LEVEL_INDICATOR
 #ifdef TEST
-                        if (! fs_use_specified_clusters)
+                        if (! cluster_options_ptr->use_specified_clusters)
                         {
                             ASSERT_IS_NOT_LESS_DBL(*level_indicators_p,
                                                   MIN_LEVEL_INDICATOR / 2.0);
@@ -12007,7 +12757,7 @@ v_step:
 
 #ifdef MIN_LEVEL_INDICATOR
 #ifdef TEST
-                        if (! fs_use_specified_clusters)
+                        if (! cluster_options_ptr->use_specified_clusters)
                         {
                             ASSERT_IS_NOT_LESS_DBL(*level_indicators_p,
                                                   MIN_HORIZONTAL_INDICATOR * MIN_LEVEL_INDICATOR / 4.0);
@@ -12095,7 +12845,7 @@ v_step:
                     ASSERT_IS_NON_NEGATIVE_INT(cluster_index);
                     ASSERT_IS_LESS_INT(cluster_index , num_clusters);
 
-                    if (    (fs_use_specified_clusters)
+                    if (    (cluster_options_ptr->use_specified_clusters)
                          && (data_ptr->group_vp != NULL)
                        )
                     {
@@ -12264,7 +13014,7 @@ v_step:
                         // Multiplying does not make much sense because there
                         // are then two nu's in the product!
                         */
-                        if (fs_multiply_vertical_prior_weights)
+                        if (cluster_options_ptr->multiply_vertical_prior_weights)
                         {
                             sum = dis_sum * con_sum;
                         }
@@ -12349,7 +13099,7 @@ v_step:
                         ASSERT_IS_NON_NEGATIVE_INT(cluster_index);
                         ASSERT_IS_LESS_INT(cluster_index , num_clusters);
 
-                        if (    (fs_use_specified_clusters)
+                        if (    (cluster_options_ptr->use_specified_clusters)
                              && (data_ptr->group_vp != NULL)
                            )
                         {
@@ -12514,7 +13264,7 @@ v_step:
                         // Multiplying does not make much sense because there
                         // are then two nu's in the product!
                         */
-                        if (fs_multiply_vertical_prior_weights)
+                        if (cluster_options_ptr->multiply_vertical_prior_weights)
                         {
                             sum = dis_sum * con_sum;
                         }
@@ -12595,7 +13345,7 @@ v_step:
                 {
                     cluster = (cluster_index_ptr == NULL) ? cluster_index : cluster_index_ptr[ cluster_index ];
 
-                    if (    (fs_use_specified_clusters)
+                    if (    (cluster_options_ptr->use_specified_clusters)
                          && (data_ptr->group_vp != NULL)
                        )
                     {
@@ -12723,7 +13473,7 @@ v_step:
                         // Multiplying does not make much sense because there
                         // are then two nu's in the product!
                         */
-                        if (fs_multiply_vertical_prior_weights)
+                        if (cluster_options_ptr->multiply_vertical_prior_weights)
                         {
                             new_V_mp->elements[ level ][ cluster ] += (dis_sum * con_sum) * point_weight;
                         }
@@ -12774,7 +13524,7 @@ v_step:
             {
                 cluster = (cluster_index_ptr == NULL) ? cluster_index : cluster_index_ptr[ cluster_index ];
 
-                if (    (fs_use_specified_clusters)
+                if (    (cluster_options_ptr->use_specified_clusters)
                      && (data_ptr->group_vp != NULL)
                    )
                 {
@@ -12814,7 +13564,7 @@ v_step:
                     {
                         cluster = (cluster_index_ptr == NULL) ? cluster_index : cluster_index_ptr[ cluster_index ];
 
-                        if (    (fs_use_specified_clusters)
+                        if (    (cluster_options_ptr->use_specified_clusters)
                              && (data_ptr->group_vp != NULL)
                            )
                         {
@@ -12958,7 +13708,7 @@ v_step:
 
                         cluster  = (cluster_index_ptr == NULL) ? cluster_index : cluster_index_ptr[ cluster_index ];
 
-                        if (    (fs_use_specified_clusters)
+                        if (    (cluster_options_ptr->use_specified_clusters)
                              && (data_ptr->group_vp != NULL)
                            )
                         {
@@ -13212,7 +13962,7 @@ v_step:
                  && (num_clusters_used != num_limited_clusters)
                )
             {
-                result = get_limited_cluster_membership(cluster_index_mp, P_c_p_vp,
+                result = get_limited_cluster_membership(cache_ptr, cluster_index_mp, P_c_p_vp,
                                                         point, num_limited_clusters,
                                                         &limited_cluster_error);
                 if (result == ERROR) { NOTE_ERROR(); break; }
@@ -13282,7 +14032,7 @@ v_step:
 
         if (log_likelihood < DBL_HALF_MOST_NEGATIVE/2.0) break;
 
-        if (fs_norm_con_prob)
+        if (cluster_options_ptr->norm_con_prob)
         {
             log_likelihood += con_log_norm * ll_con_correction_norm_sum;
             model_ptr->con_log_norm = con_log_norm;
@@ -13296,7 +14046,7 @@ v_step:
         /*
         // Calculate log prior to make log_likelihood into log posterior.
         */
-        if (fs_do_map && (max_num_dis_items > 0))
+        if (cluster_options_ptr->do_map && (max_num_dis_items > 0))
         {
             for (level = first_level; level < last_level_num; level++)
             {
@@ -13321,7 +14071,7 @@ v_step:
 
         if (log_likelihood < DBL_HALF_MOST_NEGATIVE/2.0) break;
 
-        if (fs_do_map && (max_num_con_items > 0))
+        if (cluster_options_ptr->do_map && (max_num_con_items > 0))
         {
             if (result == ERROR) { NOTE_ERROR(); break; }
 
@@ -13357,7 +14107,7 @@ v_step:
                     result = get_malhalanobis_distance_sqrd(u_vp, w_vp, var_vp, &d);
                     if (result == ERROR) { NOTE_ERROR(); break; }
 
-                    log_likelihood -= (fs_map_kappa * d / 2.0);
+                    log_likelihood -= (cluster_options_ptr->map_kappa * d / 2.0);
 
                     log_likelihood -= (map_r_minus_n_g * con_log_sqrt_det_vvp->elements[ level ]->elements[ node ]);
 
@@ -13430,7 +14180,7 @@ v_step:
                                               con_feature_enable_vp,
                                               con_feature_group_vp,
                                               min_con_log_prob,
-                                              fs_max_con_norm_var,
+                                              cluster_options_ptr->max_con_norm_var,
                                               con_score_cutoff,
                                               model_ptr->weight_con_items,
                                               model_ptr->norm_depend,
@@ -13439,13 +14189,14 @@ v_step:
                                               (const Int_vector*)NULL,
                                               held_out_dis_factor_vp,
                                               held_out_con_factor_vp,
-                                              fs_norm_continuous_features,
+                                              cluster_options_ptr->norm_continuous_features,
                                               MAX_OF(ll_rel_diff,
-                                                     fs_iteration_tolerance),
+                                                     cluster_options_ptr->iteration_tolerance),
                                               held_out_prev_log_likelihood,
                                               &held_out_log_likelihood,
                                               (const Matrix*)NULL,
-                                              FALSE, NULL);
+                                              FALSE, NULL,
+                                              cluster_options_ptr, cache_ptr);
 #else
             result = get_cluster_membership_2((Matrix**)NULL,
                                               (Matrix_vector**) NULL,
@@ -13465,7 +14216,7 @@ v_step:
                                               con_feature_enable_vp,
                                               con_feature_group_vp,
                                               min_con_log_prob,
-                                              fs_max_con_norm_var,
+                                              cluster_options_ptr->max_con_norm_var,
                                               con_score_cutoff,
                                               model_ptr->weight_con_items,
                                               model_ptr->norm_depend,
@@ -13474,13 +14225,14 @@ v_step:
                                               (const Int_vector*)NULL,
                                               held_out_dis_factor_vp,
                                               held_out_con_factor_vp,
-                                              fs_norm_continuous_features,
+                                              cluster_options_ptr->norm_continuous_features,
                                               MAX_OF(ll_rel_diff,
-                                                     fs_iteration_tolerance),
+                                                     cluster_options_ptr->iteration_tolerance),
                                               held_out_prev_log_likelihood,
                                               &held_out_log_likelihood,
                                               (const Matrix*)NULL,
-                                              FALSE, NULL);
+                                              FALSE, NULL,
+                                              cluster_options_ptr, cache_ptr);
 #endif
 
             if (result == ERROR) { NOTE_ERROR(); break; }
@@ -13523,7 +14275,7 @@ v_step:
             }
         }
 
-        if ((fs_norm_con_prob) && (ABS_OF(max_con_log_prob) > 1.0))
+        if ((cluster_options_ptr->norm_con_prob) && (ABS_OF(max_con_log_prob) > 1.0))
         {
 #ifdef XXX_SUPPORT_TRIMMING
 #ifdef DEBUG_TRIMMING
@@ -13676,32 +14428,32 @@ loop_cleanup:
 /* TEST */  }
 #endif
 
-            if ((fs_discrete_tie_count > 1) && (num_clusters == 1))
+            if ((cluster_options_ptr->discrete_tie_count > 1) && (num_clusters == 1))
             {
                 Vector* ave_P_i_n_vp = NULL;
                 int block;
-                int num_blocks = (last_level_num - first_level) / fs_discrete_tie_count;
+                int num_blocks = (last_level_num - first_level) / cluster_options_ptr->discrete_tie_count;
 
                 for (block = 0; block < num_blocks; block++)
                 {
                     result = get_zero_vector(&ave_P_i_n_vp, num_categories);
                     if (result == ERROR) { NOTE_ERROR(); break; }
 
-                    for (i = 0; i < fs_discrete_tie_count; i++)
+                    for (i = 0; i < cluster_options_ptr->discrete_tie_count; i++)
                     {
-                        level = first_level + block * fs_discrete_tie_count + i;
+                        level = first_level + block * cluster_options_ptr->discrete_tie_count + i;
 
                         result = ow_add_matrix_row_to_vector(ave_P_i_n_vp,
                                                              new_P_i_n_mvp->elements[ level ],
                                                              0);
                     }
 
-                    result = ow_divide_vector_by_scalar(ave_P_i_n_vp, fs_discrete_tie_count);
+                    result = ow_divide_vector_by_scalar(ave_P_i_n_vp, cluster_options_ptr->discrete_tie_count);
                     if (result == ERROR) { NOTE_ERROR(); break; }
 
-                    for (i = 0; i < fs_discrete_tie_count; i++)
+                    for (i = 0; i < cluster_options_ptr->discrete_tie_count; i++)
                     {
-                        level = first_level + block * fs_discrete_tie_count + i;
+                        level = first_level + block * cluster_options_ptr->discrete_tie_count + i;
 
                         result = put_matrix_row(new_P_i_n_mvp->elements[ level ],
                                                 ave_P_i_n_vp,
@@ -13733,7 +14485,7 @@ loop_cleanup:
                 // The first time through we compute the ML estimate which is
                 // used as the prior on subsequent iterations.
                 */
-                if ((fs_do_map) && (omega_mvp->elements[ level ] == NULL))
+                if ((cluster_options_ptr->do_map) && (omega_mvp->elements[ level ] == NULL))
                 {
 #ifdef OMEGA_INITIALIZATION_IS_FIRST_ML
                     ASSERT(delta_inverse_mvp->elements[ level ] == NULL);
@@ -13821,12 +14573,12 @@ loop_cleanup:
 #endif
                 }
 
-                if (fs_do_map)
+                if (cluster_options_ptr->do_map)
                 {
                     omega_mp = omega_mvp->elements[ level ];
 
                     result = ow_add_matrix_times_scalar(mean_mp, omega_mp,
-                                                        fs_map_kappa);
+                                                        cluster_options_ptr->map_kappa);
                 }
 
                 for (node = 0; node < num_nodes_this_level; node++)
@@ -13837,9 +14589,9 @@ loop_cleanup:
 
                     s = P_sum_vp->elements[ node ];
 
-                    if (fs_do_map)
+                    if (cluster_options_ptr->do_map)
                     {
-                        s += fs_map_kappa;
+                        s += cluster_options_ptr->map_kappa;
                     }
 
                     ASSERT_IS_NUMBER_DBL(s);
@@ -13917,14 +14669,14 @@ loop_cleanup:
                             var = 0.0;
                         }
 
-                        if (fs_do_map)
+                        if (cluster_options_ptr->do_map)
                         {
                             var += delta_inverse_mp->elements[ node ][ con_feature ];
 
                             temp = omega_mp->elements[ node ][ con_feature ] -
                                                 mean_mp->elements[ node ][ con_feature ];
 
-                            var += fs_map_kappa * temp * temp;
+                            var += cluster_options_ptr->map_kappa * temp * temp;
                         }
 
                         var_mp->elements[ node ][ con_feature ] = var;
@@ -13934,7 +14686,7 @@ loop_cleanup:
                         ASSERT_IS_NON_NEGATIVE_DBL(var);
                     }
 
-                    if (fs_do_map)
+                    if (cluster_options_ptr->do_map)
                     {
                         s += (map_r_minus_n_g_vp->elements[ level ]);
                     }
@@ -13955,7 +14707,7 @@ loop_cleanup:
                     result = ow_add_scalar_to_matrix_row(var_mp, var_offset, node);
                     if (result == ERROR) { NOTE_ERROR(); break; }
 
-                    if (fs_tie_var)
+                    if (cluster_options_ptr->tie_var)
                     {
                         double ave_var = 0.0;
 
@@ -13993,18 +14745,18 @@ loop_cleanup:
                         /* CHECK -- On 05-01-30, this looks a bit puzzling. We
                          *          are overwriting the data!
                         */
-                        if (    ( ! fs_vector_feature_counts_set)
+                        if (    ( ! cache_ptr->vector_feature_counts_set)
                              && (con_feature_enable_vp != NULL)
                              && (con_feature_group_vp != NULL)
                            )
                         {
                             UNTESTED_CODE();
 
-                            ERE(initialize_vector_feature_counts(con_feature_enable_vp,
+                            ERE(initialize_vector_feature_counts(cache_ptr, con_feature_enable_vp,
                                                                  con_feature_group_vp));
                         }
 
-                        if (fs_vector_feature_counts_ptr != NULL)
+                        if (cache_ptr->vector_feature_counts_ptr != NULL)
                         {
                             double ave_var = 0.0;
 
@@ -14069,8 +14821,8 @@ loop_cleanup:
                 if (min_matrix_element(var_mp) < var_offset)
                 {
                     dbe(var_offset);
-                    dbe(fs_var_offset);
-                    dbe(fs_var_offset_2);
+                    dbe(cluster_options_ptr->var_offset);
+                    dbe(cluster_options_ptr->var_offset_2);
                     dbe(norm_stdev);
                     dbe(min_matrix_element(var_mp));
                 }
@@ -14191,7 +14943,7 @@ loop_cleanup:
 
         a_vp_normalization = num_points;
 
-        if (    ( ! IS_EQUAL_DBL(fs_map_alpha, 1.0))
+        if (    ( ! IS_EQUAL_DBL(cluster_options_ptr->map_alpha, 1.0))
              && (map_alpha_vp != NULL)
            )
         {
@@ -14228,7 +14980,7 @@ loop_cleanup:
 
         if (current_model_is_valid)
         {
-            if (fs_watch)
+            if (cluster_options_ptr->watch)
             {
                 pso(" %-3d | %11.4e | %9.2e", 1 + it,
                     log_likelihood,
@@ -14242,30 +14994,30 @@ loop_cleanup:
                 }
             }
 
-            if (fs_watch)
+            if (cluster_options_ptr->watch)
             {
 #ifdef SUPPORT_ANNEALING
-                if (fs_watch_temperature)  pso(" | %10.3f", temperature);
+                if (cluster_options_ptr->watch_temperature)  pso(" | %10.3f", temperature);
 #endif
-                if (fs_watch_max_con_prob) pso(" | %9.2e", max_con_log_prob);
+                if (cluster_options_ptr->watch_max_con_prob) pso(" | %9.2e", max_con_log_prob);
 
 #ifdef CANT_SUPPORT_IT_FOR_A_BIT
                 /* Need previous key as well as prev_P_c_p_mp. */
 
-                if (fs_watch_rms_cluster_given_point_diff)
+                if (cluster_options_ptr->watch_rms_cluster_given_point_diff)
                 {
                     pso(" | %9.2e",
                         rms_matrix_difference(prev_P_c_p_mp, P_c_p_mp));
                 }
 
-                if (fs_watch_max_cluster_given_point_diff)
+                if (cluster_options_ptr->watch_max_cluster_given_point_diff)
                 {
                     pso(" | %9.2e",
                         max_abs_matrix_difference(prev_P_c_p_mp, P_c_p_mp));
                 }
 
-                if (    (fs_watch_max_cluster_given_point_diff)
-                     || (fs_watch_rms_cluster_given_point_diff)
+                if (    (cluster_options_ptr->watch_max_cluster_given_point_diff)
+                     || (cluster_options_ptr->watch_rms_cluster_given_point_diff)
                    )
                 {
                     result = copy_matrix(&prev_P_c_p_mp, P_c_p_mp);
@@ -14273,7 +15025,7 @@ loop_cleanup:
                 }
 #endif
 
-                if (fs_watch_max_parm_diff)
+                if (cluster_options_ptr->watch_max_parm_diff)
                 {
                     max_parm_diff = DBL_MOST_NEGATIVE;
 
@@ -14336,12 +15088,12 @@ loop_cleanup:
                     pso(" | %9.2e", max_parm_diff);
                 }
 
-                if (fs_watch_ave_limited_error)
+                if (cluster_options_ptr->watch_ave_limited_error)
                 {
                     pso(" | %9.2e", ave_limited_cluster_error);
                 }
 
-                if (fs_watch_max_limited_error)
+                if (cluster_options_ptr->watch_max_limited_error)
                 {
                     pso(" | %9.2e", max_limited_cluster_error);
                 }
@@ -14367,7 +15119,7 @@ loop_cleanup:
                 {
                     char output_sub_dir[ MAX_FILE_NAME_SIZE ];
 
-                    if (fs_watch)
+                    if (cluster_options_ptr->watch)
                     {
                         pso("Saving intermediate model because relative diff has droped to %.3e.\n",
                             ll_rel_diff);
@@ -14418,7 +15170,7 @@ loop_cleanup:
             {
                 char output_sub_dir[ MAX_FILE_NAME_SIZE ];
 
-                if (fs_watch)
+                if (cluster_options_ptr->watch)
                 {
                     pso("Saving intermediate model because iteration has reached %d.\n",
                         it + 1);
@@ -14483,12 +15235,12 @@ loop_cleanup:
             break;
         }
         else if (
-                     (ABS_OF(ll_rel_diff) < fs_iteration_tolerance)
+                     (ABS_OF(ll_rel_diff) < cluster_options_ptr->iteration_tolerance)
                   && (ll_rel_diff >= 0.0)
 #ifdef SUPPORT_ANNEALING
-                  && (it > fs_num_cooling_iterations)
+                  && (it > cluster_options_ptr->num_cooling_iterations)
 #endif
-                  && (it > fs_min_num_em_iterations)
+                  && (it > cluster_options_ptr->min_num_em_iterations)
                   && ( ! changed_number_of_parameters )
                 )
         {
@@ -14542,7 +15294,7 @@ loop_cleanup:
 
 
 #ifdef SUPPORT_ANNEALING
-        if (it < fs_num_cooling_iterations)
+        if (it < cluster_options_ptr->num_cooling_iterations)
         {
             temperature *= temperature_factor;
         }
@@ -14562,13 +15314,13 @@ loop_cleanup:
         kjb_fflush((FILE*)NULL);
 
 #ifdef XXX_LIMIT_MIN_CON_PROB
-        if (    (fs_min_con_log_prob_cutoff > 0.0)
-             && (fs_min_con_log_prob_cutoff < 1.0)
+        if (    (cluster_options_ptr->min_con_log_prob_cutoff > 0.0)
+             && (cluster_options_ptr->min_con_log_prob_cutoff < 1.0)
            )
         {
             if (num_g_probs > 0)
             {
-                int index = num_g_probs * fs_min_con_log_prob_cutoff;
+                int index = num_g_probs * cluster_options_ptr->min_con_log_prob_cutoff;
 
                 dbi(num_g_probs);
                 dbi(num_g_prob_resets);
@@ -14673,12 +15425,12 @@ loop_cleanup:
 
     if (result != ERROR)
     {
-        model_ptr->max_con_norm_var = fs_max_con_norm_var;
+        model_ptr->max_con_norm_var = cluster_options_ptr->max_con_norm_var;
 
         result = compute_mdl_log_likelihood(num_points, model_ptr);
     }
 
-    if ((result != ERROR) && (fs_save_model_data))
+    if ((result != ERROR) && (cluster_options_ptr->save_model_data))
     {
         result = copy_cluster_data(&(model_ptr->data_ptr), data_ptr);
     }
@@ -14948,7 +15700,9 @@ static int do_fixed_discrete_multi_modal_clustering
     const Vector*           norm_mean_vp,
     const Vector*           norm_var_vp,
     double                  norm_stdev,
-    int                     max_num_em_iterations
+    int                     max_num_em_iterations,
+    const Multi_modal_cluster_options* cluster_options_ptr,
+    Cluster_cache*                     cache_ptr
 )
 {
     IMPORT volatile Bool    iteration_atn_flag;
@@ -15159,7 +15913,7 @@ static int do_fixed_discrete_multi_modal_clustering
 
     if (result != ERROR)
     {
-        result = initialize_vector_feature_counts(con_feature_enable_vp,
+        result = initialize_vector_feature_counts(cache_ptr, con_feature_enable_vp,
                                                   con_feature_group_vp);
     }
 
@@ -15350,18 +16104,18 @@ static int do_fixed_discrete_multi_modal_clustering
     }
 #endif
 
-    if ((result != ERROR) && fs_watch)
+    if ((result != ERROR) && cluster_options_ptr->watch)
     {
         int head_len = 30;
 
         if (need_held_out_log_likelihood) head_len += 15;
         if (need_held_out_log_likelihood) head_len += 13;
-        if (fs_watch_max_con_prob) head_len += 12;
-        if (fs_watch_max_cluster_given_point_diff) head_len += 12;
-        if (fs_watch_rms_cluster_given_point_diff) head_len += 12;
-        if (fs_watch_max_parm_diff) head_len += 12;
-        if (fs_watch_ave_limited_error) head_len += 12;
-        if (fs_watch_max_limited_error) head_len += 12;
+        if (cluster_options_ptr->watch_max_con_prob) head_len += 12;
+        if (cluster_options_ptr->watch_max_cluster_given_point_diff) head_len += 12;
+        if (cluster_options_ptr->watch_rms_cluster_given_point_diff) head_len += 12;
+        if (cluster_options_ptr->watch_max_parm_diff) head_len += 12;
+        if (cluster_options_ptr->watch_ave_limited_error) head_len += 12;
+        if (cluster_options_ptr->watch_max_limited_error) head_len += 12;
 
         rep_print(stdout, '=', head_len);
         pso("\n");
@@ -15370,12 +16124,12 @@ static int do_fixed_discrete_multi_modal_clustering
 
         if (need_held_out_log_likelihood) pso(" | Held out LL");
         if (need_held_out_log_likelihood) pso(" |   diff   ");
-        if (fs_watch_max_con_prob) pso(" | max con P");
-        if (fs_watch_rms_cluster_given_point_diff) pso(" | rms P c  ");
-        if (fs_watch_max_cluster_given_point_diff) pso(" | max P c  ");
-        if (fs_watch_max_parm_diff) pso(" | max parm ");
-        if (fs_watch_ave_limited_error) pso(" | ave lim  ");
-        if (fs_watch_max_limited_error) pso(" | max lim  ");
+        if (cluster_options_ptr->watch_max_con_prob) pso(" | max con P");
+        if (cluster_options_ptr->watch_rms_cluster_given_point_diff) pso(" | rms P c  ");
+        if (cluster_options_ptr->watch_max_cluster_given_point_diff) pso(" | max P c  ");
+        if (cluster_options_ptr->watch_max_parm_diff) pso(" | max parm ");
+        if (cluster_options_ptr->watch_ave_limited_error) pso(" | ave lim  ");
+        if (cluster_options_ptr->watch_max_limited_error) pso(" | max lim  ");
         pso("\n");
         rep_print(stdout, '-', head_len);
         pso("\n");
@@ -15406,7 +16160,7 @@ static int do_fixed_discrete_multi_modal_clustering
         }
 #endif
 
-        var_offset = fs_var_offset + fs_var_offset_2 / (1.0 + it/5);
+        var_offset = cluster_options_ptr->var_offset + cluster_options_ptr->var_offset_2 / (1.0 + it/5);
         var_offset *= (norm_stdev * norm_stdev);
 
 #ifdef REPORT_CPU_TIME
@@ -15484,7 +16238,7 @@ static int do_fixed_discrete_multi_modal_clustering
 #endif
             if (result == ERROR) { NOTE_ERROR(); break; }
 
-            if ((fs_weight_data) && (weight_vp != NULL))
+            if ((cluster_options_ptr->weight_data) && (weight_vp != NULL))
             {
                 point_weight = weight_vp->elements[ point ];
             }
@@ -15534,13 +16288,13 @@ static int do_fixed_discrete_multi_modal_clustering
                             double p = kjb_rand();
 
                             /* Uniform: For debugging. */
-                            if (fs_initialize_method == 0)
+                            if (cluster_options_ptr->initialize_method == 0)
                             {
                                 p = 1.0;
                             }
-                            else if (fs_initialize_method > 1)
+                            else if (cluster_options_ptr->initialize_method > 1)
                             {
-                                p = pow(p, (double)fs_initialize_method);
+                                p = pow(p, (double)cluster_options_ptr->initialize_method);
                             }
 
                             p += 0.01 / num_levels_per_category;
@@ -15665,10 +16419,10 @@ static int do_fixed_discrete_multi_modal_clustering
                                                   mean_mp->elements[ level_index ],
                                                   var_mp->elements[ level_index ],
                                                   con_log_sqrt_det_vp->elements[ level_index ],
-                                                  fs_norm_continuous_features,
-                                                  fs_limit_gaussian_deviation,
-                                                  fs_max_con_norm_var,
-                                                  fs_vector_feature_counts_ptr,
+                                                  cluster_options_ptr->norm_continuous_features,
+                                                  cluster_options_ptr->limit_gaussian_deviation,
+                                                  cluster_options_ptr->max_con_norm_var,
+                                                  cache_ptr->vector_feature_counts_ptr,
                                                   &log_prob,
                                                   &max_con_log_prob, TRUE);
                     }
@@ -15680,10 +16434,10 @@ static int do_fixed_discrete_multi_modal_clustering
                                                   mean_mp->elements[ level_index ],
                                                   var_mp->elements[ level_index ],
                                                   con_log_sqrt_det_vp->elements[ level_index ],
-                                                  fs_norm_continuous_features,
-                                                  fs_limit_gaussian_deviation,
-                                                  fs_max_con_norm_var,
-                                                  fs_vector_feature_counts_ptr,
+                                                  cluster_options_ptr->norm_continuous_features,
+                                                  cluster_options_ptr->limit_gaussian_deviation,
+                                                  cluster_options_ptr->max_con_norm_var,
+                                                  cache_ptr->vector_feature_counts_ptr,
                                                   &log_prob,
                                                   &max_con_log_prob, FALSE);
                     }
@@ -16126,7 +16880,7 @@ v_step:
 
         if (log_likelihood < DBL_HALF_MOST_NEGATIVE/2.0) break;
 
-        if (fs_norm_con_prob)
+        if (cluster_options_ptr->norm_con_prob)
         {
             log_likelihood += con_log_norm * ll_con_correction_norm_sum;
             model_ptr->con_log_norm = con_log_norm;
@@ -16212,7 +16966,7 @@ v_step:
         }
 #endif
 
-        if ((fs_norm_con_prob) && (ABS_OF(max_con_log_prob) > 1.0))
+        if ((cluster_options_ptr->norm_con_prob) && (ABS_OF(max_con_log_prob) > 1.0))
         {
             con_log_norm += max_con_log_prob;
         }
@@ -16319,7 +17073,7 @@ loop_cleanup:
             result = ow_add_scalar_to_matrix_row(new_var_mp, var_offset, level_index);
             if (result == ERROR) { NOTE_ERROR(); break; }
 
-            if (fs_tie_var)
+            if (cluster_options_ptr->tie_var)
             {
                 double ave_var = 0.0;
 
@@ -16357,18 +17111,18 @@ loop_cleanup:
                 /* CHECK -- On 05-01-30, this looks a bit puzzling. We
                  *          are overwriting the data!
                  */
-                if (    ( ! fs_vector_feature_counts_set)
+                if (    ( ! cache_ptr->vector_feature_counts_set)
                         && (con_feature_enable_vp != NULL)
                         && (con_feature_group_vp != NULL)
                    )
                 {
                     UNTESTED_CODE();
 
-                    ERE(initialize_vector_feature_counts(con_feature_enable_vp,
+                    ERE(initialize_vector_feature_counts(cache_ptr, con_feature_enable_vp,
                                                          con_feature_group_vp));
                 }
 
-                if (fs_vector_feature_counts_ptr != NULL)
+                if (cache_ptr->vector_feature_counts_ptr != NULL)
                 {
                     double ave_var = 0.0;
 
@@ -16484,7 +17238,7 @@ loop_cleanup:
 
         if (current_model_is_valid)
         {
-            if (fs_watch)
+            if (cluster_options_ptr->watch)
             {
                 pso(" %-3d | %11.4e | %9.2e", 1 + it,
                     log_likelihood,
@@ -16498,11 +17252,11 @@ loop_cleanup:
                 }
             }
 
-            if (fs_watch)
+            if (cluster_options_ptr->watch)
             {
-                if (fs_watch_max_con_prob) pso(" | %9.2e", max_con_log_prob);
+                if (cluster_options_ptr->watch_max_con_prob) pso(" | %9.2e", max_con_log_prob);
 
-                if (fs_watch_max_parm_diff)
+                if (cluster_options_ptr->watch_max_parm_diff)
                 {
                     max_parm_diff = DBL_MOST_NEGATIVE;
 
@@ -16572,7 +17326,7 @@ loop_cleanup:
             {
                 char output_sub_dir[ MAX_FILE_NAME_SIZE ];
 
-                if (fs_watch)
+                if (cluster_options_ptr->watch)
                 {
                     pso("Saving intermediate model because iteration has reached %d.\n",
                         it + 1);
@@ -16628,9 +17382,9 @@ loop_cleanup:
             break;
         }
         else if (
-                     (ABS_OF(ll_rel_diff) < fs_iteration_tolerance)
+                     (ABS_OF(ll_rel_diff) < cluster_options_ptr->iteration_tolerance)
                   && (ll_rel_diff >= 0.0)
-                  && (it > fs_min_num_em_iterations)
+                  && (it > cluster_options_ptr->min_num_em_iterations)
                 )
         {
             break;
@@ -16696,12 +17450,12 @@ loop_cleanup:
 
     if (result != ERROR)
     {
-        model_ptr->max_con_norm_var = fs_max_con_norm_var;
+        model_ptr->max_con_norm_var = cluster_options_ptr->max_con_norm_var;
 
         result = compute_mdl_log_likelihood(num_points, model_ptr);
     }
 
-    if ((result != ERROR) && (fs_save_model_data))
+    if ((result != ERROR) && (cluster_options_ptr->save_model_data))
     {
         result = copy_cluster_data(&(model_ptr->data_ptr), data_ptr);
     }
@@ -16830,10 +17584,49 @@ int get_cluster_membership
     Vector_vector*            con_score_vpp
 )
 {
-    const Int_vector* con_feature_enable_vp    = model_ptr->con_feature_enable_vp;
-    const Int_vector* con_feature_group_vp     = model_ptr->con_feature_group_vp;
-    const int         weight_con_items         = model_ptr->weight_con_items;
-    const int         norm_depend              = model_ptr->norm_depend;
+    return get_cluster_membership_with_options(P_c_p_mpp,
+                                               P_l_p_c_mvpp,
+                                               cluster_level_index_mvpp,
+                                               P_l_p_mpp,
+                                               level_index_mpp,
+                                               fit_vp_ptr,
+                                               model_ptr,
+                                               data_ptr,
+                                               points_to_use_vp,
+                                               use_factors_flag,
+                                               test_data_flag,
+                                               con_score_vpp,
+                                               &fs_options);
+}
+
+/*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\   */
+
+/*
+ * As get_cluster_membership(), but with the options in cluster_options_ptr
+ * rather than the process wide ones. The points are split over
+ * "hc-num-threads" threads.
+*/
+int get_cluster_membership_with_options
+(
+    Matrix**                           P_c_p_mpp,
+    Matrix_vector**                    P_l_p_c_mvpp,
+    Int_matrix_vector**                cluster_level_index_mvpp,
+    Matrix**                           P_l_p_mpp,
+    Int_matrix**                       level_index_mpp,
+    Vector**                           fit_vp_ptr,
+    const Multi_modal_model*           model_ptr,
+    const Cluster_data*                data_ptr,
+    const Int_vector*                  points_to_use_vp,
+    int                                use_factors_flag,
+    int                                test_data_flag,
+    Vector_vector*                     con_score_vpp,
+    const Multi_modal_cluster_options* cluster_options_ptr
+)
+{
+    const Int_vector* con_feature_enable_vp    = model_ptr->con_feature_enable_vp;
+    const Int_vector* con_feature_group_vp     = model_ptr->con_feature_group_vp;
+    const int         weight_con_items         = model_ptr->weight_con_items;
+    const int         norm_depend              = model_ptr->norm_depend;
     const int         model_correspondence     = model_ptr->phase_two_model_correspondence;
     const double      con_prob_boost_factor    = model_ptr->con_prob_boost_factor;
     const double      dis_prob_boost_factor    = model_ptr->dis_prob_boost_factor;
@@ -16863,6 +17656,8 @@ int get_cluster_membership
     Vector*              dis_factor_vp       = NULL;
     Vector*              con_factor_vp       = NULL;
     double               prev_log_likelihood = DBL_HALF_MOST_NEGATIVE;
+    Cluster_cache        cache;
+    int                  result;
 
 
     TEST_PSO(("Level prior not implemented. \n"));
@@ -16918,49 +17713,53 @@ int get_cluster_membership
                             con_prob_boost_factor));
     }
 
+    init_cluster_cache(&cache);
+
     set_iteration_atn_trap();
 
-    ERE(get_cluster_membership_2(P_c_p_mpp,
-                                 P_l_p_c_mvpp,
-                                 cluster_level_index_mvpp,
-                                 P_l_p_mpp,
-                                 level_index_mpp,
-                                 fit_vp_ptr,
-                                 topology_ptr,
-                                 a_vp,
-                                 V_mp,
-                                 input_P_c_p_mp,
-                                 input_P_l_p_c_mvp,
-                                 input_P_l_p_mp,
-                                 P_i_n_mvp,
-                                 mean_mvp, var_mvp,
-                                 con_log_sqrt_det_vvp,
-                                 con_log_norm,
-                                 con_feature_enable_vp,
-                                 con_feature_group_vp,
-                                 min_con_log_prob,
-                                 max_con_norm_var,
-                                 con_score_cutoff,
-                                 weight_con_items,
-                                 norm_depend,
-                                 model_correspondence,
-                                 data_ptr,
-                                 points_to_use_vp,
-                                 dis_factor_vp, con_factor_vp,
-                                 norm_continuous_features,
-                                 fs_iteration_tolerance,
-                                 prev_log_likelihood,
-                                 (double*)NULL,
-                                 model_ptr->P_c_p_mp,
-                                 test_data_flag,
-                                 con_score_vpp));
+    result = get_cluster_membership_2(P_c_p_mpp,
+                                      P_l_p_c_mvpp,
+                                      cluster_level_index_mvpp,
+                                      P_l_p_mpp,
+                                      level_index_mpp,
+                                      fit_vp_ptr,
+                                      topology_ptr,
+                                      a_vp,
+                                      V_mp,
+                                      input_P_c_p_mp,
+                                      input_P_l_p_c_mvp,
+                                      input_P_l_p_mp,
+                                      P_i_n_mvp,
+                                      mean_mvp, var_mvp,
+                                      con_log_sqrt_det_vvp,
+                                      con_log_norm,
+                                      con_feature_enable_vp,
+                                      con_feature_group_vp,
+                                      min_con_log_prob,
+                                      max_con_norm_var,
+                                      con_score_cutoff,
+                                      weight_con_items,
+                                      norm_depend,
+                                      model_correspondence,
+                                      data_ptr,
+                                      points_to_use_vp,
+                                      dis_factor_vp, con_factor_vp,
+                                      norm_continuous_features,
+                                      cluster_options_ptr->iteration_tolerance,
+                                      prev_log_likelihood,
+                                      (double*)NULL,
+                                      model_ptr->P_c_p_mp,
+                                      test_data_flag,
+                                      con_score_vpp,
+                                      cluster_options_ptr, &cache);
 
     unset_iteration_atn_trap();
 
+    free_cluster_cache(&cache);
     free_vector(dis_factor_vp);
     free_vector(con_factor_vp);
 
-    return NO_ERROR;
+    return result;
 }
 
 /*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\   */
@@ -17002,30 +17801,22 @@ static int get_cluster_membership_2
     double*              log_likelihood_ptr,
     const Matrix*        test_P_c_p_mp,
     int                  test_data_flag,
-    Vector_vector*       __attribute__((unused)) dummy_con_score_vpp
+    Vector_vector*       __attribute__((unused)) dummy_con_score_vpp,
+    const Multi_modal_cluster_options* cluster_options_ptr,
+    Cluster_cache*                     cache_ptr
 )
 {
     IMPORT volatile Bool    iteration_atn_flag;
     const int         num_levels        = topology_ptr->num_levels;
     const int         first_level       = topology_ptr->first_level;
     const int         last_level_num       = topology_ptr->last_level_num;
-    const Int_matrix* node_mp           = topology_ptr->node_mp;
     const Int_vector* level_counts_vp   = topology_ptr->level_counts_vp;
     const int         num_clusters      = topology_ptr->num_clusters;
     const int         max_num_dis_items = (P_i_n_mvp == NULL) ? 0 : data_ptr->max_num_dis_items;
     const int         max_num_con_items = (mean_mvp == NULL) ? 0 : data_ptr->max_num_con_items;
     const int         max_num_items         = max_num_dis_items + max_num_con_items;
-    const Int_matrix* dis_item_mp       = (max_num_dis_items == 0) ? NULL : data_ptr->dis_item_mp;
-    const Matrix*     dis_item_multiplicity_mp    = (max_num_dis_items == 0) ? NULL : data_ptr->dis_item_multiplicity_mp;
 #ifdef XXX_NEVER_USED
     const Matrix*     dis_category_level_prior_mp = (max_num_dis_items == 0) ? NULL : data_ptr->dis_category_level_prior_mp;
-#endif
-    const Matrix_vector* con_item_mvp     = (max_num_con_items == 0) ? NULL : data_ptr->con_item_mvp;
-#ifdef HOW_IT_WAS_05_01_29
-    const int            num_con_features = data_ptr->num_con_features;
-#endif
-#ifdef TEST
-    const int num_categories = data_ptr->num_categories;
 #endif
     const Vector_vector* con_item_weight_vvp = data_ptr->con_item_weight_vvp;
     /*
@@ -17039,78 +17830,21 @@ static int get_cluster_membership_2
     int                  level;
     int                  cluster;
     int                  point;
-    int                  dis_item;
-    int                  con_item;
     Vector*              fit_vp           = NULL;
     Vector*              col_sum_vp       = NULL;
     Matrix*              P_c_p_mp         = NULL;
-#ifdef TEST
-    int                  item;
-#endif
     const Matrix_vector* P_l_p_c_mvp;
     Matrix* P_l_p_mp;
     int                  it;
-    Vector*              nu_vp            = NULL;
-    Vector*              log_nu_vp        = NULL;
     double               log_likelihood   = DBL_HALF_MOST_NEGATIVE;
-    Vector*              log_prob_vp      = NULL;
     double               ll_rel_diff;
-    double               dis_item_multiplicity;
-    double***            level_indicators_ppp;
-    double**             level_indicators_pp;
-    double*              level_indicators_p;
-    double               ll_con_correction_norm_sum = 0.0;
-#ifdef TEST
-    int                  max_index = NOT_SET;
-#endif
-
-    double         dis_factor;
-    double         con_factor;
-    double         max_log_prob;
-    double*        P_c_p_ptr;
-    double         fit_temp;
-    double         prob_sum;
-    int            num_con_items;
-    double*        save_x_ptr;
-    Vector_vector* con_prob_cache_vvp;
-    int            num_nodes_this_level;
-    double*        con_prob_cache_ptr;
     int            node;
-#ifdef HOW_IT_WAS_05_01_29
-    double         d;
-    double*        u_ptr;
-    double*        v_ptr;
-    double*        x_ptr;
-    double         norm;
-    double         dev;
-    double         v;
-    int            con_feature;
-#endif
-    double         temp;
     double         log_prob;
-    int            dis_item_found;
-    double         log_product;
-    double         product;
-    double         log_dis_prod;
-    double         log_con_prod;
-#ifdef TEST
-    double         sum_nu;
-#endif
-    int            category;
-    double         level_sum;
-    double         log_prob_sum;
-    double         nu;
-    double         prob;
-    double log_nu;
-    double exp_temp;
-    double exp_sum;
-    double p;
     double rms_diff;
     double max_diff;
     char user_id[ 1000 ];
     char halt_file_name[ MAX_FILE_NAME_SIZE ];
     const Matrix* lock_P_c_p_mp = NULL;
-    Vector* nu_for_dependent_model_vp = NULL;
     Int_vector* con_score_counts_vp = NULL;
 #ifdef XXX_NOT_SURE_WHAT_IT_IS_DOING
     Matrix* con_score_mp = NULL;
@@ -17122,6 +17856,9 @@ static int get_cluster_membership_2
     const Int_matrix* level_index_mp = NULL;
     Indexed_vector* sorted_l_p_vp = NULL;
     Vector* level_weight_vp = NULL;
+    Cluster_membership_input input;
+    Cluster_membership_job*  jobs     = NULL;
+    int                      num_jobs = 0;
 
 
     BUFF_GET_USER_ID(user_id);
@@ -17135,7 +17872,7 @@ static int get_cluster_membership_2
               || (cluster_level_index_mvpp != NULL)
             )
          &&
-            (fs_max_num_level_weights > 0)
+            (cluster_options_ptr->max_num_level_weights > 0)
        )
     {
         if (cluster_level_index_mvpp != NULL)
@@ -17148,7 +17885,7 @@ static int get_cluster_membership_2
         dbp("Using sparse levels");
 
         num_sparse_levels = MIN_OF(num_levels,
-                                   fs_max_num_level_weights);
+                                   cluster_options_ptr->max_num_level_weights);
 
         dbi(num_levels);
         dbi(num_sparse_levels);
@@ -17183,16 +17920,6 @@ static int get_cluster_membership_2
 
     ERE(get_zero_vector(&level_weight_vp, num_levels));
 
-#ifdef NU_SHOULD_NOT_BE_INDEXED_BY_SPARSE_LEVEL
-    ERE(get_zero_vector(&nu_vp, num_sparse_levels));
-    ERE(get_zero_vector(&log_nu_vp, num_sparse_levels));
-    ERE(get_zero_vector(&log_prob_vp, num_sparse_levels));
-#else
-    ERE(get_zero_vector(&nu_vp, num_levels));
-    ERE(get_zero_vector(&log_nu_vp, num_levels));
-    ERE(get_zero_vector(&log_prob_vp, num_levels));
-#endif
-
     ERE(get_zero_vector(&fit_vp, num_points));
 
     ERE(get_target_int_vector(&con_score_counts_vp,
@@ -17229,9 +17956,6 @@ static int get_cluster_membership_2
         lock_P_c_p_mp = P_c_p_mp;
     }
 
-    ERE(initialize_level_indicators_cache(num_levels, num_clusters, max_num_items));
-    level_indicators_ppp = fs_cached_level_indicators_ppp;
-
     if (P_l_p_c_mvpp == NULL)
     {
         P_l_p_c_mvp = NULL;
@@ -17392,7 +18116,7 @@ static int get_cluster_membership_2
     }
 #endif
 
-    if (fs_watch_2)
+    if (cluster_options_ptr->watch_2)
     {
         pso("\n");
         pso("Get cluster membership:\n");
@@ -17436,186 +18160,495 @@ static int get_cluster_membership_2
 
     }
 
-    ERE(initialize_con_prob_cache(max_num_con_items,
-                                  first_level,
-                                  last_level_num,
-                                  num_levels,
-                                  level_counts_vp));
-
-    ERE(initialize_vector_feature_counts(con_feature_enable_vp,
+    ERE(initialize_vector_feature_counts(cache_ptr, con_feature_enable_vp,
                                          con_feature_group_vp));
 
-    for (it = 0; it < fs_max_num_em_iterations; it++)
+    /*
+     * The points are done in parallel below, where errors cannot be set, so we
+     * check for them here. Whether compute_con_prob() finds any enabled
+     * features depends on the model, not on the point.
+    */
+    if ((V_mp == NULL) && (input_P_l_p_c_mvp == NULL) && (input_P_l_p_mp == NULL))
     {
-        int count = 0;
-#ifdef XXX_LIMIT_MIN_CON_PROB
-        int num_g_prob_resets = 0;
-#endif
+        SET_CANT_HAPPEN_BUG();
+        return ERROR;
+    }
 
-        for (point = 0; point < num_points; point++)
+    if (max_num_con_items > 0)
+    {
+        for (level = first_level; level < last_level_num; level++)
         {
-            if (    (points_to_use_vp != NULL)
-                 && (points_to_use_vp->elements[ point ] == 0)
-               )
+            for (node = 0; node < level_counts_vp->elements[ level ]; node++)
             {
-                continue;
+                ERE(compute_con_prob(con_feature_enable_vp,
+                                     con_feature_group_vp,
+                                     mean_mvp->elements[ level ]->elements[ node ],
+                                     mean_mvp->elements[ level ]->elements[ node ],
+                                     var_mvp->elements[ level ]->elements[ node ],
+                                     con_log_sqrt_det_vvp->elements[ level ]->elements[ node ],
+                                     norm_continuous_features,
+                                     cluster_options_ptr->limit_gaussian_deviation,
+                                     cluster_options_ptr->max_con_norm_var,
+                                     cache_ptr->vector_feature_counts_ptr,
+                                     &log_prob,
+                                     NULL, FALSE));
             }
+        }
 
-            dis_factor = (dis_factor_vp == NULL) ? 1.0 : dis_factor_vp->elements[ point ];
-            con_factor = (con_factor_vp == NULL) ? 1.0 : con_factor_vp->elements[ point ];
-            num_con_items = (max_num_con_items == 0) ? 0 : con_item_mvp->elements[ point ]->num_rows;
+        if ((model_correspondence == 1) && (weight_con_items) && (con_item_weight_vvp != NULL))
+        {
+            static int first_time = TRUE;
 
-            if (max_num_con_items > 0)
+            if (first_time)
             {
-                ll_con_correction_norm_sum = 0.0;
+                first_time = FALSE;
+                dbp("Weighting continous items.\n");
             }
+        }
+    }
 
-            /*
-            // Cache the probability calculations so that they are done only
-            // once per node as opposed to num_levels*num_cluster times.
-            */
-            for (con_item = 0; con_item < num_con_items; con_item++)
-            {
-                save_x_ptr = con_item_mvp->elements[ point ]->elements[ con_item ];
-                con_prob_cache_vvp = fs_con_prob_cache_vvvp->elements[ con_item ];
+    input.topology_ptr = topology_ptr;
+    input.a_vp = a_vp;
+    input.V_mp = V_mp;
+    input.input_P_l_p_c_mvp = input_P_l_p_c_mvp;
+    input.input_P_l_p_mp = input_P_l_p_mp;
+    input.P_i_n_mvp = P_i_n_mvp;
+    input.mean_mvp = mean_mvp;
+    input.var_mvp = var_mvp;
+    input.con_log_sqrt_det_vvp = con_log_sqrt_det_vvp;
+    input.con_log_norm = con_log_norm;
+    input.con_feature_enable_vp = con_feature_enable_vp;
+    input.con_feature_group_vp = con_feature_group_vp;
+    input.min_con_log_prob = min_con_log_prob;
+    input.max_con_norm_var = max_con_norm_var;
+    input.con_score_cutoff = con_score_cutoff;
+    input.weight_con_items = weight_con_items;
+    input.norm_depend = norm_depend;
+    input.model_correspondence = model_correspondence;
+    input.data_ptr = data_ptr;
+    input.points_to_use_vp = points_to_use_vp;
+    input.dis_factor_vp = dis_factor_vp;
+    input.con_factor_vp = con_factor_vp;
+    input.norm_continuous_features = norm_continuous_features;
+    input.cluster_options_ptr = cluster_options_ptr;
+    input.vector_feature_counts_ptr = cache_ptr->vector_feature_counts_ptr;
+    input.num_sparse_levels = num_sparse_levels;
+    input.first_sparse_level = first_sparse_level;
+    input.level_index_mp = level_index_mp;
+    input.con_score_vp = con_score_vp;
+    input.lock_P_c_p_mp = lock_P_c_p_mp;
+    input.P_c_p_mp = P_c_p_mp;
+    input.P_l_p_c_mvp = P_l_p_c_mvp;
+    input.P_l_p_mp = P_l_p_mp;
+    input.fit_vp = fit_vp;
+    input.missing_index_vvp = NULL;
+
+    if (get_cluster_membership_jobs(&jobs, &num_jobs, &input, cache_ptr,
+                                    num_points, max_num_items)
+        == ERROR)
+    {
+        free_cluster_membership_jobs(jobs, num_jobs);
+        return ERROR;
+    }
 
-                for (level = first_level; level < last_level_num; level++)
-                {
-                    num_nodes_this_level = level_counts_vp->elements[ level ];
-                    con_prob_cache_ptr   = con_prob_cache_vvp->elements[ level ]->elements;
+    for (it = 0; it < cluster_options_ptr->max_num_em_iterations; it++)
+    {
+        if (run_cluster_membership_jobs(jobs, num_jobs, it) == ERROR)
+        {
+            free_cluster_membership_jobs(jobs, num_jobs);
+            return ERROR;
+        }
 
-                    for (node = 0; node < num_nodes_this_level; node++)
-                    {
-#ifdef HOW_IT_WAS_05_01_29
-                        d        = 0.0;
-                        u_ptr    = mean_mvp->elements[ level ]->elements[ node ];
-                        v_ptr    = var_mvp->elements[ level ]->elements[ node ];
-                        x_ptr    = save_x_ptr;
-                        norm     = con_log_sqrt_det_vvp->elements[ level ]->elements[ node ];
+        log_likelihood = sum_vector_elements(fit_vp);
+
+        ll_rel_diff = (log_likelihood - prev_log_likelihood);
+        ll_rel_diff /= (ABS_OF(log_likelihood) + ABS_OF(prev_log_likelihood));
+        ll_rel_diff *= 2.0;
+        prev_log_likelihood = log_likelihood;
 
-                        ASSERT_IS_POSITIVE_INT(num_con_features);
+        if (cluster_options_ptr->watch_2)
+        {
+            rms_diff = 0.0;
+            max_diff = 0.0;
 
-#ifdef HOW_IT_WAS
-                        if (*v_ptr > 0.0)
-                        {
-#endif
-                            ASSERT_IS_NUMBER_DBL(norm);
-                            ASSERT_IS_FINITE_DBL(norm);
+            pso(" %-3d | %.6e | %.3e |", 1 + it, log_likelihood, ll_rel_diff);
 
-                            for (con_feature = 0; con_feature < num_con_features; con_feature++)
-                            {
-                                v = *v_ptr;
+            prev_log_likelihood = log_likelihood;
 
-                                if (v > 0.0)
-                                {
-                                    dev = *u_ptr - *x_ptr;
-                                    temp = (dev / v) * dev;
+            if (test_data_flag)
+            {
+                rms_diff = rms_matrix_difference(P_c_p_mp,
+                                                 test_P_c_p_mp);
+                max_diff = max_abs_matrix_difference(P_c_p_mp,
+                                                     test_P_c_p_mp);
+            }
 
-                                    ASSERT_IS_NUMBER_DBL(dev);
-                                    ASSERT_IS_FINITE_DBL(dev);
+            pso(" %.3e | %.3e\n", rms_diff, max_diff);
+        }
 
-                                    ASSERT_IS_NUMBER_DBL(v);
-                                    ASSERT_IS_FINITE_DBL(v);
+        kjb_fflush((FILE*)NULL);
 
-                                    ASSERT_IS_NUMBER_DBL(temp);
-                                    ASSERT_IS_FINITE_DBL(temp);
+        if (iteration_atn_flag)
+        {
+            pso("Stopping because of halt request via signal.\n");
+            break;
+        }
+        else if (is_file(halt_file_name))
+        {
+            pso("Stopping because of halt request via file.\n");
+            EPE(kjb_unlink(halt_file_name));
+            break;
+        }
+        /*
+        // If we are not fitting both levels and clusters, then more iterations
+        // won't do much.
+        */
+        else if (    ((P_l_p_c_mvp == NULL) && (P_l_p_mp == NULL))
+                  || ((P_c_p_mpp == NULL) && (input_P_c_p_mp != NULL))
+                )
+        {
+            if (cluster_options_ptr->watch_2)
+            {
+                pso("\nStopping because we are not fitting both clusters and aspects.\n");
+            }
+            break;
+        }
 
-                                    if (max_con_norm_var > 0.0)
-                                    {
-                                        temp = MIN_OF(temp, max_con_norm_var);
-                                    }
+        else if (ll_rel_diff < iteration_tolerance)
+        {
+            break;
+        }
+    }
 
-                                    d += temp;
+    if (cluster_options_ptr->watch_2)
+    {
+        pso("\n---------\n");
+    }
 
-                                    ASSERT_IS_NUMBER_DBL(d);
-                                    ASSERT_IS_FINITE_DBL(d);
-                                }
+    if (fit_vp_ptr != NULL)
+    {
+        ERE(copy_vector(fit_vp_ptr, fit_vp));
+    }
 
-                                u_ptr++;
-                                v_ptr++;
-                                x_ptr++;
-                            }
+    free_cluster_membership_jobs(jobs, num_jobs);
+    free_vector(fit_vp);
+    free_vector(col_sum_vp);
 
-                            ASSERT_IS_NUMBER_DBL(d);
-                            ASSERT_IS_FINITE_DBL(d);
+    if (P_c_p_mpp != NULL)
+    {
+        /* Generally lock_P_c_p_mp is just P_c_p_mp. */
+        ERE(copy_matrix(P_c_p_mpp, lock_P_c_p_mp));
+    }
 
-                            log_prob = -0.5 * d;
+    free_matrix(P_c_p_mp);
+    free_vector(level_weight_vp);
 
-                            ASSERT_IS_NUMBER_DBL(log_prob);
-                            ASSERT_IS_FINITE_DBL(log_prob);
+#ifdef XXX_NOT_SURE_WHAT_IT_IS_DOING
+    free_matrix(con_score_mp);
+#endif
+    free_vector(con_score_vp);
+    free_int_vector(con_score_counts_vp);
 
-                            if (norm_continuous_features)
-                            {
-                                /*
-                                // FIX
-                                //
-                                // Not valid if features are limited, or if we
-                                // are selectively disabling features.
-                                */
-                                kjb_abort();
+    free_indexed_vector(sorted_l_p_vp);
 
-                                log_prob /= num_con_features;
-                            }
+    if (log_likelihood_ptr != NULL)
+    {
+        *log_likelihood_ptr = log_likelihood;
+    }
 
-                            log_prob -= norm;
+    return NO_ERROR;
+}
 
-                            ASSERT_IS_NUMBER_DBL(log_prob);
-                            ASSERT_IS_FINITE_DBL(log_prob);
+/*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\   */
 
+/*
+ * The E-step of get_cluster_membership_2() for one point. This writes only to
+ * the point's row of P_c_p_mp, its entry of fit_vp, its entries of P_l_p_c_mvp
+ * or its column of P_l_p_mp and level_index_mp, and to the work space of
+ * job_ptr.
+*/
+static int get_cluster_membership_of_point
+(
+    Cluster_membership_job* job_ptr,
+    int                     point
+)
+{
+    const Cluster_membership_input* input_ptr = job_ptr->input_ptr;
+    const Topology*      topology_ptr      = input_ptr->topology_ptr;
+    const int            first_level       = topology_ptr->first_level;
+    const int            last_level_num    = topology_ptr->last_level_num;
+    const Int_matrix*    node_mp           = topology_ptr->node_mp;
+    const Int_vector*    level_counts_vp   = topology_ptr->level_counts_vp;
+    const int            num_clusters      = topology_ptr->num_clusters;
+    const Cluster_data*  data_ptr          = input_ptr->data_ptr;
+    const Matrix_vector* P_i_n_mvp         = input_ptr->P_i_n_mvp;
+    const Matrix_vector* mean_mvp          = input_ptr->mean_mvp;
+    const int            max_num_dis_items = (P_i_n_mvp == NULL) ? 0 : data_ptr->max_num_dis_items;
+    const int            max_num_con_items = (mean_mvp == NULL) ? 0 : data_ptr->max_num_con_items;
+    const Int_matrix*    dis_item_mp       = (max_num_dis_items == 0) ? NULL : data_ptr->dis_item_mp;
+    const Matrix*        dis_item_multiplicity_mp = (max_num_dis_items == 0) ? NULL : data_ptr->dis_item_multiplicity_mp;
+    const Matrix_vector* con_item_mvp      = (max_num_con_items == 0) ? NULL : data_ptr->con_item_mvp;
+    const Matrix_vector* var_mvp           = input_ptr->var_mvp;
+    const Vector_vector* con_log_sqrt_det_vvp = input_ptr->con_log_sqrt_det_vvp;
+#ifdef HOW_IT_WAS_05_01_29
+    const int            num_con_features  = data_ptr->num_con_features;
+    const double         max_con_norm_var  = input_ptr->max_con_norm_var;
+#endif
 #ifdef XXX_LIMIT_MIN_CON_PROB
-                            if (log_prob + con_log_norm < min_con_log_prob)
-                            {
-                                num_g_prob_resets++;
-                                log_prob = min_con_log_prob - con_log_norm;
-                            }
+    const double         min_con_log_prob  = input_ptr->min_con_log_prob;
 #endif
-
-                            *con_prob_cache_ptr = log_prob;
-#ifdef HOW_IT_WAS
-                        }
-                        else
-                        {
-                            /*
-                            // This is not handled well below. We are moving
-                            // away from node culling, so this should really not
-                            // happen. Eventually, it should either never happen,
-                            // or be handled better.
-                            */
-                            *con_prob_cache_ptr = LOG_ZERO;
-                        }
+#ifdef TEST
+    const int            num_levels        = topology_ptr->num_levels;
+    const int            max_num_items     = max_num_dis_items + max_num_con_items;
+    const int            num_categories    = data_ptr->num_categories;
+#endif
+    const Vector_vector* con_item_weight_vvp = data_ptr->con_item_weight_vvp;
+    const Vector*        a_vp              = input_ptr->a_vp;
+    const Matrix*        V_mp              = input_ptr->V_mp;
+    const Matrix_vector* input_P_l_p_c_mvp = input_ptr->input_P_l_p_c_mvp;
+    const Matrix*        input_P_l_p_mp    = input_ptr->input_P_l_p_mp;
+    const double         con_log_norm      = input_ptr->con_log_norm;
+    const Int_vector*    con_feature_enable_vp = input_ptr->con_feature_enable_vp;
+    const Int_vector*    con_feature_group_vp  = input_ptr->con_feature_group_vp;
+    const double         con_score_cutoff  = input_ptr->con_score_cutoff;
+    const int            weight_con_items  = input_ptr->weight_con_items;
+    const int            norm_depend       = input_ptr->norm_depend;
+    const int            model_correspondence = input_ptr->model_correspondence;
+    const Vector*        dis_factor_vp     = input_ptr->dis_factor_vp;
+    const Vector*        con_factor_vp     = input_ptr->con_factor_vp;
+    const int            norm_continuous_features = input_ptr->norm_continuous_features;
+    const Multi_modal_cluster_options* cluster_options_ptr = input_ptr->cluster_options_ptr;
+    const int*           vector_feature_counts_ptr = input_ptr->vector_feature_counts_ptr;
+    const int            num_sparse_levels  = input_ptr->num_sparse_levels;
+    const int            first_sparse_level = input_ptr->first_sparse_level;
+    const Int_matrix*    level_index_mp     = input_ptr->level_index_mp;
+    const Vector*        con_score_vp       = input_ptr->con_score_vp;
+    const Int_vector_vector* missing_index_vvp = input_ptr->missing_index_vvp;
+    const Matrix*        lock_P_c_p_mp      = input_ptr->lock_P_c_p_mp;
+    Matrix*              P_c_p_mp           = input_ptr->P_c_p_mp;
+    const Matrix_vector* P_l_p_c_mvp        = input_ptr->P_l_p_c_mvp;
+    Matrix*              P_l_p_mp           = input_ptr->P_l_p_mp;
+    Vector*              fit_vp             = input_ptr->fit_vp;
+    Cluster_cache*       cache_ptr          = job_ptr->cache_ptr;
+    double***            level_indicators_ppp = cache_ptr->level_indicators_ppp;
+    Vector*              nu_vp              = job_ptr->nu_vp;
+    Vector*              log_nu_vp          = job_ptr->log_nu_vp;
+    Vector*              log_prob_vp        = job_ptr->log_prob_vp;
+    Vector*              nu_for_dependent_model_vp = job_ptr->nu_for_dependent_model_vp;
+    Vector*              level_weight_vp    = job_ptr->level_weight_vp;
+    Indexed_vector*      sorted_l_p_vp      = job_ptr->sorted_l_p_vp;
+    int                  level;
+    int                  cluster;
+    int                  dis_item;
+    int                  con_item;
+#ifdef TEST
+    int                  item;
+    int                  max_index = NOT_SET;
+#endif
+    double               dis_item_multiplicity;
+    double**             level_indicators_pp;
+    double*              level_indicators_p;
+    double               ll_con_correction_norm_sum = 0.0;
+    double               dis_factor;
+    double               con_factor;
+    double               max_log_prob;
+    double*              P_c_p_ptr;
+    double               fit_temp;
+    double               prob_sum;
+    int                  num_con_items;
+    double*              save_x_ptr;
+    Vector_vector*       con_prob_cache_vvp;
+    int                  num_nodes_this_level;
+    double*              con_prob_cache_ptr;
+    int                  node;
+#ifdef HOW_IT_WAS_05_01_29
+    double               d;
+    double*              u_ptr;
+    double*              v_ptr;
+    double*              x_ptr;
+    double               norm;
+    double               dev;
+    double               v;
+    int                  con_feature;
+#endif
+    double               temp;
+    double               log_prob;
+    int                  dis_item_found;
+    double               log_product;
+    double               product;
+    double               log_dis_prod;
+    double               log_con_prod;
+#ifdef TEST
+    double               sum_nu;
 #endif
+    int                  category;
+    double               level_sum;
+    double               log_prob_sum;
+    double               nu;
+    double               prob;
+    double               log_nu;
+    double               exp_temp;
+    double               exp_sum;
+    double               p;
+    int                  sparse_level;
 
-#else
-                        ASSERT_IS_LESS_INT(level, last_level_num);
-                        ASSERT_IS_NOT_LESS_INT(level, first_level);
-                        ASSERT_IS_NON_NEGATIVE_INT(first_level);
-                        ASSERT_IS_NON_NEGATIVE_INT(node);
-                        ASSERT_IS_LESS_INT(node, mean_mvp->elements[ level ]->num_rows);
-                        ASSERT_IS_LESS_INT(node, var_mvp->elements[ level ]->num_rows);
-                        ASSERT_IS_LESS_INT(node, con_log_sqrt_det_vvp->elements[ level ]->length);
 
-                        /*
-                         * This is a stop gap until we make this routine call
-                         * do_multi_modal_clustering_4().
-                        */
-                        ERE(compute_con_prob(con_feature_enable_vp,
-                                             con_feature_group_vp,
-                                             save_x_ptr,
-                                             mean_mvp->elements[ level ]->elements[ node ],
-                                             var_mvp->elements[ level ]->elements[ node ],
-                                             con_log_sqrt_det_vvp->elements[ level ]->elements[ node ],
-                                             norm_continuous_features,
-                                             fs_limit_gaussian_deviation,
-                                             fs_max_con_norm_var,
-                                             fs_vector_feature_counts_ptr,
-                                             con_prob_cache_ptr,
-                                             NULL, FALSE));
+    dis_factor = (dis_factor_vp == NULL) ? 1.0 : dis_factor_vp->elements[ point ];
+    con_factor = (con_factor_vp == NULL) ? 1.0 : con_factor_vp->elements[ point ];
+    num_con_items = (max_num_con_items == 0) ? 0 : con_item_mvp->elements[ point ]->num_rows;
 
-#endif
-                        con_prob_cache_ptr++;
-                    }
-                }
-            }
+    if (max_num_con_items > 0)
+    {
+        ll_con_correction_norm_sum = 0.0;
+    }
+
+    /*
+    // Cache the probability calculations so that they are done only
+    // once per node as opposed to num_levels*num_cluster times.
+    */
+    for (con_item = 0; con_item < num_con_items; con_item++)
+    {
+        save_x_ptr = con_item_mvp->elements[ point ]->elements[ con_item ];
+        con_prob_cache_vvp = cache_ptr->con_prob_cache_vvvp->elements[ con_item ];
+
+        for (level = first_level; level < last_level_num; level++)
+        {
+            num_nodes_this_level = level_counts_vp->elements[ level ];
+            con_prob_cache_ptr   = con_prob_cache_vvp->elements[ level ]->elements;
+
+            for (node = 0; node < num_nodes_this_level; node++)
+            {
+#ifdef HOW_IT_WAS_05_01_29
+                d        = 0.0;
+                u_ptr    = mean_mvp->elements[ level ]->elements[ node ];
+                v_ptr    = var_mvp->elements[ level ]->elements[ node ];
+                x_ptr    = save_x_ptr;
+                norm     = con_log_sqrt_det_vvp->elements[ level ]->elements[ node ];
+
+                ASSERT_IS_POSITIVE_INT(num_con_features);
+
+#ifdef HOW_IT_WAS
+                if (*v_ptr > 0.0)
+                {
+#endif
+                    ASSERT_IS_NUMBER_DBL(norm);
+                    ASSERT_IS_FINITE_DBL(norm);
+
+                    for (con_feature = 0; con_feature < num_con_features; con_feature++)
+                    {
+                        v = *v_ptr;
+
+                        if (v > 0.0)
+                        {
+                            dev = *u_ptr - *x_ptr;
+                            temp = (dev / v) * dev;
+
+                            ASSERT_IS_NUMBER_DBL(dev);
+                            ASSERT_IS_FINITE_DBL(dev);
+
+                            ASSERT_IS_NUMBER_DBL(v);
+                            ASSERT_IS_FINITE_DBL(v);
+
+                            ASSERT_IS_NUMBER_DBL(temp);
+                            ASSERT_IS_FINITE_DBL(temp);
+
+                            if (max_con_norm_var > 0.0)
+                            {
+                                temp = MIN_OF(temp, max_con_norm_var);
+                            }
+
+                            d += temp;
+
+                            ASSERT_IS_NUMBER_DBL(d);
+                            ASSERT_IS_FINITE_DBL(d);
+                        }
+
+                        u_ptr++;
+                        v_ptr++;
+                        x_ptr++;
+                    }
+
+                    ASSERT_IS_NUMBER_DBL(d);
+                    ASSERT_IS_FINITE_DBL(d);
+
+                    log_prob = -0.5 * d;
+
+                    ASSERT_IS_NUMBER_DBL(log_prob);
+                    ASSERT_IS_FINITE_DBL(log_prob);
+
+                    if (norm_continuous_features)
+                    {
+                        /*
+                        // FIX
+                        //
+                        // Not valid if features are limited, or if we
+                        // are selectively disabling features.
+                        */
+                        kjb_abort();
+
+                        log_prob /= num_con_features;
+                    }
+
+                    log_prob -= norm;
+
+                    ASSERT_IS_NUMBER_DBL(log_prob);
+                    ASSERT_IS_FINITE_DBL(log_prob);
+
+#ifdef XXX_LIMIT_MIN_CON_PROB
+                    if (log_prob + con_log_norm < min_con_log_prob)
+                    {
+                        num_g_prob_resets++;
+                        log_prob = min_con_log_prob - con_log_norm;
+                    }
+#endif
+
+                    *con_prob_cache_ptr = log_prob;
+#ifdef HOW_IT_WAS
+                }
+                else
+                {
+                    /*
+                    // This is not handled well below. We are moving
+                    // away from node culling, so this should really not
+                    // happen. Eventually, it should either never happen,
+                    // or be handled better.
+                    */
+                    *con_prob_cache_ptr = LOG_ZERO;
+                }
+#endif
+
+#else
+                ASSERT_IS_LESS_INT(level, last_level_num);
+                ASSERT_IS_NOT_LESS_INT(level, first_level);
+                ASSERT_IS_NON_NEGATIVE_INT(first_level);
+                ASSERT_IS_NON_NEGATIVE_INT(node);
+                ASSERT_IS_LESS_INT(node, mean_mvp->elements[ level ]->num_rows);
+                ASSERT_IS_LESS_INT(node, var_mvp->elements[ level ]->num_rows);
+                ASSERT_IS_LESS_INT(node, con_log_sqrt_det_vvp->elements[ level ]->length);
+
+                /*
+                 * This is a stop gap until we make this routine call
+                 * do_multi_modal_clustering_4().
+                */
+                ERE(compute_con_prob(con_feature_enable_vp,
+                                     con_feature_group_vp,
+                                     save_x_ptr,
+                                     mean_mvp->elements[ level ]->elements[ node ],
+                                     var_mvp->elements[ level ]->elements[ node ],
+                                     con_log_sqrt_det_vvp->elements[ level ]->elements[ node ],
+                                     norm_continuous_features,
+                                     cluster_options_ptr->limit_gaussian_deviation,
+                                     cluster_options_ptr->max_con_norm_var,
+                                     vector_feature_counts_ptr,
+                                     con_prob_cache_ptr,
+                                     &(job_ptr->max_con_log_prob),
+                                     (missing_index_vvp == NULL) ? FALSE : missing_index_vvp->elements[ point ]->elements[ con_item ]));
+
+#endif
+                con_prob_cache_ptr++;
+            }
+        }
+    }
 
 #ifdef TEST
 /* TEST */  for (cluster = 0; cluster < num_clusters; cluster++)
@@ -17637,19 +18670,19 @@ static int get_cluster_membership_2
 /* TEST */  }
 #endif
 
-            /*
-             * I am not sure what this was for, or if it is ever used anymore.
-             * It looks like pre-processing for normalizing to prevent over-flow
-            */
-            if (con_score_cutoff > DBL_HALF_MOST_NEGATIVE / 2.0)
-            {
-                dbp("--------------------------------------");
-                dbp("I am not sure when this is used!");
-                dbp("--------------------------------------");
-                dbe(con_score_cutoff);
-                dbp("--------------------------------------");
+    /*
+     * I am not sure what this was for, or if it is ever used anymore.
+     * It looks like pre-processing for normalizing to prevent over-flow
+    */
+    if (con_score_cutoff > DBL_HALF_MOST_NEGATIVE / 2.0)
+    {
+        dbp("--------------------------------------");
+        dbp("I am not sure when this is used!");
+        dbp("--------------------------------------");
+        dbe(con_score_cutoff);
+        dbp("--------------------------------------");
 
-                kjb_abort();
+        kjb_abort();
 
 #ifdef XXX_NOT_SURE_WHAT_IT_IS_DOING
 XXX                  ERE(ow_zero_int_vector(con_score_counts_vp));
@@ -17742,7 +18775,7 @@ XXX  #endif
 XXX
 XXX                      for (con_item = 0; con_item < num_con_items; con_item++)
 XXX                      {
-XXX                          con_prob_cache_vvp = fs_con_prob_cache_vvvp->elements[ con_item ];
+XXX                          con_prob_cache_vvp = cache_ptr->con_prob_cache_vvvp->elements[ con_item ];
 XXX                          prob_sum = 0.0;
 XXX                          max_log_prob = DBL_MOST_NEGATIVE;
 XXX
@@ -17767,11 +18800,11 @@ XXX                              i = con_score_counts_vp->elements[ con_item ];
 XXX                              con_score_mp->elements[ con_item ][ i ] = log_prob;
 XXX
 XXX  #ifdef XXX_SUPPORT_TRIMMING
-XXX                              if (fs_trim_hack == 1)
+XXX                              if (cluster_options_ptr->trim_hack == 1)
 XXX                              {
 XXX                                  (con_score_mp->elements[ con_item ][ i ]) += log_a;
 XXX                              }
-XXX                              else if (fs_trim_hack == 2)
+XXX                              else if (cluster_options_ptr->trim_hack == 2)
 XXX                              {
 XXX                                  (con_score_mp->elements[ con_item ][ i ]) += log(P_c_p_mp->elements[ point ][ cluster ]);
 XXX                              }
@@ -17793,23 +18826,23 @@ XXX                      ERE(copy_vector(&(con_score_vpp->elements[ point ]),
 XXX                                      con_score_vp));
 XXX                  }
 #endif
-            }
+    }
 
-            /* XXXXXXXXXXX   Above code not likely to be relavent.   XXXX  */
+    /* XXXXXXXXXXX   Above code not likely to be relavent.   XXXX  */
 
-            for (cluster = 0; cluster < num_clusters; cluster++)
-            {
-                int num_good_con_items = 0;
+    for (cluster = 0; cluster < num_clusters; cluster++)
+    {
+        int num_good_con_items = 0;
 
-                dis_item_found  = FALSE;
-                product         = a_vp->elements[ cluster ];
-                log_dis_prod    = 0.0;
-                log_con_prod    = 0.0;
+        dis_item_found  = FALSE;
+        product         = a_vp->elements[ cluster ];
+        log_dis_prod    = 0.0;
+        log_con_prod    = 0.0;
 #ifdef TEST
-                sum_nu         = 0.0;
+        sum_nu         = 0.0;
 #endif
 
-                log_product = SAFE_LOG(product);
+        log_product = SAFE_LOG(product);
 
 #ifdef NU_SHOULD_NOT_BE_INDEXED_BY_SPARSE_LEVEL
 XXX                  /*
@@ -17900,81 +18933,78 @@ XXX  #endif
 XXX
 #else
 
-                /*
-                // Cache the level weights, taking logs if we are using logs for
-                // probs.
-                */
-                for (level = first_level; level < last_level_num; level++)
-                {
-                    if (V_mp != NULL)
-                    {
-                        nu = V_mp->elements[ level ][ cluster ];
-                    }
-                    else if (input_P_l_p_c_mvp != NULL)
-                    {
-                        nu = input_P_l_p_c_mvp->elements[ level ]->elements[ point ][ cluster ];
-                    }
-                    else if (input_P_l_p_mp != NULL)
-                    {
-                        UNTESTED_CODE();
-                        dbx(input_P_l_p_mp);
-                        nu = input_P_l_p_mp->elements[level ][ point ];
-                    }
-                    else
-                    {
-                        SET_CANT_HAPPEN_BUG();
-                        return ERROR;
-                    }
+        /*
+        // Cache the level weights, taking logs if we are using logs for
+        // probs.
+        */
+        for (level = first_level; level < last_level_num; level++)
+        {
+            if (V_mp != NULL)
+            {
+                nu = V_mp->elements[ level ][ cluster ];
+            }
+            else if (input_P_l_p_c_mvp != NULL)
+            {
+                nu = input_P_l_p_c_mvp->elements[ level ]->elements[ point ][ cluster ];
+            }
+            else if (input_P_l_p_mp != NULL)
+            {
+                nu = input_P_l_p_mp->elements[level ][ point ];
+            }
+            else
+            {
+                SET_CANT_HAPPEN_BUG();
+                return ERROR;
+            }
 #ifdef TEST
-                    sum_nu += nu;
+            sum_nu += nu;
 #endif
 
-                    nu_vp->elements[ level ] = nu;
+            nu_vp->elements[ level ] = nu;
 
-                    log_nu_vp->elements[ level ] = SAFE_LOG(nu);
-                }
+            log_nu_vp->elements[ level ] = SAFE_LOG(nu);
+        }
 
 #ifdef TEST
-                ASSERT_IS_LESS_DBL(sum_nu, 1.01);
-                ASSERT_IS_NOT_LESS_DBL(sum_nu, 0.99);
+        ASSERT_IS_LESS_DBL(sum_nu, 1.01);
+        ASSERT_IS_NOT_LESS_DBL(sum_nu, 0.99);
 #endif
 
 #endif
 
-                if ((model_correspondence == 1) && (num_con_items > 0))
-                {
-                    ERE(get_zero_vector(&nu_for_dependent_model_vp,
-                                        num_levels));
-                }
+        if ((model_correspondence == 1) && (num_con_items > 0))
+        {
+            ERE(ow_zero_vector(nu_for_dependent_model_vp));
+        }
 
-                for (con_item = 0; con_item < num_con_items; con_item++)
-                {
-                    exp_sum       = 0.0;
-                    max_log_prob  = DBL_MOST_NEGATIVE;
-                    con_prob_cache_vvp = fs_con_prob_cache_vvvp->elements[ con_item ];
+        for (con_item = 0; con_item < num_con_items; con_item++)
+        {
+            exp_sum       = 0.0;
+            max_log_prob  = DBL_MOST_NEGATIVE;
+            con_prob_cache_vvp = cache_ptr->con_prob_cache_vvvp->elements[ con_item ];
 
 #ifdef TEST
-                    ERE(ow_set_vector(log_prob_vp, DBL_NOT_SET));
+            ERE(ow_set_vector(log_prob_vp, DBL_NOT_SET));
 #endif
 
 
 
-                    if (    (con_score_cutoff > DBL_HALF_MOST_NEGATIVE / 2.0)
-                         && (con_score_vp->elements[ con_item ] < con_score_cutoff)
-                       )
-                    {
-                        dbs("Executing rare code?");
+            if (    (con_score_cutoff > DBL_HALF_MOST_NEGATIVE / 2.0)
+                 && (con_score_vp->elements[ con_item ] < con_score_cutoff)
+               )
+            {
+                dbs("Executing rare code?");
 
-                        if (level_index_mp != NULL)
-                        {
-                            for (level = first_level; level < last_level_num; level++)
-                            {
-                                level_indicators_pp = level_indicators_ppp[ level ];
-                                level_indicators_p = level_indicators_pp[ cluster ];
-                                level_indicators_p += (max_num_dis_items + con_item);
-                                *level_indicators_p = 0.0;
-                            }
-                        }
+                if (level_index_mp != NULL)
+                {
+                    for (level = first_level; level < last_level_num; level++)
+                    {
+                        level_indicators_pp = level_indicators_ppp[ level ];
+                        level_indicators_p = level_indicators_pp[ cluster ];
+                        level_indicators_p += (max_num_dis_items + con_item);
+                        *level_indicators_p = 0.0;
+                    }
+                }
 
 #ifdef NU_SHOULD_NOT_BE_INDEXED_BY_SPARSE_LEVEL
 XXX                          for (sparse_level = first_sparse_level; sparse_level < num_sparse_levels; sparse_level++)
@@ -18000,25 +19030,25 @@ XXX
 XXX                              *level_indicators_p = nu_vp->elements[ sparse_level ];
 XXX                          }
 #else
-                        for (level = first_level; level < last_level_num; level++)
-                        {
-                            level_indicators_pp = level_indicators_ppp[ level ];
-                            level_indicators_p = level_indicators_pp[ cluster ];
+                for (level = first_level; level < last_level_num; level++)
+                {
+                    level_indicators_pp = level_indicators_ppp[ level ];
+                    level_indicators_p = level_indicators_pp[ cluster ];
 
-                            /* CHECK */
-                            /* Why no deference to con_item? */
-                            /* Added the following line on June 21, 2004 */
+                    /* CHECK */
+                    /* Why no deference to con_item? */
+                    /* Added the following line on June 21, 2004 */
 
-                            level_indicators_p += (max_num_dis_items + con_item);
+                    level_indicators_p += (max_num_dis_items + con_item);
 
-                            *level_indicators_p = nu_vp->elements[ level ];
-                        }
+                    *level_indicators_p = nu_vp->elements[ level ];
+                }
 #endif
 
-                        continue;
-                    }
+                continue;
+            }
 
-                    num_good_con_items++;
+            num_good_con_items++;
 
 #ifdef NU_SHOULD_NOT_BE_INDEXED_BY_SPARSE_LEVEL
 XXX                      for (sparse_level = first_sparse_level; sparse_level < num_sparse_levels; sparse_level++)
@@ -18058,204 +19088,196 @@ XXX
 XXX                          log_prob_vp->elements[ sparse_level ] = exp_temp;
 XXX                      }
 #else
-                    for (level = first_level; level < last_level_num; level++)
-                    {
-                        log_nu = log_nu_vp->elements[ level ];
-                        node     = node_mp->elements[ cluster ][ level ];
-                        log_prob = con_prob_cache_vvp->elements[ level ]->elements[ node ];
+            for (level = first_level; level < last_level_num; level++)
+            {
+                log_nu = log_nu_vp->elements[ level ];
+                node     = node_mp->elements[ cluster ][ level ];
+                log_prob = con_prob_cache_vvp->elements[ level ]->elements[ node ];
 
-                        ASSERT_IS_NUMBER_DBL(log_prob);
-                        ASSERT_IS_FINITE_DBL(log_prob);
+                ASSERT_IS_NUMBER_DBL(log_prob);
+                ASSERT_IS_FINITE_DBL(log_prob);
 
-                        log_prob += log_nu;
+                log_prob += log_nu;
 
-                        ASSERT_IS_NUMBER_DBL(log_prob);
-                        ASSERT_IS_FINITE_DBL(log_prob);
+                ASSERT_IS_NUMBER_DBL(log_prob);
+                ASSERT_IS_FINITE_DBL(log_prob);
 
-                        max_log_prob = MAX_OF(max_log_prob, log_prob);
-                        log_prob_vp->elements[ level ] = log_prob;
-                    }
+                max_log_prob = MAX_OF(max_log_prob, log_prob);
+                log_prob_vp->elements[ level ] = log_prob;
+            }
 
-                    for (level = first_level; level < last_level_num; level++)
-                    {
-                        temp = log_prob_vp->elements[ level ] - max_log_prob;
-                        exp_temp = exp(temp);
+            for (level = first_level; level < last_level_num; level++)
+            {
+                temp = log_prob_vp->elements[ level ] - max_log_prob;
+                exp_temp = exp(temp);
 
-                        exp_sum += exp_temp;
+                exp_sum += exp_temp;
 
-                        log_prob_vp->elements[ level ] = exp_temp;
-                    }
+                log_prob_vp->elements[ level ] = exp_temp;
+            }
 #endif
 
-                    log_prob_sum = SAFE_LOG(exp_sum) + max_log_prob;
+            log_prob_sum = SAFE_LOG(exp_sum) + max_log_prob;
 
-                    ASSERT_IS_NUMBER_DBL(log_prob_sum);
-                    ASSERT_IS_FINITE_DBL(log_prob_sum);
+            ASSERT_IS_NUMBER_DBL(log_prob_sum);
+            ASSERT_IS_FINITE_DBL(log_prob_sum);
 
 #ifdef NU_SHOULD_NOT_BE_INDEXED_BY_SPARSE_LEVEL
-                    if (level_index_mp != NULL)
-                    {
-                        for (level = first_level; level < last_level_num; level++)
-                        {
-                            level_indicators_pp = level_indicators_ppp[ level ];
-                            level_indicators_p = level_indicators_pp[ cluster ];
-                            level_indicators_p += (max_num_dis_items + con_item);
-                            *level_indicators_p = 0.0;
-                        }
-                    }
+            if (level_index_mp != NULL)
+            {
+                for (level = first_level; level < last_level_num; level++)
+                {
+                    level_indicators_pp = level_indicators_ppp[ level ];
+                    level_indicators_p = level_indicators_pp[ cluster ];
+                    level_indicators_p += (max_num_dis_items + con_item);
+                    *level_indicators_p = 0.0;
+                }
+            }
 
-                    for (sparse_level = first_sparse_level; sparse_level < num_sparse_levels; sparse_level++)
-                    {
-                        if (level_index_mp != NULL)
-                        {
-                            level = level_index_mp->elements[ sparse_level ][ point ];
-                        }
-                        else
-                        {
-                            level = sparse_level;
-                        }
-                        /*
-                        // Force indirection in case compiler can't figure out
-                        // how to do this efficiently.
-                        */
-                        level_indicators_pp = level_indicators_ppp[ level ];
-                        level_indicators_p = level_indicators_pp[ cluster ];
-                        level_indicators_p += (max_num_dis_items + con_item);
-                        *level_indicators_p = log_prob_vp->elements[ sparse_level ] / exp_sum;
-                    }
+            for (sparse_level = first_sparse_level; sparse_level < num_sparse_levels; sparse_level++)
+            {
+                if (level_index_mp != NULL)
+                {
+                    level = level_index_mp->elements[ sparse_level ][ point ];
+                }
+                else
+                {
+                    level = sparse_level;
+                }
+                /*
+                // Force indirection in case compiler can't figure out
+                // how to do this efficiently.
+                */
+                level_indicators_pp = level_indicators_ppp[ level ];
+                level_indicators_p = level_indicators_pp[ cluster ];
+                level_indicators_p += (max_num_dis_items + con_item);
+                *level_indicators_p = log_prob_vp->elements[ sparse_level ] / exp_sum;
+            }
 #else
+            for (level = first_level; level < last_level_num; level++)
+            {
+                /*
+                // Force indirection in case compiler can't figure out
+                // how to do this efficiently.
+                */
+                level_indicators_pp = level_indicators_ppp[ level ];
+                level_indicators_p = level_indicators_pp[ cluster ];
+                level_indicators_p += (max_num_dis_items + con_item);
+                *level_indicators_p = log_prob_vp->elements[ level ] / exp_sum;
+            }
+#endif
+
+            if (model_correspondence == 1)
+            {
+                double con_item_weight = 1.0;
+
+                if ((weight_con_items) && (con_item_weight_vvp != NULL))
+                {
+                    con_item_weight = con_item_weight_vvp->elements[point]->elements[con_item];
+                }
+
+                if (norm_depend)
+                {
+                    level_sum = 0.0;
+
                     for (level = first_level; level < last_level_num; level++)
                     {
-                        /*
-                        // Force indirection in case compiler can't figure out
-                        // how to do this efficiently.
-                        */
                         level_indicators_pp = level_indicators_ppp[ level ];
-                        level_indicators_p = level_indicators_pp[ cluster ];
-                        level_indicators_p += (max_num_dis_items + con_item);
-                        *level_indicators_p = log_prob_vp->elements[ level ] / exp_sum;
+                        level_indicators_p = level_indicators_pp[ cluster ] + max_num_dis_items + con_item;
+                        level_sum += (*level_indicators_p);
                     }
-#endif
 
-                    if (model_correspondence == 1)
-                    {
-                        double con_item_weight = 1.0;
+                    con_item_weight /= level_sum;
+                }
 
-                        if ((weight_con_items) && (con_item_weight_vvp != NULL))
-                        {
-                            static int first_time = TRUE;
+                for (level = first_level; level < last_level_num; level++)
+                {
+                    level_indicators_pp = level_indicators_ppp[ level ];
+                    level_indicators_p = level_indicators_pp[ cluster ] + max_num_dis_items + con_item;
+                    nu_for_dependent_model_vp->elements[ level ] += con_item_weight * (*level_indicators_p);
+                }
+            }
 
-                            if (first_time)
-                            {
-                                first_time = FALSE;
-                                dbp("Weighting continous items.\n");
-                            }
+            log_con_prod += log_prob_sum;
 
-                            con_item_weight = con_item_weight_vvp->elements[point]->elements[con_item];
-                        }
-
-                        if (norm_depend)
-                        {
-                            level_sum = 0.0;
-
-                            for (level = first_level; level < last_level_num; level++)
-                            {
-                                level_indicators_pp = level_indicators_ppp[ level ];
-                                level_indicators_p = level_indicators_pp[ cluster ] + max_num_dis_items + con_item;
-                                level_sum += (*level_indicators_p);
-                            }
-
-                            con_item_weight /= level_sum;
-                        }
-
-                        for (level = first_level; level < last_level_num; level++)
-                        {
-                            level_indicators_pp = level_indicators_ppp[ level ];
-                            level_indicators_p = level_indicators_pp[ cluster ] + max_num_dis_items + con_item;
-                            nu_for_dependent_model_vp->elements[ level ] += con_item_weight * (*level_indicators_p);
-                        }
-                    }
-
-                    log_con_prod += log_prob_sum;
-
-                    ASSERT_IS_NUMBER_DBL(log_con_prod);
-                    ASSERT_IS_FINITE_DBL(log_con_prod);
-                }
+            ASSERT_IS_NUMBER_DBL(log_con_prod);
+            ASSERT_IS_FINITE_DBL(log_con_prod);
+        }
 
 #ifdef TEST
-                if (con_score_cutoff < DBL_HALF_MOST_NEGATIVE / 2.0)
-                {
-                    ASSERT_IS_EQUAL_INT(num_con_items, num_good_con_items);
-                }
+        if (con_score_cutoff < DBL_HALF_MOST_NEGATIVE / 2.0)
+        {
+            ASSERT_IS_EQUAL_INT(num_con_items, num_good_con_items);
+        }
 #endif
-                if (num_good_con_items > 0)
-                {
-                    ASSERT_IS_NUMBER_DBL(con_factor);
-                    ASSERT_IS_FINITE_DBL(con_factor);
-                    ASSERT_IS_NON_NEGATIVE_DBL(con_factor);
+        if (num_good_con_items > 0)
+        {
+            ASSERT_IS_NUMBER_DBL(con_factor);
+            ASSERT_IS_FINITE_DBL(con_factor);
+            ASSERT_IS_NON_NEGATIVE_DBL(con_factor);
 
-                    log_product += (log_con_prod * con_factor);
-                }
+            log_product += (log_con_prod * con_factor);
+        }
 
-                ASSERT_IS_NUMBER_DBL(log_product);
-                ASSERT_IS_FINITE_DBL(log_product);
+        ASSERT_IS_NUMBER_DBL(log_product);
+        ASSERT_IS_FINITE_DBL(log_product);
 
-                ASSERT_IS_NOT_LESS_DBL(log_product,
-                                      MIN_LOG_PROB_CLUSTER_GIVEN_POINT / 2.0);
+        ASSERT_IS_NOT_LESS_DBL(log_product,
+                              MIN_LOG_PROB_CLUSTER_GIVEN_POINT / 2.0);
 
 #ifdef NORMALIZE_NU_FOR_DEPENDENT_MODEL
-                /*
-                // This has little effect -- mostly in the computation of
-                // the likelihood.
-                */
-                if (model_correspondence == 1)
-                {
-                    if (nu_for_dependent_model_vp != NULL)
-                    {
-                        ERE(ow_scale_vector_by_sum(nu_for_dependent_model_vp));
-                    }
+        /*
+        // This has little effect -- mostly in the computation of
+        // the likelihood.
+        */
+        if (model_correspondence == 1)
+        {
+            if (nu_for_dependent_model_vp != NULL)
+            {
+                ERE(ow_scale_vector_by_sum(nu_for_dependent_model_vp));
+            }
 #ifdef TEST
-                    else
-                    {
-                        ASSERT(nu_with_prior_mp != NULL);
-                    }
+            else
+            {
+                ASSERT(nu_with_prior_mp != NULL);
+            }
 #endif
-                }
+        }
 #endif
 
-                for (dis_item = 0; dis_item < max_num_dis_items; dis_item++)
-                {
-                    category = dis_item_mp->elements[ point ][ dis_item ];
+        for (dis_item = 0; dis_item < max_num_dis_items; dis_item++)
+        {
+            category = dis_item_mp->elements[ point ][ dis_item ];
 #ifdef TEST
-                    sum_nu = 0.0;
+            sum_nu = 0.0;
 #endif
-                    prob_sum = 0.0;
+            prob_sum = 0.0;
 
-                    if (category < 0) break;
+            if (category < 0) break;
 
-                    ASSERT_IS_LESS_INT(category , num_categories);
+            ASSERT_IS_LESS_INT(category , num_categories);
 
-                    dis_item_found = TRUE;
-                    dis_item_multiplicity = dis_item_multiplicity_mp->elements[ point ][ dis_item ];
+            dis_item_found = TRUE;
+            dis_item_multiplicity = dis_item_multiplicity_mp->elements[ point ][ dis_item ];
 
-                    /* Safest to force non-sparse elements to zero. */
-                    if (level_index_mp != NULL)
-                    {
-                        for (level = first_level; level < last_level_num; level++)
-                        {
-                            level_indicators_pp = level_indicators_ppp[ level ];
-                            level_indicators_p = level_indicators_pp[ cluster ];
-                            level_indicators_p += dis_item;
-                            *level_indicators_p = 0.0;
-                        }
-                    }
+            /* Safest to force non-sparse elements to zero. */
+            if (level_index_mp != NULL)
+            {
+                for (level = first_level; level < last_level_num; level++)
+                {
+                    level_indicators_pp = level_indicators_ppp[ level ];
+                    level_indicators_p = level_indicators_pp[ cluster ];
+                    level_indicators_p += dis_item;
+                    *level_indicators_p = 0.0;
+                }
+            }
 
 #ifdef NU_SHOULD_NOT_BE_INDEXED_BY_SPARSE_LEVEL
 XXX                      for (sparse_level = first_sparse_level; sparse_level < num_sparse_levels; sparse_level++)
 #else
-                    for (level = first_level; level < last_level_num; level++)
+            for (level = first_level; level < last_level_num; level++)
 #endif
-                    {
+            {
 #ifdef NU_SHOULD_NOT_BE_INDEXED_BY_SPARSE_LEVEL
 XXX                          if (level_index_mp != NULL)
 XXX                          {
@@ -18267,93 +19289,93 @@ XXX                              level = sparse_level;
 XXX                          }
 #endif
 
-                        verify_probability_matrix(P_i_n_mvp->elements[ level ], NULL);
+                verify_probability_matrix(P_i_n_mvp->elements[ level ], NULL);
 
-                        node = node_mp->elements[ cluster ][ level ];
+                node = node_mp->elements[ cluster ][ level ];
 
-                        ASSERT_IS_NON_NEGATIVE_INT(node);
-                        ASSERT_IS_LESS_INT(node, P_i_n_mvp->elements[ level ]->num_rows);
-                        ASSERT_IS_NON_NEGATIVE_INT(category);
-                        ASSERT_IS_LESS_INT(category, P_i_n_mvp->elements[ level ]->num_cols);
+                ASSERT_IS_NON_NEGATIVE_INT(node);
+                ASSERT_IS_LESS_INT(node, P_i_n_mvp->elements[ level ]->num_rows);
+                ASSERT_IS_NON_NEGATIVE_INT(category);
+                ASSERT_IS_LESS_INT(category, P_i_n_mvp->elements[ level ]->num_cols);
 
-                        prob = P_i_n_mvp->elements[ level ]->elements[ node ][ category ];
+                prob = P_i_n_mvp->elements[ level ]->elements[ node ][ category ];
 
-                        if ((num_con_items > 0) && (model_correspondence == 1))
-                        {
-                            nu = nu_for_dependent_model_vp->elements[ level ];
-                        }
-                        else
-                        {
+                if ((num_con_items > 0) && (model_correspondence == 1))
+                {
+                    nu = nu_for_dependent_model_vp->elements[ level ];
+                }
+                else
+                {
 #ifdef NU_SHOULD_NOT_BE_INDEXED_BY_SPARSE_LEVEL
-                            nu = nu_vp->elements[ sparse_level ];
+                    nu = nu_vp->elements[ sparse_level ];
 #else
-                            nu = nu_vp->elements[ level ];
+                    nu = nu_vp->elements[ level ];
 #endif
 
 #ifdef TEST
 /* TEST */                  sum_nu += nu;
 #endif
-                        }
+                }
 
-                        level_indicators_pp = level_indicators_ppp[ level ];
+                level_indicators_pp = level_indicators_ppp[ level ];
 
-                        ASSERT_IS_NUMBER_DBL(prob);
-                        ASSERT_IS_FINITE_DBL(prob);
-                        ASSERT_IS_NON_NEGATIVE_DBL(prob);
+                ASSERT_IS_NUMBER_DBL(prob);
+                ASSERT_IS_FINITE_DBL(prob);
+                ASSERT_IS_NON_NEGATIVE_DBL(prob);
 
-                        ASSERT_IS_NUMBER_DBL(nu);
-                        ASSERT_IS_FINITE_DBL(nu);
-                        ASSERT_IS_NON_NEGATIVE_DBL(nu);
+                ASSERT_IS_NUMBER_DBL(nu);
+                ASSERT_IS_FINITE_DBL(nu);
+                ASSERT_IS_NON_NEGATIVE_DBL(nu);
 
-                        prob *= nu;
+                prob *= nu;
 
-                        ASSERT_IS_NUMBER_DBL(prob);
-                        ASSERT_IS_FINITE_DBL(prob);
-                        ASSERT_IS_NON_NEGATIVE_DBL(prob);
+                ASSERT_IS_NUMBER_DBL(prob);
+                ASSERT_IS_FINITE_DBL(prob);
+                ASSERT_IS_NON_NEGATIVE_DBL(prob);
 
-                        level_indicators_pp[ cluster ][ dis_item ] = prob;
-                        prob_sum += prob;
+                level_indicators_pp[ cluster ][ dis_item ] = prob;
+                prob_sum += prob;
 
-                        ASSERT_IS_NUMBER_DBL(prob_sum);
-                        ASSERT_IS_FINITE_DBL(prob_sum);
-                        ASSERT_IS_NON_NEGATIVE_DBL(prob_sum);
-                    }
+                ASSERT_IS_NUMBER_DBL(prob_sum);
+                ASSERT_IS_FINITE_DBL(prob_sum);
+                ASSERT_IS_NON_NEGATIVE_DBL(prob_sum);
+            }
 
 #ifdef TEST
-                    if ( ! ((num_con_items > 0) && (model_correspondence == 1)))
+            if ( ! ((num_con_items > 0) && (model_correspondence == 1)))
+            {
+                if (level_index_mp == NULL)
+                {
+                    ASSERT_IS_LESS_DBL(sum_nu, 1.01);
+                    ASSERT_IS_NOT_LESS_DBL(sum_nu, 0.99);
+                }
+                else
+                {
+                    if (sum_nu < 0.25)
                     {
-                        if (level_index_mp == NULL)
-                        {
-                            ASSERT_IS_LESS_DBL(sum_nu, 1.01);
-                            ASSERT_IS_NOT_LESS_DBL(sum_nu, 0.99);
-                        }
-                        else
-                        {
-                            if (sum_nu < 0.25)
-                            {
-                                warn_pso(" : Sparse level weights have captured less then 1/4 of full weight.\n");
-                                warn_pso(" :     Sum nu is %.3e.\n", sum_nu);
-                                warn_pso(" :     Point %d with respect to cluster %d.\n", point, cluster);
-                            }
-                        }
+                        warn_pso(" : Sparse level weights have captured less then 1/4 of full weight.\n");
+                        warn_pso(" :     Sum nu is %.3e.\n", sum_nu);
+                        warn_pso(" :     Point %d with respect to cluster %d.\n", point, cluster);
                     }
+                }
+            }
 #endif
 
-                    ASSERT_IS_NUMBER_DBL(prob_sum);
-                    ASSERT_IS_FINITE_DBL(prob_sum);
-                    ASSERT_IS_NON_NEGATIVE_DBL(prob_sum);
+            ASSERT_IS_NUMBER_DBL(prob_sum);
+            ASSERT_IS_FINITE_DBL(prob_sum);
+            ASSERT_IS_NON_NEGATIVE_DBL(prob_sum);
 
-                    log_prob_sum = SAFE_LOG(prob_sum);
+            log_prob_sum = SAFE_LOG(prob_sum);
 
-                    ASSERT_IS_NUMBER_DBL(log_prob_sum);
-                    ASSERT_IS_FINITE_DBL(log_prob_sum);
+            ASSERT_IS_NUMBER_DBL(log_prob_sum);
+            ASSERT_IS_FINITE_DBL(log_prob_sum);
 
 #ifdef DONT_USE_SPARSE_HERE
-                    for (sparse_level = first_sparse_level; sparse_level < num_sparse_levels; sparse_level++)
+            for (sparse_level = first_sparse_level; sparse_level < num_sparse_levels; sparse_level++)
 #else
-                    for (level = first_level; level < last_level_num; level++)
+            for (level = first_level; level < last_level_num; level++)
 #endif
-                    {
+            {
 #ifdef DONT_USE_SPARSE_HERE
 XXX                          if (level_index_mp != NULL)
 XXX                          {
@@ -18365,539 +19387,1583 @@ XXX                              level = sparse_level;
 XXX                          }
 #endif
 
-                        /*
-                        // Force indirection in case compiler can't figure out
-                        // how to do this efficiently.
-                        */
-                        level_indicators_pp = level_indicators_ppp[ level ];
-                        level_indicators_p = level_indicators_pp[ cluster ];
+                /*
+                // Force indirection in case compiler can't figure out
+                // how to do this efficiently.
+                */
+                level_indicators_pp = level_indicators_ppp[ level ];
+                level_indicators_p = level_indicators_pp[ cluster ];
 
-                        level_indicators_p += dis_item;
+                level_indicators_p += dis_item;
 
-                        ASSERT_IS_NUMBER_DBL(*level_indicators_p);
-                        ASSERT_IS_FINITE_DBL(*level_indicators_p);
-                        ASSERT_IS_NUMBER_DBL(*level_indicators_p);
+                ASSERT_IS_NUMBER_DBL(*level_indicators_p);
+                ASSERT_IS_FINITE_DBL(*level_indicators_p);
+                ASSERT_IS_NUMBER_DBL(*level_indicators_p);
 
-                        *level_indicators_p /= prob_sum;
+                *level_indicators_p /= prob_sum;
 
-                        ASSERT_IS_NUMBER_DBL(*level_indicators_p);
-                        ASSERT_IS_FINITE_DBL(*level_indicators_p);
-                        ASSERT_IS_PROB_DBL(*level_indicators_p);
-                    }
+                ASSERT_IS_NUMBER_DBL(*level_indicators_p);
+                ASSERT_IS_FINITE_DBL(*level_indicators_p);
+                ASSERT_IS_PROB_DBL(*level_indicators_p);
+            }
 
-                    log_dis_prod += (log_prob_sum * dis_item_multiplicity);
-                }
+            log_dis_prod += (log_prob_sum * dis_item_multiplicity);
+        }
 
-                if (dis_item_found)
-                {
-                    ASSERT_IS_NUMBER_DBL(dis_factor);
-                    ASSERT_IS_FINITE_DBL(dis_factor);
-                    ASSERT_IS_NON_NEGATIVE_DBL(dis_factor);
-                    ASSERT_IS_GREATER_DBL(dis_factor, 1e-10);
+        if (dis_item_found)
+        {
+            ASSERT_IS_NUMBER_DBL(dis_factor);
+            ASSERT_IS_FINITE_DBL(dis_factor);
+            ASSERT_IS_NON_NEGATIVE_DBL(dis_factor);
+            ASSERT_IS_GREATER_DBL(dis_factor, 1e-10);
 
-                    log_product += (log_dis_prod * dis_factor);
-                }
+            log_product += (log_dis_prod * dis_factor);
+        }
 
-                ASSERT_IS_NUMBER_DBL(log_product);
-                ASSERT_IS_FINITE_DBL(log_product);
+        ASSERT_IS_NUMBER_DBL(log_product);
+        ASSERT_IS_FINITE_DBL(log_product);
 
-                ASSERT_IS_NOT_LESS_DBL(log_product,
-                                       MIN_LOG_PROB_CLUSTER_GIVEN_POINT / 2.0);
+        ASSERT_IS_NOT_LESS_DBL(log_product,
+                               MIN_LOG_PROB_CLUSTER_GIVEN_POINT / 2.0);
 
-                /*
-                // If there were no good con items, then this should be
-                // log(a).
-                */
-                P_c_p_mp->elements[ point ][ cluster ] = log_product;
-            }
+        /*
+        // If there were no good con items, then this should be
+        // log(a).
+        */
+        P_c_p_mp->elements[ point ][ cluster ] = log_product;
+    }
 
-            if (num_con_items > 0)
-            {
-                ASSERT_IS_NUMBER_DBL(con_factor);
-                ASSERT_IS_FINITE_DBL(con_factor);
-                ASSERT_IS_NON_NEGATIVE_DBL(con_factor);
+    if (num_con_items > 0)
+    {
+        ASSERT_IS_NUMBER_DBL(con_factor);
+        ASSERT_IS_FINITE_DBL(con_factor);
+        ASSERT_IS_NON_NEGATIVE_DBL(con_factor);
 
-                ll_con_correction_norm_sum += (double)num_con_items * con_factor;
-            }
+        ll_con_correction_norm_sum += (double)num_con_items * con_factor;
+    }
 
 #ifdef TEST
-            for (cluster = 0; cluster < num_clusters; cluster++)
+    for (cluster = 0; cluster < num_clusters; cluster++)
+    {
+        for (item = 0; item < max_num_items; item++)
+        {
+            for (level = 0; level < num_levels; level++)
             {
-                for (item = 0; item < max_num_items; item++)
-                {
-                    for (level = 0; level < num_levels; level++)
-                    {
-                        level_indicators_pp = level_indicators_ppp[ level ];
-                        level_indicators_p = level_indicators_pp[ cluster ];
+                level_indicators_pp = level_indicators_ppp[ level ];
+                level_indicators_p = level_indicators_pp[ cluster ];
 
-                        level_indicators_p += item;
+                level_indicators_p += item;
 
-                        if (    (item < max_num_dis_items)
-                             && (dis_item_mp->elements[ point ][ item ] < 0)
-                           )
-                        {
-                            ASSERT_IS_EQUAL_DBL(*level_indicators_p,
-                                                DBL_NOT_SET);
-                        }
-                        else if (item >= max_num_dis_items + num_con_items)
-                        {
-                            ASSERT_IS_EQUAL_DBL(*level_indicators_p,
-                                                DBL_NOT_SET);
-                        }
-                        else if (level < first_level)
-                        {
-                            ASSERT_IS_EQUAL_DBL(*level_indicators_p,
-                                                DBL_NOT_SET);
-                        }
-                        else if (level >= last_level_num)
-                        {
-                            ASSERT_IS_EQUAL_DBL(*level_indicators_p,
-                                                DBL_NOT_SET);
-                        }
-                        else
-                        {
-                            ASSERT_IS_NUMBER_DBL(*level_indicators_p);
-                            ASSERT_IS_FINITE_DBL(*level_indicators_p);
-                            ASSERT_IS_NON_NEGATIVE_DBL(*level_indicators_p);
-                            ASSERT_IS_PROB_DBL(*level_indicators_p);
-                        }
-                    }
+                if (    (item < max_num_dis_items)
+                     && (dis_item_mp->elements[ point ][ item ] < 0)
+                   )
+                {
+                    ASSERT_IS_EQUAL_DBL(*level_indicators_p,
+                                        DBL_NOT_SET);
+                }
+                else if (item >= max_num_dis_items + num_con_items)
+                {
+                    ASSERT_IS_EQUAL_DBL(*level_indicators_p,
+                                        DBL_NOT_SET);
+                }
+                else if (level < first_level)
+                {
+                    ASSERT_IS_EQUAL_DBL(*level_indicators_p,
+                                        DBL_NOT_SET);
+                }
+                else if (level >= last_level_num)
+                {
+                    ASSERT_IS_EQUAL_DBL(*level_indicators_p,
+                                        DBL_NOT_SET);
+                }
+                else
+                {
+                    ASSERT_IS_NUMBER_DBL(*level_indicators_p);
+                    ASSERT_IS_FINITE_DBL(*level_indicators_p);
+                    ASSERT_IS_NON_NEGATIVE_DBL(*level_indicators_p);
+                    ASSERT_IS_PROB_DBL(*level_indicators_p);
                 }
             }
+        }
+    }
 #endif
 
-            max_log_prob = DBL_MOST_NEGATIVE;
+    max_log_prob = DBL_MOST_NEGATIVE;
 
-            P_c_p_ptr = P_c_p_mp->elements[ point ];
+    P_c_p_ptr = P_c_p_mp->elements[ point ];
 
-            for (cluster = 0; cluster < num_clusters; cluster++)
-            {
+    for (cluster = 0; cluster < num_clusters; cluster++)
+    {
 #ifdef TEST
-                ASSERT_IS_NOT_LESS_DBL(*P_c_p_ptr,
-                                      MIN_LOG_PROB_CLUSTER_GIVEN_POINT);
+        ASSERT_IS_NOT_LESS_DBL(*P_c_p_ptr,
+                              MIN_LOG_PROB_CLUSTER_GIVEN_POINT);
 
-                if (*P_c_p_ptr > max_log_prob)
-                {
-                    max_index = cluster;
-                }
+        if (*P_c_p_ptr > max_log_prob)
+        {
+            max_index = cluster;
+        }
 #endif
-                max_log_prob = MAX_OF(max_log_prob, *P_c_p_ptr);
+        max_log_prob = MAX_OF(max_log_prob, *P_c_p_ptr);
 
-                P_c_p_ptr++;
-            }
+        P_c_p_ptr++;
+    }
 
-            P_c_p_ptr = P_c_p_mp->elements[ point ];
+    P_c_p_ptr = P_c_p_mp->elements[ point ];
 
-            for (cluster = 0; cluster < num_clusters; cluster++)
-            {
-                 *P_c_p_ptr -= max_log_prob;
-                 P_c_p_ptr++;
-            }
+    for (cluster = 0; cluster < num_clusters; cluster++)
+    {
+         *P_c_p_ptr -= max_log_prob;
+         P_c_p_ptr++;
+    }
 
 #ifdef TEST
-            ASSERT(KJB_IS_SET(max_index));
-            ASSERT_IS_EQUAL_DBL(P_c_p_mp->elements[ point ][ max_index ], 0.0);
+    ASSERT(KJB_IS_SET(max_index));
+    ASSERT_IS_EQUAL_DBL(P_c_p_mp->elements[ point ][ max_index ], 0.0);
 #endif
 
-            P_c_p_ptr = P_c_p_mp->elements[ point ];
+    P_c_p_ptr = P_c_p_mp->elements[ point ];
 
-            for (cluster = 0; cluster < num_clusters; cluster++)
-            {
-                 *P_c_p_ptr = exp(*P_c_p_ptr);
-                 P_c_p_ptr++;
-            }
+    for (cluster = 0; cluster < num_clusters; cluster++)
+    {
+         *P_c_p_ptr = exp(*P_c_p_ptr);
+         P_c_p_ptr++;
+    }
 
 #ifdef TEST
-            ASSERT_IS_EQUAL_DBL(P_c_p_mp->elements[ point ][ max_index ], 1.0);
+    ASSERT_IS_EQUAL_DBL(P_c_p_mp->elements[ point ][ max_index ], 1.0);
 #endif
 
-            prob_sum = sum_matrix_row_elements(P_c_p_mp, point);
+    prob_sum = sum_matrix_row_elements(P_c_p_mp, point);
 
-            fit_temp = SAFE_LOG(prob_sum);
+    fit_temp = SAFE_LOG(prob_sum);
 
-            fit_temp += max_log_prob;
-            fit_temp += (con_log_norm * ll_con_correction_norm_sum);
+    fit_temp += max_log_prob;
+    fit_temp += (con_log_norm * ll_con_correction_norm_sum);
 
-            fit_vp->elements[ point ] = fit_temp;
+    fit_vp->elements[ point ] = fit_temp;
 
-            ASSERT_IS_NOT_LESS_DBL(prob_sum, 1.0);
+    ASSERT_IS_NOT_LESS_DBL(prob_sum, 1.0);
 
-            ERE(ow_divide_matrix_row_by_scalar(P_c_p_mp, prob_sum, point));
+    ERE(ow_divide_matrix_row_by_scalar(P_c_p_mp, prob_sum, point));
 
 #ifdef TEST
-            ASSERT_IS_EQUAL_INT(P_c_p_mp->num_cols, num_clusters);
+    ASSERT_IS_EQUAL_INT(P_c_p_mp->num_cols, num_clusters);
 
-            if (num_clusters == 1)
-            {
-                ASSERT_IS_EQUAL_DBL(P_c_p_mp->elements[ point ][ 0 ], 1.0);
-            }
+    if (num_clusters == 1)
+    {
+        ASSERT_IS_EQUAL_DBL(P_c_p_mp->elements[ point ][ 0 ], 1.0);
+    }
 #endif
 
-            /*
-             * Weight each level weight by cluster membership.
-            */
-            for (cluster = 0; cluster < num_clusters; cluster++)
-            {
-                /* Generally lock_P_c_p_mp is just P_c_p_mp. */
-                p = lock_P_c_p_mp->elements[ point ][ cluster ];
+    /*
+     * Weight each level weight by cluster membership.
+    */
+    for (cluster = 0; cluster < num_clusters; cluster++)
+    {
+        /* Generally lock_P_c_p_mp is just P_c_p_mp. */
+        p = lock_P_c_p_mp->elements[ point ][ cluster ];
 
-                ASSERT_IS_NUMBER_DBL(p);
-                ASSERT_IS_FINITE_DBL(p);
-                ASSERT_IS_NON_NEGATIVE_DBL(p);
-                ASSERT_IS_PROB_DBL(p);
+        ASSERT_IS_NUMBER_DBL(p);
+        ASSERT_IS_FINITE_DBL(p);
+        ASSERT_IS_NON_NEGATIVE_DBL(p);
+        ASSERT_IS_PROB_DBL(p);
 
 #ifdef DONT_USE_SPARSE_HERE
-                for (sparse_level = first_sparse_level; sparse_level < num_sparse_levels; sparse_level++)
+        for (sparse_level = first_sparse_level; sparse_level < num_sparse_levels; sparse_level++)
 #else
-                for (level = first_level; level < last_level_num; level++)
+        for (level = first_level; level < last_level_num; level++)
 #endif
-                {
+        {
 #ifdef DONT_USE_SPARSE_HERE
-                    if (level_index_mp != NULL)
-                    {
-                        level = level_index_mp->elements[ sparse_level ][ point ];
-                    }
-                    else
-                    {
-                        level = sparse_level;
-                    }
-#endif
-
-                    level_indicators_pp = level_indicators_ppp[ level ];
-                    level_indicators_p = level_indicators_pp[ cluster ];
+            if (level_index_mp != NULL)
+            {
+                level = level_index_mp->elements[ sparse_level ][ point ];
+            }
+            else
+            {
+                level = sparse_level;
+            }
+#endif
+
+            level_indicators_pp = level_indicators_ppp[ level ];
+            level_indicators_p = level_indicators_pp[ cluster ];
+
+            for (dis_item = 0; dis_item < max_num_dis_items; dis_item++)
+            {
+                category = dis_item_mp->elements[ point ][ dis_item ];
+
+                if (category < 0) break;
+
+                ASSERT_IS_LESS_INT(category, num_categories);
+
+                *level_indicators_p *= p;
+                level_indicators_p++;
+            }
+
+            level_indicators_p = level_indicators_pp[ cluster ];
+            level_indicators_p += max_num_dis_items;
+
+            for (con_item = 0; con_item < num_con_items; con_item++)
+            {
+                *level_indicators_p *= p;
+                level_indicators_p++;
+            }
+        }
+    }
+
+    if (P_l_p_c_mvp != NULL)
+    {
+        for (cluster = 0; cluster < num_clusters; cluster++)
+        {
+            level_sum = 0.0;
+
+            for (level = first_level; level < last_level_num; level++)
+            {
+                prob_sum = 0.0;
+
+                level_indicators_pp = level_indicators_ppp[ level ];
+                level_indicators_p = level_indicators_pp[ cluster ];
+
+                for (dis_item = 0; dis_item < max_num_dis_items; dis_item++)
+                {
+                    category = dis_item_mp->elements[ point ][ dis_item ];
+
+                    /*
+                    // Can't use break on negative unless use of item
+                    // is adjusted.
+                    */
+                    if (category < 0) break;
+
+                    ASSERT_IS_LESS_INT(category, num_categories);
+
+                    ASSERT_IS_NUMBER_DBL(*level_indicators_p);
+                    ASSERT_IS_FINITE_DBL(*level_indicators_p);
+                    ASSERT_IS_NON_NEGATIVE_DBL(*level_indicators_p);
+
+                    prob_sum += *level_indicators_p;
+
+                    level_indicators_p++;
+                }
+
+                level_indicators_p = level_indicators_pp[ cluster ] + max_num_dis_items;
+
+                for (con_item = 0; con_item < num_con_items; con_item++)
+                {
+                    ASSERT_IS_NUMBER_DBL(*level_indicators_p);
+                    ASSERT_IS_FINITE_DBL(*level_indicators_p);
+                    ASSERT_IS_NON_NEGATIVE_DBL(*level_indicators_p);
+
+                    prob_sum += *level_indicators_p;
+
+                    level_indicators_p++;
+                }
+
+                ASSERT_IS_NUMBER_DBL(prob_sum);
+                ASSERT_IS_FINITE_DBL(prob_sum);
+                ASSERT_IS_NON_NEGATIVE_DBL(prob_sum);
+
+                P_l_p_c_mvp->elements[ level ]->elements[ point ][ cluster ] = prob_sum;
+                level_sum += prob_sum;
+            }
+
+            if (level_sum > 10.0 * DBL_MIN)
+            {
+                for (level = first_level; level < last_level_num; level++)
+                {
+                    P_l_p_c_mvp->elements[ level ]->elements[ point ][ cluster ] /= level_sum;
+                }
+            }
+            else
+            {
+                for (level = first_level; level < last_level_num; level++)
+                {
+                    P_l_p_c_mvp->elements[ level ]->elements[ point ][ cluster ] = 1.0 / (last_level_num - first_level);
+                }
+            }
+        }
+    }
+    else if (P_l_p_mp != NULL)
+    {
+        /*
+         * Compute the level weights by marginalizing over items and
+         * clusters. The cluster weight is already in the level weights
+        */
+
+#ifdef DONT_USE_SPARSE_HERE
+        level_sum = 0.0;
+
+        for (sparse_level = first_sparse_level; sparse_level < num_sparse_levels; sparse_level++)
+#else
+        for (level = first_level; level < last_level_num; level++)
+#endif
+        {
+            double cluster_sum = 0.0;
+
+#ifdef DONT_USE_SPARSE_HERE
+            if (level_index_mp != NULL)
+            {
+                level = level_index_mp->elements[ sparse_level ][ point ];
+            }
+            else
+            {
+                level = sparse_level;
+            }
+#endif
+
+            for (cluster = 0; cluster < num_clusters; cluster++)
+            {
+                prob_sum = 0.0;
+
+                level_indicators_pp = level_indicators_ppp[ level ];
+                level_indicators_p = level_indicators_pp[ cluster ];
+
+                for (dis_item = 0; dis_item < max_num_dis_items; dis_item++)
+                {
+                    category = dis_item_mp->elements[ point ][ dis_item ];
+
+                    /*
+                    // Can't use break on negative unless use of item
+                    // is adjusted.
+                    */
+                    if (category < 0) break;
+
+                    ASSERT_IS_LESS_INT(category, num_categories);
+
+                    ASSERT_IS_NUMBER_DBL(*level_indicators_p);
+                    ASSERT_IS_FINITE_DBL(*level_indicators_p);
+                    ASSERT_IS_NON_NEGATIVE_DBL(*level_indicators_p);
+
+                    prob_sum += *level_indicators_p;
+
+                    level_indicators_p++;
+                }
+
+                level_indicators_p = level_indicators_pp[ cluster ] + max_num_dis_items;
+
+                for (con_item = 0; con_item < num_con_items; con_item++)
+                {
+                    ASSERT_IS_NUMBER_DBL(*level_indicators_p);
+                    ASSERT_IS_FINITE_DBL(*level_indicators_p);
+                    ASSERT_IS_NON_NEGATIVE_DBL(*level_indicators_p);
+
+                    /*
+                     * Likely only correct for depend=-1.
+                    */
+                    prob_sum += (*level_indicators_p);
+
+                    level_indicators_p++;
+                }
+
+                ASSERT_IS_NUMBER_DBL(prob_sum);
+                ASSERT_IS_FINITE_DBL(prob_sum);
+                ASSERT_IS_NON_NEGATIVE_DBL(prob_sum);
+
+
+                cluster_sum += prob_sum;
+            }
+
+#ifdef DONT_USE_SPARSE_HERE
+            P_l_p_mp->elements[ sparse_level ][ point ] = cluster_sum;
+            level_sum += cluster_sum;
+#else
+            level_weight_vp->elements[ level ] = cluster_sum;
+#endif
+        }
+
+        if (level_index_mp != NULL)
+        {
+            sort_level_weights(sorted_l_p_vp, level_weight_vp);
+
+            for (sparse_level = first_sparse_level; sparse_level < num_sparse_levels; sparse_level++)
+            {
+                 P_l_p_mp->elements[ sparse_level ][ point ] = sorted_l_p_vp->elements[ sparse_level ].element;
+                 level_index_mp->elements[ sparse_level ][ point ] = sorted_l_p_vp->elements[ sparse_level ].index;
+            }
+        }
+        else
+        {
+            ERE(put_matrix_col(P_l_p_mp, level_weight_vp, point));
+        }
+
+        level_sum = sum_matrix_col_elements(P_l_p_mp, point);
+
+        if (level_sum > 10.0 * DBL_MIN)
+        {
+            for (sparse_level = first_sparse_level; sparse_level < num_sparse_levels; sparse_level++)
+            {
+                P_l_p_mp->elements[ sparse_level ][ point ] /= level_sum;
+            }
+        }
+        else
+        {
+            for (sparse_level = first_sparse_level; sparse_level < num_sparse_levels; sparse_level++)
+            {
+                P_l_p_mp->elements[ sparse_level ][ point ] = 1.0 / (num_sparse_levels - first_sparse_level);
+            }
+        }
+    }
+
+    return NO_ERROR;
+}
+
+/*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\   */
+
+/*
+ * Finds the cluster membership of the points [first_point, last_point) of
+ * job_ptr. Once get_cluster_membership_2() has checked the model, nothing here
+ * sets an error or allocates, so it can run in any thread.
+*/
+static void* cluster_membership_job_main(void* arg)
+{
+    Cluster_membership_job* job_ptr          = (Cluster_membership_job*)arg;
+    const Int_vector*       points_to_use_vp = job_ptr->input_ptr->points_to_use_vp;
+    int                     point;
+    int                     count            = 0;
+
+
+    job_ptr->result = NO_ERROR;
+
+    for (point = job_ptr->first_point; point < job_ptr->last_point; point++)
+    {
+        if (    (points_to_use_vp != NULL)
+             && (points_to_use_vp->elements[ point ] == 0)
+           )
+        {
+            continue;
+        }
+
+        if (get_cluster_membership_of_point(job_ptr, point) == ERROR)
+        {
+            job_ptr->result = ERROR;
+            break;
+        }
+
+        count++;
+
+        if ((job_ptr->report_progress) && (count % 1000 == 0))
+        {
+            verbose_pso(5, "%d points processed for get_cluster_membership_2() iteration %d.\n",
+                        count, job_ptr->iteration + 1);
+        }
+    }
+
+    return NULL;
+}
+
+/*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\   */
+
+/*
+ * Runs the jobs for one iteration. The first job is done in this thread, as
+ * are any whose thread could not be started.
+*/
+static int run_cluster_membership_jobs
+(
+    Cluster_membership_job* jobs,
+    int                     num_jobs,
+    int                     iteration
+)
+{
+    kjb_pthread_t* threads = NULL;
+    int*           started = NULL;
+    int            result  = NO_ERROR;
+    int            t;
+
+
+    if (num_jobs > 1)
+    {
+        threads = N_TYPE_MALLOC(kjb_pthread_t, num_jobs);
+        started = INT_MALLOC(num_jobs);
+
+        /* Without these, all the work is done in this thread. */
+        if ((threads == NULL) || (started == NULL))
+        {
+            kjb_clear_error();
+        }
+    }
+
+    for (t = 0; t < num_jobs; t++)
+    {
+        jobs[ t ].iteration = iteration;
+        jobs[ t ].report_progress = (t == 0);
+    }
+
+    for (t = 1; t < num_jobs; t++)
+    {
+        if ((threads != NULL) && (started != NULL))
+        {
+            started[ t ] = kjb_pthread_create(&threads[ t ], NULL,
+                                              cluster_membership_job_main,
+                                              &jobs[ t ]) != ERROR;
+        }
+    }
+
+    cluster_membership_job_main(&jobs[ 0 ]);
+
+    for (t = 1; t < num_jobs; t++)
+    {
+        if ((threads != NULL) && (started != NULL) && (started[ t ]))
+        {
+            kjb_pthread_join(threads[ t ], NULL);
+        }
+        else
+        {
+            cluster_membership_job_main(&jobs[ t ]);
+        }
+    }
+
+    for (t = 0; t < num_jobs; t++)
+    {
+        if (jobs[ t ].result == ERROR)
+        {
+            result = ERROR;
+        }
+    }
+
+    kjb_free(started);
+    kjb_free(threads);
+
+    return result;
+}
+
+/*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\   */
+
+/*
+ * Splits the points over the jobs. Each job has its own caches and work
+ * space, except that the first uses cache_ptr.
+*/
+static int get_cluster_membership_jobs
+(
+    Cluster_membership_job**        jobs_ptr,
+    int*                            num_jobs_ptr,
+    const Cluster_membership_input* input_ptr,
+    Cluster_cache*                  cache_ptr,
+    int                             num_points,
+    int                             max_num_items
+)
+{
+    const Topology*         topology_ptr      = input_ptr->topology_ptr;
+    const int               num_levels        = topology_ptr->num_levels;
+    const int               max_num_con_items = (input_ptr->mean_mvp == NULL) ? 0 : input_ptr->data_ptr->max_num_con_items;
+    Cluster_membership_job* jobs;
+    int                     num_jobs;
+    int                     t;
+
+
+    num_jobs = get_cluster_num_threads(input_ptr->cluster_options_ptr);
+    num_jobs = MIN_OF(num_jobs,
+                      1 + num_points / MIN_POINTS_PER_MEMBERSHIP_THREAD);
+
+    NRE(jobs = N_TYPE_MALLOC(Cluster_membership_job, num_jobs));
+
+    for (t = 0; t < num_jobs; t++)
+    {
+        jobs[ t ].input_ptr = input_ptr;
+        jobs[ t ].cache_ptr = (t == 0) ? cache_ptr : &(jobs[ t ].cache);
+        jobs[ t ].nu_vp = NULL;
+        jobs[ t ].log_nu_vp = NULL;
+        jobs[ t ].log_prob_vp = NULL;
+        jobs[ t ].nu_for_dependent_model_vp = NULL;
+        jobs[ t ].level_weight_vp = NULL;
+        jobs[ t ].sorted_l_p_vp = NULL;
+        jobs[ t ].first_point = (int)(((long)num_points * t) / num_jobs);
+        jobs[ t ].last_point = (int)(((long)num_points * (t + 1)) / num_jobs);
+        jobs[ t ].iteration = 0;
+        jobs[ t ].report_progress = FALSE;
+        jobs[ t ].result = NO_ERROR;
+        jobs[ t ].max_con_log_prob = DBL_MOST_NEGATIVE;
+
+        init_cluster_cache(&(jobs[ t ].cache));
+    }
+
+    *jobs_ptr = jobs;
+    *num_jobs_ptr = num_jobs;
+
+    for (t = 0; t < num_jobs; t++)
+    {
+        Cluster_membership_job* job_ptr = &(jobs[ t ]);
+
+        ERE(initialize_level_indicators_cache(job_ptr->cache_ptr,
+                                              num_levels,
+                                              topology_ptr->num_clusters,
+                                              max_num_items));
+        ERE(initialize_con_prob_cache(job_ptr->cache_ptr,
+                                      max_num_con_items,
+                                      topology_ptr->first_level,
+                                      topology_ptr->last_level_num,
+                                      num_levels,
+                                      topology_ptr->level_counts_vp));
+
+#ifdef NU_SHOULD_NOT_BE_INDEXED_BY_SPARSE_LEVEL
+        ERE(get_zero_vector(&(job_ptr->nu_vp), input_ptr->num_sparse_levels));
+        ERE(get_zero_vector(&(job_ptr->log_nu_vp), input_ptr->num_sparse_levels));
+        ERE(get_zero_vector(&(job_ptr->log_prob_vp), input_ptr->num_sparse_levels));
+#else
+        ERE(get_zero_vector(&(job_ptr->nu_vp), num_levels));
+        ERE(get_zero_vector(&(job_ptr->log_nu_vp), num_levels));
+        ERE(get_zero_vector(&(job_ptr->log_prob_vp), num_levels));
+#endif
+        ERE(get_zero_vector(&(job_ptr->nu_for_dependent_model_vp), num_levels));
+        ERE(get_zero_vector(&(job_ptr->level_weight_vp), num_levels));
+        ERE(get_target_indexed_vector(&(job_ptr->sorted_l_p_vp), num_levels));
+    }
+
+    return NO_ERROR;
+}
+
+/*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\   */
+
+static void free_cluster_membership_jobs
+(
+    Cluster_membership_job* jobs,
+    int                     num_jobs
+)
+{
+    int t;
+
+
+    if (jobs == NULL) return;
+
+    for (t = 0; t < num_jobs; t++)
+    {
+        free_vector(jobs[ t ].nu_vp);
+        free_vector(jobs[ t ].log_nu_vp);
+        free_vector(jobs[ t ].log_prob_vp);
+        free_vector(jobs[ t ].nu_for_dependent_model_vp);
+        free_vector(jobs[ t ].level_weight_vp);
+        free_indexed_vector(jobs[ t ].sorted_l_p_vp);
+
+        /* Unused by the first job, which has the cache of the caller. */
+        free_cluster_cache(&(jobs[ t ].cache));
+    }
+
+    kjb_free(jobs);
+}
+
+/*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\   */
+
+/*
+ * Whether the E-step of an iteration of do_multi_modal_clustering_4() can be
+ * done by training jobs. They do the standard model once it is valid. The
+ * initialization, limited cluster membership, specified clusters, sampling,
+ * the correspondence models, and items other than discrete and continuous
+ * ones are left to the loop over points.
+*/
+static int can_use_training_jobs
+(
+    const Training_options*            options_ptr,
+    const Multi_modal_cluster_options* cluster_options_ptr,
+    const Cluster_data*                data_ptr,
+    int                                it,
+    int                                num_clusters,
+    int                                num_clusters_used,
+    int                                num_limited_clusters
+)
+{
+    if (it == 0) return FALSE;
+    if (options_ptr->model_correspondence != 0) return FALSE;
+    if (num_clusters_used != num_clusters) return FALSE;
+    if (num_limited_clusters != num_clusters) return FALSE;
+    if (cluster_options_ptr->use_specified_clusters) return FALSE;
+    if (cluster_options_ptr->sample_count > 0) return FALSE;
+
+    if ((cluster_options_ptr->use_blob_prior) && (data_ptr->blob_word_prior_mvp != NULL))
+    {
+        return FALSE;
+    }
+
+    if (    (data_ptr->max_num_dis_items > 0)
+         && (data_ptr->max_num_con_items > 0)
+         && (    (it < cluster_options_ptr->min_it_for_con_items)
+              || (it < cluster_options_ptr->min_it_for_dis_items)
+            )
+       )
+    {
+        return FALSE;
+    }
+
+    if ((data_ptr->max_num_vec_items > 0) || (data_ptr->max_num_his_items > 0))
+    {
+        return FALSE;
+    }
+
+#ifdef XXX_SUPPORT_TRIMMING
+    if (options_ptr->trim_fraction > 0.0) return FALSE;
+#endif
+
+#ifdef SUPPORT_ANNEALING
+    if (it < cluster_options_ptr->num_cooling_iterations) return FALSE;
+#endif
+
+#ifdef SUPPORT_IGNORE_DIS_PROB
+    if (cluster_options_ptr->ignore_dis_prob_fraction > 0.0) return FALSE;
+#endif
+
+    return TRUE;
+}
+
+/*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\   */
+
+/*
+ * Does the E-step of one training iteration, and adds the statistics of the
+ * M-step to those of total_ptr. The points are split into the slices of
+ * input_ptr, each of which is summed by one job, in the thread of that job.
+ * The slices are then added to the total in order, so the result does not
+ * depend on the number of threads.
+*/
+static int do_training_e_step_with_jobs
+(
+    Cluster_training_statistics*  total_ptr,
+    const Cluster_training_input* input_ptr,
+    Cluster_cache*                cache_ptr,
+    int                           max_num_items,
+    int                           iteration
+)
+{
+    const int               num_slices       = input_ptr->num_slices;
+    Cluster_membership_job* membership_jobs  = NULL;
+    int                     num_membership_jobs = 0;
+    int                     num_jobs         = 0;
+    Cluster_training_job*   jobs             = NULL;
+    kjb_pthread_t*          threads          = NULL;
+    int*                    started          = NULL;
+    int                     result           = NO_ERROR;
+    int                     first_slice;
+    int                     t;
+
+
+    result = get_cluster_membership_jobs(&membership_jobs,
+                                         &num_membership_jobs,
+                                         input_ptr->membership_input_ptr,
+                                         cache_ptr, input_ptr->num_points,
+                                         max_num_items);
+
+    if (result != ERROR)
+    {
+        num_jobs = MIN_OF(num_membership_jobs, num_slices);
+        jobs = N_TYPE_MALLOC(Cluster_training_job, num_jobs);
+        if (jobs == NULL) result = ERROR;
+    }
+
+    if (result != ERROR)
+    {
+        for (t = 0; t < num_jobs; t++)
+        {
+            jobs[ t ].input_ptr = input_ptr;
+            jobs[ t ].membership_job_ptr = &(membership_jobs[ t ]);
+            jobs[ t ].slice = NOT_SET;
+            jobs[ t ].result = NO_ERROR;
+
+            membership_jobs[ t ].iteration = iteration;
+            membership_jobs[ t ].report_progress = FALSE;
+        }
+
+        for (t = 0; t < num_jobs; t++)
+        {
+            if (result == ERROR)
+            {
+                /* So that free_training_statistics() can be used on all. */
+                get_zero_training_statistics(&(jobs[ t ].statistics),
+                                             (const Cluster_training_statistics*)NULL);
+            }
+            else
+            {
+                result = get_zero_training_statistics(&(jobs[ t ].statistics),
+                                                      total_ptr);
+            }
+        }
+    }
+
+    if ((result != ERROR) && (num_jobs > 1))
+    {
+        threads = N_TYPE_MALLOC(kjb_pthread_t, num_jobs);
+        started = INT_MALLOC(num_jobs);
 
-                    for (dis_item = 0; dis_item < max_num_dis_items; dis_item++)
-                    {
-                        category = dis_item_mp->elements[ point ][ dis_item ];
+        /* Without these, all the work is done in this thread. */
+        if ((threads == NULL) || (started == NULL))
+        {
+            kjb_clear_error();
+        }
+    }
 
-                        if (category < 0) break;
+    for (first_slice = 0;
+         (result != ERROR) && (first_slice < num_slices);
+         first_slice += num_jobs)
+    {
+        for (t = 0; t < num_jobs; t++)
+        {
+            jobs[ t ].slice = first_slice + t;
+        }
 
-                        ASSERT_IS_LESS_INT(category, num_categories);
+        for (t = 1; t < num_jobs; t++)
+        {
+            if ((threads != NULL) && (started != NULL) && (jobs[ t ].slice < num_slices))
+            {
+                started[ t ] = kjb_pthread_create(&threads[ t ], NULL,
+                                                  cluster_training_job_main,
+                                                  &jobs[ t ]) != ERROR;
+            }
+        }
 
-                        *level_indicators_p *= p;
-                        level_indicators_p++;
-                    }
+        cluster_training_job_main(&jobs[ 0 ]);
 
-                    level_indicators_p = level_indicators_pp[ cluster ];
-                    level_indicators_p += max_num_dis_items;
+        for (t = 1; t < num_jobs; t++)
+        {
+            if (jobs[ t ].slice >= num_slices) continue;
 
-                    for (con_item = 0; con_item < num_con_items; con_item++)
-                    {
-                        *level_indicators_p *= p;
-                        level_indicators_p++;
-                    }
-                }
+            if ((threads != NULL) && (started != NULL) && (started[ t ]))
+            {
+                kjb_pthread_join(threads[ t ], NULL);
+            }
+            else
+            {
+                cluster_training_job_main(&jobs[ t ]);
             }
+        }
+
+        /* The sums of the slices are added in order. */
+        for (t = 0; t < num_jobs; t++)
+        {
+            if (jobs[ t ].slice >= num_slices) continue;
 
-            if (P_l_p_c_mvp != NULL)
+            if (jobs[ t ].result == ERROR)
             {
-                for (cluster = 0; cluster < num_clusters; cluster++)
-                {
-                    level_sum = 0.0;
+                result = ERROR;
+            }
+            else if (result != ERROR)
+            {
+                result = ow_add_training_statistics(total_ptr,
+                                                    &(jobs[ t ].statistics));
+            }
+        }
+    }
 
-                    for (level = first_level; level < last_level_num; level++)
-                    {
-                        prob_sum = 0.0;
+    if (jobs != NULL)
+    {
+        for (t = 0; t < num_jobs; t++)
+        {
+            free_training_statistics(&(jobs[ t ].statistics));
+        }
+    }
 
-                        level_indicators_pp = level_indicators_ppp[ level ];
-                        level_indicators_p = level_indicators_pp[ cluster ];
+    kjb_free(started);
+    kjb_free(threads);
+    kjb_free(jobs);
+    free_cluster_membership_jobs(membership_jobs, num_membership_jobs);
 
-                        for (dis_item = 0; dis_item < max_num_dis_items; dis_item++)
-                        {
-                            category = dis_item_mp->elements[ point ][ dis_item ];
+    return result;
+}
 
-                            /*
-                            // Can't use break on negative unless use of item
-                            // is adjusted.
-                            */
-                            if (category < 0) break;
+/*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\   */
 
-                            ASSERT_IS_LESS_INT(category, num_categories);
+/*
+ * Sums the statistics of the points of the slice of job_ptr. Like
+ * cluster_membership_job_main(), nothing here sets an error once the model has
+ * been checked, so it can run in any thread.
+*/
+static void* cluster_training_job_main(void* arg)
+{
+    Cluster_training_job*         job_ptr     = (Cluster_training_job*)arg;
+    const Cluster_training_input* input_ptr   = job_ptr->input_ptr;
+    const int                     num_points  = input_ptr->num_points;
+    const int                     num_slices  = input_ptr->num_slices;
+    const int                     first_point = (int)(((long)num_points * job_ptr->slice) / num_slices);
+    const int                     last_point  = (int)(((long)num_points * (job_ptr->slice + 1)) / num_slices);
+    int                           point;
 
-                            ASSERT_IS_NUMBER_DBL(*level_indicators_p);
-                            ASSERT_IS_FINITE_DBL(*level_indicators_p);
-                            ASSERT_IS_NON_NEGATIVE_DBL(*level_indicators_p);
 
-                            prob_sum += *level_indicators_p;
+    job_ptr->result = ow_zero_training_statistics(&(job_ptr->statistics));
 
-                            level_indicators_p++;
-                        }
+    for (point = first_point; point < last_point; point++)
+    {
+        if (job_ptr->result == ERROR) break;
 
-                        level_indicators_p = level_indicators_pp[ cluster ] + max_num_dis_items;
+        if (get_cluster_membership_of_point(job_ptr->membership_job_ptr, point)
+            == ERROR)
+        {
+            job_ptr->result = ERROR;
+        }
+        else
+        {
+            job_ptr->result = add_point_to_training_statistics(&(job_ptr->statistics),
+                                                               input_ptr,
+                                                               job_ptr->membership_job_ptr,
+                                                               point);
+        }
+    }
 
-                        for (con_item = 0; con_item < num_con_items; con_item++)
-                        {
-                            ASSERT_IS_NUMBER_DBL(*level_indicators_p);
-                            ASSERT_IS_FINITE_DBL(*level_indicators_p);
-                            ASSERT_IS_NON_NEGATIVE_DBL(*level_indicators_p);
+    return NULL;
+}
 
-                            prob_sum += *level_indicators_p;
+/*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\   */
 
-                            level_indicators_p++;
-                        }
+/*
+ * The V-step and M-step sums of do_multi_modal_clustering_4() for one point,
+ * once get_cluster_membership_of_point() has left its cluster membership in
+ * P_c_p_mp, and its level indicators, weighted by the cluster membership, in
+ * the cache of the membership job. This also finds the vertical weights of the
+ * point, if they are being computed.
+*/
+static int add_point_to_training_statistics
+(
+    Cluster_training_statistics*  statistics_ptr,
+    const Cluster_training_input* input_ptr,
+    Cluster_membership_job*       membership_job_ptr,
+    int                           point
+)
+{
+    const Cluster_membership_input* membership_input_ptr = input_ptr->membership_input_ptr;
+    const Topology*      topology_ptr      = membership_input_ptr->topology_ptr;
+    const int            first_level       = topology_ptr->first_level;
+    const int            last_level_num    = topology_ptr->last_level_num;
+    const Int_matrix*    node_mp           = topology_ptr->node_mp;
+    const int            num_clusters      = topology_ptr->num_clusters;
+    const Cluster_data*  data_ptr          = membership_input_ptr->data_ptr;
+    const int            max_num_dis_items = (membership_input_ptr->P_i_n_mvp == NULL) ? 0 : data_ptr->max_num_dis_items;
+    const int            max_num_con_items = (membership_input_ptr->mean_mvp == NULL) ? 0 : data_ptr->max_num_con_items;
+    const int            num_con_features  = data_ptr->num_con_features;
+    const Int_matrix*    dis_item_mp       = (max_num_dis_items == 0) ? NULL : data_ptr->dis_item_mp;
+    const Matrix*        dis_item_multiplicity_mp = (max_num_dis_items == 0) ? NULL : data_ptr->dis_item_multiplicity_mp;
+    const Matrix_vector* con_item_mvp      = (max_num_con_items == 0) ? NULL : data_ptr->con_item_mvp;
+    const Vector_vector* con_item_weight_vvp = data_ptr->con_item_weight_vvp;
+    const Int_vector_vector* missing_index_vvp = membership_input_ptr->missing_index_vvp;
+    const Vector*        dis_item_empirical_vp = input_ptr->dis_item_empirical_vp;
+    const double         dis_factor        = (membership_input_ptr->dis_factor_vp == NULL) ? 1.0 : membership_input_ptr->dis_factor_vp->elements[ point ];
+    const double         con_factor        = (membership_input_ptr->con_factor_vp == NULL) ? 1.0 : membership_input_ptr->con_factor_vp->elements[ point ];
+    const double         point_weight      = (input_ptr->weight_vp == NULL) ? 1.0 : input_ptr->weight_vp->elements[ point ];
+    const double*        P_c_p_ptr         = membership_input_ptr->P_c_p_mp->elements[ point ];
+    double***            level_indicators_ppp = membership_job_ptr->cache_ptr->level_indicators_ppp;
+    Matrix_vector*       P_l_p_c_mvp       = input_ptr->P_l_p_c_mvp;
+    Matrix*              P_l_p_mp          = input_ptr->P_l_p_mp;
+    int                  num_dis_items     = 0;
+    int                  num_con_items     = (max_num_con_items == 0) ? 0 : con_item_mvp->elements[ point ]->num_rows;
+    int                  level;
+    int                  cluster;
+    int                  dis_item;
+    int                  con_item;
+    int                  con_feature;
+    int                  category;
+    int                  node;
+    double*              q_ptr;
+    double               q;
+    double               dis_sum;
+    double               con_sum;
+    double               sum;
+    double               level_sum;
+    double               cluster_sum;
+    double               temp;
+
+
+    for (dis_item = 0; dis_item < max_num_dis_items; dis_item++)
+    {
+        if (dis_item_mp->elements[ point ][ dis_item ] < 0) break;
 
-                        ASSERT_IS_NUMBER_DBL(prob_sum);
-                        ASSERT_IS_FINITE_DBL(prob_sum);
-                        ASSERT_IS_NON_NEGATIVE_DBL(prob_sum);
+        num_dis_items++;
+    }
 
-                        P_l_p_c_mvp->elements[ level ]->elements[ point ][ cluster ] = prob_sum;
-                        level_sum += prob_sum;
-                    }
+    statistics_ptr->log_likelihood += membership_input_ptr->fit_vp->elements[ point ] * point_weight;
 
-                    if (level_sum > 10.0 * DBL_MIN)
+    if (num_con_items > 0)
+    {
+        statistics_ptr->ll_con_correction_norm_sum += (double)num_con_items * con_factor;
+    }
+
+    statistics_ptr->max_con_log_prob = MAX_OF(statistics_ptr->max_con_log_prob,
+                                              membership_job_ptr->max_con_log_prob);
+    statistics_ptr->num_points++;
+    statistics_ptr->num_dis_items += num_dis_items;
+    statistics_ptr->num_con_items += num_con_items;
+
+    /*
+    //                           V Step
+    */
+
+    if (input_ptr->compute_cluster_dependent_aspects)
+    {
+        for (cluster = 0; cluster < num_clusters; cluster++)
+        {
+            level_sum = 0.0;
+
+            for (level = first_level; level < last_level_num; level++)
+            {
+                dis_sum = 0.0;
+                con_sum = 0.0;
+
+                q_ptr = level_indicators_ppp[ level ][ cluster ];
+
+                for (dis_item = 0; dis_item < num_dis_items; dis_item++)
+                {
+                    dis_sum += q_ptr[ dis_item ] * dis_factor * dis_item_multiplicity_mp->elements[ point ][ dis_item ];
+                }
+
+                q_ptr += max_num_dis_items;
+
+                for (con_item = 0; con_item < num_con_items; con_item++)
+                {
+                    con_sum += q_ptr[ con_item ] * con_factor;
+                }
+
+                if (input_ptr->multiply_vertical_prior_weights)
+                {
+                    sum = dis_sum * con_sum;
+                }
+                else
+                {
+                    sum = dis_sum + con_sum;
+                }
+
+                P_l_p_c_mvp->elements[ level ]->elements[ point ][ cluster ] = sum;
+                level_sum += sum;
+
+                statistics_ptr->V_mp->elements[ level ][ cluster ] += sum * point_weight;
+
+                if (statistics_ptr->dis_V_mp != NULL)
+                {
+                    statistics_ptr->dis_V_mp->elements[ level ][ cluster ] += dis_sum * point_weight;
+                }
+
+                if (statistics_ptr->con_V_mp != NULL)
+                {
+                    statistics_ptr->con_V_mp->elements[ level ][ cluster ] += con_sum * point_weight;
+                }
+            }
+
+            for (level = first_level; level < last_level_num; level++)
+            {
+                if (level_sum > 10.0 * DBL_MIN)
+                {
+                    P_l_p_c_mvp->elements[ level ]->elements[ point ][ cluster ] /= level_sum;
+                }
+                else
+                {
+                    P_l_p_c_mvp->elements[ level ]->elements[ point ][ cluster ] = 1.0 / (last_level_num - first_level);
+                }
+            }
+        }
+    }
+    else
+    {
+        level_sum = 0.0;
+
+        for (level = first_level; level < last_level_num; level++)
+        {
+            cluster_sum = 0.0;
+
+            for (cluster = 0; cluster < num_clusters; cluster++)
+            {
+                dis_sum = 0.0;
+                con_sum = 0.0;
+
+                q_ptr = level_indicators_ppp[ level ][ cluster ];
+
+                for (dis_item = 0; dis_item < num_dis_items; dis_item++)
+                {
+                    if (input_ptr->compute_aspects)
                     {
-                        for (level = first_level; level < last_level_num; level++)
-                        {
-                            P_l_p_c_mvp->elements[ level ]->elements[ point ][ cluster ] /= level_sum;
-                        }
+                        dis_sum += q_ptr[ dis_item ] * dis_factor * dis_item_multiplicity_mp->elements[ point ][ dis_item ];
                     }
                     else
                     {
-                        for (level = first_level; level < last_level_num; level++)
-                        {
-                            P_l_p_c_mvp->elements[ level ]->elements[ point ][ cluster ] = 1.0 / (last_level_num - first_level);
-                        }
+                        dis_sum += dis_item_multiplicity_mp->elements[ point ][ dis_item ] * dis_factor * q_ptr[ dis_item ];
                     }
                 }
-            }
-            else if (P_l_p_mp != NULL)
-            {
-                /*
-                 * Compute the level weights by marginalizing over items and
-                 * clusters. The cluster weight is already in the level weights
-                */
 
-#ifdef DONT_USE_SPARSE_HERE
-                level_sum = 0.0;
+                q_ptr += max_num_dis_items;
 
-                for (sparse_level = first_sparse_level; sparse_level < num_sparse_levels; sparse_level++)
-#else
-                for (level = first_level; level < last_level_num; level++)
-#endif
+                for (con_item = 0; con_item < num_con_items; con_item++)
                 {
-                    double cluster_sum = 0.0;
-
-#ifdef DONT_USE_SPARSE_HERE
-                    if (level_index_mp != NULL)
+                    if (input_ptr->compute_aspects)
                     {
-                        level = level_index_mp->elements[ sparse_level ][ point ];
+                        con_sum += q_ptr[ con_item ] * con_factor;
                     }
                     else
                     {
-                        level = sparse_level;
+                        con_sum += con_factor * q_ptr[ con_item ];
                     }
-#endif
+                }
 
-                    for (cluster = 0; cluster < num_clusters; cluster++)
-                    {
-                        prob_sum = 0.0;
+                if (input_ptr->multiply_vertical_prior_weights)
+                {
+                    sum = dis_sum * con_sum;
+                }
+                else
+                {
+                    sum = dis_sum + con_sum;
+                }
 
-                        level_indicators_pp = level_indicators_ppp[ level ];
-                        level_indicators_p = level_indicators_pp[ cluster ];
+                cluster_sum += sum;
 
-                        for (dis_item = 0; dis_item < max_num_dis_items; dis_item++)
-                        {
-                            category = dis_item_mp->elements[ point ][ dis_item ];
+                statistics_ptr->V_mp->elements[ level ][ cluster ] += sum * point_weight;
 
-                            /*
-                            // Can't use break on negative unless use of item
-                            // is adjusted.
-                            */
-                            if (category < 0) break;
+                if (statistics_ptr->dis_V_mp != NULL)
+                {
+                    statistics_ptr->dis_V_mp->elements[ level ][ cluster ] += dis_sum * point_weight;
+                }
 
-                            ASSERT_IS_LESS_INT(category, num_categories);
+                if (statistics_ptr->con_V_mp != NULL)
+                {
+                    statistics_ptr->con_V_mp->elements[ level ][ cluster ] += con_sum * point_weight;
+                }
+            }
 
-                            ASSERT_IS_NUMBER_DBL(*level_indicators_p);
-                            ASSERT_IS_FINITE_DBL(*level_indicators_p);
-                            ASSERT_IS_NON_NEGATIVE_DBL(*level_indicators_p);
+            level_sum += cluster_sum;
+
+            if (input_ptr->compute_aspects)
+            {
+                P_l_p_mp->elements[ level ][ point ] = cluster_sum;
+            }
+        }
 
-                            prob_sum += *level_indicators_p;
+        if (input_ptr->compute_aspects)
+        {
+            for (level = first_level; level < last_level_num; level++)
+            {
+                if (level_sum > 1000000.0 * DBL_MIN)
+                {
+                    P_l_p_mp->elements[ level ][ point ] /= level_sum;
+                }
+                else
+                {
+                    P_l_p_mp->elements[ level ][ point ] = 1.0 / (last_level_num - first_level);
+                }
+            }
+        }
+    }
 
-                            level_indicators_p++;
-                        }
+    /*
+    //                           M Step
+    */
 
-                        level_indicators_p = level_indicators_pp[ cluster ] + max_num_dis_items;
+    for (cluster = 0; cluster < num_clusters; cluster++)
+    {
+        statistics_ptr->a_vp->elements[ cluster ] += P_c_p_ptr[ cluster ];
+    }
 
-                        for (con_item = 0; con_item < num_con_items; con_item++)
-                        {
-                            ASSERT_IS_NUMBER_DBL(*level_indicators_p);
-                            ASSERT_IS_FINITE_DBL(*level_indicators_p);
-                            ASSERT_IS_NON_NEGATIVE_DBL(*level_indicators_p);
+    if (max_num_dis_items > 0)
+    {
+        for (level = first_level; level < last_level_num; level++)
+        {
+            Vector* P_sum_vp = statistics_ptr->dis_P_sum_vvp->elements[ level ];
+            Matrix* P_i_n_mp = statistics_ptr->P_i_n_mvp->elements[ level ];
 
-                            /*
-                             * Likely only correct for depend=-1.
-                            */
-                            prob_sum += (*level_indicators_p);
+            for (cluster = 0; cluster < num_clusters; cluster++)
+            {
+                node  = node_mp->elements[ cluster ][ level ];
+                q_ptr = level_indicators_ppp[ level ][ cluster ];
 
-                            level_indicators_p++;
-                        }
+                for (dis_item = 0; dis_item < num_dis_items; dis_item++)
+                {
+                    category = dis_item_mp->elements[ point ][ dis_item ];
 
-                        ASSERT_IS_NUMBER_DBL(prob_sum);
-                        ASSERT_IS_FINITE_DBL(prob_sum);
-                        ASSERT_IS_NON_NEGATIVE_DBL(prob_sum);
+                    q = q_ptr[ dis_item ] * dis_factor * dis_item_multiplicity_mp->elements[ point ][ dis_item ];
+                    q *= point_weight;
+
+                    if (dis_item_empirical_vp != NULL)
+                    {
+                        q /= dis_item_empirical_vp->elements[ category ];
+                    }
+
+                    P_sum_vp->elements[ node ] += q;
+                    P_i_n_mp->elements[ node ][ category ] += q;
+                }
+            }
+        }
+    }
 
+    if (max_num_con_items > 0)
+    {
+        for (level = first_level; level < last_level_num; level++)
+        {
+            Vector* P_sum_vp = statistics_ptr->con_P_sum_vvp->elements[ level ];
+            Matrix* mean_mp  = statistics_ptr->mean_mvp->elements[ level ];
+            Matrix* var_mp   = statistics_ptr->var_mvp->elements[ level ];
 
-                        cluster_sum += prob_sum;
-                    }
+            for (cluster = 0; cluster < num_clusters; cluster++)
+            {
+                Vector* missing_con_P_sum_vp;
 
-#ifdef DONT_USE_SPARSE_HERE
-                    P_l_p_mp->elements[ sparse_level ][ point ] = cluster_sum;
-                    level_sum += cluster_sum;
-#else
-                    level_weight_vp->elements[ level ] = cluster_sum;
-#endif
-                }
+                node  = node_mp->elements[ cluster ][ level ];
+                q_ptr = level_indicators_ppp[ level ][ cluster ] + max_num_dis_items;
 
-                if (level_index_mp != NULL)
+                missing_con_P_sum_vp = statistics_ptr->missing_con_P_sum_vvvp->elements[ level ]->elements[ node ];
+
+                for (con_item = 0; con_item < num_con_items; con_item++)
                 {
-                    ERE(vp_get_indexed_vector(&sorted_l_p_vp, level_weight_vp));
-                    ERE(descend_sort_indexed_vector(sorted_l_p_vp));
+                    double  con_item_weight = 1.0;
+                    int     missing_data    = missing_index_vvp->elements[ point ]->elements[ con_item ];
+                    double* x_ptr           = con_item_mvp->elements[ point ]->elements[ con_item ];
+                    double* u_ptr           = mean_mp->elements[ node ];
+                    double* v_ptr           = var_mp->elements[ node ];
 
-                    for (sparse_level = first_sparse_level; sparse_level < num_sparse_levels; sparse_level++)
+                    if ((membership_input_ptr->weight_con_items) && (con_item_weight_vvp != NULL))
                     {
-                         P_l_p_mp->elements[ sparse_level ][ point ] = sorted_l_p_vp->elements[ sparse_level ].element;
-                         level_index_mp->elements[ sparse_level ][ point ] = sorted_l_p_vp->elements[ sparse_level ].index;
+                        con_item_weight = con_item_weight_vvp->elements[ point ]->elements[ con_item ];
                     }
-                }
-                else
-                {
-                    ERE(put_matrix_col(P_l_p_mp, level_weight_vp, point));
-                }
 
-                level_sum = sum_matrix_col_elements(P_l_p_mp, point);
+                    q = q_ptr[ con_item ] * con_factor * (point_weight * con_item_weight);
 
-                if (level_sum > 10.0 * DBL_MIN)
-                {
-                    for (sparse_level = first_sparse_level; sparse_level < num_sparse_levels; sparse_level++)
+                    if (missing_data)
                     {
-                        P_l_p_mp->elements[ sparse_level ][ point ] /= level_sum;
+                        for (con_feature = 0; con_feature < num_con_features; con_feature++)
+                        {
+                            if (IS_NOT_MISSING_DBL(*x_ptr))
+                            {
+                                temp = q * (*x_ptr);
+
+                                *u_ptr += temp;
+                                *v_ptr += temp * (*x_ptr);
+
+                                missing_con_P_sum_vp->elements[ con_feature ] += q;
+                            }
+
+                            v_ptr++;
+                            u_ptr++;
+                            x_ptr++;
+                        }
                     }
-                }
-                else
-                {
-                    for (sparse_level = first_sparse_level; sparse_level < num_sparse_levels; sparse_level++)
+                    else
                     {
-                        P_l_p_mp->elements[ sparse_level ][ point ] = 1.0 / (num_sparse_levels - first_sparse_level);
+                        for (con_feature = 0; con_feature < num_con_features; con_feature++)
+                        {
+                            temp = q * (*x_ptr);
+
+                            *u_ptr += temp;
+                            *v_ptr += temp * (*x_ptr);
+
+                            v_ptr++;
+                            u_ptr++;
+                            x_ptr++;
+                        }
+
+                        P_sum_vp->elements[ node ] += q;
                     }
                 }
             }
+        }
+    }
 
-            count++;
+    return NO_ERROR;
+}
+
+/*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\   */
+
+/*
+ * Sets up *target_ptr for sums of the same size as those of source_ptr. If
+ * source_ptr is NULL, the sums are just set to NULL.
+*/
+static int get_zero_training_statistics
+(
+    Cluster_training_statistics*       target_ptr,
+    const Cluster_training_statistics* source_ptr
+)
+{
+    int level;
+    int node;
+
+
+    target_ptr->a_vp = NULL;
+    target_ptr->V_mp = NULL;
+    target_ptr->dis_V_mp = NULL;
+    target_ptr->con_V_mp = NULL;
+    target_ptr->dis_P_sum_vvp = NULL;
+    target_ptr->P_i_n_mvp = NULL;
+    target_ptr->con_P_sum_vvp = NULL;
+    target_ptr->mean_mvp = NULL;
+    target_ptr->var_mvp = NULL;
+    target_ptr->missing_con_P_sum_vvvp = NULL;
+    target_ptr->log_likelihood = 0.0;
+    target_ptr->ll_con_correction_norm_sum = 0.0;
+    target_ptr->max_con_log_prob = DBL_MOST_NEGATIVE;
+    target_ptr->num_points = 0;
+    target_ptr->num_dis_items = 0;
+    target_ptr->num_con_items = 0;
+
+    if (source_ptr == NULL) return NO_ERROR;
+
+    ERE(copy_vector(&(target_ptr->a_vp), source_ptr->a_vp));
+    ERE(copy_matrix(&(target_ptr->V_mp), source_ptr->V_mp));
+    ERE(copy_matrix(&(target_ptr->dis_V_mp), source_ptr->dis_V_mp));
+    ERE(copy_matrix(&(target_ptr->con_V_mp), source_ptr->con_V_mp));
+
+    if (source_ptr->dis_P_sum_vvp != NULL)
+    {
+        ERE(get_target_vector_vector(&(target_ptr->dis_P_sum_vvp),
+                                     source_ptr->dis_P_sum_vvp->length));
+        ERE(get_target_matrix_vector(&(target_ptr->P_i_n_mvp),
+                                     source_ptr->P_i_n_mvp->length));
+
+        for (level = 0; level < source_ptr->dis_P_sum_vvp->length; level++)
+        {
+            ERE(copy_vector(&(target_ptr->dis_P_sum_vvp->elements[ level ]),
+                            source_ptr->dis_P_sum_vvp->elements[ level ]));
+            ERE(copy_matrix(&(target_ptr->P_i_n_mvp->elements[ level ]),
+                            source_ptr->P_i_n_mvp->elements[ level ]));
+        }
+    }
 
-            if (count % 1000 == 0)
+    if (source_ptr->con_P_sum_vvp != NULL)
+    {
+        ERE(get_target_vector_vector(&(target_ptr->con_P_sum_vvp),
+                                     source_ptr->con_P_sum_vvp->length));
+        ERE(get_target_matrix_vector(&(target_ptr->mean_mvp),
+                                     source_ptr->mean_mvp->length));
+        ERE(get_target_matrix_vector(&(target_ptr->var_mvp),
+                                     source_ptr->var_mvp->length));
+        ERE(get_target_v3(&(target_ptr->missing_con_P_sum_vvvp),
+                          source_ptr->missing_con_P_sum_vvvp->length));
+
+        for (level = 0; level < source_ptr->con_P_sum_vvp->length; level++)
+        {
+            const Vector_vector* missing_con_P_sum_vvp = source_ptr->missing_con_P_sum_vvvp->elements[ level ];
+
+            ERE(copy_vector(&(target_ptr->con_P_sum_vvp->elements[ level ]),
+                            source_ptr->con_P_sum_vvp->elements[ level ]));
+            ERE(copy_matrix(&(target_ptr->mean_mvp->elements[ level ]),
+                            source_ptr->mean_mvp->elements[ level ]));
+            ERE(copy_matrix(&(target_ptr->var_mvp->elements[ level ]),
+                            source_ptr->var_mvp->elements[ level ]));
+
+            if (missing_con_P_sum_vvp != NULL)
             {
-                verbose_pso(5, "%d points processed for get_cluster_membership_2() iteration %d.\n",
-                            count, it + 1);
+                ERE(get_target_vector_vector(&(target_ptr->missing_con_P_sum_vvvp->elements[ level ]),
+                                             missing_con_P_sum_vvp->length));
+
+                for (node = 0; node < missing_con_P_sum_vvp->length; node++)
+                {
+                    ERE(copy_vector(&(target_ptr->missing_con_P_sum_vvvp->elements[ level ]->elements[ node ]),
+                                    missing_con_P_sum_vvp->elements[ node ]));
+                }
             }
         }
+    }
 
-        log_likelihood = sum_vector_elements(fit_vp);
-
-        ll_rel_diff = (log_likelihood - prev_log_likelihood);
-        ll_rel_diff /= (ABS_OF(log_likelihood) + ABS_OF(prev_log_likelihood));
-        ll_rel_diff *= 2.0;
-        prev_log_likelihood = log_likelihood;
+    return ow_zero_training_statistics(target_ptr);
+}
 
-        if (fs_watch_2)
-        {
-            rms_diff = 0.0;
-            max_diff = 0.0;
+/*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\   */
 
-            pso(" %-3d | %.6e | %.3e |", 1 + it, log_likelihood, ll_rel_diff);
+static int ow_zero_training_statistics
+(
+    Cluster_training_statistics* statistics_ptr
+)
+{
+    int level;
+    int node;
 
-            prev_log_likelihood = log_likelihood;
 
-            if (test_data_flag)
-            {
-                rms_diff = rms_matrix_difference(P_c_p_mp,
-                                                 test_P_c_p_mp);
-                max_diff = max_abs_matrix_difference(P_c_p_mp,
-                                                     test_P_c_p_mp);
-            }
+    ERE(ow_zero_vector(statistics_ptr->a_vp));
+    ERE(ow_zero_matrix(statistics_ptr->V_mp));
 
-            pso(" %.3e | %.3e\n", rms_diff, max_diff);
-        }
+    if (statistics_ptr->dis_V_mp != NULL)
+    {
+        ERE(ow_zero_matrix(statistics_ptr->dis_V_mp));
+    }
 
-        kjb_fflush((FILE*)NULL);
+    if (statistics_ptr->con_V_mp != NULL)
+    {
+        ERE(ow_zero_matrix(statistics_ptr->con_V_mp));
+    }
 
-        if (iteration_atn_flag)
-        {
-            pso("Stopping because of halt request via signal.\n");
-            break;
-        }
-        else if (is_file(halt_file_name))
+    if (statistics_ptr->dis_P_sum_vvp != NULL)
+    {
+        for (level = 0; level < statistics_ptr->dis_P_sum_vvp->length; level++)
         {
-            pso("Stopping because of halt request via file.\n");
-            EPE(kjb_unlink(halt_file_name));
-            break;
+            if (statistics_ptr->dis_P_sum_vvp->elements[ level ] == NULL) continue;
+
+            ERE(ow_zero_vector(statistics_ptr->dis_P_sum_vvp->elements[ level ]));
+            ERE(ow_zero_matrix(statistics_ptr->P_i_n_mvp->elements[ level ]));
         }
-        /*
-        // If we are not fitting both levels and clusters, then more iterations
-        // won't do much.
-        */
-        else if (    ((P_l_p_c_mvp == NULL) && (P_l_p_mp == NULL))
-                  || ((P_c_p_mpp == NULL) && (input_P_c_p_mp != NULL))
-                )
+    }
+
+    if (statistics_ptr->con_P_sum_vvp != NULL)
+    {
+        for (level = 0; level < statistics_ptr->con_P_sum_vvp->length; level++)
         {
-            if (fs_watch_2)
+            const Vector_vector* missing_con_P_sum_vvp = statistics_ptr->missing_con_P_sum_vvvp->elements[ level ];
+
+            if (statistics_ptr->con_P_sum_vvp->elements[ level ] == NULL) continue;
+
+            ERE(ow_zero_vector(statistics_ptr->con_P_sum_vvp->elements[ level ]));
+            ERE(ow_zero_matrix(statistics_ptr->mean_mvp->elements[ level ]));
+            ERE(ow_zero_matrix(statistics_ptr->var_mvp->elements[ level ]));
+
+            for (node = 0; node < missing_con_P_sum_vvp->length; node++)
             {
-                pso("\nStopping because we are not fitting both clusters and aspects.\n");
+                ERE(ow_zero_vector(missing_con_P_sum_vvp->elements[ node ]));
             }
-            break;
         }
+    }
 
-        else if (ll_rel_diff < iteration_tolerance)
-        {
-            break;
-        }
+    statistics_ptr->log_likelihood = 0.0;
+    statistics_ptr->ll_con_correction_norm_sum = 0.0;
+    statistics_ptr->max_con_log_prob = DBL_MOST_NEGATIVE;
+    statistics_ptr->num_points = 0;
+    statistics_ptr->num_dis_items = 0;
+    statistics_ptr->num_con_items = 0;
+
+    return NO_ERROR;
+}
+
+/*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\   */
+
+static int ow_add_training_statistics
+(
+    Cluster_training_statistics*       total_ptr,
+    const Cluster_training_statistics* statistics_ptr
+)
+{
+    int level;
+    int node;
+
+
+    ERE(ow_add_vectors(total_ptr->a_vp, statistics_ptr->a_vp));
+    ERE(ow_add_matrices(total_ptr->V_mp, statistics_ptr->V_mp));
+
+    if (total_ptr->dis_V_mp != NULL)
+    {
+        ERE(ow_add_matrices(total_ptr->dis_V_mp, statistics_ptr->dis_V_mp));
     }
 
-    if (fs_watch_2)
+    if (total_ptr->con_V_mp != NULL)
     {
-        pso("\n---------\n");
+        ERE(ow_add_matrices(total_ptr->con_V_mp, statistics_ptr->con_V_mp));
     }
 
-    if (fit_vp_ptr != NULL)
+    if (total_ptr->dis_P_sum_vvp != NULL)
     {
-        ERE(copy_vector(fit_vp_ptr, fit_vp));
+        for (level = 0; level < total_ptr->dis_P_sum_vvp->length; level++)
+        {
+            if (total_ptr->dis_P_sum_vvp->elements[ level ] == NULL) continue;
+
+            ERE(ow_add_vectors(total_ptr->dis_P_sum_vvp->elements[ level ],
+                               statistics_ptr->dis_P_sum_vvp->elements[ level ]));
+            ERE(ow_add_matrices(total_ptr->P_i_n_mvp->elements[ level ],
+                                statistics_ptr->P_i_n_mvp->elements[ level ]));
+        }
     }
 
-    free_vector(fit_vp);
-    free_vector(col_sum_vp);
+    if (total_ptr->con_P_sum_vvp != NULL)
+    {
+        for (level = 0; level < total_ptr->con_P_sum_vvp->length; level++)
+        {
+            const Vector_vector* missing_con_P_sum_vvp = total_ptr->missing_con_P_sum_vvvp->elements[ level ];
 
-    if (P_c_p_mpp != NULL)
+            if (total_ptr->con_P_sum_vvp->elements[ level ] == NULL) continue;
+
+            ERE(ow_add_vectors(total_ptr->con_P_sum_vvp->elements[ level ],
+                               statistics_ptr->con_P_sum_vvp->elements[ level ]));
+            ERE(ow_add_matrices(total_ptr->mean_mvp->elements[ level ],
+                                statistics_ptr->mean_mvp->elements[ level ]));
+            ERE(ow_add_matrices(total_ptr->var_mvp->elements[ level ],
+                                statistics_ptr->var_mvp->elements[ level ]));
+
+            for (node = 0; node < missing_con_P_sum_vvp->length; node++)
+            {
+                ERE(ow_add_vectors(missing_con_P_sum_vvp->elements[ node ],
+                                   statistics_ptr->missing_con_P_sum_vvvp->elements[ level ]->elements[ node ]));
+            }
+        }
+    }
+
+    total_ptr->log_likelihood += statistics_ptr->log_likelihood;
+    total_ptr->ll_con_correction_norm_sum += statistics_ptr->ll_con_correction_norm_sum;
+    total_ptr->max_con_log_prob = MAX_OF(total_ptr->max_con_log_prob,
+                                         statistics_ptr->max_con_log_prob);
+    total_ptr->num_points += statistics_ptr->num_points;
+    total_ptr->num_dis_items += statistics_ptr->num_dis_items;
+    total_ptr->num_con_items += statistics_ptr->num_con_items;
+
+    return NO_ERROR;
+}
+
+/*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\   */
+
+static void free_training_statistics
+(
+    Cluster_training_statistics* statistics_ptr
+)
+{
+    free_vector(statistics_ptr->a_vp);
+    free_matrix(statistics_ptr->V_mp);
+    free_matrix(statistics_ptr->dis_V_mp);
+    free_matrix(statistics_ptr->con_V_mp);
+    free_vector_vector(statistics_ptr->dis_P_sum_vvp);
+    free_matrix_vector(statistics_ptr->P_i_n_mvp);
+    free_vector_vector(statistics_ptr->con_P_sum_vvp);
+    free_matrix_vector(statistics_ptr->mean_mvp);
+    free_matrix_vector(statistics_ptr->var_mvp);
+    free_v3(statistics_ptr->missing_con_P_sum_vvvp);
+}
+
+/*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\   */
+
+/*
+ * Sorts the level weights into sorted_l_p_vp, largest first. This is what
+ * vp_get_indexed_vector() and descend_sort_indexed_vector() do, but without
+ * allocating, and with ties broken by level so that the result does not
+ * depend on the sort.
+*/
+static void sort_level_weights
+(
+    Indexed_vector* sorted_l_p_vp,
+    const Vector*   level_weight_vp
+)
+{
+    int level;
+
+
+    for (level = 0; level < level_weight_vp->length; level++)
     {
-        /* Generally lock_P_c_p_mp is just P_c_p_mp. */
-        ERE(copy_matrix(P_c_p_mpp, lock_P_c_p_mp));
+        sorted_l_p_vp->elements[ level ].element = level_weight_vp->elements[ level ];
+        sorted_l_p_vp->elements[ level ].index = level;
     }
 
-    free_matrix(P_c_p_mp);
-    free_vector(log_nu_vp);
-    free_vector(nu_vp);
-    free_vector(level_weight_vp);
-    free_vector(log_prob_vp);
-    free_vector(nu_for_dependent_model_vp);
+    qsort(sorted_l_p_vp->elements, (size_t)level_weight_vp->length,
+          sizeof(Indexed_vector_element), compare_level_weights);
+}
 
-#ifdef XXX_NOT_SURE_WHAT_IT_IS_DOING
-    free_matrix(con_score_mp);
-#endif
-    free_vector(con_score_vp);
-    free_int_vector(con_score_counts_vp);
+/*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\   */
 
-    free_indexed_vector(sorted_l_p_vp);
+static int compare_level_weights(const void* first_ptr, const void* second_ptr)
+{
+    const Indexed_vector_element* elem1_ptr = (const Indexed_vector_element*)first_ptr;
+    const Indexed_vector_element* elem2_ptr = (const Indexed_vector_element*)second_ptr;
 
-    if (log_likelihood_ptr != NULL)
+
+    if (elem1_ptr->element > elem2_ptr->element) return -1;
+    if (elem1_ptr->element < elem2_ptr->element) return 1;
+
+    return elem1_ptr->index - elem2_ptr->index;
+}
+
+/*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\   */
+
+static int get_cluster_num_threads
+(
+    const Multi_modal_cluster_options* cluster_options_ptr
+)
+{
+    long num_processors;
+
+
+    if (cluster_options_ptr->num_threads > 0)
     {
-        *log_likelihood_ptr = log_likelihood;
+        return cluster_options_ptr->num_threads;
     }
 
-    return NO_ERROR;
+#if defined(KJB_HAVE_PTHREAD) && defined(_SC_NPROCESSORS_ONLN)
+    num_processors = sysconf(_SC_NPROCESSORS_ONLN);
+#else
+    num_processors = 1;
+#endif
+
+    return (num_processors > 1) ? (int)num_processors : 1;
 }
 
 /*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\   */
 
 static int initialize_con_prob_cache
 (
+    Cluster_cache*    cache_ptr,
     int               max_num_con_items,
     int               first_level,
     int               last_level_num,
@@ -18905,10 +20971,6 @@ static int initialize_con_prob_cache
     const Int_vector* level_counts_vp
 )
 {
-    static int         prev_max_num_con_items = NOT_SET;
-    static int         prev_first_level       = NOT_SET;
-    static int         prev_last_level_num       = NOT_SET;
-    static int         prev_num_levels        = NOT_SET;
     int                con_item;
     int                level;
     int                num_nodes_this_level;
@@ -18916,22 +20978,22 @@ static int initialize_con_prob_cache
 
     if (max_num_con_items <= 0) return NO_ERROR;
 
-    if (    (max_num_con_items == prev_max_num_con_items)
-         && (first_level == prev_first_level)
-         && (last_level_num == prev_last_level_num)
-         && (num_levels == prev_num_levels)
+    if (    (max_num_con_items == cache_ptr->con_prob_cache_max_num_con_items)
+         && (first_level == cache_ptr->con_prob_cache_first_level)
+         && (last_level_num == cache_ptr->con_prob_cache_last_level_num)
+         && (num_levels == cache_ptr->con_prob_cache_num_levels)
        )
     {
         int wrong_size = FALSE;
 
         /*
-        // If prev_num_levels is set, then fs_level_counts_vp is not NULL, and
-        // has length prev_num_levels.
+        // If the number of levels is set, then cache_ptr->level_counts_vp is
+        // not NULL, and has that length.
         */
 
         for (level = first_level; level < last_level_num; level++)
         {
-            if (fs_level_counts_vp->elements[ level ] != level_counts_vp->elements[ level ])
+            if (cache_ptr->level_counts_vp->elements[ level ] != level_counts_vp->elements[ level ])
             {
                 wrong_size = TRUE;
                 break;
@@ -18942,13 +21004,13 @@ static int initialize_con_prob_cache
     }
 
     SKIP_HEAP_CHECK_2();
-    ERE(get_target_v3(&fs_con_prob_cache_vvvp, max_num_con_items));
+    ERE(get_target_v3(&cache_ptr->con_prob_cache_vvvp, max_num_con_items));
     CONTINUE_HEAP_CHECK_2();
 
     for (con_item = 0; con_item < max_num_con_items; con_item++)
     {
         SKIP_HEAP_CHECK_2();
-        ERE(get_target_vector_vector(&(fs_con_prob_cache_vvvp->elements[ con_item ]),
+        ERE(get_target_vector_vector(&(cache_ptr->con_prob_cache_vvvp->elements[ con_item ]),
                                      num_levels));
         CONTINUE_HEAP_CHECK_2();
 
@@ -18958,10 +21020,10 @@ static int initialize_con_prob_cache
 
             SKIP_HEAP_CHECK_2();
 #ifdef TEST
-            ERE(get_initialized_vector(&(fs_con_prob_cache_vvvp->elements[ con_item ]->elements[ level ]),
+            ERE(get_initialized_vector(&(cache_ptr->con_prob_cache_vvvp->elements[ con_item ]->elements[ level ]),
                                        num_nodes_this_level, DBL_NOT_SET));
 #else
-            ERE(get_target_vector(&(fs_con_prob_cache_vvvp->elements[ con_item ]->elements[ level ]),
+            ERE(get_target_vector(&(cache_ptr->con_prob_cache_vvvp->elements[ con_item ]->elements[ level ]),
                                   num_nodes_this_level));
 #endif
             CONTINUE_HEAP_CHECK_2();
@@ -18969,13 +21031,13 @@ static int initialize_con_prob_cache
     }
 
     SKIP_HEAP_CHECK_2();
-    ERE(copy_int_vector(&fs_level_counts_vp, level_counts_vp));
+    ERE(copy_int_vector(&cache_ptr->level_counts_vp, level_counts_vp));
     CONTINUE_HEAP_CHECK_2();
 
-    prev_num_levels = num_levels;
-    prev_first_level = first_level;
-    prev_last_level_num = last_level_num;
-    prev_max_num_con_items = max_num_con_items;
+    cache_ptr->con_prob_cache_num_levels = num_levels;
+    cache_ptr->con_prob_cache_first_level = first_level;
+    cache_ptr->con_prob_cache_last_level_num = last_level_num;
+    cache_ptr->con_prob_cache_max_num_con_items = max_num_con_items;
 
     return NO_ERROR;
 }
@@ -18984,39 +21046,33 @@ static int initialize_con_prob_cache
 
 static int initialize_level_indicators_cache
 (
-    int num_levels,
-    int num_clusters,
-    int num_items
+    Cluster_cache* cache_ptr,
+    int            num_levels,
+    int            num_clusters,
+    int            num_items
 )
 {
-    static int prev_num_clusters = NOT_SET;
-    static int prev_num_items    = NOT_SET;
-    static int prev_num_levels   = NOT_SET;
 
 
-#ifdef TRACK_MEMORY_ALLOCATION
-    prepare_memory_cleanup();
-#endif
-
-    if (    (num_clusters != prev_num_clusters)
-         || (num_items != prev_num_items)
-         || (num_levels != prev_num_levels)
+    if (    (num_clusters != cache_ptr->level_indicators_num_clusters)
+         || (num_items != cache_ptr->level_indicators_num_items)
+         || (num_levels != cache_ptr->level_indicators_num_levels)
        )
     {
         verbose_pso(5, "Resetting level indicator caches.\n");
 
         SKIP_HEAP_CHECK_2();
 
-        free_3D_double_array(fs_cached_level_indicators_ppp);
+        free_3D_double_array(cache_ptr->level_indicators_ppp);
 
-        NRE(fs_cached_level_indicators_ppp = allocate_3D_double_array(num_levels,
+        NRE(cache_ptr->level_indicators_ppp = allocate_3D_double_array(num_levels,
                                                                    num_clusters,
                                                                    num_items));
         CONTINUE_HEAP_CHECK_2();
 
-        prev_num_levels   = num_levels;
-        prev_num_clusters = num_clusters;
-        prev_num_items    = num_items;
+        cache_ptr->level_indicators_num_levels   = num_levels;
+        cache_ptr->level_indicators_num_clusters = num_clusters;
+        cache_ptr->level_indicators_num_items    = num_items;
     }
 
     return NO_ERROR;
@@ -19259,6 +21315,7 @@ static int get_his_factors
 
 static int get_limited_cluster_membership
 (
+    Cluster_cache*    cache_ptr,
     Int_matrix*   cluster_index_mp,
     const Vector* P_c_p_vp,
     int           point,
@@ -19275,24 +21332,20 @@ static int get_limited_cluster_membership
     double total_sum;
 #endif
 
-#ifdef TRACK_MEMORY_ALLOCATION
-    prepare_memory_cleanup();
-#endif
-
 
     SKIP_HEAP_CHECK_2();
-    ERE(vp_get_indexed_vector(&fs_cached_cluster_index_vp, P_c_p_vp));
+    ERE(vp_get_indexed_vector(&cache_ptr->cluster_index_vp, P_c_p_vp));
     CONTINUE_HEAP_CHECK_2();
 
-    ERE(descend_sort_indexed_vector(fs_cached_cluster_index_vp));
+    ERE(descend_sort_indexed_vector(cache_ptr->cluster_index_vp));
 
     for (cluster = 0; cluster < num_limited_clusters; cluster++)
     {
-        int index = fs_cached_cluster_index_vp->elements[ cluster ].index;
+        int index = cache_ptr->cluster_index_vp->elements[ cluster ].index;
 
         cluster_index_mp->elements[ point ][ cluster ] = index;
 
-        limited_sum += fs_cached_cluster_index_vp->elements[ cluster ].element;
+        limited_sum += cache_ptr->cluster_index_vp->elements[ cluster ].element;
     }
 
 
@@ -19301,7 +21354,7 @@ static int get_limited_cluster_membership
 
     for (cluster = num_limited_clusters; cluster < num_clusters; cluster++)
     {
-        total_sum += fs_cached_cluster_index_vp->elements[ cluster ].element;
+        total_sum += cache_ptr->cluster_index_vp->elements[ cluster ].element;
     }
 
     ASSERT_IS_GREATER_DBL(total_sum, 0.999);
@@ -19379,18 +21432,18 @@ static void sum_collected_scores
 // To save time, we only do it once, BUT WE HAVE NO INVALIDATION STRATEGY!!!
 */
 
-static int initialize_vector_feature_counts(const Int_vector* con_feature_enable_vp,
-                                            const Int_vector* con_feature_group_vp)
+static int initialize_vector_feature_counts
+(
+    Cluster_cache*    cache_ptr,
+    const Int_vector* con_feature_enable_vp,
+    const Int_vector* con_feature_group_vp
+)
 {
     int num_con_features;
     int con_feature      = 0;
 
 
-#ifdef TRACK_MEMORY_ALLOCATION
-    prepare_memory_cleanup();
-#endif
-
-    fs_vector_feature_counts_set = TRUE;
+    cache_ptr->vector_feature_counts_set = TRUE;
 
     if (con_feature_group_vp == NULL)
     {
@@ -19427,19 +21480,19 @@ static int initialize_vector_feature_counts(const Int_vector* con_feature_enable
 
         ASSERT_IS_POSITIVE_INT(count);
 
-        if (fs_vector_feature_counts_ptr == NULL)
+        if (cache_ptr->vector_feature_counts_ptr == NULL)
         {
-            NRE(fs_vector_feature_counts_ptr = INT_MALLOC(num_con_features));
+            NRE(cache_ptr->vector_feature_counts_ptr = INT_MALLOC(num_con_features));
 
             for (i = 0; i < num_con_features; i++)
             {
-                fs_vector_feature_counts_ptr[ i ] = 0;
+                cache_ptr->vector_feature_counts_ptr[ i ] = 0;
             }
         }
 
         for (i = 0; i <count ; i++)
         {
-            fs_vector_feature_counts_ptr[ con_feature + i ] = count;
+            cache_ptr->vector_feature_counts_ptr[ con_feature + i ] = count;
         }
 
         con_feature += count;
@@ -19454,6 +21507,38 @@ static int initialize_vector_feature_counts(const Int_vector* con_feature_enable
 
 /*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\   */
 
+static void init_cluster_cache(Cluster_cache* cache_ptr)
+{
+    cache_ptr->vector_feature_counts_ptr        = NULL;
+    cache_ptr->vector_feature_counts_set        = FALSE;
+    cache_ptr->level_indicators_ppp             = NULL;
+    cache_ptr->level_indicators_num_levels      = NOT_SET;
+    cache_ptr->level_indicators_num_clusters    = NOT_SET;
+    cache_ptr->level_indicators_num_items       = NOT_SET;
+    cache_ptr->con_prob_cache_vvvp              = NULL;
+    cache_ptr->level_counts_vp                  = NULL;
+    cache_ptr->con_prob_cache_max_num_con_items = NOT_SET;
+    cache_ptr->con_prob_cache_first_level       = NOT_SET;
+    cache_ptr->con_prob_cache_last_level_num    = NOT_SET;
+    cache_ptr->con_prob_cache_num_levels        = NOT_SET;
+    cache_ptr->cluster_index_vp                 = NULL;
+}
+
+/*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\   */
+
+static void free_cluster_cache(Cluster_cache* cache_ptr)
+{
+    free_indexed_vector(cache_ptr->cluster_index_vp);
+    free_3D_double_array(cache_ptr->level_indicators_ppp);
+    free_v3(cache_ptr->con_prob_cache_vvvp);
+    free_int_vector(cache_ptr->level_counts_vp);
+    kjb_free(cache_ptr->vector_feature_counts_ptr);
+
+    init_cluster_cache(cache_ptr);
+}
+
+/*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\   */
+
 #ifdef TRACK_MEMORY_ALLOCATION
 
 static void prepare_memory_cleanup(void)
@@ -19476,23 +21561,8 @@ static void prepare_memory_cleanup(void)
 
 static void free_allocated_static_data(void)
 {
-    free_int_vector(fs_sub_group_vp);
-
-    free_indexed_vector(fs_cached_cluster_index_vp);
-    fs_cached_cluster_index_vp      = NULL;
-
-    free_3D_double_array(fs_cached_level_indicators_ppp);
-    fs_cached_level_indicators_ppp  = NULL;
-
-    free_v3(fs_con_prob_cache_vvvp);
-    fs_con_prob_cache_vvvp          = NULL;
-
-    free_int_vector(fs_level_counts_vp);
-    fs_level_counts_vp              = NULL;
-
-    kjb_free(fs_vector_feature_counts_ptr);
-    fs_vector_feature_counts_ptr    = NULL;
-    fs_vector_feature_counts_set    = FALSE;
+    free_int_vector(fs_options.sub_group_vp);
+    fs_options.sub_group_vp = NULL;
 }
 
 #endif
@@ -27,8 +27,30 @@ namespace kjb_c {
 */
 
 
+typedef struct Multi_modal_cluster_options Multi_modal_cluster_options;
+
 int set_multi_modal_cluster_options(const char* option, const char* value);
 
+Multi_modal_cluster_options* create_multi_modal_cluster_options(void);
+
+int copy_multi_modal_cluster_options
+(
+    Multi_modal_cluster_options**      target_options_ptr_ptr,
+    const Multi_modal_cluster_options* options_ptr
+);
+
+void free_multi_modal_cluster_options
+(
+    Multi_modal_cluster_options* options_ptr
+);
+
+int set_multi_modal_cluster_options_2
+(
+    Multi_modal_cluster_options* options_ptr,
+    const char*                  option,
+    const char*                  value
+);
+
 int do_multi_modal_clustering
 (
     const Topology_vector* topology_vp,
@@ -41,6 +63,19 @@ int do_multi_modal_clustering
     double                 (*dis_item_loss_fn)(int, const double*)
 );
 
+int do_multi_modal_clustering_with_options
+(
+    const Topology_vector*             topology_vp,
+    const Int_vector*                  dis_item_level_vp,
+    const Cluster_data*                data_ptr,
+    const Cluster_data*                held_out_data_ptr,
+    Multi_modal_model*                 model_ptr,
+    int                                (*output_model_fn) (const Multi_modal_model*, int, const char*),
+    const char*                        output_dir,
+    double                             (*dis_item_loss_fn)(int, const double*),
+    const Multi_modal_cluster_options* options_ptr
+);
+
 
 int get_cluster_membership
 (
@@ -58,6 +93,23 @@ int get_cluster_membership
     Vector_vector*            con_score_cutoff_vpp
 );
 
+int get_cluster_membership_with_options
+(
+    Matrix**                           P_c_p_mp_ptr,
+    Matrix_vector**                    P_l_p_c_mvp_ptr,
+    Int_matrix_vector**                cluster_level_index_mvpp,
+    Matrix**                           P_l_p_mp_ptr,
+    Int_matrix**                       level_index_mp,
+    Vector**                           fit_vp_ptr,
+    const Multi_modal_model*           model_ptr,
+    const Cluster_data*                data_ptr,
+    const Int_vector*                  points_to_use_vp,
+    int                                use_factors_flag,
+    int                                test_data_flag,
+    Vector_vector*                     con_score_cutoff_vpp,
+    const Multi_modal_cluster_options* options_ptr
+);
+
 
 #ifdef __cplusplus
 #ifdef COMPILING_CPLUSPLUS_SOURCE
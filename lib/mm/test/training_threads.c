@@ -0,0 +1,338 @@
+/* $Id$ */
+
+/*
+ * Checks that a model fit with several threads is the same as one fit with a
+ * single thread, and that clustering option structures are independent of
+ * each other (setting an option on one does not change a fit done with
+ * another).
+ */
+
+#include "mm/mm_incl.h"
+#include "mm/mm_cluster.h"
+#include "mm/mm_cluster_lib.h"
+
+#define NUM_POINTS          600
+#define NUM_CATEGORIES      10
+#define NUM_CON_FEATURES    3
+#define NUM_DIS_ITEMS       4
+#define NUM_CON_ITEMS       2
+#define NUM_ITERATIONS_STR  "10"
+
+static Cluster_data* create_test_data(int num_points);
+
+static Multi_modal_model* create_test_model(void);
+
+static int fit_test_model
+(
+    const Topology_vector*             topology_vp,
+    const Cluster_data*                data_ptr,
+    const Multi_modal_cluster_options* cluster_options_ptr,
+    Multi_modal_model**                model_ptr_ptr
+);
+
+static int are_matrix_vectors_equal
+(
+    const Matrix_vector* first_mvp,
+    const Matrix_vector* second_mvp
+);
+
+static int are_models_equal
+(
+    const Multi_modal_model* first_model_ptr,
+    const Multi_modal_model* second_model_ptr
+);
+
+/* -------------------------------------------------------------------------- */
+
+int main(int argc, char **argv)
+{
+    int                          status             = EXIT_SUCCESS;
+    Topology_vector*             topology_vp        = NULL;
+    Cluster_data*                data_ptr           = NULL;
+    Multi_modal_model*           serial_model_ptr   = NULL;
+    Multi_modal_model*           threaded_model_ptr = NULL;
+    Multi_modal_model*           default_model_ptr  = NULL;
+    Multi_modal_model*           other_model_ptr    = NULL;
+    Multi_modal_cluster_options* serial_options_ptr;
+    Multi_modal_cluster_options* threaded_options_ptr;
+    Multi_modal_cluster_options* default_options_ptr;
+    Multi_modal_cluster_options* other_options_ptr;
+
+
+    kjb_init();
+
+    EPETB(set_heap_options("heap-checking", "f"));
+
+    kjb_seed_rand(1, 2);
+    NPETE(data_ptr = create_test_data(NUM_POINTS));
+
+    EPETE(get_target_topology_vector(&topology_vp, 1));
+    EPETE(get_topology(&(topology_vp->topologies[ 0 ]), 2, 0, 2, 4, 0, 0));
+
+    NPETE(serial_options_ptr = create_multi_modal_cluster_options());
+    NPETE(threaded_options_ptr = create_multi_modal_cluster_options());
+
+    EPETE(set_multi_modal_cluster_options_2(serial_options_ptr,
+                                            "hc-max-num-iterations",
+                                            NUM_ITERATIONS_STR));
+    EPETE(set_multi_modal_cluster_options_2(serial_options_ptr,
+                                            "hc-num-threads", "1"));
+    EPETE(set_multi_modal_cluster_options_2(threaded_options_ptr,
+                                            "hc-max-num-iterations",
+                                            NUM_ITERATIONS_STR));
+    EPETE(set_multi_modal_cluster_options_2(threaded_options_ptr,
+                                            "hc-num-threads", "4"));
+
+    EPETE(fit_test_model(topology_vp, data_ptr, serial_options_ptr,
+                         &serial_model_ptr));
+    EPETE(fit_test_model(topology_vp, data_ptr, threaded_options_ptr,
+                         &threaded_model_ptr));
+
+    if ( ! are_models_equal(serial_model_ptr, threaded_model_ptr))
+    {
+        p_stderr("Model fit with 4 threads differs from the one fit with 1.\n");
+        status = EXIT_BUG;
+    }
+
+    /*
+     * Options set on one structure, including ones set after another
+     * structure was created, must not leak into fits done with the other.
+    */
+    NPETE(default_options_ptr = create_multi_modal_cluster_options());
+
+    EPETE(set_multi_modal_cluster_options_2(default_options_ptr,
+                                            "hc-max-num-iterations",
+                                            NUM_ITERATIONS_STR));
+
+    NPETE(other_options_ptr = create_multi_modal_cluster_options());
+
+    EPETE(set_multi_modal_cluster_options_2(other_options_ptr,
+                                            "hc-max-num-iterations", "3"));
+    EPETE(set_multi_modal_cluster_options_2(other_options_ptr,
+                                            "hc-num-threads", "3"));
+    EPETE(set_multi_modal_cluster_options_2(
+                                  other_options_ptr,
+                                  "hc-phase-two-uniform-vertical-dist", "t"));
+    EPETE(set_multi_modal_cluster_options_2(
+                                  serial_options_ptr,
+                                  "hc-phase-two-cluster-dependent-vertical-dist",
+                                  "t"));
+
+    EPETE(fit_test_model(topology_vp, data_ptr, default_options_ptr,
+                         &default_model_ptr));
+    EPETE(fit_test_model(topology_vp, data_ptr, other_options_ptr,
+                         &other_model_ptr));
+
+    if ( ! are_models_equal(threaded_model_ptr, default_model_ptr))
+    {
+        p_stderr("Setting options on one structure changed a fit done with another.\n");
+        status = EXIT_BUG;
+    }
+
+    if (are_models_equal(default_model_ptr, other_model_ptr))
+    {
+        p_stderr("Options set on a structure were not used by its fit.\n");
+        status = EXIT_BUG;
+    }
+
+    free_multi_modal_model(serial_model_ptr);
+    free_multi_modal_model(threaded_model_ptr);
+    free_multi_modal_model(default_model_ptr);
+    free_multi_modal_model(other_model_ptr);
+    free_multi_modal_cluster_options(serial_options_ptr);
+    free_multi_modal_cluster_options(threaded_options_ptr);
+    free_multi_modal_cluster_options(default_options_ptr);
+    free_multi_modal_cluster_options(other_options_ptr);
+    free_topology_vector(topology_vp);
+    free_cluster_data(data_ptr);
+
+    return status;
+}
+
+/*  /\   /\   /\   /\   /\   /\   /\   /\   /\   /\   /\   /\   /\   /\   /\  */
+
+/*
+ * Points come in three groups with overlapping words and nearby continuous
+ * features, so the fit has something to find.
+*/
+static Cluster_data* create_test_data(int num_points)
+{
+    Cluster_data* data_ptr;
+    int           point, item, feature;
+
+
+    NRN(data_ptr = allocate_cluster_data());
+
+    data_ptr->num_points = num_points;
+    data_ptr->num_categories = NUM_CATEGORIES;
+    data_ptr->num_con_features = NUM_CON_FEATURES;
+
+    ERN(get_initialized_int_matrix(&(data_ptr->dis_item_mp), num_points,
+                                   NUM_DIS_ITEMS, -1));
+    ERN(get_initialized_matrix(&(data_ptr->dis_item_multiplicity_mp),
+                               num_points, NUM_DIS_ITEMS, 1.0));
+    ERN(get_target_matrix_vector(&(data_ptr->con_item_mvp), num_points));
+    ERN(get_target_int_vector(&(data_ptr->id_vp), num_points));
+
+    for (point = 0; point < num_points; point++)
+    {
+        int group = point % 3;
+        Matrix* con_item_mp;
+
+        for (item = 0; item < NUM_DIS_ITEMS - 1; item++)
+        {
+            data_ptr->dis_item_mp->elements[ point ][ item ] =
+                   (3 * group + item + (int)(2.0 * kjb_rand())) % NUM_CATEGORIES;
+        }
+
+        ERN(get_target_matrix(&(data_ptr->con_item_mvp->elements[ point ]),
+                              NUM_CON_ITEMS, NUM_CON_FEATURES));
+        con_item_mp = data_ptr->con_item_mvp->elements[ point ];
+
+        for (item = 0; item < NUM_CON_ITEMS; item++)
+        {
+            for (feature = 0; feature < NUM_CON_FEATURES; feature++)
+            {
+                con_item_mp->elements[ item ][ feature ] =
+                                2.0 * group + feature + 0.5 * kjb_rand();
+            }
+        }
+
+        data_ptr->id_vp->elements[ point ] = point;
+    }
+
+    ERN(set_max_num_cluster_data_items(data_ptr));
+
+    return data_ptr;
+}
+
+/*  /\   /\   /\   /\   /\   /\   /\   /\   /\   /\   /\   /\   /\   /\   /\  */
+
+static Multi_modal_model* create_test_model(void)
+{
+    Multi_modal_model* model_ptr;
+
+
+    NRN(model_ptr = allocate_multi_modal_model());
+
+    model_ptr->num_con_features = NUM_CON_FEATURES;
+    model_ptr->num_categories = NUM_CATEGORIES;
+
+    ERN(get_initialized_int_vector(&(model_ptr->con_feature_enable_vp),
+                                   NUM_CON_FEATURES, 1));
+    ERN(get_initialized_int_vector(&(model_ptr->con_feature_group_vp),
+                                   NUM_CON_FEATURES, 0));
+
+    return model_ptr;
+}
+
+/*  /\   /\   /\   /\   /\   /\   /\   /\   /\   /\   /\   /\   /\   /\   /\  */
+
+/*
+ * Every fit starts from the same seed, so fits with equivalent options must
+ * give identical models.
+*/
+static int fit_test_model
+(
+    const Topology_vector*             topology_vp,
+    const Cluster_data*                data_ptr,
+    const Multi_modal_cluster_options* cluster_options_ptr,
+    Multi_modal_model**                model_ptr_ptr
+)
+{
+    Multi_modal_model* model_ptr;
+
+
+    NRE(model_ptr = create_test_model());
+
+    kjb_seed_rand(3, 4);
+
+    if (do_multi_modal_clustering_with_options(topology_vp, NULL, data_ptr,
+                                               NULL, model_ptr, NULL, NULL,
+                                               NULL, cluster_options_ptr)
+        == ERROR)
+    {
+        free_multi_modal_model(model_ptr);
+        return ERROR;
+    }
+
+    *model_ptr_ptr = model_ptr;
+
+    return NO_ERROR;
+}
+
+/*  /\   /\   /\   /\   /\   /\   /\   /\   /\   /\   /\   /\   /\   /\   /\  */
+
+static int are_matrix_vectors_equal
+(
+    const Matrix_vector* first_mvp,
+    const Matrix_vector* second_mvp
+)
+{
+    int i;
+
+
+    if ((first_mvp == NULL) || (second_mvp == NULL))
+    {
+        return (first_mvp == second_mvp);
+    }
+
+    if (first_mvp->length != second_mvp->length) return FALSE;
+
+    for (i = 0; i < first_mvp->length; i++)
+    {
+        if ((first_mvp->elements[ i ] == NULL)
+            || (second_mvp->elements[ i ] == NULL))
+        {
+            if (first_mvp->elements[ i ] != second_mvp->elements[ i ])
+            {
+                return FALSE;
+            }
+        }
+        else if (max_abs_matrix_difference(first_mvp->elements[ i ],
+                                           second_mvp->elements[ i ]) != 0.0)
+        {
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
+/*  /\   /\   /\   /\   /\   /\   /\   /\   /\   /\   /\   /\   /\   /\   /\  */
+
+/*
+ * Models must be the same to the last bit, as the threaded E-step reduces the
+ * statistics of fixed slices of points in a fixed order.
+*/
+static int are_models_equal
+(
+    const Multi_modal_model* first_model_ptr,
+    const Multi_modal_model* second_model_ptr
+)
+{
+    if (first_model_ptr->raw_log_likelihood
+        != second_model_ptr->raw_log_likelihood)
+    {
+        return FALSE;
+    }
+
+    if (max_abs_vector_difference(first_model_ptr->a_vp,
+                                  second_model_ptr->a_vp) != 0.0)
+    {
+        return FALSE;
+    }
+
+    if (max_abs_matrix_difference(first_model_ptr->V_mp,
+                                  second_model_ptr->V_mp) != 0.0)
+    {
+        return FALSE;
+    }
+
+    return (    are_matrix_vectors_equal(first_model_ptr->P_i_n_mvp,
+                                         second_model_ptr->P_i_n_mvp)
+             && are_matrix_vectors_equal(first_model_ptr->mean_mvp,
+                                         second_model_ptr->mean_mvp)
+             && are_matrix_vectors_equal(first_model_ptr->var_mvp,
+                                         second_model_ptr->var_mvp));
+}
@@ -19,6 +19,7 @@
 * =========================================================================== */
 
 #include "n/n_cholesky.h"
+#include "n/n_factor.h"
 #include "wrap_lapack/wrap_lapack.h"
 
 #ifdef __cplusplus
@@ -173,6 +174,9 @@ int cholesky_decomposition(Matrix** target_mpp, const Matrix* input_mp)
  *    Returns ERROR on failure, setting the the errors string accordingly, and 
  *    NO_ERROR otherwise.
  *
+ * The work is done by native_cholesky_factor(), which is blocked, and uses
+ * more than one thread if the option "native-factorization-threads" is set.
+ *
  * Note:
  *    This function sometimes returns an "not positive definite" error if the 
  *    matrix is too ill-conditioned.  The lapack version is slightly more 
@@ -188,10 +192,9 @@ int cholesky_decomposition(Matrix** target_mpp, const Matrix* input_mp)
 int do_native_cholesky_decomposition(Matrix** L, const Matrix* A)
 {
     Matrix* Lp = NULL;
-    double sum;
     Matrix** in_place_ptr = NULL;
 
-    int i, j, k;
+    int i, j;
 
     if(A == NULL)
     {
@@ -215,39 +218,28 @@ int do_native_cholesky_decomposition(Matrix** L, const Matrix* A)
     ERE(get_zero_matrix(L, A->num_rows, A->num_cols));
     Lp = *L;
 
+    if (A->num_rows != A->num_cols)
+    {
+        SET_ARGUMENT_BUG();
+        return ERROR;
+    }
+
     for(i = 0; i < A->num_rows; i++)
     {
         for(j = 0; j <= i; j++)
         {
-            if(i == j)
-            {
-                sum = 0;
-                for(k = 0; k < i; k++)
-                {
-                    sum += Lp->elements[i][k] * Lp->elements[i][k];
-                }
-
-                if(A->elements[i][j] < sum)
-                {
-                    set_error("Cholesky decomposition: matrix is not positive definite.");
-                    free_matrix(*L);
-                    *L = NULL;
-                    return ERROR;
-                }
-                Lp->elements[i][j] = sqrt(A->elements[i][j] - sum);
-            }
-            else
-            {
-                sum = 0;
-                for(k = 0; k < j; k++)
-                {
-                    sum += Lp->elements[i][k] * Lp->elements[j][k];
-                }
-                Lp->elements[i][j] = (Lp->elements[j][j] != 0) ? (A->elements[i][j] - sum) / Lp->elements[j][j] : 0;
-            }
+            Lp->elements[i][j] = A->elements[i][j];
         }
     }
 
+    /* The blocked (and possibly threaded) version does the work. */
+    if (native_cholesky_factor(Lp) == ERROR)
+    {
+        free_matrix(*L);
+        *L = NULL;
+        return ERROR;
+    }
+
     if(in_place_ptr)
     {
         free_matrix(*in_place_ptr);
@@ -20,6 +20,7 @@
 
 #include "n/n_gen.h"      /*  Only safe if first #include in a ".c" file  */
 #include "wrap_lapack/wrap_lapack.h"
+#include "n/n_factor.h"
 #include "n/n_diagonalize.h"
 
 
@@ -29,6 +30,74 @@ extern "C" {
 
 /* -------------------------------------------------------------------------- */
 
+static int initialize_diagonalize_symmetric_method(void);
+
+/* -------------------------------------------------------------------------- */
+
+static Method_option fs_diagonalize_symmetric_methods[ ] =
+{
+    { "lapack", "lapack", (int(*)())lapack_diagonalize_symmetric },
+    { "native", "native", (int(*)())do_native_diagonalize_symmetric }
+};
+
+static const int fs_num_diagonalize_symmetric_methods =
+                                sizeof(fs_diagonalize_symmetric_methods) /
+                                          sizeof(fs_diagonalize_symmetric_methods[ 0 ]);
+
+static int         fs_diagonalize_symmetric_method                  = NEVER_SET;
+static const char* fs_diagonalize_symmetric_method_option_short_str = "diagonalize-symmetric";
+static const char* fs_diagonalize_symmetric_method_option_long_str  = "diagonalize-symmetric-method";
+
+/* -------------------------------------------------------------------------- */
+
+int set_diagonalize_symmetric_options(const char* option, const char* value)
+{
+    char lc_option[ 100 ];
+    int  result           = NOT_FOUND;
+
+
+    EXTENDED_LC_BUFF_CPY(lc_option, option);
+
+    if (    (lc_option[ 0 ] == '\0')
+          || match_pattern(lc_option, fs_diagonalize_symmetric_method_option_short_str)
+          || match_pattern(lc_option, fs_diagonalize_symmetric_method_option_long_str)
+       )
+    {
+        if (value == NULL) return NO_ERROR;
+
+        ERE(initialize_diagonalize_symmetric_method());
+
+        ERE(parse_method_option(fs_diagonalize_symmetric_methods, fs_num_diagonalize_symmetric_methods,
+                                fs_diagonalize_symmetric_method_option_long_str,
+                                "symmetric diagonalization method", value, &fs_diagonalize_symmetric_method));
+        result = NO_ERROR;
+    }
+
+    return result;
+}
+
+/*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\   */
+
+static int initialize_diagonalize_symmetric_method(void)
+{
+    if (fs_diagonalize_symmetric_method == NEVER_SET)
+    {
+        const char* default_method = have_lapack() ? "lapack" : "native";
+
+        if (parse_method_option(fs_diagonalize_symmetric_methods, fs_num_diagonalize_symmetric_methods,
+                                fs_diagonalize_symmetric_method_option_long_str,
+                                "symmetric diagonalization method", default_method, &fs_diagonalize_symmetric_method)
+            == ERROR)
+        {
+            SET_CANT_HAPPEN_BUG();
+            return ERROR;
+        }
+    }
+
+    return NO_ERROR;
+}
+
+/*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\   */
 
 /* =============================================================================
  *                              diagonalize
@@ -187,10 +256,10 @@ int diagonalize_2
  *     ambigous up to a sign, so if you compare the results with other
  *     eigensolvers, you may have to multiply one of the results by -1.
  *
- * Note:
- *     This routine requires that that the LAPACK library is available. If this
- *     file was compiled without the presence of that library, then this routine
- *     will return ERROR.
+ * The method used can be set with the option "diagonalize-symmetric-method".
+ * If it is "lapack" (the default if the LAPACK library is available), then
+ * LAPACK is used. Otherwise it is "native", which uses Jacobi rotations (see
+ * do_native_diagonalize_symmetric()).
  *
  * Returns:
  *     NO_ERROR on success, and ERROR on failure, with an appropriate error
@@ -203,7 +272,15 @@ int diagonalize_2
 
 int diagonalize_symmetric(const Matrix* mp, Matrix** E_mpp, Vector** D_vpp)
 {
-    return lapack_diagonalize_symmetric(mp, E_mpp, D_vpp);
+    int (*diagonalize_fn) (const Matrix*, Matrix**, Vector**);
+
+
+    ERE(initialize_diagonalize_symmetric_method());
+
+    diagonalize_fn = (int (*) (const Matrix*, Matrix**, Vector**))
+                           fs_diagonalize_symmetric_methods[ fs_diagonalize_symmetric_method ].fn;
+
+    return diagonalize_fn(mp, E_mpp, D_vpp);
 }
 
 /*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\   */
@@ -32,6 +32,8 @@ namespace kjb_c {
 #endif
 
 
+int set_diagonalize_symmetric_options(const char* option, const char* value);
+
 int diagonalize(const Matrix* mp, Matrix** E_mpp, Vector** D_vpp);
 
 int diagonalize_2
@@ -0,0 +1,1405 @@
+/* $Id$ */
+
+/* =========================================================================== *
+|
+|  Copyright (c) 1994-2008 by Kobus Barnard (author).
+|
+|  Personal and educational use of this code is granted, provided that this
+|  header is kept intact, and that the authorship is not misrepresented, that
+|  its use is acknowledged in publications, and relevant papers are cited.
+|
+|  For other use contact the author (kobus AT cs DOT arizona DOT edu).
+|
+|  Please note that the code in this file has not necessarily been adequately
+|  tested. Naturally, there is no guarantee of performance, support, or fitness
+|  for any particular task. Nonetheless, I am interested in hearing about
+|  problems that you encounter.
+|
+* =========================================================================== */
+
+/*
+ * Native dense factorizations, for when LAPACK is not available (or not
+ * wanted). The routines work directly on the rows of KJB matrices. The
+ * Cholesky and LU factorizations are blocked, so that the bulk of the work is
+ * an update of the trailing matrix with dot products and row updates over
+ * contiguous memory, which the compiler can vectorize. That update, and the
+ * triangular solves with many right hand sides, are split over threads when
+ * the option "native-factorization-threads" is greater than one.
+*/
+
+#include "n/n_gen.h"      /*  Only safe if first #include in a ".c" file  */
+#include "n/n_factor.h"
+#include "l_mt/l_mt_pthread.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* -------------------------------------------------------------------------- */
+
+/* Number of columns (or rows) in a block of the blocked factorizations. */
+#define FACTOR_BLOCK_SIZE            64
+
+/* Number of columns of the right hand side handled together by the solves. */
+#define SOLVE_BLOCK_SIZE            256
+
+/* Do not start threads for less than this many flops each. */
+#define MIN_FLOPS_PER_THREAD    100000.0
+
+/* Maximum number of Jacobi sweeps for symmetric eigenproblems. */
+#define MAX_JACOBI_SWEEPS            60
+
+/* -------------------------------------------------------------------------- */
+
+/*
+ * A function that does items begin, begin + step, ... < end of some job.
+ * Items are assigned to threads cyclically, which balances the triangular
+ * updates, where the work of a row grows with its index.
+*/
+typedef void (*Range_fn)(const void* context, int begin, int end, int step);
+
+typedef struct Range_job
+{
+    Range_fn    fn;
+    const void* context;
+    int         begin;
+    int         end;
+    int         step;
+}
+Range_job;
+
+typedef struct Cholesky_context
+{
+    double** a;
+    int      k0;
+    int      k1;
+}
+Cholesky_context;
+
+typedef struct Lu_context
+{
+    double** a;
+    int      n;
+    int      k0;
+    int      k1;
+}
+Lu_context;
+
+typedef struct Triangular_context
+{
+    double**      x;
+    double* const* t;
+    int           n;
+    int           m;
+}
+Triangular_context;
+
+/* -------------------------------------------------------------------------- */
+
+static void  run_range
+(
+    Range_fn    fn,
+    const void* context,
+    int         begin,
+    int         end,
+    double      flops
+);
+
+static void* range_job_main(void* arg);
+
+static int   cholesky_diagonal_block(double** a, int k0, int k1);
+
+static void  cholesky_panel_rows
+(
+    const void* context,
+    int         begin,
+    int         end,
+    int         step
+);
+
+static void  cholesky_trailing_rows
+(
+    const void* context,
+    int         begin,
+    int         end,
+    int         step
+);
+
+static void  lu_trailing_rows
+(
+    const void* context,
+    int         begin,
+    int         end,
+    int         step
+);
+
+static void  forward_substitution_blocks
+(
+    const void* context,
+    int         begin,
+    int         end,
+    int         step
+);
+
+static void  back_substitution_blocks
+(
+    const void* context,
+    int         begin,
+    int         end,
+    int         step
+);
+
+static int   check_triangular_args
+(
+    const Matrix* t_mp,
+    const Matrix* b_mp
+);
+
+/* -------------------------------------------------------------------------- */
+
+static int fs_num_factorization_threads = 1;
+
+/* -------------------------------------------------------------------------- */
+
+int set_native_factorization_options(const char* option, const char* value)
+{
+    char lc_option[ 100 ];
+    int  temp_int_value;
+    int  result           = NOT_FOUND;
+
+
+    EXTENDED_LC_BUFF_CPY(lc_option, option);
+
+    if (    (lc_option[ 0 ] == '\0')
+          || match_pattern(lc_option, "native-factorization-threads")
+       )
+    {
+        if (value == NULL)
+        {
+            return NO_ERROR;
+        }
+        else if (value[ 0 ] == '\0')
+        {
+            ERE(pso("Native matrix factorizations use %d thread(s).\n",
+                    fs_num_factorization_threads));
+        }
+        else if (value[ 0 ] == '?')
+        {
+            ERE(pso("native-factorization-threads = %d\n",
+                    fs_num_factorization_threads));
+        }
+        else
+        {
+            ERE(ss1pi(value, &temp_int_value));
+
+            if (temp_int_value < 1)
+            {
+                set_error("%q is an invalid number of threads.", value);
+                return ERROR;
+            }
+
+            fs_num_factorization_threads = temp_int_value;
+        }
+        result = NO_ERROR;
+    }
+
+    return result;
+}
+
+/*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\   */
+
+/*
+ * Does items [begin, end) of a job, split over threads if the job is big
+ * enough. If a thread cannot be started, its items are done in the calling
+ * thread.
+*/
+static void run_range
+(
+    Range_fn    fn,
+    const void* context,
+    int         begin,
+    int         end,
+    double      flops
+)
+{
+    int        num_threads = MIN_OF(fs_num_factorization_threads, end - begin);
+    Range_job* jobs;
+    kjb_pthread_t* threads;
+    int*       started;
+    int        t;
+
+
+    if (flops < num_threads * MIN_FLOPS_PER_THREAD)
+    {
+        num_threads = (int)(flops / MIN_FLOPS_PER_THREAD);
+    }
+
+    if (num_threads <= 1)
+    {
+        fn(context, begin, end, 1);
+        return;
+    }
+
+    jobs = N_TYPE_MALLOC(Range_job, num_threads);
+    threads = N_TYPE_MALLOC(kjb_pthread_t, num_threads);
+    started = INT_MALLOC(num_threads);
+
+    if ((jobs == NULL) || (threads == NULL) || (started == NULL))
+    {
+        kjb_free(started);
+        kjb_free(threads);
+        kjb_free(jobs);
+        fn(context, begin, end, 1);
+        return;
+    }
+
+    for (t = 0; t < num_threads; t++)
+    {
+        jobs[ t ].fn = fn;
+        jobs[ t ].context = context;
+        jobs[ t ].begin = begin + t;
+        jobs[ t ].end = end;
+        jobs[ t ].step = num_threads;
+    }
+
+    for (t = 1; t < num_threads; t++)
+    {
+        started[ t ] = kjb_pthread_create(&threads[ t ], NULL,
+                                          range_job_main, &jobs[ t ]) != ERROR;
+    }
+
+    range_job_main(&jobs[ 0 ]);
+
+    for (t = 1; t < num_threads; t++)
+    {
+        if (started[ t ])
+        {
+            kjb_pthread_join(threads[ t ], NULL);
+        }
+        else
+        {
+            range_job_main(&jobs[ t ]);
+        }
+    }
+
+    kjb_free(started);
+    kjb_free(threads);
+    kjb_free(jobs);
+}
+
+/*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\   */
+
+static void* range_job_main(void* arg)
+{
+    const Range_job* job = (const Range_job*)arg;
+
+    job->fn(job->context, job->begin, job->end, job->step);
+
+    return NULL;
+}
+
+/*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\   */
+
+/* =============================================================================
+ *                          native_cholesky_factor
+ *
+ * Blocked Cholesky decomposition in place
+ *
+ * This routine overwrites the lower triangle of the square matrix pointed to
+ * by mp with L such that LL' = A, where A is the (symmetric) input, and sets
+ * the upper triangle to zero. Only the lower triangle of the input is used.
+ *
+ * The factorization proceeds by blocks of columns. The diagonal block is
+ * factored directly, the rows below it are solved against it, and then the
+ * rest of the lower triangle is updated; the rows of the last two steps are
+ * independent, and are split over threads if the option
+ * "native-factorization-threads" is more than one.
+ *
+ * As with the original native implementation, a zero pivot gives a zero
+ * column rather than an error, but a negative one fails.
+ *
+ * Returns:
+ *    Returns ERROR on failure (if the matrix is not positive definite), setting
+ *    the the errors string accordingly, and NO_ERROR otherwise.
+ *
+ * Index: matrices, matrix decomposition
+ *
+ * -----------------------------------------------------------------------------
+*/
+
+int native_cholesky_factor(Matrix* mp)
+{
+    double**         a;
+    int              n;
+    int              i, j;
+    int              k0, k1;
+    Cholesky_context context;
+
+
+    if ((mp == NULL) || (mp->num_rows != mp->num_cols))
+    {
+        SET_ARGUMENT_BUG();
+        return ERROR;
+    }
+
+    a = mp->elements;
+    n = mp->num_rows;
+
+    for (i = 0; i < n; i++)
+    {
+        for (j = i + 1; j < n; j++)
+        {
+            a[ i ][ j ] = 0.0;
+        }
+    }
+
+    context.a = a;
+
+    for (k0 = 0; k0 < n; k0 = k1)
+    {
+        double panel_flops;
+
+        k1 = MIN_OF(k0 + FACTOR_BLOCK_SIZE, n);
+
+        ERE(cholesky_diagonal_block(a, k0, k1));
+
+        context.k0 = k0;
+        context.k1 = k1;
+
+        panel_flops = (double)(n - k1) * (k1 - k0) * (k1 - k0);
+        run_range(cholesky_panel_rows, &context, k1, n, panel_flops);
+
+        panel_flops = (double)(n - k1) * (n - k1) * (k1 - k0);
+        run_range(cholesky_trailing_rows, &context, k1, n, panel_flops);
+    }
+
+    return NO_ERROR;
+}
+
+/*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\   */
+
+/*
+ * Factors the diagonal block [k0, k1), whose entries have already been
+ * updated with the columns to its left.
+*/
+static int cholesky_diagonal_block(double** a, int k0, int k1)
+{
+    int i, j, p;
+
+
+    for (i = k0; i < k1; i++)
+    {
+        for (j = k0; j <= i; j++)
+        {
+            double sum = a[ i ][ j ];
+
+            for (p = k0; p < j; p++)
+            {
+                sum -= a[ i ][ p ] * a[ j ][ p ];
+            }
+
+            if (i == j)
+            {
+                if (sum < 0.0)
+                {
+                    set_error("Cholesky decomposition: matrix is not positive definite.");
+                    return ERROR;
+                }
+                a[ i ][ i ] = sqrt(sum);
+            }
+            else
+            {
+                a[ i ][ j ] = (a[ j ][ j ] != 0.0) ? sum / a[ j ][ j ] : 0.0;
+            }
+        }
+    }
+
+    return NO_ERROR;
+}
+
+/*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\   */
+
+/* Solves rows below the diagonal block against it. */
+static void cholesky_panel_rows
+(
+    const void* context,
+    int         begin,
+    int         end,
+    int         step
+)
+{
+    const Cholesky_context* c = (const Cholesky_context*)context;
+    double** a = c->a;
+    int      i, j, p;
+
+
+    for (i = begin; i < end; i += step)
+    {
+        double* a_i = a[ i ];
+
+        for (j = c->k0; j < c->k1; j++)
+        {
+            const double* a_j = a[ j ];
+            double        sum = a_i[ j ];
+
+            for (p = c->k0; p < j; p++)
+            {
+                sum -= a_i[ p ] * a_j[ p ];
+            }
+
+            a_i[ j ] = (a_j[ j ] != 0.0) ? sum / a_j[ j ] : 0.0;
+        }
+    }
+}
+
+/*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\   */
+
+/* Subtracts the contribution of the block columns from the trailing rows. */
+static void cholesky_trailing_rows
+(
+    const void* context,
+    int         begin,
+    int         end,
+    int         step
+)
+{
+    const Cholesky_context* c = (const Cholesky_context*)context;
+    double** a  = c->a;
+    const int k0 = c->k0;
+    const int k1 = c->k1;
+    int       i, j, p;
+
+
+    for (i = begin; i < end; i += step)
+    {
+        const double* l_i = a[ i ] + k0;
+
+        for (j = k1; j <= i; j++)
+        {
+            const double* l_j = a[ j ] + k0;
+            double        sum = 0.0;
+
+            for (p = 0; p < k1 - k0; p++)
+            {
+                sum += l_i[ p ] * l_j[ p ];
+            }
+
+            a[ i ][ j ] -= sum;
+        }
+    }
+}
+
+/*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\   */
+
+/* =============================================================================
+ *                          native_lu_factor
+ *
+ * Blocked LU decomposition with partial pivoting, in place
+ *
+ * This routine overwrites the square matrix A pointed to by mp with L and U
+ * such that PA = LU, where L is unit lower triangular (its diagonal is not
+ * stored), U is upper triangular, and P is a permutation of the rows. Row i of
+ * the result corresponds to row perm[i] of A, where perm must have room for
+ * one int per row.
+ *
+ * The factorization proceeds by blocks of columns. Each block column is
+ * factored with partial pivoting, the block row to its right is solved, and
+ * then the trailing matrix is updated with row operations; the rows of that
+ * update are split over threads if the option "native-factorization-threads"
+ * is more than one.
+ *
+ * Returns:
+ *    NO_ERROR on success, and ERROR if the matrix is (numerically) singular,
+ *    with an error message being set.
+ *
+ * Index: matrices, matrix decomposition
+ *
+ * -----------------------------------------------------------------------------
+*/
+
+int native_lu_factor(Matrix* mp, int* perm)
+{
+    double**   a;
+    int        n;
+    int        i, j, p, c;
+    int        k0, k1;
+    Lu_context context;
+
+
+    if ((mp == NULL) || (perm == NULL) || (mp->num_rows != mp->num_cols))
+    {
+        SET_ARGUMENT_BUG();
+        return ERROR;
+    }
+
+    a = mp->elements;
+    n = mp->num_rows;
+
+    for (i = 0; i < n; i++)
+    {
+        perm[ i ] = i;
+    }
+
+    context.a = a;
+    context.n = n;
+
+    for (k0 = 0; k0 < n; k0 = k1)
+    {
+        k1 = MIN_OF(k0 + FACTOR_BLOCK_SIZE, n);
+
+        /* Factor the block column, swapping whole rows. */
+        for (j = k0; j < k1; j++)
+        {
+            int    pivot_row = j;
+            double big = ABS_OF(a[ j ][ j ]);
+            double pivot_inv;
+
+            for (i = j + 1; i < n; i++)
+            {
+                if (ABS_OF(a[ i ][ j ]) > big)
+                {
+                    pivot_row = i;
+                    big = ABS_OF(a[ i ][ j ]);
+                }
+            }
+
+            if (big <= 10.0 * DBL_EPSILON)
+            {
+                set_error("LU decomposition failed -- matrix is probably singular.");
+                return ERROR;
+            }
+
+            if (pivot_row != j)
+            {
+                int temp_index = perm[ j ];
+
+                perm[ j ] = perm[ pivot_row ];
+                perm[ pivot_row ] = temp_index;
+
+                ERE(swap_matrix_rows(mp, j, pivot_row));
+            }
+
+            pivot_inv = 1.0 / a[ j ][ j ];
+
+            for (i = j + 1; i < n; i++)
+            {
+                double* a_i = a[ i ];
+                const double* a_j = a[ j ];
+                double  l_ij = a_i[ j ] * pivot_inv;
+
+                a_i[ j ] = l_ij;
+
+                for (c = j + 1; c < k1; c++)
+                {
+                    a_i[ c ] -= l_ij * a_j[ c ];
+                }
+            }
+        }
+
+        /* Solve the block row to the right with the unit lower block. */
+        for (i = k0 + 1; i < k1; i++)
+        {
+            double* a_i = a[ i ];
+
+            for (p = k0; p < i; p++)
+            {
+                const double* a_p = a[ p ];
+                double        l_ip = a_i[ p ];
+
+                for (c = k1; c < n; c++)
+                {
+                    a_i[ c ] -= l_ip * a_p[ c ];
+                }
+            }
+        }
+
+        context.k0 = k0;
+        context.k1 = k1;
+
+        run_range(lu_trailing_rows, &context, k1, n,
+                  2.0 * (n - k1) * (n - k1) * (k1 - k0));
+    }
+
+    return NO_ERROR;
+}
+
+/*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\   */
+
+/* Subtracts L21 * U12 from the trailing rows. */
+static void lu_trailing_rows
+(
+    const void* context,
+    int         begin,
+    int         end,
+    int         step
+)
+{
+    const Lu_context* l = (const Lu_context*)context;
+    double** a = l->a;
+    const int n  = l->n;
+    const int k1 = l->k1;
+    int       i, p, c;
+
+
+    for (i = begin; i < end; i += step)
+    {
+        double* a_i = a[ i ];
+
+        for (p = l->k0; p < k1; p++)
+        {
+            const double* a_p = a[ p ];
+            double        l_ip = a_i[ p ];
+
+            if (l_ip == 0.0) continue;
+
+            for (c = k1; c < n; c++)
+            {
+                a_i[ c ] -= l_ip * a_p[ c ];
+            }
+        }
+    }
+}
+
+/*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\   */
+
+/* =============================================================================
+ *                          do_native_lu_matrix_inversion
+ *
+ * Inverts a matrix using a native LU decomposition
+ *
+ * This routine computes the inverse of a matrix by factoring it with
+ * native_lu_factor() and solving for the columns of the (permuted) identity.
+ * Normally it is not called directly, but through get_matrix_inverse() with
+ * the option "matrix-inversion-method" set to "lu", which is the default when
+ * LAPACK is not available.
+ *
+ * The first argument is the adress of the target matrix. If the target matrix
+ * itself is NULL, then a matrix of the appropriate size is created. If the
+ * target matrix is the wrong size, it is resized. Finally, if it is the right
+ * size, then the storage is recycled, as is.
+ *
+ * Returns:
+ *     NO_ERROR on success, and ERROR on failure, with an error message being
+ *     set. This routine will fail if the matrix is close to singular, or if
+ *     memory allocation fails.
+ *
+ * Index: matrices, matrix arithmetic
+ *
+ * -----------------------------------------------------------------------------
+*/
+
+int do_native_lu_matrix_inversion(Matrix** target_mpp, const Matrix* input_mp)
+{
+    Matrix* lu_mp = NULL;
+    Matrix* b_mp  = NULL;
+    int*    perm  = NULL;
+    int     n;
+    int     i;
+    int     result;
+
+
+    if (    (input_mp == NULL)
+         || (input_mp->num_rows != input_mp->num_cols)
+         || (input_mp->num_rows < 1)
+       )
+    {
+        SET_ARGUMENT_BUG();
+        return ERROR;
+    }
+
+    n = input_mp->num_rows;
+
+    NRE(perm = INT_MALLOC(n));
+
+    result = copy_matrix(&lu_mp, input_mp);
+
+    if (result != ERROR)
+    {
+        result = native_lu_factor(lu_mp, perm);
+    }
+
+    /* Since PA = LU, inv(A) = inv(U) inv(L) P; we solve for the columns. */
+    if (result != ERROR)
+    {
+        result = get_zero_matrix(&b_mp, n, n);
+    }
+
+    if (result != ERROR)
+    {
+        for (i = 0; i < n; i++)
+        {
+            b_mp->elements[ i ][ perm[ i ] ] = 1.0;
+        }
+    }
+
+    if (result != ERROR)
+    {
+        Triangular_context context;
+        double*            u_diag = DBL_MALLOC(n);
+
+        if (u_diag == NULL)
+        {
+            result = ERROR;
+        }
+        else
+        {
+            /*
+             * The unit diagonal of L is not stored, so we put it in place for
+             * the forward solve, and then put back the diagonal of U.
+            */
+            for (i = 0; i < n; i++)
+            {
+                u_diag[ i ] = lu_mp->elements[ i ][ i ];
+                lu_mp->elements[ i ][ i ] = 1.0;
+            }
+
+            context.x = b_mp->elements;
+            context.t = lu_mp->elements;
+            context.n = n;
+            context.m = n;
+
+            run_range(forward_substitution_blocks, &context,
+                      0, (n + SOLVE_BLOCK_SIZE - 1) / SOLVE_BLOCK_SIZE,
+                      (double)n * n * n);
+
+            for (i = 0; i < n; i++)
+            {
+                lu_mp->elements[ i ][ i ] = u_diag[ i ];
+            }
+
+            run_range(back_substitution_blocks, &context,
+                      0, (n + SOLVE_BLOCK_SIZE - 1) / SOLVE_BLOCK_SIZE,
+                      (double)n * n * n);
+
+            result = copy_matrix(target_mpp, b_mp);
+        }
+
+        kjb_free(u_diag);
+    }
+
+    free_matrix(b_mp);
+    free_matrix(lu_mp);
+    kjb_free(perm);
+
+    return result;
+}
+
+/*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\   */
+
+/*
+ * Solves T X = B in place (x holds B on input) for blocks of
+ * SOLVE_BLOCK_SIZE columns, with T lower triangular. Each row of X is built
+ * with row updates over the columns of the block, which stay in cache.
+*/
+static void forward_substitution_blocks
+(
+    const void* context,
+    int         begin,
+    int         end,
+    int         step
+)
+{
+    const Triangular_context* s = (const Triangular_context*)context;
+    double**       x = s->x;
+    double* const* t = s->t;
+    int            block;
+    int            i, k, c;
+
+
+    for (block = begin; block < end; block += step)
+    {
+        const int c0 = block * SOLVE_BLOCK_SIZE;
+        const int c1 = MIN_OF(c0 + SOLVE_BLOCK_SIZE, s->m);
+
+        for (i = 0; i < s->n; i++)
+        {
+            double*       x_i = x[ i ];
+            const double* t_i = t[ i ];
+            double        t_ii_inv = 1.0 / t_i[ i ];
+
+            for (k = 0; k < i; k++)
+            {
+                const double* x_k = x[ k ];
+                double        t_ik = t_i[ k ];
+
+                if (t_ik == 0.0) continue;
+
+                for (c = c0; c < c1; c++)
+                {
+                    x_i[ c ] -= t_ik * x_k[ c ];
+                }
+            }
+
+            for (c = c0; c < c1; c++)
+            {
+                x_i[ c ] *= t_ii_inv;
+            }
+        }
+    }
+}
+
+/*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\   */
+
+/* Same as forward_substitution_blocks(), with T upper triangular. */
+static void back_substitution_blocks
+(
+    const void* context,
+    int         begin,
+    int         end,
+    int         step
+)
+{
+    const Triangular_context* s = (const Triangular_context*)context;
+    double**       x = s->x;
+    double* const* t = s->t;
+    int            block;
+    int            i, k, c;
+
+
+    for (block = begin; block < end; block += step)
+    {
+        const int c0 = block * SOLVE_BLOCK_SIZE;
+        const int c1 = MIN_OF(c0 + SOLVE_BLOCK_SIZE, s->m);
+
+        for (i = s->n - 1; i >= 0; i--)
+        {
+            double*       x_i = x[ i ];
+            const double* t_i = t[ i ];
+            double        t_ii_inv = 1.0 / t_i[ i ];
+
+            for (k = i + 1; k < s->n; k++)
+            {
+                const double* x_k = x[ k ];
+                double        t_ik = t_i[ k ];
+
+                if (t_ik == 0.0) continue;
+
+                for (c = c0; c < c1; c++)
+                {
+                    x_i[ c ] -= t_ik * x_k[ c ];
+                }
+            }
+
+            for (c = c0; c < c1; c++)
+            {
+                x_i[ c ] *= t_ii_inv;
+            }
+        }
+    }
+}
+
+/*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\   */
+
+static int check_triangular_args(const Matrix* t_mp, const Matrix* b_mp)
+{
+    int i;
+
+
+    if (    (t_mp == NULL) || (b_mp == NULL)
+         || (t_mp->num_rows != t_mp->num_cols)
+         || (t_mp->num_rows != b_mp->num_rows)
+       )
+    {
+        SET_ARGUMENT_BUG();
+        return ERROR;
+    }
+
+    for (i = 0; i < t_mp->num_rows; i++)
+    {
+        if (t_mp->elements[ i ][ i ] == 0.0)
+        {
+            set_error("Triangular matrix is singular (diagonal element %d is zero).",
+                      i + 1);
+            return ERROR;
+        }
+    }
+
+    return NO_ERROR;
+}
+
+/*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\   */
+
+/* =============================================================================
+ *                          solve_lower_triangular
+ *
+ * Solves a lower triangular system with many right hand sides
+ *
+ * This routine solves LX = B by forward substitution, where L is the square
+ * lower triangular matrix pointed to by l_mp, and B is pointed to by b_mp. The
+ * elements of L above the diagonal are not used. The result is put into the
+ * matrix pointed to by *x_mpp, which is created or resized as needed.
+ *
+ * The columns of B are solved in blocks, which are split over threads if the
+ * option "native-factorization-threads" is more than one.
+ *
+ * Returns:
+ *     NO_ERROR on success, and ERROR on failure (e.g., if a diagonal element
+ *     of L is zero), with an error message being set.
+ *
+ * Index: matrices, linear equations
+ *
+ * -----------------------------------------------------------------------------
+*/
+
+int solve_lower_triangular
+(
+    Matrix**      x_mpp,
+    const Matrix* l_mp,
+    const Matrix* b_mp
+)
+{
+    Triangular_context context;
+    Matrix*            x_mp = NULL;
+    int                n, m;
+
+
+    ERE(check_triangular_args(l_mp, b_mp));
+
+    n = b_mp->num_rows;
+    m = b_mp->num_cols;
+
+    /* B may be the target, so we work in a copy. */
+    ERE(copy_matrix(&x_mp, b_mp));
+
+    context.x = x_mp->elements;
+    context.t = l_mp->elements;
+    context.n = n;
+    context.m = m;
+
+    run_range(forward_substitution_blocks, &context,
+              0, (m + SOLVE_BLOCK_SIZE - 1) / SOLVE_BLOCK_SIZE,
+              (double)n * n * m);
+
+    if (*x_mpp == NULL)
+    {
+        *x_mpp = x_mp;
+        return NO_ERROR;
+    }
+    else
+    {
+        int result = copy_matrix(x_mpp, x_mp);
+
+        free_matrix(x_mp);
+        return result;
+    }
+}
+
+/*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\   */
+
+/* =============================================================================
+ *                          solve_upper_triangular
+ *
+ * Solves an upper triangular system with many right hand sides
+ *
+ * This routine solves UX = B by back substitution, where U is the square
+ * upper triangular matrix pointed to by u_mp, and B is pointed to by b_mp. The
+ * elements of U below the diagonal are not used. The result is put into the
+ * matrix pointed to by *x_mpp, which is created or resized as needed.
+ *
+ * The columns of B are solved in blocks, which are split over threads if the
+ * option "native-factorization-threads" is more than one.
+ *
+ * Returns:
+ *     NO_ERROR on success, and ERROR on failure (e.g., if a diagonal element
+ *     of U is zero), with an error message being set.
+ *
+ * Index: matrices, linear equations
+ *
+ * -----------------------------------------------------------------------------
+*/
+
+int solve_upper_triangular
+(
+    Matrix**      x_mpp,
+    const Matrix* u_mp,
+    const Matrix* b_mp
+)
+{
+    Triangular_context context;
+    Matrix*            x_mp = NULL;
+    int                n, m;
+
+
+    ERE(check_triangular_args(u_mp, b_mp));
+
+    n = b_mp->num_rows;
+    m = b_mp->num_cols;
+
+    ERE(copy_matrix(&x_mp, b_mp));
+
+    context.x = x_mp->elements;
+    context.t = u_mp->elements;
+    context.n = n;
+    context.m = m;
+
+    run_range(back_substitution_blocks, &context,
+              0, (m + SOLVE_BLOCK_SIZE - 1) / SOLVE_BLOCK_SIZE,
+              (double)n * n * m);
+
+    if (*x_mpp == NULL)
+    {
+        *x_mpp = x_mp;
+        return NO_ERROR;
+    }
+    else
+    {
+        int result = copy_matrix(x_mpp, x_mp);
+
+        free_matrix(x_mp);
+        return result;
+    }
+}
+
+/*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\   */
+
+/* =============================================================================
+ *                          do_native_qr_decompose
+ *
+ * QR decomposition with Householder reflections
+ *
+ * This routine computes A = QR for the m x n matrix pointed to by mp, where Q
+ * is an m x m orthonormal matrix and R is an m x n upper triangular (or
+ * trapezoidal) matrix, using Householder reflections. Normally it is not
+ * called directly, but through qr_decompose() with the option "qr-method" set
+ * to "native", which is the default when LAPACK is not available.
+ *
+ * The reflections are applied with row updates, so that the inner loops run
+ * over contiguous memory. As with LAPACK, the diagonal of R may be negative.
+ *
+ * Returns:
+ *     NO_ERROR on success, and ERROR on failure, with an appropriate error
+ *     message being set.
+ *
+ * Index: matrix decomposition
+ *
+ * -----------------------------------------------------------------------------
+*/
+
+int do_native_qr_decompose(const Matrix* mp, Matrix** Q_mpp, Matrix** R_mpp)
+{
+    double*  v = NULL;
+    double*  w = NULL;
+    double** r;
+    double** q;
+    int      m, n;
+    int      i, j, k, c;
+
+
+    if ((mp == NULL) || (Q_mpp == NULL) || (R_mpp == NULL))
+    {
+        SET_ARGUMENT_BUG();
+        return ERROR;
+    }
+
+    m = mp->num_rows;
+    n = mp->num_cols;
+
+    ERE(copy_matrix(R_mpp, mp));
+    ERE(get_identity_matrix(Q_mpp, m));
+
+    NRE(v = DBL_MALLOC(m));
+
+    if (n > 0)
+    {
+        w = DBL_MALLOC(MAX_OF(m, n));
+
+        if (w == NULL)
+        {
+            kjb_free(v);
+            return ERROR;
+        }
+    }
+
+    r = (*R_mpp)->elements;
+    q = (*Q_mpp)->elements;
+
+    for (k = 0; k < MIN_OF(m - 1, n); k++)
+    {
+        double norm_sq = 0.0;
+        double alpha;
+        double v_norm_sq;
+        double tau;
+
+        for (i = k; i < m; i++)
+        {
+            norm_sq += r[ i ][ k ] * r[ i ][ k ];
+        }
+
+        if (norm_sq == 0.0) continue;
+
+        /* Choose the sign of alpha to avoid cancellation in v[ k ]. */
+        alpha = (r[ k ][ k ] > 0.0) ? -sqrt(norm_sq) : sqrt(norm_sq);
+
+        for (i = k; i < m; i++)
+        {
+            v[ i ] = r[ i ][ k ];
+        }
+        v[ k ] -= alpha;
+
+        v_norm_sq = norm_sq - r[ k ][ k ] * r[ k ][ k ] + v[ k ] * v[ k ];
+
+        if (v_norm_sq == 0.0) continue;
+
+        tau = 2.0 / v_norm_sq;
+
+        /* R <- (I - tau v v') R, for the columns to the right of k. */
+        for (c = k + 1; c < n; c++)
+        {
+            w[ c ] = 0.0;
+        }
+
+        for (i = k; i < m; i++)
+        {
+            const double* r_i = r[ i ];
+            const double  v_i = v[ i ];
+
+            for (c = k + 1; c < n; c++)
+            {
+                w[ c ] += v_i * r_i[ c ];
+            }
+        }
+
+        for (i = k; i < m; i++)
+        {
+            double*      r_i = r[ i ];
+            const double s   = tau * v[ i ];
+
+            for (c = k + 1; c < n; c++)
+            {
+                r_i[ c ] -= s * w[ c ];
+            }
+        }
+
+        r[ k ][ k ] = alpha;
+
+        for (i = k + 1; i < m; i++)
+        {
+            r[ i ][ k ] = 0.0;
+        }
+
+        /* Q <- Q (I - tau v v'). */
+        for (j = 0; j < m; j++)
+        {
+            double* q_j = q[ j ];
+            double  s   = 0.0;
+
+            for (i = k; i < m; i++)
+            {
+                s += q_j[ i ] * v[ i ];
+            }
+
+            s *= tau;
+
+            for (i = k; i < m; i++)
+            {
+                q_j[ i ] -= s * v[ i ];
+            }
+        }
+    }
+
+    kjb_free(w);
+    kjb_free(v);
+
+    return NO_ERROR;
+}
+
+/*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\   */
+
+/* =============================================================================
+ *                          do_native_diagonalize_symmetric
+ *
+ * Diagonalizes a symmetric matrix with Jacobi rotations
+ *
+ * This routine has the same contract as diagonalize_symmetric(), through
+ * which it is normally called (with the option
+ * "diagonalize-symmetric-method" set to "native", which is the default when
+ * LAPACK is not available). Only the upper triangle of the matrix is used.
+ * The eigenvalues are sorted from largest to smallest, and the columns of *E_mpp
+ * are the corresponding eigenvectors. E_mpp may be NULL if the eigenvectors are
+ * not needed.
+ *
+ * The cyclic Jacobi method is used, which is simple and accurate (it finds
+ * small eigenvalues to high relative accuracy), and takes a small number of
+ * sweeps of O(n^3) time each.
+ *
+ * Returns:
+ *     NO_ERROR on success, and ERROR on failure, with an appropriate error
+ *     message being set.
+ *
+ * Index: diagonalization, eigenvalues, matrix decomposition
+ *
+ * -----------------------------------------------------------------------------
+*/
+
+int do_native_diagonalize_symmetric
+(
+    const Matrix* mp,
+    Matrix**      E_mpp,
+    Vector**      D_vpp
+)
+{
+    Matrix*  a_mp = NULL;
+    Matrix*  v_mp = NULL;
+    double** a;
+    double** v;
+    int*     order;
+    int      n;
+    int      i, j, k, p, q;
+    int      sweep;
+    int      result = NO_ERROR;
+
+
+    if ((mp == NULL) || (mp->num_rows != mp->num_cols) || (D_vpp == NULL))
+    {
+        SET_ARGUMENT_BUG();
+        return ERROR;
+    }
+
+    n = mp->num_rows;
+
+    ERE(get_target_matrix(&a_mp, n, n));
+
+    if (get_identity_matrix(&v_mp, n) == ERROR)
+    {
+        free_matrix(a_mp);
+        return ERROR;
+    }
+
+    a = a_mp->elements;
+    v = v_mp->elements;
+
+    for (i = 0; i < n; i++)
+    {
+        for (j = i; j < n; j++)
+        {
+            a[ i ][ j ] = a[ j ][ i ] = mp->elements[ i ][ j ];
+        }
+    }
+
+    for (sweep = 0; sweep < MAX_JACOBI_SWEEPS; sweep++)
+    {
+        double off = 0.0;
+        double diag = 0.0;
+
+        for (p = 0; p < n; p++)
+        {
+            diag += a[ p ][ p ] * a[ p ][ p ];
+
+            for (q = p + 1; q < n; q++)
+            {
+                off += a[ p ][ q ] * a[ p ][ q ];
+            }
+        }
+
+        if (off <= DBL_EPSILON * DBL_EPSILON * diag) break;
+
+        for (p = 0; p < n - 1; p++)
+        {
+            for (q = p + 1; q < n; q++)
+            {
+                double a_pq = a[ p ][ q ];
+                double theta, t, c, s;
+
+                if (a_pq == 0.0) continue;
+
+                /* Rotation in the (p, q) plane that zeros a[ p ][ q ]. */
+                theta = (a[ q ][ q ] - a[ p ][ p ]) / (2.0 * a_pq);
+                t = 1.0 / (ABS_OF(theta) + sqrt(theta * theta + 1.0));
+                if (theta < 0.0) t = -t;
+                c = 1.0 / sqrt(t * t + 1.0);
+                s = t * c;
+
+                for (k = 0; k < n; k++)
+                {
+                    double a_kp = a[ k ][ p ];
+                    double a_kq = a[ k ][ q ];
+
+                    a[ k ][ p ] = c * a_kp - s * a_kq;
+                    a[ k ][ q ] = s * a_kp + c * a_kq;
+                }
+
+                for (k = 0; k < n; k++)
+                {
+                    double a_pk = a[ p ][ k ];
+                    double a_qk = a[ q ][ k ];
+
+                    a[ p ][ k ] = c * a_pk - s * a_qk;
+                    a[ q ][ k ] = s * a_pk + c * a_qk;
+                }
+
+                a[ p ][ q ] = a[ q ][ p ] = 0.0;
+
+                for (k = 0; k < n; k++)
+                {
+                    double v_kp = v[ k ][ p ];
+                    double v_kq = v[ k ][ q ];
+
+                    v[ k ][ p ] = c * v_kp - s * v_kq;
+                    v[ k ][ q ] = s * v_kp + c * v_kq;
+                }
+            }
+        }
+    }
+
+    if (sweep == MAX_JACOBI_SWEEPS)
+    {
+        set_error("Jacobi diagonalization did not converge.");
+        result = ERROR;
+    }
+
+    order = (result == ERROR) ? NULL : INT_MALLOC(n);
+
+    if ((result != ERROR) && (order == NULL)) result = ERROR;
+
+    if (result != ERROR)
+    {
+        /* Sort from largest to smallest (insertion sort on indices). */
+        for (i = 0; i < n; i++)
+        {
+            int pos = i;
+
+            while ((pos > 0) && (a[ order[ pos - 1 ] ][ order[ pos - 1 ] ] < a[ i ][ i ]))
+            {
+                order[ pos ] = order[ pos - 1 ];
+                pos--;
+            }
+            order[ pos ] = i;
+        }
+
+        result = get_target_vector(D_vpp, n);
+    }
+
+    if ((result != ERROR) && (E_mpp != NULL))
+    {
+        result = get_target_matrix(E_mpp, n, n);
+    }
+
+    if (result != ERROR)
+    {
+        for (j = 0; j < n; j++)
+        {
+            (*D_vpp)->elements[ j ] = a[ order[ j ] ][ order[ j ] ];
+
+            if (E_mpp != NULL)
+            {
+                for (i = 0; i < n; i++)
+                {
+                    (*E_mpp)->elements[ i ][ j ] = v[ i ][ order[ j ] ];
+                }
+            }
+        }
+    }
+
+    kjb_free(order);
+    free_matrix(v_mp);
+    free_matrix(a_mp);
+
+    return result;
+}
+
+/*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\   */
+
+#ifdef __cplusplus
+}
+#endif
+
@@ -0,0 +1,74 @@
+/* $Id$ */
+
+/* =========================================================================== *
+|
+|  Copyright (c) 1994-2008 by Kobus Barnard (author).
+|
+|  Personal and educational use of this code is granted, provided that this
+|  header is kept intact, and that the authorship is not misrepresented, that
+|  its use is acknowledged in publications, and relevant papers are cited.
+|
+|  For other use contact the author (kobus AT cs DOT arizona DOT edu).
+|
+|  Please note that the code in this file has not necessarily been adequately
+|  tested. Naturally, there is no guarantee of performance, support, or fitness
+|  for any particular task. Nonetheless, I am interested in hearing about
+|  problems that you encounter.
+|
+* =========================================================================== */
+
+#ifndef N_FACTOR_INCLUDED
+#define N_FACTOR_INCLUDED
+
+
+#include "m/m_incl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#ifdef COMPILING_CPLUSPLUS_SOURCE
+namespace kjb_c {
+#endif
+#endif
+
+
+int set_native_factorization_options(const char* option, const char* value);
+
+int native_cholesky_factor(Matrix* mp);
+
+int native_lu_factor(Matrix* mp, int* perm);
+
+int do_native_lu_matrix_inversion(Matrix** target_mpp, const Matrix* input_mp);
+
+int solve_lower_triangular
+(
+    Matrix**      x_mpp,
+    const Matrix* l_mp,
+    const Matrix* b_mp
+);
+
+int solve_upper_triangular
+(
+    Matrix**      x_mpp,
+    const Matrix* u_mp,
+    const Matrix* b_mp
+);
+
+int do_native_qr_decompose(const Matrix* mp, Matrix** Q_mpp, Matrix** R_mpp);
+
+int do_native_diagonalize_symmetric
+(
+    const Matrix* mp,
+    Matrix**      E_mpp,
+    Vector**      D_vpp
+);
+
+
+#ifdef __cplusplus
+#ifdef COMPILING_CPLUSPLUS_SOURCE
+}
+#endif
+}
+#endif
+
+#endif
+
@@ -21,6 +21,7 @@
 #include "n/n_gen.h"      /*  Only safe if first #include in a ".c" file  */
 #include "n/n_invert.h"
 #include "n/n_svd.h"
+#include "n/n_factor.h"
 #include "wrap_lapack/wrap_lapack.h"
 
 /* For declared function pointers. Generally harmless. */
@@ -30,17 +31,22 @@ extern "C" {
 
 /* -------------------------------------------------------------------------- */
 
+static int initialize_matrix_inversion_method(void);
+
+/* -------------------------------------------------------------------------- */
+
 static Method_option fs_matrix_inversion_methods[ ] =
 {
     { "lapack",              "lapack", (int(*)())do_lapack_matrix_inversion},
     { "svd",                 "svd",    (int(*)())do_svd_matrix_inversion},
-    { "gaussian-elimination", "ge",    (int(*)())do_gaussian_elimination_matrix_inversion}
+    { "gaussian-elimination", "ge",    (int(*)())do_gaussian_elimination_matrix_inversion},
+    { "lu",                  "lu",     (int(*)())do_native_lu_matrix_inversion}
 };
 
 static const int fs_num_matrix_inversion_methods =
                                 sizeof(fs_matrix_inversion_methods) /
                                           sizeof(fs_matrix_inversion_methods[ 0 ]);
-static int         fs_matrix_inversion_method                  = 0;
+static int         fs_matrix_inversion_method                  = NEVER_SET;
 static const char* fs_matrix_inversion_method_option_short_str =
                                                        "matrix-inversion";
 static const char* fs_matrix_inversion_method_option_long_str =
@@ -66,6 +72,8 @@ int set_matrix_inversion_options(const char* option, const char* value)
     {
         if (value == NULL) return NO_ERROR;
 
+        ERE(initialize_matrix_inversion_method());
+
         ERE(parse_method_option(fs_matrix_inversion_methods,
                                 fs_num_matrix_inversion_methods,
                                 fs_matrix_inversion_method_option_long_str,
@@ -79,6 +87,29 @@ int set_matrix_inversion_options(const char* option, const char* value)
 
 /*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\   */
 
+static int initialize_matrix_inversion_method(void)
+{
+    if (fs_matrix_inversion_method == NEVER_SET)
+    {
+        const char* default_method = have_lapack() ? "lapack" : "lu";
+
+        if (parse_method_option(fs_matrix_inversion_methods,
+                                fs_num_matrix_inversion_methods,
+                                fs_matrix_inversion_method_option_long_str,
+                                "matrix inversion method", default_method,
+                                &fs_matrix_inversion_method)
+            == ERROR)
+        {
+            SET_CANT_HAPPEN_BUG();
+            return ERROR;
+        }
+    }
+
+    return NO_ERROR;
+}
+
+/*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\   */
+
 /*
  * =============================================================================
  *                              get_matrix_inverse
@@ -105,6 +136,11 @@ int set_matrix_inversion_options(const char* option, const char* value)
  * optimized routine for SVD, this advantage is not likely to be true in
  * practice.
  *
+ * The default is "lapack" if the LAPACK interface is available. Otherwise it is
+ * "lu", which uses a native blocked LU decomposition with partial pivoting
+ * (see do_native_lu_matrix_inversion()). That method uses more than one thread
+ * if the option "native-factorization-threads" is set.
+ *
  * Returns:
  *     NO_ERROR on success, and ERROR on failure, with an error message being
  *     set. This routine will fail if the matrix is close to singulare, or if
@@ -120,6 +156,7 @@ int get_matrix_inverse(Matrix** target_mpp, const Matrix* input_mp)
     int result;
 
 
+    ERE(initialize_matrix_inversion_method());
 
     if (    (fs_matrix_inversion_method < 0)
          || (fs_matrix_inversion_method >= fs_num_matrix_inversion_methods)
@@ -21,6 +21,7 @@
 
 #include "n/n_gen.h"      /*  Only safe if first #include in a ".c" file  */
 #include "wrap_lapack/wrap_lapack.h"
+#include "n/n_factor.h"
 #include "n/n_qr.h"
 
 #ifdef __cplusplus
@@ -29,6 +30,74 @@ extern "C" {
 
 /* -------------------------------------------------------------------------- */
 
+static int initialize_qr_method(void);
+
+/* -------------------------------------------------------------------------- */
+
+static Method_option fs_qr_methods[ ] =
+{
+    { "lapack", "lapack", (int(*)())lapack_qr_decompose },
+    { "native", "native", (int(*)())do_native_qr_decompose }
+};
+
+static const int fs_num_qr_methods =
+                                sizeof(fs_qr_methods) /
+                                          sizeof(fs_qr_methods[ 0 ]);
+
+static int         fs_qr_method                  = NEVER_SET;
+static const char* fs_qr_method_option_short_str = "qr";
+static const char* fs_qr_method_option_long_str  = "qr-method";
+
+/* -------------------------------------------------------------------------- */
+
+int set_qr_options(const char* option, const char* value)
+{
+    char lc_option[ 100 ];
+    int  result           = NOT_FOUND;
+
+
+    EXTENDED_LC_BUFF_CPY(lc_option, option);
+
+    if (    (lc_option[ 0 ] == '\0')
+          || match_pattern(lc_option, fs_qr_method_option_short_str)
+          || match_pattern(lc_option, fs_qr_method_option_long_str)
+       )
+    {
+        if (value == NULL) return NO_ERROR;
+
+        ERE(initialize_qr_method());
+
+        ERE(parse_method_option(fs_qr_methods, fs_num_qr_methods,
+                                fs_qr_method_option_long_str,
+                                "QR decomposition method", value, &fs_qr_method));
+        result = NO_ERROR;
+    }
+
+    return result;
+}
+
+/*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\   */
+
+static int initialize_qr_method(void)
+{
+    if (fs_qr_method == NEVER_SET)
+    {
+        const char* default_method = have_lapack() ? "lapack" : "native";
+
+        if (parse_method_option(fs_qr_methods, fs_num_qr_methods,
+                                fs_qr_method_option_long_str,
+                                "QR decomposition method", default_method, &fs_qr_method)
+            == ERROR)
+        {
+            SET_CANT_HAPPEN_BUG();
+            return ERROR;
+        }
+    }
+
+    return NO_ERROR;
+}
+
+/*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\   */
 
 /* =============================================================================
  *                             qr_decompose 
@@ -41,10 +110,10 @@ extern "C" {
  * m < n, R will actually be upper-trapezoidal; if m > n, rows m+1:n of R will
  * be zero.  
  *
- * Note:
- *     This routine requires that that the LAPACK library is available. If this
- *     file was compiled without the presence of that library, then this routine
- *     will return ERROR.
+ * The method used can be set with the option "qr-method". If it is "lapack"
+ * (the default if the LAPACK library is available), then LAPACK is used.
+ * Otherwise it is "native", which uses Householder reflections (see
+ * do_native_qr_decompose()).
  *
  * Returns:
  *     NO_ERROR on success, and ERROR on failure, with an appropriate error
@@ -86,9 +155,15 @@ int qr_decompose(const Matrix* mp, Matrix** Q_mpp, Matrix** R_mpp)
     {
         get_target_matrix(R_mpp, 0, 0);
     }
-   
 
-    return lapack_qr_decompose(mp, Q_mpp, R_mpp);
+    ERE(initialize_qr_method());
+
+    {
+        int (*qr_fn) (const Matrix*, Matrix**, Matrix**)
+            = (int (*) (const Matrix*, Matrix**, Matrix**)) fs_qr_methods[ fs_qr_method ].fn;
+
+        return qr_fn(mp, Q_mpp, R_mpp);
+    }
 }
 
 /*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\   */
@@ -114,11 +189,6 @@ int qr_decompose(const Matrix* mp, Matrix** Q_mpp, Matrix** R_mpp)
  *|   M = S * R' * S * S * Q'    algebra
  *|   M = (R_new) * (Q_new)      since (S * R' * S) is upper triangular
  *
- * Note:
- *     This routine requires that that the LAPACK library is available. If this
- *     file was compiled without the presence of that library, then this routine
- *     will return ERROR.
- *
  * Returns:
  *     NO_ERROR on success, and ERROR on failure, with an appropriate error
  *     message being set.
@@ -31,6 +31,8 @@ namespace kjb_c {
 #endif
 #endif
 
+int set_qr_options(const char* option, const char* value);
+
 int qr_decompose(const Matrix* mp, Matrix** Q_mpp, Matrix** R_mpp);
 int rq_decompose(const Matrix* mp, Matrix** R_mpp, Matrix** Q_mpp);
 
@@ -27,6 +27,9 @@
 #include "n/n_set.h"
 #include "n/n_svd.h"
 #include "n/n_cholesky.h"
+#include "n/n_qr.h"
+#include "n/n_diagonalize.h"
+#include "n/n_factor.h"
 
 
 #ifdef __cplusplus
@@ -58,6 +61,9 @@ int kjb_n_set(const char* option, const char* value)
                                         set_matrix_inversion_options,
                                         set_least_squares_options,
                                         set_cholesky_options,
+                                        set_qr_options,
+                                        set_diagonalize_symmetric_options,
+                                        set_native_factorization_options,
                                         NULL
                                     };
 
@@ -0,0 +1,176 @@
+/* $Id$ */
+
+/*
+ * This program tests the native (non-LAPACK) factorizations in n_factor.c,
+ * with one and with several threads. Sizes are chosen to cross the block
+ * boundaries of the blocked routines.
+*/
+
+#include <m/m_incl.h>
+#include <n/n_cholesky.h>
+#include <n/n_invert.h>
+#include <n/n_qr.h>
+#include <n/n_diagonalize.h>
+#include <n/n_factor.h>
+
+#define NUM_SIZES   6
+
+static const int    sizes[ NUM_SIZES ] = { 1, 7, 64, 65, 130, 200 };
+static const double TOLERANCE          = 1e-8;
+
+static int status = EXIT_SUCCESS;
+
+static void check(double diff, const char* what, int n, const char* threads)
+{
+    if (diff > TOLERANCE)
+    {
+        p_stderr("Problem with native %s (n = %d, threads = %s).\n",
+                 what, n, threads);
+        p_stderr(" %e != 0.0.\n", diff);
+        status = EXIT_BUG;
+    }
+}
+
+int main(void)
+{
+    static const char* num_threads[ ] = { "1", "3" };
+    Matrix* A_mp = NULL;
+    Matrix* S_mp = NULL;
+    Matrix* B_mp = NULL;
+    Matrix* X_mp = NULL;
+    Matrix* L_mp = NULL;
+    Matrix* Q_mp = NULL;
+    Matrix* R_mp = NULL;
+    Matrix* E_mp = NULL;
+    Matrix* I_mp = NULL;
+    Matrix* T_mp = NULL;
+    Matrix* T2_mp = NULL;
+    Vector* D_vp = NULL;
+    int     t, s, i, j, n;
+
+
+    kjb_init();
+
+    EPETE(set_matrix_inversion_options("matrix-inversion-method", "lu"));
+    EPETE(set_cholesky_options("cholesky-method", "native"));
+    EPETE(set_qr_options("qr-method", "native"));
+    EPETE(set_diagonalize_symmetric_options("diagonalize-symmetric-method",
+                                            "native"));
+
+    for (t = 0; t < 2; t++)
+    {
+        EPETE(set_native_factorization_options("native-factorization-threads",
+                                               num_threads[ t ]));
+
+        for (s = 0; s < NUM_SIZES; s++)
+        {
+            n = sizes[ s ];
+
+            /* A random matrix, and a positive definite one. */
+            EPETE(get_random_matrix(&A_mp, n, n));
+            EPETE(multiply_by_transpose(&S_mp, A_mp, A_mp));
+            EPETE(get_identity_matrix(&I_mp, n));
+            EPETE(ow_add_matrices(S_mp, I_mp));
+
+            /* Cholesky: L L' = S, with L lower triangular. */
+            EPETE(cholesky_decomposition(&L_mp, S_mp));
+            EPETE(multiply_by_transpose(&T_mp, L_mp, L_mp));
+            check(max_abs_matrix_difference(T_mp, S_mp) / n,
+                  "Cholesky", n, num_threads[ t ]);
+
+            for (i = 0; i < n; i++)
+            {
+                for (j = i + 1; j < n; j++)
+                {
+                    check(ABS_OF(L_mp->elements[ i ][ j ]),
+                          "Cholesky (upper triangle)", n, num_threads[ t ]);
+                }
+            }
+
+            /* Triangular solves with many right hand sides. */
+            EPETE(get_random_matrix(&B_mp, n, 300));
+            EPETE(solve_lower_triangular(&X_mp, L_mp, B_mp));
+            EPETE(multiply_matrices(&T_mp, L_mp, X_mp));
+            check(max_abs_matrix_difference(T_mp, B_mp),
+                  "lower triangular solve", n, num_threads[ t ]);
+
+            EPETE(get_matrix_transpose(&T2_mp, L_mp));
+            EPETE(solve_upper_triangular(&X_mp, T2_mp, B_mp));
+            EPETE(multiply_matrices(&T_mp, T2_mp, X_mp));
+            check(max_abs_matrix_difference(T_mp, B_mp),
+                  "upper triangular solve", n, num_threads[ t ]);
+
+            /* LU inversion of a general matrix. */
+            EPETE(get_matrix_inverse(&X_mp, A_mp));
+            EPETE(multiply_matrices(&T_mp, A_mp, X_mp));
+            check(max_abs_matrix_difference(T_mp, I_mp) / n,
+                  "LU inversion", n, num_threads[ t ]);
+
+            /* QR of a non-square matrix. */
+            EPETE(get_random_matrix(&B_mp, n + 3, n));
+            EPETE(qr_decompose(B_mp, &Q_mp, &R_mp));
+            EPETE(multiply_matrices(&T_mp, Q_mp, R_mp));
+            check(max_abs_matrix_difference(T_mp, B_mp),
+                  "QR (recomposition)", n, num_threads[ t ]);
+            EPETE(multiply_by_own_transpose(&T_mp, Q_mp));
+            EPETE(get_identity_matrix(&T2_mp, n + 3));
+            check(max_abs_matrix_difference(T_mp, T2_mp),
+                  "QR (orthonormality)", n, num_threads[ t ]);
+
+            for (i = 0; i < n + 3; i++)
+            {
+                for (j = 0; j < MIN_OF(i, n); j++)
+                {
+                    check(ABS_OF(R_mp->elements[ i ][ j ]),
+                          "QR (lower triangle)", n, num_threads[ t ]);
+                }
+            }
+
+            /* Symmetric eigenproblem: S E = E D, sorted largest first. */
+            if (n <= 65)
+            {
+                EPETE(diagonalize_symmetric(S_mp, &E_mp, &D_vp));
+                EPETE(multiply_matrices(&T_mp, S_mp, E_mp));
+                EPETE(multiply_matrix_by_row_vector_ew(&T2_mp, E_mp, D_vp));
+                check(max_abs_matrix_difference(T_mp, T2_mp)
+                          / D_vp->elements[ 0 ],
+                      "diagonalization", n, num_threads[ t ]);
+
+                for (i = 1; i < n; i++)
+                {
+                    if (D_vp->elements[ i ] > D_vp->elements[ i - 1 ])
+                    {
+                        check(1.0, "diagonalization (order)", n,
+                              num_threads[ t ]);
+                    }
+                }
+            }
+        }
+    }
+
+    /* A singular matrix must be reported as such. */
+    EPETE(get_zero_matrix(&A_mp, 5, 5));
+    if (get_matrix_inverse(&X_mp, A_mp) != ERROR)
+    {
+        p_stderr("Native LU inversion of a singular matrix succeeded.\n");
+        status = EXIT_BUG;
+    }
+
+    free_vector(D_vp);
+    free_matrix(T2_mp);
+    free_matrix(T_mp);
+    free_matrix(I_mp);
+    free_matrix(E_mp);
+    free_matrix(R_mp);
+    free_matrix(Q_mp);
+    free_matrix(L_mp);
+    free_matrix(X_mp);
+    free_matrix(B_mp);
+    free_matrix(S_mp);
+    free_matrix(A_mp);
+
+    kjb_cleanup();
+
+    return status;
+}
+
@@ -20,6 +20,8 @@
 #include <n_cpp/n_solve.h>
 #include <m_cpp/m_matrix.h>
 #include <m_cpp/m_vector.h>
+#include <n/n_factor.h>
+#include <l_cpp/l_util.h>
 
 namespace kjb {
 
@@ -59,5 +61,31 @@ Vector back_substitution(const Matrix& U, const Vector& b)
     return x;
 }
 
+/* \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ */
+
+Matrix forward_substitution(const Matrix& L, const Matrix& B)
+{
+    Matrix X;
+    ETX(kjb_c::solve_lower_triangular(
+            &X.get_underlying_representation_with_guilt(),
+            L.get_c_matrix(),
+            B.get_c_matrix()));
+
+    return X;
+}
+
+/* \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ */
+
+Matrix back_substitution(const Matrix& U, const Matrix& B)
+{
+    Matrix X;
+    ETX(kjb_c::solve_upper_triangular(
+            &X.get_underlying_representation_with_guilt(),
+            U.get_c_matrix(),
+            B.get_c_matrix()));
+
+    return X;
+}
+
 } // namespace kjb
 
@@ -42,6 +42,31 @@ Vector forward_substitution(const Matrix& L, const Vector& b);
  */
 Vector back_substitution(const Matrix& U, const Vector& b);
 
+/**
+ * @brief   Perform forward substitution to solve LX = B, where L is a
+ *          lower triangular matrix and B is a matrix of right hand sides.
+ *
+ * The columns of B are solved together in blocks, split over threads if the
+ * option "native-factorization-threads" is set (see
+ * kjb_c::solve_lower_triangular()). Elements of L above the diagonal are not
+ * used.
+ *
+ * @throws  KJB_error if L is not square, does not match B, or has a zero on
+ *          its diagonal.
+ */
+Matrix forward_substitution(const Matrix& L, const Matrix& B);
+
+/**
+ * @brief   Perform back substitution to solve UX = B, where U is an
+ *          upper triangular matrix and B is a matrix of right hand sides.
+ *
+ * Elements of U below the diagonal are not used.
+ *
+ * @throws  KJB_error if U is not square, does not match B, or has a zero on
+ *          its diagonal.
+ */
+Matrix back_substitution(const Matrix& U, const Matrix& B);
+
 } // namespace kjb
 
 #endif  /*N_SOLVE_H */
@@ -28,8 +28,6 @@
 
 #include <vector>
 #include <algorithm>
-#include <boost/bind.hpp>
-#include <boost/ref.hpp>
 
 using namespace kjb;
 using namespace kjb::pt;
@@ -53,11 +51,15 @@ Body_2d kjb::pt::project_cstate
     cylinder_points(cs, height, width, girth, fpts, bpts, botc, topc, bodc);
 
     // project points
-    std::transform(fpts.begin(), fpts.end(), fpts.begin(),
-                   boost::bind(project_point, boost::cref(cam), _1));
-
-    std::transform(bpts.begin(), bpts.end(), bpts.begin(),
-                   boost::bind(project_point, boost::cref(cam), _1));
+    for(size_t i = 0; i < fpts.size(); i++)
+    {
+        fpts[i] = project_point(cam, fpts[i]);
+    }
+
+    for(size_t i = 0; i < bpts.size(); i++)
+    {
+        bpts[i] = project_point(cam, bpts[i]);
+    }
 
     // project top and bottom of cylinder
     botc = project_point(cam, botc);
@@ -35,6 +35,7 @@
 #include <string>
 #include <cmath>
 #include <utility>
+#include <vector>
 #include <boost/foreach.hpp>
 
 using namespace kjb;
@@ -57,12 +58,14 @@ double Box_likelihood::at_noise(const Scene& scene) const
 {
     const Ascn& w = scene.association;
 
-    Ascn::Available_data f_alarms = w.get_available_data();
-    size_t fa_sz = f_alarms.size();
+    // the association indexes its used boxes, so no sets are built here
+    std::vector<const Detection_box*> f_alarms;
+    size_t T = w.get_data().size();
     double lh = 0.0;
-    for(size_t t = 0; t < fa_sz; t++)
+    for(size_t t = 1; t <= T; t++)
     {
-        BOOST_FOREACH(const Detection_box* dbox_p, f_alarms[t])
+        w.get_available_data_at_time(t, f_alarms);
+        BOOST_FOREACH(const Detection_box* dbox_p, f_alarms)
         {
             lh += single_noise(*dbox_p);
         }
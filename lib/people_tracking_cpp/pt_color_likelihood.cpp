@@ -42,6 +42,58 @@
 using namespace kjb;
 using namespace kjb::pt;
 
+namespace {
+
+// Color histograms of cells are NUM_CHROMA_BINS x NUM_CHROMA_BINS histograms
+// of the (r, g) chromaticity, each in CHROMA_RANGE.
+const size_t NUM_CHROMA_BINS = 8;
+const std::pair<double, double> CHROMA_RANGE(0.0, 1.0);
+
+/**
+ * @brief   Bin of a chromaticity value, as found by Histogram_2d with
+ *          NUM_CHROMA_BINS bins over CHROMA_RANGE. Like Histogram_2d, this
+ *          accumulates the lower bin edges from the start of the range and
+ *          returns the last bin whose edge is at most v, so values on (or
+ *          within rounding of) an edge go to the same bin. Undefined values
+ *          (black pixels) go to the last bin.
+ */
+inline int chroma_bin(double v)
+{
+    const double bin_size = (CHROMA_RANGE.second - CHROMA_RANGE.first)
+                                / (NUM_CHROMA_BINS - 1);
+    if(!(v >= CHROMA_RANGE.first))
+    {
+        return v < CHROMA_RANGE.first ? 0 : NUM_CHROMA_BINS - 1;
+    }
+
+    size_t bin = 0;
+    double edge = CHROMA_RANGE.first + bin_size;
+    while(bin + 1 < NUM_CHROMA_BINS && edge <= v)
+    {
+        bin++;
+        edge += bin_size;
+    }
+
+    return bin;
+}
+
+/** @brief  Pixel range [first, last) of a box side, as get_foreground() does. */
+inline void pixel_range
+(
+    double lo,
+    double hi,
+    size_t size,
+    size_t& first,
+    size_t& last
+)
+{
+    first = std::max(0.0, lo);
+    last = std::min((double)size, std::ceil(std::max(0.0, hi)));
+    if(last < first) last = first;
+}
+
+} // anonymous namespace
+
 void Color_likelihood::read_frames(const std::vector<std::string>& frame_fps)
 {
     size_t num_frames = frame_fps.size();
@@ -58,10 +110,39 @@ void Color_likelihood::read_frames(const std::vector<std::string>& frame_fps)
 
     m_r_pixels.resize(num_frames);
     m_g_pixels.resize(num_frames);
+    if(m_integral)
+    {
+        m_fg_hists.assign(num_frames, boost::shared_ptr<Integral_histogram>());
+    }
+
     // Load in the image frames 
     for(size_t i = 0; i < num_frames; i = i + m_frame_ssz)
     {
         Image image(frame_fps[i]);
+
+        if(m_integral)
+        {
+            // only the histograms are needed
+            Int_matrix bins(new_nrows, new_ncols);
+            for(size_t srow = 0; srow < new_nrows; srow++)
+            {
+                for(size_t scol = 0; scol < new_ncols; scol++)
+                {
+                    size_t row = srow * m_pixel_ssz;
+                    size_t col = scol * m_pixel_ssz;
+                    double red = float(image(row, col, Image::RED));
+                    double green = float(image(row, col, Image::GREEN));
+                    double blue = float(image(row, col, Image::BLUE));
+                    double s = red + green + blue;
+                    bins(srow, scol) = chroma_bin(red / s) * NUM_CHROMA_BINS
+                                        + chroma_bin(green / s);
+                }
+            }
+            m_fg_hists[i].reset(new Integral_histogram(
+                            bins, NUM_CHROMA_BINS * NUM_CHROMA_BINS));
+            continue;
+        }
+
         boost::shared_array<float> r_buffer(new float[new_sz]);
         boost::shared_array<float> g_buffer(new float[new_sz]);
 
@@ -89,10 +170,33 @@ void Color_likelihood::read_frames(const std::vector<std::string>& frame_fps)
 
 /* \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ */
 
+void Color_likelihood::update_bg_histogram()
+{
+    m_bg_hist.reset();
+    if(!m_integral || m_bg_r_p == NULL || m_bg_g_p == NULL) return;
+
+    IFT(m_bg_r_p->get_num_rows() == m_bg_g_p->get_num_rows()
+            && m_bg_r_p->get_num_cols() == m_bg_g_p->get_num_cols(),
+        Dimension_mismatch, "Background matrices have different sizes.");
+
+    Int_matrix bins(m_bg_r_p->get_num_rows(), m_bg_r_p->get_num_cols());
+    for(int row = 0; row < bins.get_num_rows(); row++)
+    {
+        for(int col = 0; col < bins.get_num_cols(); col++)
+        {
+            bins(row, col) = chroma_bin((*m_bg_r_p)(row, col)) * NUM_CHROMA_BINS
+                                + chroma_bin((*m_bg_g_p)(row, col));
+        }
+    }
+    m_bg_hist.reset(new Integral_histogram(
+                            bins, NUM_CHROMA_BINS * NUM_CHROMA_BINS));
+}
+
+/* \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ */
+
 double Color_likelihood::operator()(const Scene& scene)const
 {
-    IFT(m_bg_r_p != NULL && m_bg_g_p != NULL,
-        Runtime_error, "Background matrix not set.");
+    check_background();
 
     double ll = 0.0;
     BOOST_FOREACH(const Target& tg, scene.association)
@@ -165,9 +269,9 @@ double Color_likelihood::at_box
     const double xn_min = next_box.get_left() + xn_delta / 2.0;
     const double yn_min = next_box.get_bottom() + yn_delta / 2.0;
 
-    const size_t num_bins = 8;
-    std::pair<double, double> range_1 = std::make_pair(0.0, 1.0);
-    std::pair<double, double> range_2 = std::make_pair(0.0, 1.0);
+    const size_t num_bins = NUM_CHROMA_BINS;
+    const std::pair<double, double>& range_1 = CHROMA_RANGE;
+    const std::pair<double, double>& range_2 = CHROMA_RANGE;
 
     std::vector<Vector>::const_iterator cur_vis_it = 
                                             cur_vis_cells.begin();
@@ -269,6 +373,11 @@ std::vector<Vector> Color_likelihood::get_foreground
 ) const
 {
     IFT(frame <= m_r_pixels.size(), Illegal_argument, "frame out of bound"); 
+
+    // integral mode keeps only the histograms, and skipped frames are not read
+    IFT(m_r_pixels[frame - 1] && m_g_pixels[frame - 1], Illegal_argument,
+        "No pixels kept for frame; with integral histograms, foreground "
+        "histograms are only available for 8 bins over [0, 1].");
     std::vector<Vector> values;
     //const Vector& center = box.get_center();
 
@@ -353,6 +462,63 @@ Matrix Color_likelihood::get_norm_hist_as_matrix
     Bbox vis_cell(loc, x_delta, y_delta);
     unstandardize(vis_cell, m_width, m_height);
 
+    // the integral histograms are binned for these settings only
+    if(m_integral && num_bins == NUM_CHROMA_BINS
+        && range_1 == CHROMA_RANGE && range_2 == CHROMA_RANGE)
+    {
+        size_t left_px, right_px, bottom_py, top_py;
+        pixel_range(vis_cell.get_left(), vis_cell.get_right(), m_width,
+                    left_px, right_px);
+        pixel_range(vis_cell.get_bottom(), vis_cell.get_top(), m_height,
+                    bottom_py, top_py);
+
+        const Integral_histogram* ihist;
+        if(is_foreground)
+        {
+            IFT(frame <= m_fg_hists.size() && m_fg_hists[frame - 1],
+                Illegal_argument, "frame out of bound");
+            ihist = m_fg_hists[frame - 1].get();
+
+            // the same sampled pixels as get_foreground()
+            const size_t s = m_pixel_ssz;
+            right_px = left_px / s + (right_px - left_px + s - 1) / s;
+            top_py = bottom_py / s + (top_py - bottom_py + s - 1) / s;
+            left_px /= s;
+            bottom_py /= s;
+        }
+        else
+        {
+            IFT(m_bg_hist, Runtime_error, "Background matrix not set.");
+            ihist = m_bg_hist.get();
+        }
+
+        right_px = std::min(right_px, (size_t)ihist->get_num_cols());
+        top_py = std::min(top_py, (size_t)ihist->get_num_rows());
+        left_px = std::min(left_px, right_px);
+        bottom_py = std::min(bottom_py, top_py);
+
+        std::vector<unsigned int> counts(ihist->get_num_bins());
+        ihist->get_counts(&counts[0], left_px, bottom_py, right_px, top_py);
+
+        Matrix M(num_bins, num_bins);
+        double total = 0.0;
+        for(size_t i = 0; i < num_bins; i++)
+        {
+            for(size_t j = 0; j < num_bins; j++)
+            {
+                M(i, j) = counts[i * num_bins + j];
+                total += M(i, j);
+            }
+        }
+
+        if(total > 1)
+        {
+            M = (M / total) * filter;
+        }
+
+        return M;
+    }
+
     // get the pixels in range
     std::vector<Vector> pixels;
     if(is_foreground)
@@ -23,6 +23,7 @@
 #include <people_tracking_cpp/pt_scene.h>
 #include <people_tracking_cpp/pt_visibility.h>
 #include <i_cpp/i_filter.h>
+#include <i_cpp/i_integral_histogram.h>
 #include <m_cpp/m_vector.h>
 #include <m_cpp/m_matrix.h>
 #include <detector_cpp/d_bbox.h>
@@ -30,6 +31,7 @@
 #include <string>
 #include <utility>
 #include <boost/shared_array.hpp>
+#include <boost/shared_ptr.hpp>
 
 namespace kjb {
 namespace pt {
@@ -42,15 +44,24 @@ namespace pt {
 class Color_likelihood
 {
 public:
-    // Ctor
+    /**
+     * @brief   Ctor.
+     *
+     * If integral_histograms is true, read_frames() builds an integral
+     * histogram of each frame (and of the background), so that the cell
+     * histograms take a time independent of the cell size. This uses
+     * 64 counts per (sampled) pixel and frame, instead of two floats.
+     */
     Color_likelihood
     (
         size_t pixel_sampling = 1,
-        size_t frame_sampling = 1
+        size_t frame_sampling = 1,
+        bool integral_histograms = false
     ) : m_bg_r_p(NULL),
         m_bg_g_p(NULL),
         m_pixel_ssz(pixel_sampling),
-        m_frame_ssz(frame_sampling)
+        m_frame_ssz(frame_sampling),
+        m_integral(integral_histograms)
     {}
 
     /** @brief  Evaluate this likelihood at the given scene. */
@@ -73,25 +84,31 @@ public:
     void set_bg_r_matrix(const Matrix* bg_r_p)
     {
         m_bg_r_p = bg_r_p;
+        update_bg_histogram();
     }
 
     void set_bg_g_matrix(const Matrix* bg_g_p)
     {
         m_bg_g_p = bg_g_p;
+        update_bg_histogram();
     }
 
-private:
-    std::vector<Vector> get_foreground
-    (
-        size_t frame,
-        const Bbox& box
-    ) const;
-
-    std::vector<Vector> get_background
-    (
-        const Bbox& box
-    ) const;
+    /** @brief  Throws if the background matrices have not been set. */
+    void check_background() const
+    {
+        IFT(m_bg_r_p != NULL && m_bg_g_p != NULL,
+            Runtime_error, "Background matrix not set.");
+    }
 
+    /**
+     * @brief   Normalized and filtered (r, g) histogram of the cell centered
+     *          at loc, in the given frame or in the background.
+     *
+     * The integral histograms are used for 8 bins over [0, 1] in both
+     * dimensions; they give the same histogram as Histogram_2d does. As
+     * the frame pixels are not kept then, foreground histograms with other
+     * bins or ranges throw Illegal_argument.
+     */
     Matrix get_norm_hist_as_matrix
     (
         const Vector& loc,
@@ -105,6 +122,21 @@ private:
         bool is_foreground
     ) const;
 
+private:
+    /** @brief  Builds the background integral histogram, if needed. */
+    void update_bg_histogram();
+
+    std::vector<Vector> get_foreground
+    (
+        size_t frame,
+        const Bbox& box
+    ) const;
+
+    std::vector<Vector> get_background
+    (
+        const Bbox& box
+    ) const;
+
 private:
     const Matrix* m_bg_r_p;
     const Matrix* m_bg_g_p;
@@ -114,6 +146,9 @@ private:
     size_t m_frame_ssz;
     size_t m_width;
     size_t m_height;
+    bool m_integral;
+    std::vector<boost::shared_ptr<Integral_histogram> > m_fg_hists;
+    boost::shared_ptr<Integral_histogram> m_bg_hist;
 
 };
 
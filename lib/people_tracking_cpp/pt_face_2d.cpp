@@ -28,8 +28,6 @@
 
 #include <vector>
 #include <algorithm>
-#include <boost/bind.hpp>
-#include <boost/ref.hpp>
 
 using namespace kjb;
 using namespace kjb::pt;
@@ -47,15 +45,19 @@ Face_2d kjb::pt::project_cstate_face
 {
     // face box
     Vector_vec hpts = head_points(cs, height, width, girth);
-    std::transform(hpts.begin(), hpts.end(), hpts.begin(),
-                   boost::bind(project_point, boost::cref(cam), _1));
+    for(size_t i = 0; i < hpts.size(); i++)
+    {
+        hpts[i] = project_point(cam, hpts[i]);
+    }
 
     Bbox head_box = compute_bounding_box(hpts.begin(), hpts.end());
 
     // face features
     Vector_vec ffts = face_features(cs, height, width, girth);
-    std::transform(ffts.begin(), ffts.end(), ffts.begin(),
-                   boost::bind(project_point, boost::cref(cam), _1));
+    for(size_t i = 0; i < ffts.size(); i++)
+    {
+        ffts[i] = project_point(cam, ffts[i]);
+    }
 
     Vector& leye = ffts[0];
     Vector& reye = ffts[1];
@@ -123,8 +123,8 @@ double Position_prior::at_endpoints(const Scene& scene) const
         const Vector3& ex = target.trajectory()[ef - 1]->value.position;
 
         // start and end 2D points
-        Vector su = project_point(cam, Vector(sx.begin(), sx.end()));
-        Vector eu = project_point(cam, Vector(ex.begin(), ex.end()));
+        Vector2 su = project_point(cam, sx);
+        Vector2 eu = project_point(cam, ex);
 
         if(su[0] > -imw/2 + th && su[0] < imw/2 - th
                 && su[1] > -imh/2 + th && su[1] < imh/2 - th)
@@ -274,7 +274,7 @@ double Position_prior::local_endpoints
     if(t != sf && t != ef) return 0.0;
 
     const Vector3& x = target.trajectory()[t - 1]->value.position;
-    Vector u = project_point(cam, Vector(x.begin(), x.end()));
+    Vector2 u = project_point(cam, x);
 
     if(u[0] > -imw/2 + th && u[0] < imw/2 - th
             && u[1] > -imh/2 + th && u[1] < imh/2 - th)
@@ -28,6 +28,7 @@
 #include "l/l_sys_lib.h"
 
 #include <iostream>
+#include <vector>
 #include <boost/foreach.hpp>
 
 using namespace kjb;
@@ -37,6 +38,13 @@ void Scene_adapter::set(Scene* s, const Vector& x) const
 {
     Scene& scene = *s;
 
+    // only the frames with changed targets need their visibilities updated
+    std::vector<bool> changed_frames;
+    if(!scene.association.empty())
+    {
+        changed_frames.resize(scene.association.get_data().size(), false);
+    }
+
     size_t i = 0;
     BOOST_FOREACH(const Target& tg, scene.association)
     {
@@ -46,6 +54,7 @@ void Scene_adapter::set(Scene* s, const Vector& x) const
         size_t ef = tg.changed_end();
         for(size_t t = sf; t <= ef; t++)
         {
+            changed_frames[t - 1] = true;
             tg.trajectory()[t - 1]->value.position[0] = x[i++];
             tg.trajectory()[t - 1]->value.position[2] = x[i++];
             if(m_infer_head)
@@ -63,7 +72,13 @@ void Scene_adapter::set(Scene* s, const Vector& x) const
         }
     }
 
-    update_visibilities(scene, m_infer_head);
+    for(size_t t = 0; t < changed_frames.size(); t++)
+    {
+        if(changed_frames[t])
+        {
+            update_visibilities(scene, t + 1, m_infer_head);
+        }
+    }
 }
 
 /* \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ */
@@ -85,7 +85,7 @@ void Scene_info::set(const Scene_posterior& post, const Scene& sc, bool cmlh)
     // counts
     dim = dims(sc, false, ih);
     num_aboxes = length(sc.association);
-    num_nboxes = length(sc.association.get_available_data());
+    num_nboxes = sc.association.count_available_data();
     num_afmarks = fm_lh.num_assigned_facemarks(sc);
     num_nfmarks = fm_lh.num_facemarks() - num_afmarks;
 }
@@ -220,7 +220,7 @@ bool Scene_info::is_valid(const Scene& sc, bool ih) const
     // counts
     if(dim != dims(sc, false, ih)) return false;
     if(num_aboxes != length(sc.association)) return false;
-    if(num_nboxes != length(sc.association.get_available_data())) return false;
+    if(num_nboxes != sc.association.count_available_data()) return false;
     //if(num_afmarks != fm_lh.num_assigned_facemarks(sc)) return false;
     //if(num_nfmarks != fm_lh.num_facemarks() - num_afmarks) return false;
 
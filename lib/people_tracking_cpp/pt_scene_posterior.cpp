@@ -47,17 +47,37 @@
 #include <boost/bind.hpp>
 #include <boost/ref.hpp>
 #include <boost/foreach.hpp>
+#include <boost/thread.hpp>
 
 using namespace kjb;
 using namespace kjb::pt;
 
 double Scene_posterior::operator()(const Scene& scene) const
 {
-    double bl = use_box_lh_ ? box_likelihood_(scene) : 0.0;
-    double ml = use_fm_lh_ && m_infer_head ? fm_likelihood_(scene) : 0.0;
-    double ol = use_of_lh_ ? of_likelihood_(scene) : 0.0;
-    double fl = use_ff_lh_ && m_infer_head ? ff_likelihood_(scene) : 0.0;
-    double cl = use_color_lh_ ? color_likelihood_(scene) : 0.0;
+    size_t nt = num_threads_;
+    if(nt == 0)
+    {
+        nt = boost::thread::hardware_concurrency();
+    }
+
+    double bl = 0.0;
+    double ml = 0.0;
+    double ol = 0.0;
+    double fl = 0.0;
+    double cl = 0.0;
+    if(nt > 1 && scene.association.size() > 1)
+    {
+        parallel_likelihoods(scene, nt, bl, ml, ol, fl, cl);
+    }
+    else
+    {
+        bl = use_box_lh_ ? box_likelihood_(scene) : 0.0;
+        ml = use_fm_lh_ && m_infer_head ? fm_likelihood_(scene) : 0.0;
+        ol = use_of_lh_ ? of_likelihood_(scene) : 0.0;
+        fl = use_ff_lh_ && m_infer_head ? ff_likelihood_(scene) : 0.0;
+        cl = use_color_lh_ ? color_likelihood_(scene) : 0.0;
+    }
+
     double pp = use_pos_prior_ ? pos_prior_(scene) : 0.0;
     double rp = use_dir_prior_ && m_infer_head ? dir_prior_(scene) : 0.0;
     double fp = use_fdir_prior_ && m_infer_head  ? fdir_prior_(scene) : 0.0;
@@ -68,6 +88,159 @@ double Scene_posterior::operator()(const Scene& scene) const
 
 /* \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ */
 
+void Scene_posterior::parallel_likelihoods
+(
+    const Scene& scene,
+    size_t nthreads,
+    double& bl,
+    double& ml,
+    double& ol,
+    double& fl,
+    double& cl
+) const
+{
+    bool use[NUM_LH];
+    use[BOX_LH] = use_box_lh_;
+    use[FM_LH] = use_fm_lh_ && m_infer_head;
+    use[OF_LH] = use_of_lh_;
+    use[FF_LH] = use_ff_lh_ && m_infer_head;
+    use[COLOR_LH] = use_color_lh_;
+
+    if(use[COLOR_LH])
+    {
+        color_likelihood_.check_background();
+    }
+
+    std::vector<const Target*> targets;
+    targets.reserve(scene.association.size());
+    BOOST_FOREACH(const Target& tg, scene.association)
+    {
+        targets.push_back(&tg);
+    }
+
+    // one job per (target, term); values[i*NUM_LH + j] is term j of target i.
+    // The jobs are in the order the serial code evaluates them: each term for
+    // all targets, then the next term.
+    std::vector<size_t> jobs;
+    jobs.reserve(targets.size() * NUM_LH);
+    for(size_t j = 0; j < NUM_LH; j++)
+    {
+        if(!use[j]) continue;
+
+        for(size_t i = 0; i < targets.size(); i++)
+        {
+            jobs.push_back(i*NUM_LH + j);
+        }
+    }
+
+    std::vector<double> values(targets.size() * NUM_LH, 0.0);
+    size_t next = 0;
+    bool failed = false;
+    boost::mutex next_mutex;
+
+    if(nthreads > jobs.size())
+    {
+        nthreads = jobs.size();
+    }
+
+    boost::thread_group thrds;
+    for(size_t t = 0; t < nthreads; t++)
+    {
+        thrds.create_thread(boost::bind(&Scene_posterior::likelihood_worker,
+                                        this, boost::cref(targets),
+                                        boost::cref(jobs),
+                                        boost::ref(values),
+                                        &next, &failed, &next_mutex));
+    }
+    thrds.join_all();
+
+    if(failed)
+    {
+        // redo the work here, in job order, so that the first error is
+        // thrown as without threads
+        BOOST_FOREACH(size_t job, jobs)
+        {
+            values[job] = target_likelihood(
+                            static_cast<Likelihood_term>(job % NUM_LH),
+                            *targets[job / NUM_LH]);
+        }
+    }
+
+    // add in target order, as the likelihoods themselves do
+    double* sums[NUM_LH] = { &bl, &ml, &ol, &fl, &cl };
+    for(size_t j = 0; j < NUM_LH; j++)
+    {
+        *sums[j] = 0.0;
+        if(!use[j]) continue;
+
+        for(size_t i = 0; i < targets.size(); i++)
+        {
+            *sums[j] += values[i*NUM_LH + j];
+        }
+    }
+}
+
+/* \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ */
+
+double Scene_posterior::target_likelihood
+(
+    Likelihood_term term,
+    const Target& target
+) const
+{
+    switch(term)
+    {
+        case BOX_LH: return box_likelihood_.at_target(target);
+        case FM_LH: return fm_likelihood_.at_trajectory(target);
+        case OF_LH: return of_likelihood_.at_trajectory(target);
+        case FF_LH: return ff_likelihood_.at_trajectory(target);
+        case COLOR_LH: return color_likelihood_.at_trajectory(target);
+        default: KJB_THROW_2(Illegal_argument, "Unknown likelihood term.");
+    }
+}
+
+/* \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ */
+
+void Scene_posterior::likelihood_worker
+(
+    const std::vector<const Target*>& targets,
+    const std::vector<size_t>& jobs,
+    std::vector<double>& values,
+    size_t* next,
+    bool* failed,
+    boost::mutex* next_mutex
+) const
+{
+    while(true)
+    {
+        size_t k;
+        {
+            boost::mutex::scoped_lock lock(*next_mutex);
+            if(*failed || *next >= jobs.size())
+            {
+                return;
+            }
+            k = (*next)++;
+        }
+
+        size_t job = jobs[k];
+        try
+        {
+            values[job] = target_likelihood(
+                            static_cast<Likelihood_term>(job % NUM_LH),
+                            *targets[job / NUM_LH]);
+        }
+        catch(...)
+        {
+            boost::mutex::scoped_lock lock(*next_mutex);
+            *failed = true;
+            return;
+        }
+    }
+}
+
+/* \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ */
+
 double Scene_posterior::local
 (
     const Target& target1,
@@ -38,6 +38,8 @@
 #include <prob_cpp/prob_distribution.h>
 #include <detector_cpp/d_bbox.h>
 #include <iostream>
+#include <vector>
+#include <boost/thread/mutex.hpp>
 
 namespace kjb {
 namespace pt {
@@ -91,7 +93,8 @@ public:
         use_fdir_prior_(true),
         use_dim_prior_(true),
         m_vis_off(vis_off),
-        m_infer_head(!infer_head_off)
+        m_infer_head(!infer_head_off),
+        num_threads_(1)
     {}
 
 public:
@@ -159,6 +162,15 @@ public:
     /** @brief  Returns whether inferring head. */
     bool infer_head() const { return m_infer_head; }
 
+    /**
+     * @brief   Returns the number of threads used to evaluate the
+     *          likelihoods in operator() (0 means one per core).
+     *
+     * The per-target terms are summed in the same order as when using a
+     * single thread, so the result does not depend on this value.
+     */
+    size_t& num_threads() const { return num_threads_; }
+
 public:
     /** @brief  Returns the position prior. */
     const Position_prior& position_prior() const { return pos_prior_; }
@@ -207,6 +219,35 @@ public:
     double dimension_prior(const Scene& scene) const;
 
 private:
+    /** @brief  Likelihood terms that are evaluated target by target. */
+    enum Likelihood_term { BOX_LH, FM_LH, OF_LH, FF_LH, COLOR_LH, NUM_LH };
+
+    /** @brief  Computes the likelihoods of a scene using several threads. */
+    void parallel_likelihoods
+    (
+        const Scene& scene,
+        size_t nthreads,
+        double& bl,
+        double& ml,
+        double& ol,
+        double& fl,
+        double& cl
+    ) const;
+
+    /** @brief  Evaluates a single likelihood term at a single target. */
+    double target_likelihood(Likelihood_term term, const Target& target) const;
+
+    /** @brief  Evaluates (target, term) pairs until there are none left. */
+    void likelihood_worker
+    (
+        const std::vector<const Target*>& targets,
+        const std::vector<size_t>& jobs,
+        std::vector<double>& values,
+        size_t* next,
+        bool* failed,
+        boost::mutex* next_mutex
+    ) const;
+
     // distributions
     const Box_likelihood& box_likelihood_;
     const Facemark_likelihood& fm_likelihood_;
@@ -232,6 +273,7 @@ private:
     mutable bool use_dim_prior_;
     bool m_vis_off;
     bool m_infer_head;
+    mutable size_t num_threads_;
 };
 
 /**
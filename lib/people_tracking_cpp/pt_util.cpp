@@ -723,6 +723,95 @@ void kjb::pt::prune_by_height
 
 /* \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ */
 
+std::vector<Detection_box> kjb::pt::hog_detection_boxes
+(
+    const std::vector<Hog_detection>& detections,
+    double image_width,
+    double image_height,
+    double a,
+    double b,
+    const std::string& type
+)
+{
+    std::vector<Detection_box> dboxes;
+    dboxes.reserve(detections.size());
+    for(size_t i = 0; i < detections.size(); i++)
+    {
+        Bbox box = detections[i].box;
+        standardize(box, image_width, image_height);
+        double pnoise = 1.0 / (1.0 + exp(a + b*detections[i].score));
+        dboxes.push_back(Detection_box(box, pnoise, type));
+    }
+
+    return dboxes;
+}
+
+/* \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ */
+
+void kjb::pt::project_points
+(
+    const Perspective_camera& cam,
+    const std::vector<double>& x,
+    const std::vector<double>& y,
+    const std::vector<double>& z,
+    std::vector<double>& u,
+    std::vector<double>& v
+)
+{
+    const size_t n = x.size();
+    IFT(y.size() == n && z.size() == n, Illegal_argument,
+        "Coordinate arrays must have the same size.");
+
+    u.resize(n);
+    v.resize(n);
+    if(n == 0) return;
+
+    // copy the matrix into locals, so the compiler knows that writing the
+    // output does not change it
+    const Matrix_d<3, 4>& P = cam.get_camera_matrix_d();
+    const double p00 = P(0, 0), p01 = P(0, 1), p02 = P(0, 2), p03 = P(0, 3);
+    const double p10 = P(1, 0), p11 = P(1, 1), p12 = P(1, 2), p13 = P(1, 3);
+    const double p20 = P(2, 0), p21 = P(2, 1), p22 = P(2, 2), p23 = P(2, 3);
+
+    const double* px = &x[0];
+    const double* py = &y[0];
+    const double* pz = &z[0];
+    double* pu = &u[0];
+    double* pv = &v[0];
+
+    // The homogeneous coordinates go in v first. Checking them in the loops
+    // that compute them would stop those from being vectorized.
+    for(size_t i = 0; i < n; i++)
+    {
+        pv[i] = p20*px[i] + p21*py[i] + p22*pz[i] + p23;
+    }
+
+    for(size_t i = 0; i < n; i++)
+    {
+        IFT(fabs(pv[i]) > 1e-10, Illegal_argument,
+            "Homogeneous coordinate cannot be 0.");
+    }
+
+    for(size_t i = 0; i < n; i++)
+    {
+        double w = pv[i];
+        pu[i] = (p00*px[i] + p01*py[i] + p02*pz[i] + p03) / w;
+        pv[i] = (p10*px[i] + p11*py[i] + p12*pz[i] + p13) / w;
+    }
+
+    if(cam.has_radial_distortion())
+    {
+        for(size_t i = 0; i < n; i++)
+        {
+            Vector2 d = cam.radial_distortion(Vector2(pu[i], pv[i]));
+            pu[i] = d[0];
+            pv[i] = d[1];
+        }
+    }
+}
+
+/* \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ */
+
 void kjb::pt::update_facemarks(const Ascn& ascn, const Facemark_data& fms)
 {
     size_t num_frames = fms.size();
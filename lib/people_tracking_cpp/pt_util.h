@@ -35,6 +35,7 @@
 #include <detector_cpp/d_bbox.h>
 #include <detector_cpp/d_deva_detection.h>
 #include <detector_cpp/d_deva_facemark.h>
+#include <detector_cpp/d_hog_scoring.h>
 #include <boost/optional.hpp>
 
 namespace kjb {
@@ -255,15 +256,91 @@ void prune_by_height
     double average_height
 );
 
-/** @brief  Projects a 3D point into a 2D point using camera. */
+/**
+ * @brief   Converts detections of HOG filters (in image coordinates) into
+ *          standardized detection boxes of the given type.
+ *
+ * The probability of noise is <tt>1 / (1 + exp(a + b*score))</tt>, as for
+ * Deva_detection; a and b must be fit for the filters used.
+ */
+std::vector<Detection_box> hog_detection_boxes
+(
+    const std::vector<Hog_detection>& detections,
+    double image_width,
+    double image_height,
+    double a,
+    double b,
+    const std::string& type
+);
+
+/**
+ * @brief   Projects a 3D point into a 2D point using camera, applying its
+ *          radial distortion (if any). Does not allocate.
+ */
+inline
+Vector2 project_point(const Perspective_camera& cam, const Vector3& x)
+{
+    const Matrix_d<3, 4>& P = cam.get_camera_matrix_d();
+    double w = P(2, 0)*x[0] + P(2, 1)*x[1] + P(2, 2)*x[2] + P(2, 3);
+    IFT(fabs(w) > 1e-10, Illegal_argument,
+        "Homogeneous coordinate cannot be 0.");
+
+    Vector2 u((P(0, 0)*x[0] + P(0, 1)*x[1] + P(0, 2)*x[2] + P(0, 3)) / w,
+              (P(1, 0)*x[0] + P(1, 1)*x[1] + P(1, 2)*x[2] + P(1, 3)) / w);
+
+    if(cam.has_radial_distortion())
+    {
+        u = cam.radial_distortion(u);
+    }
+
+    return u;
+}
+
+/**
+ * @brief   Projects a 3D point (or a homogeneous 4D point) into a 2D point
+ *          using camera, applying its radial distortion (if any).
+ */
 inline
 Vector project_point(const Perspective_camera& cam, const Vector& x)
 {
-    Vector temp = x;
-    temp.resize(4, 1.0);
-    return geometry::projective_to_euclidean_2d(cam.get_camera_matrix() * temp);
+    IFT(x.size() == 3 || x.size() == 4, Illegal_argument,
+        "Vector must be of size 3 or 4.");
+
+    const Matrix_d<3, 4>& P = cam.get_camera_matrix_d();
+    double h = x.size() == 4 ? x[3] : 1.0;
+    double w = P(2, 0)*x[0] + P(2, 1)*x[1] + P(2, 2)*x[2] + P(2, 3)*h;
+    IFT(fabs(w) > 1e-10, Illegal_argument,
+        "Homogeneous coordinate cannot be 0.");
+
+    Vector2 u((P(0, 0)*x[0] + P(0, 1)*x[1] + P(0, 2)*x[2] + P(0, 3)*h) / w,
+              (P(1, 0)*x[0] + P(1, 1)*x[1] + P(1, 2)*x[2] + P(1, 3)*h) / w);
+    if(cam.has_radial_distortion())
+    {
+        u = cam.radial_distortion(u);
+    }
+
+    return Vector(u[0], u[1]);
 }
 
+/**
+ * @brief   Projects 3D points, given as arrays of their x, y and z
+ *          coordinates, into 2D points using camera, applying its radial
+ *          distortion (if any).
+ *
+ * u and v are resized to the number of points, so they are only reallocated
+ * if they are too small. The loops over the arrays are simple enough for the
+ * compiler to vectorize.
+ */
+void project_points
+(
+    const Perspective_camera& cam,
+    const std::vector<double>& x,
+    const std::vector<double>& y,
+    const std::vector<double>& z,
+    std::vector<double>& u,
+    std::vector<double>& v
+);
+
 /**
  * @brief   Update facemark detections for face trajectories.
  * @return  The number of noisy detections
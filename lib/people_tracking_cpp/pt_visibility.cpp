@@ -28,123 +28,102 @@
 #include "people_tracking_cpp/pt_association.h"
 #include "m_cpp/m_vector_d.h"
 #include "m_cpp/m_vector.h"
+#include "l_cpp/l_exception.h"
 #include "l_cpp/l_util.h"
 
 #include <vector>
-#include <list>
-#include <boost/bimap/bimap.hpp>
-#include <boost/bimap/multiset_of.hpp>
-
-namespace kjb {
-namespace pt {
-
-// depth map
-using namespace boost::bimaps;
-typedef bimap<const Target*, multiset_of<double> > Depth_map;
-
-/** @brief  Computes visible of a box given other boxes. */
-Visibility get_box_visibility
-(
-    const Bbox& box,
-    double depth,
-    size_t frame,
-    const Depth_map& depth_map,
-    double img_width,
-    double img_height,
-    bool infer_head
-);
-
-}} //namespace kjb::pt
+#include <map>
+#include <algorithm>
+#include <boost/foreach.hpp>
+#include <boost/thread.hpp>
+#include <boost/bind.hpp>
 
 using namespace kjb;
 using namespace kjb::pt;
 
-/* \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ */
+namespace {
 
-void kjb::pt::update_visibilities(const Scene& scene, bool infer_head)
+typedef Visibility_engine::Frame_target Frame_target;
+
+/** @brief  Sets ext to the left, right, bottom, and top of box. */
+inline void set_extent(double* ext, const Bbox& box)
 {
-    if(scene.association.empty()) return;
+    ext[0] = box.get_left();
+    ext[1] = box.get_right();
+    ext[2] = box.get_bottom();
+    ext[3] = box.get_top();
+}
 
-    for(size_t fr = 1; fr <= scene.association.get_data().size(); fr++)
-    {
-        update_visibilities(scene, fr, infer_head);
-    }
+/** @brief  Same as Bbox::intersects(), on extents. */
+inline bool intersects(const double* box, const double* other)
+{
+    return !(other[0] >= box[1] ||
+             other[1] <= box[0] ||
+             other[2] >= box[3] ||
+             other[3] <= box[2]);
 }
 
-/* \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ */
+/** @brief  Same as Bbox::contains(), on an extent. */
+inline bool contains(const double* box, double x, double y)
+{
+    return x >= box[0] && x <= box[1] && y >= box[2] && y <= box[3];
+}
 
-void kjb::pt::update_visibilities
+/** @brief  Gets the depth and boxes of the targets present at a frame. */
+void get_frame_targets
 (
     const Scene& scene,
     size_t frame,
-    bool infer_head
+    bool infer_head,
+    std::vector<Frame_target>& fts
 )
 {
     size_t t = frame - 1;
 
-    // create depth map for this frame
-    Depth_map dmap;
-    BOOST_FOREACH(const Target& target, scene.association)
-    {
-        Trajectory& traj = target.trajectory();
-        if(traj[t])
-        {
-            const Vector3& pos = traj[t]->value.position;
-            dmap.left.insert(Depth_map::left_value_type(&target, pos[2]));
-        }
-    }
-
-    // get image dimensions
-    const Box_data& box_data = (const Box_data&)scene.association.get_data();
-    double iw = box_data.image_width();
-    double ih = box_data.image_height();
-
-    // compute visibilities
+    fts.clear();
     BOOST_FOREACH(const Target& target, scene.association)
     {
         const Trajectory& traj = target.trajectory();
         if(!traj[t]) continue;
 
-        // body visibility
-        Body_2d_trajectory& btraj = target.body_trajectory();
-        ASSERT(btraj[t]);
-        double depth = target.trajectory()[t]->value.position[2];
+        Frame_target ft;
+        ft.target = &target;
+        ft.depth = traj[t]->value.position[2];
 
-        const Bbox& bbox = btraj[t]->value.body_bbox;
-        btraj[t]->value.visibility
-            = get_box_visibility(bbox, depth, frame, dmap, iw, ih, infer_head);
+        const Body_2d_trajectory& btraj = target.body_trajectory();
+        ASSERT(btraj[t]);
+        set_extent(ft.body, btraj[t]->value.body_bbox);
 
-        // face visibility
         if(infer_head)
         {
-            Face_2d_trajectory& ftraj = target.face_trajectory();
+            const Face_2d_trajectory& ftraj = target.face_trajectory();
             ASSERT(ftraj[t]);
-            const Bbox& fbox = ftraj[t]->value.bbox;
-            ftraj[t]->value.visibility
-                = get_box_visibility(fbox, depth, frame, dmap, iw, ih, 
-                                     infer_head);
+            set_extent(ft.face, ftraj[t]->value.bbox);
+        }
+        else
+        {
+            std::fill(ft.face, ft.face + 4, 0.0);
         }
+
+        fts.push_back(ft);
     }
 }
 
-/* \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ */
-
-Visibility kjb::pt::get_box_visibility
+/**
+ * @brief   Computes the visibility of the body or face box of a target,
+ *          given the other targets at its frame.
+ */
+Visibility get_box_visibility
 (
     const Bbox& box,
-    double depth,
-    size_t frame,
-    const Depth_map& depth_map,
+    const Frame_target& owner,
+    bool face,
+    const std::vector<Frame_target>& fts,
     double img_width,
     double img_height,
     bool infer_head
 )
 {
-    size_t t = frame - 1;
-
-    // get box corresponding to track
-    //const Bbox& box = target.body_trajectory()[t]->value.body_bbox;
-
     // constants
     const size_t num_subdivisions = 8; 
     const size_t num_cells = num_subdivisions * num_subdivisions; 
@@ -156,93 +135,83 @@ Visibility kjb::pt::get_box_visibility
     const double x_min = box.get_left() + x_delta / 2.0;
     const double y_min = box.get_bottom() + y_delta / 2.0;
 
-    std::vector<Vector> cell_centers(num_cells, Vector(2, 0.0));
-    std::list<bool> occluded;
+    double xs[num_subdivisions];
+    double ys[num_subdivisions];
+    for(size_t k = 0; k < num_subdivisions; k++)
+    {
+        xs[k] = x_min + k * x_delta;
+        ys[k] = y_min + k * y_delta;
+    }
+
+    double ext[4];
+    set_extent(ext, box);
 
-    // make vector of cell centers, which we'll test for occlusion
+    double im_ext[4];
+    set_extent(im_ext, Bbox(Vector(0.0, 0.0), img_width, img_height));
+
+    // cells are x-major; those outside the image are occluded
+    bool occluded[num_cells];
     size_t i = 0;
-    Bbox im_box(Vector(0.0, 0.0), img_width, img_height);
     for(size_t x_i = 0; x_i < num_subdivisions; x_i++)
     {
         for(size_t y_i = 0; y_i < num_subdivisions; y_i++, i++)
         {
-            const double x = x_min + x_i * x_delta;
-            const double y = y_min + y_i * y_delta;
-            cell_centers[i].set(x, y);
-            occluded.push_back(!im_box.contains(cell_centers[i]));
+            occluded[i] = !contains(im_ext, xs[x_i], ys[y_i]);
         }
     }
 
-    //double depth = target.trajectory()[t]->value.position[2];
-
     // iterate over boxes in front of this one
-    Visibility bvis;
-    bvis.cell_width = x_delta;
-    bvis.cell_height = y_delta;
-    for(Depth_map::right_map::const_iterator
-                                  pair_p = depth_map.right.lower_bound(depth);
-                                  pair_p != depth_map.right.end();
-                                  pair_p++)
+    BOOST_FOREACH(const Frame_target& ft, fts)
     {
-        const Target& cur_target = *pair_p->second;
-
-        // do not check against self
-        //if(&target == &cur_target) continue;
+        if(ft.depth < owner.depth) continue;
 
-        // check against body boxes 
-        const Bbox& cur_box = cur_target.body_trajectory()[t]->value.body_bbox;
+        // a body box does not occlude itself; and the face of a target
+        // is only checked if its body box intersects this box
+        bool self = !face && ft.target == owner.target;
+        if(self || !intersects(ext, ft.body)) continue;
 
-        // do not check against self, if no intersection, skip it
-        if(&cur_box == &box || !box.intersects(cur_box)) continue;
-
-        // test each cell center for occlusion
-        std::list<bool>::iterator bool_p = occluded.begin();
-        BOOST_FOREACH(const Vector& cell_center, cell_centers)
+        i = 0;
+        for(size_t x_i = 0; x_i < num_subdivisions; x_i++)
         {
-            // (we could use a binary search over box's area
-            // here to avoid exhaustive search; but that is 
-            // probably overkill unless num_divisions gets much larger)
-            if(*bool_p == false && cur_box.contains(cell_center))
+            for(size_t y_i = 0; y_i < num_subdivisions; y_i++, i++)
             {
-                *bool_p = true;
+                occluded[i] = occluded[i]
+                                || contains(ft.body, xs[x_i], ys[y_i]);
             }
-
-            *bool_p++;
         }
 
         // check against face boxes
         if(infer_head)
         {
-            const Bbox& cur_fbox = cur_target.face_trajectory()[t]->value.bbox;
+            self = face && ft.target == owner.target;
+            if(self || !intersects(ext, ft.face)) continue;
 
-            // do not check against self, if no intersection, skip it
-            if(&cur_fbox == &box || !box.intersects(cur_fbox)) continue;
-
-            // test each cell center for occlusion
-            std::list<bool>::iterator bool_p = occluded.begin();
-            BOOST_FOREACH(const Vector& cell_center, cell_centers)
+            i = 0;
+            for(size_t x_i = 0; x_i < num_subdivisions; x_i++)
             {
-                // (we could use a binary search over box's area
-                // here to avoid exhaustive search; but that is 
-                // probably overkill unless num_divisions gets much larger)
-                if(*bool_p == false && cur_fbox.contains(cell_center))
+                for(size_t y_i = 0; y_i < num_subdivisions; y_i++, i++)
                 {
-                    *bool_p = true;
+                    occluded[i] = occluded[i]
+                                    || contains(ft.face, xs[x_i], ys[y_i]);
                 }
-
-                *bool_p++;
             }
         }
     }
 
-    bvis.visible_cells.clear();
-    bvis.visible_cells.reserve(cell_centers.size());
-    std::list<bool>::iterator bool_p = occluded.begin();
-    for(i = 0; i < num_cells; i++, bool_p++)
+    Visibility bvis;
+    bvis.cell_width = x_delta;
+    bvis.cell_height = y_delta;
+    bvis.visible_cells.reserve(num_cells);
+
+    i = 0;
+    for(size_t x_i = 0; x_i < num_subdivisions; x_i++)
     {
-        if(!*bool_p)
+        for(size_t y_i = 0; y_i < num_subdivisions; y_i++, i++)
         {
-            bvis.visible_cells.push_back(cell_centers[i]);
+            if(!occluded[i])
+            {
+                bvis.visible_cells.push_back(Vector(xs[x_i], ys[y_i]));
+            }
         }
     }
 
@@ -251,3 +220,356 @@ Visibility kjb::pt::get_box_visibility
     return bvis;
 }
 
+/** @brief  Computes the body and face visibilities of a target. */
+void update_target_visibility
+(
+    const Frame_target& ft,
+    size_t frame,
+    const std::vector<Frame_target>& fts,
+    double img_width,
+    double img_height,
+    bool infer_head
+)
+{
+    size_t t = frame - 1;
+
+    Body_2d_trajectory& btraj = ft.target->body_trajectory();
+    btraj[t]->value.visibility = get_box_visibility(
+                                            btraj[t]->value.body_bbox,
+                                            ft, false, fts,
+                                            img_width, img_height,
+                                            infer_head);
+
+    if(infer_head)
+    {
+        Face_2d_trajectory& ftraj = ft.target->face_trajectory();
+        ftraj[t]->value.visibility = get_box_visibility(
+                                            ftraj[t]->value.bbox,
+                                            ft, true, fts,
+                                            img_width, img_height,
+                                            infer_head);
+    }
+}
+
+/** @brief  True if two visibilities are the same. */
+bool same_visibility(const Visibility& vis1, const Visibility& vis2)
+{
+    return vis1.visible == vis2.visible
+            && vis1.cell_width == vis2.cell_width
+            && vis1.cell_height == vis2.cell_height
+            && vis1.visible_cells == vis2.visible_cells;
+}
+
+/** @brief  True if a target has the same depth and boxes at a frame. */
+bool same_frame_target
+(
+    const Frame_target& ft1,
+    const Frame_target& ft2
+)
+{
+    return ft1.depth == ft2.depth
+            && std::equal(ft1.body, ft1.body + 4, ft2.body)
+            && std::equal(ft1.face, ft1.face + 4, ft2.face);
+}
+
+} // anonymous namespace
+
+/* \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ */
+
+void kjb::pt::update_visibilities(const Scene& scene, bool infer_head)
+{
+    if(scene.association.empty()) return;
+
+    for(size_t fr = 1; fr <= scene.association.get_data().size(); fr++)
+    {
+        update_visibilities(scene, fr, infer_head);
+    }
+}
+
+/* \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ */
+
+void kjb::pt::update_visibilities
+(
+    const Scene& scene,
+    size_t frame,
+    bool infer_head
+)
+{
+    std::vector<Frame_target> fts;
+    get_frame_targets(scene, frame, infer_head, fts);
+
+    // get image dimensions
+    const Box_data& box_data = (const Box_data&)scene.association.get_data();
+    double iw = box_data.image_width();
+    double ih = box_data.image_height();
+
+    // compute visibilities
+    BOOST_FOREACH(const Frame_target& ft, fts)
+    {
+        update_target_visibility(ft, frame, fts, iw, ih, infer_head);
+    }
+}
+
+/* \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ */
+
+void Visibility_engine::update
+(
+    const Scene& scene,
+    std::vector<Visibility_change>* changes
+)
+{
+    if(scene.association.empty())
+    {
+        frames_.clear();
+        return;
+    }
+
+    std::vector<size_t> frames(scene.association.get_data().size());
+    for(size_t t = 0; t < frames.size(); t++)
+    {
+        frames[t] = t + 1;
+    }
+
+    update_frames(scene, frames, changes);
+}
+
+/* \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ */
+
+void Visibility_engine::update
+(
+    const Scene& scene,
+    size_t first_frame,
+    size_t last_frame,
+    std::vector<Visibility_change>* changes
+)
+{
+    if(scene.association.empty())
+    {
+        frames_.clear();
+        return;
+    }
+
+    IFT(first_frame >= 1 && first_frame <= last_frame
+            && last_frame <= scene.association.get_data().size(),
+        Illegal_argument, "Cannot update visibilities; invalid frames.");
+
+    std::vector<size_t> frames;
+    for(size_t fr = first_frame; fr <= last_frame; fr++)
+    {
+        frames.push_back(fr);
+    }
+
+    update_frames(scene, frames, changes);
+}
+
+/* \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ */
+
+void Visibility_engine::update_changed
+(
+    const Scene& scene,
+    std::vector<Visibility_change>* changes
+)
+{
+    if(scene.association.empty())
+    {
+        frames_.clear();
+        return;
+    }
+
+    std::vector<bool> changed(scene.association.get_data().size(), false);
+    BOOST_FOREACH(const Target& tg, scene.association)
+    {
+        if(!tg.changed()) continue;
+
+        for(size_t t = tg.changed_start(); t <= tg.changed_end(); t++)
+        {
+            changed[t - 1] = true;
+        }
+    }
+
+    std::vector<size_t> frames;
+    for(size_t t = 0; t < changed.size(); t++)
+    {
+        if(changed[t]) frames.push_back(t + 1);
+    }
+
+    update_frames(scene, frames, changes);
+}
+
+/* \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ */
+
+void Visibility_engine::update_frames
+(
+    const Scene& scene,
+    const std::vector<size_t>& frames,
+    std::vector<Visibility_change>* changes
+)
+{
+    frames_.resize(scene.association.get_data().size());
+
+    std::vector<std::vector<Visibility_change> > frame_changes(frames.size());
+    size_t next = 0;
+    boost::mutex next_mutex;
+
+    size_t nt = nthreads_;
+    if(nt == 0)
+    {
+        nt = boost::thread::hardware_concurrency();
+    }
+    if(nt > frames.size())
+    {
+        nt = frames.size();
+    }
+
+    if(nt <= 1)
+    {
+        update_worker(scene, frames, frame_changes, &next, &next_mutex);
+    }
+    else
+    {
+        // each frame only touches the visibilities at that frame
+        boost::thread_group thrds;
+        for(size_t t = 0; t < nt; t++)
+        {
+            thrds.create_thread(boost::bind(&Visibility_engine::update_worker,
+                                            this, boost::cref(scene),
+                                            boost::cref(frames),
+                                            boost::ref(frame_changes),
+                                            &next, &next_mutex));
+        }
+        thrds.join_all();
+    }
+
+    if(changes == 0) return;
+
+    for(size_t i = 0; i < frame_changes.size(); i++)
+    {
+        changes->insert(changes->end(), frame_changes[i].begin(),
+                                        frame_changes[i].end());
+    }
+}
+
+/* \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ */
+
+void Visibility_engine::update_worker
+(
+    const Scene& scene,
+    const std::vector<size_t>& frames,
+    std::vector<std::vector<Visibility_change> >& frame_changes,
+    size_t* next,
+    boost::mutex* next_mutex
+)
+{
+    while(true)
+    {
+        size_t i;
+        {
+            boost::mutex::scoped_lock lock(*next_mutex);
+            if(*next >= frames.size())
+            {
+                return;
+            }
+            i = (*next)++;
+        }
+
+        update_frame(scene, frames[i], frame_changes[i]);
+    }
+}
+
+/* \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ */
+
+void Visibility_engine::update_frame
+(
+    const Scene& scene,
+    size_t frame,
+    std::vector<Visibility_change>& changes
+)
+{
+    typedef std::map<const Target*, const Frame_target*> Target_map;
+
+    size_t t = frame - 1;
+    std::vector<Frame_target>& old_fts = frames_[t];
+    std::vector<Frame_target> fts;
+    get_frame_targets(scene, frame, infer_head_, fts);
+
+    Target_map old_map;
+    BOOST_FOREACH(const Frame_target& ft, old_fts)
+    {
+        old_map[ft.target] = &ft;
+    }
+
+    // targets that moved, appeared or disappeared, and their boxes before
+    // and after; nobody else's occluders changed
+    std::vector<bool> moved(fts.size(), false);
+    std::vector<const double*> moved_boxes;
+    for(size_t i = 0; i < fts.size(); i++)
+    {
+        Target_map::iterator pair_p = old_map.find(fts[i].target);
+        if(pair_p != old_map.end())
+        {
+            const Frame_target& old_ft = *pair_p->second;
+            old_map.erase(pair_p);
+            if(same_frame_target(fts[i], old_ft)) continue;
+
+            moved_boxes.push_back(old_ft.body);
+            if(infer_head_) moved_boxes.push_back(old_ft.face);
+        }
+
+        moved[i] = true;
+        moved_boxes.push_back(fts[i].body);
+        if(infer_head_) moved_boxes.push_back(fts[i].face);
+    }
+
+    for(Target_map::const_iterator pair_p = old_map.begin();
+                                   pair_p != old_map.end();
+                                   pair_p++)
+    {
+        moved_boxes.push_back(pair_p->second->body);
+        if(infer_head_) moved_boxes.push_back(pair_p->second->face);
+    }
+
+    if(!moved_boxes.empty())
+    {
+        const Box_data& box_data
+                        = (const Box_data&)scene.association.get_data();
+        double iw = box_data.image_width();
+        double ih = box_data.image_height();
+
+        for(size_t i = 0; i < fts.size(); i++)
+        {
+            const Frame_target& ft = fts[i];
+            bool affected = moved[i];
+            for(size_t j = 0; j < moved_boxes.size() && !affected; j++)
+            {
+                affected = intersects(ft.body, moved_boxes[j])
+                            || (infer_head_
+                                    && intersects(ft.face, moved_boxes[j]));
+            }
+
+            if(!affected) continue;
+
+            Body_2d_trajectory& btraj = ft.target->body_trajectory();
+            Visibility body_vis = btraj[t]->value.visibility;
+            Visibility face_vis;
+            if(infer_head_)
+            {
+                face_vis = ft.target->face_trajectory()[t]->value.visibility;
+            }
+
+            update_target_visibility(ft, frame, fts, iw, ih, infer_head_);
+
+            if(!same_visibility(body_vis, btraj[t]->value.visibility))
+            {
+                changes.push_back(Visibility_change(ft.target, frame, false));
+            }
+
+            if(infer_head_ && !same_visibility(face_vis,
+                        ft.target->face_trajectory()[t]->value.visibility))
+            {
+                changes.push_back(Visibility_change(ft.target, frame, true));
+            }
+        }
+    }
+
+    old_fts.swap(fts);
+}
@@ -26,6 +26,7 @@
 #include <vector>
 
 #include <boost/optional.hpp>
+#include <boost/thread/mutex.hpp>
 
 namespace kjb {
 namespace pt {
@@ -47,6 +48,7 @@ struct Visibility
 
 // forward declaration to avoid cycles
 class Scene;
+class Target;
 
 /** @brief  Update all the visibilities in a scene. */
 void update_visibilities(const Scene& scene, bool infer_head = true);
@@ -59,6 +61,122 @@ void update_visibilities
     bool infer_head = true
 );
 
+/**
+ * @struct  Visibility_change
+ * @brief   Identifies a visibility changed by a Visibility_engine update.
+ */
+struct Visibility_change
+{
+    const Target* target;
+    size_t frame;
+    bool face;
+
+    Visibility_change(const Target* tg, size_t fr, bool fc) :
+        target(tg), frame(fr), face(fc)
+    {}
+};
+
+/**
+ * @class   Visibility_engine
+ * @brief   Keeps the visibilities of a scene up to date as its targets
+ *          move, recomputing only those that can have changed.
+ *
+ * The engine remembers, for every frame, the depth and boxes of each target
+ * as of its last update. When updating a frame, the targets whose depth or
+ * boxes differ from those remembered are found, and only they and the
+ * targets with a box overlapping one of their old or new boxes are
+ * recomputed. Visibilities outside the frames given to update() are
+ * assumed to be up to date. Frames are updated in parallel.
+ */
+class Visibility_engine
+{
+public:
+    /** @brief  The depth and boxes of a target at a frame. */
+    struct Frame_target
+    {
+        const Target* target;
+        double depth;
+
+        // left, right, bottom, and top of the body and face boxes
+        double body[4];
+        double face[4];
+    };
+
+    /** @brief  Create an engine that has seen no scene yet. */
+    Visibility_engine(bool infer_head = true, size_t num_threads = 1) :
+        infer_head_(infer_head), nthreads_(num_threads)
+    {}
+
+    /**
+     * @brief   Update the visibilities of all frames of a scene.
+     *
+     * If changes is not null, the visibilities that changed are appended
+     * to it, frame by frame.
+     */
+    void update
+    (
+        const Scene& scene,
+        std::vector<Visibility_change>* changes = 0
+    );
+
+    /**
+     * @brief   Update the visibilities of frames [first_frame, last_frame]
+     *          of a scene, which must be the only frames changed since the
+     *          last update.
+     */
+    void update
+    (
+        const Scene& scene,
+        size_t first_frame,
+        size_t last_frame,
+        std::vector<Visibility_change>* changes = 0
+    );
+
+    /**
+     * @brief   Update the visibilities of the frames in which the targets
+     *          of a scene are marked as changed.
+     */
+    void update_changed
+    (
+        const Scene& scene,
+        std::vector<Visibility_change>* changes = 0
+    );
+
+    /** @brief  Forget everything remembered about the scene. */
+    void clear() { frames_.clear(); }
+
+    /** @brief  Set the number of threads (0 means one per core). */
+    void set_num_threads(size_t nthreads) { nthreads_ = nthreads; }
+
+private:
+    void update_frames
+    (
+        const Scene& scene,
+        const std::vector<size_t>& frames,
+        std::vector<Visibility_change>* changes
+    );
+
+    void update_worker
+    (
+        const Scene& scene,
+        const std::vector<size_t>& frames,
+        std::vector<std::vector<Visibility_change> >& frame_changes,
+        size_t* next,
+        boost::mutex* next_mutex
+    );
+
+    void update_frame
+    (
+        const Scene& scene,
+        size_t frame,
+        std::vector<Visibility_change>& changes
+    );
+
+    bool infer_head_;
+    size_t nthreads_;
+    std::vector<std::vector<Frame_target> > frames_;
+};
+
 }} //namespace kjb::pt
 
 #endif /*PT_VISIBILITY_H */
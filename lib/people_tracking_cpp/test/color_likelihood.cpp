@@ -27,10 +27,12 @@
 #include <detector_cpp/d_bbox.h>
 #include <i_cpp/i_image.h>
 #include <i_cpp/i_pixel.h>
+#include <i_cpp/i_filter.h>
 #include <m_cpp/m_matrix.h>
 #include <gr_cpp/gr_2D_bounding_box.h>
 #include <l_cpp/l_test.h>
 #include <l/l_sys_io.h>
+#include <boost/foreach.hpp>
 
 using namespace kjb;
 using namespace kjb::pt;
@@ -169,6 +171,93 @@ int main()
     //std::cout << color_l_3 << std::endl;
     //// END TEST 3
 
+    //// TEST 4 integral histograms give the same cell histograms as
+    //// Histogram_2d, with background values on (and next to) bin edges
+    const size_t num_bins = 8;
+    const std::pair<double, double> range(0.0, 1.0);
+    const double bin_size = 1.0 / (num_bins - 1);
+
+    // edges accumulated as Histogram_2d does, and computed directly
+    std::vector<double> edge_values;
+    double edge = 0.0;
+    for(size_t k = 0; k < num_bins; k++, edge += bin_size)
+    {
+        edge_values.push_back(edge);
+        edge_values.push_back(k / (num_bins - 1.0));
+        edge_values.push_back(k * bin_size);
+    }
+    edge_values.push_back(1.0);
+
+    Matrix bg_r(rows, cols);
+    Matrix bg_g(rows, cols);
+    for(size_t row = 0; row < rows; row++)
+    {
+        for(size_t col = 0; col < cols; col++)
+        {
+            bg_r(row, col) = edge_values[(row + col) % edge_values.size()];
+            bg_g(row, col) = edge_values[(3 * row + col) % edge_values.size()];
+        }
+    }
+
+    Color_likelihood c_l_hist;
+    c_l_hist.set_bg_r_matrix(&bg_r);
+    c_l_hist.set_bg_g_matrix(&bg_g);
+    c_l_hist.read_frames(img_names);
+
+    Color_likelihood c_l_int(1, 1, true);
+    c_l_int.set_bg_r_matrix(&bg_r);
+    c_l_int.set_bg_g_matrix(&bg_g);
+    c_l_int.read_frames(img_names);
+
+    Filter filter = gaussian_filter(1.0);
+
+    // cells inside the image, and over its sides and corners
+    std::vector<Vector> cell_locs;
+    cell_locs.push_back(Vector(0.0, 0.0));
+    cell_locs.push_back(Vector(13.5, -27.25));
+    cell_locs.push_back(Vector(-cols / 2.0, 0.0));
+    cell_locs.push_back(Vector(cols / 2.0 - 3.0, rows / 2.0 - 3.0));
+    cell_locs.push_back(Vector(-cols / 2.0 + 2.0, -rows / 2.0));
+
+    BOOST_FOREACH(const Vector& loc, cell_locs)
+    {
+        for(size_t is_fg = 0; is_fg <= 1; is_fg++)
+        {
+            Matrix H_hist = c_l_hist.get_norm_hist_as_matrix(
+                                    loc, 17.0, 23.0, start_time,
+                                    range, range, num_bins, filter, is_fg);
+            Matrix H_int = c_l_int.get_norm_hist_as_matrix(
+                                    loc, 17.0, 23.0, start_time,
+                                    range, range, num_bins, filter, is_fg);
+
+            TEST_TRUE(H_hist.get_num_rows() == H_int.get_num_rows());
+            TEST_TRUE(H_hist.get_num_cols() == H_int.get_num_cols());
+            TEST_TRUE(max_abs_difference(H_hist, H_int) <= DBL_EPSILON);
+        }
+    }
+
+    // other ranges are not what the integral histograms were binned for
+    const std::pair<double, double> half_range(0.0, 0.5);
+    Matrix H_hist = c_l_hist.get_norm_hist_as_matrix(
+                            cell_locs[0], 17.0, 23.0, start_time,
+                            half_range, range, num_bins, filter, false);
+    Matrix H_int = c_l_int.get_norm_hist_as_matrix(
+                            cell_locs[0], 17.0, 23.0, start_time,
+                            half_range, range, num_bins, filter, false);
+    TEST_TRUE(max_abs_difference(H_hist, H_int) <= DBL_EPSILON);
+
+    // but the frame pixels are not kept for other foreground histograms
+    c_l_hist.get_norm_hist_as_matrix(cell_locs[0], 17.0, 23.0, start_time,
+                                     half_range, range, num_bins, filter,
+                                     true);
+    TEST_FAIL(c_l_int.get_norm_hist_as_matrix(
+                            cell_locs[0], 17.0, 23.0, start_time,
+                            half_range, range, num_bins, filter, true));
+    TEST_FAIL(c_l_int.get_norm_hist_as_matrix(
+                            cell_locs[0], 17.0, 23.0, start_time,
+                            range, range, num_bins / 2, filter, true));
+    //// END TEST 4
+
     TEST_TRUE(color_l_1 <= DBL_EPSILON
                 && color_l_2 < DBL_EPSILON
                 && color_l_3 > DBL_EPSILON);
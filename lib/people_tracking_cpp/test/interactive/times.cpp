@@ -169,14 +169,14 @@ int main(int argc, char** argv)
         cout << "  head_points(): " << tot_time/1000.0 << endl;
 
         tot_time = 0;
+        Vector_vec hpts_2d(hpts.size());
         for(size_t i = 1; i <= num_reps; ++i)
         {
             kjb_c::init_real_time();
-            transform(
-                hpts.begin(),
-                hpts.end(),
-                hpts.begin(),
-                bind(project_point, cref(cam), _1));
+            for(size_t j = 0; j < hpts.size(); ++j)
+            {
+                hpts_2d[j] = project_point(cam, hpts[j]);
+            }
             tot_time += kjb_c::get_real_time();
         }
         cout << "  project head pts: " << tot_time/1000.0 << endl;
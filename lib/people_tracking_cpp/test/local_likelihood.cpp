@@ -122,6 +122,12 @@ int main(int argc, char** argv)
         bool pvo = posterior.vis_off();
 
         double orig_pt = posterior(scene);
+
+        // threads only change who evaluates each target, not the sum
+        posterior.num_threads() = 4;
+        TEST_TRUE(posterior(scene) == orig_pt);
+        posterior.num_threads() = 1;
+
         double orig_pr = pos_prior(scene)
                             + dir_prior(scene)
                             + fdir_prior(scene);
@@ -0,0 +1,112 @@
+/* =========================================================================== *
+   |
+   |  Copyright (c) 1994-2011 by Kobus Barnard (author)
+   |
+   |  Personal and educational use of this code is granted, provided that this
+   |  header is kept intact, and that the authorship is not misrepresented, that
+   |  its use is acknowledged in publications, and relevant papers are cited.
+   |
+   |  For other use contact the author (kobus AT cs DOT arizona DOT edu).
+   |
+   |  Please note that the code in this file has not necessarily been adequately
+   |  tested. Naturally, there is no guarantee of performance, support, or fitness
+   |  for any particular task. Nonetheless, I am interested in hearing about
+   |  problems that you encounter.
+   |
+ * =========================================================================== */
+
+/* $Id$ */
+
+#include <people_tracking_cpp/pt_util.h>
+#include <camera_cpp/perspective_camera.h>
+#include <g_cpp/g_util.h>
+#include <l_cpp/l_test.h>
+#include <vector>
+#include <cmath>
+
+using namespace std;
+using namespace kjb;
+using namespace kjb::pt;
+
+/** @brief  True if the 2D points are the same, up to rounding. */
+bool same_point(double u1, double v1, double u2, double v2)
+{
+    const double eps = 1e-9;
+    return fabs(u1 - u2) <= eps * (1.0 + fabs(u1))
+            && fabs(v1 - v2) <= eps * (1.0 + fabs(v1));
+}
+
+/** @brief  Main =) */
+int main(int argc, char** argv)
+{
+    Perspective_camera cam(0.5, 1.7, 8.0, 0.1, -0.2, 0.05,
+                           600.0, 3.0, -2.0, M_PI/2 - 0.01, 1.1);
+
+    // points in front of the camera, enough for the vectorized loop
+    const size_t num_points = 103;
+    vector<double> xs(num_points);
+    vector<double> ys(num_points);
+    vector<double> zs(num_points);
+    for(size_t i = 0; i < num_points; i++)
+    {
+        xs[i] = -3.0 + 0.06 * i;
+        ys[i] = 0.02 * (i % 17);
+        zs[i] = -5.0 - 0.1 * (i % 11);
+    }
+
+    vector<double> us;
+    vector<double> vs;
+    project_points(cam, xs, ys, zs, us, vs);
+    TEST_TRUE(us.size() == num_points && vs.size() == num_points);
+
+    for(size_t i = 0; i < num_points; i++)
+    {
+        Vector x(xs[i], ys[i], zs[i]);
+
+        // the way project_point used to compute it
+        Vector xh = x;
+        xh.resize(4, 1.0);
+        Vector ue = geometry::projective_to_euclidean_2d(
+                                            cam.get_camera_matrix() * xh);
+
+        Vector2 u = project_point(cam, Vector3(xs[i], ys[i], zs[i]));
+        Vector uv = project_point(cam, x);
+        Vector uh = project_point(cam, Vector(2.0 * x).resize(4, 2.0));
+
+        TEST_TRUE(same_point(u[0], u[1], ue[0], ue[1]));
+        TEST_TRUE(uv.size() == 2 && same_point(uv[0], uv[1], ue[0], ue[1]));
+        TEST_TRUE(same_point(uh[0], uh[1], ue[0], ue[1]));
+        TEST_TRUE(same_point(us[i], vs[i], ue[0], ue[1]));
+    }
+
+    // radial distortion is applied by all the versions
+    cam.set_radial_distortion(0.1, -0.02, 0.003, 0.001, -0.002);
+    Perspective_camera dcam = cam;
+    TEST_TRUE(dcam.has_radial_distortion());
+
+    project_points(dcam, xs, ys, zs, us, vs);
+    for(size_t i = 0; i < num_points; i++)
+    {
+        Vector3 x(xs[i], ys[i], zs[i]);
+        Vector ue = cam.radial_distortion(
+                geometry::projective_to_euclidean_2d(
+                    cam.get_camera_matrix() * Vector(x[0], x[1], x[2], 1.0)));
+
+        Vector2 u = project_point(dcam, x);
+        Vector uv = project_point(dcam, Vector(x[0], x[1], x[2]));
+
+        TEST_TRUE(same_point(u[0], u[1], ue[0], ue[1]));
+        TEST_TRUE(same_point(uv[0], uv[1], ue[0], ue[1]));
+        TEST_TRUE(same_point(us[i], vs[i], ue[0], ue[1]));
+    }
+
+    // the camera centre cannot be projected
+    Vector3 cc(0.5, 1.7, 8.0);
+    xs.push_back(cc[0]);
+    ys.push_back(cc[1]);
+    zs.push_back(cc[2]);
+    TEST_FAIL(project_point(cam, cc));
+    TEST_FAIL(project_points(cam, xs, ys, zs, us, vs));
+
+    RETURN_VICTORIOUSLY();
+}
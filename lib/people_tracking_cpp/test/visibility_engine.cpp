@@ -0,0 +1,221 @@
+/* =========================================================================== *
+   |
+   |  Copyright (c) 1994-2011 by Kobus Barnard (author)
+   |
+   |  Personal and educational use of this code is granted, provided that this
+   |  header is kept intact, and that the authorship is not misrepresented, that
+   |  its use is acknowledged in publications, and relevant papers are cited.
+   |
+   |  For other use contact the author (kobus AT cs DOT arizona DOT edu).
+   |
+   |  Please note that the code in this file has not necessarily been adequately
+   |  tested. Naturally, there is no guarantee of performance, support, or fitness
+   |  for any particular task. Nonetheless, I am interested in hearing about
+   |  problems that you encounter.
+   |
+ * =========================================================================== */
+
+/* $Id$ */
+
+#include <people_tracking_cpp/pt_scene.h>
+#include <people_tracking_cpp/pt_association.h>
+#include <people_tracking_cpp/pt_complete_trajectory.h>
+#include <people_tracking_cpp/pt_visibility.h>
+#include <people_tracking_cpp/pt_data.h>
+#include <l_cpp/l_test.h>
+#include <algorithm>
+#include <vector>
+#include <set>
+#include <boost/foreach.hpp>
+#include <boost/tuple/tuple.hpp>
+#include <boost/tuple/tuple_comparison.hpp>
+
+#include "utils.h"
+
+using namespace std;
+using namespace kjb;
+using namespace kjb::pt;
+
+typedef boost::tuple<size_t, size_t, bool> Vis_key;
+
+/** @brief  True if two visibilities are the same. */
+bool same_visibility(const Visibility& vis1, const Visibility& vis2)
+{
+    return vis1.visible == vis2.visible
+            && vis1.cell_width == vis2.cell_width
+            && vis1.cell_height == vis2.cell_height
+            && vis1.visible_cells == vis2.visible_cells;
+}
+
+/** @brief  All the body and face visibilities of a scene. */
+vector<Visibility> get_visibilities(const Scene& scene)
+{
+    vector<Visibility> viss;
+    BOOST_FOREACH(const Target& target, scene.association)
+    {
+        const Body_2d_trajectory& btraj = target.body_trajectory();
+        const Face_2d_trajectory& ftraj = target.face_trajectory();
+        for(size_t t = btraj.start_time() - 1; t < btraj.end_time(); t++)
+        {
+            viss.push_back(btraj[t]->value.visibility);
+            viss.push_back(ftraj[t]->value.visibility);
+        }
+    }
+
+    return viss;
+}
+
+/** @brief  The (target, frame, face) of each visibility, as above. */
+vector<Vis_key> get_keys(const Scene& scene)
+{
+    vector<Vis_key> keys;
+    size_t i = 0;
+    BOOST_FOREACH(const Target& target, scene.association)
+    {
+        const Body_2d_trajectory& btraj = target.body_trajectory();
+        for(size_t t = btraj.start_time() - 1; t < btraj.end_time(); t++)
+        {
+            keys.push_back(Vis_key(i, t + 1, false));
+            keys.push_back(Vis_key(i, t + 1, true));
+        }
+        i++;
+    }
+
+    return keys;
+}
+
+/** @brief  Moves the k-th target of a scene at frames [sf, ef]. */
+void move_target(Scene& scene, size_t k, size_t sf, size_t ef, double dx)
+{
+    Ascn::iterator tg_p = scene.association.begin();
+    std::advance(tg_p, k);
+
+    sf = std::max(sf, (size_t)tg_p->get_start_time());
+    ef = std::min(ef, (size_t)tg_p->get_end_time());
+    if(sf > ef) return;
+
+    for(size_t t = sf; t <= ef; t++)
+    {
+        tg_p->trajectory()[t - 1]->value.position[0] += dx;
+        tg_p->trajectory()[t - 1]->value.position[2] += dx / 2.0;
+    }
+
+    // boxes are recomputed (and their visibilities reset) where changed
+    tg_p->set_changed_start(sf);
+    tg_p->set_changed_end(ef);
+    tg_p->update_boxes(scene.camera);
+    tg_p->update_faces(scene.camera);
+}
+
+/** @brief  Main =) */
+int main(int argc, char** argv)
+{
+    // CREATE SCENE
+    size_t num_frames = 50;
+    double img_width = 500;
+    double img_height = 500;
+    const size_t num_max_trajs = 3;
+
+    Box_data data(img_width, img_height, 0.99);
+    vector<Integral_flow> flows_x;
+    vector<Integral_flow> flows_y;
+    Facemark_data fm_data(num_frames);
+
+    Scene scene1(Ascn(data), Perspective_camera(), 0.0, 0.0, 0.0);
+    create_or_read_scene(
+        argc, argv, num_frames, img_width, img_height,
+        data, fm_data, flows_x, flows_y, scene1, num_max_trajs);
+
+    // make the boxes agree with the trajectories everywhere, so that a move
+    // changes boxes only where it moves a target
+    BOOST_FOREACH(const Target& target, scene1.association)
+    {
+        target.update_boxes(scene1.camera);
+        target.update_faces(scene1.camera);
+        target.set_unchanged();
+    }
+    Scene scene2 = scene1;
+    size_t num_targets = scene1.association.size();
+
+    // the engine gets the same visibilities, with or without threads
+    Visibility_engine engine(true, 3);
+    update_visibilities(scene1);
+    engine.update(scene2);
+    TEST_TRUE(get_visibilities(scene1).size() == get_visibilities(scene2).size());
+    {
+        vector<Visibility> viss1 = get_visibilities(scene1);
+        vector<Visibility> viss2 = get_visibilities(scene2);
+        for(size_t i = 0; i < viss1.size(); i++)
+        {
+            TEST_TRUE(same_visibility(viss1[i], viss2[i]));
+        }
+    }
+
+    // move targets over a few frames, and update only those frames
+    for(size_t m = 0; m < 3 * num_frames; m++)
+    {
+        size_t k = m % num_targets;
+        size_t sf = 1 + (m * 7) % num_frames;
+        size_t ef = std::min(sf + m % 4, num_frames);
+        double dx = (m % 2 == 0 ? 0.15 : -0.1) * (1 + m % 3);
+
+        move_target(scene1, k, sf, ef, dx);
+        move_target(scene2, k, sf, ef, dx);
+
+        vector<Visibility> before = get_visibilities(scene2);
+        vector<Visibility_change> changes;
+        update_visibilities(scene1);
+        engine.set_num_threads(m % 3);
+        if(m % 2 == 0)
+        {
+            engine.update(scene2, sf, ef, &changes);
+        }
+        else
+        {
+            engine.update_changed(scene2, &changes);
+        }
+
+        BOOST_FOREACH(const Target& target, scene1.association)
+        {
+            target.set_unchanged();
+        }
+        BOOST_FOREACH(const Target& target, scene2.association)
+        {
+            target.set_unchanged();
+        }
+
+        vector<Visibility> viss1 = get_visibilities(scene1);
+        vector<Visibility> viss2 = get_visibilities(scene2);
+        vector<Vis_key> keys = get_keys(scene2);
+
+        // the reported changes are exactly the visibilities that changed
+        set<Vis_key> changed;
+        for(size_t i = 0; i < viss1.size(); i++)
+        {
+            TEST_TRUE(same_visibility(viss1[i], viss2[i]));
+            if(!same_visibility(before[i], viss2[i]))
+            {
+                changed.insert(keys[i]);
+            }
+        }
+
+        set<Vis_key> reported;
+        BOOST_FOREACH(const Visibility_change& change, changes)
+        {
+            Ascn::const_iterator tg_p = scene2.association.begin();
+            size_t i = 0;
+            while(&*tg_p != change.target)
+            {
+                tg_p++;
+                i++;
+            }
+
+            TEST_TRUE(change.frame >= sf && change.frame <= ef);
+            reported.insert(Vis_key(i, change.frame, change.face));
+        }
+
+        TEST_TRUE(reported == changed);
+    }
+
+    RETURN_VICTORIOUSLY();
+}
@@ -37,6 +37,7 @@
 #include <boost/math/distributions/inverse_chi_squared.hpp>
 #include <boost/math/distributions/negative_binomial.hpp>
 #include <map>
+#include <algorithm>
 #include <cmath>
 #include <vector>
 #include "prob_cpp/prob_util.h"
@@ -46,6 +47,7 @@
 #include "n_cpp/n_cholesky.h"
 #include "l_cpp/l_exception.h"
 #include "l_cpp/l_std_parallel.h"
+#include "l/l_sys_debug.h"  /* For ASSERT. */
 
 #include "g/g_area.h"
 #include "g_cpp/g_quaternion.h"
@@ -126,6 +128,26 @@ struct Distribution_traits
  * finite number of numbers. It stores an STL map that relates values
  * with probabilities.
  *
+ * Samples are drawn in one of three ways (see set_sampling_method()):
+ *
+ * - CDF_SAMPLING (the default) binary-searches the cumulative weights, in
+ *   O(log n) time; changing a weight rebuilds them in O(n) time.
+ *
+ * - ALIAS_SAMPLING uses Walker's alias table (built with Vose's method),
+ *   which gives samples in O(1) time. The table is built in O(n) time the
+ *   first time the distribution is sampled after a change, so this is the
+ *   best choice for distributions that are sampled many times and rarely
+ *   change.
+ *
+ * - SUM_TREE_SAMPLING keeps the weights in a binary tree whose nodes hold
+ *   the sum of their children, so that both sampling and set_weight() (or
+ *   insert()) take O(log n) time. Use this for large distributions whose
+ *   weights change a few at a time, e.g., in a Gibbs sampler.
+ *
+ * The alias table is built lazily by the (const) sampling functions, so a
+ * distribution in ALIAS_SAMPLING mode should not be sampled by several
+ * threads at once right after it changes.
+ *
  * @tparam  T   The type over which the distribution is over. Must be
  *              be a RealType (i.e., a field).
  */
@@ -137,11 +159,15 @@ class Categorical_distribution
     typedef typename std::map<T, double>::value_type Map_pair;
 
 public:
+    /** @brief  How samples are drawn; see the class documentation. */
+    enum Sampling_method { CDF_SAMPLING, ALIAS_SAMPLING, SUM_TREE_SAMPLING };
+
     /// @brief Construct an empty distribution.
     Categorical_distribution() :
         db(),
         cdf_(),
-        total_weight_(0)
+        total_weight_(0),
+        method_(CDF_SAMPLING)
     {}
 
     /**
@@ -209,7 +235,9 @@ public:
      * @param   d  A map containing the distribution. It must
      * be such that P(X = x) = d[x].
      */
-    Categorical_distribution(const std::map<T, double>& d) : db(d)
+    Categorical_distribution(const std::map<T, double>& d) :
+        db(d),
+        method_(CDF_SAMPLING)
     {
         init_cdf_();
     }
@@ -220,7 +248,8 @@ public:
      * @param   m  A map containing the distribution. It must
      * be such that P(X = x) is proportional to m[x].
      */
-    Categorical_distribution(const std::map<T, size_t>& m)
+    Categorical_distribution(const std::map<T, size_t>& m) :
+        method_(CDF_SAMPLING)
     {
         for(typename std::map<T,size_t>::const_iterator it = m.begin();
             it != m.end(); ++it)
@@ -251,7 +280,8 @@ public:
      *
      * (wait, so this is just a bernoulli distribution?  suggest removing this constructor --kyle, March 13, 2012)
      */
-    Categorical_distribution(const T& x1, const T& x2, double p1, double p2)
+    Categorical_distribution(const T& x1, const T& x2, double p1, double p2) :
+        method_(CDF_SAMPLING)
     {
         db[x1] = p1;
         db[x2] = p2;
@@ -260,7 +290,8 @@ public:
 
     /** @brief   Copy-ctor: needed to make sure init_cdf_ gets called. */
     Categorical_distribution(const Categorical_distribution<T>& cd) :
-        db(cd.db)
+        db(cd.db),
+        method_(cd.method_)
     {
         init_cdf_();
     }
@@ -271,6 +302,7 @@ public:
         if(this != &cd)
         {
             db = cd.db;
+            method_ = cd.method_;
             init_cdf_();
         }
 
@@ -298,6 +330,7 @@ public:
         Categorical_distribution<T> result;
 
         result.db = log_map;
+        result.method_ = CDF_SAMPLING;
 
         // get the sum of the log-weights, without leaving log space, which mitigates precision loss
         // when weights are very small.
@@ -373,6 +406,9 @@ public:
         if(count > 0)
             KJB_THROW_2(Illegal_argument, "Key collision");
 
+        if(weight < 0.0)
+            KJB_THROW_2(Illegal_argument, "Weights must be non-negative");
+
         const T* stored_key = &db.insert(std::make_pair(key, weight)).first->first;
 
         if(cdf_.empty())
@@ -381,6 +417,84 @@ public:
             total_weight_ += weight;
 
         cdf_.push_back(Cdf_pair(stored_key, total_weight_));
+
+        alias_prob_.clear();
+        if(method_ == SUM_TREE_SAMPLING)
+        {
+            if(cdf_.size() > tree_.size() / 2)
+            {
+                init_tree_();
+            }
+            else
+            {
+                positions_[stored_key] = cdf_.size() - 1;
+                update_tree_(cdf_.size() - 1, weight);
+                total_weight_ = tree_[1];
+            }
+        }
+    }
+
+    /**
+     * @brief   Change the (unnormalized) weight of an item.
+     *
+     * Running time is O(log n) with SUM_TREE_SAMPLING, and O(n) otherwise.
+     *
+     * @throws Illegal_argument if key does not exist in the collection, or
+     *         if weight is negative.
+     */
+    void set_weight(const T& key, double weight)
+    {
+        typename std::map<T, double>::iterator it = db.find(key);
+        if(it == db.end())
+            KJB_THROW_2(Illegal_argument, "Key not found");
+        if(weight < 0.0)
+            KJB_THROW_2(Illegal_argument, "Weights must be non-negative");
+
+        it->second = weight;
+
+        if(method_ != SUM_TREE_SAMPLING)
+        {
+            init_cdf_();
+            return;
+        }
+
+        // the cumulative weights in cdf_ are left stale in this mode; they
+        // are recomputed when the sampling method changes
+        alias_prob_.clear();
+        update_tree_(positions_[&it->first], weight);
+        total_weight_ = tree_[1];
+    }
+
+    /** @brief  Get the (unnormalized) weight of an item; 0 if absent. */
+    double get_weight(const T& key) const
+    {
+        typename std::map<T, double>::const_iterator it = db.find(key);
+        return it == db.end() ? 0.0 : it->second;
+    }
+
+    /** @brief  Choose how samples are drawn; see the class documentation. */
+    void set_sampling_method(Sampling_method method)
+    {
+        if(method == method_) return;
+
+        bool was_tree = method_ == SUM_TREE_SAMPLING;
+        method_ = method;
+        if(was_tree)
+        {
+            tree_.clear();
+            positions_.clear();
+            init_cdf_();
+        }
+        else if(method_ == SUM_TREE_SAMPLING)
+        {
+            init_tree_();
+        }
+    }
+
+    /** @brief  The current sampling method. */
+    Sampling_method get_sampling_method() const
+    {
+        return method_;
     }
 
     /**
@@ -407,6 +521,14 @@ public:
     template<class U>
     friend U sample(const Categorical_distribution<U>& dist);
 
+    template<class U, class OutputIterator>
+    friend void sample_n
+    (
+        const Categorical_distribution<U>& dist,
+        size_t n,
+        OutputIterator out
+    );
+
 private:
 
     void init_cdf_()
@@ -414,7 +536,13 @@ private:
         using namespace boost;
 
         cdf_.resize(db.size());
-        if(cdf_.size() == 0) return;
+        alias_prob_.clear();
+        if(cdf_.size() == 0)
+        {
+            tree_.clear();
+            positions_.clear();
+            return;
+        }
 
         //typedef typename std::map<T, double>::const_iterator Const_iterator;
 
@@ -443,6 +571,11 @@ private:
             KJB_THROW_2(Illegal_argument, "Items have zero probability mass.");
         }
 
+        if(method_ == SUM_TREE_SAMPLING)
+        {
+            init_tree_();
+        }
+
 
         // normalize to 1.0
         // update: we now store CDF unnormalized, to make dynamic
@@ -464,6 +597,129 @@ private:
     }
 
 
+    /**
+     * Build the sum tree over the items, in the order of cdf_. The leaves
+     * are tree_[cap + i], where cap is a power of two at least twice the
+     * number of items (so that items can be inserted), and node j is the
+     * sum of nodes 2j and 2j + 1.
+     */
+    void init_tree_()
+    {
+        size_t cap = 1;
+        while(cap < 2 * cdf_.size()) cap *= 2;
+
+        tree_.assign(2 * cap, 0.0);
+        positions_.clear();
+        for(size_t i = 0; i < cdf_.size(); i++)
+        {
+            tree_[cap + i] = db.find(*cdf_[i].first)->second;
+            positions_[cdf_[i].first] = i;
+        }
+
+        for(size_t j = cap - 1; j >= 1; j--)
+        {
+            tree_[j] = tree_[2 * j] + tree_[2 * j + 1];
+        }
+
+        total_weight_ = tree_[1];
+    }
+
+    /** Set the weight of the i-th item and update its ancestors. */
+    void update_tree_(size_t i, double weight)
+    {
+        size_t j = tree_.size() / 2 + i;
+        tree_[j] = weight;
+        for(j /= 2; j >= 1; j /= 2)
+        {
+            tree_[j] = tree_[2 * j] + tree_[2 * j + 1];
+        }
+    }
+
+    /** Index of the item at u, for u in [0, total weight). */
+    size_t tree_lookup_(double u) const
+    {
+        const size_t cap = tree_.size() / 2;
+        size_t j = 1;
+        while(j < cap)
+        {
+            const double left = tree_[2 * j];
+            // round-off may leave u past the last item with mass
+            if(u < left || tree_[2 * j + 1] <= 0.0)
+            {
+                j = 2 * j;
+            }
+            else
+            {
+                u -= left;
+                j = 2 * j + 1;
+            }
+        }
+
+        return j - cap;
+    }
+
+    /** Index of the item at u, for u in [0, total weight). */
+    size_t cdf_lookup_(double u) const
+    {
+        typename std::vector<Cdf_pair>::const_iterator r =
+            std::lower_bound(
+                cdf_.begin(),
+                cdf_.end(),
+                u,
+                cdf_pair_less_than_scalar());
+
+        ASSERT(r != cdf_.end());
+        return r - cdf_.begin();
+    }
+
+    /** Build the alias table (Vose's method) if it is out of date. */
+    void init_alias_table_() const
+    {
+        const size_t n = cdf_.size();
+        if(alias_prob_.size() == n) return;
+
+        alias_prob_.resize(n);
+        alias_index_.resize(n);
+
+        std::vector<size_t> small;
+        std::vector<size_t> large;
+        const double scale = n / total_weight_;
+        for(size_t i = 0; i < n; i++)
+        {
+            alias_prob_[i] = db.find(*cdf_[i].first)->second * scale;
+            alias_index_[i] = i;
+            if(alias_prob_[i] < 1.0)
+                small.push_back(i);
+            else
+                large.push_back(i);
+        }
+
+        while(!small.empty() && !large.empty())
+        {
+            const size_t s = small.back();
+            const size_t l = large.back();
+            small.pop_back();
+
+            alias_index_[s] = l;
+            alias_prob_[l] -= 1.0 - alias_prob_[s];
+            if(alias_prob_[l] < 1.0)
+            {
+                large.pop_back();
+                small.push_back(l);
+            }
+        }
+
+        // whatever is left is full, up to round-off
+        for(size_t k = 0; k < small.size(); k++) alias_prob_[small[k]] = 1.0;
+        for(size_t k = 0; k < large.size(); k++) alias_prob_[large[k]] = 1.0;
+    }
+
+    /** Index of the item for column i of the alias table and coin in [0, 1). */
+    size_t alias_lookup_(size_t i, double coin) const
+    {
+        return coin < alias_prob_[i] ? i : alias_index_[i];
+    }
+
     // utility functors
     struct make_cdf_pair : public std::unary_function<Cdf_pair, const Map_pair&>
     {
@@ -518,6 +774,16 @@ private:
     std::map<T, double> db;
     std::vector<Cdf_pair> cdf_;
     double total_weight_;
+
+    Sampling_method method_;
+
+    // ALIAS_SAMPLING; empty when out of date
+    mutable std::vector<double> alias_prob_;
+    mutable std::vector<size_t> alias_index_;
+
+    // SUM_TREE_SAMPLING
+    std::vector<double> tree_;
+    std::map<const T*, size_t> positions_;
 };
 
 /* non-inline member functions */
@@ -530,6 +796,7 @@ Categorical_distribution<T>::Categorical_distribution
     const std::vector<double>& ps,
     const T& t1
 )
+: method_(CDF_SAMPLING)
 {
     for(std::size_t i = 0; i < ps.size(); i++)
     {
@@ -546,6 +813,7 @@ Categorical_distribution<T>::Categorical_distribution
     const Vector& ps,
     const T& t1
 )
+: method_(CDF_SAMPLING)
 {
     for(int i = 0; i < ps.get_length(); i++)
     {
@@ -562,6 +830,7 @@ Categorical_distribution<T>::Categorical_distribution
 (
     const std::vector<T>& values,
     const std::vector<double>& probabilities)
+: method_(CDF_SAMPLING)
 {
     for(std::size_t i = 0; i < probabilities.size(); i++)
     {
@@ -577,6 +846,7 @@ Categorical_distribution<T>::Categorical_distribution
 (
     const std::vector<T>& values,
     const Vector&         probabilities)
+: method_(CDF_SAMPLING)
 {
     for(int i = 0; i < probabilities.size(); i++)
     {
@@ -612,6 +882,7 @@ Categorical_distribution<T>::Categorical_distribution
     const T& max,
     const T& step
 )
+: method_(CDF_SAMPLING)
 {
     double p = 1.0 / static_cast<int>((max - min + 1) / step);
     for(T x = min; x <= max; x += step)
@@ -827,6 +1098,10 @@ private:
 
     friend Vector sample(const MV_gaussian_distribution&);
 
+    friend void sample_n(const MV_gaussian_distribution&, size_t, Matrix&);
+
+    friend Vector log_pdf_batch(const MV_gaussian_distribution&, const Matrix&);
+
 private:
     Vector mean;
     Matrix cov_mat;
@@ -28,6 +28,7 @@
 #include "n_cpp/n_solve.h"
 
 #include <cmath>
+#include <vector>
 
 #include <boost/math/special_functions/gamma.hpp>
 
@@ -98,6 +99,83 @@ double log_pdf(const MV_gaussian_distribution& P, const Vector& x)
 
 /* /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ */
 
+Vector log_pdf_batch(const MV_gaussian_distribution& P, const Matrix& X)
+{
+    const Vector& mu = P.mean;
+    const int k = mu.get_length();
+    const int n = X.get_num_rows();
+
+    IFT(X.get_num_cols() == k, Dimension_mismatch,
+        "Cannot compute joint pdf: points have incorrect dimension.");
+
+    Vector f(n);
+    if(n == 0)
+    {
+        return f;
+    }
+
+    // For a general covariance, solve L y = x - mu, where LL' = Sigma, so
+    // that (x - mu)' inv(Sigma) (x - mu) = y'y. For the independent case,
+    // L is diagonal.
+    std::vector<double> y(k);
+    double log_norm;
+    if(P.type == MV_gaussian_distribution::INDEPENDENT)
+    {
+        std::vector<double> inv_sd(k);
+        log_norm = 0.0;
+        for(int j = 0; j < k; j++)
+        {
+            inv_sd[j] = 1.0 / std::sqrt(P.cov_mat(j, j));
+            log_norm += std::log(inv_sd[j]);
+        }
+        log_norm -= (k * std::log(2 * M_PI)) / 2.0;
+
+        for(int i = 0; i < n; i++)
+        {
+            double msm = 0.0;
+            for(int j = 0; j < k; j++)
+            {
+                const double u = (X(i, j) - mu[j]) * inv_sd[j];
+                msm += u * u;
+            }
+            f[i] = log_norm - 0.5 * msm;
+        }
+
+        return f;
+    }
+
+    P.update_cov_chol();
+    P.update_log_abs_det();
+    const Matrix& L = P.cov_chol;
+    log_norm = -(0.5 * P.log_abs_det) - ((k * std::log(2 * M_PI)) / 2.0);
+
+    std::vector<double> inv_diag(k);
+    for(int j = 0; j < k; j++)
+    {
+        inv_diag[j] = 1.0 / L(j, j);
+    }
+
+    for(int i = 0; i < n; i++)
+    {
+        double msm = 0.0;
+        for(int j = 0; j < k; j++)
+        {
+            double s = X(i, j) - mu[j];
+            for(int l = 0; l < j; l++)
+            {
+                s -= L(j, l) * y[l];
+            }
+            y[j] = s * inv_diag[j];
+            msm += y[j] * y[j];
+        }
+        f[i] = log_norm - 0.5 * msm;
+    }
+
+    return f;
+}
+
+/* /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ */
+
 double pdf
 (
     const Chinese_restaurant_process& cpr,
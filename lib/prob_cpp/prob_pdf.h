@@ -294,6 +294,61 @@ inline double log_pdf(const Binomial_distribution& P, double k)
  */
 double log_pdf(const MV_gaussian_distribution& P, const Vector& x);
 
+/**
+ * @brief   Computes the log PDF of a univariate distribution at each
+ *          element of x.
+ *
+ * This simply calls log_pdf() on each element; please specialize for
+ * best results.
+ */
+template<class Distribution>
+inline Vector log_pdf_batch(const Distribution& P, const Vector& x)
+{
+    Vector f(x.get_length());
+    for(int i = 0; i < x.get_length(); i++)
+    {
+        f[i] = log_pdf(P, x[i]);
+    }
+
+    return f;
+}
+
+/**
+ * @brief   Computes the log PDF a normal distribution at each element of x.
+ *
+ * The normalizing constant is computed once, and the loop has no calls,
+ * so it can be vectorized by the compiler.
+ */
+inline Vector log_pdf_batch(const Gaussian_distribution& P, const Vector& x)
+{
+    const double mu = P.mean();
+    const double variance = P.standard_deviation() * P.standard_deviation();
+    const double log_norm = -(0.5 * log(2 * M_PI  * variance));
+    const double scale = 1.0 / (2 * variance);
+
+    const int n = x.get_length();
+    Vector f(n);
+    const double* px = n > 0 ? &x[0] : NULL;
+    double* pf = n > 0 ? &f[0] : NULL;
+    for(int i = 0; i < n; i++)
+    {
+        pf[i] = log_norm - (px[i] - mu) * (px[i] - mu) * scale;
+    }
+
+    return f;
+}
+
+/**
+ * @brief   Computes the log PDF a multivariate normal distribution at each
+ *          row of X.
+ *
+ * This gives the same values as calling log_pdf() on each row, but the
+ * Cholesky factor of the covariance matrix is computed once (and cached in
+ * P) and each point costs a triangular solve instead of a matrix-vector
+ * product with the inverse.
+ */
+Vector log_pdf_batch(const MV_gaussian_distribution& P, const Matrix& X);
+
 
 /**
  * @brief Computes the log PDF of a uniform distribution over the surface of the unit
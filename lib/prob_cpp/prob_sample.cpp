@@ -26,6 +26,7 @@
 #include "m_cpp/m_vector.h"
 
 #include <cmath>
+#include <vector>
 #include <boost/random.hpp>
 #include <boost/bind.hpp>
 
@@ -70,6 +71,60 @@ Vector sample(const MV_gaussian_distribution& dist)
 
 /* \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ */
 
+void sample_n(const MV_gaussian_distribution& dist, size_t n, Matrix& X)
+{
+    const int k = dist.get_dimension();
+    X.resize(n, k);
+    if(n == 0 || k == 0)
+    {
+        return;
+    }
+
+    // draw all the standard normal variates at once
+    std::vector<double> z(n * k);
+    sample_n(Gaussian_distribution(0.0, 1.0), z.size(), z.begin());
+
+    const Vector& mu = dist.mean;
+    if(dist.type == MV_gaussian_distribution::INDEPENDENT)
+    {
+        std::vector<double> sd(k);
+        for(int j = 0; j < k; j++)
+        {
+            sd[j] = std::sqrt(dist.cov_mat(j, j));
+        }
+
+        for(size_t i = 0; i < n; i++)
+        {
+            const double* zi = &z[i * k];
+            for(int j = 0; j < k; j++)
+            {
+                X(i, j) = mu[j] + sd[j] * zi[j];
+            }
+        }
+    }
+    else
+    {
+        // x = L z + mu, with L lower-triangular
+        dist.update_cov_chol();
+        const Matrix& L = dist.cov_chol;
+        for(size_t i = 0; i < n; i++)
+        {
+            const double* zi = &z[i * k];
+            for(int j = 0; j < k; j++)
+            {
+                double x = mu[j];
+                for(int l = 0; l <= j; l++)
+                {
+                    x += L(j, l) * zi[l];
+                }
+                X(i, j) = x;
+            }
+        }
+    }
+}
+
+/* \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ */
+
 Chinese_restaurant_process::Type sample(const Chinese_restaurant_process& crp)
 {
     const size_t n = crp.num_customers();
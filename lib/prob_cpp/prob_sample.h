@@ -231,20 +231,115 @@ inline double sample(const Geometric_distribution& dist)
 }
 #endif /* BOOST_VERSION < 10340 */
 
+/*============================================================================
+  batch sampling: sample_n(dist, n, out) writes n i.i.d. samples to out
+  ----------------------------------------------------------------------------*/
+
 /**
- * @brief   Sample from a categorical distribution
+ * @brief   Draw n samples from a boost random distribution, using a single
+ *          generator.
+ *
+ * Keeping the generator for the whole batch keeps the state of the
+ * underlying sampler (e.g., the second value of a Box-Muller pair in older
+ * versions of boost; newer versions use the Ziggurat method for normal and
+ * exponential variates) and avoids re-validating the parameters for every
+ * value.
  */
-template<class T>
-T sample(const Categorical_distribution<T>& dist)
+template<class Distribution_type, class OutputIterator>
+inline
+void sample_n_from_boost(const Distribution_type& d, size_t n, OutputIterator out)
 {
-    // TODO: This is currently O(log n), but approaches exist that
-    // make this constant, see the Alias Table methods described here:
-    // http://www.keithschwarz.com/darts-dice-coins/
-    // Also boost's discrete_distribution implements most of what
-    // this class does, so we could replace this with that.
-    double u = sample(Uniform_distribution());
+    typedef boost::variate_generator<Base_generator_type&, Distribution_type> Rng;
+    Rng rng(basic_rnd_gen, d);
+
+    for(size_t i = 0; i < n; i++, ++out)
+    {
+        *out = rng();
+    }
+}
+
+/**
+ * @brief   Draw n independent samples from a distribution.
+ *
+ * The generic version calls sample() n times; it is overloaded for the
+ * distributions for which a batch can be drawn faster.
+ *
+ * @param   out     Output iterator; e.g., a pointer into a Vector, or a
+ *                  std::back_inserter.
+ */
+template<class Distro, class OutputIterator>
+inline void sample_n(const Distro& dist, size_t n, OutputIterator out)
+{
+    for(size_t i = 0; i < n; i++, ++out)
+    {
+        *out = sample(dist);
+    }
+}
+
+/** @brief  Draw n samples from a uniform distribution. */
+template<class OutputIterator>
+inline void sample_n(const Uniform_distribution& dist, size_t n, OutputIterator out)
+{
+    sample_n_from_boost(
+        boost::uniform_real<>(dist.lower(), dist.upper()), n, out);
+}
+
+/** @brief  Draw n samples from a Gaussian distribution. */
+template<class OutputIterator>
+inline void sample_n(const Gaussian_distribution& dist, size_t n, OutputIterator out)
+{
+    sample_n_from_boost(
+        boost::normal_distribution<>(dist.mean(), dist.standard_deviation()),
+        n, out);
+}
+
+/** @brief  Draw n samples from an exponential distribution. */
+template<class OutputIterator>
+inline void sample_n(const Exponential_distribution& dist, size_t n, OutputIterator out)
+{
+    sample_n_from_boost(boost::exponential_distribution<>(dist.lambda()), n, out);
+}
+
+/** @brief  Draw n samples from a Gamma distribution. */
+template<class OutputIterator>
+inline void sample_n(const Gamma_distribution& dist, size_t n, OutputIterator out)
+{
+    sample_n_from_boost(
+        boost::gamma_distribution<>(dist.shape(), dist.scale()), n, out);
+}
+
+/** @brief  Draw n samples from a Chi-squared distribution. */
+template<class OutputIterator>
+inline void sample_n(const Chi_square_distribution& dist, size_t n, OutputIterator out)
+{
+    sample_n_from_boost(
+        boost::gamma_distribution<>(dist.degrees_of_freedom()/2.0, 2.0), n, out);
+}
+
+/** @brief  Draw n samples from a Poisson distribution. */
+template<class OutputIterator>
+inline void sample_n(const Poisson_distribution& dist, size_t n, OutputIterator out)
+{
+    sample_n_from_boost(boost::poisson_distribution<>(dist.mean()), n, out);
+}
 
-    using namespace boost;
+/**
+ * @brief   Draw n samples from a categorical distribution.
+ *
+ * The work that does not depend on the sample (e.g., building the alias
+ * table, or setting up the generators) is done once for the whole batch.
+ */
+template<class T, class OutputIterator>
+void sample_n
+(
+    const Categorical_distribution<T>& dist,
+    size_t n,
+    OutputIterator out
+)
+{
+    typedef Categorical_distribution<T> Cd;
+    typedef boost::variate_generator<Base_generator_type&, boost::uniform_real<> >
+        Uniform_rng;
 
     if(dist.cdf_.empty())
     {
@@ -252,25 +347,102 @@ T sample(const Categorical_distribution<T>& dist)
     }
 
     ASSERT(dist.cdf_.size() == dist.db.size()); // init_cdf() was called
-    double total_weight = dist.cdf_.back().second;
-    u *= total_weight;
+    Uniform_rng uniform(basic_rnd_gen, boost::uniform_real<>());
 
-    typedef Categorical_distribution<T> Cd;
-    typedef typename Cd::Cdf_pair Cdf_pair;
-    typedef typename std::vector<Cdf_pair>::const_iterator Const_iterator;
+    switch(dist.method_)
+    {
+        case Cd::ALIAS_SAMPLING:
+        {
+            // a separate draw for the column keeps the coin accurate
+            // when there are many items
+            typedef boost::variate_generator<Base_generator_type&,
+                                             boost::uniform_int<size_t> >
+                Column_rng;
+            dist.init_alias_table_();
+            Column_rng column(basic_rnd_gen,
+                              boost::uniform_int<size_t>(0, dist.cdf_.size() - 1));
+            for(size_t i = 0; i < n; i++, ++out)
+            {
+                size_t c = column();
+                *out = *dist.cdf_[dist.alias_lookup_(c, uniform())].first;
+            }
+            break;
+        }
+
+        case Cd::SUM_TREE_SAMPLING:
+        {
+            const double total_weight = dist.tree_[1];
+            if(total_weight <= 0.0)
+            {
+                KJB_THROW_2(Runtime_error,
+                            "Attempting to sample with zero probability mass.");
+            }
+
+            for(size_t i = 0; i < n; i++, ++out)
+            {
+                *out = *dist.cdf_[dist.tree_lookup_(uniform() * total_weight)].first;
+            }
+            break;
+        }
+
+        default:
+        {
+            const double total_weight = dist.cdf_.back().second;
+            for(size_t i = 0; i < n; i++, ++out)
+            {
+                *out = *dist.cdf_[dist.cdf_lookup_(uniform() * total_weight)].first;
+            }
+            break;
+        }
+    }
+}
 
-    // use binary search to find first element in CDF that exceeds u
-    Const_iterator r = 
-        std::lower_bound(
-            dist.cdf_.begin(),
-            dist.cdf_.end(),
-            u,
-            typename Cd::cdf_pair_less_than_scalar());
+/**
+ * @brief   Output iterator that keeps the address of the last element
+ *          assigned to it.
+ *
+ * sample_n() assigns the sampled elements of a categorical distribution
+ * themselves, so this lets sample() copy construct its result from the
+ * element, rather than assign it to a default constructed T.
+ */
+template<class T>
+class Categorical_element_address
+{
+public:
+    explicit Categorical_element_address(const T** address) :
+        address_(address)
+    {}
+
+    Categorical_element_address& operator*() { return *this; }
 
-    ASSERT(r != dist.cdf_.end());
+    Categorical_element_address& operator++() { return *this; }
 
-    return *r->first;
+    Categorical_element_address& operator++(int) { return *this; }
 
+    Categorical_element_address& operator=(const T& x)
+    {
+        *address_ = &x;
+        return *this;
+    }
+
+private:
+    const T** address_;
+};
+
+/**
+ * @brief   Sample from a categorical distribution
+ *
+ * This takes O(log n) or O(1) time, depending on the sampling method of
+ * the distribution; see Categorical_distribution. T need only be copy
+ * constructible.
+ */
+template<class T>
+T sample(const Categorical_distribution<T>& dist)
+{
+    const T* x = 0;
+    sample_n(dist, 1, Categorical_element_address<T>(&x));
+    ASSERT(x != 0);
+    return *x;
 }
 
 /**
@@ -295,6 +467,15 @@ Iterator element_uar(Iterator first, distance_type size)
  */
 Vector sample(const MV_gaussian_distribution& dist);
 
+/**
+ * @brief   Draw n samples from a multivariate normal distribution, one per
+ *          row of X.
+ *
+ * X is resized to n by the dimension of dist. The Cholesky factor of the
+ * covariance matrix is computed once (and cached in dist).
+ */
+void sample_n(const MV_gaussian_distribution& dist, size_t n, Matrix& X);
+
 inline double sample(const Log_normal_distribution& dist)
 {
     return exp(sample(dist.dist_));
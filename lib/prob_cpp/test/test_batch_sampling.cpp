@@ -0,0 +1,120 @@
+#include <l/l_init.h>
+#include <l_cpp/l_test.h>
+#include <m_cpp/m_matrix.h>
+#include <m_cpp/m_vector.h>
+#include <prob_cpp/prob_distribution.h>
+#include <prob_cpp/prob_sample.h>
+#include <prob_cpp/prob_pdf.h>
+#include <prob_cpp/prob_stat.h>
+#include <vector>
+#include <iterator>
+#include <cmath>
+
+using namespace std;
+using namespace kjb;
+
+template<class D>
+bool is_batch_good(const D& P, int nsamples, int nparams, double alpha, int nbins)
+{
+    vector<double> samples;
+    sample_n(P, nsamples, back_inserter(samples));
+    return samples.size() == static_cast<size_t>(nsamples)
+        && g_test(samples.begin(), samples.end(), P, alpha, nparams, nbins);
+}
+
+int main(int argc, char** argv)
+{
+    kjb_c::kjb_init();
+    seed_sampling_rand(1234);
+
+    int num_samples = 5000;
+    double alpha = 0.001;
+    int num_bins = 25;
+
+    // univariate batches
+    TEST_TRUE(is_batch_good(Normal_distribution(1.0, 2.0),
+                            num_samples, 2, alpha, num_bins));
+    TEST_TRUE(is_batch_good(Exponential_distribution(1.5),
+                            num_samples, 1, alpha, num_bins));
+    TEST_TRUE(is_batch_good(Gamma_distribution(2, 2.0),
+                            num_samples, 2, alpha, num_bins));
+    TEST_TRUE(is_batch_good(Chi_square_distribution(3),
+                            num_samples, 1, alpha, num_bins));
+    TEST_TRUE(is_batch_good(Uniform_distribution(-1.0, 3.0),
+                            num_samples, 2, alpha, num_bins));
+    // generic version
+    TEST_TRUE(is_batch_good(Beta_distribution(2, 5),
+                            num_samples, 2, alpha, num_bins));
+
+    // into a Vector
+    Vector v(100);
+    sample_n(Normal_distribution(0.0, 1.0), v.size(), v.begin());
+
+    // batched univariate log-pdf
+    Normal_distribution N(1.0, 2.0);
+    Vector lv = log_pdf_batch(N, v);
+    for(int i = 0; i < v.get_length(); i++)
+    {
+        TEST_TRUE(fabs(lv[i] - log_pdf(N, v[i])) < 1e-10);
+    }
+
+    // multivariate normal, full and diagonal covariance
+    Vector mu;
+    mu.set(1.0, 2.0, 3.0);
+
+    Matrix Sigma(3, 3);
+    Sigma(0, 0) = 3.9; Sigma(0, 1) = 3.1; Sigma(0, 2) = 1.9;
+    Sigma(1, 0) = 3.1; Sigma(1, 1) = 3.4; Sigma(1, 2) = 2.1;
+    Sigma(2, 0) = 1.9; Sigma(2, 1) = 2.1; Sigma(2, 2) = 2.2;
+
+    vector<MV_normal_distribution> mvns;
+    mvns.push_back(MV_normal_distribution(mu, Sigma));
+    mvns.push_back(MV_normal_distribution(mu, Vector().set(0.5, 1.0, 2.0)));
+
+    const size_t n = 20000;
+    for(size_t d = 0; d < mvns.size(); d++)
+    {
+        const MV_normal_distribution& P = mvns[d];
+        const Matrix& S = P.get_covariance_matrix();
+
+        Matrix X;
+        sample_n(P, n, X);
+        TEST_TRUE(X.get_num_rows() == static_cast<int>(n));
+        TEST_TRUE(X.get_num_cols() == 3);
+
+        // sample mean and covariance
+        Vector m(3, 0.0);
+        for(size_t i = 0; i < n; i++)
+        {
+            m += X.get_row(i);
+        }
+        m /= n;
+
+        Matrix C(3, 3, 0.0);
+        for(size_t i = 0; i < n; i++)
+        {
+            Vector y = X.get_row(i) - m;
+            C += outer_product(y, y);
+        }
+        C /= (n - 1);
+
+        for(int j = 0; j < 3; j++)
+        {
+            TEST_TRUE(fabs(m[j] - mu[j]) < 5 * sqrt(S(j, j) / n));
+            for(int k = 0; k < 3; k++)
+            {
+                TEST_TRUE(fabs(C(j, k) - S(j, k)) < 0.1 * S(j, j));
+            }
+        }
+
+        // batched log-pdf agrees with the one-at-a-time version
+        Vector f = log_pdf_batch(P, X);
+        TEST_TRUE(f.get_length() == static_cast<int>(n));
+        for(size_t i = 0; i < n; i += 97)
+        {
+            TEST_TRUE(fabs(f[i] - log_pdf(P, X.get_row(i))) < 1e-8);
+        }
+    }
+
+    RETURN_VICTORIOUSLY();
+}
@@ -0,0 +1,156 @@
+#include <l/l_init.h>
+#include <l_cpp/l_test.h>
+#include <prob_cpp/prob_distribution.h>
+#include <prob_cpp/prob_sample.h>
+#include <prob_cpp/prob_pdf.h>
+#include <vector>
+#include <map>
+#include <cmath>
+
+using namespace std;
+using namespace kjb;
+
+typedef Categorical_distribution<size_t> Cd;
+
+// an item type without a default constructor
+class Label
+{
+public:
+    explicit Label(int id) : id_(id) {}
+    int id() const { return id_; }
+    bool operator<(const Label& l) const { return id_ < l.id_; }
+
+private:
+    int id_;
+};
+
+// Pearson's statistic of n samples against the probabilities of P, compared
+// to a generous bound for its degrees of freedom
+bool is_sample_good(const Cd& P, const vector<size_t>& support, size_t n)
+{
+    vector<size_t> xs(n);
+    sample_n(P, n, xs.begin());
+
+    map<size_t, size_t> counts;
+    for(size_t i = 0; i < n; i++)
+    {
+        counts[xs[i]]++;
+    }
+
+    double chi2 = 0.0;
+    size_t dof = 0;
+    for(size_t k = 0; k < support.size(); k++)
+    {
+        double e = n * pdf(P, support[k]);
+        double o = counts[support[k]];
+        if(e == 0.0)
+        {
+            if(o != 0) return false;
+            continue;
+        }
+        chi2 += (o - e) * (o - e) / e;
+        dof++;
+    }
+
+    // items outside of the support
+    if(counts.size() > support.size()) return false;
+
+    // mean + 5 sd of a chi-squared with dof - 1 degrees of freedom
+    dof -= 1;
+    return chi2 < dof + 5 * sqrt(2.0 * dof);
+}
+
+int main(int argc, char** argv)
+{
+    kjb_c::kjb_init();
+    seed_sampling_rand(4321);
+
+    const size_t K = 50;
+    const size_t N = 50000;
+
+    vector<double> ws(K);
+    vector<size_t> support(K);
+    for(size_t k = 0; k < K; k++)
+    {
+        ws[k] = (k % 7 == 3) ? 0.0 : 1.0 + (k % 5) * (k % 3);
+        support[k] = k;
+    }
+
+    const Cd::Sampling_method methods[] = {
+        Cd::CDF_SAMPLING, Cd::ALIAS_SAMPLING, Cd::SUM_TREE_SAMPLING };
+
+    for(size_t m = 0; m < 3; m++)
+    {
+        Cd P(ws, 0);
+        P.set_sampling_method(methods[m]);
+        TEST_TRUE(P.get_sampling_method() == methods[m]);
+        TEST_TRUE(is_sample_good(P, support, N));
+
+        // change some weights, including to and from zero
+        P.set_weight(3, 5.0);
+        P.set_weight(4, 0.0);
+        P.set_weight(49, 0.25);
+        TEST_TRUE(P.get_weight(3) == 5.0);
+        TEST_TRUE(P.get_weight(4) == 0.0);
+
+        double total = 0.0;
+        for(size_t k = 0; k < K; k++) total += P.get_weight(k);
+        TEST_TRUE(fabs(pdf(P, size_t(3)) - 5.0 / total) < 1e-12);
+        TEST_TRUE(is_sample_good(P, support, N));
+
+        // a copy samples the same way
+        Cd Q = P;
+        TEST_TRUE(Q.get_sampling_method() == methods[m]);
+        TEST_TRUE(is_sample_good(Q, support, N));
+
+        // insert and erase items
+        vector<size_t> support2 = support;
+        for(size_t k = K; k < 3 * K; k++)
+        {
+            P.insert(k, 0.5);
+            support2.push_back(k);
+        }
+        P.erase(10);
+        TEST_TRUE(P.get_weight(10) == 0.0);
+        TEST_TRUE(is_sample_good(P, support2, N));
+
+        // switching the method keeps the distribution
+        P.set_sampling_method(methods[(m + 1) % 3]);
+        TEST_TRUE(is_sample_good(P, support2, N));
+
+        TEST_TRUE(sample(P) < 3 * K);
+    }
+
+    // single-item distributions
+    Cd one;
+    one.set_sampling_method(Cd::SUM_TREE_SAMPLING);
+    one.insert(7, 2.0);
+    TEST_TRUE(sample(one) == 7);
+    one.set_sampling_method(Cd::ALIAS_SAMPLING);
+    TEST_TRUE(sample(one) == 7);
+
+    // many small updates keep the sum tree consistent
+    Cd dyn(ws, 0);
+    dyn.set_sampling_method(Cd::SUM_TREE_SAMPLING);
+    for(size_t i = 0; i < 10000; i++)
+    {
+        dyn.set_weight(i % K, 0.1 + (i % 13));
+    }
+    TEST_TRUE(is_sample_good(dyn, support, N));
+
+    // sample() does not need a default constructor
+    map<Label, double> label_weights;
+    label_weights[Label(1)] = 0.0;
+    label_weights[Label(2)] = 1.0;
+    typedef Categorical_distribution<Label> Ld;
+    const Ld::Sampling_method label_methods[] = {
+        Ld::CDF_SAMPLING, Ld::ALIAS_SAMPLING, Ld::SUM_TREE_SAMPLING };
+    for(size_t m = 0; m < 3; m++)
+    {
+        Ld L(label_weights);
+        L.set_sampling_method(label_methods[m]);
+        TEST_TRUE(sample(L).id() == 2);
+    }
+
+    RETURN_VICTORIOUSLY();
+}
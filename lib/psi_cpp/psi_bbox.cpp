@@ -224,5 +224,13 @@ kjb::Color_histogram compute_color_histogram_from_box(const Bbox & box, const kj
             MIN_OF(box.get_right(), img.get_num_cols()-1), MIN_OF(box.get_top(),img.get_num_rows()-1) );
 }
 
+kjb::Color_histogram compute_color_histogram_from_box(const Bbox & box, const kjb::Integral_histogram & ihist)
+{
+    kjb::Color_histogram hist;
+    hist.compute_histogram(ihist, MAX_OF(0.0, box.get_left()), MAX_OF(0.0, box.get_bottom()),
+            MIN_OF(box.get_right(), ihist.get_num_cols()-1), MIN_OF(box.get_top(), ihist.get_num_rows()-1) );
+    return hist;
+}
+
 } // namespace psi
 } // namespace kjb
@@ -10,6 +10,7 @@
 #include <g_cpp/g_util.h>
 #include <g_cpp/g_cylinder.h>
 #include <i_cpp/i_color_histogram.h>
+#include <i_cpp/i_integral_histogram.h>
 
 #ifdef KJB_HAVE_UA_CARTWHEEL
 #include <MathLib/Capsule.h>
@@ -87,6 +88,12 @@ inline kjb::Vector project_point(const kjb::Perspective_camera& cam, const kjb::
 
 kjb::Color_histogram compute_color_histogram_from_box(const Bbox & box, const kjb::Image & img, unsigned int num_bins);
 
+/**
+ * @brief Same as above, from an integral histogram of the image (see
+ * kjb::get_rgb_bin_indices()); the number of bins is that of ihist.
+ */
+kjb::Color_histogram compute_color_histogram_from_box(const Bbox & box, const kjb::Integral_histogram & ihist);
+
 
 } // namespace psi
 } // namespace kjb
@@ -0,0 +1,585 @@
+/**
+ * @file
+ * @brief definition of class Heap_subtree_sum, a pooled subtree-sum heap.
+ *
+ * This is the "finished" alternative to the locator design of redblack.h that
+ * the README has been promising for a while.  Instead of chasing pointers
+ * among individually allocated nodes, all the records live in two contiguous
+ * arrays:  an implicit binary heap (the tree topology is given by the array
+ * index, so there are no links to store at all) and a record pool indexed by
+ * locator, with an index-linked free list threaded through the unused slots.
+ * Nothing is allocated per node; after the arrays grow to the working size of
+ * the queue, inserts, rekeys and erasures never touch the allocator again.
+ */
+/*
+ * $Id$
+ */
+
+#ifndef HEAPSUM_H_PREDOEHL_UOFARIZONAVISION
+#define HEAPSUM_H_PREDOEHL_UOFARIZONAVISION 1
+
+#include <l/l_sys_lib.h>
+#include <l/l_debug.h>
+#include <l_cpp/l_util.h>
+
+#include <qd_cpp/diprique.h>
+
+#include <vector>
+#include <limits>
+#include <algorithm>
+
+namespace kjb
+{
+namespace qd
+{
+
+
+/**
+ * @brief a binary heap that stores subtree sums of its keys in each node.
+ *
+ * This class implements the same interface as @ref Redblack_subtree_sum,
+ * namely the DijkstraPriorityQueue interface plus the root_sum() and
+ * loc_using_cumulative_key_sum() methods that @ref StochasticPriorityQueue
+ * relies on.  Because of that it can be used as the sub-queue type of the
+ * stochastic priority queue (see the template parameter of that class), or
+ * as a deterministic priority queue in its own right.
+ *
+ * @section hsssum Subtree sums in a heap
+ *
+ * Every heap slot stores the sum of the keys in the subtree rooted there.
+ * Heap operations only ever disturb the slots along one root-to-leaf path, so
+ * after a sift we recompute the sums of that path bottom-up, in O(log n)
+ * time.  Sums are always recomputed from the children, never adjusted by a
+ * delta, so roundoff error does not accumulate over millions of rekeys.
+ *
+ * @section hssorder Heap order
+ *
+ * If template parameter TOP_IS_MAX is false, this is a min-heap:  loc_min()
+ * and Dijkstra_extraction() take O(1) time, but loc_max() must scan the
+ * leaves, in O(n) time.  If TOP_IS_MAX is true it is the other way around.
+ * The stochastic priority queue stores probability weights, and wants the
+ * maximum weight, so it should use the max-heap (see @ref Max_heap_subtree_sum).
+ *
+ * @section hsscukes Cumulative key sums
+ *
+ * The red-black tree defines loc_using_cumulative_key_sum() with respect to
+ * an inorder (sorted) listing of its nodes.  A heap is not sorted, so here
+ * the listing is instead the inorder listing of the heap's binary tree.  Each
+ * record still owns an interval of length equal to its key, so if you pick
+ * the cumulative key sum uniformly from (0, root_sum()), the probability of
+ * drawing a record is its key divided by root_sum(), just as before.  That
+ * is the only property the stochastic priority queue needs.
+ *
+ * @section hssloc Locators
+ *
+ * Locators work just as in the red-black tree:  they are opaque, positive
+ * integers, they stay valid across rekeys, and they are recycled after an
+ * erasure.  Copying the queue preserves the locators.
+ */
+template < typename SATELLITE_TYPE, bool TOP_IS_MAX = false >
+class Heap_subtree_sum
+:   public DijkstraPriorityQueue< SATELLITE_TYPE >
+{
+public:
+    typedef SATELLITE_TYPE                                              Sat_tp;
+    typedef typename DijkstraPriorityQueue< SATELLITE_TYPE >::Key_tp    Key_tp;
+    typedef typename DijkstraPriorityQueue< SATELLITE_TYPE >::Loc_tp    Loc_tp;
+
+private:
+    enum
+    {
+        LOCATOR_BASE = 654000   ///< constant added to all pool indices
+    };
+
+    /// @brief sentinel pool index meaning "none" (end of free list, etc.)
+    static size_t NIL()
+    {
+        return std::numeric_limits< size_t >::max();
+    }
+
+    /// @brief heap slot:  key, subtree sum, and index of record in the pool
+    struct Slot
+    {
+        Key_tp  key,        ///< search key we use to organize the heap
+                sum;        ///< sum of keys in the subtree rooted here
+        size_t  rec;        ///< index of the record in m_pool
+
+        /// @brief ctor for a new leaf (subtree sum is just its own key)
+        Slot( const Key_tp& k, size_t r )
+        :   key( k ), sum( k ), rec( r )
+        {}
+    };
+
+    /// @brief pool record:  satellite data plus slot index (or free link)
+    struct Record
+    {
+        Sat_tp  sat;        ///< satellite data
+        size_t  pos;        ///< index in m_heap if live, else next free rec
+        bool    live;       ///< is this record in the heap?
+
+        /// @brief ctor
+        Record( const Sat_tp& s, size_t p, bool l )
+        :   sat( s ), pos( p ), live( l )
+        {}
+    };
+
+    std::vector< Slot > m_heap;     ///< implicit binary heap
+    std::vector< Record > m_pool;   ///< record pool, indexed by unbiased loc
+    size_t m_free;                  ///< head of free list threaded in m_pool
+
+
+    /// @brief heap ordering predicate:  should key a sit above key b?
+    static bool above( const Key_tp& a, const Key_tp& b )
+    {
+        return TOP_IS_MAX ? b < a : a < b;
+    }
+
+    /// @brief index of left child of slot i (might be out of range)
+    static size_t left_of( size_t i )
+    {
+        return 2 * i + 1;
+    }
+
+    /// @brief index of parent of slot i, i must be positive
+    static size_t parent_of( size_t i )
+    {
+        return ( i - 1 ) / 2;
+    }
+
+    /// @brief recompute the subtree sum of one slot from its children
+    void refresh( size_t i )
+    {
+        const size_t l = left_of( i ), r = l + 1, n = m_heap.size();
+        Key_tp s = m_heap[ i ].key;
+        if ( l < n )
+        {
+            s += m_heap[ l ].sum;
+        }
+        if ( r < n )
+        {
+            s += m_heap[ r ].sum;
+        }
+        m_heap[ i ].sum = s;
+    }
+
+    /// @brief recompute subtree sums from slot i up to the root
+    void refresh_to_root( size_t i )
+    {
+        for ( ; ; i = parent_of( i ) )
+        {
+            refresh( i );
+            if ( 0 == i )
+            {
+                break;
+            }
+        }
+    }
+
+    /// @brief exchange two heap slots, except for their subtree sums
+    void swap_slots( size_t i, size_t j )
+    {
+        std::swap( m_heap[ i ].key, m_heap[ j ].key );
+        std::swap( m_heap[ i ].rec, m_heap[ j ].rec );
+        m_pool[ m_heap[ i ].rec ].pos = i;
+        m_pool[ m_heap[ j ].rec ].pos = j;
+    }
+
+    /// @brief move slot i toward the root while it belongs above its parent
+    size_t sift_up( size_t i )
+    {
+        while ( i > 0 && above( m_heap[ i ].key, m_heap[ parent_of(i) ].key ) )
+        {
+            swap_slots( i, parent_of( i ) );
+            i = parent_of( i );
+        }
+        return i;
+    }
+
+    /// @brief move slot i toward the leaves while a child belongs above it
+    size_t sift_down( size_t i )
+    {
+        const size_t n = m_heap.size();
+        for ( size_t l = left_of( i ); l < n; l = left_of( i ) )
+        {
+            size_t c = l;
+            if ( l + 1 < n && above( m_heap[ l + 1 ].key, m_heap[ l ].key ) )
+            {
+                c = l + 1;
+            }
+            if ( ! above( m_heap[ c ].key, m_heap[ i ].key ) )
+            {
+                break;
+            }
+            swap_slots( i, c );
+            i = c;
+        }
+        return i;
+    }
+
+    /**
+     * @brief restore heap order and subtree sums after slot i changed its key
+     *
+     * Every slot whose key changed lies on the path from the deepest slot
+     * visited to the root, so one bottom-up refresh pass fixes all the sums.
+     */
+    void fix( size_t i )
+    {
+        const size_t up = sift_up( i );
+        refresh_to_root( up == i ? sift_down( i ) : i );
+    }
+
+    /// @brief obtain an unused record from the pool, growing it if necessary
+    size_t alloc_record( const Sat_tp& sat )
+    {
+        if ( NIL() == m_free )
+        {
+            m_pool.push_back( Record( sat, NIL(), true ) );
+            return m_pool.size() - 1;
+        }
+        const size_t r = m_free;
+        m_free = m_pool[ r ].pos;
+        m_pool[ r ].sat = sat;
+        m_pool[ r ].live = true;
+        return r;
+    }
+
+    /// @brief return record r to the free list
+    void free_record( size_t r )
+    {
+        m_pool[ r ].live = false;
+        m_pool[ r ].pos = m_free;
+        m_free = r;
+    }
+
+    /// @brief translate a locator into a live pool index, or NIL() if bad
+    size_t look_up_locator( Loc_tp loc ) const
+    {
+        if ( loc < LOCATOR_BASE )
+        {
+            return NIL();
+        }
+        const size_t r = loc - LOCATOR_BASE;
+        return r < m_pool.size() && m_pool[ r ].live ? r : NIL();
+    }
+
+    /// @brief locator of the record in heap slot i
+    Loc_tp loc_at( size_t i ) const
+    {
+        return LOCATOR_BASE + m_heap[ i ].rec;
+    }
+
+    /// @brief locator of the bottom element, found by scanning the leaves
+    Loc_tp loc_bottom() const
+    {
+        const size_t n = m_heap.size();
+        if ( 0 == n )
+        {
+            return 0;
+        }
+        size_t best = n / 2;
+        for ( size_t i = best + 1; i < n; ++i )
+        {
+            if ( above( m_heap[ best ].key, m_heap[ i ].key ) )
+            {
+                best = i;
+            }
+        }
+        return loc_at( best );
+    }
+
+public:
+
+    /// @brief default ctor
+    Heap_subtree_sum()
+    :   m_free( NIL() )
+    {}
+
+
+    /**
+     * @brief allocate room for n records so the queue won't grow later.
+     *
+     * This is optional, but if you know the graph size in advance, it means
+     * that a whole run of Dijkstra's algorithm performs no allocation at all.
+     */
+    void reserve( size_t n )
+    {
+        m_heap.reserve( n );
+        m_pool.reserve( n );
+    }
+
+
+    /**
+     * @brief discard all records, but keep the storage for reuse.
+     *
+     * @post This invalidates all locators.
+     */
+    void clear()
+    {
+        m_heap.clear();
+        m_pool.clear();
+        m_free = NIL();
+    }
+
+
+    /// @brief insert a new key+value pair in O(log n) time
+    Loc_tp insert( const Key_tp& key, const Sat_tp& sat )
+    {
+        const size_t r = alloc_record( sat );
+        m_pool[ r ].pos = m_heap.size();
+        m_heap.push_back( Slot( key, r ) );
+        fix( m_heap.size() - 1 );
+        return LOCATOR_BASE + r;
+    }
+
+
+    /// @brief insert a record with a key of "infinity" (as does redblack.h)
+    Loc_tp ins_max_key( const Sat_tp& sat )
+    {
+        return insert( std::numeric_limits< Key_tp >::max(), sat );
+    }
+
+
+    /**
+     * @brief look up the key and satellite data of a record by its locator
+     * @param[in] query_loc     Locator to look for
+     * @param[out] key_out      Optional output pointer for the key
+     * @param[out] sat_out      Optional output pointer for the satellite data
+     * @return true iff the locator points to a valid record
+     */
+    bool access_loc( Loc_tp query_loc, Key_tp* key_out, Sat_tp* sat_out ) const
+    {
+        const size_t r = look_up_locator( query_loc );
+        if ( NIL() == r )
+        {
+            return false;
+        }
+        if ( key_out )
+        {
+            *key_out = m_heap[ m_pool[ r ].pos ].key;
+        }
+        if ( sat_out )
+        {
+            *sat_out = m_pool[ r ].sat;
+        }
+        return true;
+    }
+
+
+    /**
+     * @brief remove the record indicated by a locator, in O(log n) time
+     * @return true iff the locator points to a valid record
+     * @warning Locators get recycled! Don't erase the same locator twice!
+     */
+    bool erase_loc( Loc_tp query_loc )
+    {
+        const size_t r = look_up_locator( query_loc );
+        if ( NIL() == r )
+        {
+            return false;
+        }
+        const size_t i = m_pool[ r ].pos, last = m_heap.size() - 1;
+        free_record( r );
+
+        if ( i == last )
+        {
+            m_heap.pop_back();
+            if ( last > 0 )
+            {
+                refresh_to_root( parent_of( last ) );
+            }
+            return true;
+        }
+
+        // fill the hole with the last slot, then repair both paths
+        m_heap[ i ].key = m_heap[ last ].key;
+        m_heap[ i ].rec = m_heap[ last ].rec;
+        m_pool[ m_heap[ i ].rec ].pos = i;
+        m_heap.pop_back();
+        refresh_to_root( parent_of( last ) );
+        fix( i );
+        return true;
+    }
+
+
+    /// @brief change the key of a record, in O(log n) time
+    bool rekey_loc( Loc_tp query_loc, const Key_tp& newkey )
+    {
+        const size_t r = look_up_locator( query_loc );
+        if ( NIL() == r )
+        {
+            return false;
+        }
+        const size_t i = m_pool[ r ].pos;
+        m_heap[ i ].key = newkey;
+        fix( i );
+        return true;
+    }
+
+
+    /// @brief locator of a record with minimum key, or 0 if empty
+    Loc_tp loc_min() const
+    {
+        if ( TOP_IS_MAX )
+        {
+            return loc_bottom();
+        }
+        return is_empty() ? 0 : loc_at( 0 );
+    }
+
+
+    /// @brief locator of a record with maximum key, or 0 if empty
+    Loc_tp loc_max() const
+    {
+        if ( ! TOP_IS_MAX )
+        {
+            return loc_bottom();
+        }
+        return is_empty() ? 0 : loc_at( 0 );
+    }
+
+
+    /// @brief return the number of records in the heap
+    size_t size() const
+    {
+        return m_heap.size();
+    }
+
+
+    /// @brief return whether the size is zero
+    bool is_empty() const
+    {
+        return m_heap.empty();
+    }
+
+
+    /// @brief return the sum of all keys, in O(1) time
+    Key_tp root_sum() const
+    {
+        return is_empty() ? 0 : m_heap[ 0 ].sum;
+    }
+
+
+    /**
+     * @brief fetch a record based on a cumulative sum of keys, O(log n) time
+     * @param cumulative_keysum value we want to find or minimally exceed.
+     * @pre keys are all positive, or else behavior is undefined
+     * @return locator of record j such that s_{j-1} < cumulative_keysum <= s_j
+     *         where s is the cumulative key sum in the inorder listing of the
+     *         heap's binary tree (see @ref hsscukes), or 0 if the heap is empty.
+     *
+     * Degenerate cases are handled as in the red-black tree:  a nonpositive
+     * input gets the first record of the listing, and an input of root_sum()
+     * or more gets the last.
+     */
+    Loc_tp loc_using_cumulative_key_sum( Key_tp cumulative_keysum ) const
+    {
+        const size_t n = m_heap.size();
+        if ( 0 == n )
+        {
+            return 0;
+        }
+        size_t i = 0;
+        for ( ; ; )
+        {
+            const size_t l = left_of( i ), r = l + 1;
+            if ( l < n )
+            {
+                if ( cumulative_keysum <= m_heap[ l ].sum )
+                {
+                    i = l;
+                    continue;
+                }
+                cumulative_keysum -= m_heap[ l ].sum;
+            }
+            if ( cumulative_keysum <= m_heap[ i ].key || n <= r )
+            {
+                break;
+            }
+            cumulative_keysum -= m_heap[ i ].key;
+            i = r;
+        }
+        return loc_at( i );
+    }
+
+
+    /// @brief proxy to make this and a stochastic pri queue work alike
+    Loc_tp Dijkstra_extraction() const
+    {
+        return loc_min();
+    }
+
+
+    /**
+     * @brief check heap order, sums and locator bookkeeping, in linear time.
+     *
+     * Subtree sums are compared with a relative tolerance since the order of
+     * summation in this check differs from the order used by the heap.
+     */
+    bool heap_valid_in_linear_time() const
+    {
+        const size_t n = m_heap.size();
+        size_t live_count = 0;
+        for ( size_t r = 0; r < m_pool.size(); ++r )
+        {
+            if ( m_pool[ r ].live )
+            {
+                ++live_count;
+                if ( n <= m_pool[ r ].pos || m_heap[ m_pool[ r ].pos ].rec != r )
+                {
+                    return false;
+                }
+            }
+        }
+        if ( live_count != n )
+        {
+            return false;
+        }
+        for ( size_t i = n; i-- > 0; )
+        {
+            if ( i > 0 && above( m_heap[ i ].key, m_heap[ parent_of(i) ].key ) )
+            {
+                return false;
+            }
+            const size_t l = left_of( i ), r = l + 1;
+            Key_tp s = m_heap[ i ].key;
+            s += l < n ? m_heap[ l ].sum : 0;
+            s += r < n ? m_heap[ r ].sum : 0;
+            const Key_tp tol = 1e-4f * std::max( Key_tp( 1 ), s );
+            if ( m_heap[ i ].sum < s - tol || s + tol < m_heap[ i ].sum )
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+
+    /// @brief swap the contents of two heaps (locators follow their records)
+    void swap( Heap_subtree_sum& other )
+    {
+        m_heap.swap( other.m_heap );
+        m_pool.swap( other.m_pool );
+        std::swap( m_free, other.m_free );
+    }
+};
+
+
+/**
+ * @brief max-heap flavor of Heap_subtree_sum, with a single template parameter
+ *
+ * This is the type to plug into StochasticPriorityQueue, which stores
+ * probability weights and wants the largest one at the top:
+ * @code
+ * typedef StochasticPriorityQueue< int, -3, 2, Max_heap_subtree_sum > SPQ;
+ * @endcode
+ */
+template < typename SATELLITE_TYPE >
+class Max_heap_subtree_sum
+:   public Heap_subtree_sum< SATELLITE_TYPE, true >
+{};
+
+
+}
+}
+
+#endif /* HEAPSUM_H_PREDOEHL_UOFARIZONAVISION */
@@ -123,8 +123,20 @@ namespace qd
  * draw elements from "neverland," which contains elements that have
  * infinite energy.  Elements can be rekeyed and consequently move from one
  * sub-queue to another.
+ *
+ * The container used for the sub-queues is the template parameter SUBQUEUE.
+ * It defaults to @ref Redblack_subtree_sum, but @ref Max_heap_subtree_sum
+ * (in heapsum.h) offers the same operations from two flat arrays, with no
+ * per-node allocation, and is usually faster on big pixel graphs.
+ * Both store their weights so that loc_max() is cheap, which the
+ * extraction methods below rely upon.
  */
-template< typename SATELLITE_TYPE, int POWERLAW_NUM, int POWERLAW_DEN >
+template<
+    typename SATELLITE_TYPE,
+    int POWERLAW_NUM,
+    int POWERLAW_DEN,
+    template< typename > class SUBQUEUE = Redblack_subtree_sum
+>
 class StochasticPriorityQueue
 :   public DijkstraPriorityQueue< SATELLITE_TYPE >
 {
@@ -182,7 +194,7 @@ private:
     };
 
     /// tree data structure used for sub-queues of the overall queue
-    typedef Redblack_subtree_sum< SatLoc > RBT;
+    typedef SUBQUEUE< SatLoc > RBT;
 
     enum {
         LOC_BIAS = 12345    ///< bias all external locators to make it opaque
@@ -0,0 +1,188 @@
+/**
+ * @file
+ * @brief benchmark of the pooled heap vs. the red-black tree in (quasi-)Dijkstra
+ *
+ * Usage:  bench_heapsum [W]
+ *
+ * This runs single-source Dijkstra and quasi-Dijkstra over a W x W grid graph
+ * (8-way connectivity, random positive edge weights, default W = 1000) using
+ * each of these priority queues:
+ * - Redblack_subtree_sum                         (deterministic, locators)
+ * - Heap_subtree_sum                             (deterministic, pooled)
+ * - StochasticPriorityQueue on Redblack_subtree_sum   (stochastic, locators)
+ * - StochasticPriorityQueue on Max_heap_subtree_sum   (stochastic, pooled)
+ * and prints the wall-clock time of each.  The two deterministic runs must
+ * produce the same distances, which is checked as a sanity test.
+ */
+/*
+ * $Id$
+ */
+
+#include <l/l_init.h>
+#include <l/l_sys_time.h>
+#include <l/l_sys_rand.h>
+#include <l_cpp/l_exception.h>
+#include <qd_cpp/redblack.h>
+#include <qd_cpp/heapsum.h>
+#include <qd_cpp/stoprique.h>
+
+#include <vector>
+#include <iostream>
+#include <cstdlib>
+#include <cmath>
+
+namespace {
+
+/// @brief grid graph with random edge weights, stored per vertex and direction
+class Grid
+{
+    int m_w;
+    std::vector< float > m_wt;
+
+public:
+    enum { DEGREE = 8 };
+
+    Grid( int w )
+    :   m_w( w ),
+        m_wt( size_t( w ) * w * DEGREE )
+    {
+        for ( size_t iii = 0; iii < m_wt.size(); ++iii )
+        {
+            m_wt[ iii ] = 0.5f + float( kjb_c::kjb_rand() );
+        }
+    }
+
+    int size() const
+    {
+        return m_w * m_w;
+    }
+
+    /// @brief neighbor of v in direction d, or -1 if off the grid
+    int neighbor( int v, int d ) const
+    {
+        static const int dx[ DEGREE ] = { -1, 1, 0, 0, -1, 1, -1, 1 },
+                         dy[ DEGREE ] = { 0, 0, -1, 1, -1, -1, 1, 1 };
+        const int x = v % m_w + dx[ d ], y = v / m_w + dy[ d ];
+        return 0 <= x && x < m_w && 0 <= y && y < m_w ? x + y * m_w : -1;
+    }
+
+    float weight( int v, int d ) const
+    {
+        return m_wt[ size_t( v ) * DEGREE + d ];
+    }
+};
+
+
+/// @brief Dijkstra (or quasi-Dijkstra) from vertex 0, returns the distances
+template< typename PQ >
+std::vector< float > run( const Grid& grid )
+{
+    typedef typename PQ::Loc_tp Loc_tp;
+    typedef typename PQ::Key_tp Key_tp;
+    const Loc_tp NO_LOC = 0;
+
+    std::vector< float > dist( grid.size(), std::numeric_limits<float>::max() );
+    std::vector< Loc_tp > locs( grid.size() );
+    PQ pq;
+
+    dist[ 0 ] = 0;
+    locs[ 0 ] = pq.insert( 0, 0 );
+    for ( int v = 1; v < grid.size(); ++v )
+    {
+        locs[ v ] = pq.ins_max_key( v );
+    }
+
+    while ( ! pq.is_empty() )
+    {
+        const Loc_tp lowloc = pq.Dijkstra_extraction();
+        int v = -1;
+        Key_tp dv;
+        if ( NO_LOC == lowloc || ! pq.access_loc( lowloc, & dv, & v ) )
+        {
+            break; // only unreachable ("infinite") vertices remain
+        }
+        pq.erase_loc( lowloc );
+        locs[ v ] = NO_LOC;
+
+        for ( int d = 0; d < Grid::DEGREE; ++d )
+        {
+            const int u = grid.neighbor( v, d );
+            if ( u < 0 || NO_LOC == locs[ u ] )
+            {
+                continue;
+            }
+            const float du = dist[ v ] + grid.weight( v, d );
+            if ( du < dist[ u ] )
+            {
+                dist[ u ] = du;
+                pq.rekey_loc( locs[ u ], du );
+            }
+        }
+    }
+    return dist;
+}
+
+
+/// @brief time one run, in milliseconds, and print it
+template< typename PQ >
+std::vector< float > timed( const Grid& grid, const char* name )
+{
+    KJB(EPETE(kjb_c::init_real_time()));
+    std::vector< float > dist = run< PQ >( grid );
+    const long ms = kjb_c::get_real_time();
+    std::cout << name << ": " << ms << " ms\n";
+    return dist;
+}
+
+
+int main2( int argc, const char* const* argv )
+{
+    using namespace kjb::qd;
+
+    const int w = 1 < argc ? std::atoi( argv[ 1 ] ) : 1000;
+    if ( w < 2 )
+    {
+        std::cerr << "usage: " << argv[ 0 ] << " [W]\n";
+        return EXIT_FAILURE;
+    }
+    kjb_c::kjb_seed_rand_2( 1234 );
+    const Grid grid( w );
+    std::cout << "grid graph with " << grid.size() << " vertices\n";
+
+    const std::vector< float >
+        d1 = timed< Redblack_subtree_sum< int > >( grid, "redblack    "),
+        d2 = timed< Heap_subtree_sum< int > >( grid, "heap        ");
+
+    timed< StochasticPriorityQueue< int, -3, 2 > >( grid, "spq/redblack");
+    timed< StochasticPriorityQueue< int, -3, 2, Max_heap_subtree_sum > >(
+                                                        grid, "spq/heap    ");
+
+    for ( size_t iii = 0; iii < d1.size(); ++iii )
+    {
+        if ( d1[ iii ] != d2[ iii ] )
+        {
+            std::cerr << "deterministic distances disagree at " << iii << '\n';
+            return EXIT_FAILURE;
+        }
+    }
+    return EXIT_SUCCESS;
+}
+
+} // end anonymous ns
+
+
+int main( int argc, const char* const* argv )
+{
+    int rc = EXIT_FAILURE;
+    KJB(EPETE(kjb_init()));
+    try
+    {
+        rc = main2( argc, argv );
+    }
+    catch (const kjb::Exception& e)
+    {
+        e.print_details_exit();
+    }
+    kjb_c::kjb_cleanup();
+    return rc;
+}
@@ -0,0 +1,256 @@
+/**
+ * @file
+ * @brief unit test program for the pooled subtree-sum heap
+ *
+ * This mirrors a random sequence of insertions, rekeys and erasures in a
+ * plain std::map and checks that the heap agrees with it, and that the heap
+ * still satisfies its own invariants, after every operation.  It also checks
+ * that a stochastic priority queue built on the heap draws records with the
+ * right frequencies.
+ */
+/*
+ * $Id$
+ */
+
+#include <l/l_init.h>
+#include <l/l_error.h>
+#include <l/l_global.h>
+#include <l/l_sys_rand.h>
+#include <l_cpp/l_test.h>
+#include <qd_cpp/heapsum.h>
+#include <qd_cpp/stoprique.h>
+
+#include <vector>
+#include <map>
+#include <cmath>
+
+namespace {
+
+int ALOT = -1;
+
+typedef kjb::qd::Heap_subtree_sum< int > Heap;
+typedef kjb::qd::Max_heap_subtree_sum< int > MaxHeap;
+typedef std::map< Heap::Loc_tp, std::pair< float, int > > Model;
+
+
+/// @brief return a random float value in interval (0,1]
+float rand_unit()
+{
+    return ( 1 + rand() ) / ( 1.0f + RAND_MAX );
+}
+
+
+/// @brief check that every record of the model is found in the heap
+template< typename H >
+int agrees( const H& heap, const Model& model )
+{
+    TEST_TRUE( heap.heap_valid_in_linear_time() );
+    TEST_TRUE( heap.size() == model.size() );
+    float sum = 0;
+    for ( Model::const_iterator i = model.begin(); i != model.end(); ++i )
+    {
+        float key;
+        int sat;
+        TEST_TRUE( heap.access_loc( i -> first, & key, & sat ) );
+        TEST_TRUE( key == i -> second.first );
+        TEST_TRUE( sat == i -> second.second );
+        sum += key;
+    }
+    TEST_TRUE( std::fabs( heap.root_sum() - sum ) <= 1e-3 * ( 1 + sum ) );
+    return EXIT_SUCCESS;
+}
+
+
+/// @brief random mix of operations, compared against a std::map
+template< typename H >
+int test_random_ops()
+{
+    H heap;
+    Model model;
+    std::vector< typename H::Loc_tp > locs;
+
+    for ( int iii = 0; iii < ALOT; ++iii )
+    {
+        const int op = rand() % 4;
+        if ( 0 == op || 1 == op || locs.empty() )
+        {
+            const float key = rand_unit();
+            const typename H::Loc_tp loc = heap.insert( key, iii );
+            TEST_TRUE( 0 == model.count( loc ) );
+            model[ loc ] = std::make_pair( key, iii );
+            locs.push_back( loc );
+        }
+        else if ( 2 == op )
+        {
+            const size_t j = rand() % locs.size();
+            const float key = rand_unit();
+            TEST_TRUE( heap.rekey_loc( locs[ j ], key ) );
+            model[ locs[ j ] ].first = key;
+        }
+        else
+        {
+            const size_t j = rand() % locs.size();
+            TEST_TRUE( heap.erase_loc( locs[ j ] ) );
+            TEST_FALSE( heap.access_loc( locs[ j ], 00, 00 ) );
+            model.erase( locs[ j ] );
+            locs[ j ] = locs.back();
+            locs.pop_back();
+        }
+
+        if ( iii % 97 == 0 && agrees( heap, model ) != EXIT_SUCCESS )
+        {
+            return EXIT_FAILURE;
+        }
+    }
+    return agrees( heap, model );
+}
+
+
+/// @brief min-heap returns the true minimum, max-heap the true maximum
+int test_extrema()
+{
+    Heap mnh;
+    MaxHeap mxh;
+    float lo = 2, hi = -1;
+    for ( int iii = 0; iii < 1000; ++iii )
+    {
+        const float key = rand_unit();
+        mnh.insert( key, iii );
+        mxh.insert( key, iii );
+        lo = std::min( lo, key );
+        hi = std::max( hi, key );
+    }
+    float key;
+    TEST_TRUE( mnh.access_loc( mnh.Dijkstra_extraction(), & key, 00 ) );
+    TEST_TRUE( lo == key );
+    TEST_TRUE( mnh.access_loc( mnh.loc_max(), & key, 00 ) );
+    TEST_TRUE( hi == key );
+    TEST_TRUE( mxh.access_loc( mxh.loc_max(), & key, 00 ) );
+    TEST_TRUE( hi == key );
+    TEST_TRUE( mxh.access_loc( mxh.loc_min(), & key, 00 ) );
+    TEST_TRUE( lo == key );
+
+    // drain the min heap in order
+    float prev = -1;
+    while ( ! mnh.is_empty() )
+    {
+        const Heap::Loc_tp loc = mnh.loc_min();
+        TEST_TRUE( mnh.access_loc( loc, & key, 00 ) );
+        TEST_TRUE( prev <= key );
+        prev = key;
+        TEST_TRUE( mnh.erase_loc( loc ) );
+    }
+    TEST_TRUE( 0 == mnh.Dijkstra_extraction() );
+    return EXIT_SUCCESS;
+}
+
+
+/// @brief cumulative key sums must assign each record a mass equal to its key
+int test_cukes()
+{
+    Heap heap;
+    std::vector< float > keys;
+    for ( int iii = 0; iii < 50; ++iii )
+    {
+        keys.push_back( float( iii + 1 ) );
+        heap.insert( keys.back(), iii );
+    }
+
+    // sweep the cumulative sum through (0, S] in unit steps
+    std::vector< int > hits( keys.size(), 0 );
+    const int total = int( heap.root_sum() );
+    TEST_TRUE( total == 50 * 51 / 2 );
+    for ( int s = 1; s <= total; ++s )
+    {
+        int sat;
+        TEST_TRUE( heap.access_loc(
+                    heap.loc_using_cumulative_key_sum( s - 0.5f ), 00, & sat ));
+        hits.at( sat ) += 1;
+    }
+    for ( size_t iii = 0; iii < keys.size(); ++iii )
+    {
+        TEST_TRUE( hits[ iii ] == int( keys[ iii ] ) );
+    }
+    return EXIT_SUCCESS;
+}
+
+
+/// @brief stochastic queue over the heap draws in proportion to weight
+int test_spq()
+{
+    typedef kjb::qd::StochasticPriorityQueue< int, -1, 1,
+                                    kjb::qd::Max_heap_subtree_sum > SPQ;
+    SPQ spq;
+    spq.ins_max_key( 99 );
+    spq.insert( 1, 0 );   // weight 1
+    spq.insert( 4, 1 );   // weight 1/4
+    TEST_TRUE( 3 == spq.size() );
+
+    const int n = 40000;
+    int count0 = 0;
+    for ( int iii = 0; iii < n; ++iii )
+    {
+        int sat = -1;
+        TEST_TRUE( spq.access_loc( spq.Dijkstra_extraction(), 00, & sat ) );
+        TEST_TRUE( 0 == sat || 1 == sat );
+        count0 += ( 0 == sat );
+    }
+    // expected fraction is 0.8, binomial std. dev. is 0.002
+    TEST_TRUE( std::fabs( count0 / double( n ) - 0.8 ) < 0.02 );
+
+    // zero energy goes to alwaysland and is drawn first
+    const SPQ::Loc_tp zloc = spq.insert( 0, 7 );
+    TEST_TRUE( zloc == spq.Dijkstra_extraction() );
+    TEST_TRUE( spq.erase_loc( zloc ) );
+    return EXIT_SUCCESS;
+}
+
+
+int main2( int argc, const char* const* argv )
+{
+    typedef int (*PTest)(void);
+
+    PTest suite[] = { test_random_ops< Heap >, test_random_ops< MaxHeap >,
+                      test_extrema, test_cukes, test_spq, 00 };
+
+    int test_factor = 1;
+    KJB(EPETE(scan_time_factor(argv[1], &test_factor)));
+
+    for( ALOT = 1000; test_factor > 0; --test_factor )
+    {
+        ALOT *= 10;
+    }
+
+    srand( 7654321 );
+    kjb_c::kjb_seed_rand_2( 7654321 );
+    for( PTest* p = suite; *p; ++p )
+    {
+        int rc = (*p)();
+        if ( rc != EXIT_SUCCESS )
+        {
+            KJB(TEST_PSE(( "failure in test index %d.\n", p - suite )));
+            return rc;
+        }
+    }
+
+    RETURN_VICTORIOUSLY();
+}
+
+} // end anonymous ns
+
+
+int main( int argc, const char* const* argv )
+{
+    int rc;
+    KJB(EPETE(kjb_init()));
+    try
+    {
+        rc = main2( argc, argv );
+    }
+    catch (const kjb::Exception& e)
+    {
+        e.print_details_exit();
+    }
+    kjb_c::kjb_cleanup();
+    return rc;
+}
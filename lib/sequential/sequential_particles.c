@@ -19,6 +19,7 @@
 * =========================================================================== */
 
 #include "l/l_incl.h"
+#include "l_mt/l_mt_pthread.h"
 #include "sequential/sequential_particles.h"
 #include "sample/sample_incl.h"
 
@@ -28,7 +29,441 @@ extern "C" {
 
 /*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\   */
 
-static int resample(Vector_vector* original_samples, const Vector* distribution);
+typedef struct Likelihood_job
+{
+    Particle_batch_log_likelihood batch_log_likelihood;
+    const void*                   context;
+    Vector*                       log_likelihoods;
+    const Vector*                 y;
+    const Vector_vector*          particles;
+    int                           begin;
+    int                           end;
+    int                           result;
+}
+Likelihood_job;
+
+/*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\   */
+
+static int propagate_particles(SIR_filter* filter, const Vector* y);
+
+static int evaluate_log_likelihoods
+(
+    SIR_filter*          filter,
+    const Vector*        y,
+    const Vector_vector* particles
+);
+
+static void* likelihood_job_main(void* job_ptr);
+
+static int per_particle_log_likelihood
+(
+    Vector*              log_likelihoods,
+    const Vector*        y,
+    const Vector_vector* particles,
+    int                  begin,
+    int                  end,
+    const void*          context
+);
+
+static int select_ancestors(SIR_filter* filter);
+
+static void sorted_draws
+(
+    int*          ancestors,
+    int           count,
+    const Vector* w,
+    double        total,
+    int           systematic
+);
+
+static int apply_ancestors(SIR_filter* filter);
+
+/*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\   */
+
+/* =============================================================================
+ *                              create_SIR_filter
+ *
+ * Creates an online SIR particle filter
+ *
+ * This routine creates a SIR (sample-importance-resample) particle filter with
+ * L particles, to be advanced one observation at a time with
+ * update_SIR_filter. Unlike SIR_particle_filter, only the current population
+ * (and, if requested with set_SIR_filter_lag, a fixed number of past ones) is
+ * kept, so memory does not grow with the length of the sequence.
+ *
+ * The callbacks have the same meaning and signatures as for
+ * SIR_particle_filter: sample_from_prior draws from p(x_k | x_{k-1}) (with
+ * NULL for x_{k-1} at the first step) and likelihood evaluates p(y_k | x_k).
+ * A batched callback may be installed instead of likelihood with
+ * set_SIR_filter_batch_likelihood, in which case likelihood may be NULL.
+ *
+ * The filter starts out with systematic resampling whenever the effective
+ * sample size drops to below half of L, and with a single thread; see
+ * set_SIR_filter_resampling and set_SIR_filter_num_threads.
+ *
+ * The routine free_SIR_filter should be used to dispose of the filter.
+ *
+ * Returns:
+ *     A pointer to the new filter on success, and NULL on failure, with an
+ *     appropriate error message being set.
+ *
+ * Index: LDS
+ *
+ * -----------------------------------------------------------------------------
+*/
+
+SIR_filter* create_SIR_filter
+(
+    int                  L,
+    int                  (*sample_from_prior)(Vector**, const Vector*, const void*),
+    const void*          prior_context,
+    int                  (*likelihood)(double*, const Vector*, const Vector*, const void*),
+    const void*          likelihood_context
+)
+{
+    SIR_filter* filter;
+
+    if(L <= 0 || sample_from_prior == NULL)
+    {
+        SET_ARGUMENT_BUG();
+        return NULL;
+    }
+
+    NRN(filter = TYPE_MALLOC(SIR_filter));
+
+    filter->num_particles = L;
+    filter->num_steps = 0;
+    filter->lag = 0;
+    filter->current = 0;
+    filter->history = NULL;
+    filter->spare = NULL;
+    filter->log_weights = NULL;
+    filter->weights = NULL;
+    filter->log_likelihoods = NULL;
+    filter->ancestors = NULL;
+    filter->ess = L;
+    filter->resampled = FALSE;
+    filter->log_marginal_likelihood = 0.0;
+
+    filter->resampling_method = SYSTEMATIC_RESAMPLING;
+    filter->ess_threshold = 0.5;
+    filter->num_threads = 1;
+
+    filter->sample_from_prior = sample_from_prior;
+    filter->prior_context = prior_context;
+    filter->likelihood = likelihood;
+    filter->batch_log_likelihood = NULL;
+    filter->likelihood_context = likelihood_context;
+
+    if(    get_target_v3(&filter->history, 1) == ERROR
+        || get_initialized_vector(&filter->log_weights, L, -log((double)L)) == ERROR
+        || get_initialized_vector(&filter->weights, L, 1.0 / L) == ERROR
+        || get_target_vector(&filter->log_likelihoods, L) == ERROR
+        || (filter->ancestors = N_TYPE_MALLOC(int, L)) == NULL)
+    {
+        free_SIR_filter(filter);
+        return NULL;
+    }
+
+    return filter;
+}
+
+/*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\   */
+
+/* =============================================================================
+ *                         set_SIR_filter_batch_likelihood
+ *
+ * Installs a batched likelihood callback in a SIR filter
+ *
+ * After this call the filter evaluates the likelihood of the whole population
+ * by calling batch_log_likelihood on contiguous ranges of particles, instead
+ * of calling the per-particle likelihood once per particle. The callback
+ * returns log-likelihoods, which avoids underflow for peaked likelihoods. If
+ * the filter uses more than one thread, the callback is called concurrently
+ * on disjoint ranges, so it must not modify shared state without locking.
+ *
+ * Passing NULL for batch_log_likelihood goes back to the per-particle
+ * likelihood given to create_SIR_filter, which must then be non-NULL.
+ *
+ * Returns:
+ *     NO_ERROR on success, and ERROR on failure, with an appropriate error
+ *     message being set.
+ *
+ * Index: LDS
+ *
+ * -----------------------------------------------------------------------------
+*/
+
+int set_SIR_filter_batch_likelihood
+(
+    SIR_filter*                   filter,
+    Particle_batch_log_likelihood batch_log_likelihood,
+    const void*                   likelihood_context
+)
+{
+    NRE(filter);
+
+    if(batch_log_likelihood == NULL && filter->likelihood == NULL)
+    {
+        SET_ARGUMENT_BUG();
+        return ERROR;
+    }
+
+    filter->batch_log_likelihood = batch_log_likelihood;
+    filter->likelihood_context = likelihood_context;
+
+    return NO_ERROR;
+}
+
+/*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\   */
+
+/* =============================================================================
+ *                           set_SIR_filter_resampling
+ *
+ * Sets how and when a SIR filter resamples
+ *
+ * The filter resamples after an update if the effective sample size of the
+ * weights, 1 / sum w_l^2, is less than ess_threshold times the number of
+ * particles. An ess_threshold of 1 (or more) resamples after every update, as
+ * SIR_particle_filter does, and 0 never resamples.
+ *
+ * The method is one of MULTINOMIAL_RESAMPLING, SYSTEMATIC_RESAMPLING,
+ * STRATIFIED_RESAMPLING or RESIDUAL_RESAMPLING. All but the first take linear
+ * time and have lower variance than multinomial resampling. Residual
+ * resampling keeps floor(L w_l) copies of each particle and fills the rest
+ * with stratified draws from the remainders.
+ *
+ * Returns:
+ *     NO_ERROR on success, and ERROR on failure, with an appropriate error
+ *     message being set.
+ *
+ * Index: LDS
+ *
+ * -----------------------------------------------------------------------------
+*/
+
+int set_SIR_filter_resampling
+(
+    SIR_filter*                filter,
+    Particle_resampling_method method,
+    double                     ess_threshold
+)
+{
+    NRE(filter);
+
+    if(    ess_threshold < 0.0
+        || (    method != MULTINOMIAL_RESAMPLING
+             && method != SYSTEMATIC_RESAMPLING
+             && method != STRATIFIED_RESAMPLING
+             && method != RESIDUAL_RESAMPLING))
+    {
+        SET_ARGUMENT_BUG();
+        return ERROR;
+    }
+
+    filter->resampling_method = method;
+    filter->ess_threshold = ess_threshold;
+
+    return NO_ERROR;
+}
+
+/*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\   */
+
+/* =============================================================================
+ *                           set_SIR_filter_num_threads
+ *
+ * Sets the number of threads used to evaluate likelihoods
+ *
+ * The population is split into num_threads contiguous ranges of particles
+ * whose likelihoods are evaluated at the same time, one range per thread.
+ * Sampling from the prior and resampling stay in the calling thread, so only
+ * the likelihood callback needs to be reentrant. If a thread cannot be started
+ * (e.g., without pthreads), its range is evaluated in the calling thread.
+ *
+ * Returns:
+ *     NO_ERROR on success, and ERROR on failure, with an appropriate error
+ *     message being set.
+ *
+ * Index: LDS
+ *
+ * -----------------------------------------------------------------------------
+*/
+
+int set_SIR_filter_num_threads(SIR_filter* filter, int num_threads)
+{
+    NRE(filter);
+
+    if(num_threads < 1)
+    {
+        SET_ARGUMENT_BUG();
+        return ERROR;
+    }
+
+    filter->num_threads = num_threads;
+
+    return NO_ERROR;
+}
+
+/*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\   */
+
+/* =============================================================================
+ *                              set_SIR_filter_lag
+ *
+ * Sets the number of past populations kept by a SIR filter
+ *
+ * With a positive lag, the filter also keeps the populations of the previous
+ * lag time steps, which get_SIR_filter_particles returns. These are resampled
+ * together with the current population, so that particle l of every kept
+ * population lies on the same trajectory; with the current weights they
+ * approximate the fixed-lag smoothing distribution p(x_{k-j} | y_{1:k}).
+ *
+ * The lag can only be set before the first update.
+ *
+ * Returns:
+ *     NO_ERROR on success, and ERROR on failure, with an appropriate error
+ *     message being set.
+ *
+ * Index: LDS
+ *
+ * -----------------------------------------------------------------------------
+*/
+
+int set_SIR_filter_lag(SIR_filter* filter, int lag)
+{
+    NRE(filter);
+
+    if(lag < 0)
+    {
+        SET_ARGUMENT_BUG();
+        return ERROR;
+    }
+
+    if(filter->num_steps > 0)
+    {
+        set_error("The lag of a SIR filter must be set before the first update.");
+        return ERROR;
+    }
+
+    ERE(get_target_v3(&filter->history, lag + 1));
+    filter->lag = lag;
+    filter->current = 0;
+
+    return NO_ERROR;
+}
+
+/*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\   */
+
+/* =============================================================================
+ *                              update_SIR_filter
+ *
+ * Advances a SIR filter by one observation
+ *
+ * This routine moves every particle forward by sampling from the prior,
+ * weights the particles by the likelihood of y, and then resamples them if
+ * the effective sample size is too low (see set_SIR_filter_resampling). The
+ * resulting population is returned by get_SIR_filter_particles(filter, 0),
+ * and its normalized weights are in filter->weights (and their logarithms in
+ * filter->log_weights). filter->ess holds the effective sample size before
+ * resampling, filter->resampled tells whether this update resampled, and
+ * filter->log_marginal_likelihood accumulates log p(y_1, ..., y_k).
+ *
+ * Returns:
+ *     NO_ERROR on success, and ERROR on failure, with an appropriate error
+ *     message being set. It is an error for every particle to have zero
+ *     likelihood.
+ *
+ * Index: LDS
+ *
+ * -----------------------------------------------------------------------------
+*/
+
+int update_SIR_filter(SIR_filter* filter, const Vector* y)
+{
+    NRE(filter);
+    NRE(y);
+
+    ERE(propagate_particles(filter, y));
+
+    filter->resampled = FALSE;
+    if(    filter->ess_threshold >= 1.0
+        || filter->ess < filter->ess_threshold * filter->num_particles)
+    {
+        ERE(select_ancestors(filter));
+        ERE(apply_ancestors(filter));
+        filter->resampled = TRUE;
+    }
+
+    return NO_ERROR;
+}
+
+/*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\   */
+
+/* =============================================================================
+ *                           get_SIR_filter_particles
+ *
+ * Returns a population of a SIR filter
+ *
+ * This routine returns the current population if steps_back is zero, and
+ * otherwise the population steps_back time steps ago, which is available as
+ * long as steps_back is at most the lag (see set_SIR_filter_lag) and at most
+ * the number of updates minus one. In all cases, the weights of the particles
+ * are filter->weights. The population belongs to the filter and changes with
+ * the next update.
+ *
+ * Returns:
+ *     The population, or NULL if it is not available.
+ *
+ * Index: LDS
+ *
+ * -----------------------------------------------------------------------------
+*/
+
+const Vector_vector* get_SIR_filter_particles
+(
+    const SIR_filter* filter,
+    int               steps_back
+)
+{
+    int R;
+
+    if(    filter == NULL || steps_back < 0 || steps_back > filter->lag
+        || steps_back >= filter->num_steps)
+    {
+        return NULL;
+    }
+
+    R = filter->lag + 1;
+
+    return filter->history->elements[(filter->current - steps_back + R) % R];
+}
+
+/*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\   */
+
+/* =============================================================================
+ *                              free_SIR_filter
+ *
+ * Frees a SIR filter
+ *
+ * This routine frees a filter created by create_SIR_filter, with all its
+ * populations. It is safe to pass NULL.
+ *
+ * Index: LDS
+ *
+ * -----------------------------------------------------------------------------
+*/
+
+void free_SIR_filter(SIR_filter* filter)
+{
+    if(filter == NULL) return;
+
+    free_v3(filter->history);
+    free_vector_vector(filter->spare);
+    free_vector(filter->log_weights);
+    free_vector(filter->weights);
+    free_vector(filter->log_likelihoods);
+    kjb_free(filter->ancestors);
+    kjb_free(filter);
+}
 
 /*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\   */
 
@@ -44,6 +479,11 @@ static int resample(Vector_vector* original_samples, const Vector* distribution)
  * p(y_k | x_k), which it does by calling likelihood. The context parameters
  * are provided in case the prior or the likelihood depend on extra variables.
  *
+ * The particles are resampled (multinomially) at every time step, and the
+ * weights before resampling are put in *weights. This routine keeps every time
+ * step; for long sequences, create_SIR_filter and update_SIR_filter do the
+ * same work keeping only the current population.
+ *
  * As usual, *samples is reused if possible and created if needed, according
  * to the KJB allocation semantics.
  *
@@ -72,65 +512,400 @@ int SIR_particle_filter
     const void*          likelihood_context
 )
 {
-    Vector_vector* x_k;
-    Vector_vector* x_k_1;
-    Vector* w_k;
-    double lh;
+    SIR_filter* filter;
+    int result = NO_ERROR;
     int N;
-    int k, l;
+    int k;
+
+    NRE(y);
 
     N = y->length;
 
-    get_target_v3(samples, N);
-    get_target_vector_vector(weights, N);
+    ERE(get_target_v3(samples, N));
+    ERE(get_target_vector_vector(weights, N));
+
+    NRE(filter = create_SIR_filter(L, sample_from_prior, prior_context,
+                                   likelihood, likelihood_context));
+    filter->resampling_method = MULTINOMIAL_RESAMPLING;
 
     for(k = 0; k < N; k++)
     {
-        get_target_vector_vector(&(*samples)->elements[k], L);
-        get_target_vector(&(*weights)->elements[k], L);
-        x_k = (*samples)->elements[k];
-        x_k_1 = k == 0 ? NULL : (*samples)->elements[k - 1];
-        w_k = (*weights)->elements[k];
-
-        for(l = 0; l < L; l++)
+        if(    propagate_particles(filter, y->elements[k]) == ERROR
+            || copy_vector(&(*weights)->elements[k], filter->weights) == ERROR
+            || select_ancestors(filter) == ERROR
+            || apply_ancestors(filter) == ERROR
+            || copy_vector_vector(&(*samples)->elements[k],
+                                  get_SIR_filter_particles(filter, 0)) == ERROR)
         {
-            sample_from_prior(&x_k->elements[l], k != 0 ? x_k_1->elements[l] : NULL, prior_context);
-            likelihood(&lh, y->elements[k], x_k->elements[l], likelihood_context);
-            w_k->elements[l] = lh;
+            result = ERROR;
+            break;
         }
-        ow_normalize_vector(w_k, NORMALIZE_BY_SUM);
+    }
+
+    free_SIR_filter(filter);
 
-        resample(x_k, w_k);
+    return result;
+}
+
+/*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\   */
+
+/*
+ * Samples a new population from the prior, makes it the current one (evicting
+ * the oldest kept population), and multiplies the weights by the likelihood.
+ * The weights are left normalized, and the normalizer goes into the log
+ * marginal likelihood.
+ */
+static int propagate_particles(SIR_filter* filter, const Vector* y)
+{
+    const int L = filter->num_particles;
+    const int R = filter->lag + 1;
+    const Vector_vector* x_k_1;
+    Vector_vector* x_k;
+    double* log_w = filter->log_weights->elements;
+    double* w = filter->weights->elements;
+    const double* log_lh = filter->log_likelihoods->elements;
+    double max_log_w = DBL_MOST_NEGATIVE;
+    double sum = 0.0;
+    double sum_sq = 0.0;
+    double log_norm;
+    int next;
+    int l;
+
+    x_k_1 = get_SIR_filter_particles(filter, 0);
+
+    ERE(get_target_vector_vector(&filter->spare, L));
+    x_k = filter->spare;
+
+    for(l = 0; l < L; l++)
+    {
+        ERE(filter->sample_from_prior(&x_k->elements[l],
+                                      x_k_1 == NULL ? NULL : x_k_1->elements[l],
+                                      filter->prior_context));
     }
 
+    ERE(evaluate_log_likelihoods(filter, y, x_k));
+
+    for(l = 0; l < L; l++)
+    {
+        log_w[l] += log_lh[l];
+        max_log_w = MAX_OF(max_log_w, log_w[l]);
+    }
+
+    if(max_log_w <= DBL_HALF_MOST_NEGATIVE)
+    {
+        set_error("All particles of the SIR filter have zero likelihood.");
+        return ERROR;
+    }
+
+    for(l = 0; l < L; l++)
+    {
+        w[l] = exp(log_w[l] - max_log_w);
+        sum += w[l];
+    }
+
+    log_norm = max_log_w + log(sum);
+    filter->log_marginal_likelihood += log_norm;
+
+    for(l = 0; l < L; l++)
+    {
+        log_w[l] -= log_norm;
+        w[l] /= sum;
+        sum_sq += w[l] * w[l];
+    }
+    filter->ess = 1.0 / sum_sq;
+
+    /* The new population takes the slot of the oldest one, whose storage is
+     * reused by the next update. */
+    next = filter->num_steps == 0 ? filter->current : (filter->current + 1) % R;
+    filter->spare = filter->history->elements[next];
+    filter->history->elements[next] = x_k;
+    filter->current = next;
+    filter->num_steps++;
+
     return NO_ERROR;
 }
 
 /*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\   */
 
-static int resample(Vector_vector* original_samples, const Vector* distribution)
+/*
+ * Puts log p(y | x_l) for every particle into filter->log_likelihoods, one
+ * contiguous range of particles per thread.
+ */
+static int evaluate_log_likelihoods
+(
+    SIR_filter*          filter,
+    const Vector*        y,
+    const Vector_vector* particles
+)
 {
-    Vector_vector* copy = NULL;
-    int L;
-    int l;
-    int i;
+    const int L = filter->num_particles;
+    const int num_threads = MIN_OF(filter->num_threads, L);
+    Particle_batch_log_likelihood batch_log_likelihood;
+    const void* context;
+    Likelihood_job* jobs;
+    kjb_pthread_t* threads;
+    int* started;
+    int result = NO_ERROR;
+    int t;
 
-    if(original_samples == NULL || distribution == NULL)
+    if(filter->batch_log_likelihood != NULL)
+    {
+        batch_log_likelihood = filter->batch_log_likelihood;
+        context = filter->likelihood_context;
+    }
+    else if(filter->likelihood != NULL)
+    {
+        batch_log_likelihood = per_particle_log_likelihood;
+        context = filter;
+    }
+    else
     {
         SET_ARGUMENT_BUG();
         return ERROR;
     }
 
-    L  = original_samples->length;
-    copy_vector_vector(&copy, original_samples);
+    if(num_threads <= 1)
+    {
+        return batch_log_likelihood(filter->log_likelihoods, y, particles,
+                                    0, L, context);
+    }
+
+    jobs = N_TYPE_MALLOC(Likelihood_job, num_threads);
+    threads = N_TYPE_MALLOC(kjb_pthread_t, num_threads);
+    started = N_TYPE_MALLOC(int, num_threads);
 
-    for(i = 0; i < L; i++)
+    if(jobs == NULL || threads == NULL || started == NULL)
+    {
+        kjb_free(started);
+        kjb_free(threads);
+        kjb_free(jobs);
+        return ERROR;
+    }
+
+    for(t = 0; t < num_threads; t++)
+    {
+        jobs[t].batch_log_likelihood = batch_log_likelihood;
+        jobs[t].context = context;
+        jobs[t].log_likelihoods = filter->log_likelihoods;
+        jobs[t].y = y;
+        jobs[t].particles = particles;
+        jobs[t].begin = (L / num_threads) * t + MIN_OF(t, L % num_threads);
+        jobs[t].end = jobs[t].begin + L / num_threads
+                                    + (t < L % num_threads ? 1 : 0);
+        jobs[t].result = NO_ERROR;
+    }
+
+    for(t = 1; t < num_threads; t++)
+    {
+        started[t] = kjb_pthread_create(&threads[t], NULL,
+                                        likelihood_job_main, &jobs[t]) != ERROR;
+    }
+
+    likelihood_job_main(&jobs[0]);
+
+    for(t = 1; t < num_threads; t++)
+    {
+        if(started[t])
+        {
+            kjb_pthread_join(threads[t], NULL);
+        }
+        else
+        {
+            likelihood_job_main(&jobs[t]);
+        }
+    }
+
+    for(t = 0; t < num_threads; t++)
+    {
+        if(jobs[t].result == ERROR)
+        {
+            result = ERROR;
+        }
+    }
+
+    kjb_free(started);
+    kjb_free(threads);
+    kjb_free(jobs);
+
+    return result;
+}
+
+/*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\   */
+
+static void* likelihood_job_main(void* job_ptr)
+{
+    Likelihood_job* job = (Likelihood_job*)job_ptr;
+
+    job->result = job->batch_log_likelihood(job->log_likelihoods, job->y,
+                                            job->particles, job->begin,
+                                            job->end, job->context);
+
+    return NULL;
+}
+
+/*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\   */
+
+/*
+ * Adapts the per-particle likelihood callback of SIR_particle_filter to a
+ * batched log-likelihood; the context is the filter itself.
+ */
+static int per_particle_log_likelihood
+(
+    Vector*              log_likelihoods,
+    const Vector*        y,
+    const Vector_vector* particles,
+    int                  begin,
+    int                  end,
+    const void*          context
+)
+{
+    const SIR_filter* filter = (const SIR_filter*)context;
+    double lh;
+    int l;
+
+    for(l = begin; l < end; l++)
     {
-        ERE(sample_from_discrete_distribution(&l, distribution));
-        copy_vector(&original_samples->elements[i], copy->elements[l]);
+        ERE(filter->likelihood(&lh, y, particles->elements[l],
+                               filter->likelihood_context));
+        log_likelihoods->elements[l] = lh > 0.0 ? log(lh) : DBL_HALF_MOST_NEGATIVE;
     }
 
-    free_vector_vector(copy);
+    return NO_ERROR;
+}
+
+/*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\   */
+
+/*
+ * Fills filter->ancestors with the index of the particle that each slot of the
+ * resampled population copies, according to filter->weights.
+ */
+static int select_ancestors(SIR_filter* filter)
+{
+    const int L = filter->num_particles;
+    const Vector* w = filter->weights;
+    int* ancestors = filter->ancestors;
+    Vector* residuals = NULL;
+    double total = 0.0;
+    int count = 0;
+    int copies;
+    int i, l;
+
+    switch(filter->resampling_method)
+    {
+        case MULTINOMIAL_RESAMPLING:
+            for(i = 0; i < L; i++)
+            {
+                ERE(sample_from_discrete_distribution(&ancestors[i], w));
+            }
+            break;
+
+        case SYSTEMATIC_RESAMPLING:
+            sorted_draws(ancestors, L, w, 1.0, TRUE);
+            break;
+
+        case STRATIFIED_RESAMPLING:
+            sorted_draws(ancestors, L, w, 1.0, FALSE);
+            break;
+
+        case RESIDUAL_RESAMPLING:
+            ERE(get_target_vector(&residuals, L));
+            for(l = 0; l < L; l++)
+            {
+                copies = (int)floor(L * w->elements[l]);
+                residuals->elements[l] = L * w->elements[l] - copies;
+                total += residuals->elements[l];
+                for(i = 0; i < copies && count < L; i++)
+                {
+                    ancestors[count++] = l;
+                }
+            }
+            if(count < L)
+            {
+                sorted_draws(ancestors + count, L - count, residuals, total, FALSE);
+            }
+            free_vector(residuals);
+            break;
+
+        default:
+            SET_CANT_HAPPEN_BUG();
+            return ERROR;
+    }
+
+    return NO_ERROR;
+}
+
+/*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\   */
+
+/*
+ * Draws count indices from the (unnormalized) weights w, whose sum is total,
+ * by inverting the CDF at count sorted points, one per stratum of width
+ * total / count. Systematic draws use the same offset in every stratum, and
+ * stratified draws an independent one.
+ */
+static void sorted_draws
+(
+    int*          ancestors,
+    int           count,
+    const Vector* w,
+    double        total,
+    int           systematic
+)
+{
+    const int L = w->length;
+    const double offset = systematic ? kjb_rand() : 0.0;
+    double cdf = w->elements[0];
+    double u;
+    int i;
+    int l = 0;
+
+    for(i = 0; i < count; i++)
+    {
+        u = total * (i + (systematic ? offset : kjb_rand())) / count;
+        while(u > cdf && l < L - 1)
+        {
+            l++;
+            cdf += w->elements[l];
+        }
+        ancestors[i] = l;
+    }
+}
+
+/*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\   */
+
+/*
+ * Replaces every kept population by its particles at filter->ancestors, so
+ * that the trajectories stay aligned, and resets the weights to uniform.
+ */
+static int apply_ancestors(SIR_filter* filter)
+{
+    const int L = filter->num_particles;
+    const int R = filter->lag + 1;
+    const int depth = MIN_OF(R, filter->num_steps);
+    Vector_vector* population;
+    int slot;
+    int i, j;
+
+    for(j = 0; j < depth; j++)
+    {
+        slot = (filter->current - j + R) % R;
+        population = filter->history->elements[slot];
+
+        ERE(get_target_vector_vector(&filter->spare, L));
+        for(i = 0; i < L; i++)
+        {
+            ERE(copy_vector(&filter->spare->elements[i],
+                            population->elements[filter->ancestors[i]]));
+        }
+
+        filter->history->elements[slot] = filter->spare;
+        filter->spare = population;
+    }
+
+    for(i = 0; i < L; i++)
+    {
+        filter->log_weights->elements[i] = -log((double)L);
+        filter->weights->elements[i] = 1.0 / L;
+    }
 
     return NO_ERROR;
 }
@@ -30,6 +30,96 @@ namespace kjb_c {
 #endif
 #endif
 
+/* Resampling schemes for SIR_filter; see set_SIR_filter_resampling. */
+typedef enum Particle_resampling_method
+{
+    MULTINOMIAL_RESAMPLING,
+    SYSTEMATIC_RESAMPLING,
+    STRATIFIED_RESAMPLING,
+    RESIDUAL_RESAMPLING
+}
+Particle_resampling_method;
+
+/*
+ * Batched likelihood callback. It must write log p(y | x_l) into
+ * log_likelihoods->elements[l] for begin <= l < end. With more than one thread
+ * it is called concurrently on disjoint ranges of the same population.
+ */
+typedef int (*Particle_batch_log_likelihood)
+(
+    Vector*              log_likelihoods,
+    const Vector*        y,
+    const Vector_vector* particles,
+    int                  begin,
+    int                  end,
+    const void*          context
+);
+
+typedef struct SIR_filter
+{
+    int                  num_particles;
+    int                  num_steps;       /* observations consumed so far    */
+    int                  lag;             /* past populations kept           */
+    int                  current;         /* index of the current population */
+    V_v_v*               history;         /* ring of lag + 1 populations     */
+    Vector_vector*       spare;
+    Vector*              log_weights;     /* normalized, current population  */
+    Vector*              weights;
+    Vector*              log_likelihoods;
+    int*                 ancestors;
+    double               ess;             /* of the weights before resampling */
+    int                  resampled;       /* whether the last update did     */
+    double               log_marginal_likelihood;
+
+    Particle_resampling_method resampling_method;
+    double               ess_threshold;
+    int                  num_threads;
+
+    int                  (*sample_from_prior)(Vector**, const Vector*, const void*);
+    const void*          prior_context;
+    int                  (*likelihood)(double*, const Vector*, const Vector*, const void*);
+    Particle_batch_log_likelihood batch_log_likelihood;
+    const void*          likelihood_context;
+}
+SIR_filter;
+
+SIR_filter* create_SIR_filter
+(
+    int                  L,
+    int                  (*sample_from_prior)(Vector**, const Vector*, const void*),
+    const void*          prior_context,
+    int                  (*likelihood)(double*, const Vector*, const Vector*, const void*),
+    const void*          likelihood_context
+);
+
+int set_SIR_filter_batch_likelihood
+(
+    SIR_filter*                   filter,
+    Particle_batch_log_likelihood batch_log_likelihood,
+    const void*                   likelihood_context
+);
+
+int set_SIR_filter_resampling
+(
+    SIR_filter*                filter,
+    Particle_resampling_method method,
+    double                     ess_threshold
+);
+
+int set_SIR_filter_num_threads(SIR_filter* filter, int num_threads);
+
+int set_SIR_filter_lag(SIR_filter* filter, int lag);
+
+int update_SIR_filter(SIR_filter* filter, const Vector* y);
+
+const Vector_vector* get_SIR_filter_particles
+(
+    const SIR_filter* filter,
+    int               steps_back
+);
+
+void free_SIR_filter(SIR_filter* filter);
+
 int SIR_particle_filter
 (
     V_v_v**              samples,
@@ -0,0 +1,652 @@
+/* $Id$ */
+
+/*
+ * Checks the online SIR filter on a 1-D random walk observed with Gaussian
+ * noise: that it reproduces SIR_particle_filter when set up the same way, that
+ * every resampling scheme copies particles in proportion to their weights,
+ * that the fixed-lag history keeps aligned trajectories, and that the result
+ * does not depend on the number of threads evaluating the likelihood.
+ */
+
+#include "l/l_incl.h"
+#include "sample/sample_incl.h"
+#include "sequential/sequential_particles.h"
+
+#define NUM_PARTICLES   200
+#define NUM_STEPS       30
+#define LAG             3
+#define NUM_THREADS     4
+#define NOISE_SIGMA     0.5
+
+/*
+ * The batched likelihood keeps a copy of the population it weighted, and of
+ * the log likelihoods, so that the resampled population can be checked against
+ * the filter's ancestors.
+ */
+typedef struct Likelihood_record
+{
+    Vector_vector* particles;
+    Vector*        log_likelihoods;
+}
+Likelihood_record;
+
+static int sample_random_walk
+(
+    Vector**      x_ptr,
+    const Vector* x_prev,
+    const void*   context
+);
+
+static int random_walk_likelihood
+(
+    double*       likelihood_ptr,
+    const Vector* y,
+    const Vector* x,
+    const void*   context
+);
+
+static int random_walk_batch_log_likelihood
+(
+    Vector*              log_likelihoods,
+    const Vector*        y,
+    const Vector_vector* particles,
+    int                  begin,
+    int                  end,
+    const void*          context
+);
+
+static int recording_batch_log_likelihood
+(
+    Vector*              log_likelihoods,
+    const Vector*        y,
+    const Vector_vector* particles,
+    int                  begin,
+    int                  end,
+    const void*          context
+);
+
+static int make_observations(Vector_vector** y_vvp, int num_steps);
+
+static int are_populations_equal
+(
+    const Vector_vector* first_vvp,
+    const Vector_vector* second_vvp
+);
+
+static int test_same_as_SIR_particle_filter(const Vector_vector* y_vvp);
+
+static int test_resampling
+(
+    const Vector_vector*       y_vvp,
+    Particle_resampling_method method
+);
+
+static int test_lag(const Vector_vector* y_vvp);
+
+static int test_threads(const Vector_vector* y_vvp);
+
+/* -------------------------------------------------------------------------- */
+
+int main(int argc, char **argv)
+{
+    int            status = EXIT_SUCCESS;
+    Vector_vector* y_vvp  = NULL;
+
+
+    kjb_init();
+
+    EPETB(set_heap_options("heap-checking", "f"));
+
+    kjb_seed_rand(1, 2);
+    kjb_seed_rand_2(3);
+    EPETE(make_observations(&y_vvp, NUM_STEPS));
+
+    if (test_same_as_SIR_particle_filter(y_vvp) == ERROR)
+    {
+        kjb_print_error();
+        status = EXIT_BUG;
+    }
+
+    if (    (test_resampling(y_vvp, MULTINOMIAL_RESAMPLING) == ERROR)
+         || (test_resampling(y_vvp, SYSTEMATIC_RESAMPLING) == ERROR)
+         || (test_resampling(y_vvp, STRATIFIED_RESAMPLING) == ERROR)
+         || (test_resampling(y_vvp, RESIDUAL_RESAMPLING) == ERROR)
+       )
+    {
+        kjb_print_error();
+        status = EXIT_BUG;
+    }
+
+    if (test_lag(y_vvp) == ERROR)
+    {
+        kjb_print_error();
+        status = EXIT_BUG;
+    }
+
+    if (test_threads(y_vvp) == ERROR)
+    {
+        kjb_print_error();
+        status = EXIT_BUG;
+    }
+
+    free_vector_vector(y_vvp);
+
+    return status;
+}
+
+/*  /\   /\   /\   /\   /\   /\   /\   /\   /\   /\   /\   /\   /\   /\   /\  */
+
+/*
+ * A particle is its whole trajectory: each step appends one random walk step
+ * to the previous particle, so that the lag test can check that past
+ * populations are prefixes of the current one.
+ */
+static int sample_random_walk
+(
+    Vector**      x_ptr,
+    const Vector* x_prev,
+    const void*   context
+)
+{
+    int length = (x_prev == NULL) ? 1 : x_prev->length + 1;
+    int i;
+
+
+    ERE(get_target_vector(x_ptr, length));
+
+    for (i = 0; i < length - 1; i++)
+    {
+        (*x_ptr)->elements[ i ] = x_prev->elements[ i ];
+    }
+
+    (*x_ptr)->elements[ length - 1 ] = gauss_rand();
+
+    if (x_prev != NULL)
+    {
+        (*x_ptr)->elements[ length - 1 ] += x_prev->elements[ length - 2 ];
+    }
+
+    return NO_ERROR;
+}
+
+/*  /\   /\   /\   /\   /\   /\   /\   /\   /\   /\   /\   /\   /\   /\   /\  */
+
+static int random_walk_likelihood
+(
+    double*       likelihood_ptr,
+    const Vector* y,
+    const Vector* x,
+    const void*   context
+)
+{
+    double d = (y->elements[ 0 ] - x->elements[ x->length - 1 ]) / NOISE_SIGMA;
+
+    *likelihood_ptr = exp(-0.5 * d * d);
+
+    return NO_ERROR;
+}
+
+/*  /\   /\   /\   /\   /\   /\   /\   /\   /\   /\   /\   /\   /\   /\   /\  */
+
+static int random_walk_batch_log_likelihood
+(
+    Vector*              log_likelihoods,
+    const Vector*        y,
+    const Vector_vector* particles,
+    int                  begin,
+    int                  end,
+    const void*          context
+)
+{
+    const Vector* x;
+    double        d;
+    int           l;
+
+
+    for (l = begin; l < end; l++)
+    {
+        x = particles->elements[ l ];
+        d = (y->elements[ 0 ] - x->elements[ x->length - 1 ]) / NOISE_SIGMA;
+        log_likelihoods->elements[ l ] = -0.5 * d * d;
+    }
+
+    return NO_ERROR;
+}
+
+/*  /\   /\   /\   /\   /\   /\   /\   /\   /\   /\   /\   /\   /\   /\   /\  */
+
+static int recording_batch_log_likelihood
+(
+    Vector*              log_likelihoods,
+    const Vector*        y,
+    const Vector_vector* particles,
+    int                  begin,
+    int                  end,
+    const void*          context
+)
+{
+    Likelihood_record* record_ptr = (Likelihood_record*)context;
+
+
+    ERE(random_walk_batch_log_likelihood(log_likelihoods, y, particles,
+                                         begin, end, NULL));
+    ERE(copy_vector_vector(&(record_ptr->particles), particles));
+    ERE(copy_vector(&(record_ptr->log_likelihoods), log_likelihoods));
+
+    return NO_ERROR;
+}
+
+/*  /\   /\   /\   /\   /\   /\   /\   /\   /\   /\   /\   /\   /\   /\   /\  */
+
+static int make_observations(Vector_vector** y_vvp, int num_steps)
+{
+    double x = 0.0;
+    int    k;
+
+
+    ERE(get_target_vector_vector(y_vvp, num_steps));
+
+    for (k = 0; k < num_steps; k++)
+    {
+        x += gauss_rand();
+        ERE(get_initialized_vector(&((*y_vvp)->elements[ k ]), 1,
+                                   x + NOISE_SIGMA * gauss_rand()));
+    }
+
+    return NO_ERROR;
+}
+
+/*  /\   /\   /\   /\   /\   /\   /\   /\   /\   /\   /\   /\   /\   /\   /\  */
+
+static int are_populations_equal
+(
+    const Vector_vector* first_vvp,
+    const Vector_vector* second_vvp
+)
+{
+    int l;
+
+
+    if ((first_vvp == NULL) || (second_vvp == NULL)) return FALSE;
+    if (first_vvp->length != second_vvp->length) return FALSE;
+
+    for (l = 0; l < first_vvp->length; l++)
+    {
+        if (max_abs_vector_difference(first_vvp->elements[ l ],
+                                      second_vvp->elements[ l ]) != 0.0)
+        {
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
+/*  /\   /\   /\   /\   /\   /\   /\   /\   /\   /\   /\   /\   /\   /\   /\  */
+
+/*
+ * SIR_particle_filter resamples multinomially after every step, which the
+ * online filter does with an ESS threshold of 1.
+ */
+static int test_same_as_SIR_particle_filter(const Vector_vector* y_vvp)
+{
+    V_v_v*         samples_vvvp = NULL;
+    Vector_vector* weights_vvp  = NULL;
+    SIR_filter*    filter;
+    int            result       = NO_ERROR;
+    int            k;
+
+
+    kjb_seed_rand(5, 6);
+    ERE(SIR_particle_filter(&samples_vvvp, &weights_vvp, NUM_PARTICLES,
+                            y_vvp, sample_random_walk, NULL,
+                            random_walk_likelihood, NULL));
+
+    NRE(filter = create_SIR_filter(NUM_PARTICLES, sample_random_walk, NULL,
+                                   random_walk_likelihood, NULL));
+
+    if (    (set_SIR_filter_resampling(filter, MULTINOMIAL_RESAMPLING, 1.0)
+             == ERROR)
+         || (set_SIR_filter_num_threads(filter, 1) == ERROR)
+       )
+    {
+        result = ERROR;
+    }
+
+    kjb_seed_rand(5, 6);
+
+    for (k = 0; (k < y_vvp->length) && (result != ERROR); k++)
+    {
+        if (update_SIR_filter(filter, y_vvp->elements[ k ]) == ERROR)
+        {
+            result = ERROR;
+        }
+        else if (    ( ! filter->resampled)
+                  || ( ! are_populations_equal(
+                                     get_SIR_filter_particles(filter, 0),
+                                     samples_vvvp->elements[ k ]))
+                )
+        {
+            set_error("Step %d of the SIR filter differs from SIR_particle_filter.",
+                      k);
+            result = ERROR;
+        }
+    }
+
+    free_SIR_filter(filter);
+    free_v3(samples_vvvp);
+    free_vector_vector(weights_vvp);
+
+    return result;
+}
+
+/*  /\   /\   /\   /\   /\   /\   /\   /\   /\   /\   /\   /\   /\   /\   /\  */
+
+/*
+ * With an ESS threshold of 1 every step resamples from uniform weights, so the
+ * weights being resampled are the normalized recorded likelihoods. Particle i
+ * of the new population must be the recorded particle ancestors[i], and the
+ * number of copies n_l of particle l must be close to L w_l: within 1 for
+ * systematic resampling, within 2 for stratified resampling, and within 2 but
+ * no less than floor(L w_l) for residual resampling. For
+ * multinomial resampling, only the copies are checked here; its counts are
+ * those of SIR_particle_filter.
+ */
+static int test_resampling
+(
+    const Vector_vector*       y_vvp,
+    Particle_resampling_method method
+)
+{
+    Likelihood_record record      = { NULL, NULL };
+    SIR_filter*       filter;
+    Vector*           weight_vp   = NULL;
+    int*              counts      = NULL;
+    int               result      = NO_ERROR;
+    int               k, i, l;
+
+
+    NRE(filter = create_SIR_filter(NUM_PARTICLES, sample_random_walk, NULL,
+                                   NULL, NULL));
+
+    if (    (set_SIR_filter_batch_likelihood(filter,
+                                             recording_batch_log_likelihood,
+                                             &record) == ERROR)
+         || (set_SIR_filter_resampling(filter, method, 1.0) == ERROR)
+         || ((counts = INT_MALLOC(NUM_PARTICLES)) == NULL)
+       )
+    {
+        result = ERROR;
+    }
+
+    kjb_seed_rand(7, 8);
+
+    for (k = 0; (k < y_vvp->length) && (result != ERROR); k++)
+    {
+        const Vector_vector* particles;
+        double               expected, max_diff;
+
+        if (    (update_SIR_filter(filter, y_vvp->elements[ k ]) == ERROR)
+             || (copy_vector(&weight_vp, record.log_likelihoods) == ERROR)
+           )
+        {
+            result = ERROR;
+            break;
+        }
+
+        (void)ow_exp_scale_by_sum_log_vector(weight_vp);
+
+        particles = get_SIR_filter_particles(filter, 0);
+
+        for (l = 0; l < NUM_PARTICLES; l++)
+        {
+            counts[ l ] = 0;
+
+            if (filter->weights->elements[ l ] != 1.0 / NUM_PARTICLES)
+            {
+                set_error("Weights are not uniform after resampling (method %d).",
+                          (int)method);
+                result = ERROR;
+            }
+        }
+
+        for (i = 0; i < NUM_PARTICLES; i++)
+        {
+            int a = filter->ancestors[ i ];
+
+            if (    (a < 0) || (a >= NUM_PARTICLES)
+                 || (max_abs_vector_difference(particles->elements[ i ],
+                                               record.particles->elements[ a ])
+                     != 0.0)
+               )
+            {
+                set_error("Resampled particle %d is not its ancestor (method %d).",
+                          i, (int)method);
+                result = ERROR;
+                break;
+            }
+
+            counts[ a ]++;
+        }
+
+        if ((result == ERROR) || (method == MULTINOMIAL_RESAMPLING)) continue;
+
+        max_diff = (method == SYSTEMATIC_RESAMPLING) ? 1.0 : 2.0;
+
+        for (l = 0; l < NUM_PARTICLES; l++)
+        {
+            expected = NUM_PARTICLES * weight_vp->elements[ l ];
+
+            /* Leave some room for rounding in the cumulative weights. */
+            if (    (ABS_OF(counts[ l ] - expected) >= max_diff + 1.0e-8)
+                 || (    (method == RESIDUAL_RESAMPLING)
+                      && (counts[ l ] < (int)floor(expected - 1.0e-8)))
+               )
+            {
+                set_error("Particle %d has %d copies for weight %.4f (method %d).",
+                          l, counts[ l ], weight_vp->elements[ l ],
+                          (int)method);
+                result = ERROR;
+                break;
+            }
+        }
+    }
+
+    /* A threshold of 0 never resamples. */
+    if (result != ERROR)
+    {
+        if (    (set_SIR_filter_resampling(filter, method, 0.0) == ERROR)
+             || (update_SIR_filter(filter, y_vvp->elements[ 0 ]) == ERROR)
+           )
+        {
+            result = ERROR;
+        }
+        else if (filter->resampled)
+        {
+            set_error("SIR filter resampled with a zero ESS threshold (method %d).",
+                      (int)method);
+            result = ERROR;
+        }
+    }
+
+    kjb_free(counts);
+    free_vector(weight_vp);
+    free_vector_vector(record.particles);
+    free_vector(record.log_likelihoods);
+    free_SIR_filter(filter);
+
+    return result;
+}
+
+/*  /\   /\   /\   /\   /\   /\   /\   /\   /\   /\   /\   /\   /\   /\   /\  */
+
+/*
+ * After k updates, populations up to min(LAG, k - 1) steps back are
+ * available. Since particles are trajectories, particle l of the population j
+ * steps back must be the prefix of length k - j of particle l of the current
+ * one, however often the filter resampled in between.
+ */
+static int test_lag(const Vector_vector* y_vvp)
+{
+    SIR_filter* filter;
+    int         result = NO_ERROR;
+    int         k, j, l, i;
+
+
+    NRE(filter = create_SIR_filter(NUM_PARTICLES, sample_random_walk, NULL,
+                                   random_walk_likelihood, NULL));
+
+    if (    (set_SIR_filter_resampling(filter, SYSTEMATIC_RESAMPLING, 0.5)
+             == ERROR)
+         || (set_SIR_filter_lag(filter, LAG) == ERROR)
+       )
+    {
+        result = ERROR;
+    }
+
+    if ((result != ERROR) && (get_SIR_filter_particles(filter, 0) != NULL))
+    {
+        set_error("SIR filter has a population before the first update.");
+        result = ERROR;
+    }
+
+    kjb_seed_rand(9, 10);
+
+    for (k = 1; (k <= y_vvp->length) && (result != ERROR); k++)
+    {
+        const Vector_vector* current;
+
+        if (update_SIR_filter(filter, y_vvp->elements[ k - 1 ]) == ERROR)
+        {
+            result = ERROR;
+            break;
+        }
+
+        if (k == 2)
+        {
+            if (set_SIR_filter_lag(filter, LAG) != ERROR)
+            {
+                set_error("The lag of a SIR filter was changed after an update.");
+                result = ERROR;
+                break;
+            }
+            kjb_clear_error();
+        }
+
+        current = get_SIR_filter_particles(filter, 0);
+
+        for (j = 0; j <= LAG + 1; j++)
+        {
+            const Vector_vector* past = get_SIR_filter_particles(filter, j);
+            int available = (j <= LAG) && (j < k);
+
+            if ((past != NULL) != available)
+            {
+                set_error("After %d updates, population %d steps back is %s.",
+                          k, j, available ? "missing" : "present");
+                result = ERROR;
+                break;
+            }
+
+            if (past == NULL) continue;
+
+            for (l = 0; (l < NUM_PARTICLES) && (result != ERROR); l++)
+            {
+                const Vector* x      = current->elements[ l ];
+                const Vector* x_past = past->elements[ l ];
+
+                if ((x->length != k) || (x_past->length != k - j))
+                {
+                    set_error("Particle %d has the wrong length.", l);
+                    result = ERROR;
+                    break;
+                }
+
+                for (i = 0; i < k - j; i++)
+                {
+                    if (x_past->elements[ i ] != x->elements[ i ])
+                    {
+                        set_error("After %d updates, particle %d of %d steps back is not on its trajectory.",
+                                  k, l, j);
+                        result = ERROR;
+                        break;
+                    }
+                }
+            }
+
+            if (result == ERROR) break;
+        }
+    }
+
+    free_SIR_filter(filter);
+
+    return result;
+}
+
+/*  /\   /\   /\   /\   /\   /\   /\   /\   /\   /\   /\   /\   /\   /\   /\  */
+
+/*
+ * Sampling and resampling stay in the calling thread, so the number of threads
+ * evaluating the likelihood must not change anything.
+ */
+static int test_threads(const Vector_vector* y_vvp)
+{
+    SIR_filter* filters[ 2 ] = { NULL, NULL };
+    int         result       = NO_ERROR;
+    int         f, k;
+
+
+    for (f = 0; f < 2; f++)
+    {
+        NRE(filters[ f ] = create_SIR_filter(NUM_PARTICLES, sample_random_walk,
+                                             NULL, NULL, NULL));
+
+        if (    (set_SIR_filter_batch_likelihood(filters[ f ],
+                                        random_walk_batch_log_likelihood,
+                                        NULL) == ERROR)
+             || (set_SIR_filter_num_threads(filters[ f ],
+                                            (f == 0) ? 1 : NUM_THREADS)
+                 == ERROR)
+             || (set_SIR_filter_lag(filters[ f ], LAG) == ERROR)
+           )
+        {
+            result = ERROR;
+        }
+    }
+
+    for (k = 0; (k < y_vvp->length) && (result != ERROR); k++)
+    {
+        for (f = 0; f < 2; f++)
+        {
+            kjb_seed_rand(11, 12 + k);
+
+            if (update_SIR_filter(filters[ f ], y_vvp->elements[ k ]) == ERROR)
+            {
+                result = ERROR;
+                break;
+            }
+        }
+
+        if (result == ERROR) break;
+
+        if (    (filters[ 0 ]->resampled != filters[ 1 ]->resampled)
+             || (filters[ 0 ]->log_marginal_likelihood
+                 != filters[ 1 ]->log_marginal_likelihood)
+             || (max_abs_vector_difference(filters[ 0 ]->weights,
+                                           filters[ 1 ]->weights) != 0.0)
+             || ( ! are_populations_equal(
+                                    get_SIR_filter_particles(filters[ 0 ], 0),
+                                    get_SIR_filter_particles(filters[ 1 ], 0)))
+           )
+        {
+            set_error("SIR filter with %d threads differs from one thread at step %d.",
+                      NUM_THREADS, k);
+            result = ERROR;
+        }
+    }
+
+    free_SIR_filter(filters[ 0 ]);
+    free_SIR_filter(filters[ 1 ]);
+
+    return result;
+}
@@ -1,6 +1,7 @@
 /* $Id: ransac_fit.c 21596 2017-07-30 23:33:36Z kobus $
  */
 #include "slic/ransac_fit.h"
+#include "l_mt/l_mt_options.h"
 
 /* Kobus: I hope these commented out values are correct, because before they
  * were declared in ransac_fit.h but without value. 
@@ -9,19 +10,48 @@ static int (*fitting_func)(const Matrix *, const Matrix *, Matrix **, double *)
 static int (*dist_func)(const Matrix *, const Matrix *, const Matrix *, Vector **) = get_homography_distance; 
  static int (*degen_func)(const Matrix *) = is_homography_degenerate;
 
-static double fs_minimum_inliers_percentage = NOT_SET; 
-static double fs_acceptable_inliers_percentage = NOT_SET; 
-static int fs_max_random_trials = 100; 
-static double fs_inlier_prob = 0.99; /* Desired probability of choosing at least one
-                              sample free from outliers */ 
-static double fs_duplicates_dist_thresh = 5.0; /* how many px away should a match be to be an inlier */
-static double fs_duplicates_thresh_percentage = 0.50; /* percentage of inliers that is allowed to be duplicated */
+/* The options are kept in a struct so that threads can use their own (see
+ * l_mt_options.h). Read them with get_ransac_options().
+*/
+typedef struct Ransac_options
+{
+    double minimum_inliers_percentage; 
+    double acceptable_inliers_percentage; 
+    int max_random_trials; 
+    double inlier_prob; /* Desired probability of choosing at least one
+                           sample free from outliers */ 
+    double duplicates_dist_thresh; /* how many px away should a match be to be an inlier */
+    double duplicates_thresh_percentage; /* percentage of inliers that is allowed to be duplicated */
+}
+Ransac_options;
+
+static const Ransac_options fs_initial_ransac_options = { NOT_SET, NOT_SET, 100, 0.99, 5.0, 0.50 };
+static Ransac_options fs_ransac_options = { NOT_SET, NOT_SET, 100, 0.99, 5.0, 0.50 };
+
+static Option_module fs_ransac_option_module =
+{
+    "ransac",
+    sizeof(Ransac_options),
+    &fs_initial_ransac_options,
+    &fs_ransac_options,
+    FALSE
+};
+
+#define get_ransac_options() \
+    ((const Ransac_options*)get_module_options(&fs_ransac_option_module))
+
+#define get_ransac_options_for_update() \
+    ((Ransac_options*)get_module_options_for_update(&fs_ransac_option_module))
+
+static double get_minimum_inliers_percentage(const Ransac_options* options_ptr);
 
 int set_ransac_options(const char* option, const char* value)
 {
     int result = NOT_FOUND;
     char lc_option[ 100 ];
     double temp_dbl_value;
+    const Ransac_options* options_ptr = get_ransac_options();
+    Ransac_options* new_options_ptr;
 
     EXTENDED_LC_BUFF_CPY( lc_option, option );
 
@@ -33,16 +63,17 @@ int set_ransac_options(const char* option, const char* value)
         }
         if ( value[0] == '\0' )
         {
-            pso( "The minimum percentage of RANSAC inliers is '%f'\n", fs_minimum_inliers_percentage );
+            pso( "The minimum percentage of RANSAC inliers is '%f'\n", options_ptr->minimum_inliers_percentage );
         }
         else if (value[0] == '?')
         {
-            pso( "minimum-inliers-percentage = %f\n", fs_minimum_inliers_percentage );
+            pso( "minimum-inliers-percentage = %f\n", options_ptr->minimum_inliers_percentage );
         }
         else
         {
             ERE( ss1d(value, &temp_dbl_value) );
-            fs_minimum_inliers_percentage = temp_dbl_value;
+            NRE( new_options_ptr = get_ransac_options_for_update() );
+            new_options_ptr->minimum_inliers_percentage = temp_dbl_value;
         }
         result = NO_ERROR;
     }
@@ -54,16 +85,17 @@ int set_ransac_options(const char* option, const char* value)
         }
         if ( value[0] == '\0' )
         {
-            pso( "The minimum percentage of RANSAC inliers is '%f'\n", fs_acceptable_inliers_percentage );
+            pso( "The minimum percentage of RANSAC inliers is '%f'\n", options_ptr->acceptable_inliers_percentage );
         }
         else if (value[0] == '?')
         {
-            pso( "acceptable-inliers-percentage = %f\n", fs_acceptable_inliers_percentage );
+            pso( "acceptable-inliers-percentage = %f\n", options_ptr->acceptable_inliers_percentage );
         }
         else
         {
             ERE( ss1d(value, &temp_dbl_value) );
-            fs_acceptable_inliers_percentage = temp_dbl_value;
+            NRE( new_options_ptr = get_ransac_options_for_update() );
+            new_options_ptr->acceptable_inliers_percentage = temp_dbl_value;
         }
         result = NO_ERROR;
     }
@@ -75,16 +107,17 @@ int set_ransac_options(const char* option, const char* value)
         }
         if ( value[0] == '\0' )
         {
-            pso( "The distance threshold for inliers to not be a duplicate is '%f'\n", fs_duplicates_dist_thresh );
+            pso( "The distance threshold for inliers to not be a duplicate is '%f'\n", options_ptr->duplicates_dist_thresh );
         }
         else if (value[0] == '?')
         {
-            pso( "duplicates-distance-threshold = %f\n", fs_duplicates_dist_thresh );
+            pso( "duplicates-distance-threshold = %f\n", options_ptr->duplicates_dist_thresh );
         }
         else
         {
             ERE( ss1d(value, &temp_dbl_value) );
-            fs_duplicates_dist_thresh = temp_dbl_value;
+            NRE( new_options_ptr = get_ransac_options_for_update() );
+            new_options_ptr->duplicates_dist_thresh = temp_dbl_value;
         }
         result = NO_ERROR;
     }
@@ -96,16 +129,17 @@ int set_ransac_options(const char* option, const char* value)
         }
         if ( value[0] == '\0' )
         {
-            pso( "The distance threshold for inliers to not be a duplicate is '%f'\n", fs_duplicates_thresh_percentage );
+            pso( "The distance threshold for inliers to not be a duplicate is '%f'\n", options_ptr->duplicates_thresh_percentage );
         }
         else if (value[0] == '?')
         {
-            pso( "duplicates-threshold-percentage = %f\n", fs_duplicates_thresh_percentage );
+            pso( "duplicates-threshold-percentage = %f\n", options_ptr->duplicates_thresh_percentage );
         }
         else
         {
             ERE( ss1d(value, &temp_dbl_value) );
-            fs_duplicates_thresh_percentage = temp_dbl_value;
+            NRE( new_options_ptr = get_ransac_options_for_update() );
+            new_options_ptr->duplicates_thresh_percentage = temp_dbl_value;
         }
         result = NO_ERROR;
     }
@@ -117,19 +151,32 @@ int set_ransac_options(const char* option, const char* value)
 
 /*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\   */
 
+static double get_minimum_inliers_percentage(const Ransac_options* options_ptr)
+{
+    if (options_ptr->minimum_inliers_percentage < DBL_EPSILON)
+    {
+        return DEFAULT_MINIMUM_PERCENTAGE_OF_INLIERS;
+    }
+
+    return options_ptr->minimum_inliers_percentage;
+}
+
+/*  /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\ /\   */
+
 int calculate_max_num_iterations(int min_num_samples);
 int calculate_max_num_iterations(int min_num_samples)
 {
+  const Ransac_options* options_ptr = get_ransac_options();
   /* probability that any selected data point is an inlier, w */
   /* double frac = ((double)fs_minimum_num_inliers_percentage) / num_points; /\* (# of inliers) / (total # of points) *\/ */
   int max_num_iterations;
-  double frac = fs_minimum_inliers_percentage;
+  double frac = get_minimum_inliers_percentage(options_ptr);
   /* probability of an outlier, epsilon = 1 - w */ 
   double pNoOutliers = 1 - pow(frac, min_num_samples);
   pNoOutliers = pNoOutliers > 0 ? pNoOutliers : 0.000000001;
   pNoOutliers = pNoOutliers < 1 ? pNoOutliers : 0.999999999;
   /* N = log(1 - p) / log(1 - (1 - epsilon)^s) */
-  max_num_iterations = SAFE_LOG(1 - fs_inlier_prob) / SAFE_LOG(pNoOutliers);
+  max_num_iterations = SAFE_LOG(1 - options_ptr->inlier_prob) / SAFE_LOG(pNoOutliers);
   max_num_iterations     = (int)(max_num_iterations > INT_MAX ? INT_MAX : max_num_iterations);
 
   return max_num_iterations;
@@ -184,6 +231,7 @@ int ransac_fit
     int (*degen_func)(const Matrix *)
 )
 {
+    const Ransac_options* options_ptr = get_ransac_options();
     int num; /* = x_mp->num_rows; */
     /*int num = x_mp->num_rows;*/
     Matrix *A_mp = NULL;
@@ -293,7 +341,7 @@ int ransac_fit
                     pNoOutliers = pNoOutliers > 0 ? pNoOutliers : 0.000000001;
                     pNoOutliers = pNoOutliers < 1 ? pNoOutliers : 0.999999999;
                     /* N = log(1 - p) / log(1 - (1 - epsilon)^s) */
-                    d_N = SAFE_LOG(1-fs_inlier_prob) / SAFE_LOG(pNoOutliers);
+                    d_N = SAFE_LOG(1-options_ptr->inlier_prob) / SAFE_LOG(pNoOutliers);
                     N = (int)(d_N > INT_MAX ? INT_MAX:d_N);
                     verbose_pso(8, " | N (# tries) after re-calculation = %d \n", N);
                 }
@@ -338,6 +386,7 @@ int ransac_fit_basic
     int (*degen_func)(const Matrix *)
 )
 {
+    const Ransac_options* options_ptr = get_ransac_options();
     int num; 
     Matrix *A_mp = NULL;
     Matrix *B_mp = NULL;
@@ -369,31 +418,30 @@ int ransac_fit_basic
     ERE(get_target_int_vector(&index_ivp, num));
     ERE(get_target_int_vector(&current_best_index_ivp, num));
     
-    if (fs_minimum_inliers_percentage < DBL_EPSILON)
+    if (options_ptr->minimum_inliers_percentage < DBL_EPSILON)
     {
-      fs_minimum_inliers_percentage = DEFAULT_MINIMUM_PERCENTAGE_OF_INLIERS;
-      verbose_pso(7, " | Minimum percentage of RANSAC inliers is not set. Setting default.\n");
+      verbose_pso(7, " | Minimum percentage of RANSAC inliers is not set. Using default.\n");
     }
-    if (fs_acceptable_inliers_percentage != NOT_SET)
+    if (options_ptr->acceptable_inliers_percentage != NOT_SET)
     {
-        acceptable_num_inliers = fs_acceptable_inliers_percentage * num;
+        acceptable_num_inliers = options_ptr->acceptable_inliers_percentage * num;
     }
     else
     {
         acceptable_num_inliers = num;
     }
     max_num_tries = calculate_max_num_iterations(min_num_samples);
-    verbose_pso(7, " | Minimum percentage of RANSAC inliers is set to %e\n", fs_minimum_inliers_percentage);
+    verbose_pso(7, " | Minimum percentage of RANSAC inliers is set to %e\n", get_minimum_inliers_percentage(options_ptr));
     verbose_pso(7, " | RANSAC will run at most %d iterations\n", max_num_tries);
-    if (fs_acceptable_inliers_percentage != NOT_SET)
+    if (options_ptr->acceptable_inliers_percentage != NOT_SET)
     {
         verbose_pso(7, " | or until it finds %d or more inliers\n", acceptable_num_inliers);
     }
 
     /* By default, the expected number of inliers is set to NOT_SET, which is negative */
     /*
-    while (   (   (fs_acceptable_inliers_percentage == NOT_SET)
-               && (max_inlier_percentage < fs_acceptable_inliers_percentage)
+    while (   (   (options_ptr->acceptable_inliers_percentage == NOT_SET)
+               && (max_inlier_percentage < options_ptr->acceptable_inliers_percentage)
               )
            || (try_num < max_num_tries) 
           )
@@ -510,10 +558,10 @@ int ransac_fit_basic
                     count, acceptable_num_inliers);
     }
     /*
-    if (fs_minimum_inliers_percentage <= fs_acceptable_inliers_percentage)
+    if (options_ptr->minimum_inliers_percentage <= options_ptr->acceptable_inliers_percentage)
     {
         verbose_pso(8, " | The max percentage of inliers (%e) is <= the early-exit percentage of inliers (%e).\n", 
-                    max_inlier_percentage, fs_acceptable_inliers_percentage);
+                    max_inlier_percentage, options_ptr->acceptable_inliers_percentage);
     }
     */
 
@@ -568,6 +616,7 @@ int ransac_fit_error
     int (*degen_func)(const Matrix *)
 )
 {
+    const Ransac_options* options_ptr = get_ransac_options();
     int num = x_mp->num_rows;
     Matrix *A_mp = NULL;
     Matrix *B_mp = NULL;
@@ -648,7 +697,7 @@ int ransac_fit_error
                     pNoOutliers = 1 - pow(frac, min_num_samples);
                     pNoOutliers = pNoOutliers > 0 ? pNoOutliers : 0.000000001;
                     pNoOutliers = pNoOutliers < 1 ? pNoOutliers : 0.999999999;
-                    d_N = SAFE_LOG(1-fs_inlier_prob) / SAFE_LOG(pNoOutliers);
+                    d_N = SAFE_LOG(1-options_ptr->inlier_prob) / SAFE_LOG(pNoOutliers);
                     N = (int)(d_N > INT_MAX ? INT_MAX:d_N);
                 }
                /* pso("---%d %d----\n", count, N);*/
@@ -715,6 +764,7 @@ int ransac_fit_2
     double       *fit_err_ptr
 )
 {
+    const Ransac_options* options_ptr = get_ransac_options();
     int num = x_mp->num_rows;
     Matrix *A_mp = NULL;
     Matrix *B_mp = NULL;
@@ -782,7 +832,7 @@ int ransac_fit_2
         pNoOutliers = 1 - pow(frac, min_num_samples);
         pNoOutliers = pNoOutliers > 0 ? pNoOutliers : 0.000000001;
         pNoOutliers = pNoOutliers < 1 ? pNoOutliers : 0.999999999;
-        d_N = SAFE_LOG(1-fs_inlier_prob) / SAFE_LOG(pNoOutliers);
+        d_N = SAFE_LOG(1-options_ptr->inlier_prob) / SAFE_LOG(pNoOutliers);
         N = (int)(d_N > INT_MAX ? INT_MAX:d_N);
           }
     
@@ -1251,6 +1301,7 @@ int get_random_samples
     int (*degen_func)(const Matrix *)    
 )
 {
+    const Ransac_options* options_ptr = get_ransac_options();
     Int_vector *index_ivp = NULL;
     int num = NOT_SET;
     int dim = NOT_SET;
@@ -1284,7 +1335,7 @@ int get_random_samples
     rand_x_mp = *rand_x_mpp;
     rand_y_mp = *rand_y_mpp;
 
-    while(count < fs_max_random_trials)
+    while(count < options_ptr->max_random_trials)
     {
         ERE(generate_random_index(m, num, &index_ivp));
 
@@ -1312,7 +1363,7 @@ int get_random_samples
 
     free_int_vector(index_ivp);
 
-    if(count == fs_max_random_trials)
+    if(count == options_ptr->max_random_trials)
     {
        /* pso("Warning: reached maximum trials and still failed to pick
         * non-degenerate set of samples!\n");*/
@@ -1401,6 +1452,7 @@ int get_unique_inliers
     int (*dist_func)(const Matrix *, const Matrix *, const Matrix *, Vector **)
 )
 {
+    const Ransac_options* options_ptr = get_ransac_options();
     Vector *dist_vp = NULL;
     Int_vector *inlier_index_ivp = NULL;
     int count;
@@ -1452,10 +1504,10 @@ int get_unique_inliers
                 if (inlier_index_ivp->elements[j] != NOT_SET)
                 {
                     next = inlier_index_ivp->elements[j];
-                    if ( ((fabs(x_mp->elements[pt][0] - x_mp->elements[next][0]) <= fs_duplicates_dist_thresh )
-                          && (fabs(x_mp->elements[pt][1] - x_mp->elements[next][1]) <= fs_duplicates_dist_thresh))
-                         || ((fabs(y_mp->elements[pt][0] - y_mp->elements[next][0]) <= fs_duplicates_dist_thresh)
-                             && (fabs(y_mp->elements[pt][1] - y_mp->elements[next][1]) <= fs_duplicates_dist_thresh)) 
+                    if ( ((fabs(x_mp->elements[pt][0] - x_mp->elements[next][0]) <= options_ptr->duplicates_dist_thresh )
+                          && (fabs(x_mp->elements[pt][1] - x_mp->elements[next][1]) <= options_ptr->duplicates_dist_thresh))
+                         || ((fabs(y_mp->elements[pt][0] - y_mp->elements[next][0]) <= options_ptr->duplicates_dist_thresh)
+                             && (fabs(y_mp->elements[pt][1] - y_mp->elements[next][1]) <= options_ptr->duplicates_dist_thresh)) 
                        )
                     {
                         verbose_pso(9, " | identical inliers %d and %d\n", pt, next);
@@ -1476,7 +1528,7 @@ int get_unique_inliers
     }
 
     /*if (num_duplicates >= (index_ivp->length/2.0))*/
-    if (num_duplicates >= fs_duplicates_thresh_percentage * (index_ivp->length))
+    if (num_duplicates >= options_ptr->duplicates_thresh_percentage * (index_ivp->length))
     {
         verbose_pso(9, " | Degenerate case: too many duplicate points (%d out of %d)!\n", num_duplicates, count);
         count = NOT_SET;
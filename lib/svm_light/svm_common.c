@@ -21,6 +21,9 @@
 /*                                                                      */
 /************************************************************************/
 
+#include "l/l_def.h"
+#include "l_mt/l_mt_pthread.h"
+
 # include "ctype.h"
 # include "svm_light/svm_common.h"
 # include "svm_light/kernel.h"           /* this contains a user supplied kernel */
@@ -33,6 +36,13 @@ extern "C" {
 
 long   verbosity;              /* verbosity level (0-4) */
 long   kernel_cache_statistic;
+long   kernel_num_threads=1;   /* threads for kernel rows and batch scoring */
+
+# define CLASSIFY_DOC_BLOCK 32   /* documents packed together for scoring */
+# define CLASSIFY_SV_BLOCK   8   /* support vectors reused across a block */
+
+static CFLOAT single_kernel_value(KERNEL_PARM *, SVECTOR *, SVECTOR *);
+static double classify_example_uncounted(MODEL *, DOC *);
 
 double classify_example(MODEL *model, DOC *ex) 
      /* classifies one example */
@@ -69,6 +79,277 @@ double classify_example_linear(MODEL *model, DOC *ex)
 }
 
 
+/* ------------------------- Batched classification ------------------------ */
+
+typedef struct range_job {
+  void  (*func)(void *, long, long, long);
+  void  *arg;
+  long  piece;
+  long  begin;
+  long  end;
+} RANGE_JOB;
+
+static void *range_job_main(void *job_ptr)
+{
+  RANGE_JOB *job=(RANGE_JOB *)job_ptr;
+  job->func(job->arg,job->piece,job->begin,job->end);
+  return(NULL);
+}
+
+void parallel_for_range(long n, void (*func)(void *, long, long, long),
+                        void *arg)
+     /* Splits [0,n) into at most kernel_num_threads contiguous pieces and
+        calls func(arg,piece,begin,end) on each piece in its own thread,
+        where piece counts from zero. The pieces only depend on n and the
+        thread count, so results are the same from run to run. Without
+        pthreads, or if a thread cannot be started, the piece is run by
+        the calling thread instead. */
+{
+  long          t,nt;
+  RANGE_JOB     *jobs;
+  kjb_pthread_t *tids;
+  int           *started;
+
+  nt=kernel_num_threads;
+  if(nt > n)
+    nt=n;
+  if(nt <= 1) {
+    if(n > 0)
+      func(arg,0,0,n);
+    return;
+  }
+
+  jobs=(RANGE_JOB *)my_malloc(sizeof(RANGE_JOB)*nt);
+  tids=(kjb_pthread_t *)my_malloc(sizeof(kjb_pthread_t)*nt);
+  started=(int *)my_malloc(sizeof(int)*nt);
+  for(t=0;t<nt;t++) {
+    jobs[t].func=func;
+    jobs[t].arg=arg;
+    jobs[t].piece=t;
+    jobs[t].begin=(n/nt)*t+minl(t,n%nt);
+    jobs[t].end=jobs[t].begin+n/nt+(t < n%nt ? 1 : 0);
+    started[t]=0;
+  }
+  for(t=1;t<nt;t++) {
+    started[t]=(kjb_pthread_create(&tids[t],NULL,range_job_main,&jobs[t])
+                != ERROR);
+  }
+  range_job_main(&jobs[0]);
+  for(t=1;t<nt;t++) {
+    if(started[t])
+      kjb_pthread_join(tids[t],NULL);
+    else
+      range_job_main(&jobs[t]);
+  }
+  free(started);
+  free(tids);
+  free(jobs);
+}
+
+typedef struct classify_batch {
+  MODEL  *model;
+  DOC    **docs;
+  double *dist;
+  long   dim;        /* columns of sv_dense (highest SV feature number) */
+  FVAL   *sv_dense;  /* support vectors 1..sv_num-1, one row each */
+  double *sv_norm;   /* their twonorm_sq */
+  double *sv_coef;   /* alpha times the SVECTOR factor */
+  long   *sv_kernel_id; /* their kernel_id */
+} CLASSIFY_BATCH;
+
+static double kernel_from_sprod(KERNEL_PARM *kernel_parm, double prod,
+                                double norm_a, double norm_b)
+     /* single_kernel() for the built-in kernels, given the inner product */
+{
+  switch(kernel_parm->kernel_type) {
+    case LINEAR:
+      return((CFLOAT)prod);
+    case POLY:
+      return((CFLOAT)pow(kernel_parm->coef_lin*prod+kernel_parm->coef_const,
+                         (double)kernel_parm->poly_degree));
+    case RBF:
+      return((CFLOAT)exp(-kernel_parm->rbf_gamma*(norm_a-2*prod+norm_b)));
+    default:
+      return((CFLOAT)tanh(kernel_parm->coef_lin*prod+kernel_parm->coef_const));
+  }
+}
+
+static int is_single_svector(DOC *doc)
+{
+  return(doc->fvec && !doc->fvec->next);
+}
+
+static void pack_svector(SVECTOR *vec, FVAL *row, long dim)
+     /* scatters the first dim features of vec into a zeroed row */
+{
+  WORD *w;
+  long i;
+
+  if(vec->dense) {
+    for(i=0;i<dim;i++) {
+      row[i]=(i < vec->dense_dim ? vec->dense[i] : 0);
+    }
+    return;
+  }
+  for(i=0;i<dim;i++) {
+    row[i]=0;
+  }
+  for(w=vec->words;w->wnum;w++) {
+    if(w->wnum <= dim)
+      row[w->wnum-1]=w->weight;
+  }
+}
+
+static void classify_batch_range(void *batch_ptr, long piece, long begin,
+                                 long end)
+     /* scores docs[begin..end-1]. Documents are packed CLASSIFY_DOC_BLOCK
+        at a time, so that each block of support vectors is read from
+        memory once per block of documents rather than once per document,
+        which turns the scoring into a blocked matrix product. */
+{
+  CLASSIFY_BATCH *batch=(CLASSIFY_BATCH *)batch_ptr;
+  MODEL  *model=batch->model;
+  long   dim=batch->dim,nsv=model->sv_num-1;
+  long   d0,d,nd,s0,s,ns;
+  long   packed[CLASSIFY_DOC_BLOCK];
+  FVAL   *rows;
+  double acc[CLASSIFY_DOC_BLOCK];
+  DOC    *ex;
+
+  rows=(FVAL *)my_malloc(sizeof(FVAL)*CLASSIFY_DOC_BLOCK*(dim > 0 ? dim : 1));
+
+  for(d0=begin;d0<end;d0+=CLASSIFY_DOC_BLOCK) {
+    nd=minl(CLASSIFY_DOC_BLOCK,end-d0);
+
+    /* documents that are lists of vectors take the generic path */
+    for(d=0;d<nd;d++) {
+      ex=batch->docs[d0+d];
+      packed[d]=is_single_svector(ex);
+      acc[d]=0;
+      if(packed[d])
+	pack_svector(ex->fvec,rows+d*dim,dim);
+      else
+	batch->dist[d0+d]=classify_example_uncounted(model,ex);
+    }
+
+    for(s0=0;s0<nsv;s0+=CLASSIFY_SV_BLOCK) {
+      ns=minl(CLASSIFY_SV_BLOCK,nsv-s0);
+      for(d=0;d<nd;d++) {
+	if(!packed[d])
+	  continue;
+	ex=batch->docs[d0+d];
+	for(s=s0;s<s0+ns;s++) {
+	  /* as in kernel(), vectors with different kernel_id's do not
+	     interact */
+	  if(batch->sv_kernel_id[s] != ex->fvec->kernel_id)
+	    continue;
+	  acc[d]+=batch->sv_coef[s]*kernel_from_sprod(&model->kernel_parm,
+                              sprod_dense(rows+d*dim,batch->sv_dense+s*dim,dim),
+                              batch->sv_norm[s],ex->fvec->twonorm_sq);
+	}
+      }
+    }
+
+    for(d=0;d<nd;d++) {
+      if(packed[d])
+	batch->dist[d0+d]=batch->docs[d0+d]->fvec->factor*acc[d]-model->b;
+    }
+  }
+  free(rows);
+}
+
+static void classify_generic_range(void *batch_ptr, long piece, long begin,
+                                   long end)
+{
+  CLASSIFY_BATCH *batch=(CLASSIFY_BATCH *)batch_ptr;
+  long i;
+
+  for(i=begin;i<end;i++) {
+    batch->dist[i]=classify_example_uncounted(batch->model,batch->docs[i]);
+  }
+}
+
+void classify_examples(MODEL *model, DOC **docs, long n, double *dist)
+     /* classifies n examples, writing the result for docs[i] into dist[i].
+        Gives the same values as classify_example() (up to rounding), but
+        for the linear, polynomial, rbf and sigmoid kernels, it computes
+        all the inner products with the support vectors as one blocked
+        matrix product over dense rows, split across kernel_num_threads
+        threads. Documents with a dense copy (see create_svector_dense())
+        are packed without scattering their word lists. */
+{
+  CLASSIFY_BATCH batch;
+  SVECTOR *f;
+  WORD    *w;
+  long    i,nsv;
+  int     packable;
+
+  batch.model=model;
+  batch.docs=docs;
+  batch.dist=dist;
+
+  nsv=model->sv_num-1;
+  packable=(model->kernel_parm.kernel_type >= LINEAR)
+           && (model->kernel_parm.kernel_type <= SIGMOID)
+           && !((model->kernel_parm.kernel_type == LINEAR)
+                && (model->lin_weights))
+           && (nsv > 0);
+  batch.dim=0;
+  for(i=1;packable && (i<model->sv_num);i++) {
+    packable=is_single_svector(model->supvec[i]);
+    if(packable) {
+      f=model->supvec[i]->fvec;
+      for(w=f->words;w->wnum;w++) {
+	if(w->wnum > batch.dim)
+	  batch.dim=w->wnum;
+      }
+    }
+  }
+
+  if(!packable) {
+    parallel_for_range(n,classify_generic_range,&batch);
+    return;
+  }
+
+  batch.sv_dense=(FVAL *)my_malloc(sizeof(FVAL)*nsv*(batch.dim > 0 ? batch.dim : 1));
+  batch.sv_norm=(double *)my_malloc(sizeof(double)*nsv);
+  batch.sv_coef=(double *)my_malloc(sizeof(double)*nsv);
+  batch.sv_kernel_id=(long *)my_malloc(sizeof(long)*nsv);
+  for(i=0;i<nsv;i++) {
+    f=model->supvec[i+1]->fvec;
+    pack_svector(f,batch.sv_dense+i*batch.dim,batch.dim);
+    batch.sv_norm[i]=f->twonorm_sq;
+    batch.sv_coef[i]=model->alpha[i+1]*f->factor;
+    batch.sv_kernel_id[i]=f->kernel_id;
+  }
+
+  parallel_for_range(n,classify_batch_range,&batch);
+
+  free(batch.sv_kernel_id);
+  free(batch.sv_coef);
+  free(batch.sv_norm);
+  free(batch.sv_dense);
+}
+
+static double classify_example_uncounted(MODEL *model, DOC *ex) 
+     /* classify_example(), without touching kernel_cache_statistic */
+{
+  long   i;
+  double dist;
+
+  if((model->kernel_parm.kernel_type == LINEAR) && (model->lin_weights))
+    return(classify_example_linear(model,ex));
+
+  dist=0;
+  for(i=1;i<model->sv_num;i++) {  
+    dist+=kernel_uncounted(&model->kernel_parm,model->supvec[i],ex)
+          *model->alpha[i];
+  }
+  return(dist-model->b);
+}
+
+/* -------------------------------------------------------------------------- */
+
 CFLOAT kernel(KERNEL_PARM *kernel_parm, DOC *a, DOC *b) 
      /* calculate the kernel function */
 {
@@ -87,10 +368,33 @@ CFLOAT kernel(KERNEL_PARM *kernel_parm, DOC *a, DOC *b)
   return(sum);
 }
 
+CFLOAT kernel_uncounted(KERNEL_PARM *kernel_parm, DOC *a, DOC *b) 
+     /* same as kernel(), but does not touch kernel_cache_statistic, so
+        it can be called from several threads at once */
+{
+  double sum=0;
+  SVECTOR *fa,*fb;
+
+  for(fa=a->fvec;fa;fa=fa->next) { 
+    for(fb=b->fvec;fb;fb=fb->next) {
+      if(fa->kernel_id == fb->kernel_id)
+	sum+=fa->factor*fb->factor*single_kernel_value(kernel_parm,fa,fb);
+    }
+  }
+  return(sum);
+}
+
 CFLOAT single_kernel(KERNEL_PARM *kernel_parm, SVECTOR *a, SVECTOR *b) 
      /* calculate the kernel function between two vectors */
 {
   kernel_cache_statistic++;
+  return(single_kernel_value(kernel_parm,a,b));
+}
+
+static CFLOAT single_kernel_value(KERNEL_PARM *kernel_parm, SVECTOR *a,
+                                  SVECTOR *b) 
+     /* the kernel function between two vectors, without statistics */
+{
   switch(kernel_parm->kernel_type) {
     case 0: /* linear */ 
             return((CFLOAT)sprod_ss(a,b)); 
@@ -136,14 +440,86 @@ SVECTOR *create_svector(WORD *words,char *userdefined,double factor)
   vec->kernel_id=0;
   vec->next=NULL;
   vec->factor=factor;
+  vec->dense=NULL;
+  vec->dense_dim=0;
+  return(vec);
+}
+
+SVECTOR *create_svector_dense(FVAL *values, long dim, char *userdefined,
+                              double factor)
+     /* creates a feature vector from a dense array of dim values, where
+        values[i] is the value of feature number i+1 (e.g. a HOG or color
+        histogram descriptor). The vector keeps the usual word list, so
+        it works everywhere, and also a dense copy that speeds up kernel
+        evaluations against other dense vectors. */
+{
+  SVECTOR *vec;
+  WORD    *words;
+  long    i,fnum;
+
+  words=(WORD *)my_malloc(sizeof(WORD)*(dim+1));
+  fnum=0;
+  for(i=0;i<dim;i++) {
+    if(values[i] != 0) {
+      words[fnum].wnum=i+1;
+      words[fnum].weight=values[i];
+      fnum++;
+    }
+  }
+  words[fnum].wnum=0;
+  vec=create_svector(words,userdefined,factor);
+  free(words);
+
+  vec->dense=(FVAL *)my_malloc(sizeof(FVAL)*(dim > 0 ? dim : 1));
+  for(i=0;i<dim;i++) {
+    vec->dense[i]=values[i];
+  }
+  vec->dense_dim=dim;
   return(vec);
 }
 
+void add_dense_copy_to_svector(SVECTOR *vec, long dim)
+     /* gives an existing sparse vector (and the rest of its list) a dense
+        copy of its features, e.g. after read_documents(). The copy has at
+        least dim entries, more if the vector has higher feature numbers.
+        Use the same dim (e.g. totwords) for all documents. */
+{
+  WORD *w;
+  long i;
+
+  for(;vec;vec=vec->next) {
+    if(vec->dense)
+      free(vec->dense);
+    for(w=vec->words;w->wnum;w++) {
+      if(w->wnum > dim)
+	dim=w->wnum;
+    }
+    vec->dense=(FVAL *)my_malloc(sizeof(FVAL)*(dim > 0 ? dim : 1));
+    for(i=0;i<dim;i++) {
+      vec->dense[i]=0;
+    }
+    for(w=vec->words;w->wnum;w++) {
+      if(w->wnum <= dim)
+	vec->dense[w->wnum-1]=w->weight;
+    }
+    vec->dense_dim=dim;
+  }
+}
+
 SVECTOR *copy_svector(SVECTOR *vec)
 {
   SVECTOR *newvec=NULL;
+  long    i;
   if(vec) {
     newvec=create_svector(vec->words,vec->userdefined,vec->factor);
+    if(vec->dense) {
+      newvec->dense=(FVAL *)my_malloc(sizeof(FVAL)*
+                                      (vec->dense_dim > 0 ? vec->dense_dim : 1));
+      for(i=0;i<vec->dense_dim;i++) {
+	newvec->dense[i]=vec->dense[i];
+      }
+      newvec->dense_dim=vec->dense_dim;
+    }
     newvec->next=copy_svector(vec->next);
   }
   return(newvec);
@@ -155,16 +531,44 @@ void free_svector(SVECTOR *vec)
     free(vec->words);
     if(vec->userdefined)
       free(vec->userdefined);
+    if(vec->dense)
+      free(vec->dense);
     free_svector(vec->next);
     free(vec);
   }
 }
 
+double sprod_dense(FVAL *a, FVAL *b, long n)
+     /* compute the inner product of two dense vectors of length n. The
+        four independent partial sums let the compiler vectorize the
+        loop (and keep the rounding of long sums in check). */
+{
+    double s0=0,s1=0,s2=0,s3=0;
+    long   i;
+
+    for(i=0;i+4<=n;i+=4) {
+      s0+=(double)a[i]*b[i];
+      s1+=(double)a[i+1]*b[i+1];
+      s2+=(double)a[i+2]*b[i+2];
+      s3+=(double)a[i+3]*b[i+3];
+    }
+    for(;i<n;i++) {
+      s0+=(double)a[i]*b[i];
+    }
+    return((s0+s1)+(s2+s3));
+}
+
 double sprod_ss(SVECTOR *a, SVECTOR *b) 
      /* compute the inner product of two sparse vectors */
 {
     register CFLOAT sum=0;
     register WORD *ai,*bj;
+
+    if(a->dense && b->dense) {
+      /* features past the shorter dense copy multiply a zero */
+      return(sprod_dense(a->dense,b->dense,minl(a->dense_dim,b->dense_dim)));
+    }
+
     ai=a->words;
     bj=b->words;
     while (ai->wnum && bj->wnum) {
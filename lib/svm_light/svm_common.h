@@ -100,6 +100,15 @@ typedef struct svector {
                   NULL. */
   double  factor;              /* Factor by which this feature vector
                   is multiplied in the sum. */
+  FVAL    *dense;              /* Optional dense copy of the feature
+                  values, where dense[i] is the value of
+                  feature number i+1. NULL for purely
+                  sparse vectors. When both vectors of
+                  a product have one, sprod_ss() uses a
+                  plain array loop instead of merging
+                  the word lists. See
+                  create_svector_dense(). */
+  long    dense_dim;           /* Number of entries in dense. */
 } SVECTOR;
 
 typedef struct doc {
@@ -272,13 +281,19 @@ typedef struct shrink_state {
 
 double classify_example(MODEL *, DOC *);
 double classify_example_linear(MODEL *, DOC *);
+void   classify_examples(MODEL *, DOC **, long, double *);
+void   parallel_for_range(long, void (*)(void *, long, long, long), void *);
 CFLOAT kernel(KERNEL_PARM *, DOC *, DOC *);
+CFLOAT kernel_uncounted(KERNEL_PARM *, DOC *, DOC *);
 CFLOAT single_kernel(KERNEL_PARM *, SVECTOR *, SVECTOR *);
 double custom_kernel(KERNEL_PARM *, SVECTOR *, SVECTOR *);
 SVECTOR *create_svector(WORD *, char *, double);
+SVECTOR *create_svector_dense(FVAL *, long, char *, double);
+void   add_dense_copy_to_svector(SVECTOR *, long);
 SVECTOR *copy_svector(SVECTOR *);
 void   free_svector(SVECTOR *);
 double    sprod_ss(SVECTOR *, SVECTOR *);
+double    sprod_dense(FVAL *, FVAL *, long);
 SVECTOR*  sub_ss(SVECTOR *, SVECTOR *);
 SVECTOR*  add_ss(SVECTOR *, SVECTOR *);
 SVECTOR*  add_list_ss(SVECTOR *);
@@ -312,6 +327,8 @@ void   copyright_notice(void);
 
 extern long   verbosity;              /* verbosity level (0-4) */
 extern long   kernel_cache_statistic;
+extern long   kernel_num_threads;     /* threads used to fill kernel cache
+                                         rows and in classify_examples() */
 
 
 #ifdef __cplusplus
@@ -3510,16 +3510,109 @@ void cache_kernel_row(KERNEL_CACHE *kernel_cache, DOC **docs,
 }
 
 
+typedef struct cache_rows_job {
+  KERNEL_CACHE *kernel_cache;
+  DOC          **docs;
+  KERNEL_PARM  *kernel_parm;
+  long         *rows;      /* docnums of the rows being filled */
+  long         numrows;
+  char         *pending;   /* by active index: row is being filled now */
+  long         *evals;     /* kernel evaluations, per piece of work */
+} CACHE_ROWS_JOB;
+
+static void cache_rows_piece(void *job_ptr, long piece, long begin, long end)
+     /* Fills entries begin..end-1 of the rows in the job, counted row by
+        row. Entries that mirror a row cached earlier are copied; entries
+        that mirror a row still being filled are computed. */
+{
+  CACHE_ROWS_JOB *job=(CACHE_ROWS_JOB *)job_ptr;
+  KERNEL_CACHE   *kc=job->kernel_cache;
+  long           e,r,j,k,l,m,evals=0;
+  CFLOAT         *cache;
+
+  for(e=begin;e<end;e++) {
+    r=e/kc->activenum;
+    j=e%kc->activenum;
+    m=job->rows[r];
+    cache=kc->buffer+kc->activenum*kc->index[m];
+    l=kc->totdoc2active[m];
+    k=kc->active2totdoc[j];
+    if((kc->index[k] != -1) && (l != -1) && (k != m) && !job->pending[j]) {
+      cache[j]=kc->buffer[kc->activenum*kc->index[k]+l];
+    }
+    else {
+      cache[j]=kernel_uncounted(job->kernel_parm,job->docs[m],job->docs[k]);
+      evals++;
+    }
+  }
+  job->evals[piece]=evals;
+}
+
 void cache_multiple_kernel_rows(KERNEL_CACHE *kernel_cache, DOC **docs,
 				long int *key, long int varnum,
 				KERNEL_PARM *kernel_parm)
-     /* Fills cache for the rows in key */
+     /* Fills cache for the rows in key. With kernel_num_threads > 1, the
+        rows are first reserved in the cache one after another (the LRU
+        bookkeeping is not thread safe), then all their entries are
+        computed in parallel. */
 {
-  register long i;
+  register long i,j;
+  CACHE_ROWS_JOB job;
+
+  if((kernel_num_threads <= 1) || (varnum <= 0)) {
+    for(i=0;i<varnum;i++) {  /* fill up kernel cache */
+      cache_kernel_row(kernel_cache,docs,key[i],kernel_parm);
+    }
+    return;
+  }
+
+  job.kernel_cache=kernel_cache;
+  job.docs=docs;
+  job.kernel_parm=kernel_parm;
+  job.rows=(long *)my_malloc(sizeof(long)*varnum);
+  job.numrows=0;
+  for(i=0;i<varnum;i++) {
+    if(!kernel_cache_check(kernel_cache,key[i])) {
+      if(kernel_cache_clean_and_malloc(kernel_cache,key[i])) {
+	job.rows[job.numrows++]=key[i];
+      }
+      else {
+	perror("Error: Kernel cache full! => increase cache size");
+      }
+    }
+  }
+
+  /* a reservation may have evicted a row reserved earlier in this loop */
+  for(i=0,j=0;i<job.numrows;i++) {
+    if(kernel_cache_check(kernel_cache,job.rows[i]))
+      job.rows[j++]=job.rows[i];
+  }
+  job.numrows=j;
 
-  for(i=0;i<varnum;i++) {  /* fill up kernel cache */
-    cache_kernel_row(kernel_cache,docs,key[i],kernel_parm);
+  if(job.numrows > 0) {
+    job.pending=(char *)my_malloc(sizeof(char)*kernel_cache->activenum);
+    for(j=0;j<kernel_cache->activenum;j++) {
+      job.pending[j]=0;
+    }
+    for(i=0;i<job.numrows;i++) {
+      if(kernel_cache->totdoc2active[job.rows[i]] != -1)
+	job.pending[kernel_cache->totdoc2active[job.rows[i]]]=1;
+    }
+    job.evals=(long *)my_malloc(sizeof(long)*kernel_num_threads);
+    for(i=0;i<kernel_num_threads;i++) {
+      job.evals[i]=0;
+    }
+
+    parallel_for_range(job.numrows*kernel_cache->activenum,
+                       cache_rows_piece,&job);
+
+    for(i=0;i<kernel_num_threads;i++) {
+      kernel_cache_statistic+=job.evals[i];
+    }
+    free(job.evals);
+    free(job.pending);
   }
+  free(job.rows);
 }
 
 
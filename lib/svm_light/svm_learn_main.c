@@ -185,6 +185,7 @@ void read_input_parameters_learn(int argc,char *argv[],char *docfile,char *model
       case 'l': i++; strcpy(learn_parm->predfile,argv[i]); break;
       case 'a': i++; strcpy(learn_parm->alphafile,argv[i]); break;
       case 'y': i++; strcpy(restartfile,argv[i]); break;
+      case 'N': i++; kernel_num_threads=atol(argv[i]); break;
       default: printf("\nUnrecognized option %s!\n\n",argv[i]);
 	       print_help_learn();
 	       exit(0);
@@ -259,6 +260,12 @@ void read_input_parameters_learn(int argc,char *argv[],char *docfile,char *model
     print_help_learn();
     exit(0);
   }
+  if(kernel_num_threads<1) {
+    printf("\nNumber of threads not in valid range: %ld [1,..]\n",kernel_num_threads);
+    wait_any_key();
+    print_help_learn();
+    exit(0);
+  }
   if(learn_parm->svm_c<0) {
     printf("\nThe C parameter must be greater than zero!\n\n");
     wait_any_key();
@@ -364,6 +371,8 @@ void print_help_learn(void)
   printf("                        zig-zagging.\n");
   printf("         -m [5..]    -> size of cache for kernel evaluations in MB (default 40)\n");
   printf("                        The larger the faster...\n");
+  printf("         -N [1..]    -> number of threads used to compute kernel cache\n");
+  printf("                        rows (default 1)\n");
   printf("         -e float    -> eps: Allow that error for termination criterion\n");
   printf("                        [y [w*x+b] - 1] >= eps (default 0.001)\n");
   printf("         -y [0,1]    -> restart the optimization from alpha values in file\n");
@@ -0,0 +1,316 @@
+/* $Id$ */
+
+/*
+ * Checks that classify_examples() gives the same scores as classify_example()
+ * one document at a time, for models trained with the kernel cache filled by
+ * one thread and by several, and that the rows filled by several threads hold
+ * the kernel values. Documents are a mix of sparse and dense vectors with
+ * different kernel_id's, some of which no support vector has, since vectors
+ * with different kernel_id's must not interact.
+ */
+
+#include "l/l_incl.h"
+#include "svm_light/svm_common.h"
+#include "svm_light/svm_learn.h"
+
+#define NUM_TRAINING_DOCS   120
+#define NUM_TEST_DOCS       100
+#define NUM_WORDS           12
+#define NUM_THREADS         4
+#define SCORE_TOLERANCE     1e-5
+
+static DOC* create_test_doc(long docnum, long kernel_id, int dense);
+
+static void set_learn_parm(LEARN_PARM* learn_parm);
+
+static int check_batch_scores
+(
+    KERNEL_PARM* kernel_parm,
+    DOC**        training_docs,
+    double*      labels,
+    DOC**        test_docs
+);
+
+static int check_cache_rows(KERNEL_PARM* kernel_parm, DOC** docs);
+
+/* -------------------------------------------------------------------------- */
+
+int main(int argc, char **argv)
+{
+    int         status        = EXIT_SUCCESS;
+    DOC*        training_docs[ NUM_TRAINING_DOCS ];
+    DOC*        test_docs[ NUM_TEST_DOCS ];
+    double      labels[ NUM_TRAINING_DOCS ];
+    KERNEL_PARM kernel_parm;
+    int         kernel_type, i;
+
+
+    kjb_init();
+
+    EPETB(set_heap_options("heap-checking", "f"));
+
+    verbosity = 0;
+
+    kjb_seed_rand(1, 2);
+
+    /* Training documents use kernel_id's 0 and 1, test documents also 2. */
+    for (i = 0; i < NUM_TRAINING_DOCS; i++)
+    {
+        training_docs[ i ] = create_test_doc(i, i % 2, i % 3 == 0);
+        labels[ i ] = (training_docs[ i ]->fvec->words[ 0 ].weight > 0.5)
+                      ? 1.0 : -1.0;
+    }
+
+    for (i = 0; i < NUM_TEST_DOCS; i++)
+    {
+        test_docs[ i ] = create_test_doc(i, i % 3, i % 2 == 0);
+    }
+
+    kernel_parm.poly_degree = 2;
+    kernel_parm.rbf_gamma = 0.5;
+    kernel_parm.coef_lin = 1.0;
+    kernel_parm.coef_const = 1.0;
+    strcpy(kernel_parm.custom, "empty");
+
+    for (kernel_type = POLY; kernel_type <= SIGMOID; kernel_type++)
+    {
+        kernel_parm.kernel_type = kernel_type;
+
+        kernel_num_threads = 1;
+
+        if (check_batch_scores(&kernel_parm, training_docs, labels, test_docs)
+            == ERROR)
+        {
+            p_stderr("Serial batch scores differ for kernel type %d.\n",
+                     kernel_type);
+            status = EXIT_BUG;
+        }
+
+        kernel_num_threads = NUM_THREADS;
+
+        if (check_batch_scores(&kernel_parm, training_docs, labels, test_docs)
+            == ERROR)
+        {
+            p_stderr("Threaded batch scores differ for kernel type %d.\n",
+                     kernel_type);
+            status = EXIT_BUG;
+        }
+
+        if (check_cache_rows(&kernel_parm, training_docs) == ERROR)
+        {
+            p_stderr("Threaded cache rows differ for kernel type %d.\n",
+                     kernel_type);
+            status = EXIT_BUG;
+        }
+    }
+
+    for (i = 0; i < NUM_TRAINING_DOCS; i++)
+    {
+        free_example(training_docs[ i ], 1);
+    }
+
+    for (i = 0; i < NUM_TEST_DOCS; i++)
+    {
+        free_example(test_docs[ i ], 1);
+    }
+
+    return status;
+}
+
+/*  /\   /\   /\   /\   /\   /\   /\   /\   /\   /\   /\   /\   /\   /\   /\  */
+
+/*
+ * Makes a document of NUM_WORDS features, about a third of which are zero, so
+ * that sparse vectors have gaps in their word lists.
+*/
+static DOC* create_test_doc(long docnum, long kernel_id, int dense)
+{
+    FVAL     values[ NUM_WORDS ];
+    WORD     words[ NUM_WORDS + 1 ];
+    SVECTOR* fvec;
+    int      i, num_words = 0;
+
+
+    for (i = 0; i < NUM_WORDS; i++)
+    {
+        values[ i ] = (kjb_rand() < 0.33) ? 0.0 : kjb_rand();
+
+        if (values[ i ] != 0.0)
+        {
+            words[ num_words ].wnum = i + 1;
+            words[ num_words ].weight = values[ i ];
+            num_words++;
+        }
+    }
+
+    /* The label is taken from the first word, so there must be one. */
+    if (num_words == 0)
+    {
+        values[ 0 ] = 1.0;
+        words[ 0 ].wnum = 1;
+        words[ 0 ].weight = 1.0;
+        num_words++;
+    }
+
+    words[ num_words ].wnum = 0;
+
+    if (dense)
+    {
+        fvec = create_svector_dense(values, NUM_WORDS, "", 1.0);
+    }
+    else
+    {
+        fvec = create_svector(words, "", 1.0);
+    }
+
+    fvec->kernel_id = kernel_id;
+
+    return create_example(docnum, 0, 0, 1.0, fvec);
+}
+
+/*  /\   /\   /\   /\   /\   /\   /\   /\   /\   /\   /\   /\   /\   /\   /\  */
+
+/*
+ * The defaults of svm_learn.
+*/
+static void set_learn_parm(LEARN_PARM* learn_parm)
+{
+    strcpy(learn_parm->predfile, "");
+    strcpy(learn_parm->alphafile, "");
+    learn_parm->type = CLASSIFICATION;
+    learn_parm->biased_hyperplane = 1;
+    learn_parm->sharedslack = 0;
+    learn_parm->remove_inconsistent = 0;
+    learn_parm->skip_final_opt_check = 0;
+    learn_parm->svm_maxqpsize = 10;
+    learn_parm->svm_newvarsinqp = 0;
+    learn_parm->svm_iter_to_shrink = 100;
+    learn_parm->maxiter = 100000;
+    learn_parm->kernel_cache_size = 40;
+    learn_parm->svm_c = 0.0;
+    learn_parm->eps = 0.1;
+    learn_parm->transduction_posratio = -1.0;
+    learn_parm->svm_costratio = 1.0;
+    learn_parm->svm_costratio_unlab = 1.0;
+    learn_parm->svm_unlabbound = 1E-5;
+    learn_parm->epsilon_crit = 0.001;
+    learn_parm->epsilon_a = 1E-15;
+    learn_parm->compute_loo = 0;
+    learn_parm->rho = 1.0;
+    learn_parm->xa_depth = 0;
+}
+
+/*  /\   /\   /\   /\   /\   /\   /\   /\   /\   /\   /\   /\   /\   /\   /\  */
+
+/*
+ * Trains a model with the current kernel_num_threads, and scores the test
+ * documents with classify_examples(). Returns ERROR if any score differs from
+ * the classify_example() one. Kernel values are single precision (CFLOAT),
+ * and the batch sums inner products in a different order, so the scores agree
+ * to about float precision only.
+*/
+static int check_batch_scores
+(
+    KERNEL_PARM* kernel_parm,
+    DOC**        training_docs,
+    double*      labels,
+    DOC**        test_docs
+)
+{
+    LEARN_PARM    learn_parm;
+    KERNEL_CACHE* kernel_cache;
+    MODEL*        model;
+    double        scores[ NUM_TEST_DOCS ];
+    double        score;
+    int           result = NO_ERROR;
+    int           i;
+
+
+    set_learn_parm(&learn_parm);
+
+    model = (MODEL*)my_malloc(sizeof(MODEL));
+    kernel_cache = kernel_cache_init(NUM_TRAINING_DOCS,
+                                     learn_parm.kernel_cache_size);
+
+    svm_learn_classification(training_docs, labels, NUM_TRAINING_DOCS,
+                             NUM_WORDS, &learn_parm, kernel_parm,
+                             kernel_cache, model, NULL);
+
+    classify_examples(model, test_docs, NUM_TEST_DOCS, scores);
+
+    for (i = 0; i < NUM_TEST_DOCS; i++)
+    {
+        score = classify_example(model, test_docs[ i ]);
+
+        if (ABS_OF(scores[ i ] - score) > SCORE_TOLERANCE * (1.0 + ABS_OF(score)))
+        {
+            p_stderr("Document %d (kernel_id %ld): batch score %e, expected %e.\n",
+                     i, test_docs[ i ]->fvec->kernel_id, scores[ i ], score);
+            result = ERROR;
+        }
+    }
+
+    kernel_cache_cleanup(kernel_cache);
+    free_model(model, 0);
+
+    return result;
+}
+
+/*  /\   /\   /\   /\   /\   /\   /\   /\   /\   /\   /\   /\   /\   /\   /\  */
+
+/*
+ * Fills the kernel cache rows of the training documents with the current
+ * kernel_num_threads, in two batches so that rows are filled both while rows
+ * they mirror are already cached and while those are being filled in the same
+ * batch. Returns ERROR if any entry is not exactly the kernel value, which
+ * both kinds of entries must be, as the kernels are symmetric.
+*/
+static int check_cache_rows(KERNEL_PARM* kernel_parm, DOC** docs)
+{
+    KERNEL_CACHE* kernel_cache;
+    long          key[ NUM_TRAINING_DOCS ];
+    CFLOAT*       row;
+    int           result = NO_ERROR;
+    int           i, j;
+
+
+    kernel_cache = kernel_cache_init(NUM_TRAINING_DOCS, 40);
+
+    for (i = 0; i < NUM_TRAINING_DOCS; i++)
+    {
+        key[ i ] = i;
+    }
+
+    cache_multiple_kernel_rows(kernel_cache, docs, key, NUM_TRAINING_DOCS / 3,
+                               kernel_parm);
+    cache_multiple_kernel_rows(kernel_cache, docs, key, NUM_TRAINING_DOCS,
+                               kernel_parm);
+
+    for (i = 0; i < NUM_TRAINING_DOCS; i++)
+    {
+        if ( ! kernel_cache_check(kernel_cache, i))
+        {
+            p_stderr("Row %d was not cached.\n", i);
+            result = ERROR;
+            continue;
+        }
+
+        row = kernel_cache->buffer
+              + kernel_cache->activenum * kernel_cache->index[ i ];
+
+        for (j = 0; j < NUM_TRAINING_DOCS; j++)
+        {
+            if (row[ j ] != kernel(kernel_parm, docs[ i ], docs[ j ]))
+            {
+                p_stderr("Cache entry (%d, %d) is %e, expected %e.\n", i, j,
+                         row[ j ], kernel(kernel_parm, docs[ i ], docs[ j ]));
+                result = ERROR;
+            }
+        }
+    }
+
+    kernel_cache_cleanup(kernel_cache);
+
+    return result;
+}
+
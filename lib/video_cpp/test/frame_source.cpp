@@ -0,0 +1,220 @@
+/* $Id$ */
+/* {{{=========================================================================== *
+   |
+   |  Copyright (c) 1994-2011 by Kobus Barnard (author)
+   |
+   |  Personal and educational use of this code is granted, provided that this
+   |  header is kept intact, and that the authorship is not misrepresented, that
+   |  its use is acknowledged in publications, and relevant papers are cited.
+   |
+   |  For other use contact the author (kobus AT cs DOT arizona DOT edu).
+   |
+   |  Please note that the code in this file has not necessarily been adequately
+   |  tested. Naturally, there is no guarantee of performance, support, or fitness
+   |  for any particular task. Nonetheless, I am interested in hearing about
+   |  problems that you encounter.
+   |
+ * =========================================================================== }}}*/
+
+// vim: tabstop=4 shiftwidth=4 foldmethod=marker
+
+/*
+ * Checks Frame_source with a synthetic decoder (no files): frames come out in
+ * order, no more than num_ahead frames are decoded ahead of the caller,
+ * failed decodes are retried or reported by next(), and buffers are reused.
+ */
+
+#include <l_cpp/l_test.h>
+#include <l_cpp/l_exception.h>
+#include <i_cpp/i_image.h>
+#include <video_cpp/video_frame_source.h>
+#include <set>
+#include <boost/thread.hpp>
+#include <boost/ref.hpp>
+
+using namespace kjb;
+
+namespace {
+
+const int FRAME_ROWS = 8;
+const int FRAME_COLS = 8;
+
+/**
+ * @brief   Decodes frame i as an image whose pixels are all i, and records
+ *          what the source asks of it.
+ */
+class Synthetic_decoder
+{
+public:
+    explicit Synthetic_decoder(size_t num_ahead) :
+        max_ahead(num_ahead),
+        num_requested(0),
+        max_ahead_excess(0),
+        num_decodes(0),
+        num_reused(0),
+        fail_once(-1),
+        fail_always(-1)
+    {}
+
+    void operator()(size_t i, Image& img)
+    {
+        {
+            boost::mutex::scoped_lock lock(mutex);
+
+            num_decodes++;
+            if(i >= num_requested + max_ahead)
+            {
+                max_ahead_excess = std::max(max_ahead_excess,
+                                            i + 1 - num_requested - max_ahead);
+            }
+
+            if((int)i == fail_always || (int)i == fail_once)
+            {
+                if((int)i == fail_once) fail_once = -1;
+                KJB_THROW_2(IO_error, "Synthetic decoding failure.");
+            }
+
+            if(img.get_num_rows() == FRAME_ROWS)
+            {
+                num_reused++;
+            }
+            buffers.insert(&img);
+        }
+
+        // slow enough for the caller to catch up now and then
+        boost::this_thread::sleep(boost::posix_time::microseconds(200));
+
+        if(img.get_num_rows() != FRAME_ROWS)
+        {
+            Image frame(FRAME_ROWS, FRAME_COLS);
+            img.swap(frame);
+        }
+
+        for(int row = 0; row < FRAME_ROWS; row++)
+        {
+            for(int col = 0; col < FRAME_COLS; col++)
+            {
+                img(row, col, Image::RED) = i;
+                img(row, col, Image::GREEN) = i;
+                img(row, col, Image::BLUE) = i;
+            }
+        }
+    }
+
+    /** @brief  To be called before each call to next(). */
+    void request()
+    {
+        boost::mutex::scoped_lock lock(mutex);
+        num_requested++;
+    }
+
+    boost::mutex mutex;
+    size_t max_ahead;
+    size_t num_requested;
+    size_t max_ahead_excess;
+    size_t num_decodes;
+    size_t num_reused;
+    int fail_once;
+    int fail_always;
+    std::set<const Image*> buffers;
+};
+
+/** @brief  True if the view holds frame i, as the decoder makes it. */
+bool is_frame(const Frame_view& view, size_t i)
+{
+    if(!view.is_valid() || view.index() != i) return false;
+
+    const Image& img = view.image();
+    return img.get_num_rows() == FRAME_ROWS
+            && img.get_num_cols() == FRAME_COLS
+            && img(0, 0, Image::RED) == i
+            && img(FRAME_ROWS - 1, FRAME_COLS - 1, Image::BLUE) == i;
+}
+
+/**
+ * @brief   Reads all frames with the given number of threads, and checks
+ *          order, look-ahead, retries and buffer reuse.
+ */
+void test_in_order(size_t num_frames, size_t num_ahead, size_t num_threads)
+{
+    Synthetic_decoder decoder(num_ahead);
+    decoder.fail_once = num_frames / 2;
+
+    Frame_source source(num_frames, boost::ref(decoder),
+                        num_ahead, num_threads);
+    TEST_TRUE(source.size() == num_frames);
+
+    for(size_t i = 0; i < num_frames; i++)
+    {
+        TEST_TRUE(source.has_next());
+
+        decoder.request();
+        Frame_view view = source.next();
+        TEST_TRUE(is_frame(view, i));
+
+        // let the decoders run ahead as far as they are allowed to
+        if(i % 10 == 0)
+        {
+            boost::this_thread::sleep(boost::posix_time::milliseconds(5));
+        }
+    }
+
+    TEST_FALSE(source.has_next());
+    TEST_FAIL(source.next());
+
+    boost::mutex::scoped_lock lock(decoder.mutex);
+
+    // no frame was decoded num_ahead or more frames past those asked for
+    TEST_TRUE(decoder.max_ahead_excess == 0);
+
+    // the frame that failed once was decoded again by next()
+    TEST_TRUE(decoder.fail_once == -1);
+    TEST_TRUE(decoder.num_decodes == num_frames + 1);
+
+    // num_ahead buffers are decoded into and one is held by the caller, plus
+    // the two that next() uses for the frame that failed; the other frames
+    // are decoded into recycled buffers
+    TEST_TRUE(decoder.buffers.size() <= num_ahead + 3);
+    TEST_TRUE(decoder.num_reused + num_ahead + 3 >= num_frames);
+}
+
+/**
+ * @brief   Checks that a frame that cannot be decoded makes next() throw,
+ *          every time, until the decoder can decode it.
+ */
+void test_failure()
+{
+    const size_t num_frames = 3;
+    const size_t num_ahead = 2;
+    Synthetic_decoder decoder(num_ahead);
+    decoder.fail_always = 1;
+
+    Frame_source source(num_frames, boost::ref(decoder), num_ahead, 2);
+
+    TEST_TRUE(is_frame(source.next(), 0));
+
+    TEST_FAIL(source.next());
+    TEST_FAIL(source.next());
+    TEST_TRUE(source.has_next());
+
+    {
+        boost::mutex::scoped_lock lock(decoder.mutex);
+        decoder.fail_always = -1;
+    }
+
+    TEST_TRUE(is_frame(source.next(), 1));
+    TEST_TRUE(is_frame(source.next(), 2));
+    TEST_FALSE(source.has_next());
+}
+
+} // anonymous namespace
+
+int main(int, char**)
+{
+    test_in_order(100, 4, 1);
+    test_in_order(100, 4, 3);
+    test_in_order(50, 1, 2);
+    test_failure();
+
+    RETURN_VICTORIOUSLY();
+}
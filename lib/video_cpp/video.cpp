@@ -27,18 +27,31 @@ namespace kjb
 bool Video::ffmpeg_registered_ = false;
 
 Image Video_frame::to_image() const
+{
+    Image img(height_, width_);
+    to_image(img);
+
+    return img;
+}
+
+void Video_frame::to_image(Image& img) const
 {
     size_t num_cols = width_;
     size_t num_rows = height_;
-    Image img(num_rows, num_cols);
+    if(img.get_num_rows() != (int) num_rows
+        || img.get_num_cols() != (int) num_cols)
+    {
+        Image resized(num_rows, num_cols);
+        img.swap(resized);
+    }
     size_t stride = 3 * num_cols;
 
-    size_t out_col = 0;
     int out_row = num_rows - 1;
     size_t offset = 0;
 
     for(size_t row = 0; row < num_rows; row++)
     {
+        size_t out_col = 0;
         for(size_t col = 0; col < 3*num_cols; col += 3)
         {
             img(out_row, out_col, Image::RED) = (float) data_[offset + col + 0];
@@ -49,8 +62,6 @@ Image Video_frame::to_image() const
         --out_row;
         offset += stride;
     }
-
-    return img;
 }
 
 }
@@ -74,6 +74,9 @@ public:
 public:
     Image to_image() const;
 
+    /** @brief  Like to_image(), but reuses the storage of img if it has the right size. */
+    void to_image(Image& img) const;
+
 private:
     boost::shared_array<unsigned char> data_;
     size_t width_;
@@ -0,0 +1,345 @@
+/* $Id$ */
+/* {{{=========================================================================== *
+   |
+   |  Copyright (c) 1994-2011 by Kobus Barnard (author)
+   |
+   |  Personal and educational use of this code is granted, provided that this
+   |  header is kept intact, and that the authorship is not misrepresented, that
+   |  its use is acknowledged in publications, and relevant papers are cited.
+   |
+   |  For other use contact the author (kobus AT cs DOT arizona DOT edu).
+   |
+   |  Please note that the code in this file has not necessarily been adequately
+   |  tested. Naturally, there is no guarantee of performance, support, or fitness
+   |  for any particular task. Nonetheless, I am interested in hearing about
+   |  problems that you encounter.
+   |
+ * =========================================================================== }}}*/
+
+// vim: tabstop=4 shiftwidth=4 foldmethod=marker
+
+#include <video_cpp/video_frame_source.h>
+#include <i_cpp/i_image.h>
+#include <l_cpp/l_exception.h>
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <set>
+#include <string>
+#include <boost/bind.hpp>
+#include <boost/ref.hpp>
+#include <boost/thread.hpp>
+
+namespace kjb
+{
+
+/**
+ * Everything shared by the source, its threads, and the views it hands out.
+ * The views keep this alive, so buffers can be returned after the source is
+ * gone.
+ */
+class Frame_source::State
+{
+public:
+    State(size_t num_frames, const Decoder& decode, size_t num_ahead) :
+        decode(decode),
+        num_frames(num_frames),
+        num_ahead(num_ahead),
+        next_decode(0),
+        next_return(0),
+        stop(false)
+    {}
+
+    ~State()
+    {
+        for(std::map<size_t, Image*>::iterator it = ready.begin();
+            it != ready.end(); ++it)
+        {
+            delete it->second;
+        }
+
+        for(size_t i = 0; i < spare.size(); i++)
+        {
+            delete spare[i];
+        }
+    }
+
+    /** @brief  Decodes frames until told to stop. */
+    void work();
+
+    /** @brief  Takes back a buffer the caller is done with. */
+    void recycle(const Image* buffer);
+
+    /** @brief  Tells the threads to stop, and waits for them. */
+    void shutdown();
+
+    Decoder decode;
+    size_t num_frames;
+    size_t num_ahead;
+
+    boost::mutex mutex;
+    boost::condition_variable changed;
+    boost::thread_group threads;
+
+    size_t next_decode;
+    size_t next_return;
+    std::map<size_t, Image*> ready;
+    std::set<size_t> failed;
+    std::vector<Image*> spare;
+    bool stop;
+};
+
+/* \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ */
+
+void Frame_source::State::work()
+{
+    boost::mutex::scoped_lock lock(mutex);
+    while(true)
+    {
+        while(!stop && (next_decode == num_frames
+                        || next_decode >= next_return + num_ahead))
+        {
+            changed.wait(lock);
+        }
+
+        if(stop) return;
+
+        size_t i = next_decode++;
+        Image* buffer = 0;
+        if(!spare.empty())
+        {
+            buffer = spare.back();
+            spare.pop_back();
+        }
+
+        lock.unlock();
+
+        bool ok = true;
+        try
+        {
+            if(buffer == 0) buffer = new Image();
+            decode(i, *buffer);
+        }
+        catch(...)
+        {
+            ok = false;
+        }
+
+        lock.lock();
+        if(ok)
+        {
+            ready[i] = buffer;
+        }
+        else
+        {
+            failed.insert(i);
+            if(buffer != 0) spare.push_back(buffer);
+        }
+        changed.notify_all();
+    }
+}
+
+/* \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ */
+
+void Frame_source::State::recycle(const Image* buffer)
+{
+    boost::mutex::scoped_lock lock(mutex);
+
+    // the caller may hold on to some frames; keep no more than we use, which
+    // is num_ahead frames decoded ahead plus the one the caller has
+    size_t num_in_use = next_decode - next_return - failed.size();
+    if(!stop && spare.size() + num_in_use < num_ahead + 1)
+    {
+        spare.push_back(const_cast<Image*>(buffer));
+    }
+    else
+    {
+        delete buffer;
+    }
+}
+
+/* \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ */
+
+void Frame_source::State::shutdown()
+{
+    {
+        boost::mutex::scoped_lock lock(mutex);
+        stop = true;
+        changed.notify_all();
+    }
+
+    threads.join_all();
+}
+
+/* \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ */
+
+Frame_source::Frame_source
+(
+    size_t num_frames,
+    const Decoder& decode,
+    size_t num_ahead,
+    size_t num_threads
+) :
+    state_(new State(num_frames, decode, num_ahead))
+{
+    IFT(num_ahead > 0, Illegal_argument,
+        "Frame source must decode at least one frame ahead.");
+
+    if(num_threads == 0)
+    {
+        // may be 0 if the number of cores is unknown
+        num_threads = std::max(1u, boost::thread::hardware_concurrency());
+    }
+    if(num_threads > num_ahead)
+    {
+        num_threads = num_ahead;
+    }
+    if(num_threads > num_frames)
+    {
+        num_threads = num_frames;
+    }
+
+    try
+    {
+        for(size_t t = 0; t < num_threads; t++)
+        {
+            state_->threads.create_thread(
+                        boost::bind(&State::work, state_.get()));
+        }
+    }
+    catch(...)
+    {
+        // the destructor will not run, and the threads use state_
+        state_->shutdown();
+        throw;
+    }
+}
+
+/* \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ */
+
+Frame_source::~Frame_source()
+{
+    state_->shutdown();
+}
+
+/* \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ */
+
+size_t Frame_source::size() const
+{
+    return state_->num_frames;
+}
+
+/* \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ */
+
+bool Frame_source::has_next() const
+{
+    boost::mutex::scoped_lock lock(state_->mutex);
+    return state_->next_return < state_->num_frames;
+}
+
+/* \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ */
+
+Frame_view Frame_source::next()
+{
+    State& st = *state_;
+    boost::mutex::scoped_lock lock(st.mutex);
+
+    IFT(st.next_return < st.num_frames, Runtime_error,
+        "Frame source has no more frames.");
+
+    size_t i = st.next_return;
+    while(st.ready.count(i) == 0 && st.failed.count(i) == 0)
+    {
+        st.changed.wait(lock);
+    }
+
+    Image* buffer = 0;
+    if(st.failed.erase(i) == 0)
+    {
+        buffer = st.ready[i];
+        st.ready.erase(i);
+    }
+    else
+    {
+        // decode it again here, so that the caller gets the error
+        lock.unlock();
+        Image img;
+        try
+        {
+            st.decode(i, img);
+        }
+        catch(...)
+        {
+            // leave it for the next call
+            lock.lock();
+            st.failed.insert(i);
+            throw;
+        }
+        buffer = new Image();
+        buffer->swap(img);
+        lock.lock();
+    }
+
+    st.next_return++;
+    st.changed.notify_all();
+
+    // the view keeps the state alive until it gives the buffer back
+    boost::shared_ptr<const Image> image(
+                buffer, boost::bind(&State::recycle, state_, _1));
+
+    return Frame_view(image, i);
+}
+
+/* \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ */
+
+/** @brief  Reads an image file; one at a time, as the reader is not reentrant. */
+static void read_frame_file
+(
+    const std::vector<std::string>& fnames,
+    size_t i,
+    Image& img
+)
+{
+    static boost::mutex read_mutex;
+    boost::mutex::scoped_lock lock(read_mutex);
+
+    Image frame(fnames[i]);
+    img.swap(frame);
+}
+
+Image_file_frame_source::Image_file_frame_source
+(
+    const std::vector<std::string>& fnames,
+    size_t num_ahead
+) :
+    Frame_source(fnames.size(),
+                 boost::bind(read_frame_file, fnames, _1, _2),
+                 num_ahead, 1)
+{}
+
+/* \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ \/ */
+
+/** @brief  Converts a video frame into a recycled buffer. */
+static void convert_video_frame
+(
+    const Abstract_video& video,
+    size_t i,
+    Image& img
+)
+{
+    video[i].to_image(img);
+}
+
+Video_frame_source::Video_frame_source
+(
+    const Abstract_video& video,
+    size_t num_ahead,
+    size_t num_threads
+) :
+    Frame_source(video.size(),
+                 boost::bind(convert_video_frame, boost::cref(video), _1, _2),
+                 num_ahead, num_threads)
+{}
+
+} // namespace kjb
+
@@ -0,0 +1,170 @@
+/* $Id$ */
+/* {{{=========================================================================== *
+   |
+   |  Copyright (c) 1994-2011 by Kobus Barnard (author)
+   |
+   |  Personal and educational use of this code is granted, provided that this
+   |  header is kept intact, and that the authorship is not misrepresented, that
+   |  its use is acknowledged in publications, and relevant papers are cited.
+   |
+   |  For other use contact the author (kobus AT cs DOT arizona DOT edu).
+   |
+   |  Please note that the code in this file has not necessarily been adequately
+   |  tested. Naturally, there is no guarantee of performance, support, or fitness
+   |  for any particular task. Nonetheless, I am interested in hearing about
+   |  problems that you encounter.
+   |
+ * =========================================================================== }}}*/
+
+// vim: tabstop=4 shiftwidth=4 foldmethod=marker
+
+#ifndef KJB_CPP_VIDEO_FRAME_SOURCE_H
+#define KJB_CPP_VIDEO_FRAME_SOURCE_H
+
+/**
+ * @file Sources that produce the frames of an image sequence or video one at
+ * a time, decoding a few frames ahead on background threads.
+ */
+
+#include <i_cpp/i_image.h>
+#include <video_cpp/video.h>
+#include <vector>
+#include <string>
+#include <boost/function.hpp>
+#include <boost/shared_ptr.hpp>
+
+namespace kjb
+{
+
+/**
+ * @class   Frame_view
+ * @brief   A frame produced by a Frame_source.
+ *
+ * The view refers to the buffer the frame was decoded into; nothing is
+ * copied. The buffer goes back to its source when the last copy of the view
+ * is destroyed, so views should not be kept longer than needed.
+ */
+class Frame_view
+{
+public:
+    /** @brief  Constructs an empty view. */
+    Frame_view() : index_(0) {}
+
+    /** @brief  Returns true if this view refers to a frame. */
+    bool is_valid() const { return image_.get() != 0; }
+
+    /** @brief  Returns the (zero-based) index of this frame. */
+    size_t index() const { return index_; }
+
+    /** @brief  Returns the frame. */
+    const Image& image() const { return *image_; }
+
+    /** @brief  Returns the frame as a C image. */
+    const kjb_c::KJB_image* c_ptr() const { return image_->c_ptr(); }
+
+private:
+    friend class Frame_source;
+
+    Frame_view(const boost::shared_ptr<const Image>& image, size_t index) :
+        image_(image), index_(index)
+    {}
+
+    boost::shared_ptr<const Image> image_;
+    size_t index_;
+};
+
+/**
+ * @class   Frame_source
+ * @brief   Produces the frames of a sequence in order, decoding ahead.
+ *
+ * The frames are decoded by a user-supplied function on background threads,
+ * at most num_ahead frames ahead of the caller, into buffers that are reused
+ * once the caller is done with them. Thus the time to the first frame and
+ * the memory used do not depend on the length of the sequence.
+ *
+ * The decoder is called as decode(i, img), and must put frame i into img,
+ * reusing its storage when it can. It is called from several threads at
+ * once, unless num_threads is 1. If it throws, next() calls it again for
+ * that frame on the calling thread, so that the error is thrown there.
+ */
+class Frame_source
+{
+public:
+    typedef boost::function<void (size_t, Image&)> Decoder;
+
+    /**
+     * @brief   Starts decoding the frames of a sequence.
+     *
+     * @param   num_frames   The number of frames in the sequence.
+     * @param   decode       Puts a frame into a buffer; see above.
+     * @param   num_ahead    How many frames may be decoded ahead.
+     * @param   num_threads  Decoding threads (0 means one per core).
+     */
+    Frame_source
+    (
+        size_t num_frames,
+        const Decoder& decode,
+        size_t num_ahead = 4,
+        size_t num_threads = 1
+    );
+
+    /** @brief  Stops decoding; the views handed out stay valid. */
+    virtual ~Frame_source();
+
+    /** @brief  Returns the number of frames in the sequence. */
+    size_t size() const;
+
+    /** @brief  Returns true if next() has more frames to give. */
+    bool has_next() const;
+
+    /** @brief  Returns the next frame, waiting for it if needed. */
+    Frame_view next();
+
+private:
+    Frame_source(const Frame_source&);
+    Frame_source& operator=(const Frame_source&);
+
+    class State;
+
+    boost::shared_ptr<State> state_;
+};
+
+/**
+ * @class   Image_file_frame_source
+ * @brief   Reads the frames of a sequence from a list of image files.
+ *
+ * Image reading uses static library data, so the files are read one at a
+ * time, while the caller works on the previous frames. The caller should
+ * not read images or change the image options while the source is alive.
+ */
+class Image_file_frame_source : public Frame_source
+{
+public:
+    Image_file_frame_source
+    (
+        const std::vector<std::string>& fnames,
+        size_t num_ahead = 4
+    );
+};
+
+/**
+ * @class   Video_frame_source
+ * @brief   Converts the frames of a video to images as they are needed.
+ *
+ * The video must outlive this source.
+ */
+class Video_frame_source : public Frame_source
+{
+public:
+    Video_frame_source
+    (
+        const Abstract_video& video,
+        size_t num_ahead = 4,
+        size_t num_threads = 1
+    );
+};
+
+} // namespace kjb
+
+#endif /* KJB_CPP_VIDEO_FRAME_SOURCE_H */
+